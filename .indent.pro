@@ -126,6 +126,12 @@
 -T lxw_packager
 -T lxw_panes
 -T lxw_part_name
+-T lxw_pivot_cache_field
+-T lxw_pivot_data_field
+-T lxw_pivot_data_obj
+-T lxw_pivot_table
+-T lxw_pivot_table_obj
+-T lxw_pivot_table_options
 -T lxw_print_area
 -T lxw_protection
 -T lxw_protection_obj
@@ -47,6 +47,7 @@ pub fn build(b: *std.Build) void {
             "src/core.c",
             "src/comment.c",
             "src/utility.c",
+            "src/image_cache.c",
             "src/metadata.c",
             "src/custom.c",
             "src/hash_table.c",
@@ -57,6 +58,7 @@ pub fn build(b: *std.Build) void {
             "src/worksheet.c",
             "src/format.c",
             "src/table.c",
+            "src/pivot_table.c",
             "src/workbook.c",
             "src/packager.c",
             "src/rich_value.c",
@@ -12,8 +12,10 @@
 #import "drawing.h"
 #import "format.h"
 #import "hash_table.h"
+#import "image_cache.h"
 #import "metadata.h"
 #import "packager.h"
+#import "pivot_table.h"
 #import "relationships.h"
 #import "rich_value.h"
 #import "rich_value_rel.h"
@@ -18,6 +18,7 @@
 #include "xlsxwriter/worksheet.h"
 #include "xlsxwriter/format.h"
 #include "xlsxwriter/utility.h"
+#include "xlsxwriter/image_cache.h"
 
 #define LXW_VERSION "1.2.3"
 #define LXW_VERSION_ID 123
@@ -617,7 +617,7 @@ typedef struct lxw_series_range {
     uint8_t ignore_cache;
 
     uint8_t has_string_cache;
-    uint16_t num_data_points;
+    uint32_t num_data_points;
     struct lxw_series_data_points *data_cache;
 
 } lxw_series_range;
@@ -627,6 +627,7 @@ typedef struct lxw_series_data_point {
     double number;
     char *string;
     uint8_t no_data;
+    lxw_number_precision precision;
 
     STAILQ_ENTRY (lxw_series_data_point) list_pointers;
 
@@ -921,6 +922,23 @@ typedef enum lxw_chart_blank {
     LXW_CHART_BLANKS_AS_CONNECTED
 } lxw_chart_blank;
 
+/**
+ * @brief Methods used to reduce the number of points in a chart series.
+ */
+typedef enum lxw_chart_downsample {
+
+    /** Plot all of the points in the series. The default. */
+    LXW_CHART_DOWNSAMPLE_NONE,
+
+    /** Largest-Triangle-Three-Buckets. Keeps the points that best preserve
+     *  the visual shape of the series. */
+    LXW_CHART_DOWNSAMPLE_LTTB,
+
+    /** Keep the minimum and maximum points in each bucket. Preserves the
+     *  peaks and troughs of the series. */
+    LXW_CHART_DOWNSAMPLE_MIN_MAX
+} lxw_chart_downsample;
+
 enum lxw_chart_position {
     LXW_CHART_AXIS_RIGHT,
     LXW_CHART_AXIS_LEFT,
@@ -1048,6 +1066,8 @@ typedef struct lxw_chart_series {
 
     uint8_t smooth;
     uint8_t invert_if_negative;
+    uint8_t downsample;
+    uint32_t downsample_points;
 
     /* Data label parameters. */
     uint8_t has_labels;
@@ -1256,6 +1276,8 @@ typedef struct lxw_chart {
     uint8_t default_label_position;
     uint8_t is_protected;
 
+    lxw_number_precision *number_precision;
+
     STAILQ_ENTRY (lxw_chart) ordered_list_pointers;
     STAILQ_ENTRY (lxw_chart) list_pointers;
 
@@ -1743,6 +1765,46 @@ lxw_error chart_series_set_points(lxw_chart_series *series,
  */
 void chart_series_set_smooth(lxw_chart_series *series, uint8_t smooth);
 
+/**
+ * @brief Reduce the number of points plotted for a large chart series.
+ *
+ * @param series     A series object created via `chart_add_series()`.
+ * @param method     The downsample method. See #lxw_chart_downsample.
+ * @param max_points The maximum number of points to plot. Minimum 3.
+ *
+ * @return A #lxw_error.
+ *
+ * The `chart_series_set_downsample()` function is used to limit the number
+ * of points plotted for a line or scatter series with a very large number of
+ * data points. When the workbook is closed the selected points are copied to
+ * a hidden `_ChartData` worksheet and the series is pointed at the copy. The
+ * original data in the worksheet isn't changed:
+ *
+ * @code
+ *     chart_series_set_downsample(series, LXW_CHART_DOWNSAMPLE_LTTB, 2000);
+ * @endcode
+ *
+ * The supported methods are:
+ *
+ * - #LXW_CHART_DOWNSAMPLE_LTTB: The Largest-Triangle-Three-Buckets
+ *   algorithm. This keeps the first and last points and the point from each
+ *   bucket that best preserves the shape of the series.
+ * - #LXW_CHART_DOWNSAMPLE_MIN_MAX: Keep the minimum and maximum values in
+ *   each bucket, in their original order.
+ *
+ * Downsampling is only supported for #LXW_CHART_LINE and scatter charts.
+ * The values and categories must be single row or column ranges of the same
+ * length in worksheets that don't use the `constant_memory` mode. Value cells
+ * that don't contain a number are ignored. Series that have less than
+ * `max_points` points, or that contain formulas, are plotted unchanged.
+ *
+ * @note The downsampled data is a copy of the worksheet data at the time the
+ * workbook is closed so the chart won't update if the source data is later
+ * changed in Excel.
+ */
+lxw_error chart_series_set_downsample(lxw_chart_series *series,
+                                      uint8_t method, uint32_t max_points);
+
 /**
  * @brief Add data labels to a chart series.
  *
@@ -149,6 +149,9 @@ typedef enum lxw_error {
     /** Couldn't read image dimensions or DPI. */
     LXW_ERROR_IMAGE_DIMENSIONS,
 
+    /** Incremental workbook close isn't complete. Not an error. */
+    LXW_CLOSE_IN_PROGRESS,
+
     LXW_MAX_ERRNO
 } lxw_error;
 
@@ -173,6 +176,32 @@ typedef struct lxw_datetime {
 
 } lxw_datetime;
 
+/** Number precision types used with workbook_set_number_precision() and
+ *  worksheet_set_column_precision(). */
+enum lxw_number_precision_types {
+    /** Use the default precision. For a worksheet column this is the
+     *  workbook precision. For a workbook it is full precision. */
+    LXW_PRECISION_DEFAULT = 0,
+
+    /** Write numbers with full double precision. */
+    LXW_PRECISION_FULL,
+
+    /** Round numbers to a number of significant digits. */
+    LXW_PRECISION_SIGNIFICANT_DIGITS,
+
+    /** Round numbers to a number of decimal places. */
+    LXW_PRECISION_DECIMAL_PLACES
+};
+
+/* Struct to represent the precision used when writing numbers. */
+typedef struct lxw_number_precision {
+    uint8_t type;
+    uint8_t digits;
+} lxw_number_precision;
+
+/* The maximum number of digits for a number precision. */
+#define LXW_PRECISION_MAX_DIGITS  15
+
 enum lxw_custom_property_types {
     LXW_CUSTOM_NONE,
     LXW_CUSTOM_STRING,
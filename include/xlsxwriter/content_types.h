@@ -46,6 +46,8 @@ void lxw_ct_add_default(lxw_content_types *content_types, const char *key,
                         const char *value);
 void lxw_ct_add_override(lxw_content_types *content_types, const char *key,
                          const char *value);
+void lxw_ct_remove_override(lxw_content_types *content_types,
+                            const char *key);
 void lxw_ct_add_worksheet_name(lxw_content_types *content_types,
                                const char *name);
 void lxw_ct_add_chartsheet_name(lxw_content_types *content_types,
@@ -56,6 +58,12 @@ void lxw_ct_add_drawing_name(lxw_content_types *content_types,
                              const char *name);
 void lxw_ct_add_table_name(lxw_content_types *content_types,
                            const char *name);
+void lxw_ct_add_pivot_table_name(lxw_content_types *content_types,
+                                 const char *name);
+void lxw_ct_add_pivot_cache_name(lxw_content_types *content_types,
+                                 const char *name);
+void lxw_ct_add_pivot_records_name(lxw_content_types *content_types,
+                                   const char *name);
 void lxw_ct_add_comment_name(lxw_content_types *content_types,
                              const char *name);
 void lxw_ct_add_vml_name(lxw_content_types *content_types);
@@ -42,23 +42,26 @@ typedef struct lxw_drawing_coords {
 
 /* Object to represent the properties of a drawing. */
 typedef struct lxw_drawing_object {
-    uint8_t type;
-    uint8_t anchor;
+    /* The members are ordered by size to avoid padding, since a worksheet
+     * may hold many thousands of drawing objects. */
     struct lxw_drawing_coords from;
     struct lxw_drawing_coords to;
     uint64_t col_absolute;
     uint64_t row_absolute;
+    char *description;
+    char *tip;
+
+    STAILQ_ENTRY (lxw_drawing_object) list_pointers;
+
     uint32_t width;
     uint32_t height;
-    uint8_t shape;
     uint32_t rel_index;
     uint32_t url_rel_index;
-    char *description;
-    char *tip;
+    uint8_t type;
+    uint8_t anchor;
+    uint8_t shape;
     uint8_t decorative;
 
-    STAILQ_ENTRY (lxw_drawing_object) list_pointers;
-
 } lxw_drawing_object;
 
 /*
@@ -93,6 +96,15 @@ void lxw_add_drawing_object(lxw_drawing *drawing,
 #ifdef TESTING
 
 STATIC void _drawing_xml_declaration(lxw_drawing *self);
+STATIC void _drawing_write_two_cell_anchor(lxw_drawing *self, uint32_t index,
+                                           lxw_drawing_object
+                                           *drawing_object);
+STATIC uint8_t _drawing_has_anchor_template(lxw_drawing_object
+                                            *drawing_object);
+STATIC void _drawing_write_two_cell_anchor_template(lxw_drawing *self,
+                                                    uint32_t index,
+                                                    lxw_drawing_object
+                                                    *drawing_object);
 #endif /* TESTING */
 
 /* *INDENT-OFF* */
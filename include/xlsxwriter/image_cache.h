@@ -0,0 +1,133 @@
+/*
+ * libxlsxwriter
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ * Copyright 2014-2025, John McNamara, jmcnamara@cpan.org.
+ */
+
+/**
+ * @file image_cache.h
+ *
+ * @brief Functions for the process wide image cache.
+ *
+ * Applications that create many workbooks often insert the same images,
+ * such as logos and icons, into each one. By default each workbook reads,
+ * parses, checksums and compresses the image files again. The image cache
+ * keeps the properties and the compressed data of images so that they can
+ * be reused by later workbooks in the same process.
+ *
+ * <!-- Copyright 2014-2025, John McNamara, jmcnamara@cpan.org -->
+ *
+ */
+
+#ifndef __LXW_IMAGE_CACHE_H__
+#define __LXW_IMAGE_CACHE_H__
+
+#include <stdint.h>
+
+#include "common.h"
+
+/* Define the tree.h RB structs for the cache entries. */
+RB_HEAD(lxw_image_cache_entries, lxw_image_cache_entry);
+
+/* Struct to represent a cached image. File entries are keyed by filename and
+ * store the image properties. Data entries are keyed by the MD5 checksum of
+ * the image data and store the compressed data for the xlsx zip file. */
+typedef struct lxw_image_cache_entry {
+    char *key;
+
+    uint64_t file_size;
+    int64_t file_mtime;
+    uint8_t image_type;
+    double width;
+    double height;
+    double x_dpi;
+    double y_dpi;
+    char *extension;
+    char *md5;
+
+    char *zip_data;
+    size_t zip_data_size;
+    size_t data_size;
+    uint32_t crc32;
+
+    RB_ENTRY (lxw_image_cache_entry) tree_pointers;
+} lxw_image_cache_entry;
+
+#define LXW_RB_GENERATE_IMAGE_CACHE(name, type, field, cmp) \
+    RB_GENERATE_INSERT_COLOR(name, type, field, static)    \
+    RB_GENERATE_REMOVE_COLOR(name, type, field, static)    \
+    RB_GENERATE_INSERT(name, type, field, cmp, static)     \
+    RB_GENERATE_REMOVE(name, type, field, static)          \
+    RB_GENERATE_FIND(name, type, field, cmp, static)       \
+    RB_GENERATE_NEXT(name, type, field, static)            \
+    RB_GENERATE_MINMAX(name, type, field, static)          \
+    /* Add unused struct to allow adding a semicolon */    \
+    struct lxw_rb_generate_image_cache{int unused;}
+
+/* *INDENT-OFF* */
+#ifdef __cplusplus
+extern "C" {
+#endif
+/* *INDENT-ON* */
+
+/**
+ * @brief Turn on the process wide image cache.
+ *
+ * The `%lxw_image_cache_enable()` function turns on a cache for the images
+ * inserted into worksheets by all the workbooks that are created
+ * afterwards:
+ *
+ * @code
+ *     lxw_image_cache_enable();
+ *
+ *     for (i = 0; i < num_reports; i++) {
+ *         workbook = workbook_new(filenames[i]);
+ *         worksheet = workbook_add_worksheet(workbook, NULL);
+ *         worksheet_insert_image(worksheet, 0, 0, "logo.png");
+ *         ...
+ *         workbook_close(workbook);
+ *     }
+ *
+ *     lxw_image_cache_free();
+ * @endcode
+ *
+ * Image files are identified by their filename, size and modification time
+ * so a file that is changed is read again. The image properties are reused
+ * without reading the file. The compressed image data is identified by the
+ * MD5 checksum of the image and is also used for images inserted from
+ * memory buffers. It isn't cached if the library is built without MD5
+ * support.
+ *
+ * The cache isn't thread safe. When it is enabled the workbooks that insert
+ * images should be created and closed from one thread at a time.
+ */
+void lxw_image_cache_enable(void);
+
+/**
+ * @brief Turn off the image cache and free its memory.
+ *
+ * The `%lxw_image_cache_free()` function frees the images stored by the
+ * image cache and turns the cache off. It shouldn't be called while a
+ * workbook that was created with the cache enabled is open.
+ */
+void lxw_image_cache_free(void);
+
+uint8_t lxw_image_cache_is_enabled(void);
+lxw_image_cache_entry *lxw_image_cache_get_file(const char *filename);
+lxw_image_cache_entry *lxw_image_cache_add_file(const char *filename);
+lxw_image_cache_entry *lxw_image_cache_get_data(const char *md5);
+lxw_image_cache_entry *lxw_image_cache_add_data(const char *md5);
+
+/* Declarations required for unit testing. */
+#ifdef TESTING
+
+#endif /* TESTING */
+
+/* *INDENT-OFF* */
+#ifdef __cplusplus
+}
+#endif
+/* *INDENT-ON* */
+
+#endif /* __LXW_IMAGE_CACHE_H__ */
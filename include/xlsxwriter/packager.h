@@ -29,6 +29,7 @@
 #include "core.h"
 #include "custom.h"
 #include "table.h"
+#include "pivot_table.h"
 #include "theme.h"
 #include "styles.h"
 #include "format.h"
@@ -44,6 +45,10 @@
 
 #define LXW_ZIP_BUFFER_SIZE (16384)
 
+/* The number of shared strings assembled between incremental close budget
+ * checks. */
+#define LXW_SST_STEP_STRINGS (1024)
+
 /* If zip returns a ZIP_XXX error then errno is set and we can trap that in
  * workbook.c. Otherwise return a default libxlsxwriter error. */
 #define RETURN_ON_ZIP_ERROR(err, default_err)       \
@@ -78,6 +83,19 @@ typedef struct lxw_packager {
     const char *tmpdir;
     uint8_t use_zip64;
 
+    lxw_sheet *sheet;
+    FILE *member_file;
+    char *member_buffer;
+    size_t member_buffer_size;
+    size_t member_offset;
+    uint8_t member_open;
+    struct sst_element *sst_element;
+    size_t step_budget;
+    size_t step_size;
+    uint32_t sheet_index;
+    uint32_t image_index;
+    uint16_t part;
+
 } lxw_packager;
 
 
@@ -91,10 +109,13 @@ lxw_packager *lxw_packager_new(const char *filename, const char *tmpdir,
                                uint8_t use_zip64);
 void lxw_packager_free(lxw_packager *packager);
 lxw_error lxw_create_package(lxw_packager *self);
+lxw_error lxw_create_package_step(lxw_packager *self, size_t budget);
 
 /* Declarations required for unit testing. */
 #ifdef TESTING
 
+STATIC void _add_app_named_ranges(lxw_app *app, lxw_workbook *workbook);
+
 #endif /* TESTING */
 
 /* *INDENT-OFF* */
@@ -0,0 +1,109 @@
+/*
+ * libxlsxwriter
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ * Copyright 2014-2025, John McNamara, jmcnamara@cpan.org.
+ *
+ * pivot_table - A libxlsxwriter library for creating Excel XLSX pivot table
+ *               and pivot cache files.
+ *
+ */
+#ifndef __LXW_PIVOT_TABLE_H__
+#define __LXW_PIVOT_TABLE_H__
+
+#include <stdint.h>
+
+#include "common.h"
+#include "worksheet.h"
+#include "hash_table.h"
+
+enum lxw_pivot_axis {
+    LXW_PIVOT_AXIS_NONE = 0,
+    LXW_PIVOT_AXIS_ROW,
+    LXW_PIVOT_AXIS_COL
+};
+
+/*
+ * A field of the pivot cache, i.e., a column of the source range. The shared
+ * items are only stored for fields that are used as row or column labels.
+ */
+typedef struct lxw_pivot_cache_field {
+    char *name;
+    uint8_t axis;
+    uint8_t is_data;
+    uint8_t has_string;
+    uint8_t has_number;
+    uint8_t has_boolean;
+    uint8_t has_blank;
+    uint8_t has_non_integer;
+    double min_value;
+    double max_value;
+
+    lxw_hash_table *items;
+
+} lxw_pivot_cache_field;
+
+/*
+ * Struct to represent a pivot table object and its pivot cache.
+ */
+typedef struct lxw_pivot_table {
+
+    FILE *file;
+
+    lxw_pivot_table_obj *pivot_obj;
+
+    lxw_pivot_cache_field *fields;
+    uint16_t num_fields;
+
+    uint16_t *row_fields;
+    uint16_t num_row_fields;
+    uint16_t *col_fields;
+    uint16_t num_col_fields;
+    uint16_t *data_fields;
+    lxw_pivot_data_obj **data_objs;
+    uint16_t num_data_fields;
+
+    uint32_t record_count;
+
+    /* State for streaming the records from the source worksheet. */
+    lxw_cell_iter iter;
+    lxw_cell_value next_value;
+    lxw_cell_value *record;
+    lxw_row_t record_row;
+    uint8_t has_next_value;
+
+    char *key;
+    size_t key_size;
+
+} lxw_pivot_table;
+
+
+/* *INDENT-OFF* */
+#ifdef __cplusplus
+extern "C" {
+#endif
+/* *INDENT-ON* */
+
+lxw_pivot_table *lxw_pivot_table_new(lxw_pivot_table_obj *pivot_obj);
+void lxw_pivot_table_free(lxw_pivot_table *pivot_table);
+lxw_error lxw_pivot_table_check_fields(lxw_pivot_table_obj *pivot_obj);
+lxw_error lxw_pivot_table_build_cache(lxw_pivot_table *self);
+void lxw_pivot_cache_assemble_xml_file(lxw_pivot_table *self);
+void lxw_pivot_records_assemble_xml_file(lxw_pivot_table *self);
+void lxw_pivot_table_assemble_xml_file(lxw_pivot_table *self);
+
+/* Declarations required for unit testing. */
+#ifdef TESTING
+
+STATIC void _pivot_table_xml_declaration(lxw_pivot_table *self);
+STATIC void _pivot_write_location(lxw_pivot_table *self);
+
+#endif /* TESTING */
+
+/* *INDENT-OFF* */
+#ifdef __cplusplus
+}
+#endif
+/* *INDENT-ON* */
+
+#endif /* __LXW_PIVOT_TABLE_H__ */
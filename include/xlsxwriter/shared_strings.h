@@ -69,6 +69,12 @@ void lxw_sst_free(lxw_sst *sst);
 struct sst_element *lxw_get_sst_index(lxw_sst *sst, const char *string,
                                       uint8_t is_rich_string);
 void lxw_sst_assemble_xml_file(lxw_sst *self);
+struct sst_element *lxw_sst_assemble_xml_start(lxw_sst *self);
+struct sst_element *lxw_sst_assemble_xml_strings(lxw_sst *self,
+                                                 struct sst_element
+                                                 *sst_element,
+                                                 uint32_t count);
+void lxw_sst_assemble_xml_end(lxw_sst *self);
 
 /* Declarations required for unit testing. */
 #ifdef TESTING
@@ -274,6 +274,10 @@ int lxw_sprintf_dbl(char *data, double number);
         lxw_snprintf(data, LXW_ATTR_32, "%.16G", number)
 #endif
 
+double lxw_strtod(const char *string, char **end);
+double lxw_round_dbl(double number, lxw_number_precision *precision);
+lxw_error lxw_validate_number_precision(uint8_t type, uint8_t digits);
+
 uint16_t lxw_hash_password(const char *password);
 
 /* *INDENT-OFF* */
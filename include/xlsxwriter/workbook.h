@@ -252,6 +252,33 @@ typedef struct lxw_doc_properties {
  * - `output_buffer_size`: Used with output_buffer to get the size of the
  *   created buffer. This option can only be used if filename is NULL.
  *
+ * - `minimal_package`: Only write the parts of the xlsx package that are
+ *   required to open the file: the content types, the relationships, the
+ *   workbook, the worksheets and the styles, along with any parts needed for
+ *   the data such as shared strings, images, charts or tables. The optional
+ *   `docProps/app.xml`, `docProps/core.xml` and `xl/theme/theme1.xml` parts
+ *   are omitted. This reduces the time and size of small machine generated
+ *   files. The document properties set via workbook_set_properties() aren't
+ *   written in this mode, although custom properties are. The files open in
+ *   Excel, LibreOffice and the common xlsx reading libraries but Excel will
+ *   use its default theme for the file. This option is off by default.
+ *
+ * - `binary_tmpfile`: In `constant_memory` mode store the rows in the
+ *   worksheet temp files in a compact binary format, with the column
+ *   numbers, cell formats, numbers and string indexes stored in binary form,
+ *   instead of as XML. The XML is generated from the stored rows when the
+ *   worksheet is written to the xlsx file. This reduces the size of the temp
+ *   files, and the disk I/O, by several times for large files. The output
+ *   file is the same in either case. This option is off by default and it
+ *   has no effect unless `constant_memory` is also on.
+ *
+ * - `validation_list_sheet`: Store data validation lists that are repeated,
+ *   or that are longer than the Excel limit of 255 characters, once in a
+ *   hidden worksheet called `_ValidationLists`. The validations refer to the
+ *   list range via a hidden defined name. Lists with the same strings are
+ *   only stored once in the workbook. This option is off by default. See
+ *   @ref working_with_data_validation for more details.
+ *
  * @note In `constant_memory` mode each row of in-memory data is written to
  * disk and then freed when a new row is started via one of the
  * `worksheet_write_*()` functions. Therefore, once this option is active data
@@ -281,6 +308,15 @@ typedef struct lxw_workbook_options {
 
     /** Used with output_buffer to get the size of the created buffer */
     size_t *output_buffer_size;
+
+    /** Only write the parts of the xlsx package that are required. */
+    uint8_t minimal_package;
+
+    /** Store constant_memory rows in the temp files in a binary format. */
+    uint8_t binary_tmpfile;
+
+    /** Store long or repeated data validation lists in a hidden worksheet. */
+    uint8_t validation_list_sheet;
 } lxw_workbook_options;
 
 /**
@@ -307,6 +343,9 @@ typedef struct lxw_workbook {
     struct lxw_formats *formats;
     struct lxw_defined_names *defined_names;
     lxw_sst *sst;
+    struct lxw_url_table *url_table;
+    struct lxw_validation_lists *validation_lists;
+    struct lxw_packager *packager;
     lxw_doc_properties *properties;
     struct lxw_custom_properties *custom_properties;
 
@@ -321,8 +360,10 @@ typedef struct lxw_workbook {
     uint16_t num_xf_formats;
     uint16_t num_dxf_formats;
     uint16_t num_format_count;
+    uint16_t num_default_formats;
     uint16_t drawing_count;
     uint16_t comment_count;
+    uint16_t pivot_table_count;
     uint32_t num_embedded_images;
     uint16_t window_width;
     uint16_t window_height;
@@ -353,8 +394,11 @@ typedef struct lxw_workbook {
     char *vba_codename;
 
     uint8_t use_1904_epoch;
+    lxw_number_precision number_precision;
+    lxw_worksheet_residency residency;
 
     lxw_format *default_url_format;
+    char *checkpoint_dir;
 
 } lxw_workbook;
 
@@ -656,6 +700,66 @@ lxw_chart *workbook_add_chart(lxw_workbook *workbook, uint8_t chart_type);
  */
 lxw_error workbook_close(lxw_workbook *workbook);
 
+/**
+ * @brief Start an incremental close of a workbook.
+ *
+ * @param workbook Pointer to a lxw_workbook instance.
+ *
+ * @return A #lxw_error.
+ *
+ * The `%workbook_close_begin()` and `workbook_close_step()` functions are an
+ * alternative to `workbook_close()` for applications, such as event loop
+ * servers, that can't block while a large file is written. The
+ * `%workbook_close_begin()` function runs the finalization code for the
+ * workbook and creates the output file. The file is then written by
+ * repeated calls to `workbook_close_step()`:
+ *
+ * @code
+ *     lxw_error error = workbook_close_begin(workbook);
+ *
+ *     if (!error) {
+ *         do {
+ *             error = workbook_close_step(workbook, 64 * 1024);
+ *             // Handle other events.
+ *         } while (error == LXW_CLOSE_IN_PROGRESS);
+ *     }
+ * @endcode
+ *
+ * If an error is returned the workbook has been freed, as with
+ * `workbook_close()`.
+ */
+lxw_error workbook_close_begin(lxw_workbook *workbook);
+
+/**
+ * @brief Write part of the file in an incremental workbook close.
+ *
+ * @param workbook Pointer to a lxw_workbook instance.
+ * @param budget   The approximate number of bytes to write in the step.
+ *
+ * @return #LXW_CLOSE_IN_PROGRESS, #LXW_NO_ERROR or a #lxw_error.
+ *
+ * The `%workbook_close_step()` function writes the parts of the xlsx file
+ * until roughly `budget` bytes of uncompressed data have been added to it.
+ * A budget of 0 writes the rest of the file.
+ *
+ * The worksheet and shared string parts are added to the file in chunks and
+ * the shared strings are also assembled in chunks. A step can return in the
+ * middle of these parts, or between images. Other parts are written whole
+ * within a step, so a step can exceed the budget by:
+ *
+ * - The time taken to assemble the XML of one worksheet.
+ * - The time taken to add one image.
+ * - The time taken to write the pivot table parts, including the pivot cache
+ *   records, which are assembled from the source data in one step.
+ * - The time taken to write one of the other, generally small, parts such as
+ *   the styles or theme.
+ *
+ * The function returns #LXW_CLOSE_IN_PROGRESS while there is more to write.
+ * Any other return value means that the close is complete, or has failed,
+ * and that the workbook has been freed. See `workbook_close_begin()`.
+ */
+lxw_error workbook_close_step(lxw_workbook *workbook, size_t budget);
+
 /**
  * @brief Set the document properties such as Title, Author etc.
  *
@@ -1096,6 +1200,178 @@ void workbook_read_only_recommended(lxw_workbook *workbook);
  */
 void workbook_use_1904_epoch(lxw_workbook *workbook);
 
+/**
+ * @brief Set the precision used to write numbers to the file.
+ *
+ * @param workbook Pointer to a lxw_workbook instance.
+ * @param type     The precision type. See #lxw_number_precision_types.
+ * @param digits   The number of significant digits or decimal places.
+ *
+ * @return A #lxw_error code.
+ *
+ * By default numbers are written to the file with the full precision of a
+ * double. Data that was measured with a lower precision takes more space in
+ * the file than it needs to and rounding errors, such as the result of
+ * `0.1 + 0.2`, can be written in full.
+ *
+ * The `%workbook_set_number_precision()` function rounds the numbers in
+ * worksheet cells and chart caches to a number of significant digits or
+ * decimal places when they are written. The values stored in the worksheet
+ * aren't changed:
+ *
+ * @code
+ *     workbook_set_number_precision(workbook,
+ *                                   LXW_PRECISION_SIGNIFICANT_DIGITS, 15);
+ * @endcode
+ *
+ * The number of digits can be from 1 to 15 significant digits or 0 to 15
+ * decimal places. The precision of individual columns can be set with
+ * `worksheet_set_column_precision()`.
+ *
+ * The number is scaled by a power of ten and rounded in binary floating
+ * point, with ties rounded to even. Since most decimal fractions aren't
+ * exact in binary a value that looks like a halfway case, such as 1.005
+ * rounded to 2 decimal places, is rounded according to the stored value,
+ * which in this case is slightly less than 1.005 and gives 1.0.
+ *
+ * Formula results aren't rounded since Excel recalculates them.
+ */
+lxw_error workbook_set_number_precision(lxw_workbook *workbook,
+                                        uint8_t type, uint8_t digits);
+
+/**
+ * @brief Limit the number of worksheets that hold their cell data in memory.
+ *
+ * @param workbook      Pointer to a lxw_workbook instance.
+ * @param num_worksheets The maximum number of resident worksheets. 0 turns
+ *                       the limit off.
+ *
+ * The `constant_memory` mode requires data to be written in row order, one
+ * worksheet at a time. Applications that interleave writes across many
+ * worksheets would otherwise hold the cell data of every worksheet in
+ * memory until the workbook is closed.
+ *
+ * The `%workbook_set_max_resident_worksheets()` function keeps the cell data
+ * of at most `num_worksheets` worksheets in memory. When a worksheet is
+ * written to, or read, and the limit is exceeded, the cell data of the least
+ * recently used worksheet is compressed to a temporary file in the `tmpdir`
+ * directory and freed. It is reloaded transparently the next time that the
+ * worksheet is used:
+ *
+ * @code
+ *     workbook_set_max_resident_worksheets(workbook, 8);
+ * @endcode
+ *
+ * When the workbook is closed each spilled worksheet is reloaded just before
+ * it is written and freed straight after, so only one extra worksheet is
+ * held in memory at a time.
+ *
+ * The limit should be set before data is written. It doesn't apply to
+ * worksheets in `constant_memory` mode. Formats, merged ranges, comments and
+ * hyperlinks are kept in memory. Spilling and reloading costs time, so the
+ * limit should be large enough to hold the worksheets that are being
+ * actively written.
+ */
+void workbook_set_max_resident_worksheets(lxw_workbook *workbook,
+                                          uint16_t num_worksheets);
+
+/**
+ * @brief Set a directory for the checkpoints of a constant_memory workbook.
+ *
+ * @param workbook Pointer to a lxw_workbook instance.
+ * @param dir      An existing directory to store the checkpoint files in.
+ *
+ * @return A #lxw_error code.
+ *
+ * In `constant_memory` mode the rows of each worksheet are written to a temp
+ * file as the data is streamed and are lost if the process stops before
+ * workbook_close() is called. For long running exports the rows can be
+ * stored in named files in a checkpoint directory instead. The state needed
+ * to continue writing is then saved with workbook_checkpoint() and restored
+ * in a new process with workbook_resume():
+ *
+ * @code
+ *     lxw_workbook_options options = {.constant_memory = LXW_TRUE};
+ *
+ *     lxw_workbook  *workbook  = workbook_new_opt("export.xlsx", &options);
+ *     workbook_set_checkpoint_dir(workbook, "/var/tmp/export");
+ *
+ *     // Add the worksheets and formats, as on every run.
+ *     lxw_worksheet *worksheet = workbook_add_worksheet(workbook, NULL);
+ *     lxw_format    *bold      = workbook_add_format(workbook);
+ *     format_set_bold(bold);
+ *
+ *     // Continue from the last checkpoint, if there is one.
+ *     workbook_resume(workbook);
+ *
+ *     for (row = worksheet_get_resume_row(worksheet); row < num_rows; row++) {
+ *         write_row(worksheet, row);
+ *
+ *         if (row % 100000 == 0)
+ *             workbook_checkpoint(workbook);
+ *     }
+ *
+ *     workbook_close(workbook);
+ * @endcode
+ *
+ * The function must be called before any worksheets are added. The
+ * directory must exist and must only be used by one workbook at a time. The
+ * checkpoint files are deleted when the workbook is closed successfully.
+ */
+lxw_error workbook_set_checkpoint_dir(lxw_workbook *workbook,
+                                      const char *dir);
+
+/**
+ * @brief Save a checkpoint of a constant_memory workbook.
+ *
+ * @param workbook Pointer to a lxw_workbook instance.
+ *
+ * @return A #lxw_error code.
+ *
+ * Flush the rows written to each worksheet to the files in the checkpoint
+ * directory, see workbook_set_checkpoint_dir(), and save the state needed to
+ * continue writing them: the size of the row data, the next row and the
+ * dimensions of each worksheet, the worksheet hyperlinks and the indexes of
+ * the formats used so far. The checkpoint replaces the previous one
+ * atomically, so a process that stops during a checkpoint resumes from the
+ * previous one.
+ *
+ * The current row of each worksheet is completed by the checkpoint and
+ * further data must be written to later rows. The data is flushed to the
+ * operating system but isn't synced to disk, so a checkpoint survives the
+ * process stopping but not necessarily the system stopping.
+ *
+ * Worksheets with pinned rows, see worksheet_pin_rows(), or row segments
+ * can't be checkpointed.
+ */
+lxw_error workbook_checkpoint(lxw_workbook *workbook);
+
+/**
+ * @brief Resume a constant_memory workbook from its last checkpoint.
+ *
+ * @param workbook Pointer to a lxw_workbook instance.
+ *
+ * @return A #lxw_error code.
+ *
+ * Restore the state saved by the last call to workbook_checkpoint() in a
+ * previous process. Any rows written after that checkpoint are discarded
+ * and writing continues at the row returned by worksheet_get_resume_row()
+ * for each worksheet. If there is no checkpoint in the directory the
+ * function does nothing, so the same code can be used for the first run and
+ * for a resumed run.
+ *
+ * The checkpoint only contains the data written to the worksheets. The
+ * application must recreate the rest of the workbook in the same way as the
+ * first run before calling this function: the worksheets, formats, column
+ * and other worksheet options, images, charts and comments. The formats must
+ * be added in the same order and an error is returned if they don't match
+ * the formats in the checkpoint. Strings in `constant_memory` mode are
+ * stored inline in the rows so there is no shared string table to restore.
+ * The statistics of worksheet_track_column_stats() are restored from the
+ * checkpoint. The output is then the same as a run that wasn't interrupted.
+ */
+lxw_error workbook_resume(lxw_workbook *workbook);
+
 /**
  * @brief Set the size of a workbook window.
  *
@@ -1142,6 +1418,18 @@ STATIC lxw_error _store_defined_name(lxw_workbook *self, const char *name,
                                      const char *formula, int16_t index,
                                      uint8_t hidden);
 
+STATIC lxw_error _prepare_validation_lists(lxw_workbook *self);
+STATIC void _populate_range(lxw_workbook *self, lxw_series_range *range);
+
+STATIC uint32_t _chart_downsample_lttb(double *x, double *y,
+                                       uint32_t num_points,
+                                       uint32_t *indices,
+                                       uint32_t max_points);
+STATIC uint32_t _chart_downsample_min_max(double *y, uint32_t num_points,
+                                          uint32_t *indices,
+                                          uint32_t max_points);
+STATIC lxw_error _prepare_chart_downsampling(lxw_workbook *self);
+
 #endif /* TESTING */
 
 /* *INDENT-OFF* */
@@ -65,6 +65,7 @@
 #define LXW_PANE_NAME_LENGTH        12  /* bottomRight + 1 */
 #define LXW_IMAGE_BUFFER_SIZE       1024
 #define LXW_HEADER_FOOTER_OBJS_MAX  6   /* Header/footer image objs. */
+#define LXW_VALIDATION_MAX_STRING_LENGTH 255
 
 /* The Excel 2007 specification says that the maximum number of page
  * breaks is 1026. However, in practice it is actually 1023. */
@@ -725,7 +726,8 @@ enum cell_types {
     COMMENT,
     HYPERLINK_URL,
     HYPERLINK_INTERNAL,
-    HYPERLINK_EXTERNAL
+    HYPERLINK_EXTERNAL,
+    NUMBER_TEXT_CELL
 };
 
 enum pane_types {
@@ -757,6 +759,12 @@ struct lxw_table_rows {
     lxw_row_t cached_row_num;
 };
 
+/* Define a RB_TREE struct manually to add extra members. */
+struct lxw_url_table {
+    struct lxw_url_element *rbh_root;
+    uint32_t unique_count;
+};
+
 /* Wrapper around RB_GENERATE_STATIC from tree.h to avoid unused function
  * warnings and to avoid portability issues with the _unused attribute. */
 #define LXW_RB_GENERATE_ROW(name, type, field, cmp)       \
@@ -814,15 +822,29 @@ struct lxw_table_rows {
     /* Add unused struct to allow adding a semicolon */         \
     struct lxw_rb_generate_cond_format_hash{int unused;}
 
+#define LXW_RB_GENERATE_URL_ELEMENT(name, type, field, cmp)     \
+    RB_GENERATE_INSERT_COLOR(name, type, field, static)         \
+    RB_GENERATE_REMOVE_COLOR(name, type, field, static)         \
+    RB_GENERATE_INSERT(name, type, field, cmp, static)          \
+    RB_GENERATE_REMOVE(name, type, field, static)               \
+    RB_GENERATE_FIND(name, type, field, cmp, static)            \
+    RB_GENERATE_NEXT(name, type, field, static)                 \
+    RB_GENERATE_MINMAX(name, type, field, static)               \
+    /* Add unused struct to allow adding a semicolon */         \
+    struct lxw_rb_generate_url_element{int unused;}
+
 STAILQ_HEAD(lxw_merged_ranges, lxw_merged_range);
 STAILQ_HEAD(lxw_selections, lxw_selection);
 STAILQ_HEAD(lxw_data_validations, lxw_data_val_obj);
+STAILQ_HEAD(lxw_validation_list_head, lxw_validation_list);
 STAILQ_HEAD(lxw_cond_format_list, lxw_cond_format_obj);
 STAILQ_HEAD(lxw_image_props, lxw_object_properties);
 STAILQ_HEAD(lxw_embedded_image_props, lxw_object_properties);
 STAILQ_HEAD(lxw_chart_props, lxw_object_properties);
 STAILQ_HEAD(lxw_comment_objs, lxw_vml_obj);
 STAILQ_HEAD(lxw_table_objs, lxw_table_obj);
+STAILQ_HEAD(lxw_pivot_table_objs, lxw_pivot_table_obj);
+STAILQ_HEAD(lxw_worksheet_segments, lxw_worksheet);
 
 /**
  * @brief Options for rows and columns.
@@ -850,6 +872,23 @@ typedef struct lxw_row_col_options {
     uint8_t collapsed;
 } lxw_row_col_options;
 
+/**
+ * @brief Options for continuing a worksheet on new worksheets.
+ *
+ * Options used with worksheet_set_rollover() to set the size of each
+ * worksheet and the header rows that are repeated on the continuation
+ * worksheets.
+ */
+typedef struct lxw_rollover_options {
+    /** The number of rows in each worksheet, including the header rows.
+     *  The default of 0 is the Excel limit of 1,048,576 rows. */
+    lxw_row_t max_rows;
+
+    /** The number of rows at the top of the worksheet that are copied to
+     *  each continuation worksheet. */
+    lxw_row_t header_rows;
+} lxw_rollover_options;
+
 typedef struct lxw_col_options {
     lxw_col_t firstcol;
     lxw_col_t lastcol;
@@ -1088,6 +1127,32 @@ typedef struct lxw_data_validation {
 /* A copy of lxw_data_validation which is used internally and which contains
  * some additional fields.
  */
+/*
+ * A data validation list that is stored once and shared by all the data
+ * validations in the workbook with the same list. The strings are stored
+ * consecutively in `data`, each with a NUL terminator. The formula is set
+ * when the workbook is closed.
+ */
+typedef struct lxw_validation_list {
+    char *data;
+    size_t data_size;
+    uint32_t num_items;
+    size_t length;
+    uint64_t hash;
+    uint32_t use_count;
+    char *formula;
+
+    struct lxw_validation_list *next_same_hash;
+    STAILQ_ENTRY (lxw_validation_list) list_pointers;
+} lxw_validation_list;
+
+/* The shared data validation lists of a workbook, indexed by hash. */
+struct lxw_validation_lists {
+    struct lxw_validation_list_head lists;
+    struct lxw_hash_table *hashes;
+    uint32_t count;
+};
+
 typedef struct lxw_data_val_obj {
     uint8_t validate;
     uint8_t criteria;
@@ -1110,6 +1175,7 @@ typedef struct lxw_data_val_obj {
     char *error_title;
     char *error_message;
     char sqref[LXW_MAX_CELL_RANGE_LENGTH];
+    lxw_validation_list *shared_list;
 
     STAILQ_ENTRY (lxw_data_val_obj) list_pointers;
 } lxw_data_val_obj;
@@ -1368,6 +1434,16 @@ typedef struct lxw_cond_format_obj {
     int32_t dxf_index;
     uint32_t dxf_priority;
 
+    /* The format and range used to bake static rules into cell formats. */
+    lxw_format *format;
+    lxw_row_t first_row;
+    lxw_row_t last_row;
+    lxw_col_t first_col;
+    lxw_col_t last_col;
+    uint8_t is_multi_range;
+    uint8_t is_static;
+    uint8_t blanks_match;
+
     char first_cell[LXW_MAX_CELL_NAME_LENGTH];
     char sqref[LXW_MAX_ATTRIBUTE_LENGTH];
 
@@ -1651,12 +1727,131 @@ typedef struct lxw_table_obj {
     lxw_col_t num_cols;
     uint32_t id;
 
+    /* The data rows and columns covered by the calculated columns of the
+     * table. */
+    lxw_row_t first_data_row;
+    lxw_row_t last_data_row;
+    lxw_col_t first_formula_col;
+    lxw_col_t last_formula_col;
+    uint8_t has_formulas;
+
     char sqref[LXW_MAX_ATTRIBUTE_LENGTH];
     char filter_sqref[LXW_MAX_ATTRIBUTE_LENGTH];
     STAILQ_ENTRY (lxw_table_obj) list_pointers;
 
 } lxw_table_obj;
 
+/**
+ * @brief Summary functions for pivot table data fields.
+ *
+ * The functions used to summarize the source data in the values area of a
+ * pivot table.
+ */
+enum lxw_pivot_functions {
+
+    /** Sum the values of the field. The default. */
+    LXW_PIVOT_FUNCTION_SUM = 0,
+
+    /** Count the non-empty values of the field. */
+    LXW_PIVOT_FUNCTION_COUNT,
+
+    /** Use the average of the values of the field. */
+    LXW_PIVOT_FUNCTION_AVERAGE,
+
+    /** Use the maximum value of the field. */
+    LXW_PIVOT_FUNCTION_MAX,
+
+    /** Use the minimum value of the field. */
+    LXW_PIVOT_FUNCTION_MIN
+};
+
+/**
+ * @brief Options for a pivot table data field.
+ *
+ * Options used to define a field in the values area of a pivot table. See
+ * worksheet_add_pivot_table().
+ */
+typedef struct lxw_pivot_data_field {
+
+    /** The header name of the source column to summarize. */
+    const char *field;
+
+    /** The summary function. See #lxw_pivot_functions. */
+    uint8_t function;
+
+    /** An optional caption such as "Total Sales". The default is in the
+     *  Excel style of "Sum of Sales". */
+    const char *name;
+
+} lxw_pivot_data_field;
+
+/**
+ * @brief Options for pivot tables.
+ *
+ * Options used to define a pivot table. See worksheet_add_pivot_table().
+ */
+typedef struct lxw_pivot_table_options {
+
+    /** The name of the pivot table. The default is "PivotTable1",
+     *  "PivotTable2", etc. */
+    const char *name;
+
+    /** The worksheet that contains the source data. */
+    struct lxw_worksheet *source;
+
+    /** The first row of the source range. This row contains the field
+     *  names. (All zero indexed.) */
+    lxw_row_t first_row;
+
+    /** The first column of the source range. */
+    lxw_col_t first_col;
+
+    /** The last row of the source range. */
+    lxw_row_t last_row;
+
+    /** The last column of the source range. */
+    lxw_col_t last_col;
+
+    /** A NULL terminated list of field names to show as row labels. */
+    const char **row_fields;
+
+    /** A NULL terminated list of field names to show as column labels. */
+    const char **column_fields;
+
+    /** A NULL terminated list of pointers to #lxw_pivot_data_field structs
+     *  for the values area. */
+    lxw_pivot_data_field **data_fields;
+
+} lxw_pivot_table_options;
+
+typedef struct lxw_pivot_data_obj {
+    char *field;
+    char *name;
+    uint8_t function;
+} lxw_pivot_data_obj;
+
+typedef struct lxw_pivot_table_obj {
+    char *name;
+    struct lxw_worksheet *source;
+    char **row_fields;
+    char **col_fields;
+    lxw_pivot_data_obj *data_fields;
+    uint16_t num_row_fields;
+    uint16_t num_col_fields;
+    uint16_t num_data_fields;
+
+    lxw_row_t row;
+    lxw_col_t col;
+    lxw_row_t first_row;
+    lxw_col_t first_col;
+    lxw_row_t last_row;
+    lxw_col_t last_col;
+    uint32_t id;
+
+    STAILQ_ENTRY (lxw_pivot_table_obj) list_pointers;
+
+} lxw_pivot_table_obj;
+
 /**
  * @brief Options for autofilter rules.
  *
@@ -2105,6 +2300,19 @@ typedef struct lxw_rich_string_tuple {
     const char *string;
 } lxw_rich_string_tuple;
 
+TAILQ_HEAD(lxw_resident_worksheets, lxw_worksheet);
+
+/*
+ * Struct to limit the number of worksheets that hold their cell data in
+ * memory. The resident worksheets are kept in least recently used order.
+ * See workbook_set_max_resident_worksheets().
+ */
+typedef struct lxw_worksheet_residency {
+    struct lxw_resident_worksheets resident;
+    uint16_t max_resident;
+    uint16_t num_resident;
+} lxw_worksheet_residency;
+
 /**
  * @brief Struct to represent an Excel worksheet.
  *
@@ -2136,6 +2344,11 @@ typedef struct lxw_worksheet {
     struct lxw_comment_objs *button_objs;
     struct lxw_table_objs *table_objs;
     uint16_t table_count;
+    uint8_t has_table_formulas;
+    lxw_row_t table_formula_first_row;
+    lxw_row_t table_formula_last_row;
+    struct lxw_pivot_table_objs *pivot_table_objs;
+    uint16_t pivot_table_count;
 
     lxw_row_t dim_rowmin;
     lxw_row_t dim_rowmax;
@@ -2143,6 +2356,9 @@ typedef struct lxw_worksheet {
     lxw_col_t dim_colmax;
 
     lxw_sst *sst;
+    struct lxw_url_table *url_table;
+    uint8_t free_url_table;
+    struct lxw_validation_lists *validation_lists;
     const char *name;
     const char *quoted_name;
     const char *tmpdir;
@@ -2167,7 +2383,45 @@ typedef struct lxw_worksheet {
     uint8_t col_size_changed;
     uint8_t row_size_changed;
     uint8_t optimize;
+    uint8_t binary_tmpfile;
     struct lxw_row *optimize_row;
+    lxw_format **record_formats;
+    uint32_t record_formats_max;
+
+    struct lxw_worksheet_segments *segments;
+    struct lxw_formats *formats;
+    uint16_t num_default_formats;
+    lxw_format **batch_formats;
+    uint16_t num_batch_formats;
+    uint16_t batch_formats_size;
+    lxw_number_precision *number_precision;
+    lxw_number_precision *col_precision;
+    lxw_row_t segment_first_row;
+    lxw_row_t segment_last_row;
+    size_t segment_offset;
+    uint8_t is_segment;
+    uint8_t segment_offset_set;
+    lxw_row_t pinned_rows;
+    uint8_t trusted_input;
+    lxw_row_t rollover_rows;
+    lxw_row_t rollover_header_rows;
+    struct lxw_worksheet **rollover_sheets;
+    uint16_t rollover_count;
+    struct lxw_workbook *workbook;
+    struct lxw_column_accumulator *column_stats;
+    lxw_row_t stats_first_row;
+    lxw_row_t stats_last_row;
+    lxw_col_t stats_first_col;
+    lxw_col_t stats_last_col;
+    lxw_row_t stats_row_offset;
+    uint8_t stats_shared;
+    uint8_t stats_generation;
+
+    lxw_worksheet_residency *residency;
+    FILE *spill_file;
+    uint32_t reload_count;
+    uint8_t is_resident;
+    TAILQ_ENTRY (lxw_worksheet) residency_pointers;
 
     uint16_t fit_height;
     uint16_t fit_width;
@@ -2179,6 +2433,8 @@ typedef struct lxw_worksheet {
     uint16_t vertical_dpi;
     uint16_t zoom;
     uint8_t filter_on;
+    uint8_t hide_filtered_rows;
+    uint8_t bake_cond_formats;
     uint8_t fit_page;
     uint8_t hcenter;
     uint8_t orientation;
@@ -2246,6 +2502,7 @@ typedef struct lxw_worksheet {
     struct lxw_rel_tuples *drawing_links;
     struct lxw_rel_tuples *vml_drawing_links;
     struct lxw_rel_tuples *external_table_links;
+    struct lxw_rel_tuples *external_pivot_table_links;
 
     struct lxw_panes panes;
     char top_left_cell[LXW_MAX_CELL_NAME_LENGTH];
@@ -2321,6 +2578,13 @@ typedef struct lxw_worksheet_init_data {
     lxw_format *default_url_format;
     uint16_t max_url_length;
     uint8_t use_1904_epoch;
+    struct lxw_url_table *url_table;
+    struct lxw_validation_lists *validation_lists;
+    struct lxw_formats *formats;
+    uint16_t num_default_formats;
+    lxw_number_precision *number_precision;
+    lxw_worksheet_residency *residency;
+    uint8_t binary_tmpfile;
 
 } lxw_worksheet_init_data;
 
@@ -2346,6 +2610,10 @@ typedef struct lxw_row {
 typedef struct lxw_cell {
     lxw_row_t row_num;
     lxw_col_t col_num;
+
+    /* The worksheet_track_column_stats() call that counted the value. */
+    uint8_t stats_generation;
+
     enum cell_types type;
     lxw_format *format;
     lxw_vml_obj *comment;
@@ -2365,6 +2633,164 @@ typedef struct lxw_cell {
     RB_ENTRY (lxw_cell) tree_pointers;
 } lxw_cell;
 
+/** Cell value types returned by worksheet_get_cell() and
+ *  worksheet_cell_iter_next(). */
+enum lxw_cell_value_types {
+    /** The cell doesn't contain any data. */
+    LXW_CELL_VALUE_EMPTY = 0,
+
+    /** Number cell. The value is stored in `number`. */
+    LXW_CELL_VALUE_NUMBER,
+
+    /** String cell. The value is stored in `string`. */
+    LXW_CELL_VALUE_STRING,
+
+    /** Formula cell. The formula is stored in `string` and the cached
+     *  numeric result, if any, in `number`. */
+    LXW_CELL_VALUE_FORMULA,
+
+    /** Boolean cell. The value, 0 or 1, is stored in `number`. */
+    LXW_CELL_VALUE_BOOLEAN,
+
+    /** Blank cell with a format. */
+    LXW_CELL_VALUE_BLANK,
+
+    /** Error cell. */
+    LXW_CELL_VALUE_ERROR
+};
+
+/**
+ * @brief The value of a worksheet cell.
+ *
+ * Struct used to return the data written to a cell by worksheet_get_cell()
+ * and worksheet_cell_iter_next(). The `string` and `format` pointers refer
+ * to data owned by the workbook and are valid until the cell is overwritten
+ * or the workbook is closed.
+ */
+typedef struct lxw_cell_value {
+    /** The zero indexed row of the cell. */
+    lxw_row_t row;
+
+    /** The zero indexed column of the cell. */
+    lxw_col_t col;
+
+    /** The cell type. See #lxw_cell_value_types. */
+    uint8_t type;
+
+    /** The numeric value of the cell, where applicable. */
+    double number;
+
+    /** The string value or formula of the cell, where applicable. */
+    const char *string;
+
+    /** The format of the cell, or NULL. */
+    lxw_format *format;
+} lxw_cell_value;
+
+/**
+ * @brief Iterator over the cells in a worksheet range.
+ *
+ * Struct used by worksheet_cell_iter_init() and worksheet_cell_iter_next().
+ * The members are private.
+ */
+typedef struct lxw_cell_iter {
+    struct lxw_worksheet *worksheet;
+    struct lxw_row *row;
+    struct lxw_cell *cell;
+    lxw_row_t first_row;
+    lxw_row_t last_row;
+    lxw_col_t first_col;
+    lxw_col_t last_col;
+    lxw_col_t col;
+    lxw_row_t row_num;
+    uint32_t reload_count;
+    uint8_t started;
+} lxw_cell_iter;
+
+/**
+ * @brief Running statistics for a worksheet column.
+ *
+ * The statistics of the values written to a column of the range set with
+ * worksheet_track_column_stats(). See worksheet_get_column_stats().
+ */
+typedef struct lxw_column_stats {
+    /** The number of cells in the column with a number or string. */
+    uint32_t count;
+
+    /** The number of cells with a number, including dates and times. */
+    uint32_t number_count;
+
+    /** The number of cells with a string. */
+    uint32_t string_count;
+
+    /** The sum of the numbers. */
+    double sum;
+
+    /** The minimum number, or 0 if no numbers were written. */
+    double min;
+
+    /** The maximum number, or 0 if no numbers were written. */
+    double max;
+
+    /** The number of distinct strings. This is exact for up to 256 distinct
+     *  strings and an estimate, with an error of a few percent, above
+     *  that. */
+    uint32_t distinct_strings;
+} lxw_column_stats;
+
+/* The number of string hashes kept for the distinct string estimate. */
+#define LXW_COLUMN_STATS_HASHES 256
+
+typedef struct lxw_column_accumulator {
+    uint32_t number_count;
+    uint32_t string_count;
+    double sum;
+    double min;
+    double max;
+
+    /* The smallest string hashes, in ascending order. */
+    uint64_t *hashes;
+    uint16_t num_hashes;
+} lxw_column_accumulator;
+
+/**
+ * Opcodes for the commands used by worksheet_execute_batch(). All integers
+ * are unsigned and little-endian and numbers are IEEE 754 doubles stored as
+ * 8 little-endian bytes. In the layouts below `row` is 4 bytes, `col` is 2
+ * bytes and strings are a 4 byte length followed by the UTF-8 bytes of the
+ * string, without a terminating null.
+ */
+enum lxw_batch_opcodes {
+    /** Set the format used by the following commands:
+     *  `format_id(2)`. Id 0 is no format. */
+    LXW_BATCH_SET_FORMAT = 1,
+
+    /** Write a number: `row col number(8)`. */
+    LXW_BATCH_WRITE_NUMBER,
+
+    /** Write a string: `row col string`. */
+    LXW_BATCH_WRITE_STRING,
+
+    /** Write a formula: `row col string`. */
+    LXW_BATCH_WRITE_FORMULA,
+
+    /** Write a blank cell: `row col`. */
+    LXW_BATCH_WRITE_BLANK,
+
+    /** Write a boolean: `row col value(1)`. */
+    LXW_BATCH_WRITE_BOOLEAN,
+
+    /** Write a date/time: `row col year(2) month(1) day(1) hour(1)
+     *  min(1) sec(8)`. */
+    LXW_BATCH_WRITE_DATETIME,
+
+    /** Set the row height and format: `row height(8)`. */
+    LXW_BATCH_SET_ROW,
+
+    /** Merge a range: `first_row first_col last_row last_col string`. */
+    LXW_BATCH_MERGE_RANGE
+};
+
 /* Struct to represent a drawing Target/ID pair. */
 typedef struct lxw_drawing_rel_id {
     uint32_t id;
@@ -2373,6 +2799,18 @@ typedef struct lxw_drawing_rel_id {
     RB_ENTRY (lxw_drawing_rel_id) tree_pointers;
 } lxw_drawing_rel_id;
 
+/* Struct to represent a normalized hyperlink url stored once per workbook.
+ * The key is the url as written, or the normalized url for links read from
+ * a checkpoint, so that a repeated url isn't normalized again. */
+typedef struct lxw_url_element {
+    char *key;
+    char *url;
+    size_t url_length;
+    uint8_t is_normalized;
+
+    RB_ENTRY (lxw_url_element) tree_pointers;
+} lxw_url_element;
+
 
 
 /* *INDENT-OFF* */
@@ -2428,6 +2866,81 @@ lxw_error worksheet_write_number(lxw_worksheet *worksheet,
                                  lxw_row_t row,
                                  lxw_col_t col, double number,
                                  lxw_format *format);
+
+/**
+ * @brief Write a number, in text form, to a worksheet cell.
+ *
+ * @param worksheet Pointer to a lxw_worksheet instance to be updated.
+ * @param row       The zero indexed row number.
+ * @param col       The zero indexed column number.
+ * @param digits    The number as decimal text. It doesn't need to be NULL
+ *                  terminated.
+ * @param length    The length of the text in bytes.
+ * @param format    A pointer to a Format instance or NULL.
+ *
+ * @return A #lxw_error code.
+ *
+ * The `%worksheet_write_number_text()` function writes a number that is
+ * stored as text, such as a decimal value read from a database, without
+ * converting it to a double and back:
+ *
+ * @code
+ *     worksheet_write_number_text(worksheet, 0, 0, "12345.6700", 10, NULL);
+ * @endcode
+ *
+ * The text must be a decimal number with an optional sign, fraction and
+ * exponent, such as `123`, `-0.5`, `.25` or `1.5E-10`. Other text, including
+ * leading or trailing whitespace, returns `LXW_ERROR_PARAMETER_VALIDATION`.
+ * The number is stored in the file in a minimal form: leading `+` signs,
+ * leading zeros and trailing zeros in the fraction are removed, so the
+ * example above is stored as `12345.67`. Otherwise the digits are written
+ * to the file as they are. This avoids the time to convert the number twice
+ * and any change in the digits from the conversion.
+ *
+ * Excel reads the number as a double when the file is opened. The number
+ * isn't rounded by workbook_set_number_precision() or
+ * worksheet_set_column_precision().
+ */
+lxw_error worksheet_write_number_text(lxw_worksheet *worksheet,
+                                      lxw_row_t row,
+                                      lxw_col_t col,
+                                      const char *digits, size_t length,
+                                      lxw_format *format);
+
+/**
+ * @brief Add a number to the value in a worksheet cell.
+ *
+ * @param worksheet Pointer to a lxw_worksheet instance to be updated.
+ * @param row       The zero indexed row number.
+ * @param col       The zero indexed column number.
+ * @param delta     The number to add to the cell value.
+ * @param format    A pointer to a Format instance or NULL to keep the
+ *                  existing cell format.
+ *
+ * @return A #lxw_error code.
+ *
+ * The `worksheet_accumulate_number()` function adds a number to the numeric
+ * value of a worksheet cell. It is useful for running totals and other
+ * summary cells that are updated many times before the file is closed:
+ *
+ * @code
+ *     for (i = 0; i < num_sales; i++)
+ *         worksheet_accumulate_number(worksheet, region[i], 1, sales[i], NULL);
+ * @endcode
+ *
+ * The existing cell is updated in place so repeated updates don't allocate
+ * memory. An empty or blank cell is treated as 0. If the cell contains
+ * data that isn't a number, such as a string or a formula, the function
+ * returns `LXW_ERROR_PARAMETER_VALIDATION` and the cell isn't changed.
+ *
+ * In `constant_memory` mode only cells in the current row can be updated.
+ * Updating a cell in a row that has already been written returns
+ * `LXW_ERROR_WORKSHEET_INDEX_OUT_OF_RANGE` and the cell isn't changed.
+ */
+lxw_error worksheet_accumulate_number(lxw_worksheet *worksheet,
+                                      lxw_row_t row,
+                                      lxw_col_t col, double delta,
+                                      lxw_format *format);
 /**
  * @brief Write a string to a worksheet cell.
  *
@@ -3609,6 +4122,39 @@ lxw_error worksheet_set_column_pixels_opt(lxw_worksheet *worksheet,
                                           lxw_format *format,
                                           lxw_row_col_options *options);
 
+/**
+ * @brief Set the precision used to write the numbers in a range of columns.
+ *
+ * @param worksheet Pointer to a lxw_worksheet instance to be updated.
+ * @param first_col The zero indexed first column.
+ * @param last_col  The zero indexed last column.
+ * @param type      The precision type. See #lxw_number_precision_types.
+ * @param digits    The number of significant digits or decimal places.
+ *
+ * @return A #lxw_error code.
+ *
+ * The `%worksheet_set_column_precision()` function sets the precision used
+ * to write numbers in a range of columns to the file. It overrides the
+ * workbook precision set with `workbook_set_number_precision()`:
+ *
+ * @code
+ *     // Write sensor readings in column C with 7 significant digits.
+ *     worksheet_set_column_precision(worksheet, 2, 2,
+ *                                    LXW_PRECISION_SIGNIFICANT_DIGITS, 7);
+ *
+ *     // Write the numbers in column D in full.
+ *     worksheet_set_column_precision(worksheet, 3, 3, LXW_PRECISION_FULL, 0);
+ * @endcode
+ *
+ * The column precision also applies to the chart cache values read from
+ * the column. See `workbook_set_number_precision()` for details of the
+ * rounding.
+ */
+lxw_error worksheet_set_column_precision(lxw_worksheet *worksheet,
+                                         lxw_col_t first_col,
+                                         lxw_col_t last_col, uint8_t type,
+                                         uint8_t digits);
+
 /**
  * @brief Insert an image in a worksheet cell.
  *
@@ -4202,7 +4748,8 @@ lxw_error worksheet_autofilter(lxw_worksheet *worksheet, lxw_row_t first_row,
  * column in an existing autofilter created with `worksheet_autofilter()`.
  *
  * It isn't sufficient to just specify the filter condition. You must also
- * hide any rows that don't match the filter condition. See @ref
+ * hide any rows that don't match the filter condition, or use
+ * `worksheet_hide_filtered_rows()` to hide them automatically. See @ref
  * ww_autofilters_data for more details.
  */
 lxw_error worksheet_filter_column(lxw_worksheet *worksheet, lxw_col_t col,
@@ -4243,7 +4790,8 @@ lxw_error worksheet_filter_column(lxw_worksheet *worksheet, lxw_col_t col,
  * The `and_or` parameter is either "and (LXW_FILTER_AND)" or "or  (LXW_FILTER_OR)".
  *
  * It isn't sufficient to just specify the filter condition. You must also
- * hide any rows that don't match the filter condition. See @ref
+ * hide any rows that don't match the filter condition, or use
+ * `worksheet_hide_filtered_rows()` to hide them automatically. See @ref
  * ww_autofilters_data for more details.
  */
 lxw_error worksheet_filter_column2(lxw_worksheet *worksheet, lxw_col_t col,
@@ -4287,12 +4835,52 @@ lxw_error worksheet_filter_column2(lxw_worksheet *worksheet, lxw_col_t col,
  * @endcode
  *
  * It isn't sufficient to just specify the filter condition. You must also
- * hide any rows that don't match the filter condition. See @ref
+ * hide any rows that don't match the filter condition, or use
+ * `worksheet_hide_filtered_rows()` to hide them automatically. See @ref
  * ww_autofilters_data for more details.
  */
 lxw_error worksheet_filter_list(lxw_worksheet *worksheet, lxw_col_t col,
                                 const char **list);
 
+/**
+ * @brief Hide the rows that don't match the autofilter rules.
+ *
+ * @param worksheet Pointer to a lxw_worksheet instance to be updated.
+ *
+ * @return A #lxw_error code.
+ *
+ * The `%worksheet_hide_filtered_rows()` function tells the worksheet to
+ * evaluate the rules added with `worksheet_filter_column()`,
+ * `worksheet_filter_column2()` and `worksheet_filter_list()` against the
+ * data in the autofilter range when the workbook is closed, and to hide the
+ * rows that don't match. This replaces the manual hiding of rows described
+ * in @ref ww_autofilters_data:
+ *
+ * @code
+ *     worksheet_autofilter(worksheet, 0, 0, 50, 3);
+ *
+ *     lxw_filter_rule filter_rule = {.criteria     = LXW_FILTER_CRITERIA_EQUAL_TO,
+ *                                    .value_string = "East"};
+ *
+ *     worksheet_filter_column(worksheet, 0, &filter_rule);
+ *
+ *     worksheet_hide_filtered_rows(worksheet);
+ * @endcode
+ *
+ * The rules are evaluated like Excel: string comparisons are case
+ * insensitive, the `*` and `?` wildcards can be used with the equal and not
+ * equal criteria and numbers are matched against string rules using the
+ * number as it is displayed in a General format. Formulas are evaluated
+ * using their stored result value.
+ *
+ * Rows that match the rules aren't changed. Rows without any data are only
+ * hidden if blank cells don't match the rules.
+ *
+ * This function isn't supported in `constant_memory` mode and it doesn't
+ * apply to rows written to worksheet segments.
+ */
+lxw_error worksheet_hide_filtered_rows(lxw_worksheet *worksheet);
+
 /**
  * @brief Add a data validation to a cell.
  *
@@ -4452,6 +5040,51 @@ lxw_error worksheet_conditional_format_range(lxw_worksheet *worksheet,
                                              lxw_col_t last_col,
                                              lxw_conditional_format
                                              *conditional_format);
+
+/**
+ * @brief Bake static conditional formats into the cell formats.
+ *
+ * @param worksheet Pointer to a lxw_worksheet instance to be updated.
+ *
+ * @return A #lxw_error code.
+ *
+ * The `%worksheet_bake_conditional_formats()` function tells the worksheet
+ * to evaluate the simple conditional formats added with
+ * `worksheet_conditional_format_range()` against the stored cell data when
+ * the workbook is closed. The cells that match get a cell format that
+ * combines their own format with the conditional format, and the rules
+ * aren't written to the file. This avoids Excel re-evaluating the rules
+ * when large, static, data is opened or scrolled:
+ *
+ * @code
+ *     conditional_format.type     = LXW_CONDITIONAL_TYPE_CELL;
+ *     conditional_format.criteria = LXW_CONDITIONAL_CRITERIA_LESS_THAN;
+ *     conditional_format.value    = 0;
+ *     conditional_format.format   = red;
+ *     worksheet_conditional_format_range(worksheet, RANGE("A1:D100000"),
+ *                                        &conditional_format);
+ *
+ *     worksheet_bake_conditional_formats(worksheet);
+ * @endcode
+ *
+ * Only #LXW_CONDITIONAL_TYPE_CELL rules with number values, and
+ * #LXW_CONDITIONAL_TYPE_TEXT, #LXW_CONDITIONAL_TYPE_BLANKS and
+ * #LXW_CONDITIONAL_TYPE_NO_BLANKS rules are baked. Text rules that contain
+ * the `*` or `?` wildcards, rules with a `multi_range` and rules over
+ * formulas are left as conditional formats. So are rules that overlap
+ * another rule that can't be baked, so that the rule priorities and
+ * `stop_if_true` are applied as they would be in Excel. Rules that match
+ * blank cells are only baked if they are within the range of the worksheet
+ * data since the blank cells need to be written with the format.
+ *
+ * The font color, bold, italic, underline, strikeout, number format, fill
+ * and border properties of the conditional format are applied to the cell
+ * format, in the same way as Excel.
+ *
+ * This function isn't supported in `constant_memory` mode.
+ */
+lxw_error worksheet_bake_conditional_formats(lxw_worksheet *worksheet);
+
 /**
  * @brief Insert a button object into a worksheet.
  *
@@ -4517,6 +5150,58 @@ lxw_error worksheet_add_table(lxw_worksheet *worksheet, lxw_row_t first_row,
                               lxw_col_t first_col, lxw_row_t last_row,
                               lxw_col_t last_col, lxw_table_options *options);
 
+/**
+ * @brief Add a pivot table to a worksheet.
+ *
+ * @param worksheet  Pointer to a lxw_worksheet instance to be updated.
+ * @param row        The zero indexed row of the top left cell of the table.
+ * @param col        The zero indexed column of the top left cell.
+ * @param options    A #lxw_pivot_table_options struct to define the table.
+ *
+ * @return A #lxw_error code.
+ *
+ * The `%worksheet_add_pivot_table()` function adds a pivot table that
+ * summarizes a range of data in another, or the same, worksheet. The first
+ * row of the source range holds the field names and the fields are referred
+ * to by those names:
+ *
+ * @code
+ *     const char *rows[] = {"Region", NULL};
+ *     lxw_pivot_data_field sales = {.field = "Sales"};
+ *     lxw_pivot_data_field *values[] = {&sales, NULL};
+ *
+ *     lxw_pivot_table_options options = {
+ *         .source     = data_worksheet,
+ *         .first_row  = 0,
+ *         .first_col  = 0,
+ *         .last_row   = 1000,
+ *         .last_col   = 3,
+ *         .row_fields = rows,
+ *         .data_fields = values,
+ *     };
+ *
+ *     worksheet_add_pivot_table(worksheet, 2, 0, &options);
+ * @endcode
+ *
+ * The header row of the source range must be written before the pivot
+ * table is added since the field names are checked against it. A name that
+ * isn't in the header row returns #LXW_ERROR_PARAMETER_VALIDATION. As in
+ * Excel, duplicate header names are made unique by appending "2", "3", etc.,
+ * so the second of two "Sales" columns is referred to as "Sales2".
+ *
+ * The pivot cache records are read from the source worksheet when the
+ * workbook is closed so the other rows of the source data can be written
+ * before or after the pivot table is added. The pivot table is set to
+ * refresh when the file is opened and Excel calculates the summary values at
+ * that point.
+ *
+ * The source worksheet can't be in `constant_memory` mode since the data has
+ * already been written to disk by the time the pivot cache is created.
+ */
+lxw_error worksheet_add_pivot_table(lxw_worksheet *worksheet, lxw_row_t row,
+                                    lxw_col_t col,
+                                    lxw_pivot_table_options *options);
+
  /**
   * @brief Make a worksheet the active, i.e., visible worksheet.
   *
@@ -5904,8 +6589,423 @@ void worksheet_set_comments_author(lxw_worksheet *worksheet,
 lxw_error worksheet_ignore_errors(lxw_worksheet *worksheet, uint8_t type,
                                   const char *range);
 
+/**
+ * @brief Open a row range segment that can be written from another thread.
+ *
+ * @param worksheet Pointer to a lxw_worksheet instance to be updated.
+ * @param first_row The first row of the segment (zero indexed).
+ * @param last_row  The last row of the segment (zero indexed).
+ *
+ * @return A segment worksheet object or NULL on error.
+ *
+ * The `%worksheet_open_segment()` function reserves a range of rows in a
+ * worksheet and returns a segment object that is used to write data to
+ * those rows. Each segment stores its data in `constant_memory` mode in its
+ * own temporary file so that separate segments can be written at the same
+ * time from separate threads:
+ *
+ * @code
+ *     lxw_worksheet *segment1 = worksheet_open_segment(worksheet, 1, 50000);
+ *     lxw_worksheet *segment2 = worksheet_open_segment(worksheet, 50001, 100000);
+ *
+ *     // In thread 1.
+ *     worksheet_write_number(segment1, 1, 0, 123, NULL);
+ *     ...
+ *     worksheet_close_segment(segment1);
+ *
+ *     // In thread 2.
+ *     worksheet_write_number(segment2, 50001, 0, 456, NULL);
+ *     ...
+ *     worksheet_close_segment(segment2);
+ * @endcode
+ *
+ * The segment object is passed to the standard `worksheet_write_*()` and
+ * `worksheet_set_row()` functions. As with `constant_memory` mode the data
+ * must be written in row order within a segment and strings are stored
+ * inline. Rows outside the segment range return
+ * #LXW_ERROR_WORKSHEET_INDEX_OUT_OF_RANGE. The segments are joined in row
+ * order into the parent worksheet when the workbook is closed.
+ *
+ * Only cell data and row properties are taken from a segment. Other
+ * worksheet features such as merged ranges, hyperlinks,
+ * comments and images should be added to the parent worksheet.
+ *
+ * Segments must not overlap and the parent worksheet can't write to rows
+ * inside a segment. In `constant_memory` mode the segment must also start
+ * after the rows already written in the parent worksheet.
+ *
+ * **Note**: The segments should be opened from the main thread after the
+ * formats and column formats that they will use have been created and set
+ * up. Format indexes are assigned when the segment is opened so that the
+ * threads don't need to update the shared format table. The segment object
+ * is owned by the parent worksheet and is freed with it.
+ */
+lxw_worksheet *worksheet_open_segment(lxw_worksheet *worksheet,
+                                      lxw_row_t first_row,
+                                      lxw_row_t last_row);
+
+/**
+ * @brief Flush the data in a worksheet segment.
+ *
+ * @param segment Pointer to a segment from worksheet_open_segment().
+ *
+ * @return A #lxw_error code.
+ *
+ * The `%worksheet_close_segment()` function writes out the last row held in
+ * memory by a segment so that the writing is completed in the segment's own
+ * thread. It is optional since any open segments are also flushed when the
+ * workbook is closed.
+ */
+lxw_error worksheet_close_segment(lxw_worksheet *segment);
+
+/**
+ * @brief Keep the first rows of a worksheet in memory in constant_memory mode.
+ *
+ * @param worksheet Pointer to a lxw_worksheet instance to be updated.
+ * @param num_rows  The number of rows, from the first row, to keep in memory.
+ *
+ * @return A #lxw_error code.
+ *
+ * In `constant_memory` mode each row is written to a temp file when a cell
+ * is written to a later row and it can't be changed after that. The
+ * `%worksheet_pin_rows()` function keeps the first `num_rows` rows of the
+ * worksheet in memory instead so that they can be written at any time. This
+ * is useful for header, total or summary rows at the top of a worksheet
+ * whose values are only known once the rest of the data has been streamed:
+ *
+ * @code
+ *     worksheet_pin_rows(worksheet, 1);
+ *
+ *     for (row = 1; row < num_rows; row++) {
+ *         worksheet_write_number(worksheet, row, 0, data[row], NULL);
+ *         total += data[row];
+ *     }
+ *
+ *     worksheet_write_number(worksheet, 0, 0, total, NULL);
+ * @endcode
+ *
+ * The pinned rows are written before the streamed rows when the workbook is
+ * closed. Since they are stored in memory, like rows in the default mode,
+ * the number of pinned rows should be small. Strings in pinned rows are
+ * stored inline as with the rest of a `constant_memory` worksheet.
+ *
+ * This function must be called before any data is written to the
+ * worksheet. It has no effect if `constant_memory` mode isn't on since all
+ * rows can be changed in that case.
+ */
+lxw_error worksheet_pin_rows(lxw_worksheet *worksheet, lxw_row_t num_rows);
+
+/**
+ * @brief Skip the validation of the data written to a worksheet.
+ *
+ * @param worksheet Pointer to a lxw_worksheet instance to be updated.
+ * @param trusted   Turn the trusted input mode on or off. Off by default.
+ *
+ * The `worksheet_write_*()` functions check the data that is written to a
+ * worksheet: that the row and column are in the range of the worksheet and
+ * haven't already been written in `constant_memory` mode, that strings and
+ * formulas aren't `NULL` or empty, that strings aren't longer than the
+ * Excel limit and, in `constant_memory` mode, that strings don't contain
+ * control characters that need to be escaped. For applications that write
+ * large amounts of data that is already known to be valid these checks can
+ * be turned off with `%worksheet_set_trusted_input()`:
+ *
+ * @code
+ *     worksheet_set_trusted_input(worksheet, LXW_TRUE);
+ *
+ *     for (row = 0; row < num_rows; row++) {
+ *         worksheet_write_string(worksheet, row, 0, names[row], NULL);
+ *         worksheet_write_number(worksheet, row, 1, values[row], NULL);
+ *     }
+ * @endcode
+ *
+ * The worksheet dimensions are still updated for each cell.
+ *
+ * This applies to worksheet_write_number(), worksheet_write_number_text(),
+ * worksheet_write_string(), worksheet_write_formula(),
+ * worksheet_write_formula_num(), worksheet_write_formula_str(),
+ * worksheet_write_boolean() and worksheet_write_blank(). The text of
+ * worksheet_write_number_text() is still checked since it is stored in a
+ * normalized form. The other functions validate their data as normal.
+ *
+ * **Note**: invalid data written in this mode isn't reported and will
+ * produce an invalid file or undefined behavior. Strings in this mode
+ * must not be `NULL` or empty, rather than being ignored or written as blank
+ * cells as in the default mode. To test an application with this mode the
+ * library can be compiled with the `USE_TRUSTED_INPUT_CHECKS` option. The
+ * data is then validated and any errors are reported as warnings and
+ * returned from the `worksheet_write_*()` functions.
+ */
+void worksheet_set_trusted_input(lxw_worksheet *worksheet, uint8_t trusted);
+
+/**
+ * @brief Continue a worksheet on new worksheets when it is full.
+ *
+ * @param worksheet Pointer to a lxw_worksheet instance to be updated.
+ * @param options   A #lxw_rollover_options struct with the worksheet size
+ *                  and header rows.
+ *
+ * @return A #lxw_error code.
+ *
+ * Excel worksheets are limited to 1,048,576 rows. The
+ * `%worksheet_set_rollover()` function allows an application to keep writing
+ * rows past the end of a worksheet, or past a smaller `max_rows` limit. The
+ * rows are then written to continuation worksheets that are added to the
+ * workbook as required, with the name of the worksheet and a number such as
+ * "Data (2)", "Data (3)" and so on:
+ *
+ * @code
+ *     lxw_rollover_options options = {.max_rows = 100000, .header_rows = 1};
+ *
+ *     worksheet_set_rollover(worksheet, &options);
+ *     worksheet_set_column(worksheet, 0, 0, 20, NULL);
+ *     worksheet_write_string(worksheet, 0, 0, "Name", bold);
+ *
+ *     // Rows 100000 and later are written to the continuation worksheets.
+ *     for (row = 1; row <= num_rows; row++)
+ *         worksheet_write_string(worksheet, row, 0, names[row], NULL);
+ * @endcode
+ *
+ * The row numbers passed to the write functions continue from the end of
+ * the worksheet. Each continuation worksheet starts with a copy of the
+ * `header_rows` of the worksheet, followed by the next `max_rows -
+ * header_rows` rows of data. The column settings from worksheet_set_column()
+ * and the header row data and settings are copied when each continuation
+ * worksheet is added, so they should be set before the first row past the
+ * limit is written.
+ *
+ * The rows are redirected by worksheet_write_number(),
+ * worksheet_write_string(), worksheet_write_formula() and the other formula
+ * functions that write a single cell, worksheet_write_boolean(),
+ * worksheet_write_blank(), worksheet_write_datetime(),
+ * worksheet_write_unixtime(), worksheet_write_url(),
+ * worksheet_write_rich_string(), worksheet_write_number_text() and
+ * worksheet_set_row(). Functions that apply to a range of cells, such as
+ * merged ranges or array formulas, and objects such as images or comments
+ * aren't redirected and return #LXW_ERROR_WORKSHEET_INDEX_OUT_OF_RANGE for
+ * rows past the `max_rows` limit of the first worksheet. Formulas in the
+ * header rows are copied as they are and aren't adjusted for the
+ * continuation worksheet.
+ *
+ * In `constant_memory` mode the header rows are kept in memory, as with
+ * worksheet_pin_rows(), and the function must be called before any data is
+ * written to the worksheet.
+ */
+lxw_error worksheet_set_rollover(lxw_worksheet *worksheet,
+                                 lxw_rollover_options *options);
+
+/**
+ * @brief Get the row to resume writing at after a workbook checkpoint.
+ *
+ * @param worksheet Pointer to a lxw_worksheet instance.
+ *
+ * @return The zero indexed row number of the next row to write.
+ *
+ * In `constant_memory` mode with a checkpoint directory set, see
+ * workbook_set_checkpoint_dir(), this function returns the first row that
+ * can still be written to the worksheet. After workbook_resume() it is the
+ * row after the last row saved by workbook_checkpoint():
+ *
+ * @code
+ *     workbook_resume(workbook);
+ *
+ *     for (row = worksheet_get_resume_row(worksheet); row < num_rows; row++)
+ *         worksheet_write_number(worksheet, row, 0, data[row], NULL);
+ * @endcode
+ *
+ * It returns 0 for a worksheet that isn't in `constant_memory` mode.
+ */
+lxw_row_t worksheet_get_resume_row(lxw_worksheet *worksheet);
+
+/**
+ * @brief Track running statistics for the columns of a worksheet range.
+ *
+ * @param worksheet Pointer to a lxw_worksheet instance to be updated.
+ * @param first_row The first row of the range. (All zero indexed.)
+ * @param first_col The first column of the range.
+ * @param last_row  The last row of the range.
+ * @param last_col  The last col of the range.
+ *
+ * @return A #lxw_error code.
+ *
+ * The `%worksheet_track_column_stats()` function turns on per-column
+ * accumulators for a range of cells. The count, sum, minimum and maximum of
+ * the numbers and the number of distinct strings written to each column of
+ * the range are updated as the data is written and can be read with
+ * worksheet_get_column_stats().
+ *
+ * This is mainly useful in `constant_memory` mode, where the data can't be
+ * read back, to write a totals row or to set fixed chart axis bounds:
+ *
+ * @code
+ *     lxw_column_stats stats;
+ *
+ *     worksheet_track_column_stats(worksheet, 1, 0, 1000000, 3);
+ *
+ *     // Write the data.
+ *
+ *     worksheet_get_column_stats(worksheet, 2, &stats);
+ *     chart_axis_set_min(chart->y_axis, stats.min);
+ *     chart_axis_set_max(chart->y_axis, stats.max);
+ * @endcode
+ *
+ * The statistics are updated by worksheet_write_number(),
+ * worksheet_write_string(), worksheet_write_number_text(),
+ * worksheet_write_datetime(), worksheet_write_unixtime() and
+ * worksheet_accumulate_number(). They count the current value of each cell:
+ * when a cell is overwritten, or a number is added to it, the old value is
+ * removed from the count and sum and the new value is added. The minimum,
+ * maximum and distinct strings can't be unwound, so they can still include
+ * values that have since been overwritten. Calling the function again resets
+ * the statistics and values written before that aren't counted.
+ *
+ * Rows that are written past the rollover row set by worksheet_set_rollover()
+ * are counted in the statistics of the original worksheet, using the row
+ * numbers passed to it, so the range can extend past `LXW_ROW_MAX` once the
+ * rollover has been set. The statistics are saved by workbook_checkpoint()
+ * and restored by workbook_resume().
+ */
+lxw_error worksheet_track_column_stats(lxw_worksheet *worksheet,
+                                       lxw_row_t first_row,
+                                       lxw_col_t first_col,
+                                       lxw_row_t last_row,
+                                       lxw_col_t last_col);
+
+/**
+ * @brief Get the running statistics for a worksheet column.
+ *
+ * @param worksheet Pointer to a lxw_worksheet instance.
+ * @param col       The zero indexed column number.
+ * @param stats     Pointer to a lxw_column_stats struct to hold the result.
+ *
+ * @return A #lxw_error code.
+ *
+ * Get the statistics of a column in the range set with
+ * worksheet_track_column_stats(). See the example above.
+ */
+lxw_error worksheet_get_column_stats(lxw_worksheet *worksheet,
+                                     lxw_col_t col, lxw_column_stats *stats);
+
+/**
+ * @brief Read back the value of a cell written to a worksheet.
+ *
+ * @param worksheet Pointer to a lxw_worksheet instance.
+ * @param row       The zero indexed row number.
+ * @param col       The zero indexed column number.
+ * @param value     Pointer to a lxw_cell_value struct to hold the result.
+ *
+ * @return A #lxw_error code.
+ *
+ * The `%worksheet_get_cell()` function returns the type, value and format of
+ * data previously written to a cell. Cells without data have the type
+ * #LXW_CELL_VALUE_EMPTY:
+ *
+ * @code
+ *     lxw_cell_value value;
+ *
+ *     worksheet_write_number(worksheet, 0, 0, 123, NULL);
+ *     worksheet_get_cell(worksheet, 0, 0, &value);
+ *
+ *     // value.type == LXW_CELL_VALUE_NUMBER and value.number == 123.
+ * @endcode
+ *
+ * In `constant_memory` mode only the cells of the row currently held in
+ * memory can be read back. The same applies to worksheet segments.
+ */
+lxw_error worksheet_get_cell(lxw_worksheet *worksheet, lxw_row_t row,
+                             lxw_col_t col, lxw_cell_value *value);
+
+/**
+ * @brief Initialize an iterator over the cells in a worksheet range.
+ *
+ * @param iter      Pointer to a lxw_cell_iter struct to initialize.
+ * @param worksheet Pointer to a lxw_worksheet instance.
+ * @param first_row The first row of the range. (All zero indexed.)
+ * @param first_col The first column of the range.
+ * @param last_row  The last row of the range.
+ * @param last_col  The last column of the range.
+ *
+ * @return A #lxw_error code.
+ *
+ * The `%worksheet_cell_iter_init()` function sets up an iterator that is
+ * used with `worksheet_cell_iter_next()` to read back the cells written to
+ * a range of the worksheet in row-major order:
+ *
+ * @code
+ *     lxw_cell_iter iter;
+ *     lxw_cell_value value;
+ *     double total = 0;
+ *
+ *     worksheet_cell_iter_init(&iter, worksheet, 1, 2, 1000, 2);
+ *
+ *     while (worksheet_cell_iter_next(&iter, &value)) {
+ *         if (value.type == LXW_CELL_VALUE_NUMBER)
+ *             total += value.number;
+ *     }
+ * @endcode
+ *
+ * Only cells that contain data are returned. The iterator walks the cell
+ * storage in order so it is faster than calling `worksheet_get_cell()` for
+ * each cell in a range. The worksheet shouldn't be written to while it is
+ * being iterated.
+ */
+lxw_error worksheet_cell_iter_init(lxw_cell_iter *iter,
+                                   lxw_worksheet *worksheet,
+                                   lxw_row_t first_row, lxw_col_t first_col,
+                                   lxw_row_t last_row, lxw_col_t last_col);
+
+/**
+ * @brief Get the next cell from a worksheet cell iterator.
+ *
+ * @param iter  Pointer to a lxw_cell_iter initialized with
+ *              worksheet_cell_iter_init().
+ * @param value Pointer to a lxw_cell_value struct to hold the result.
+ *
+ * @return LXW_TRUE if a cell was returned, LXW_FALSE at the end of the range.
+ *
+ * See `worksheet_cell_iter_init()` for an example.
+ */
+uint8_t worksheet_cell_iter_next(lxw_cell_iter *iter, lxw_cell_value *value);
+
+/**
+ * @brief Write data to a worksheet from a buffer of binary commands.
+ *
+ * @param worksheet    Pointer to a lxw_worksheet instance to be updated.
+ * @param buffer       The command buffer.
+ * @param length       The length of the command buffer in bytes.
+ * @param error_offset Optional pointer to return the offset in the buffer of
+ *                     the command that failed. May be NULL.
+ *
+ * @return A #lxw_error code.
+ *
+ * The `%worksheet_execute_batch()` function applies a buffer of commands
+ * to a worksheet. It is intended for language bindings where the cost of
+ * calling a C function for each cell is higher than the cost of writing the
+ * cell. The binding encodes the cells into a buffer and passes all of them
+ * to the library in one call.
+ *
+ * Each command is a 1 byte opcode followed by its arguments. The opcodes and
+ * their layouts are given by #lxw_batch_opcodes. The format set with
+ * `LXW_BATCH_SET_FORMAT` is used by all the following commands in the
+ * buffer. A format id of `n` refers to the nth format created with
+ * `workbook_add_format()`. The default formats of the workbook don't have
+ * ids. Formats that are added between batches get the next ids.
+ *
+ * The buffer is checked before any commands are applied. If it contains an
+ * unknown opcode, a truncated command or an invalid format id then nothing
+ * is written and the function returns `LXW_ERROR_PARAMETER_VALIDATION`.
+ * Otherwise the commands are applied in order until one of them fails, in
+ * which case the error from the failed write is returned and the commands
+ * before it remain applied. In both cases the offset of the failing command
+ * is returned in `error_offset`.
+ */
+lxw_error worksheet_execute_batch(lxw_worksheet *worksheet,
+                                  const uint8_t *buffer, size_t length,
+                                  size_t *error_offset);
+
 lxw_worksheet *lxw_worksheet_new(lxw_worksheet_init_data *init_data);
 void lxw_worksheet_free(lxw_worksheet *worksheet);
+void lxw_worksheet_free_cells(lxw_worksheet *worksheet);
 void lxw_worksheet_assemble_xml_file(lxw_worksheet *worksheet);
 void lxw_worksheet_write_single_row(lxw_worksheet *worksheet);
 
@@ -5939,8 +7039,30 @@ void lxw_worksheet_prepare_header_vml_objects(lxw_worksheet *worksheet,
 void lxw_worksheet_prepare_tables(lxw_worksheet *worksheet,
                                   uint32_t table_id);
 
+void lxw_worksheet_prepare_pivot_tables(lxw_worksheet *worksheet,
+                                        uint32_t pivot_id);
+void lxw_worksheet_prepare_filtered_rows(lxw_worksheet *worksheet);
+void lxw_worksheet_bake_conditional_formats(lxw_worksheet *worksheet);
+
 lxw_row *lxw_worksheet_find_row(lxw_worksheet *worksheet, lxw_row_t row_num);
 lxw_cell *lxw_worksheet_find_cell_in_row(lxw_row *row, lxw_col_t col_num);
+lxw_table_column *lxw_worksheet_find_table_formula(lxw_worksheet *worksheet,
+                                                   lxw_row_t row_num,
+                                                   lxw_col_t col_num);
+
+struct lxw_url_table *lxw_url_table_new(void);
+void lxw_url_table_free(struct lxw_url_table *url_table);
+struct lxw_validation_lists *lxw_validation_lists_new(void);
+void lxw_validation_lists_free(struct lxw_validation_lists *lists);
+void lxw_worksheet_close_segments(lxw_worksheet *worksheet);
+lxw_error lxw_worksheet_set_checkpoint_file(lxw_worksheet *worksheet,
+                                           const char *filename);
+lxw_error lxw_worksheet_flush_checkpoint(lxw_worksheet *worksheet);
+lxw_error lxw_worksheet_write_checkpoint(lxw_worksheet *worksheet,
+                                         FILE *file);
+lxw_error lxw_worksheet_read_checkpoint(lxw_worksheet *worksheet,
+                                        FILE *file);
+
 /*
  * External functions to call intern XML functions shared with chartsheet.
  */
@@ -5967,6 +7089,7 @@ STATIC void _worksheet_write_sheet_view(lxw_worksheet *worksheet);
 STATIC void _worksheet_write_sheet_views(lxw_worksheet *worksheet);
 STATIC void _worksheet_write_sheet_format_pr(lxw_worksheet *worksheet);
 STATIC void _worksheet_write_sheet_data(lxw_worksheet *worksheet);
+STATIC void _worksheet_write_optimized_sheet_data(lxw_worksheet *worksheet);
 STATIC void _worksheet_write_page_margins(lxw_worksheet *worksheet);
 STATIC void _worksheet_write_page_setup(lxw_worksheet *worksheet);
 STATIC void _worksheet_write_col_info(lxw_worksheet *worksheet,
@@ -5994,6 +7117,16 @@ STATIC double _pixels_to_height(double pixels);
 STATIC double _pixels_to_width(double pixels);
 
 STATIC void _worksheet_write_auto_filter(lxw_worksheet *worksheet);
+STATIC void _worksheet_write_hyperlinks(lxw_worksheet *worksheet);
+STATIC char *_normalize_number_text(const char *digits, size_t length);
+STATIC uint8_t _filter_match_string(const char *str, const char *pattern);
+STATIC uint8_t _filter_match_criteria(lxw_cell_value *value, uint8_t criteria,
+                                      const char *criteria_string,
+                                      double criteria_number);
+STATIC uint8_t _filter_match_rule(lxw_filter_rule_obj *rule,
+                                  lxw_cell_value *value);
+STATIC uint8_t _cond_format_match(lxw_cond_format_obj *cond_format,
+                                  lxw_cell_value *value);
 #endif /* TESTING */
 
 /* *INDENT-OFF* */
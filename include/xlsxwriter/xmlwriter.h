@@ -170,6 +170,16 @@ void lxw_xml_data_element(FILE *xmlfile,
 
 void lxw_xml_rich_si_element(FILE *xmlfile, const char *string);
 
+/**
+ * Write a single escaped attribute, with a leading space, in an open tag.
+ *
+ * @param xmlfile    A FILE pointer to the output XML file.
+ * @param key        The attribute name.
+ * @param value      The attribute value, which is escaped but not truncated.
+ */
+void lxw_xml_escaped_attribute(FILE *xmlfile, const char *key,
+                               const char *value);
+
 uint8_t lxw_has_control_characters(const char *string);
 char *lxw_escape_control_characters(const char *string);
 char *lxw_escape_url_characters(const char *string, uint8_t escape_hash);
@@ -1288,7 +1288,7 @@ _chart_write_a_body_pr(lxw_chart *self, int32_t rotation,
  * Write the <c:ptCount> element.
  */
 STATIC void
-_chart_write_pt_count(lxw_chart *self, uint16_t num_data_points)
+_chart_write_pt_count(lxw_chart *self, uint32_t num_data_points)
 {
     struct xml_attribute_list attributes;
     struct xml_attribute *attribute;
@@ -1302,14 +1302,19 @@ _chart_write_pt_count(lxw_chart *self, uint16_t num_data_points)
 }
 
 /*
- * Write the <c:v> element.
+ * Write the <c:v> element. Points read from a worksheet column with its own
+ * precision use that, like the cell, instead of the workbook precision.
  */
 STATIC void
-_chart_write_v_num(lxw_chart *self, double number)
+_chart_write_v_num(lxw_chart *self, lxw_series_data_point *data_point)
 {
     char data[LXW_ATTR_32];
+    lxw_number_precision *precision = self->number_precision;
+
+    if (data_point->precision.type)
+        precision = &data_point->precision;
 
-    lxw_sprintf_dbl(data, number);
+    lxw_sprintf_dbl(data, lxw_round_dbl(data_point->number, precision));
 
     lxw_xml_data_element(self->file, "c:v", data, NULL);
 }
@@ -1336,7 +1341,7 @@ _chart_write_f(lxw_chart *self, char *formula)
  * Write the <c:pt> element.
  */
 STATIC void
-_chart_write_pt(lxw_chart *self, uint16_t index,
+_chart_write_pt(lxw_chart *self, uint32_t index,
                 lxw_series_data_point *data_point)
 {
     struct xml_attribute_list attributes;
@@ -1354,7 +1359,7 @@ _chart_write_pt(lxw_chart *self, uint16_t index,
     if (data_point->is_string && data_point->string)
         _chart_write_v_str(self, data_point->string);
     else
-        _chart_write_v_num(self, data_point->number);
+        _chart_write_v_num(self, data_point);
 
     lxw_xml_end_tag(self->file, "c:pt");
 
@@ -1365,7 +1370,7 @@ _chart_write_pt(lxw_chart *self, uint16_t index,
  * Write the <c:pt> element.
  */
 STATIC void
-_chart_write_num_pt(lxw_chart *self, uint16_t index,
+_chart_write_num_pt(lxw_chart *self, uint32_t index,
                     lxw_series_data_point *data_point)
 {
     struct xml_attribute_list attributes;
@@ -1380,7 +1385,7 @@ _chart_write_num_pt(lxw_chart *self, uint16_t index,
 
     lxw_xml_start_tag(self->file, "c:pt", &attributes);
 
-    _chart_write_v_num(self, data_point->number);
+    _chart_write_v_num(self, data_point);
 
     lxw_xml_end_tag(self->file, "c:pt");
 
@@ -1403,7 +1408,7 @@ STATIC void
 _chart_write_num_cache(lxw_chart *self, lxw_series_range *range)
 {
     lxw_series_data_point *data_point;
-    uint16_t index = 0;
+    uint32_t index = 0;
 
     lxw_xml_start_tag(self->file, "c:numCache", NULL);
 
@@ -1429,7 +1434,7 @@ STATIC void
 _chart_write_str_cache(lxw_chart *self, lxw_series_range *range)
 {
     lxw_series_data_point *data_point;
-    uint16_t index = 0;
+    uint32_t index = 0;
 
     lxw_xml_start_tag(self->file, "c:strCache", NULL);
 
@@ -5668,6 +5673,32 @@ chart_series_set_smooth(lxw_chart_series *series, uint8_t smooth)
     series->smooth = smooth;
 }
 
+/*
+ * Set the downsample method and point limit for a large line or scatter
+ * series.
+ */
+lxw_error
+chart_series_set_downsample(lxw_chart_series *series, uint8_t method,
+                            uint32_t max_points)
+{
+    if (method > LXW_CHART_DOWNSAMPLE_MIN_MAX) {
+        LXW_WARN_FORMAT1("chart_series_set_downsample(): "
+                         "unknown downsample method '%d'.", method);
+        return LXW_ERROR_PARAMETER_VALIDATION;
+    }
+
+    if (method != LXW_CHART_DOWNSAMPLE_NONE && max_points < 3) {
+        LXW_WARN_FORMAT1("chart_series_set_downsample(): "
+                         "max_points '%u' must be at least 3.", max_points);
+        return LXW_ERROR_PARAMETER_VALIDATION;
+    }
+
+    series->downsample = method;
+    series->downsample_points = max_points;
+
+    return LXW_NO_ERROR;
+}
+
 /*
  * Turn on default data labels for a series.
  */
@@ -285,6 +285,25 @@ mem_error:
     }
 }
 
+/*
+ * Remove an element from the ContentTypes overrides.
+ */
+void
+lxw_ct_remove_override(lxw_content_types *self, const char *key)
+{
+    lxw_tuple *tuple;
+
+    STAILQ_FOREACH(tuple, self->overrides, list_pointers) {
+        if (strcmp(tuple->key, key) == 0) {
+            STAILQ_REMOVE(self->overrides, tuple, lxw_tuple, list_pointers);
+            free(tuple->key);
+            free(tuple->value);
+            free(tuple);
+            return;
+        }
+    }
+}
+
 /*
  * Add the name of a worksheet to the ContentTypes overrides.
  */
@@ -333,6 +352,38 @@ lxw_ct_add_table_name(lxw_content_types *self, const char *name)
                         LXW_APP_DOCUMENT "spreadsheetml.table+xml");
 }
 
+/*
+ * Add the name of a pivot table to the ContentTypes overrides.
+ */
+void
+lxw_ct_add_pivot_table_name(lxw_content_types *self, const char *name)
+{
+    lxw_ct_add_override(self, name,
+                        LXW_APP_DOCUMENT "spreadsheetml.pivotTable+xml");
+}
+
+/*
+ * Add the name of a pivot cache definition to the ContentTypes overrides.
+ */
+void
+lxw_ct_add_pivot_cache_name(lxw_content_types *self, const char *name)
+{
+    lxw_ct_add_override(self, name,
+                        LXW_APP_DOCUMENT
+                        "spreadsheetml.pivotCacheDefinition+xml");
+}
+
+/*
+ * Add the name of a pivot cache records file to the ContentTypes overrides.
+ */
+void
+lxw_ct_add_pivot_records_name(lxw_content_types *self, const char *name)
+{
+    lxw_ct_add_override(self, name,
+                        LXW_APP_DOCUMENT
+                        "spreadsheetml.pivotCacheRecords+xml");
+}
+
 /*
  * Add the name of a VML drawing to the ContentTypes overrides.
  */
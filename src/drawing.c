@@ -923,6 +923,123 @@ _drawing_write_absolute_anchor(lxw_drawing *self, uint32_t frame_index)
     lxw_xml_end_tag(self->file, "xdr:absoluteAnchor");
 }
 
+/*
+ * The twoCellAnchor elements for pictures and charts are almost constant
+ * apart from the coordinates, ids and names. The following templates are
+ * used to write them with a few formatted writes instead of building and
+ * escaping an attribute list for each element.
+ */
+#define LXW_DRAWING_COORDS_TEMPLATE                        \
+    "<xdr:col>%u</xdr:col><xdr:colOff>%u</xdr:colOff>"     \
+    "<xdr:row>%u</xdr:row><xdr:rowOff>%u</xdr:rowOff>"
+
+#define LXW_DRAWING_ANCHOR_TEMPLATE                        \
+    "<xdr:twoCellAnchor%s>"                                \
+    "<xdr:from>" LXW_DRAWING_COORDS_TEMPLATE "</xdr:from>" \
+    "<xdr:to>" LXW_DRAWING_COORDS_TEMPLATE "</xdr:to>"
+
+#define LXW_DRAWING_PIC_START_TEMPLATE                     \
+    "<xdr:pic><xdr:nvPicPr><xdr:cNvPr id=\"%d\" name=\"Picture %d\""
+
+#define LXW_DRAWING_PIC_END_TEMPLATE                                   \
+    "/><xdr:cNvPicPr><a:picLocks noChangeAspect=\"1\"/></xdr:cNvPicPr>" \
+    "</xdr:nvPicPr><xdr:blipFill>"                                     \
+    "<a:blip xmlns:r=\"" LXW_SCHEMA_OFFICEDOC "/relationships\" "      \
+    "r:embed=\"rId%u\"/><a:stretch><a:fillRect/></a:stretch>"          \
+    "</xdr:blipFill><xdr:spPr><a:xfrm>"                                \
+    "<a:off x=\"%s\" y=\"%s\"/><a:ext cx=\"%d\" cy=\"%d\"/></a:xfrm>"  \
+    "<a:prstGeom prst=\"rect\"><a:avLst/></a:prstGeom></xdr:spPr>"     \
+    "</xdr:pic>"
+
+#define LXW_DRAWING_FRAME_START_TEMPLATE                   \
+    "<xdr:graphicFrame macro=\"\"><xdr:nvGraphicFramePr>"  \
+    "<xdr:cNvPr id=\"%d\" name=\"Chart %d\""
+
+#define LXW_DRAWING_FRAME_END_TEMPLATE                                 \
+    "/><xdr:cNvGraphicFramePr/></xdr:nvGraphicFramePr>"                \
+    "<xdr:xfrm><a:off x=\"0\" y=\"0\"/><a:ext cx=\"0\" cy=\"0\"/>"     \
+    "</xdr:xfrm><a:graphic>"                                           \
+    "<a:graphicData uri=\"" LXW_SCHEMA_DRAWING "/chart\">"             \
+    "<c:chart xmlns:c=\"" LXW_SCHEMA_DRAWING "/chart\" "               \
+    "xmlns:r=\"" LXW_SCHEMA_OFFICEDOC "/relationships\" "              \
+    "r:id=\"rId%u\"/></a:graphicData></a:graphic></xdr:graphicFrame>"
+
+/*
+ * Check if a drawing object can be written with the anchor templates. Objects
+ * with hyperlinks, decorative flags or overlong descriptions use the element
+ * writers above.
+ */
+STATIC uint8_t
+_drawing_has_anchor_template(lxw_drawing_object *drawing_object)
+{
+    if (drawing_object->type != LXW_DRAWING_IMAGE
+        && drawing_object->type != LXW_DRAWING_CHART)
+        return LXW_FALSE;
+
+    if (drawing_object->url_rel_index || drawing_object->decorative)
+        return LXW_FALSE;
+
+    if (drawing_object->description
+        && strlen(drawing_object->description) >= LXW_MAX_ATTRIBUTE_LENGTH)
+        return LXW_FALSE;
+
+    return LXW_TRUE;
+}
+
+/*
+ * Write the <xdr:twoCellAnchor> element for a picture or chart using the
+ * anchor templates.
+ */
+STATIC void
+_drawing_write_two_cell_anchor_template(lxw_drawing *self, uint32_t index,
+                                        lxw_drawing_object *drawing_object)
+{
+    lxw_drawing_coords *from = &drawing_object->from;
+    lxw_drawing_coords *to = &drawing_object->to;
+    char *description = drawing_object->description;
+    char *edit_as = "";
+    char x[LXW_ATTR_32];
+    char y[LXW_ATTR_32];
+
+    if (drawing_object->anchor == LXW_OBJECT_MOVE_DONT_SIZE)
+        edit_as = " editAs=\"oneCell\"";
+    else if (drawing_object->anchor == LXW_OBJECT_DONT_MOVE_DONT_SIZE)
+        edit_as = " editAs=\"absolute\"";
+
+    fprintf(self->file, LXW_DRAWING_ANCHOR_TEMPLATE, edit_as,
+            from->col, (uint32_t) from->col_offset,
+            from->row, (uint32_t) from->row_offset,
+            to->col, (uint32_t) to->col_offset,
+            to->row, (uint32_t) to->row_offset);
+
+    if (drawing_object->type == LXW_DRAWING_IMAGE)
+        fprintf(self->file, LXW_DRAWING_PIC_START_TEMPLATE,
+                (int32_t) index + 1, (int32_t) index);
+    else
+        fprintf(self->file, LXW_DRAWING_FRAME_START_TEMPLATE,
+                (int32_t) index + 1, (int32_t) index);
+
+    if (description && *description)
+        lxw_xml_escaped_attribute(self->file, "descr", description);
+
+    if (drawing_object->type == LXW_DRAWING_IMAGE) {
+        /* Use %.16G for the offsets, as in _drawing_write_a_off(). */
+        lxw_sprintf_dbl(x, (double) drawing_object->col_absolute);
+        lxw_sprintf_dbl(y, (double) drawing_object->row_absolute);
+
+        fprintf(self->file, LXW_DRAWING_PIC_END_TEMPLATE,
+                drawing_object->rel_index, x, y,
+                (int32_t) drawing_object->width,
+                (int32_t) drawing_object->height);
+    }
+    else {
+        fprintf(self->file, LXW_DRAWING_FRAME_END_TEMPLATE,
+                drawing_object->rel_index);
+    }
+
+    fputs("<xdr:clientData/></xdr:twoCellAnchor>", self->file);
+}
+
 /*****************************************************************************
  *
  * XML file assembly functions.
@@ -948,7 +1065,11 @@ lxw_drawing_assemble_xml_file(lxw_drawing *self)
         index = 1;
 
         STAILQ_FOREACH(drawing_object, self->drawing_objects, list_pointers) {
-            _drawing_write_two_cell_anchor(self, index, drawing_object);
+            if (_drawing_has_anchor_template(drawing_object))
+                _drawing_write_two_cell_anchor_template(self, index,
+                                                        drawing_object);
+            else
+                _drawing_write_two_cell_anchor(self, index, drawing_object);
             index++;
         }
     }
@@ -0,0 +1,307 @@
+/*****************************************************************************
+ * image_cache - A process wide cache for image properties and data.
+ *
+ * Used in conjunction with the libxlsxwriter library.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ * Copyright 2014-2025, John McNamara, jmcnamara@cpan.org.
+ *
+ */
+
+/* Request POSIX.1-2008 for the nanosecond file times in struct stat. */
+#if !defined(_WIN32) && !defined(__APPLE__)
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include "xlsxwriter/image_cache.h"
+#include "xlsxwriter/utility.h"
+
+STATIC int _image_cache_cmp(lxw_image_cache_entry *entry1,
+                            lxw_image_cache_entry *entry2);
+
+#ifndef __clang_analyzer__
+LXW_RB_GENERATE_IMAGE_CACHE(lxw_image_cache_entries, lxw_image_cache_entry,
+                            tree_pointers, _image_cache_cmp);
+#endif
+
+/* The cached image files, keyed by filename, and image data, keyed by MD5. */
+static struct lxw_image_cache_entries *image_cache_files = NULL;
+static struct lxw_image_cache_entries *image_cache_data = NULL;
+
+/*****************************************************************************
+ *
+ * Private functions.
+ *
+ ****************************************************************************/
+
+/*
+ * Comparator for the image cache trees.
+ */
+STATIC int
+_image_cache_cmp(lxw_image_cache_entry *entry1, lxw_image_cache_entry *entry2)
+{
+    return strcmp(entry1->key, entry2->key);
+}
+
+/*
+ * Get the size and modification time of a file. The time is in nanoseconds,
+ * where the platform supports it, so that a file that is rewritten within
+ * the same second isn't served from the cache.
+ */
+STATIC lxw_error
+_get_file_info(const char *filename, uint64_t *size, int64_t *mtime)
+{
+    int64_t nsec;
+
+#ifdef _MSC_VER
+    struct _stat64 info;
+
+    if (_stat64(filename, &info) != 0)
+        return LXW_ERROR_PARAMETER_VALIDATION;
+#else
+    struct stat info;
+
+    if (stat(filename, &info) != 0)
+        return LXW_ERROR_PARAMETER_VALIDATION;
+#endif
+
+#if defined(_WIN32)
+    nsec = 0;
+#elif defined(__APPLE__)
+    nsec = (int64_t) info.st_mtimespec.tv_nsec;
+#else
+    nsec = (int64_t) info.st_mtim.tv_nsec;
+#endif
+
+    *size = (uint64_t) info.st_size;
+    *mtime = (int64_t) info.st_mtime * 1000000000 + nsec;
+
+    return LXW_NO_ERROR;
+}
+
+/*
+ * Free the properties and data stored in a cache entry, but not its key.
+ */
+STATIC void
+_free_entry_data(lxw_image_cache_entry *entry)
+{
+    free(entry->extension);
+    free(entry->md5);
+    free(entry->zip_data);
+
+    entry->extension = NULL;
+    entry->md5 = NULL;
+    entry->zip_data = NULL;
+    entry->zip_data_size = 0;
+}
+
+/*
+ * Free a cache entry.
+ */
+STATIC void
+_free_entry(lxw_image_cache_entry *entry)
+{
+    _free_entry_data(entry);
+    free(entry->key);
+    free(entry);
+}
+
+/*
+ * Free a cache tree and its entries.
+ */
+STATIC void
+_free_entries(struct lxw_image_cache_entries *entries)
+{
+    lxw_image_cache_entry *entry;
+    lxw_image_cache_entry *next_entry;
+
+    if (!entries)
+        return;
+
+    for (entry = RB_MIN(lxw_image_cache_entries, entries); entry;
+         entry = next_entry) {
+
+        next_entry = RB_NEXT(lxw_image_cache_entries, entries, entry);
+        RB_REMOVE(lxw_image_cache_entries, entries, entry);
+        _free_entry(entry);
+    }
+
+    free(entries);
+}
+
+/*
+ * Find an entry in a cache tree.
+ */
+STATIC lxw_image_cache_entry *
+_find_entry(struct lxw_image_cache_entries *entries, const char *key)
+{
+    lxw_image_cache_entry tmp_entry;
+
+    if (!entries || !key)
+        return NULL;
+
+    tmp_entry.key = (char *) key;
+
+    return RB_FIND(lxw_image_cache_entries, entries, &tmp_entry);
+}
+
+/*
+ * Find or add an entry in a cache tree. Any data stored in an existing entry
+ * is freed so that it can be replaced.
+ */
+STATIC lxw_image_cache_entry *
+_add_entry(struct lxw_image_cache_entries *entries, const char *key)
+{
+    lxw_image_cache_entry *entry;
+
+    if (!entries || !key)
+        return NULL;
+
+    entry = _find_entry(entries, key);
+
+    if (entry) {
+        _free_entry_data(entry);
+        return entry;
+    }
+
+    entry = calloc(1, sizeof(lxw_image_cache_entry));
+    RETURN_ON_MEM_ERROR(entry, NULL);
+
+    entry->key = lxw_strdup(key);
+    if (!entry->key) {
+        free(entry);
+        LXW_MEM_ERROR();
+        return NULL;
+    }
+
+    RB_INSERT(lxw_image_cache_entries, entries, entry);
+
+    return entry;
+}
+
+/*****************************************************************************
+ *
+ * Public functions.
+ *
+ ****************************************************************************/
+
+/*
+ * Turn on the image cache.
+ */
+void
+lxw_image_cache_enable(void)
+{
+    if (image_cache_files)
+        return;
+
+    image_cache_files = calloc(1, sizeof(struct lxw_image_cache_entries));
+    image_cache_data = calloc(1, sizeof(struct lxw_image_cache_entries));
+
+    if (!image_cache_files || !image_cache_data) {
+        LXW_MEM_ERROR();
+        lxw_image_cache_free();
+        return;
+    }
+
+    RB_INIT(image_cache_files);
+    RB_INIT(image_cache_data);
+}
+
+/*
+ * Turn off the image cache and free the cached images.
+ */
+void
+lxw_image_cache_free(void)
+{
+    _free_entries(image_cache_files);
+    _free_entries(image_cache_data);
+
+    image_cache_files = NULL;
+    image_cache_data = NULL;
+}
+
+/*
+ * Check if the image cache is turned on.
+ */
+uint8_t
+lxw_image_cache_is_enabled(void)
+{
+    return image_cache_files != NULL;
+}
+
+/*
+ * Get the cached properties of an image file if the file hasn't changed.
+ */
+lxw_image_cache_entry *
+lxw_image_cache_get_file(const char *filename)
+{
+    lxw_image_cache_entry *entry;
+    uint64_t size;
+    int64_t mtime;
+
+    entry = _find_entry(image_cache_files, filename);
+    if (!entry || !entry->extension)
+        return NULL;
+
+    if (_get_file_info(filename, &size, &mtime) != LXW_NO_ERROR)
+        return NULL;
+
+    if (size != entry->file_size || mtime != entry->file_mtime)
+        return NULL;
+
+    return entry;
+}
+
+/*
+ * Add an entry for an image file. The caller stores the image properties.
+ */
+lxw_image_cache_entry *
+lxw_image_cache_add_file(const char *filename)
+{
+    lxw_image_cache_entry *entry;
+    uint64_t size;
+    int64_t mtime;
+
+    if (!image_cache_files)
+        return NULL;
+
+    if (_get_file_info(filename, &size, &mtime) != LXW_NO_ERROR)
+        return NULL;
+
+    entry = _add_entry(image_cache_files, filename);
+    if (!entry)
+        return NULL;
+
+    entry->file_size = size;
+    entry->file_mtime = mtime;
+
+    return entry;
+}
+
+/*
+ * Get the cached compressed data for an image.
+ */
+lxw_image_cache_entry *
+lxw_image_cache_get_data(const char *md5)
+{
+    lxw_image_cache_entry *entry = _find_entry(image_cache_data, md5);
+
+    if (!entry || !entry->zip_data)
+        return NULL;
+
+    return entry;
+}
+
+/*
+ * Add an entry for the data of an image. The caller stores the data.
+ */
+lxw_image_cache_entry *
+lxw_image_cache_add_data(const char *md5)
+{
+    return _add_entry(image_cache_data, md5);
+}
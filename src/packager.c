@@ -49,6 +49,7 @@
 #include "xlsxwriter/packager.h"
 #include "xlsxwriter/hash_table.h"
 #include "xlsxwriter/utility.h"
+#include "xlsxwriter/image_cache.h"
 
 STATIC lxw_error _add_file_to_zip(lxw_packager *self, FILE *file,
                                   const char *filename);
@@ -56,6 +57,12 @@ STATIC lxw_error _add_file_to_zip(lxw_packager *self, FILE *file,
 STATIC lxw_error _add_buffer_to_zip(lxw_packager *self, const char *buffer,
                                     size_t buffer_size, const char *filename);
 
+STATIC lxw_error _open_zip_member(lxw_packager *self, const char *filename,
+                                  uint8_t raw);
+STATIC lxw_error _add_raw_data_to_zip(lxw_packager *self,
+                                      lxw_image_cache_entry *cache_entry,
+                                      const char *filename);
+STATIC lxw_error _write_zip_member(lxw_packager *self);
 STATIC lxw_error _add_to_zip(lxw_packager *self, FILE *file,
                              char **buffer, size_t *buffer_size,
                              const char *filename);
@@ -240,6 +247,11 @@ lxw_packager_free(lxw_packager *packager)
     if (!packager)
         return;
 
+    /* Close any part left open by an incomplete incremental close. */
+    if (packager->member_file)
+        fclose(packager->member_file);
+
+    free(packager->member_buffer);
     free((void *) packager->buffer);
     free((void *) packager->filename);
     free(packager);
@@ -277,44 +289,64 @@ _write_workbook_file(lxw_packager *self)
 }
 
 /*
- * Write the worksheet files.
+ * Write the worksheet files. The worksheet data is added to the zip file in
+ * chunks so that an incremental close can return once its budget is used.
  */
 STATIC lxw_error
 _write_worksheet_files(lxw_packager *self)
 {
     lxw_workbook *workbook = self->workbook;
-    lxw_sheet *sheet;
     lxw_worksheet *worksheet;
     char sheetname[LXW_FILENAME_LENGTH] = { 0 };
-    char *buffer = NULL;
-    size_t buffer_size = 0;
-    uint32_t index = 1;
     lxw_error err;
 
-    STAILQ_FOREACH(sheet, workbook->sheets, list_pointers) {
-        if (sheet->is_chartsheet)
+    if (!self->sheet_index) {
+        self->sheet = STAILQ_FIRST(workbook->sheets);
+        self->sheet_index = 1;
+    }
+
+    while (self->sheet) {
+        if (self->sheet->is_chartsheet) {
+            self->sheet = STAILQ_NEXT(self->sheet, list_pointers);
             continue;
-        else
-            worksheet = sheet->u.worksheet;
+        }
+        else {
+            worksheet = self->sheet->u.worksheet;
+        }
 
-        lxw_snprintf(sheetname, LXW_FILENAME_LENGTH,
-                     "xl/worksheets/sheet%d.xml", index++);
+        /* Assemble the worksheet xml and start the zip member for it. */
+        if (!self->member_file) {
+            lxw_snprintf(sheetname, LXW_FILENAME_LENGTH,
+                         "xl/worksheets/sheet%d.xml", self->sheet_index++);
 
-        if (worksheet->optimize_row)
-            lxw_worksheet_write_single_row(worksheet);
+            if (worksheet->optimize_row)
+                lxw_worksheet_write_single_row(worksheet);
 
-        worksheet->file = lxw_get_filehandle(&buffer, &buffer_size,
-                                             self->tmpdir);
-        if (!worksheet->file)
-            return LXW_ERROR_CREATING_TMPFILE;
+            worksheet->file = lxw_get_filehandle(&self->member_buffer,
+                                                 &self->member_buffer_size,
+                                                 self->tmpdir);
+            if (!worksheet->file)
+                return LXW_ERROR_CREATING_TMPFILE;
 
-        lxw_worksheet_assemble_xml_file(worksheet);
+            self->member_file = worksheet->file;
 
-        err = _add_to_zip(self, worksheet->file, &buffer, &buffer_size,
-                          sheetname);
-        fclose(worksheet->file);
-        free(buffer);
+            lxw_worksheet_assemble_xml_file(worksheet);
+
+            /* The cell data isn't needed once the xml has been written. */
+            lxw_worksheet_free_cells(worksheet);
+
+            err = _open_zip_member(self, sheetname, 0);
+            RETURN_ON_ERROR(err);
+        }
+
+        err = _write_zip_member(self);
         RETURN_ON_ERROR(err);
+
+        self->sheet = STAILQ_NEXT(self->sheet, list_pointers);
+
+        if (self->step_budget && self->step_size >= self->step_budget
+            && self->sheet)
+            return LXW_CLOSE_IN_PROGRESS;
     }
 
     return LXW_NO_ERROR;
@@ -362,7 +394,146 @@ _write_chartsheet_files(lxw_packager *self)
 }
 
 /*
- * Write the /xl/media/image?.xml files.
+ * Compress the data of an image and store it in the image cache.
+ */
+STATIC lxw_image_cache_entry *
+_cache_image_data(const char *md5, const char *data, size_t data_size)
+{
+    lxw_image_cache_entry *cache_entry;
+    z_stream stream;
+    char *zip_data;
+    uLong zip_data_size;
+    int error;
+
+    memset(&stream, 0, sizeof(stream));
+
+    error = deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED,
+                         -MAX_WBITS, DEF_MEM_LEVEL, Z_DEFAULT_STRATEGY);
+    if (error != Z_OK)
+        return NULL;
+
+    zip_data_size = deflateBound(&stream, (uLong) data_size);
+    zip_data = malloc(zip_data_size);
+    if (!zip_data) {
+        deflateEnd(&stream);
+        return NULL;
+    }
+
+    stream.next_in = (Bytef *) data;
+    stream.avail_in = (uInt) data_size;
+    stream.next_out = (Bytef *) zip_data;
+    stream.avail_out = (uInt) zip_data_size;
+
+    error = deflate(&stream, Z_FINISH);
+    deflateEnd(&stream);
+
+    if (error != Z_STREAM_END) {
+        free(zip_data);
+        return NULL;
+    }
+
+    cache_entry = lxw_image_cache_add_data(md5);
+    if (!cache_entry) {
+        free(zip_data);
+        return NULL;
+    }
+
+    cache_entry->zip_data = zip_data;
+    cache_entry->zip_data_size = stream.total_out;
+    cache_entry->data_size = data_size;
+    cache_entry->crc32 = (uint32_t) crc32(0L, (const Bytef *) data,
+                                          (uInt) data_size);
+
+    return cache_entry;
+}
+
+/*
+ * Get the compressed data of an image from the image cache, adding it to the
+ * cache if necessary. Returns NULL if the data can't be cached.
+ */
+STATIC lxw_image_cache_entry *
+_get_cached_image_data(lxw_object_properties *object_props)
+{
+    lxw_image_cache_entry *cache_entry;
+    FILE *image_stream;
+    char *data;
+    long data_size;
+
+    cache_entry = lxw_image_cache_get_data(object_props->md5);
+    if (cache_entry)
+        return cache_entry;
+
+    if (object_props->is_image_buffer)
+        return _cache_image_data(object_props->md5,
+                                 object_props->image_buffer,
+                                 object_props->image_buffer_size);
+
+    image_stream = lxw_fopen(object_props->filename, "rb");
+    if (!image_stream)
+        return NULL;
+
+    if (fseek(image_stream, 0, SEEK_END) != 0
+        || (data_size = ftell(image_stream)) <= 0) {
+        fclose(image_stream);
+        return NULL;
+    }
+
+    rewind(image_stream);
+
+    data = malloc(data_size);
+    if (data
+        && fread(data, 1, data_size, image_stream) == (size_t) data_size)
+        cache_entry = _cache_image_data(object_props->md5, data, data_size);
+
+    fclose(image_stream);
+    free(data);
+
+    return cache_entry;
+}
+
+/*
+ * Add an image file or buffer to the zip file.
+ */
+STATIC lxw_error
+_add_image_to_zip(lxw_packager *self, lxw_object_properties *object_props,
+                  const char *filename)
+{
+    lxw_image_cache_entry *cache_entry = NULL;
+    FILE *image_stream;
+    lxw_error err;
+
+    /* Use the compressed data from the image cache, if available. */
+    if (object_props->md5 && lxw_image_cache_is_enabled())
+        cache_entry = _get_cached_image_data(object_props);
+
+    if (cache_entry)
+        return _add_raw_data_to_zip(self, cache_entry, filename);
+
+    if (!object_props->is_image_buffer) {
+        /* Check that the image file exists and can be opened. */
+        image_stream = lxw_fopen(object_props->filename, "rb");
+        if (!image_stream) {
+            LXW_WARN_FORMAT1("Error adding image to xlsx file: file "
+                             "doesn't exist or can't be opened: %s.",
+                             object_props->filename);
+            return LXW_ERROR_CREATING_TMPFILE;
+        }
+
+        err = _add_file_to_zip(self, image_stream, filename);
+        fclose(image_stream);
+    }
+    else {
+        err = _add_buffer_to_zip(self,
+                                 object_props->image_buffer,
+                                 object_props->image_buffer_size, filename);
+    }
+
+    return err;
+}
+
+/*
+ * Write the /xl/media/image?.xml files. An incremental close can return
+ * between images once its budget is used.
  */
 STATIC lxw_error
 _write_image_files(lxw_packager *self)
@@ -372,7 +543,6 @@ _write_image_files(lxw_packager *self)
     lxw_worksheet *worksheet;
     lxw_object_properties *object_props;
     lxw_error err;
-    FILE *image_stream;
 
     char filename[LXW_FILENAME_LENGTH] = { 0 };
     uint32_t index = 1;
@@ -393,31 +563,23 @@ _write_image_files(lxw_packager *self)
             if (object_props->is_duplicate)
                 continue;
 
+            /* Skip the images written in a previous step. */
+            if (index <= self->image_index) {
+                index++;
+                continue;
+            }
+
             lxw_snprintf(filename, LXW_FILENAME_LENGTH,
                          "xl/media/image%d.%s", index++,
                          object_props->extension);
 
-            if (!object_props->is_image_buffer) {
-                /* Check that the image file exists and can be opened. */
-                image_stream = lxw_fopen(object_props->filename, "rb");
-                if (!image_stream) {
-                    LXW_WARN_FORMAT1("Error adding image to xlsx file: file "
-                                     "doesn't exist or can't be opened: %s.",
-                                     object_props->filename);
-                    return LXW_ERROR_CREATING_TMPFILE;
-                }
-
-                err = _add_file_to_zip(self, image_stream, filename);
-                fclose(image_stream);
-            }
-            else {
-                err = _add_buffer_to_zip(self,
-                                         object_props->image_buffer,
-                                         object_props->image_buffer_size,
-                                         filename);
-            }
-
+            err = _add_image_to_zip(self, object_props, filename);
             RETURN_ON_ERROR(err);
+
+            self->image_index++;
+
+            if (self->step_budget && self->step_size >= self->step_budget)
+                return LXW_CLOSE_IN_PROGRESS;
         }
 
         STAILQ_FOREACH(object_props, worksheet->image_props, list_pointers) {
@@ -425,31 +587,23 @@ _write_image_files(lxw_packager *self)
             if (object_props->is_duplicate)
                 continue;
 
+            /* Skip the images written in a previous step. */
+            if (index <= self->image_index) {
+                index++;
+                continue;
+            }
+
             lxw_snprintf(filename, LXW_FILENAME_LENGTH,
                          "xl/media/image%d.%s", index++,
                          object_props->extension);
 
-            if (!object_props->is_image_buffer) {
-                /* Check that the image file exists and can be opened. */
-                image_stream = lxw_fopen(object_props->filename, "rb");
-                if (!image_stream) {
-                    LXW_WARN_FORMAT1("Error adding image to xlsx file: file "
-                                     "doesn't exist or can't be opened: %s.",
-                                     object_props->filename);
-                    return LXW_ERROR_CREATING_TMPFILE;
-                }
-
-                err = _add_file_to_zip(self, image_stream, filename);
-                fclose(image_stream);
-            }
-            else {
-                err = _add_buffer_to_zip(self,
-                                         object_props->image_buffer,
-                                         object_props->image_buffer_size,
-                                         filename);
-            }
-
+            err = _add_image_to_zip(self, object_props, filename);
             RETURN_ON_ERROR(err);
+
+            self->image_index++;
+
+            if (self->step_budget && self->step_size >= self->step_budget)
+                return LXW_CLOSE_IN_PROGRESS;
         }
     }
 
@@ -723,6 +877,158 @@ _get_table_count(lxw_packager *self)
     return table_count;
 }
 
+/*
+ * Write a .rels file with a single relationship for a pivot table part.
+ */
+STATIC lxw_error
+_write_pivot_rels_file(lxw_packager *self, const char *filename,
+                       const char *type, const char *target)
+{
+    lxw_relationships *rels;
+    char *buffer = NULL;
+    size_t buffer_size = 0;
+    lxw_error err;
+
+    rels = lxw_relationships_new();
+    RETURN_ON_MEM_ERROR(rels, LXW_ERROR_MEMORY_MALLOC_FAILED);
+
+    rels->file = lxw_get_filehandle(&buffer, &buffer_size, self->tmpdir);
+    if (!rels->file) {
+        lxw_free_relationships(rels);
+        return LXW_ERROR_CREATING_TMPFILE;
+    }
+
+    lxw_add_document_relationship(rels, type, target);
+    lxw_relationships_assemble_xml_file(rels);
+
+    err = _add_to_zip(self, rels->file, &buffer, &buffer_size, filename);
+
+    fclose(rels->file);
+    free(buffer);
+    lxw_free_relationships(rels);
+
+    return err;
+}
+
+/*
+ * Write one of the xml files of a pivot table.
+ */
+STATIC lxw_error
+_write_pivot_part_file(lxw_packager *self, lxw_pivot_table *pivot_table,
+                       void (*assemble_xml_file) (lxw_pivot_table *),
+                       const char *filename)
+{
+    char *buffer = NULL;
+    size_t buffer_size = 0;
+    lxw_error err;
+
+    pivot_table->file = lxw_get_filehandle(&buffer, &buffer_size,
+                                           self->tmpdir);
+    if (!pivot_table->file)
+        return LXW_ERROR_CREATING_TMPFILE;
+
+    assemble_xml_file(pivot_table);
+
+    err = _add_to_zip(self, pivot_table->file, &buffer, &buffer_size,
+                      filename);
+
+    fclose(pivot_table->file);
+    free(buffer);
+    pivot_table->file = NULL;
+
+    return err;
+}
+
+/*
+ * Write the pivot table, pivot cache definition and pivot cache records
+ * files, and their .rels files. The records are streamed from the source
+ * worksheet so this must run before the worksheet cells are freed.
+ */
+STATIC lxw_error
+_write_pivot_table_files(lxw_packager *self)
+{
+    lxw_workbook *workbook = self->workbook;
+    lxw_sheet *sheet;
+    lxw_worksheet *worksheet;
+    lxw_pivot_table *pivot_table;
+    lxw_pivot_table_obj *pivot_obj;
+    lxw_error err;
+
+    char filename[LXW_FILENAME_LENGTH] = { 0 };
+    char target[LXW_FILENAME_LENGTH] = { 0 };
+    uint32_t index;
+
+    STAILQ_FOREACH(sheet, workbook->sheets, list_pointers) {
+        if (sheet->is_chartsheet)
+            continue;
+        else
+            worksheet = sheet->u.worksheet;
+
+        STAILQ_FOREACH(pivot_obj, worksheet->pivot_table_objs, list_pointers) {
+
+            index = pivot_obj->id;
+
+            pivot_table = lxw_pivot_table_new(pivot_obj);
+            RETURN_ON_MEM_ERROR(pivot_table, LXW_ERROR_MEMORY_MALLOC_FAILED);
+
+            err = lxw_pivot_table_build_cache(pivot_table);
+            if (err)
+                goto error;
+
+            lxw_snprintf(filename, LXW_FILENAME_LENGTH,
+                         "xl/pivotCache/pivotCacheDefinition%d.xml", index);
+            err = _write_pivot_part_file(self, pivot_table,
+                                         lxw_pivot_cache_assemble_xml_file,
+                                         filename);
+            if (err)
+                goto error;
+
+            lxw_snprintf(filename, LXW_FILENAME_LENGTH,
+                         "xl/pivotCache/_rels/pivotCacheDefinition%d.xml.rels",
+                         index);
+            lxw_snprintf(target, LXW_FILENAME_LENGTH,
+                         "pivotCacheRecords%d.xml", index);
+            err = _write_pivot_rels_file(self, filename,
+                                         "/pivotCacheRecords", target);
+            if (err)
+                goto error;
+
+            lxw_snprintf(filename, LXW_FILENAME_LENGTH,
+                         "xl/pivotCache/pivotCacheRecords%d.xml", index);
+            err = _write_pivot_part_file(self, pivot_table,
+                                         lxw_pivot_records_assemble_xml_file,
+                                         filename);
+            if (err)
+                goto error;
+
+            lxw_snprintf(filename, LXW_FILENAME_LENGTH,
+                         "xl/pivotTables/pivotTable%d.xml", index);
+            err = _write_pivot_part_file(self, pivot_table,
+                                         lxw_pivot_table_assemble_xml_file,
+                                         filename);
+            if (err)
+                goto error;
+
+            lxw_snprintf(filename, LXW_FILENAME_LENGTH,
+                         "xl/pivotTables/_rels/pivotTable%d.xml.rels", index);
+            lxw_snprintf(target, LXW_FILENAME_LENGTH,
+                         "../pivotCache/pivotCacheDefinition%d.xml", index);
+            err = _write_pivot_rels_file(self, filename,
+                                         "/pivotCacheDefinition", target);
+            if (err)
+                goto error;
+
+            lxw_pivot_table_free(pivot_table);
+        }
+    }
+
+    return LXW_NO_ERROR;
+
+error:
+    lxw_pivot_table_free(pivot_table);
+    return err;
+}
+
 /*
  * Write the comment/header VML files.
  */
@@ -897,33 +1203,86 @@ _write_comment_files(lxw_packager *self)
 }
 
 /*
- * Write the sharedStrings.xml file.
+ * Write the sharedStrings.xml file. The strings are assembled, and then
+ * added to the zip file, in chunks so that an incremental close can return
+ * once its budget is used.
  */
 STATIC lxw_error
 _write_shared_strings_file(lxw_packager *self)
 {
     lxw_sst *sst = self->workbook->sst;
-    char *buffer = NULL;
-    size_t buffer_size = 0;
     lxw_error err;
+    long offset;
 
     /* Skip the sharedStrings file if there are no shared strings. */
     if (!sst->string_count)
         return LXW_NO_ERROR;
 
-    sst->file = lxw_get_filehandle(&buffer, &buffer_size, self->tmpdir);
-    if (!sst->file)
-        return LXW_ERROR_CREATING_TMPFILE;
+    if (!self->member_file) {
+        sst->file = lxw_get_filehandle(&self->member_buffer,
+                                       &self->member_buffer_size,
+                                       self->tmpdir);
+        if (!sst->file)
+            return LXW_ERROR_CREATING_TMPFILE;
 
-    lxw_sst_assemble_xml_file(sst);
+        self->member_file = sst->file;
+        self->sst_element = lxw_sst_assemble_xml_start(sst);
+    }
 
-    err = _add_to_zip(self, sst->file, &buffer, &buffer_size,
-                      "xl/sharedStrings.xml");
-    fclose(sst->file);
-    free(buffer);
-    RETURN_ON_ERROR(err);
+    while (self->sst_element) {
+        offset = ftell(sst->file);
+        self->sst_element = lxw_sst_assemble_xml_strings(sst,
+                                                         self->sst_element,
+                                                         LXW_SST_STEP_STRINGS);
+        self->step_size += ftell(sst->file) - offset;
 
-    return LXW_NO_ERROR;
+        if (self->step_budget && self->step_size >= self->step_budget
+            && self->sst_element)
+            return LXW_CLOSE_IN_PROGRESS;
+    }
+
+    if (!self->member_open) {
+        lxw_sst_assemble_xml_end(sst);
+
+        err = _open_zip_member(self, "xl/sharedStrings.xml", 0);
+        RETURN_ON_ERROR(err);
+
+        self->member_open = LXW_TRUE;
+    }
+
+    return _write_zip_member(self);
+}
+
+/*
+ * Add the defined names with ranges to the app.xml parts, except for
+ * autofilters and other hidden names, which Excel doesn't list.
+ */
+STATIC void
+_add_app_named_ranges(lxw_app *app, lxw_workbook *workbook)
+{
+    lxw_defined_name *defined_name;
+    uint32_t named_range_count = 0;
+    char *autofilter;
+    char *has_range;
+    char number[LXW_ATTR_32] = { 0 };
+
+    /* Add the Named Ranges parts. */
+    TAILQ_FOREACH(defined_name, workbook->defined_names, list_pointers) {
+
+        has_range = strchr(defined_name->formula, '!');
+        autofilter = strstr(defined_name->app_name, "_FilterDatabase");
+
+        if (has_range && !autofilter && !defined_name->hidden) {
+            lxw_app_add_part_name(app, defined_name->app_name);
+            named_range_count++;
+        }
+    }
+
+    /* Add the Named Range heading pairs. */
+    if (named_range_count) {
+        lxw_snprintf(number, LXW_ATTR_32, "%d", named_range_count);
+        lxw_app_add_heading_pair(app, "Named Ranges", number);
+    }
 }
 
 /*
@@ -936,16 +1295,15 @@ _write_app_file(lxw_packager *self)
     lxw_sheet *sheet;
     lxw_worksheet *worksheet;
     lxw_chartsheet *chartsheet;
-    lxw_defined_name *defined_name;
     lxw_app *app;
     char *buffer = NULL;
     size_t buffer_size = 0;
-    uint32_t named_range_count = 0;
-    char *autofilter;
-    char *has_range;
     char number[LXW_ATTR_32] = { 0 };
     lxw_error err = LXW_NO_ERROR;
 
+    if (workbook->options.minimal_package)
+        return LXW_NO_ERROR;
+
     app = lxw_app_new();
     if (!app) {
         err = LXW_ERROR_MEMORY_MALLOC_FAILED;
@@ -984,24 +1342,7 @@ _write_app_file(lxw_packager *self)
         }
     }
 
-    /* Add the Named Ranges parts. */
-    TAILQ_FOREACH(defined_name, workbook->defined_names, list_pointers) {
-
-        has_range = strchr(defined_name->formula, '!');
-        autofilter = strstr(defined_name->app_name, "_FilterDatabase");
-
-        /* Only store defined names with ranges (except for autofilters). */
-        if (has_range && !autofilter) {
-            lxw_app_add_part_name(app, defined_name->app_name);
-            named_range_count++;
-        }
-    }
-
-    /* Add the Named Range heading pairs. */
-    if (named_range_count) {
-        lxw_snprintf(number, LXW_ATTR_32, "%d", named_range_count);
-        lxw_app_add_heading_pair(app, "Named Ranges", number);
-    }
+    _add_app_named_ranges(app, workbook);
 
     /* Set the app/doc properties. */
     app->properties = workbook->properties;
@@ -1029,10 +1370,14 @@ STATIC lxw_error
 _write_core_file(lxw_packager *self)
 {
     lxw_error err = LXW_NO_ERROR;
-    lxw_core *core = lxw_core_new();
+    lxw_core *core;
     char *buffer = NULL;
     size_t buffer_size = 0;
 
+    if (self->workbook->options.minimal_package)
+        return LXW_NO_ERROR;
+
+    core = lxw_core_new();
     if (!core) {
         err = LXW_ERROR_MEMORY_MALLOC_FAILED;
         goto mem_error;
@@ -1324,10 +1669,14 @@ STATIC lxw_error
 _write_theme_file(lxw_packager *self)
 {
     lxw_error err = LXW_NO_ERROR;
-    lxw_theme *theme = lxw_theme_new();
+    lxw_theme *theme;
     char *buffer = NULL;
     size_t buffer_size = 0;
 
+    if (self->workbook->options.minimal_package)
+        return LXW_NO_ERROR;
+
+    theme = lxw_theme_new();
     if (!theme) {
         err = LXW_ERROR_MEMORY_MALLOC_FAILED;
         goto mem_error;
@@ -1460,6 +1809,13 @@ _write_content_types_file(lxw_packager *self)
         goto mem_error;
     }
 
+    /* Remove the optional parts that aren't written for minimal packages. */
+    if (workbook->options.minimal_package) {
+        lxw_ct_remove_override(content_types, "/docProps/app.xml");
+        lxw_ct_remove_override(content_types, "/docProps/core.xml");
+        lxw_ct_remove_override(content_types, "/xl/theme/theme1.xml");
+    }
+
     if (workbook->has_png)
         lxw_ct_add_default(content_types, "png", "image/png");
 
@@ -1518,6 +1874,20 @@ _write_content_types_file(lxw_packager *self)
         lxw_ct_add_table_name(content_types, filename);
     }
 
+    for (index = 1; index <= workbook->pivot_table_count; index++) {
+        lxw_snprintf(filename, LXW_FILENAME_LENGTH,
+                     "/xl/pivotTables/pivotTable%d.xml", index);
+        lxw_ct_add_pivot_table_name(content_types, filename);
+
+        lxw_snprintf(filename, LXW_FILENAME_LENGTH,
+                     "/xl/pivotCache/pivotCacheDefinition%d.xml", index);
+        lxw_ct_add_pivot_cache_name(content_types, filename);
+
+        lxw_snprintf(filename, LXW_FILENAME_LENGTH,
+                     "/xl/pivotCache/pivotCacheRecords%d.xml", index);
+        lxw_ct_add_pivot_records_name(content_types, filename);
+    }
+
     if (workbook->has_vml)
         lxw_ct_add_vml_name(content_types);
 
@@ -1567,6 +1937,7 @@ _write_workbook_rels_file(lxw_packager *self)
     char sheetname[LXW_FILENAME_LENGTH] = { 0 };
     uint32_t worksheet_index = 1;
     uint32_t chartsheet_index = 1;
+    uint32_t index;
     lxw_error err = LXW_NO_ERROR;
 
     if (!rels) {
@@ -1595,7 +1966,17 @@ _write_workbook_rels_file(lxw_packager *self)
         }
     }
 
-    lxw_add_document_relationship(rels, "/theme", "theme/theme1.xml");
+    /* The pivot cache rel ids follow the sheets. See workbook.xml. */
+    for (index = 1; index <= workbook->pivot_table_count; index++) {
+        lxw_snprintf(sheetname, LXW_FILENAME_LENGTH,
+                     "pivotCache/pivotCacheDefinition%d.xml", index);
+        lxw_add_document_relationship(rels, "/pivotCacheDefinition",
+                                      sheetname);
+    }
+
+    if (!workbook->options.minimal_package)
+        lxw_add_document_relationship(rels, "/theme", "theme/theme1.xml");
+
     lxw_add_document_relationship(rels, "/styles", "styles.xml");
 
     if (workbook->sst->string_count)
@@ -1655,6 +2036,7 @@ _write_worksheet_rels_file(lxw_packager *self)
         if (STAILQ_EMPTY(worksheet->external_hyperlinks) &&
             STAILQ_EMPTY(worksheet->external_drawing_links) &&
             STAILQ_EMPTY(worksheet->external_table_links) &&
+            STAILQ_EMPTY(worksheet->external_pivot_table_links) &&
             !worksheet->external_vml_header_link &&
             !worksheet->external_vml_comment_link &&
             !worksheet->external_background_link &&
@@ -1699,6 +2081,12 @@ _write_worksheet_rels_file(lxw_packager *self)
                                            rel->target_mode);
         }
 
+        STAILQ_FOREACH(rel, worksheet->external_pivot_table_links,
+                       list_pointers) {
+            lxw_add_worksheet_relationship(rels, rel->type, rel->target,
+                                           rel->target_mode);
+        }
+
         rel = worksheet->external_comment_link;
         if (rel)
             lxw_add_worksheet_relationship(rels, rel->type, rel->target,
@@ -2023,12 +2411,15 @@ _write_root_rels_file(lxw_packager *self)
 
     lxw_add_document_relationship(rels, "/officeDocument", "xl/workbook.xml");
 
-    lxw_add_package_relationship(rels,
-                                 "/metadata/core-properties",
-                                 "docProps/core.xml");
+    if (!self->workbook->options.minimal_package) {
+        lxw_add_package_relationship(rels,
+                                     "/metadata/core-properties",
+                                     "docProps/core.xml");
 
-    lxw_add_document_relationship(rels,
-                                  "/extended-properties", "docProps/app.xml");
+        lxw_add_document_relationship(rels,
+                                      "/extended-properties",
+                                      "docProps/app.xml");
+    }
 
     if (!STAILQ_EMPTY(self->workbook->custom_properties))
         lxw_add_document_relationship(rels,
@@ -2054,17 +2445,20 @@ mem_error:
  *
  ****************************************************************************/
 
+/*
+ * Open a new member in the zip file. Raw members take data that has already
+ * been compressed.
+ */
 STATIC lxw_error
-_add_file_to_zip(lxw_packager *self, FILE *file, const char *filename)
+_open_zip_member(lxw_packager *self, const char *filename, uint8_t raw)
 {
     int16_t error = ZIP_OK;
-    size_t size_read;
 
     error = zipOpenNewFileInZip4_64(self->zipfile,
                                     filename,
                                     &self->zipfile_info,
                                     NULL, 0, NULL, 0, NULL,
-                                    Z_DEFLATED, Z_DEFAULT_COMPRESSION, 0,
+                                    Z_DEFLATED, Z_DEFAULT_COMPRESSION, raw,
                                     -MAX_WBITS, DEF_MEM_LEVEL,
                                     Z_DEFAULT_STRATEGY, NULL, 0, 0, 0,
                                     self->use_zip64);
@@ -2074,6 +2468,102 @@ _add_file_to_zip(lxw_packager *self, FILE *file, const char *filename)
         RETURN_ON_ZIP_ERROR(error, LXW_ERROR_ZIP_FILE_ADD);
     }
 
+    return LXW_NO_ERROR;
+}
+
+STATIC lxw_error
+_close_zip_member(lxw_packager *self)
+{
+    int16_t error = ZIP_OK;
+
+    error = zipCloseFileInZip(self->zipfile);
+    if (error != ZIP_OK) {
+        LXW_ERROR("Error in closing member in the zipfile");
+        RETURN_ON_ZIP_ERROR(error, LXW_ERROR_ZIP_FILE_ADD);
+    }
+
+    return LXW_NO_ERROR;
+}
+
+/*
+ * Add the data of the open member file to the zip file in chunks, stopping
+ * when the step budget is used. The member is closed once it is complete.
+ */
+STATIC lxw_error
+_write_zip_member(lxw_packager *self)
+{
+    int16_t error = ZIP_OK;
+    const char *data;
+    size_t size_read;
+
+    /* Flush to ensure buffer is updated when using a memory-backed file. */
+    if (self->member_offset == 0) {
+        fflush(self->member_file);
+
+        if (!self->member_buffer)
+            rewind(self->member_file);
+    }
+
+    do {
+        if (self->member_buffer) {
+            data = self->member_buffer + self->member_offset;
+            size_read = self->member_buffer_size - self->member_offset;
+
+            if (size_read > self->buffer_size)
+                size_read = self->buffer_size;
+        }
+        else {
+            data = self->buffer;
+            size_read = fread((void *) self->buffer, 1, self->buffer_size,
+                              self->member_file);
+
+            if (size_read < self->buffer_size && ferror(self->member_file)) {
+                LXW_ERROR("Error reading member file data");
+                return LXW_ERROR_ZIP_FILE_ADD;
+            }
+        }
+
+        if (!size_read)
+            break;
+
+        error = zipWriteInFileInZip(self->zipfile,
+                                    data, (unsigned int) size_read);
+
+        if (error < 0) {
+            LXW_ERROR("Error in writing member in the zipfile");
+            RETURN_ON_ZIP_ERROR(error, LXW_ERROR_ZIP_FILE_ADD);
+        }
+
+        self->member_offset += size_read;
+        self->step_size += size_read;
+
+    } while (!self->step_budget || self->step_size < self->step_budget);
+
+    if (size_read)
+        return LXW_CLOSE_IN_PROGRESS;
+
+    fclose(self->member_file);
+    free(self->member_buffer);
+
+    self->member_file = NULL;
+    self->member_buffer = NULL;
+    self->member_buffer_size = 0;
+    self->member_offset = 0;
+    self->member_open = LXW_FALSE;
+
+    return _close_zip_member(self);
+}
+
+STATIC lxw_error
+_add_file_to_zip(lxw_packager *self, FILE *file, const char *filename)
+{
+    int16_t error = ZIP_OK;
+    size_t size_read;
+    lxw_error err;
+
+    err = _open_zip_member(self, filename, 0);
+    RETURN_ON_ERROR(err);
+
     fflush(file);
     rewind(file);
 
@@ -2096,17 +2586,13 @@ _add_file_to_zip(lxw_packager *self, FILE *file, const char *filename)
             RETURN_ON_ZIP_ERROR(error, LXW_ERROR_ZIP_FILE_ADD);
         }
 
+        self->step_size += size_read;
+
         size_read =
             fread((void *) (void *) self->buffer, 1, self->buffer_size, file);
     }
 
-    error = zipCloseFileInZip(self->zipfile);
-    if (error != ZIP_OK) {
-        LXW_ERROR("Error in closing member in the zipfile");
-        RETURN_ON_ZIP_ERROR(error, LXW_ERROR_ZIP_FILE_ADD);
-    }
-
-    return LXW_NO_ERROR;
+    return _close_zip_member(self);
 }
 
 STATIC lxw_error
@@ -2114,30 +2600,50 @@ _add_buffer_to_zip(lxw_packager *self, const char *buffer, size_t buffer_size,
                    const char *filename)
 {
     int16_t error = ZIP_OK;
+    lxw_error err;
 
-    error = zipOpenNewFileInZip4_64(self->zipfile,
-                                    filename,
-                                    &self->zipfile_info,
-                                    NULL, 0, NULL, 0, NULL,
-                                    Z_DEFLATED, Z_DEFAULT_COMPRESSION, 0,
-                                    -MAX_WBITS, DEF_MEM_LEVEL,
-                                    Z_DEFAULT_STRATEGY, NULL, 0, 0, 0,
-                                    self->use_zip64);
+    err = _open_zip_member(self, filename, 0);
+    RETURN_ON_ERROR(err);
 
-    if (error != ZIP_OK) {
-        LXW_ERROR("Error adding member to zipfile");
+    error = zipWriteInFileInZip(self->zipfile,
+                                buffer, (unsigned int) buffer_size);
+
+    if (error < 0) {
+        LXW_ERROR("Error in writing member in the zipfile");
         RETURN_ON_ZIP_ERROR(error, LXW_ERROR_ZIP_FILE_ADD);
     }
 
-    error = zipWriteInFileInZip(self->zipfile,
-                                buffer, (unsigned int) buffer_size);
+    self->step_size += buffer_size;
+
+    return _close_zip_member(self);
+}
+
+/*
+ * Add data that has already been compressed, from the image cache, to the
+ * zip file.
+ */
+STATIC lxw_error
+_add_raw_data_to_zip(lxw_packager *self, lxw_image_cache_entry *cache_entry,
+                     const char *filename)
+{
+    int16_t error = ZIP_OK;
+    lxw_error err;
+
+    err = _open_zip_member(self, filename, 1);
+    RETURN_ON_ERROR(err);
+
+    error = zipWriteInFileInZip(self->zipfile, cache_entry->zip_data,
+                                (unsigned int) cache_entry->zip_data_size);
 
     if (error < 0) {
         LXW_ERROR("Error in writing member in the zipfile");
         RETURN_ON_ZIP_ERROR(error, LXW_ERROR_ZIP_FILE_ADD);
     }
 
-    error = zipCloseFileInZip(self->zipfile);
+    self->step_size += cache_entry->zip_data_size;
+
+    error = zipCloseFileInZipRaw64(self->zipfile, cache_entry->data_size,
+                                   cache_entry->crc32);
     if (error != ZIP_OK) {
         LXW_ERROR("Error in closing member in the zipfile");
         RETURN_ON_ZIP_ERROR(error, LXW_ERROR_ZIP_FILE_ADD);
@@ -2158,103 +2664,76 @@ _add_to_zip(lxw_packager *self, FILE *file, char **buffer,
 }
 
 /*
- * Write the xml files that make up the XLSX OPC package.
+ * The functions that write the xml files that make up the XLSX OPC package,
+ * in package order.
+ */
+typedef lxw_error (*lxw_package_writer) (lxw_packager *self);
+
+static const lxw_package_writer package_writers[] = {
+    _write_content_types_file,
+    _write_root_rels_file,
+    _write_workbook_rels_file,
+    _write_pivot_table_files,
+    _write_worksheet_files,
+    _write_chartsheet_files,
+    _write_workbook_file,
+    _write_chart_files,
+    _write_drawing_files,
+    _write_vml_files,
+    _write_comment_files,
+    _write_table_files,
+    _write_shared_strings_file,
+    _write_custom_file,
+    _write_theme_file,
+    _write_styles_file,
+    _write_worksheet_rels_file,
+    _write_chartsheet_rels_file,
+    _write_drawing_rels_file,
+    _write_image_files,
+    _add_vba_project,
+    _add_vba_project_signature,
+    _write_vba_project_rels_file,
+    _write_core_file,
+    _write_metadata_file,
+    _write_rich_value_file,
+    _write_rich_value_rel_file,
+    _write_rich_value_types_file,
+    _write_rich_value_structure_file,
+    _write_rich_value_rels_file,
+    _write_app_file,
+};
+
+#define LXW_PACKAGE_WRITERS \
+    (sizeof(package_writers) / sizeof(package_writers[0]))
+
+/*
+ * Write the xml files that make up the XLSX OPC package until roughly
+ * "budget" bytes have been added to the zip file. Returns
+ * LXW_CLOSE_IN_PROGRESS if there is more to do. A zero budget writes the
+ * complete package.
  */
 lxw_error
-lxw_create_package(lxw_packager *self)
+lxw_create_package_step(lxw_packager *self, size_t budget)
 {
     lxw_error error;
     int8_t zip_error;
 
-    error = _write_content_types_file(self);
-    RETURN_AND_ZIPCLOSE_ON_ERROR(error);
-
-    error = _write_root_rels_file(self);
-    RETURN_AND_ZIPCLOSE_ON_ERROR(error);
-
-    error = _write_workbook_rels_file(self);
-    RETURN_AND_ZIPCLOSE_ON_ERROR(error);
-
-    error = _write_worksheet_files(self);
-    RETURN_AND_ZIPCLOSE_ON_ERROR(error);
-
-    error = _write_chartsheet_files(self);
-    RETURN_AND_ZIPCLOSE_ON_ERROR(error);
-
-    error = _write_workbook_file(self);
-    RETURN_AND_ZIPCLOSE_ON_ERROR(error);
-
-    error = _write_chart_files(self);
-    RETURN_AND_ZIPCLOSE_ON_ERROR(error);
-
-    error = _write_drawing_files(self);
-    RETURN_AND_ZIPCLOSE_ON_ERROR(error);
+    self->step_budget = budget;
+    self->step_size = 0;
 
-    error = _write_vml_files(self);
-    RETURN_AND_ZIPCLOSE_ON_ERROR(error);
+    while (self->part < LXW_PACKAGE_WRITERS) {
+        error = package_writers[self->part] (self);
 
-    error = _write_comment_files(self);
-    RETURN_AND_ZIPCLOSE_ON_ERROR(error);
+        if (error == LXW_CLOSE_IN_PROGRESS)
+            return error;
 
-    error = _write_table_files(self);
-    RETURN_AND_ZIPCLOSE_ON_ERROR(error);
+        RETURN_AND_ZIPCLOSE_ON_ERROR(error);
 
-    error = _write_shared_strings_file(self);
-    RETURN_AND_ZIPCLOSE_ON_ERROR(error);
+        self->part++;
 
-    error = _write_custom_file(self);
-    RETURN_AND_ZIPCLOSE_ON_ERROR(error);
-
-    error = _write_theme_file(self);
-    RETURN_AND_ZIPCLOSE_ON_ERROR(error);
-
-    error = _write_styles_file(self);
-    RETURN_AND_ZIPCLOSE_ON_ERROR(error);
-
-    error = _write_worksheet_rels_file(self);
-    RETURN_AND_ZIPCLOSE_ON_ERROR(error);
-
-    error = _write_chartsheet_rels_file(self);
-    RETURN_AND_ZIPCLOSE_ON_ERROR(error);
-
-    error = _write_drawing_rels_file(self);
-    RETURN_AND_ZIPCLOSE_ON_ERROR(error);
-
-    error = _write_image_files(self);
-    RETURN_AND_ZIPCLOSE_ON_ERROR(error);
-
-    error = _add_vba_project(self);
-    RETURN_AND_ZIPCLOSE_ON_ERROR(error);
-
-    error = _add_vba_project_signature(self);
-    RETURN_AND_ZIPCLOSE_ON_ERROR(error);
-
-    error = _write_vba_project_rels_file(self);
-    RETURN_AND_ZIPCLOSE_ON_ERROR(error);
-
-    error = _write_core_file(self);
-    RETURN_AND_ZIPCLOSE_ON_ERROR(error);
-
-    error = _write_metadata_file(self);
-    RETURN_AND_ZIPCLOSE_ON_ERROR(error);
-
-    error = _write_rich_value_file(self);
-    RETURN_AND_ZIPCLOSE_ON_ERROR(error);
-
-    error = _write_rich_value_rel_file(self);
-    RETURN_AND_ZIPCLOSE_ON_ERROR(error);
-
-    error = _write_rich_value_types_file(self);
-    RETURN_AND_ZIPCLOSE_ON_ERROR(error);
-
-    error = _write_rich_value_structure_file(self);
-    RETURN_AND_ZIPCLOSE_ON_ERROR(error);
-
-    error = _write_rich_value_rels_file(self);
-    RETURN_AND_ZIPCLOSE_ON_ERROR(error);
-
-    error = _write_app_file(self);
-    RETURN_AND_ZIPCLOSE_ON_ERROR(error);
+        if (budget && self->step_size >= budget)
+            return LXW_CLOSE_IN_PROGRESS;
+    }
 
     zip_error = zipClose(self->zipfile, NULL);
     if (zip_error) {
@@ -2263,3 +2742,12 @@ lxw_create_package(lxw_packager *self)
 
     return LXW_NO_ERROR;
 }
+
+/*
+ * Write the xml files that make up the XLSX OPC package.
+ */
+lxw_error
+lxw_create_package(lxw_packager *self)
+{
+    return lxw_create_package_step(self, 0);
+}
@@ -0,0 +1,1204 @@
+/*****************************************************************************
+ * pivot_table - A library for creating Excel XLSX pivot table and pivot
+ *               cache files.
+ *
+ * Used in conjunction with the libxlsxwriter library.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ * Copyright 2014-2025, John McNamara, jmcnamara@cpan.org.
+ *
+ */
+
+#include "xlsxwriter/xmlwriter.h"
+#include "xlsxwriter/worksheet.h"
+#include "xlsxwriter/pivot_table.h"
+#include "xlsxwriter/utility.h"
+
+#define LXW_PIVOT_ITEM_BUCKETS 1024
+
+/*
+ * Forward declarations.
+ */
+
+/*****************************************************************************
+ *
+ * Private functions.
+ *
+ ****************************************************************************/
+
+/*
+ * Find the index of a cache field from its name.
+ */
+STATIC int32_t
+_pivot_field_index(lxw_pivot_table *self, const char *name)
+{
+    uint16_t i;
+
+    for (i = 0; i < self->num_fields; i++) {
+        if (strcmp(self->fields[i].name, name) == 0)
+            return i;
+    }
+
+    LXW_WARN_FORMAT1("worksheet_add_pivot_table(): field '%s' isn't in the "
+                     "header row of the pivot table source range", name);
+
+    return -1;
+}
+
+/*
+ * Check if a cache field name is used by one of the previous fields.
+ */
+STATIC uint8_t
+_pivot_field_name_used(lxw_pivot_table *self, uint16_t num_fields,
+                       const char *name)
+{
+    uint16_t i;
+
+    for (i = 0; i < num_fields; i++) {
+        if (strcmp(self->fields[i].name, name) == 0)
+            return LXW_TRUE;
+    }
+
+    return LXW_FALSE;
+}
+
+/*
+ * Set the cache field names from the header row of the source range. Like
+ * Excel, duplicate names are made unique by appending "2", "3", etc.
+ */
+STATIC lxw_error
+_pivot_set_field_names(lxw_pivot_table *self)
+{
+    lxw_pivot_table_obj *pivot_obj = self->pivot_obj;
+    lxw_cell_value value;
+    char number[LXW_ATTR_32];
+    const char *name;
+    char *unique_name;
+    size_t length;
+    uint32_t suffix;
+    uint16_t i;
+
+    for (i = 0; i < self->num_fields; i++) {
+        worksheet_get_cell(pivot_obj->source, pivot_obj->first_row,
+                           pivot_obj->first_col + i, &value);
+
+        if (value.type == LXW_CELL_VALUE_STRING && *value.string) {
+            name = value.string;
+        }
+        else {
+            if (value.type == LXW_CELL_VALUE_NUMBER
+                || value.type == LXW_CELL_VALUE_FORMULA)
+                lxw_sprintf_dbl(number, value.number);
+            else
+                lxw_snprintf(number, LXW_ATTR_32, "Column%d", i + 1);
+
+            name = number;
+        }
+
+        if (!_pivot_field_name_used(self, i, name)) {
+            self->fields[i].name = lxw_strdup(name);
+            RETURN_ON_MEM_ERROR(self->fields[i].name,
+                                LXW_ERROR_MEMORY_MALLOC_FAILED);
+            continue;
+        }
+
+        length = strlen(name) + LXW_ATTR_32;
+        unique_name = malloc(length);
+        RETURN_ON_MEM_ERROR(unique_name, LXW_ERROR_MEMORY_MALLOC_FAILED);
+
+        for (suffix = 2;; suffix++) {
+            lxw_snprintf(unique_name, length, "%s%u", name, suffix);
+
+            if (!_pivot_field_name_used(self, i, unique_name))
+                break;
+        }
+
+        self->fields[i].name = unique_name;
+    }
+
+    return LXW_NO_ERROR;
+}
+
+/*
+ * Map the user field names of a row or column axis to cache fields.
+ */
+STATIC lxw_error
+_pivot_set_axis_fields(lxw_pivot_table *self, char **names,
+                       uint16_t num_names, uint8_t axis,
+                       uint16_t **axis_fields, uint16_t *num_axis_fields)
+{
+    lxw_pivot_cache_field *field;
+    int32_t index;
+    uint16_t i;
+
+    if (!num_names)
+        return LXW_NO_ERROR;
+
+    *axis_fields = calloc(num_names, sizeof(uint16_t));
+    RETURN_ON_MEM_ERROR(*axis_fields, LXW_ERROR_MEMORY_MALLOC_FAILED);
+
+    for (i = 0; i < num_names; i++) {
+        index = _pivot_field_index(self, names[i]);
+        if (index < 0)
+            return LXW_ERROR_PARAMETER_VALIDATION;
+
+        field = &self->fields[index];
+
+        /* A field can only be used once as a row or column label. */
+        if (field->axis) {
+            LXW_WARN_FORMAT1("worksheet_add_pivot_table(): field '%s' is "
+                             "already used as a row or column field",
+                             names[i]);
+            return LXW_ERROR_PARAMETER_VALIDATION;
+        }
+
+        field->axis = axis;
+        field->items = lxw_hash_new(LXW_PIVOT_ITEM_BUCKETS, 1, 1);
+        RETURN_ON_MEM_ERROR(field->items, LXW_ERROR_MEMORY_MALLOC_FAILED);
+
+        (*axis_fields)[(*num_axis_fields)++] = (uint16_t) index;
+    }
+
+    return LXW_NO_ERROR;
+}
+
+/*
+ * Map the user data fields to cache fields.
+ */
+STATIC lxw_error
+_pivot_set_data_fields(lxw_pivot_table *self)
+{
+    lxw_pivot_table_obj *pivot_obj = self->pivot_obj;
+    int32_t index;
+    uint16_t i;
+
+    if (!pivot_obj->num_data_fields)
+        return LXW_NO_ERROR;
+
+    self->data_fields = calloc(pivot_obj->num_data_fields, sizeof(uint16_t));
+    RETURN_ON_MEM_ERROR(self->data_fields, LXW_ERROR_MEMORY_MALLOC_FAILED);
+
+    self->data_objs = calloc(pivot_obj->num_data_fields,
+                             sizeof(lxw_pivot_data_obj *));
+    RETURN_ON_MEM_ERROR(self->data_objs, LXW_ERROR_MEMORY_MALLOC_FAILED);
+
+    for (i = 0; i < pivot_obj->num_data_fields; i++) {
+        index = _pivot_field_index(self, pivot_obj->data_fields[i].field);
+        if (index < 0)
+            return LXW_ERROR_PARAMETER_VALIDATION;
+
+        self->fields[index].is_data = LXW_TRUE;
+        self->data_fields[self->num_data_fields] = (uint16_t) index;
+        self->data_objs[self->num_data_fields] = &pivot_obj->data_fields[i];
+        self->num_data_fields++;
+    }
+
+    return LXW_NO_ERROR;
+}
+
+/*
+ * Create a new pivot table object and map the user fields to the columns of
+ * the source range.
+ */
+STATIC lxw_error
+_pivot_table_create(lxw_pivot_table_obj *pivot_obj,
+                    lxw_pivot_table **new_pivot_table)
+{
+    lxw_error err = LXW_ERROR_MEMORY_MALLOC_FAILED;
+    lxw_pivot_table *pivot_table = calloc(1, sizeof(lxw_pivot_table));
+    GOTO_LABEL_ON_MEM_ERROR(pivot_table, error);
+
+    pivot_table->pivot_obj = pivot_obj;
+    pivot_table->num_fields = pivot_obj->last_col - pivot_obj->first_col + 1;
+
+    pivot_table->fields = calloc(pivot_table->num_fields,
+                                 sizeof(lxw_pivot_cache_field));
+    GOTO_LABEL_ON_MEM_ERROR(pivot_table->fields, error);
+
+    pivot_table->record = calloc(pivot_table->num_fields,
+                                 sizeof(lxw_cell_value));
+    GOTO_LABEL_ON_MEM_ERROR(pivot_table->record, error);
+
+    err = _pivot_set_field_names(pivot_table);
+    if (err)
+        goto error;
+
+    err = _pivot_set_axis_fields(pivot_table, pivot_obj->row_fields,
+                                 pivot_obj->num_row_fields,
+                                 LXW_PIVOT_AXIS_ROW,
+                                 &pivot_table->row_fields,
+                                 &pivot_table->num_row_fields);
+    if (err)
+        goto error;
+
+    err = _pivot_set_axis_fields(pivot_table, pivot_obj->col_fields,
+                                 pivot_obj->num_col_fields,
+                                 LXW_PIVOT_AXIS_COL,
+                                 &pivot_table->col_fields,
+                                 &pivot_table->num_col_fields);
+    if (err)
+        goto error;
+
+    err = _pivot_set_data_fields(pivot_table);
+    if (err)
+        goto error;
+
+    *new_pivot_table = pivot_table;
+
+    return LXW_NO_ERROR;
+
+error:
+    lxw_pivot_table_free(pivot_table);
+    *new_pivot_table = NULL;
+    return err;
+}
+
+/*
+ * Create a new pivot table object from a pivot table added to a worksheet.
+ */
+lxw_pivot_table *
+lxw_pivot_table_new(lxw_pivot_table_obj *pivot_obj)
+{
+    lxw_pivot_table *pivot_table;
+
+    _pivot_table_create(pivot_obj, &pivot_table);
+
+    return pivot_table;
+}
+
+/*
+ * Check that the user fields of a pivot table are in the header row of the
+ * source range.
+ */
+lxw_error
+lxw_pivot_table_check_fields(lxw_pivot_table_obj *pivot_obj)
+{
+    lxw_pivot_table *pivot_table;
+    lxw_error err;
+
+    err = _pivot_table_create(pivot_obj, &pivot_table);
+    lxw_pivot_table_free(pivot_table);
+
+    return err;
+}
+
+/*
+ * Free a pivot table object.
+ */
+void
+lxw_pivot_table_free(lxw_pivot_table *pivot_table)
+{
+    uint16_t i;
+
+    if (!pivot_table)
+        return;
+
+    if (pivot_table->fields) {
+        for (i = 0; i < pivot_table->num_fields; i++) {
+            free(pivot_table->fields[i].name);
+
+            if (pivot_table->fields[i].items)
+                lxw_hash_free(pivot_table->fields[i].items);
+        }
+    }
+
+    free(pivot_table->fields);
+    free(pivot_table->record);
+    free(pivot_table->row_fields);
+    free(pivot_table->col_fields);
+    free(pivot_table->data_fields);
+    free(pivot_table->data_objs);
+    free(pivot_table->key);
+    free(pivot_table);
+}
+
+/*
+ * Start reading the records, i.e., the data rows, of the source range.
+ */
+STATIC void
+_pivot_start_records(lxw_pivot_table *self)
+{
+    lxw_pivot_table_obj *pivot_obj = self->pivot_obj;
+
+    self->record_row = pivot_obj->first_row + 1;
+    self->has_next_value = LXW_FALSE;
+
+    if (self->record_row <= pivot_obj->last_row)
+        worksheet_cell_iter_init(&self->iter, pivot_obj->source,
+                                 self->record_row, pivot_obj->first_col,
+                                 pivot_obj->last_row, pivot_obj->last_col);
+}
+
+/*
+ * Read the next record from the source range into self->record. The cells are
+ * read in place from the source worksheet so that only one record at a time
+ * is held in memory. Empty source rows are returned as empty records.
+ */
+STATIC uint8_t
+_pivot_next_record(lxw_pivot_table *self)
+{
+    lxw_pivot_table_obj *pivot_obj = self->pivot_obj;
+    lxw_cell_value *value = &self->next_value;
+    uint16_t i;
+
+    if (self->record_row > pivot_obj->last_row)
+        return LXW_FALSE;
+
+    for (i = 0; i < self->num_fields; i++)
+        self->record[i].type = LXW_CELL_VALUE_EMPTY;
+
+    if (!self->has_next_value)
+        self->has_next_value = worksheet_cell_iter_next(&self->iter, value);
+
+    while (self->has_next_value && value->row == self->record_row) {
+        self->record[value->col - pivot_obj->first_col] = *value;
+        self->has_next_value = worksheet_cell_iter_next(&self->iter, value);
+    }
+
+    self->record_row++;
+
+    return LXW_TRUE;
+}
+
+/*
+ * Create a key for a cell value to use for the shared items hash and for
+ * writing the item. The first character is the item type, as used in the
+ * XML element, followed by the item value.
+ */
+STATIC size_t
+_pivot_item_key(lxw_pivot_table *self, lxw_cell_value *value)
+{
+    size_t size = LXW_ATTR_32 + 1;
+    char *key;
+
+    if (value->type == LXW_CELL_VALUE_STRING)
+        size += strlen(value->string);
+
+    if (size > self->key_size) {
+        key = realloc(self->key, size);
+        RETURN_ON_MEM_ERROR(key, 0);
+
+        self->key = key;
+        self->key_size = size;
+    }
+
+    key = self->key;
+
+    if (value->type == LXW_CELL_VALUE_NUMBER
+        || value->type == LXW_CELL_VALUE_FORMULA) {
+        key[0] = 'n';
+        lxw_sprintf_dbl(key + 1, value->number);
+    }
+    else if (value->type == LXW_CELL_VALUE_STRING) {
+        key[0] = 's';
+        strcpy(key + 1, value->string);
+    }
+    else if (value->type == LXW_CELL_VALUE_BOOLEAN) {
+        key[0] = 'b';
+        key[1] = value->number ? '1' : '0';
+        key[2] = '\0';
+    }
+    else {
+        key[0] = 'm';
+        key[1] = '\0';
+    }
+
+    /* Include the terminating null so keys with common prefixes differ. */
+    return strlen(key) + 1;
+}
+
+/*
+ * Update the value types and range of a cache field from a record value.
+ */
+STATIC void
+_pivot_update_field(lxw_pivot_cache_field *field, lxw_cell_value *value)
+{
+    if (value->type == LXW_CELL_VALUE_NUMBER
+        || value->type == LXW_CELL_VALUE_FORMULA) {
+
+        if (!field->has_number || value->number < field->min_value)
+            field->min_value = value->number;
+
+        if (!field->has_number || value->number > field->max_value)
+            field->max_value = value->number;
+
+        if (value->number != (double) (int64_t) value->number)
+            field->has_non_integer = LXW_TRUE;
+
+        field->has_number = LXW_TRUE;
+    }
+    else if (value->type == LXW_CELL_VALUE_STRING) {
+        field->has_string = LXW_TRUE;
+    }
+    else if (value->type == LXW_CELL_VALUE_BOOLEAN) {
+        field->has_boolean = LXW_TRUE;
+    }
+    else {
+        field->has_blank = LXW_TRUE;
+    }
+}
+
+/*
+ * Add a value to the shared items of a row or column field, if it isn't
+ * already there. The hash value is the index of the item.
+ */
+STATIC lxw_error
+_pivot_add_item(lxw_pivot_table *self, lxw_pivot_cache_field *field,
+                lxw_cell_value *value)
+{
+    size_t key_len = _pivot_item_key(self, value);
+    char *key;
+    uint32_t *index;
+
+    if (!key_len)
+        return LXW_ERROR_MEMORY_MALLOC_FAILED;
+
+    if (lxw_hash_key_exists(field->items, self->key, key_len))
+        return LXW_NO_ERROR;
+
+    key = malloc(key_len);
+    RETURN_ON_MEM_ERROR(key, LXW_ERROR_MEMORY_MALLOC_FAILED);
+    memcpy(key, self->key, key_len);
+
+    index = malloc(sizeof(uint32_t));
+    GOTO_LABEL_ON_MEM_ERROR(index, mem_error);
+    *index = field->items->unique_count;
+
+    if (!lxw_insert_hash_element(field->items, key, index, key_len))
+        goto mem_error;
+
+    return LXW_NO_ERROR;
+
+mem_error:
+    free(key);
+    free(index);
+    return LXW_ERROR_MEMORY_MALLOC_FAILED;
+}
+
+/*
+ * Read the source range once to find the record count, the value types of
+ * each field and the unique shared items of the row and column fields.
+ */
+lxw_error
+lxw_pivot_table_build_cache(lxw_pivot_table *self)
+{
+    lxw_pivot_cache_field *field;
+    lxw_error err;
+    uint16_t i;
+
+    _pivot_start_records(self);
+
+    while (_pivot_next_record(self)) {
+        self->record_count++;
+
+        for (i = 0; i < self->num_fields; i++) {
+            field = &self->fields[i];
+
+            _pivot_update_field(field, &self->record[i]);
+
+            if (field->axis) {
+                err = _pivot_add_item(self, field, &self->record[i]);
+                RETURN_ON_ERROR(err);
+            }
+        }
+    }
+
+    return LXW_NO_ERROR;
+}
+
+/*****************************************************************************
+ *
+ * XML functions.
+ *
+ ****************************************************************************/
+
+/*
+ * Write the XML declaration.
+ */
+STATIC void
+_pivot_table_xml_declaration(lxw_pivot_table *self)
+{
+    lxw_xml_declaration(self->file);
+}
+
+/*
+ * Write a shared item or record value element from an item key. Doesn't use
+ * the xml functions as an optimization in the inner record writing loop.
+ */
+STATIC void
+_pivot_write_item(lxw_pivot_table *self, const char *key)
+{
+    if (key[0] == 's') {
+        fputs("<s", self->file);
+        lxw_xml_escaped_attribute(self->file, "v", key + 1);
+        fputs("/>", self->file);
+    }
+    else if (key[0] == 'm') {
+        fputs("<m/>", self->file);
+    }
+    else {
+        fprintf(self->file, "<%c v=\"%s\"/>", key[0], key + 1);
+    }
+}
+
+/*
+ * Write the <pivotCacheDefinition> element.
+ */
+STATIC void
+_pivot_write_pivot_cache_definition(lxw_pivot_table *self)
+{
+    struct xml_attribute_list attributes;
+    struct xml_attribute *attribute;
+    char xmlns[] = "http://schemas.openxmlformats.org/"
+        "spreadsheetml/2006/main";
+    char xmlns_r[] = "http://schemas.openxmlformats.org/"
+        "officeDocument/2006/relationships";
+
+    LXW_INIT_ATTRIBUTES();
+    LXW_PUSH_ATTRIBUTES_STR("xmlns", xmlns);
+    LXW_PUSH_ATTRIBUTES_STR("xmlns:r", xmlns_r);
+    LXW_PUSH_ATTRIBUTES_STR("r:id", "rId1");
+    LXW_PUSH_ATTRIBUTES_STR("refreshOnLoad", "1");
+    LXW_PUSH_ATTRIBUTES_STR("createdVersion", "6");
+    LXW_PUSH_ATTRIBUTES_STR("refreshedVersion", "6");
+    LXW_PUSH_ATTRIBUTES_STR("minRefreshableVersion", "3");
+    LXW_PUSH_ATTRIBUTES_INT("recordCount", self->record_count);
+
+    lxw_xml_start_tag(self->file, "pivotCacheDefinition", &attributes);
+
+    LXW_FREE_ATTRIBUTES();
+}
+
+/*
+ * Write the <cacheSource> element.
+ */
+STATIC void
+_pivot_write_cache_source(lxw_pivot_table *self)
+{
+    struct xml_attribute_list attributes;
+    struct xml_attribute *attribute;
+    lxw_pivot_table_obj *pivot_obj = self->pivot_obj;
+    char ref[LXW_MAX_CELL_RANGE_LENGTH];
+
+    lxw_rowcol_to_range(ref, pivot_obj->first_row, pivot_obj->first_col,
+                        pivot_obj->last_row, pivot_obj->last_col);
+
+    LXW_INIT_ATTRIBUTES();
+    LXW_PUSH_ATTRIBUTES_STR("type", "worksheet");
+
+    lxw_xml_start_tag(self->file, "cacheSource", &attributes);
+
+    LXW_FREE_ATTRIBUTES();
+    LXW_PUSH_ATTRIBUTES_STR("ref", ref);
+    LXW_PUSH_ATTRIBUTES_STR("sheet", pivot_obj->source->name);
+
+    lxw_xml_empty_tag(self->file, "worksheetSource", &attributes);
+    lxw_xml_end_tag(self->file, "cacheSource");
+
+    LXW_FREE_ATTRIBUTES();
+}
+
+/*
+ * Write the <sharedItems> element.
+ */
+STATIC void
+_pivot_write_shared_items(lxw_pivot_table *self,
+                          lxw_pivot_cache_field *field)
+{
+    struct xml_attribute_list attributes;
+    struct xml_attribute *attribute;
+    lxw_hash_element *element;
+    uint8_t num_types;
+
+    num_types = field->has_string + field->has_number + field->has_boolean;
+
+    LXW_INIT_ATTRIBUTES();
+
+    if (!field->has_string && !field->has_blank && !field->has_boolean)
+        LXW_PUSH_ATTRIBUTES_STR("containsSemiMixedTypes", "0");
+
+    if (!field->has_string)
+        LXW_PUSH_ATTRIBUTES_STR("containsString", "0");
+
+    if (field->has_blank)
+        LXW_PUSH_ATTRIBUTES_STR("containsBlank", "1");
+
+    if (num_types > 1)
+        LXW_PUSH_ATTRIBUTES_STR("containsMixedTypes", "1");
+
+    if (field->has_number) {
+        LXW_PUSH_ATTRIBUTES_STR("containsNumber", "1");
+
+        if (!field->has_non_integer)
+            LXW_PUSH_ATTRIBUTES_STR("containsInteger", "1");
+
+        LXW_PUSH_ATTRIBUTES_DBL("minValue", field->min_value);
+        LXW_PUSH_ATTRIBUTES_DBL("maxValue", field->max_value);
+    }
+
+    if (field->items) {
+        LXW_PUSH_ATTRIBUTES_INT("count", field->items->unique_count);
+
+        lxw_xml_start_tag(self->file, "sharedItems", &attributes);
+
+        LXW_FOREACH_ORDERED(element, field->items) {
+            _pivot_write_item(self, element->key);
+        }
+
+        lxw_xml_end_tag(self->file, "sharedItems");
+    }
+    else {
+        lxw_xml_empty_tag(self->file, "sharedItems", &attributes);
+    }
+
+    LXW_FREE_ATTRIBUTES();
+}
+
+/*
+ * Write the <cacheFields> element.
+ */
+STATIC void
+_pivot_write_cache_fields(lxw_pivot_table *self)
+{
+    struct xml_attribute_list attributes;
+    struct xml_attribute *attribute;
+    uint16_t i;
+
+    LXW_INIT_ATTRIBUTES();
+    LXW_PUSH_ATTRIBUTES_INT("count", self->num_fields);
+
+    lxw_xml_start_tag(self->file, "cacheFields", &attributes);
+
+    for (i = 0; i < self->num_fields; i++) {
+        LXW_FREE_ATTRIBUTES();
+        LXW_PUSH_ATTRIBUTES_STR("name", self->fields[i].name);
+        LXW_PUSH_ATTRIBUTES_STR("numFmtId", "0");
+
+        lxw_xml_start_tag(self->file, "cacheField", &attributes);
+        _pivot_write_shared_items(self, &self->fields[i]);
+        lxw_xml_end_tag(self->file, "cacheField");
+    }
+
+    lxw_xml_end_tag(self->file, "cacheFields");
+
+    LXW_FREE_ATTRIBUTES();
+}
+
+/*
+ * Write the <pivotCacheRecords> element.
+ */
+STATIC void
+_pivot_write_pivot_cache_records(lxw_pivot_table *self)
+{
+    struct xml_attribute_list attributes;
+    struct xml_attribute *attribute;
+    char xmlns[] = "http://schemas.openxmlformats.org/"
+        "spreadsheetml/2006/main";
+    char xmlns_r[] = "http://schemas.openxmlformats.org/"
+        "officeDocument/2006/relationships";
+
+    LXW_INIT_ATTRIBUTES();
+    LXW_PUSH_ATTRIBUTES_STR("xmlns", xmlns);
+    LXW_PUSH_ATTRIBUTES_STR("xmlns:r", xmlns_r);
+    LXW_PUSH_ATTRIBUTES_INT("count", self->record_count);
+
+    lxw_xml_start_tag(self->file, "pivotCacheRecords", &attributes);
+
+    LXW_FREE_ATTRIBUTES();
+}
+
+/*
+ * Write the <r> record elements, streamed from the source range.
+ */
+STATIC void
+_pivot_write_records(lxw_pivot_table *self)
+{
+    lxw_pivot_cache_field *field;
+    lxw_hash_element *element;
+    size_t key_len;
+    uint16_t i;
+
+    _pivot_start_records(self);
+
+    while (_pivot_next_record(self)) {
+        fputs("<r>", self->file);
+
+        for (i = 0; i < self->num_fields; i++) {
+            field = &self->fields[i];
+            key_len = _pivot_item_key(self, &self->record[i]);
+
+            if (!key_len) {
+                fputs("<m/>", self->file);
+            }
+            else if (field->axis) {
+                element = lxw_hash_key_exists(field->items, self->key,
+                                              key_len);
+                fprintf(self->file, "<x v=\"%u\"/>",
+                        element ? *(uint32_t *) element->value : 0);
+            }
+            else {
+                _pivot_write_item(self, self->key);
+            }
+        }
+
+        fputs("</r>", self->file);
+    }
+}
+
+/*
+ * Get the number of items, including the grand total, in an axis.
+ */
+STATIC uint32_t
+_pivot_axis_item_count(lxw_pivot_table *self, uint16_t *axis_fields,
+                       uint16_t num_axis_fields)
+{
+    if (!num_axis_fields)
+        return 1;
+
+    return self->fields[axis_fields[0]].items->unique_count + 1;
+}
+
+/*
+ * Write the <pivotTableDefinition> element.
+ */
+STATIC void
+_pivot_write_pivot_table_definition(lxw_pivot_table *self)
+{
+    struct xml_attribute_list attributes;
+    struct xml_attribute *attribute;
+    char xmlns[] = "http://schemas.openxmlformats.org/"
+        "spreadsheetml/2006/main";
+
+    LXW_INIT_ATTRIBUTES();
+    LXW_PUSH_ATTRIBUTES_STR("xmlns", xmlns);
+    LXW_PUSH_ATTRIBUTES_STR("name", self->pivot_obj->name);
+    LXW_PUSH_ATTRIBUTES_INT("cacheId", self->pivot_obj->id);
+    LXW_PUSH_ATTRIBUTES_STR("applyNumberFormats", "0");
+    LXW_PUSH_ATTRIBUTES_STR("applyBorderFormats", "0");
+    LXW_PUSH_ATTRIBUTES_STR("applyFontFormats", "0");
+    LXW_PUSH_ATTRIBUTES_STR("applyPatternFormats", "0");
+    LXW_PUSH_ATTRIBUTES_STR("applyAlignmentFormats", "0");
+    LXW_PUSH_ATTRIBUTES_STR("applyWidthHeightFormats", "1");
+    LXW_PUSH_ATTRIBUTES_STR("dataCaption", "Values");
+    LXW_PUSH_ATTRIBUTES_STR("updatedVersion", "6");
+    LXW_PUSH_ATTRIBUTES_STR("minRefreshableVersion", "3");
+    LXW_PUSH_ATTRIBUTES_STR("useAutoFormatting", "1");
+    LXW_PUSH_ATTRIBUTES_STR("itemPrintTitles", "1");
+    LXW_PUSH_ATTRIBUTES_STR("createdVersion", "6");
+    LXW_PUSH_ATTRIBUTES_STR("indent", "0");
+    LXW_PUSH_ATTRIBUTES_STR("outline", "1");
+    LXW_PUSH_ATTRIBUTES_STR("outlineData", "1");
+    LXW_PUSH_ATTRIBUTES_STR("multipleFieldFilters", "0");
+
+    lxw_xml_start_tag(self->file, "pivotTableDefinition", &attributes);
+
+    LXW_FREE_ATTRIBUTES();
+}
+
+/*
+ * Write the <location> element. The range is the initial layout of the table
+ * and is recalculated by Excel when the pivot cache is refreshed on load.
+ *
+ * The header rows depend on the column axis. Without column fields there is
+ * a single header row with the row labels and the data field captions. With
+ * column fields there is a "Column Labels" row and a row for the column items
+ * followed, for more than one data field, by a row for the data captions.
+ * Excel marks the row with the column items as the first header row, which is
+ * row 0 when the data captions are the column items.
+ */
+STATIC void
+_pivot_write_location(lxw_pivot_table *self)
+{
+    struct xml_attribute_list attributes;
+    struct xml_attribute *attribute;
+    lxw_pivot_table_obj *pivot_obj = self->pivot_obj;
+    char ref[LXW_MAX_CELL_RANGE_LENGTH];
+    uint16_t num_values = self->num_data_fields ? self->num_data_fields : 1;
+    uint32_t header_rows;
+    uint32_t first_header_row;
+    uint32_t num_rows;
+    uint32_t num_cols;
+    lxw_row_t last_row;
+    lxw_col_t last_col;
+
+    if (self->num_col_fields) {
+        header_rows = num_values > 1 ? 3 : 2;
+        first_header_row = 1;
+    }
+    else {
+        header_rows = 1;
+        first_header_row = num_values > 1 ? 0 : 1;
+    }
+
+    /* The row items include the grand total row. */
+    num_rows = header_rows;
+
+    if (self->num_row_fields)
+        num_rows += _pivot_axis_item_count(self, self->row_fields,
+                                           self->num_row_fields);
+    else
+        num_rows++;
+
+    /* The column items, including the grand total, repeat for each value. */
+    if (self->num_col_fields)
+        num_cols = num_values * _pivot_axis_item_count(self, self->col_fields,
+                                                       self->num_col_fields);
+    else
+        num_cols = num_values;
+
+    if (self->num_row_fields)
+        num_cols++;
+
+    last_row = pivot_obj->row + num_rows - 1;
+    last_col = pivot_obj->col + num_cols - 1;
+
+    if (last_row >= LXW_ROW_MAX)
+        last_row = LXW_ROW_MAX - 1;
+
+    if (last_col >= LXW_COL_MAX)
+        last_col = LXW_COL_MAX - 1;
+
+    lxw_rowcol_to_range(ref, pivot_obj->row, pivot_obj->col,
+                        last_row, last_col);
+
+    LXW_INIT_ATTRIBUTES();
+    LXW_PUSH_ATTRIBUTES_STR("ref", ref);
+    LXW_PUSH_ATTRIBUTES_INT("firstHeaderRow", first_header_row);
+    LXW_PUSH_ATTRIBUTES_INT("firstDataRow", header_rows);
+    LXW_PUSH_ATTRIBUTES_INT("firstDataCol", self->num_row_fields ? 1 : 0);
+
+    lxw_xml_empty_tag(self->file, "location", &attributes);
+
+    LXW_FREE_ATTRIBUTES();
+}
+
+/*
+ * Write the <pivotField> element.
+ */
+STATIC void
+_pivot_write_pivot_field(lxw_pivot_table *self, lxw_pivot_cache_field *field)
+{
+    struct xml_attribute_list attributes;
+    struct xml_attribute *attribute;
+    uint32_t i;
+
+    LXW_INIT_ATTRIBUTES();
+
+    if (field->axis == LXW_PIVOT_AXIS_ROW)
+        LXW_PUSH_ATTRIBUTES_STR("axis", "axisRow");
+    else if (field->axis == LXW_PIVOT_AXIS_COL)
+        LXW_PUSH_ATTRIBUTES_STR("axis", "axisCol");
+
+    if (field->is_data)
+        LXW_PUSH_ATTRIBUTES_STR("dataField", "1");
+
+    LXW_PUSH_ATTRIBUTES_STR("showAll", "0");
+
+    if (!field->axis) {
+        lxw_xml_empty_tag(self->file, "pivotField", &attributes);
+        LXW_FREE_ATTRIBUTES();
+        return;
+    }
+
+    lxw_xml_start_tag(self->file, "pivotField", &attributes);
+
+    LXW_FREE_ATTRIBUTES();
+    LXW_PUSH_ATTRIBUTES_INT("count", field->items->unique_count + 1);
+
+    lxw_xml_start_tag(self->file, "items", &attributes);
+
+    for (i = 0; i < field->items->unique_count; i++)
+        fprintf(self->file, "<item x=\"%u\"/>", i);
+
+    fputs("<item t=\"default\"/>", self->file);
+
+    lxw_xml_end_tag(self->file, "items");
+    lxw_xml_end_tag(self->file, "pivotField");
+
+    LXW_FREE_ATTRIBUTES();
+}
+
+/*
+ * Write the <pivotFields> element.
+ */
+STATIC void
+_pivot_write_pivot_fields(lxw_pivot_table *self)
+{
+    struct xml_attribute_list attributes;
+    struct xml_attribute *attribute;
+    uint16_t i;
+
+    LXW_INIT_ATTRIBUTES();
+    LXW_PUSH_ATTRIBUTES_INT("count", self->num_fields);
+
+    lxw_xml_start_tag(self->file, "pivotFields", &attributes);
+
+    for (i = 0; i < self->num_fields; i++)
+        _pivot_write_pivot_field(self, &self->fields[i]);
+
+    lxw_xml_end_tag(self->file, "pivotFields");
+
+    LXW_FREE_ATTRIBUTES();
+}
+
+/*
+ * Write the <rowFields> or <colFields> element. The -2 field is the position
+ * of the "Values" pseudo field when there is more than one data field.
+ */
+STATIC void
+_pivot_write_axis_fields(lxw_pivot_table *self, const char *tag,
+                         uint16_t *axis_fields, uint16_t num_axis_fields,
+                         uint8_t has_values_field)
+{
+    struct xml_attribute_list attributes;
+    struct xml_attribute *attribute;
+    uint16_t i;
+
+    if (!num_axis_fields && !has_values_field)
+        return;
+
+    LXW_INIT_ATTRIBUTES();
+    LXW_PUSH_ATTRIBUTES_INT("count", num_axis_fields + has_values_field);
+
+    lxw_xml_start_tag(self->file, tag, &attributes);
+
+    for (i = 0; i < num_axis_fields; i++)
+        fprintf(self->file, "<field x=\"%d\"/>", axis_fields[i]);
+
+    if (has_values_field)
+        fputs("<field x=\"-2\"/>", self->file);
+
+    lxw_xml_end_tag(self->file, tag);
+
+    LXW_FREE_ATTRIBUTES();
+}
+
+/*
+ * Write the <rowItems> or <colItems> element for an axis with a single field.
+ * The items for axes with more fields are left to Excel's refresh on load.
+ */
+STATIC void
+_pivot_write_axis_items(lxw_pivot_table *self, const char *tag,
+                        uint16_t *axis_fields, uint16_t num_axis_fields,
+                        uint16_t num_values)
+{
+    struct xml_attribute_list attributes;
+    struct xml_attribute *attribute;
+    uint32_t num_items;
+    uint32_t i;
+
+    LXW_INIT_ATTRIBUTES();
+
+    if (num_axis_fields == 0) {
+        LXW_PUSH_ATTRIBUTES_INT("count", num_values > 1 ? num_values : 1);
+
+        lxw_xml_start_tag(self->file, tag, &attributes);
+
+        if (num_values > 1) {
+            fputs("<i><x/></i>", self->file);
+            for (i = 1; i < num_values; i++)
+                fprintf(self->file, "<i i=\"%u\"><x v=\"%u\"/></i>", i, i);
+        }
+        else {
+            fputs("<i/>", self->file);
+        }
+
+        lxw_xml_end_tag(self->file, tag);
+    }
+    else if (num_axis_fields == 1 && num_values <= 1) {
+        num_items = self->fields[axis_fields[0]].items->unique_count;
+
+        LXW_PUSH_ATTRIBUTES_INT("count", num_items + 1);
+
+        lxw_xml_start_tag(self->file, tag, &attributes);
+
+        for (i = 0; i < num_items; i++) {
+            if (i == 0)
+                fputs("<i><x/></i>", self->file);
+            else
+                fprintf(self->file, "<i><x v=\"%u\"/></i>", i);
+        }
+
+        fputs("<i t=\"grand\"><x/></i>", self->file);
+
+        lxw_xml_end_tag(self->file, tag);
+    }
+
+    LXW_FREE_ATTRIBUTES();
+}
+
+/*
+ * Write the <dataField> element.
+ */
+STATIC void
+_pivot_write_data_field(lxw_pivot_table *self, uint16_t index)
+{
+    struct xml_attribute_list attributes;
+    struct xml_attribute *attribute;
+    lxw_pivot_data_obj *data_obj = self->data_objs[index];
+    uint16_t field_index = self->data_fields[index];
+    char name[LXW_MAX_ATTRIBUTE_LENGTH];
+    const char *functions[] = { "sum", "count", "average", "max", "min" };
+    const char *captions[] = { "Sum", "Count", "Average", "Max", "Min" };
+
+    if (data_obj->name)
+        lxw_snprintf(name, LXW_MAX_ATTRIBUTE_LENGTH, "%s", data_obj->name);
+    else
+        lxw_snprintf(name, LXW_MAX_ATTRIBUTE_LENGTH, "%s of %s",
+                     captions[data_obj->function],
+                     self->fields[field_index].name);
+
+    LXW_INIT_ATTRIBUTES();
+    LXW_PUSH_ATTRIBUTES_STR("name", name);
+    LXW_PUSH_ATTRIBUTES_INT("fld", field_index);
+
+    if (data_obj->function != LXW_PIVOT_FUNCTION_SUM)
+        LXW_PUSH_ATTRIBUTES_STR("subtotal", functions[data_obj->function]);
+
+    LXW_PUSH_ATTRIBUTES_STR("baseField", "0");
+    LXW_PUSH_ATTRIBUTES_STR("baseItem", "0");
+
+    lxw_xml_empty_tag(self->file, "dataField", &attributes);
+
+    LXW_FREE_ATTRIBUTES();
+}
+
+/*
+ * Write the <dataFields> element.
+ */
+STATIC void
+_pivot_write_data_fields(lxw_pivot_table *self)
+{
+    struct xml_attribute_list attributes;
+    struct xml_attribute *attribute;
+    uint16_t i;
+
+    if (!self->num_data_fields)
+        return;
+
+    LXW_INIT_ATTRIBUTES();
+    LXW_PUSH_ATTRIBUTES_INT("count", self->num_data_fields);
+
+    lxw_xml_start_tag(self->file, "dataFields", &attributes);
+
+    for (i = 0; i < self->num_data_fields; i++)
+        _pivot_write_data_field(self, i);
+
+    lxw_xml_end_tag(self->file, "dataFields");
+
+    LXW_FREE_ATTRIBUTES();
+}
+
+/*
+ * Write the <pivotTableStyleInfo> element.
+ */
+STATIC void
+_pivot_write_pivot_table_style_info(lxw_pivot_table *self)
+{
+    struct xml_attribute_list attributes;
+    struct xml_attribute *attribute;
+
+    LXW_INIT_ATTRIBUTES();
+    LXW_PUSH_ATTRIBUTES_STR("name", "PivotStyleLight16");
+    LXW_PUSH_ATTRIBUTES_STR("showRowHeaders", "1");
+    LXW_PUSH_ATTRIBUTES_STR("showColHeaders", "1");
+    LXW_PUSH_ATTRIBUTES_STR("showRowStripes", "0");
+    LXW_PUSH_ATTRIBUTES_STR("showColStripes", "0");
+    LXW_PUSH_ATTRIBUTES_STR("showLastColumn", "1");
+
+    lxw_xml_empty_tag(self->file, "pivotTableStyleInfo", &attributes);
+
+    LXW_FREE_ATTRIBUTES();
+}
+
+/*****************************************************************************
+ *
+ * XML file assembly functions.
+ *
+ ****************************************************************************/
+
+/*
+ * Assemble and write the pivotCacheDefinition XML file.
+ */
+void
+lxw_pivot_cache_assemble_xml_file(lxw_pivot_table *self)
+{
+    /* Write the XML declaration. */
+    _pivot_table_xml_declaration(self);
+
+    /* Write the pivotCacheDefinition element. */
+    _pivot_write_pivot_cache_definition(self);
+
+    /* Write the cacheSource element. */
+    _pivot_write_cache_source(self);
+
+    /* Write the cacheFields element. */
+    _pivot_write_cache_fields(self);
+
+    lxw_xml_end_tag(self->file, "pivotCacheDefinition");
+}
+
+/*
+ * Assemble and write the pivotCacheRecords XML file.
+ */
+void
+lxw_pivot_records_assemble_xml_file(lxw_pivot_table *self)
+{
+    /* Write the XML declaration. */
+    _pivot_table_xml_declaration(self);
+
+    /* Write the pivotCacheRecords element. */
+    _pivot_write_pivot_cache_records(self);
+
+    /* Write the r elements. */
+    _pivot_write_records(self);
+
+    lxw_xml_end_tag(self->file, "pivotCacheRecords");
+}
+
+/*
+ * Assemble and write the pivotTableDefinition XML file.
+ */
+void
+lxw_pivot_table_assemble_xml_file(lxw_pivot_table *self)
+{
+    uint8_t has_values_field = self->num_data_fields > 1;
+
+    /* Write the XML declaration. */
+    _pivot_table_xml_declaration(self);
+
+    /* Write the pivotTableDefinition element. */
+    _pivot_write_pivot_table_definition(self);
+
+    /* Write the location element. */
+    _pivot_write_location(self);
+
+    /* Write the pivotFields element. */
+    _pivot_write_pivot_fields(self);
+
+    /* Write the rowFields and rowItems elements. */
+    _pivot_write_axis_fields(self, "rowFields", self->row_fields,
+                             self->num_row_fields, LXW_FALSE);
+    _pivot_write_axis_items(self, "rowItems", self->row_fields,
+                            self->num_row_fields, 0);
+
+    /* Write the colFields and colItems elements. */
+    _pivot_write_axis_fields(self, "colFields", self->col_fields,
+                             self->num_col_fields, has_values_field);
+    _pivot_write_axis_items(self, "colItems", self->col_fields,
+                            self->num_col_fields, self->num_data_fields);
+
+    /* Write the dataFields element. */
+    _pivot_write_data_fields(self);
+
+    /* Write the pivotTableStyleInfo element. */
+    _pivot_write_pivot_table_style_info(self);
+
+    lxw_xml_end_tag(self->file, "pivotTableDefinition");
+}
+
+/*****************************************************************************
+ *
+ * Public functions.
+ *
+ ****************************************************************************/
@@ -197,28 +197,35 @@ _write_sst(lxw_sst *self)
  ****************************************************************************/
 
 /*
- * Assemble and write the XML file.
+ * Write the si elements for up to "count" strings, starting at "sst_element".
+ * A count of 0 writes all of the remaining strings. Returns the next string
+ * to write, or NULL once all of the strings are written.
  */
-STATIC void
-_write_sst_strings(lxw_sst *self)
+STATIC struct sst_element *
+_write_sst_strings(lxw_sst *self, struct sst_element *sst_element,
+                   uint32_t count)
 {
-    struct sst_element *sst_element;
+    uint32_t i = 0;
 
-    STAILQ_FOREACH(sst_element, self->order_list, sst_order_pointers) {
+    while (sst_element && (!count || i++ < count)) {
         /* Write the si element. */
         if (sst_element->is_rich_string)
             _write_rich_si(self, sst_element->string);
         else
             _write_si(self, sst_element->string);
 
+        sst_element = STAILQ_NEXT(sst_element, sst_order_pointers);
     }
+
+    return sst_element;
 }
 
 /*
- * Assemble and write the XML file.
+ * Write the start of the XML file for an incremental assembly. Returns the
+ * first string to write.
  */
-void
-lxw_sst_assemble_xml_file(lxw_sst *self)
+struct sst_element *
+lxw_sst_assemble_xml_start(lxw_sst *self)
 {
     /* Write the XML declaration. */
     _sst_xml_declaration(self);
@@ -226,13 +233,46 @@ lxw_sst_assemble_xml_file(lxw_sst *self)
     /* Write the sst element. */
     _write_sst(self);
 
-    /* Write the sst strings. */
-    _write_sst_strings(self);
+    return STAILQ_FIRST(self->order_list);
+}
+
+/*
+ * Write the next "count" strings of an incremental assembly. Returns the
+ * next string to write or NULL when there are no more strings.
+ */
+struct sst_element *
+lxw_sst_assemble_xml_strings(lxw_sst *self, struct sst_element *sst_element,
+                             uint32_t count)
+{
+    return _write_sst_strings(self, sst_element, count);
+}
 
+/*
+ * Write the end of the XML file for an incremental assembly.
+ */
+void
+lxw_sst_assemble_xml_end(lxw_sst *self)
+{
     /* Close the sst tag. */
     lxw_xml_end_tag(self->file, "sst");
 }
 
+/*
+ * Assemble and write the XML file.
+ */
+void
+lxw_sst_assemble_xml_file(lxw_sst *self)
+{
+    struct sst_element *sst_element;
+
+    sst_element = lxw_sst_assemble_xml_start(self);
+
+    /* Write the sst strings. */
+    _write_sst_strings(self, sst_element, 0);
+
+    lxw_sst_assemble_xml_end(self);
+}
+
 /*****************************************************************************
  *
  * Public functions.
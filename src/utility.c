@@ -13,6 +13,7 @@
 #endif
 
 #include <ctype.h>
+#include <locale.h>
 #include <stdio.h>
 #include <string.h>
 #include <stdint.h>
@@ -54,6 +55,7 @@ char *error_strings[LXW_MAX_ERRNO + 1] = {
     "Maximum hyperlink length (2079) exceeded.",
     "Maximum number of worksheet URLs (65530) exceeded.",
     "Couldn't read image dimensions or DPI.",
+    "Incremental workbook close isn't complete.",
     "Unknown error number."
 };
 
@@ -637,6 +639,163 @@ lxw_sprintf_dbl(char *data, double number)
 }
 #endif
 
+/*
+ * Convert a string with a "." decimal point to a double, independently of
+ * the locale. The decimal point is replaced with the one from the current
+ * locale since that is what strtod() expects.
+ */
+double
+lxw_strtod(const char *string, char **end)
+{
+    const char *decimal_point = localeconv()->decimal_point;
+    const char *point = strchr(string, '.');
+    size_t prefix_len;
+    size_t point_len;
+    char *buffer;
+    char *buffer_end;
+    double number;
+
+    if (!point || !decimal_point || strcmp(decimal_point, ".") == 0)
+        return strtod(string, end);
+
+    prefix_len = point - string;
+    point_len = strlen(decimal_point);
+
+    buffer = malloc(strlen(string) + point_len);
+    if (!buffer)
+        return strtod(string, end);
+
+    memcpy(buffer, string, prefix_len);
+    memcpy(buffer + prefix_len, decimal_point, point_len);
+    strcpy(buffer + prefix_len + point_len, point + 1);
+
+    number = strtod(buffer, &buffer_end);
+
+    /* Map the end of the number back to the original string. */
+    if (end) {
+        if ((size_t) (buffer_end - buffer) > prefix_len)
+            *end = (char *) string + (buffer_end - buffer) - point_len + 1;
+        else
+            *end = (char *) string + (buffer_end - buffer);
+    }
+
+    free(buffer);
+
+    return number;
+}
+
+/* Powers of ten that can be represented exactly as doubles. */
+static const double powers_of_ten[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+#define LXW_MAX_POWER_OF_TEN 22
+
+/*
+ * Round a scaled number to an integer, with ties rounded to even, and scale
+ * it back. Numbers larger than 2^52 have no fractional part and are returned
+ * unchanged. This avoids a dependency on the C math library.
+ */
+STATIC double
+_round_scaled_dbl(double number, int scale)
+{
+    double scaled;
+    double magnitude;
+    double fraction;
+    uint64_t integer;
+
+    if (scale >= 0)
+        scaled = number * powers_of_ten[scale];
+    else
+        scaled = number / powers_of_ten[-scale];
+
+    magnitude = scaled < 0 ? -scaled : scaled;
+
+    if (!(magnitude < 4503599627370496.0))
+        return number;
+
+    integer = (uint64_t) magnitude;
+    fraction = magnitude - (double) integer;
+
+    if (fraction > 0.5 || (fraction == 0.5 && (integer & 1)))
+        integer++;
+
+    magnitude = (double) integer;
+    scaled = scaled < 0 ? -magnitude : magnitude;
+
+    if (scale >= 0)
+        return scaled / powers_of_ten[scale];
+    else
+        return scaled * powers_of_ten[-scale];
+}
+
+/*
+ * Round a number to a number of significant digits or decimal places before
+ * it is written to a file. The scaling is done in binary floating point so
+ * the rounding of apparent halfway cases depends on the stored value. The
+ * result is scaled back with a single division or multiplication so the
+ * shortest representation of it is written.
+ */
+double
+lxw_round_dbl(double number, lxw_number_precision *precision)
+{
+    double magnitude;
+    int exponent = 0;
+    int scale;
+
+    if (!precision || precision->type == LXW_PRECISION_DEFAULT
+        || precision->type == LXW_PRECISION_FULL || number == 0.0)
+        return number;
+
+    if (precision->type == LXW_PRECISION_DECIMAL_PLACES) {
+        scale = precision->digits;
+    }
+    else {
+        magnitude = number < 0 ? -number : number;
+
+        /* Also excludes NaN and infinity. */
+        if (!(magnitude < powers_of_ten[LXW_MAX_POWER_OF_TEN]))
+            return number;
+
+        /* Find the decimal exponent of the number. */
+        if (magnitude >= 1.0) {
+            while (magnitude >= powers_of_ten[exponent + 1])
+                exponent++;
+        }
+        else {
+            while (exponent > -LXW_MAX_POWER_OF_TEN
+                   && magnitude * powers_of_ten[-exponent] < 1.0)
+                exponent--;
+        }
+
+        scale = precision->digits - 1 - exponent;
+    }
+
+    if (scale > LXW_MAX_POWER_OF_TEN || scale < -LXW_MAX_POWER_OF_TEN)
+        return number;
+
+    return _round_scaled_dbl(number, scale);
+}
+
+/*
+ * Check the precision type and number of digits for a number precision.
+ */
+lxw_error
+lxw_validate_number_precision(uint8_t type, uint8_t digits)
+{
+    if (type > LXW_PRECISION_DECIMAL_PLACES)
+        return LXW_ERROR_PARAMETER_VALIDATION;
+
+    if (digits > LXW_PRECISION_MAX_DIGITS)
+        return LXW_ERROR_PARAMETER_VALIDATION;
+
+    if (type == LXW_PRECISION_SIGNIFICANT_DIGITS && digits == 0)
+        return LXW_ERROR_PARAMETER_VALIDATION;
+
+    return LXW_NO_ERROR;
+}
+
 /*
  * Retrieve runtime library version.
  */
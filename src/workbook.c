@@ -280,11 +280,15 @@ lxw_workbook_free(lxw_workbook *workbook)
     lxw_hash_free(workbook->used_xf_formats);
     lxw_hash_free(workbook->used_dxf_formats);
     lxw_sst_free(workbook->sst);
+    lxw_url_table_free(workbook->url_table);
+    lxw_validation_lists_free(workbook->validation_lists);
+    lxw_packager_free(workbook->packager);
     free((void *) workbook->options.tmpdir);
     free(workbook->ordered_charts);
     free(workbook->vba_project);
     free(workbook->vba_project_signature);
     free(workbook->vba_codename);
+    free(workbook->checkpoint_dir);
     free(workbook);
 }
 
@@ -843,7 +847,7 @@ _populate_range_data_cache(lxw_workbook *self, lxw_series_range *range)
     lxw_row *row_obj;
     lxw_cell *cell_obj;
     struct lxw_series_data_point *data_point;
-    uint16_t num_data_points = 0;
+    uint32_t num_data_points = 0;
 
     /* If ignore_cache is set then don't try to populate the cache. This flag
      * may be set manually, for testing, or due to a case where the cache
@@ -897,13 +901,25 @@ _populate_range_data_cache(lxw_workbook *self, lxw_series_range *range)
                     data_point->number = cell_obj->u.number;
                 }
 
+                if (cell_obj->type == NUMBER_TEXT_CELL) {
+                    data_point->number = lxw_strtod(cell_obj->u.string, NULL);
+                }
+
+                /* Round the cached number like the cell. */
+                if (worksheet->col_precision)
+                    data_point->precision = worksheet->col_precision[col_num];
+
                 if (cell_obj->type == STRING_CELL) {
                     data_point->string = lxw_strdup(cell_obj->sst_string);
                     data_point->is_string = LXW_TRUE;
                     range->has_string_cache = LXW_TRUE;
                 }
             }
-            else {
+            else if (!lxw_worksheet_find_table_formula(worksheet, row_num,
+                                                       col_num)) {
+                /* Empty cells have no data. Table calculated column
+                 * formulas aren't stored as cells but are cached as 0 like
+                 * other formulas. */
                 data_point->no_data = LXW_TRUE;
             }
 
@@ -1054,6 +1070,499 @@ _add_chart_cache_data(lxw_workbook *self)
     }
 }
 
+/* Struct to hold the points selected from a downsampled chart series. */
+typedef struct lxw_chart_sample {
+    lxw_chart_series *series;
+    lxw_worksheet *values_sheet;
+    lxw_worksheet *categories_sheet;
+    uint32_t *offsets;
+    uint32_t num_points;
+} lxw_chart_sample;
+
+/*
+ * Select the points of a large chart series to plot using the
+ * Largest-Triangle-Three-Buckets algorithm. The first and last points are
+ * always kept and the point from each bucket in between that forms the
+ * largest triangle with the previous selected point and the average of the
+ * next bucket is selected. Returns the number of indices stored.
+ */
+STATIC uint32_t
+_chart_downsample_lttb(double *x, double *y, uint32_t num_points,
+                       uint32_t *indices, uint32_t max_points)
+{
+    double bucket_size = (double) (num_points - 2) / (max_points - 2);
+    double avg_x;
+    double avg_y;
+    double area;
+    double max_area;
+    uint32_t previous = 0;
+    uint32_t count = 0;
+    uint32_t bucket;
+    uint32_t start;
+    uint32_t end;
+    uint32_t next_end;
+    uint32_t i;
+
+    indices[count++] = 0;
+
+    for (bucket = 0; bucket < max_points - 2; bucket++) {
+        start = (uint32_t) (bucket * bucket_size) + 1;
+        end = (uint32_t) ((bucket + 1) * bucket_size) + 1;
+        next_end = (uint32_t) ((bucket + 2) * bucket_size) + 1;
+
+        if (end > num_points - 1)
+            end = num_points - 1;
+
+        if (next_end > num_points || next_end <= end)
+            next_end = num_points;
+
+        /* Get the average point of the next bucket. */
+        avg_x = 0;
+        avg_y = 0;
+        for (i = end; i < next_end; i++) {
+            avg_x += x[i];
+            avg_y += y[i];
+        }
+        avg_x /= next_end - end;
+        avg_y /= next_end - end;
+
+        /* Find the point in this bucket with the largest triangle area. */
+        max_area = -1;
+        for (i = start; i < end; i++) {
+            area = (x[previous] - avg_x) * (y[i] - y[previous])
+                - (x[previous] - x[i]) * (avg_y - y[previous]);
+
+            if (area < 0)
+                area = -area;
+
+            if (area > max_area) {
+                max_area = area;
+                indices[count] = i;
+            }
+        }
+
+        previous = indices[count++];
+    }
+
+    indices[count++] = num_points - 1;
+
+    return count;
+}
+
+/*
+ * Select the points of a large chart series to plot by keeping the minimum
+ * and maximum values in each bucket, in their original order. Returns the
+ * number of indices stored.
+ */
+STATIC uint32_t
+_chart_downsample_min_max(double *y, uint32_t num_points,
+                          uint32_t *indices, uint32_t max_points)
+{
+    uint32_t num_buckets = max_points / 2;
+    double bucket_size = (double) num_points / num_buckets;
+    uint32_t count = 0;
+    uint32_t bucket;
+    uint32_t start;
+    uint32_t end;
+    uint32_t min;
+    uint32_t max;
+    uint32_t i;
+
+    for (bucket = 0; bucket < num_buckets; bucket++) {
+        start = (uint32_t) (bucket * bucket_size);
+
+        if (bucket == num_buckets - 1)
+            end = num_points;
+        else
+            end = (uint32_t) ((bucket + 1) * bucket_size);
+
+        min = start;
+        max = start;
+        for (i = start + 1; i < end; i++) {
+            if (y[i] < y[min])
+                min = i;
+            if (y[i] > y[max])
+                max = i;
+        }
+
+        if (min < max) {
+            indices[count++] = min;
+            indices[count++] = max;
+        }
+        else if (min > max) {
+            indices[count++] = max;
+            indices[count++] = min;
+        }
+        else {
+            indices[count++] = min;
+        }
+    }
+
+    return count;
+}
+
+/*
+ * Get the number of points in a single row or column chart range, or 0 for
+ * a 2D range.
+ */
+STATIC uint32_t
+_chart_range_length(lxw_series_range *range)
+{
+    if (range->first_col == range->last_col)
+        return range->last_row - range->first_row + 1;
+
+    if (range->first_row == range->last_row)
+        return range->last_col - range->first_col + 1;
+
+    return 0;
+}
+
+/*
+ * Get the value of the cell at an offset in a single row or column chart
+ * range.
+ */
+STATIC void
+_chart_range_cell(lxw_worksheet *worksheet, lxw_series_range *range,
+                  uint32_t offset, lxw_cell_value *value)
+{
+    if (range->first_col == range->last_col)
+        worksheet_get_cell(worksheet, range->first_row + offset,
+                           range->first_col, value);
+    else
+        worksheet_get_cell(worksheet, range->first_row,
+                           range->first_col + offset, value);
+}
+
+/*
+ * Get the worksheet of a chart range if the data can be read back from it.
+ */
+STATIC lxw_worksheet *
+_chart_range_worksheet(lxw_workbook *self, lxw_series_range *range)
+{
+    lxw_worksheet *worksheet;
+
+    _populate_range_dimensions(self, range);
+
+    if (range->ignore_cache)
+        return NULL;
+
+    worksheet = workbook_get_worksheet_by_name(self, range->sheetname);
+
+    /* We can't read the data when worksheet optimization is on. */
+    if (!worksheet || worksheet->optimize)
+        return NULL;
+
+    return worksheet;
+}
+
+/*
+ * Select the points to plot for a series with a downsample method. The
+ * sample is left empty if the series can't be, or doesn't need to be,
+ * downsampled.
+ */
+STATIC lxw_error
+_downsample_chart_series(lxw_workbook *self, lxw_chart_series *series,
+                         lxw_chart_sample *sample)
+{
+    lxw_series_range *values = series->values;
+    lxw_series_range *categories = series->categories;
+    lxw_worksheet *values_sheet;
+    lxw_worksheet *categories_sheet = NULL;
+    lxw_cell_value value;
+    double *x = NULL;
+    double *y = NULL;
+    uint32_t *offsets = NULL;
+    uint32_t *indices = NULL;
+    uint32_t num_points;
+    uint32_t count = 0;
+    uint32_t i;
+
+    values_sheet = _chart_range_worksheet(self, values);
+    if (!values_sheet)
+        return LXW_NO_ERROR;
+
+    num_points = _chart_range_length(values);
+    if (num_points <= series->downsample_points)
+        return LXW_NO_ERROR;
+
+    /* The categories must match the values point for point. */
+    if (categories->formula || categories->sheetname) {
+        categories_sheet = _chart_range_worksheet(self, categories);
+
+        if (!categories_sheet
+            || _chart_range_length(categories) != num_points)
+            return LXW_NO_ERROR;
+    }
+
+    x = calloc(num_points, sizeof(double));
+    GOTO_LABEL_ON_MEM_ERROR(x, mem_error);
+
+    y = calloc(num_points, sizeof(double));
+    GOTO_LABEL_ON_MEM_ERROR(y, mem_error);
+
+    offsets = calloc(num_points, sizeof(uint32_t));
+    GOTO_LABEL_ON_MEM_ERROR(offsets, mem_error);
+
+    /* Read the numeric points. Non-numeric categories are plotted in order
+     * so their position is used as the x value. Formula results aren't
+     * known until Excel recalculates so series with formulas are left
+     * unchanged. */
+    for (i = 0; i < num_points; i++) {
+        _chart_range_cell(values_sheet, values, i, &value);
+        if (value.type == LXW_CELL_VALUE_FORMULA)
+            goto done;
+
+        if (value.type != LXW_CELL_VALUE_NUMBER)
+            continue;
+
+        y[count] = value.number;
+        x[count] = i;
+        offsets[count] = i;
+
+        if (categories_sheet) {
+            _chart_range_cell(categories_sheet, categories, i, &value);
+            if (value.type == LXW_CELL_VALUE_FORMULA)
+                goto done;
+
+            if (value.type == LXW_CELL_VALUE_NUMBER)
+                x[count] = value.number;
+        }
+
+        count++;
+    }
+
+    if (count <= series->downsample_points)
+        goto done;
+
+    indices = calloc(series->downsample_points, sizeof(uint32_t));
+    GOTO_LABEL_ON_MEM_ERROR(indices, mem_error);
+
+    if (series->downsample == LXW_CHART_DOWNSAMPLE_LTTB)
+        count = _chart_downsample_lttb(x, y, count, indices,
+                                       series->downsample_points);
+    else
+        count = _chart_downsample_min_max(y, count, indices,
+                                          series->downsample_points);
+
+    /* Convert the selected points back to offsets in the ranges. */
+    for (i = 0; i < count; i++)
+        indices[i] = offsets[indices[i]];
+
+    sample->series = series;
+    sample->values_sheet = values_sheet;
+    sample->categories_sheet = categories_sheet;
+    sample->offsets = indices;
+    sample->num_points = count;
+
+done:
+    free(x);
+    free(y);
+    free(offsets);
+    return LXW_NO_ERROR;
+
+mem_error:
+    free(x);
+    free(y);
+    free(offsets);
+    return LXW_ERROR_MEMORY_MALLOC_FAILED;
+}
+
+/*
+ * Point a downsampled chart range at its column in the helper worksheet.
+ */
+STATIC lxw_error
+_set_downsampled_range(lxw_series_range *range, lxw_worksheet *worksheet,
+                       lxw_col_t col, uint32_t num_points)
+{
+    char formula[LXW_MAX_FORMULA_RANGE_LENGTH] = { 0 };
+
+    lxw_rowcol_to_formula_abs(formula, worksheet->name,
+                              0, col, num_points - 1, col);
+
+    free(range->formula);
+    free(range->sheetname);
+
+    range->formula = lxw_strdup(formula);
+    range->sheetname = lxw_strdup(worksheet->name);
+    range->first_row = 0;
+    range->first_col = col;
+    range->last_row = num_points - 1;
+    range->last_col = col;
+
+    if (!range->formula || !range->sheetname)
+        return LXW_ERROR_MEMORY_MALLOC_FAILED;
+
+    return LXW_NO_ERROR;
+}
+
+/*
+ * Check if the series of a chart can be downsampled. Stacked line charts and
+ * other chart types are plotted per category so the series have to keep all
+ * of their points.
+ */
+STATIC uint8_t
+_chart_can_downsample(lxw_chart *chart)
+{
+    switch (chart->type) {
+        case LXW_CHART_LINE:
+        case LXW_CHART_SCATTER:
+        case LXW_CHART_SCATTER_STRAIGHT:
+        case LXW_CHART_SCATTER_STRAIGHT_WITH_MARKERS:
+        case LXW_CHART_SCATTER_SMOOTH:
+        case LXW_CHART_SCATTER_SMOOTH_WITH_MARKERS:
+            return LXW_TRUE;
+        default:
+            return LXW_FALSE;
+    }
+}
+
+/*
+ * Store the selected points of chart series that have a downsample method
+ * in a hidden worksheet, with a category and value column per series, and
+ * point the series at the reduced ranges. The chart caches are then
+ * populated from the reduced data in the usual way.
+ */
+STATIC lxw_error
+_prepare_chart_downsampling(lxw_workbook *self)
+{
+    lxw_chart *chart;
+    lxw_chart_series *series;
+    lxw_chart_sample *samples = NULL;
+    lxw_chart_sample *sample;
+    lxw_worksheet *worksheet;
+    lxw_cell_value value;
+    uint32_t num_series = 0;
+    uint32_t num_samples = 0;
+    uint32_t max_points = 0;
+    uint32_t offset;
+    uint32_t i;
+    lxw_row_t row;
+    lxw_col_t col;
+    lxw_error error = LXW_NO_ERROR;
+
+    STAILQ_FOREACH(chart, self->charts, list_pointers) {
+        STAILQ_FOREACH(series, chart->series_list, list_pointers) {
+            if (!series->downsample)
+                continue;
+
+            if (!_chart_can_downsample(chart)) {
+                LXW_WARN("workbook_close(): chart series downsampling is "
+                         "only supported for line and scatter charts.");
+                series->downsample = LXW_CHART_DOWNSAMPLE_NONE;
+                continue;
+            }
+
+            num_series++;
+        }
+    }
+
+    if (!num_series)
+        return LXW_NO_ERROR;
+
+    samples = calloc(num_series, sizeof(lxw_chart_sample));
+    RETURN_ON_MEM_ERROR(samples, LXW_ERROR_MEMORY_MALLOC_FAILED);
+
+    STAILQ_FOREACH(chart, self->charts, list_pointers) {
+        STAILQ_FOREACH(series, chart->series_list, list_pointers) {
+            if (!series->downsample || num_samples >= LXW_COL_MAX / 2)
+                continue;
+
+            sample = &samples[num_samples];
+
+            error = _downsample_chart_series(self, series, sample);
+            if (error)
+                goto done;
+
+            if (!sample->num_points)
+                continue;
+
+            if (sample->num_points > max_points)
+                max_points = sample->num_points;
+
+            num_samples++;
+        }
+    }
+
+    if (!num_samples)
+        goto done;
+
+    worksheet = workbook_add_worksheet(self, "_ChartData");
+    if (!worksheet) {
+        LXW_WARN("workbook_close(): "
+                 "couldn't add the '_ChartData' worksheet.");
+        error = LXW_ERROR_SHEETNAME_ALREADY_USED;
+        goto done;
+    }
+
+    worksheet_hide(worksheet);
+
+    /* Write the points in row order, so that the worksheet can also be
+     * written in constant_memory mode. Series without categories get the
+     * position of the point in the original series as the category. */
+    for (row = 0; row < max_points; row++) {
+        for (i = 0; i < num_samples; i++) {
+            sample = &samples[i];
+            col = (lxw_col_t) (i * 2);
+
+            if (row >= sample->num_points)
+                continue;
+
+            offset = sample->offsets[row];
+
+            if (sample->categories_sheet) {
+                _chart_range_cell(sample->categories_sheet,
+                                  sample->series->categories, offset, &value);
+
+                if (value.type == LXW_CELL_VALUE_NUMBER)
+                    error = worksheet_write_number(worksheet, row, col,
+                                                   value.number,
+                                                   value.format);
+                else if (value.type == LXW_CELL_VALUE_STRING)
+                    error = worksheet_write_string(worksheet, row, col,
+                                                   value.string,
+                                                   value.format);
+            }
+            else {
+                error = worksheet_write_number(worksheet, row, col,
+                                               offset + 1, NULL);
+            }
+
+            if (error)
+                goto done;
+
+            _chart_range_cell(sample->values_sheet, sample->series->values,
+                              offset, &value);
+
+            error = worksheet_write_number(worksheet, row, col + 1,
+                                           value.number, value.format);
+            if (error)
+                goto done;
+        }
+    }
+
+    for (i = 0; i < num_samples; i++) {
+        sample = &samples[i];
+        col = (lxw_col_t) (i * 2);
+
+        error = _set_downsampled_range(sample->series->categories, worksheet,
+                                       col, sample->num_points);
+        if (error)
+            goto done;
+
+        error = _set_downsampled_range(sample->series->values, worksheet,
+                                       col + 1, sample->num_points);
+        if (error)
+            goto done;
+    }
+
+done:
+    for (i = 0; i < num_series; i++)
+        free(samples[i].offsets);
+
+    free(samples);
+    return error;
+}
+
 /*
  * Store the image types used in the workbook to update the content types.
  */
@@ -1491,6 +2000,154 @@ _prepare_defined_names(lxw_workbook *self)
     }
 }
 
+/*
+ * Get the quoted CSV formula for a data validation list that is stored in
+ * the data validation itself.
+ */
+STATIC char *
+_validation_list_formula(lxw_validation_list *list)
+{
+    /* Allow for the quotes and the commas in place of the NULs. */
+    char *formula = calloc(1, list->data_size + 3);
+    char *data = list->data;
+    uint32_t i;
+
+    RETURN_ON_MEM_ERROR(formula, NULL);
+
+    strcat(formula, "\"");
+
+    for (i = 0; i < list->num_items; i++) {
+        if (i > 0)
+            strcat(formula, ",");
+
+        strcat(formula, data);
+        data += strlen(data) + 1;
+    }
+
+    strcat(formula, "\"");
+
+    return formula;
+}
+
+/*
+ * Store the shared data validation lists that are repeated, or that are too
+ * long for Excel, in a hidden worksheet with a hidden defined name for each
+ * list. The other lists are stored as CSV strings in the validation.
+ */
+STATIC lxw_error
+_prepare_validation_lists(lxw_workbook *self)
+{
+    lxw_worksheet *worksheet;
+    lxw_validation_list *list;
+    lxw_validation_list **sheet_lists = NULL;
+    char **cursors = NULL;
+    char name[LXW_DEFINED_NAME_LENGTH];
+    char range[LXW_MAX_FORMULA_RANGE_LENGTH];
+    uint32_t num_lists = 0;
+    uint32_t max_items = 0;
+    lxw_row_t row;
+    lxw_col_t col;
+    lxw_error error = LXW_NO_ERROR;
+
+    if (!self->validation_lists || !self->validation_lists->count)
+        return LXW_NO_ERROR;
+
+    sheet_lists = calloc(self->validation_lists->count,
+                         sizeof(lxw_validation_list *));
+    GOTO_LABEL_ON_MEM_ERROR(sheet_lists, mem_error);
+
+    STAILQ_FOREACH(list, &self->validation_lists->lists, list_pointers) {
+        if (list->num_items
+            && num_lists < LXW_COL_MAX && list->num_items <= LXW_ROW_MAX
+            && (list->use_count > 1
+                || list->length > LXW_VALIDATION_MAX_STRING_LENGTH)) {
+
+            sheet_lists[num_lists++] = list;
+
+            if (list->num_items > max_items)
+                max_items = list->num_items;
+        }
+        else {
+            /* Lists that are too long can't be stored in the validation. */
+            if (list->length > LXW_VALIDATION_MAX_STRING_LENGTH) {
+                LXW_WARN_FORMAT1("workbook_close(): data validation list "
+                                 "length with commas > Excel limit of %d "
+                                 "and can't be stored in the "
+                                 "'_ValidationLists' worksheet.",
+                                 LXW_VALIDATION_MAX_STRING_LENGTH);
+                error = LXW_ERROR_PARAMETER_VALIDATION;
+                goto done;
+            }
+
+            list->formula = _validation_list_formula(list);
+            GOTO_LABEL_ON_MEM_ERROR(list->formula, mem_error);
+        }
+    }
+
+    if (!num_lists)
+        goto done;
+
+    worksheet = workbook_add_worksheet(self, "_ValidationLists");
+    if (!worksheet) {
+        LXW_WARN("workbook_close(): "
+                 "couldn't add the '_ValidationLists' worksheet.");
+        error = LXW_ERROR_SHEETNAME_ALREADY_USED;
+        goto done;
+    }
+
+    worksheet_hide(worksheet);
+
+    /* Write the lists in row order, one list per column, so that the
+     * worksheet can also be written in constant_memory mode. */
+    cursors = calloc(num_lists, sizeof(char *));
+    GOTO_LABEL_ON_MEM_ERROR(cursors, mem_error);
+
+    for (col = 0; col < num_lists; col++)
+        cursors[col] = sheet_lists[col]->data;
+
+    for (row = 0; row < max_items; row++) {
+        for (col = 0; col < num_lists; col++) {
+            if (row >= sheet_lists[col]->num_items)
+                continue;
+
+            error = worksheet_write_string(worksheet, row, col, cursors[col],
+                                           NULL);
+            if (error)
+                goto done;
+
+            cursors[col] += strlen(cursors[col]) + 1;
+        }
+    }
+
+    /* Add a hidden defined name to refer to each list range. */
+    for (col = 0; col < num_lists; col++) {
+        list = sheet_lists[col];
+
+        lxw_snprintf(name, LXW_DEFINED_NAME_LENGTH, "_ValidationList%d",
+                     col + 1);
+
+        lxw_rowcol_to_formula_abs(range, worksheet->name, 0, col,
+                                  list->num_items - 1, col);
+
+        error = _store_defined_name(self, name, NULL, range, -1, LXW_TRUE);
+        if (error)
+            goto done;
+
+        list->formula = lxw_strdup(name);
+        GOTO_LABEL_ON_MEM_ERROR(list->formula, mem_error);
+    }
+
+    goto done;
+
+mem_error:
+    error = LXW_ERROR_MEMORY_MALLOC_FAILED;
+
+done:
+    free(cursors);
+    free(sheet_lists);
+    return error;
+}
+
 /*
  * Iterate through the worksheets and set up the table objects.
  */
@@ -1519,6 +2176,34 @@ _prepare_tables(lxw_workbook *self)
     }
 }
 
+/*
+ * Iterate through the worksheets and set up the pivot table objects. Each
+ * pivot table has its own pivot cache with the same id.
+ */
+STATIC void
+_prepare_pivot_tables(lxw_workbook *self)
+{
+    lxw_worksheet *worksheet;
+    lxw_sheet *sheet;
+
+    self->pivot_table_count = 0;
+
+    STAILQ_FOREACH(sheet, self->sheets, list_pointers) {
+        if (sheet->is_chartsheet)
+            continue;
+        else
+            worksheet = sheet->u.worksheet;
+
+        if (worksheet->pivot_table_count == 0)
+            continue;
+
+        lxw_worksheet_prepare_pivot_tables(worksheet,
+                                           self->pivot_table_count + 1);
+
+        self->pivot_table_count += worksheet->pivot_table_count;
+    }
+}
+
 /*****************************************************************************
  *
  * XML functions.
@@ -1737,10 +2422,42 @@ _write_calc_pr(lxw_workbook *self)
 }
 
 /*
- * Write the <definedName> element.
+ * Write the <pivotCaches> element. The pivot cache relationships follow the
+ * sheet relationships in the workbook rels file.
  */
 STATIC void
-_write_defined_name(lxw_workbook *self, lxw_defined_name *defined_name)
+_write_pivot_caches(lxw_workbook *self)
+{
+    struct xml_attribute_list attributes;
+    struct xml_attribute *attribute;
+    char r_id[LXW_MAX_ATTRIBUTE_LENGTH];
+    uint16_t i;
+
+    if (!self->pivot_table_count)
+        return;
+
+    lxw_xml_start_tag(self->file, "pivotCaches", NULL);
+
+    for (i = 1; i <= self->pivot_table_count; i++) {
+        lxw_snprintf(r_id, LXW_ATTR_32, "rId%d", self->num_sheets + i);
+
+        LXW_INIT_ATTRIBUTES();
+        LXW_PUSH_ATTRIBUTES_INT("cacheId", i);
+        LXW_PUSH_ATTRIBUTES_STR("r:id", r_id);
+
+        lxw_xml_empty_tag(self->file, "pivotCache", &attributes);
+
+        LXW_FREE_ATTRIBUTES();
+    }
+
+    lxw_xml_end_tag(self->file, "pivotCaches");
+}
+
+/*
+ * Write the <definedName> element.
+ */
+STATIC void
+_write_defined_name(lxw_workbook *self, lxw_defined_name *defined_name)
 {
     struct xml_attribute_list attributes;
     struct xml_attribute *attribute;
@@ -1819,6 +2536,9 @@ lxw_workbook_assemble_xml_file(lxw_workbook *self)
     /* Write the workbook calculation properties. */
     _write_calc_pr(self);
 
+    /* Write the pivot cache ids. */
+    _write_pivot_caches(self);
+
     /* Close the workbook tag. */
     lxw_xml_end_tag(self->file, "workbook");
 }
@@ -1875,6 +2595,7 @@ workbook_new_opt(const char *filename, lxw_workbook_options *options)
     workbook->worksheets = calloc(1, sizeof(struct lxw_worksheets));
     GOTO_LABEL_ON_MEM_ERROR(workbook->worksheets, mem_error);
     STAILQ_INIT(workbook->worksheets);
+    TAILQ_INIT(&workbook->residency.resident);
 
     /* Add the chartsheets list. */
     workbook->chartsheets = calloc(1, sizeof(struct lxw_chartsheets));
@@ -1936,6 +2657,10 @@ workbook_new_opt(const char *filename, lxw_workbook_options *options)
     workbook->sst = lxw_sst_new();
     GOTO_LABEL_ON_MEM_ERROR(workbook->sst, mem_error);
 
+    /* Add the hyperlink url table. */
+    workbook->url_table = lxw_url_table_new();
+    GOTO_LABEL_ON_MEM_ERROR(workbook->url_table, mem_error);
+
     /* Add the default workbook properties. */
     workbook->properties = calloc(1, sizeof(lxw_doc_properties));
     GOTO_LABEL_ON_MEM_ERROR(workbook->properties, mem_error);
@@ -1957,6 +2682,7 @@ workbook_new_opt(const char *filename, lxw_workbook_options *options)
     /* Add the default cell format. */
     format = workbook_add_format(workbook);
     GOTO_LABEL_ON_MEM_ERROR(format, mem_error);
+    workbook->num_default_formats++;
 
     /* Initialize its index. */
     lxw_format_get_xf_index(format);
@@ -1964,6 +2690,7 @@ workbook_new_opt(const char *filename, lxw_workbook_options *options)
     /* Add the default hyperlink format. */
     format = workbook_add_format(workbook);
     GOTO_LABEL_ON_MEM_ERROR(format, mem_error);
+    workbook->num_default_formats++;
     format_set_hyperlink(format);
     workbook->default_url_format = format;
 
@@ -1973,6 +2700,16 @@ workbook_new_opt(const char *filename, lxw_workbook_options *options)
         workbook->options.use_zip64 = options->use_zip64;
         workbook->options.output_buffer = options->output_buffer;
         workbook->options.output_buffer_size = options->output_buffer_size;
+        workbook->options.minimal_package = options->minimal_package;
+        workbook->options.binary_tmpfile = options->binary_tmpfile;
+        workbook->options.validation_list_sheet =
+            options->validation_list_sheet;
+    }
+
+    /* Add the table of data validation lists shared between worksheets. */
+    if (workbook->options.validation_list_sheet) {
+        workbook->validation_lists = lxw_validation_lists_new();
+        GOTO_LABEL_ON_MEM_ERROR(workbook->validation_lists, mem_error);
     }
 
     workbook->max_url_length = 2079;
@@ -1987,6 +2724,56 @@ mem_error:
     return NULL;
 }
 
+/*
+ * Get the path of a file in the workbook checkpoint directory.
+ */
+STATIC char *
+_checkpoint_path(lxw_workbook *self, const char *name)
+{
+    size_t length = strlen(self->checkpoint_dir) + strlen(name) + 2;
+    char *path = malloc(length);
+    RETURN_ON_MEM_ERROR(path, NULL);
+
+    lxw_snprintf(path, length, "%s/%s", self->checkpoint_dir, name);
+
+    return path;
+}
+
+/*
+ * Get the path of the row file of a worksheet in the checkpoint directory.
+ */
+STATIC char *
+_checkpoint_sheet_path(lxw_workbook *self, uint16_t index)
+{
+    char name[LXW_ATTR_32];
+
+    lxw_snprintf(name, LXW_ATTR_32, "sheet%d.rows", index + 1);
+
+    return _checkpoint_path(self, name);
+}
+
+/*
+ * Delete the checkpoint files after the workbook has been closed.
+ */
+STATIC void
+_remove_checkpoint_files(lxw_workbook *self)
+{
+    lxw_worksheet *worksheet;
+    char *path;
+
+    STAILQ_FOREACH(worksheet, self->worksheets, list_pointers) {
+        path = _checkpoint_sheet_path(self, worksheet->index);
+        if (path)
+            remove(path);
+        free(path);
+    }
+
+    path = _checkpoint_path(self, "checkpoint");
+    if (path)
+        remove(path);
+    free(path);
+}
+
 /*
  * Add a new worksheet to the Excel workbook.
  */
@@ -1997,9 +2784,9 @@ workbook_add_worksheet(lxw_workbook *self, const char *sheetname)
     lxw_worksheet *worksheet = NULL;
     lxw_worksheet_name *worksheet_name = NULL;
     lxw_error error;
-    lxw_worksheet_init_data init_data =
-        { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+    lxw_worksheet_init_data init_data = { 0 };
     char *new_name = NULL;
+    char *checkpoint_path;
 
     if (sheetname) {
         /* Use the user supplied name. */
@@ -2034,16 +2821,41 @@ workbook_add_worksheet(lxw_workbook *self, const char *sheetname)
     init_data.index = self->num_sheets;
     init_data.sst = self->sst;
     init_data.optimize = self->options.constant_memory;
+    init_data.binary_tmpfile = self->options.binary_tmpfile;
     init_data.active_sheet = &self->active_sheet;
     init_data.first_sheet = &self->first_sheet;
     init_data.tmpdir = self->options.tmpdir;
     init_data.default_url_format = self->default_url_format;
     init_data.max_url_length = self->max_url_length;
     init_data.use_1904_epoch = self->use_1904_epoch;
+    init_data.url_table = self->url_table;
+    init_data.validation_lists = self->validation_lists;
+    init_data.formats = self->formats;
+    init_data.num_default_formats = self->num_default_formats;
+    init_data.number_precision = &self->number_precision;
+
+    if (!self->options.constant_memory)
+        init_data.residency = &self->residency;
 
     /* Create a new worksheet object. */
     worksheet = lxw_worksheet_new(&init_data);
     GOTO_LABEL_ON_MEM_ERROR(worksheet, mem_error);
+    worksheet->workbook = self;
+
+    /* Store the constant_memory rows in the checkpoint directory. */
+    if (self->checkpoint_dir) {
+        checkpoint_path = _checkpoint_sheet_path(self, init_data.index);
+        GOTO_LABEL_ON_MEM_ERROR(checkpoint_path, mem_error);
+
+        error = lxw_worksheet_set_checkpoint_file(worksheet, checkpoint_path);
+        free(checkpoint_path);
+
+        if (error) {
+            lxw_worksheet_free(worksheet);
+            worksheet = NULL;
+            goto mem_error;
+        }
+    }
 
     /* Add it to the worksheet list. */
     self->num_worksheets++;
@@ -2083,8 +2895,7 @@ workbook_add_chartsheet(lxw_workbook *self, const char *sheetname)
     lxw_chartsheet *chartsheet = NULL;
     lxw_chartsheet_name *chartsheet_name = NULL;
     lxw_error error;
-    lxw_worksheet_init_data init_data =
-        { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+    lxw_worksheet_init_data init_data = { 0 };
     char *new_name = NULL;
 
     if (sheetname) {
@@ -2169,8 +2980,10 @@ workbook_add_chart(lxw_workbook *self, uint8_t type)
     /* Create a new chart object. */
     chart = lxw_chart_new(type);
 
-    if (chart)
+    if (chart) {
+        chart->number_precision = &self->number_precision;
         STAILQ_INSERT_TAIL(self->charts, chart, list_pointers);
+    }
 
     return chart;
 }
@@ -2194,11 +3007,100 @@ workbook_add_format(lxw_workbook *self)
     return format;
 }
 
+/*
+ * Report any packaging errors and free the workbook at the end of a close.
+ */
+STATIC lxw_error
+_workbook_close_finish(lxw_workbook *self, lxw_error error)
+{
+    lxw_packager *packager = self->packager;
+
+    if (!self->filename) {
+        *self->options.output_buffer = packager->output_buffer;
+        *self->options.output_buffer_size = packager->output_buffer_size;
+    }
+
+    /* Error and non-error conditions fall through to the cleanup code. */
+    if (error == LXW_ERROR_CREATING_TMPFILE) {
+        LXW_PRINTF(LXW_STDERR "[ERROR] workbook_close(): "
+                   "Error creating tmpfile(s) to assemble '%s'. "
+                   "System error = %s\n", self->filename, strerror(errno));
+    }
+
+    /* If LXW_ERROR_ZIP_FILE_OPERATION then errno is set by zip. */
+    if (error == LXW_ERROR_ZIP_FILE_OPERATION) {
+        LXW_PRINTF(LXW_STDERR "[ERROR] workbook_close(): "
+                   "Zip ZIP_ERRNO error while creating xlsx file '%s'. "
+                   "System error = %s\n", self->filename, strerror(errno));
+    }
+
+    /* If LXW_ERROR_ZIP_PARAMETER_ERROR then errno is set by zip. */
+    if (error == LXW_ERROR_ZIP_PARAMETER_ERROR) {
+        LXW_PRINTF(LXW_STDERR "[ERROR] workbook_close(): "
+                   "Zip ZIP_PARAMERROR error while creating xlsx file '%s'. "
+                   "System error = %s\n", self->filename, strerror(errno));
+    }
+
+    /* If LXW_ERROR_ZIP_BAD_ZIP_FILE then errno is set by zip. */
+    if (error == LXW_ERROR_ZIP_BAD_ZIP_FILE) {
+        LXW_PRINTF(LXW_STDERR "[ERROR] workbook_close(): "
+                   "Zip ZIP_BADZIPFILE error while creating xlsx file '%s'. "
+                   "This may require the use_zip64 option for large files. "
+                   "System error = %s\n", self->filename, strerror(errno));
+    }
+
+    /* If LXW_ERROR_ZIP_INTERNAL_ERROR then errno is set by zip. */
+    if (error == LXW_ERROR_ZIP_INTERNAL_ERROR) {
+        LXW_PRINTF(LXW_STDERR "[ERROR] workbook_close(): "
+                   "Zip ZIP_INTERNALERROR error while creating xlsx file '%s'. "
+                   "System error = %s\n", self->filename, strerror(errno));
+    }
+
+    /* The next 2 error conditions don't set errno. */
+    if (error == LXW_ERROR_ZIP_FILE_ADD) {
+        LXW_PRINTF(LXW_STDERR "[ERROR] workbook_close(): "
+                   "Zip error adding file to xlsx file '%s'.\n",
+                   self->filename);
+    }
+
+    if (error == LXW_ERROR_ZIP_CLOSE) {
+        LXW_PRINTF(LXW_STDERR "[ERROR] workbook_close(): "
+                   "Zip error closing xlsx file '%s'.\n", self->filename);
+    }
+
+    /* The checkpoint files aren't needed once the file has been written. */
+    if (!error && self->checkpoint_dir)
+        _remove_checkpoint_files(self);
+
+    lxw_workbook_free(self);
+    return error;
+}
+
 /*
  * Call finalization code and close file.
  */
 lxw_error
 workbook_close(lxw_workbook *self)
+{
+    lxw_error error;
+
+    error = workbook_close_begin(self);
+    if (error)
+        return error;
+
+    do {
+        error = workbook_close_step(self, 0);
+    } while (error == LXW_CLOSE_IN_PROGRESS);
+
+    return error;
+}
+
+/*
+ * Start an incremental close. Run the finalization code and create the
+ * packager used by workbook_close_step() to write the file.
+ */
+lxw_error
+workbook_close_begin(lxw_workbook *self)
 {
     lxw_sheet *sheet = NULL;
     lxw_worksheet *worksheet = NULL;
@@ -2206,10 +3108,25 @@ workbook_close(lxw_workbook *self)
     lxw_error error = LXW_NO_ERROR;
     char codename[LXW_MAX_SHEETNAME_LENGTH] = { 0 };
 
+    if (self->packager) {
+        LXW_WARN("workbook_close_begin(): close has already been started.");
+        return LXW_ERROR_PARAMETER_VALIDATION;
+    }
+
     /* Add a default worksheet if non have been added. */
     if (!self->num_sheets)
         workbook_add_worksheet(self, NULL);
 
+    /* Store the shared data validation lists. */
+    error = _prepare_validation_lists(self);
+    if (error)
+        return error;
+
+    /* Store the reduced data of any downsampled chart series. */
+    error = _prepare_chart_downsampling(self);
+    if (error)
+        return error;
+
     /* Ensure that at least one worksheet has been selected. */
     if (self->active_sheet == 0) {
         sheet = STAILQ_FIRST(self->sheets);
@@ -2230,6 +3147,15 @@ workbook_close(lxw_workbook *self)
         if (worksheet->index == self->active_sheet)
             worksheet->active = LXW_TRUE;
 
+        /* Add the data and properties of any row segments. */
+        lxw_worksheet_close_segments(worksheet);
+
+        /* Hide the rows that don't match the autofilter rules. */
+        lxw_worksheet_prepare_filtered_rows(worksheet);
+
+        /* Apply the static conditional formats to the cell formats. */
+        lxw_worksheet_bake_conditional_formats(worksheet);
+
         if (worksheet->has_dynamic_functions) {
             self->has_metadata = LXW_TRUE;
             self->has_dynamic_functions = LXW_TRUE;
@@ -2277,6 +3203,9 @@ workbook_close(lxw_workbook *self)
     /* Set the table ids for the worksheet tables. */
     _prepare_tables(self);
 
+    /* Set the pivot table and pivot cache ids. */
+    _prepare_pivot_tables(self);
+
     /* Create a packager object to assemble sub-elements into a zip file. */
     packager = lxw_packager_new(self->filename,
                                 self->options.tmpdir,
@@ -2294,67 +3223,36 @@ workbook_close(lxw_workbook *self)
 
     /* Set the workbook object in the packager. */
     packager->workbook = self;
+    self->packager = packager;
 
-    /* Assemble all the sub-files in the xlsx package. */
-    error = lxw_create_package(packager);
-
-    if (!self->filename) {
-        *self->options.output_buffer = packager->output_buffer;
-        *self->options.output_buffer_size = packager->output_buffer_size;
-    }
-
-    /* Error and non-error conditions fall through to the cleanup code. */
-    if (error == LXW_ERROR_CREATING_TMPFILE) {
-        LXW_PRINTF(LXW_STDERR "[ERROR] workbook_close(): "
-                   "Error creating tmpfile(s) to assemble '%s'. "
-                   "System error = %s\n", self->filename, strerror(errno));
-    }
-
-    /* If LXW_ERROR_ZIP_FILE_OPERATION then errno is set by zip. */
-    if (error == LXW_ERROR_ZIP_FILE_OPERATION) {
-        LXW_PRINTF(LXW_STDERR "[ERROR] workbook_close(): "
-                   "Zip ZIP_ERRNO error while creating xlsx file '%s'. "
-                   "System error = %s\n", self->filename, strerror(errno));
-    }
+    return LXW_NO_ERROR;
 
-    /* If LXW_ERROR_ZIP_PARAMETER_ERROR then errno is set by zip. */
-    if (error == LXW_ERROR_ZIP_PARAMETER_ERROR) {
-        LXW_PRINTF(LXW_STDERR "[ERROR] workbook_close(): "
-                   "Zip ZIP_PARAMERROR error while creating xlsx file '%s'. "
-                   "System error = %s\n", self->filename, strerror(errno));
-    }
+mem_error:
+    lxw_workbook_free(self);
+    return error;
+}
 
-    /* If LXW_ERROR_ZIP_BAD_ZIP_FILE then errno is set by zip. */
-    if (error == LXW_ERROR_ZIP_BAD_ZIP_FILE) {
-        LXW_PRINTF(LXW_STDERR "[ERROR] workbook_close(): "
-                   "Zip ZIP_BADZIPFILE error while creating xlsx file '%s'. "
-                   "This may require the use_zip64 option for large files. "
-                   "System error = %s\n", self->filename, strerror(errno));
-    }
+/*
+ * Write part of the xlsx file in an incremental close.
+ */
+lxw_error
+workbook_close_step(lxw_workbook *self, size_t budget)
+{
+    lxw_error error;
 
-    /* If LXW_ERROR_ZIP_INTERNAL_ERROR then errno is set by zip. */
-    if (error == LXW_ERROR_ZIP_INTERNAL_ERROR) {
-        LXW_PRINTF(LXW_STDERR "[ERROR] workbook_close(): "
-                   "Zip ZIP_INTERNALERROR error while creating xlsx file '%s'. "
-                   "System error = %s\n", self->filename, strerror(errno));
+    if (!self->packager) {
+        LXW_WARN("workbook_close_step(): "
+                 "workbook_close_begin() must be called first.");
+        return LXW_ERROR_PARAMETER_VALIDATION;
     }
 
-    /* The next 2 error conditions don't set errno. */
-    if (error == LXW_ERROR_ZIP_FILE_ADD) {
-        LXW_PRINTF(LXW_STDERR "[ERROR] workbook_close(): "
-                   "Zip error adding file to xlsx file '%s'.\n",
-                   self->filename);
-    }
+    /* Assemble the next sub-files in the xlsx package. */
+    error = lxw_create_package_step(self->packager, budget);
 
-    if (error == LXW_ERROR_ZIP_CLOSE) {
-        LXW_PRINTF(LXW_STDERR "[ERROR] workbook_close(): "
-                   "Zip error closing xlsx file '%s'.\n", self->filename);
-    }
+    if (error == LXW_CLOSE_IN_PROGRESS)
+        return error;
 
-mem_error:
-    lxw_packager_free(packager);
-    lxw_workbook_free(self);
-    return error;
+    return _workbook_close_finish(self, error);
 }
 
 /*
@@ -2873,6 +3771,280 @@ workbook_use_1904_epoch(lxw_workbook *self)
     self->use_1904_epoch = LXW_TRUE;
 }
 
+/*
+ * Set the precision used to write numbers to the file.
+ */
+lxw_error
+workbook_set_number_precision(lxw_workbook *self, uint8_t type,
+                              uint8_t digits)
+{
+    lxw_error err;
+
+    err = lxw_validate_number_precision(type, digits);
+    if (err) {
+        LXW_WARN_FORMAT2("workbook_set_number_precision(): invalid "
+                         "precision type %d or digits %d.", type, digits);
+        return err;
+    }
+
+    self->number_precision.type = type;
+    self->number_precision.digits = digits;
+
+    return LXW_NO_ERROR;
+}
+
+/*
+ * Limit the number of worksheets that hold their cell data in memory.
+ */
+void
+workbook_set_max_resident_worksheets(lxw_workbook *self,
+                                     uint16_t num_worksheets)
+{
+    self->residency.max_resident = num_worksheets;
+}
+
+/*
+ * Store the rows of constant_memory worksheets in a checkpoint directory.
+ */
+lxw_error
+workbook_set_checkpoint_dir(lxw_workbook *self, const char *dir)
+{
+    if (!dir)
+        return LXW_ERROR_NULL_PARAMETER_IGNORED;
+
+    if (!self->options.constant_memory) {
+        LXW_WARN("workbook_set_checkpoint_dir(): "
+                 "checkpoints require 'constant_memory' mode.");
+        return LXW_ERROR_PARAMETER_VALIDATION;
+    }
+
+    if (self->num_sheets) {
+        LXW_WARN("workbook_set_checkpoint_dir(): "
+                 "function must be called before any worksheets are added.");
+        return LXW_ERROR_PARAMETER_VALIDATION;
+    }
+
+    free(self->checkpoint_dir);
+    self->checkpoint_dir = lxw_strdup(dir);
+    RETURN_ON_MEM_ERROR(self->checkpoint_dir, LXW_ERROR_MEMORY_MALLOC_FAILED);
+
+    return LXW_NO_ERROR;
+}
+
+/*
+ * Save the state needed to resume writing a constant_memory workbook. The
+ * state is written to a temp file that then replaces the last checkpoint.
+ */
+lxw_error
+workbook_checkpoint(lxw_workbook *self)
+{
+    lxw_worksheet *worksheet;
+    lxw_format *format;
+    FILE *file = NULL;
+    char *tmp_path = NULL;
+    char *path = NULL;
+    int32_t *positions = NULL;
+    uint32_t num_formats;
+    int32_t position = 0;
+    uint32_t i;
+    lxw_error err = LXW_NO_ERROR;
+
+    if (!self->checkpoint_dir) {
+        LXW_WARN("workbook_checkpoint(): "
+                 "workbook_set_checkpoint_dir() must be called first.");
+        return LXW_ERROR_PARAMETER_VALIDATION;
+    }
+
+    tmp_path = _checkpoint_path(self, "checkpoint.tmp");
+    GOTO_LABEL_ON_MEM_ERROR(tmp_path, mem_error);
+
+    path = _checkpoint_path(self, "checkpoint");
+    GOTO_LABEL_ON_MEM_ERROR(path, mem_error);
+
+    /* Flush the rows first since it assigns the format xf indexes. */
+    STAILQ_FOREACH(worksheet, self->worksheets, list_pointers) {
+        err = lxw_worksheet_flush_checkpoint(worksheet);
+        if (err)
+            goto cleanup;
+    }
+
+    num_formats = self->used_xf_formats->unique_count;
+
+    /* Store the workbook format list position of each used xf index. */
+    if (num_formats) {
+        positions = calloc(num_formats, sizeof(int32_t));
+        GOTO_LABEL_ON_MEM_ERROR(positions, mem_error);
+    }
+
+    STAILQ_FOREACH(format, self->formats, list_pointers) {
+        if (format->xf_index != LXW_PROPERTY_UNSET
+            && (uint32_t) format->xf_index < num_formats)
+            positions[format->xf_index] = position;
+
+        position++;
+    }
+
+    file = lxw_fopen(tmp_path, "wb");
+    if (!file) {
+        err = LXW_ERROR_CREATING_TMPFILE;
+        goto cleanup;
+    }
+
+    fprintf(file, "libxlsxwriter checkpoint 1\n");
+    fprintf(file, "formats %u", num_formats);
+
+    for (i = 0; i < num_formats; i++)
+        fprintf(file, " %d", positions[i]);
+
+    fprintf(file, "\n");
+
+    STAILQ_FOREACH(worksheet, self->worksheets, list_pointers) {
+        err = lxw_worksheet_write_checkpoint(worksheet, file);
+        if (err)
+            goto cleanup;
+    }
+
+    fprintf(file, "end\n");
+
+    if (fflush(file) || ferror(file)) {
+        err = LXW_ERROR_CREATING_TMPFILE;
+        goto cleanup;
+    }
+
+    fclose(file);
+    file = NULL;
+
+    /* Replace the previous checkpoint. */
+    remove(path);
+    if (rename(tmp_path, path))
+        err = LXW_ERROR_CREATING_TMPFILE;
+
+    goto cleanup;
+
+mem_error:
+    err = LXW_ERROR_MEMORY_MALLOC_FAILED;
+
+cleanup:
+    if (file)
+        fclose(file);
+
+    free(positions);
+    free(tmp_path);
+    free(path);
+    return err;
+}
+
+/*
+ * Restore the state of a constant_memory workbook from its last checkpoint.
+ */
+lxw_error
+workbook_resume(lxw_workbook *self)
+{
+    lxw_worksheet *worksheet;
+    lxw_format *format;
+    lxw_format **formats = NULL;
+    FILE *file = NULL;
+    char *path = NULL;
+    char token[LXW_ATTR_32];
+    uint32_t num_formats;
+    uint32_t num_positions = 0;
+    uint32_t i;
+    int32_t position;
+    unsigned int version;
+    unsigned int index;
+    lxw_error err = LXW_NO_ERROR;
+
+    if (!self->checkpoint_dir) {
+        LXW_WARN("workbook_resume(): "
+                 "workbook_set_checkpoint_dir() must be called first.");
+        return LXW_ERROR_PARAMETER_VALIDATION;
+    }
+
+    path = _checkpoint_path(self, "checkpoint");
+    RETURN_ON_MEM_ERROR(path, LXW_ERROR_MEMORY_MALLOC_FAILED);
+
+    /* There is nothing to resume on the first run. */
+    file = lxw_fopen(path, "rb");
+    free(path);
+    if (!file)
+        return LXW_NO_ERROR;
+
+    if (fscanf(file, "libxlsxwriter checkpoint %u", &version) != 1
+        || version != 1
+        || fscanf(file, " formats %u", &num_formats) != 1) {
+        err = LXW_ERROR_READING_TMPFILE;
+        goto cleanup;
+    }
+
+    /* Look up the formats by their position in the workbook format list. */
+    STAILQ_FOREACH(format, self->formats, list_pointers) {
+        num_positions++;
+    }
+
+    formats = calloc(num_positions + 1, sizeof(lxw_format *));
+    GOTO_LABEL_ON_MEM_ERROR(formats, mem_error);
+
+    i = 0;
+    STAILQ_FOREACH(format, self->formats, list_pointers) {
+        formats[i++] = format;
+    }
+
+    /* Assign the xf indexes in the same order as the checkpointed run. */
+    for (i = 0; i < num_formats; i++) {
+        if (fscanf(file, " %d", &position) != 1) {
+            err = LXW_ERROR_READING_TMPFILE;
+            goto cleanup;
+        }
+
+        if (position < 0 || (uint32_t) position >= num_positions
+            || lxw_format_get_xf_index(formats[position]) != (int32_t) i) {
+            LXW_WARN("workbook_resume(): "
+                     "workbook formats don't match the checkpoint.");
+            err = LXW_ERROR_PARAMETER_VALIDATION;
+            goto cleanup;
+        }
+    }
+
+    while (fscanf(file, " %31s", token) == 1) {
+        if (strcmp(token, "end") == 0)
+            goto cleanup;
+
+        if (strcmp(token, "sheet") != 0 || fscanf(file, " %u", &index) != 1) {
+            err = LXW_ERROR_READING_TMPFILE;
+            goto cleanup;
+        }
+
+        STAILQ_FOREACH(worksheet, self->worksheets, list_pointers) {
+            if (worksheet->index == index)
+                break;
+        }
+
+        if (!worksheet) {
+            LXW_WARN_FORMAT1("workbook_resume(): "
+                             "worksheet index %u in the checkpoint hasn't "
+                             "been added to the workbook.", index);
+            err = LXW_ERROR_PARAMETER_VALIDATION;
+            goto cleanup;
+        }
+
+        err = lxw_worksheet_read_checkpoint(worksheet, file);
+        if (err)
+            goto cleanup;
+    }
+
+    /* The checkpoint doesn't have an end marker. */
+    err = LXW_ERROR_READING_TMPFILE;
+    goto cleanup;
+
+mem_error:
+    err = LXW_ERROR_MEMORY_MALLOC_FAILED;
+
+cleanup:
+    free(formats);
+    fclose(file);
+    return err;
+}
+
 /*
  * Set the size of a workbook window.
  */
@@ -12,10 +12,15 @@
 #define _POSIX_C_SOURCE 200809L
 #endif
 
+#include <float.h>
+#include <zlib.h>
 #include "xlsxwriter/xmlwriter.h"
 #include "xlsxwriter/worksheet.h"
+#include "xlsxwriter/workbook.h"
 #include "xlsxwriter/format.h"
 #include "xlsxwriter/utility.h"
+#include "xlsxwriter/image_cache.h"
+#include "xlsxwriter/pivot_table.h"
 
 #ifdef USE_OPENSSL_MD5
 #include <openssl/md5.h>
@@ -29,18 +34,43 @@
 #define LXW_BUFFER_SIZE                  4096
 #define LXW_PRINT_ACROSS                 1
 #define LXW_VALIDATION_MAX_TITLE_LENGTH  32
-#define LXW_VALIDATION_MAX_STRING_LENGTH 255
 #define LXW_THIS_ROW "[#This Row],"
+#define LXW_URL_BUFFER_SIZE              2048
+#define LXW_SPILL_BUFFER_SIZE            16384
+#define LXW_SPILL_NO_STRING              UINT32_MAX
+
+/* Redirect a write past the rollover row of a worksheet to the rollover
+ * worksheet that holds the row. See worksheet_set_rollover(). */
+#define LXW_ROLLOVER_ROW(self, row_num)                               \
+    do {                                                              \
+        lxw_error rollover_err;                                       \
+        if ((self)->rollover_rows                                     \
+            && (row_num) >= (self)->rollover_rows) {                  \
+            rollover_err = _worksheet_rollover(&(self), &(row_num));  \
+            if (rollover_err)                                         \
+                return rollover_err;                                  \
+        }                                                             \
+    } while (0)
 /*
  * Forward declarations.
  */
 STATIC void _worksheet_write_rows(lxw_worksheet *self);
+STATIC void _worksheet_write_pinned_rows(lxw_worksheet *self);
+STATIC void _worksheet_use_cells(lxw_worksheet *self);
+STATIC void _free_column_stats(lxw_worksheet *self);
+STATIC void _remove_column_stats(lxw_worksheet *self, lxw_cell *cell);
+STATIC uint8_t _get_cell_value(lxw_cell *cell, lxw_cell_value *value);
+STATIC void _worksheet_render_row_records(lxw_worksheet *self,
+                                          lxw_worksheet *source,
+                                          size_t start, size_t end);
 STATIC int _row_cmp(lxw_row *row1, lxw_row *row2);
 STATIC int _cell_cmp(lxw_cell *cell1, lxw_cell *cell2);
 STATIC int _drawing_rel_id_cmp(lxw_drawing_rel_id *tuple1,
                                lxw_drawing_rel_id *tuple2);
 STATIC int _cond_format_hash_cmp(lxw_cond_format_hash_element *elem_1,
                                  lxw_cond_format_hash_element *elem_2);
+STATIC int _url_element_cmp(lxw_url_element *element1,
+                            lxw_url_element *element2);
 
 #ifndef __clang_analyzer__
 LXW_RB_GENERATE_ROW(lxw_table_rows, lxw_row, tree_pointers, _row_cmp);
@@ -53,6 +83,8 @@ LXW_RB_GENERATE_VML_DRAWING_REL_IDS(lxw_vml_drawing_rel_ids,
 LXW_RB_GENERATE_COND_FORMAT_HASH(lxw_cond_format_hash,
                                  lxw_cond_format_hash_element, tree_pointers,
                                  _cond_format_hash_cmp);
+LXW_RB_GENERATE_URL_ELEMENT(lxw_url_table, lxw_url_element, tree_pointers,
+                            _url_element_cmp);
 #endif
 
 /*****************************************************************************
@@ -69,6 +101,8 @@ lxw_worksheet_find_row(lxw_worksheet *self, lxw_row_t row_num)
 {
     lxw_row tmp_row;
 
+    _worksheet_use_cells(self);
+
     tmp_row.row_num = row_num;
 
     return RB_FIND(lxw_table_rows, self->table, &tmp_row);
@@ -90,6 +124,94 @@ lxw_worksheet_find_cell_in_row(lxw_row *row, lxw_col_t col_num)
     return RB_FIND(lxw_table_cells, row->cells, &tmp_cell);
 }
 
+/*
+ * Create a new table of normalized hyperlink urls. The table is owned by the
+ * workbook and shared between its worksheets.
+ */
+struct lxw_url_table *
+lxw_url_table_new(void)
+{
+    struct lxw_url_table *url_table = calloc(1, sizeof(struct lxw_url_table));
+    RETURN_ON_MEM_ERROR(url_table, NULL);
+
+    RB_INIT(url_table);
+
+    return url_table;
+}
+
+/*
+ * Free a hyperlink url table and the urls stored in it.
+ */
+void
+lxw_url_table_free(struct lxw_url_table *url_table)
+{
+    lxw_url_element *element;
+    lxw_url_element *next_element;
+
+    if (!url_table)
+        return;
+
+    for (element = RB_MIN(lxw_url_table, url_table); element;
+         element = next_element) {
+
+        next_element = RB_NEXT(lxw_url_table, url_table, element);
+        RB_REMOVE(lxw_url_table, url_table, element);
+
+        if (element->key != element->url)
+            free(element->key);
+
+        free(element->url);
+        free(element);
+    }
+
+    free(url_table);
+}
+
+/*
+ * Create a new table of shared data validation lists. The table is owned by
+ * the workbook and shared between its worksheets.
+ */
+struct lxw_validation_lists *
+lxw_validation_lists_new(void)
+{
+    struct lxw_validation_lists *lists =
+        calloc(1, sizeof(struct lxw_validation_lists));
+    RETURN_ON_MEM_ERROR(lists, NULL);
+
+    STAILQ_INIT(&lists->lists);
+
+    lists->hashes = lxw_hash_new(128, 0, 0);
+    if (!lists->hashes) {
+        free(lists);
+        return NULL;
+    }
+
+    return lists;
+}
+
+/*
+ * Free a shared data validation list table and the lists stored in it.
+ */
+void
+lxw_validation_lists_free(struct lxw_validation_lists *lists)
+{
+    lxw_validation_list *list;
+
+    if (!lists)
+        return;
+
+    while (!STAILQ_EMPTY(&lists->lists)) {
+        list = STAILQ_FIRST(&lists->lists);
+        STAILQ_REMOVE_HEAD(&lists->lists, list_pointers);
+        free(list->data);
+        free(list->formula);
+        free(list);
+    }
+
+    lxw_hash_free(lists->hashes);
+    free(lists);
+}
+
 /*
  * Create a new worksheet object.
  */
@@ -176,6 +298,11 @@ lxw_worksheet_new(lxw_worksheet_init_data *init_data)
     GOTO_LABEL_ON_MEM_ERROR(worksheet->table_objs, mem_error);
     STAILQ_INIT(worksheet->table_objs);
 
+    worksheet->pivot_table_objs =
+        calloc(1, sizeof(struct lxw_pivot_table_objs));
+    GOTO_LABEL_ON_MEM_ERROR(worksheet->pivot_table_objs, mem_error);
+    STAILQ_INIT(worksheet->pivot_table_objs);
+
     worksheet->external_hyperlinks = calloc(1, sizeof(struct lxw_rel_tuples));
     GOTO_LABEL_ON_MEM_ERROR(worksheet->external_hyperlinks, mem_error);
     STAILQ_INIT(worksheet->external_hyperlinks);
@@ -198,6 +325,15 @@ lxw_worksheet_new(lxw_worksheet_init_data *init_data)
     GOTO_LABEL_ON_MEM_ERROR(worksheet->external_table_links, mem_error);
     STAILQ_INIT(worksheet->external_table_links);
 
+    worksheet->external_pivot_table_links =
+        calloc(1, sizeof(struct lxw_rel_tuples));
+    GOTO_LABEL_ON_MEM_ERROR(worksheet->external_pivot_table_links, mem_error);
+    STAILQ_INIT(worksheet->external_pivot_table_links);
+
+    worksheet->segments = calloc(1, sizeof(struct lxw_worksheet_segments));
+    GOTO_LABEL_ON_MEM_ERROR(worksheet->segments, mem_error);
+    STAILQ_INIT(worksheet->segments);
+
     if (init_data && init_data->optimize) {
         FILE *tmpfile;
 
@@ -232,6 +368,20 @@ lxw_worksheet_new(lxw_worksheet_init_data *init_data)
     GOTO_LABEL_ON_MEM_ERROR(worksheet->conditional_formats, mem_error);
     RB_INIT(worksheet->conditional_formats);
 
+    /* Use the workbook url table or create a local one if standalone. */
+    if (init_data && init_data->url_table) {
+        worksheet->url_table = init_data->url_table;
+    }
+    else {
+        worksheet->url_table = lxw_url_table_new();
+        GOTO_LABEL_ON_MEM_ERROR(worksheet->url_table, mem_error);
+        worksheet->free_url_table = LXW_TRUE;
+    }
+
+    /* Use the workbook shared data validation lists, if enabled. */
+    if (init_data)
+        worksheet->validation_lists = init_data->validation_lists;
+
     /* Initialize the worksheet dimensions. */
     worksheet->dim_rowmax = 0;
     worksheet->dim_colmax = 0;
@@ -290,11 +440,17 @@ lxw_worksheet_new(lxw_worksheet_init_data *init_data)
         worksheet->hidden = init_data->hidden;
         worksheet->sst = init_data->sst;
         worksheet->optimize = init_data->optimize;
+        worksheet->binary_tmpfile = init_data->optimize
+            && init_data->binary_tmpfile;
         worksheet->active_sheet = init_data->active_sheet;
         worksheet->first_sheet = init_data->first_sheet;
         worksheet->default_url_format = init_data->default_url_format;
         worksheet->max_url_length = init_data->max_url_length;
         worksheet->use_1904_epoch = init_data->use_1904_epoch;
+        worksheet->formats = init_data->formats;
+        worksheet->num_default_formats = init_data->num_default_formats;
+        worksheet->number_precision = init_data->number_precision;
+        worksheet->residency = init_data->residency;
     }
 
     return worksheet;
@@ -365,26 +521,53 @@ _free_filter_rules(lxw_worksheet *worksheet)
 }
 
 /*
- * Free a worksheet cell.
+ * Check if the string in a cell is owned by the cell, rather than being an
+ * index into the shared string table or a url.
  */
-STATIC void
-_free_cell(lxw_cell *cell)
+STATIC uint8_t
+_cell_owns_string(lxw_cell *cell)
 {
-    if (!cell)
-        return;
-
-    if (cell->type != NUMBER_CELL && cell->type != STRING_CELL
+    return cell->type != NUMBER_CELL && cell->type != STRING_CELL
         && cell->type != BLANK_CELL && cell->type != BOOLEAN_CELL
-        && cell->type != ERROR_CELL) {
+        && cell->type != ERROR_CELL && cell->type != HYPERLINK_URL
+        && cell->type != HYPERLINK_INTERNAL
+        && cell->type != HYPERLINK_EXTERNAL;
+}
 
+/*
+ * Free the data owned by a worksheet cell, but not the cell itself, so that
+ * the cell can be reused.
+ */
+STATIC void
+_free_cell_data(lxw_cell *cell)
+{
+    if (_cell_owns_string(cell))
         free((void *) cell->u.string);
-    }
 
     free(cell->user_data1);
     free(cell->user_data2);
 
     _free_vml_object(cell->comment);
 
+    cell->u.number = 0;
+    cell->formula_result = 0;
+    cell->user_data1 = NULL;
+    cell->user_data2 = NULL;
+    cell->sst_string = NULL;
+    cell->comment = NULL;
+}
+
+/*
+ * Free a worksheet cell.
+ */
+STATIC void
+_free_cell(lxw_cell *cell)
+{
+    if (!cell)
+        return;
+
+    _free_cell_data(cell);
+
     free(cell);
 }
 
@@ -522,14 +705,128 @@ _free_worksheet_table(lxw_table_obj *table)
     free(table);
 }
 
+/*
+ * Free a worksheet pivot table object.
+ */
+STATIC void
+_free_worksheet_pivot_table(lxw_pivot_table_obj *pivot)
+{
+    uint16_t i;
+
+    if (!pivot)
+        return;
+
+    for (i = 0; i < pivot->num_row_fields; i++)
+        free(pivot->row_fields[i]);
+
+    for (i = 0; i < pivot->num_col_fields; i++)
+        free(pivot->col_fields[i]);
+
+    for (i = 0; i < pivot->num_data_fields; i++) {
+        free(pivot->data_fields[i].field);
+        free(pivot->data_fields[i].name);
+    }
+
+    free(pivot->name);
+    free(pivot->row_fields);
+    free(pivot->col_fields);
+    free(pivot->data_fields);
+
+    free(pivot);
+}
+
+/*
+ * Free the rows, and the cells in them, of a row tree. The tree is left empty.
+ */
+STATIC void
+_free_row_tree(struct lxw_table_rows *tree)
+{
+    lxw_row *row;
+    lxw_row *next_row;
+
+    for (row = RB_MIN(lxw_table_rows, tree); row; row = next_row) {
+        next_row = RB_NEXT(lxw_table_rows, tree, row);
+        RB_REMOVE(lxw_table_rows, tree, row);
+        _free_row(row);
+    }
+
+    tree->cached_row = NULL;
+    tree->cached_row_num = LXW_ROW_MAX + 1;
+}
+
+/*
+ * Free the row segments of a worksheet. The list is left empty.
+ */
+STATIC void
+_free_segments(lxw_worksheet *self)
+{
+    lxw_worksheet *segment;
+
+    while (!STAILQ_EMPTY(self->segments)) {
+        segment = STAILQ_FIRST(self->segments);
+        STAILQ_REMOVE_HEAD(self->segments, list_pointers);
+
+        /* Close the temp file if the segment wasn't written out. */
+        if (segment->optimize_tmpfile)
+            fclose(segment->optimize_tmpfile);
+
+        free(segment->optimize_buffer);
+        lxw_worksheet_free(segment);
+    }
+}
+
+/*
+ * Free the cell data of a worksheet once the worksheet xml file has been
+ * written so that the memory can be reused while the rest of the package is
+ * written. The comments tree is kept since it is needed for the comment and
+ * vml files.
+ */
+void
+lxw_worksheet_free_cells(lxw_worksheet *self)
+{
+    lxw_col_t col;
+
+    if (self->table)
+        _free_row_tree(self->table);
+
+    if (self->hyperlinks)
+        _free_row_tree(self->hyperlinks);
+
+    if (self->array) {
+        for (col = 0; col < LXW_COL_MAX; col++) {
+            _free_cell(self->array[col]);
+        }
+        free(self->array);
+        self->array = NULL;
+    }
+
+    if (self->segments)
+        _free_segments(self);
+
+    /* The worksheet no longer counts towards the resident worksheets. */
+    if (self->residency) {
+        if (self->is_resident) {
+            TAILQ_REMOVE(&self->residency->resident, self,
+                         residency_pointers);
+            self->residency->num_resident--;
+            self->is_resident = LXW_FALSE;
+        }
+
+        self->residency = NULL;
+    }
+
+    if (self->spill_file) {
+        fclose(self->spill_file);
+        self->spill_file = NULL;
+    }
+}
+
 /*
  * Free a worksheet object.
  */
 void
 lxw_worksheet_free(lxw_worksheet *worksheet)
 {
-    lxw_row *row;
-    lxw_row *next_row;
     lxw_col_t col;
     lxw_merged_range *merged_range;
     lxw_object_properties *object_props;
@@ -539,6 +836,7 @@ lxw_worksheet_free(lxw_worksheet *worksheet)
     lxw_rel_tuple *relationship;
     lxw_cond_format_obj *cond_format;
     lxw_table_obj *table_obj;
+    lxw_pivot_table_obj *pivot_obj;
     struct lxw_drawing_rel_id *drawing_rel_id;
     struct lxw_drawing_rel_id *next_drawing_rel_id;
     struct lxw_cond_format_hash_element *cond_format_elem;
@@ -557,40 +855,23 @@ lxw_worksheet_free(lxw_worksheet *worksheet)
     free(worksheet->col_options);
     free(worksheet->col_sizes);
     free(worksheet->col_formats);
+    free(worksheet->col_precision);
 
     if (worksheet->table) {
-        for (row = RB_MIN(lxw_table_rows, worksheet->table); row;
-             row = next_row) {
-
-            next_row = RB_NEXT(lxw_table_rows, worksheet->table, row);
-            RB_REMOVE(lxw_table_rows, worksheet->table, row);
-            _free_row(row);
-        }
-
+        _free_row_tree(worksheet->table);
         free(worksheet->table);
     }
 
     if (worksheet->hyperlinks) {
-        for (row = RB_MIN(lxw_table_rows, worksheet->hyperlinks); row;
-             row = next_row) {
-
-            next_row = RB_NEXT(lxw_table_rows, worksheet->hyperlinks, row);
-            RB_REMOVE(lxw_table_rows, worksheet->hyperlinks, row);
-            _free_row(row);
-        }
-
+        _free_row_tree(worksheet->hyperlinks);
         free(worksheet->hyperlinks);
     }
 
-    if (worksheet->comments) {
-        for (row = RB_MIN(lxw_table_rows, worksheet->comments); row;
-             row = next_row) {
-
-            next_row = RB_NEXT(lxw_table_rows, worksheet->comments, row);
-            RB_REMOVE(lxw_table_rows, worksheet->comments, row);
-            _free_row(row);
-        }
+    if (worksheet->spill_file)
+        fclose(worksheet->spill_file);
 
+    if (worksheet->comments) {
+        _free_row_tree(worksheet->comments);
         free(worksheet->comments);
     }
 
@@ -678,6 +959,16 @@ lxw_worksheet_free(lxw_worksheet *worksheet)
         free(worksheet->table_objs);
     }
 
+    if (worksheet->pivot_table_objs) {
+        while (!STAILQ_EMPTY(worksheet->pivot_table_objs)) {
+            pivot_obj = STAILQ_FIRST(worksheet->pivot_table_objs);
+            STAILQ_REMOVE_HEAD(worksheet->pivot_table_objs, list_pointers);
+            _free_worksheet_pivot_table(pivot_obj);
+        }
+
+        free(worksheet->pivot_table_objs);
+    }
+
     if (worksheet->data_validations) {
         while (!STAILQ_EMPTY(worksheet->data_validations)) {
             data_validation = STAILQ_FIRST(worksheet->data_validations);
@@ -723,6 +1014,17 @@ lxw_worksheet_free(lxw_worksheet *worksheet)
     }
     free(worksheet->external_table_links);
 
+    if (worksheet->external_pivot_table_links) {
+        while (!STAILQ_EMPTY(worksheet->external_pivot_table_links)) {
+            relationship =
+                STAILQ_FIRST(worksheet->external_pivot_table_links);
+            STAILQ_REMOVE_HEAD(worksheet->external_pivot_table_links,
+                               list_pointers);
+            _free_relationship(relationship);
+        }
+        free(worksheet->external_pivot_table_links);
+    }
+
     if (worksheet->drawing_rel_ids) {
         for (drawing_rel_id =
              RB_MIN(lxw_drawing_rel_ids, worksheet->drawing_rel_ids);
@@ -799,9 +1101,22 @@ lxw_worksheet_free(lxw_worksheet *worksheet)
     if (worksheet->optimize_row)
         free(worksheet->optimize_row);
 
+    free(worksheet->record_formats);
+    free(worksheet->batch_formats);
+    free(worksheet->rollover_sheets);
+    _free_column_stats(worksheet);
+
     if (worksheet->drawing)
         lxw_drawing_free(worksheet->drawing);
 
+    if (worksheet->free_url_table)
+        lxw_url_table_free(worksheet->url_table);
+
+    if (worksheet->segments) {
+        _free_segments(worksheet);
+        free(worksheet->segments);
+    }
+
     free(worksheet->hbreaks);
     free(worksheet->vbreaks);
     free((void *) worksheet->name);
@@ -852,111 +1167,584 @@ _new_row(lxw_row_t row_num)
 }
 
 /*
- * Create a new worksheet number cell object.
+ * A compressed stream of row and cell records used to spill the cell data
+ * of a worksheet to a temp file. See workbook_set_max_resident_worksheets().
  */
-STATIC lxw_cell *
-_new_number_cell(lxw_row_t row_num,
-                 lxw_col_t col_num, double value, lxw_format *format)
+typedef struct lxw_spill_stream {
+    FILE *file;
+    z_stream zstream;
+    size_t pos;
+    size_t used;
+    uint8_t error;
+    uint8_t at_end;
+    unsigned char data[LXW_SPILL_BUFFER_SIZE];
+    unsigned char zdata[LXW_SPILL_BUFFER_SIZE];
+} lxw_spill_stream;
+
+enum lxw_spill_record_types {
+    LXW_SPILL_END = 0,
+    LXW_SPILL_ROW,
+    LXW_SPILL_CELL
+};
+
+/* Row record in a spill file. */
+typedef struct lxw_spill_row {
+    double height;
+    lxw_format *format;
+    lxw_row_t row_num;
+    uint8_t hidden;
+    uint8_t level;
+    uint8_t collapsed;
+    uint8_t row_changed;
+    uint8_t data_changed;
+    uint8_t height_changed;
+} lxw_spill_row;
+
+/* Cell record in a spill file. Owned strings follow the record. */
+typedef struct lxw_spill_cell {
+    double number;
+    double formula_result;
+    lxw_format *format;
+    char *sst_string;
+    lxw_col_t col_num;
+    uint8_t type;
+    uint8_t stats_generation;
+} lxw_spill_cell;
+
+/*
+ * Compress the buffered spill data and write it to the spill file.
+ */
+STATIC void
+_spill_deflate(lxw_spill_stream *spill, int flush)
 {
-    lxw_cell *cell = calloc(1, sizeof(lxw_cell));
-    RETURN_ON_MEM_ERROR(cell, cell);
+    z_stream *zstream = &spill->zstream;
+    size_t size;
 
-    cell->row_num = row_num;
-    cell->col_num = col_num;
-    cell->type = NUMBER_CELL;
-    cell->format = format;
-    cell->u.number = value;
+    zstream->next_in = spill->data;
+    zstream->avail_in = (uInt) spill->used;
 
-    return cell;
+    do {
+        zstream->next_out = spill->zdata;
+        zstream->avail_out = LXW_SPILL_BUFFER_SIZE;
+
+        if (deflate(zstream, flush) == Z_STREAM_ERROR) {
+            spill->error = LXW_TRUE;
+            return;
+        }
+
+        size = LXW_SPILL_BUFFER_SIZE - zstream->avail_out;
+
+        if (fwrite(spill->zdata, 1, size, spill->file) != size) {
+            spill->error = LXW_TRUE;
+            return;
+        }
+    } while (zstream->avail_out == 0);
+
+    spill->used = 0;
 }
 
 /*
- * Create a new worksheet string cell object.
+ * Add data to a spill stream.
  */
-STATIC lxw_cell *
-_new_string_cell(lxw_row_t row_num,
-                 lxw_col_t col_num, int32_t string_id, char *sst_string,
-                 lxw_format *format)
+STATIC void
+_spill_write(lxw_spill_stream *spill, const void *data, size_t length)
 {
-    lxw_cell *cell = calloc(1, sizeof(lxw_cell));
-    RETURN_ON_MEM_ERROR(cell, cell);
+    const unsigned char *p_data = data;
+    size_t size;
 
-    cell->row_num = row_num;
-    cell->col_num = col_num;
-    cell->type = STRING_CELL;
-    cell->format = format;
-    cell->u.string_id = string_id;
-    cell->sst_string = sst_string;
+    while (length && !spill->error) {
+        size = LXW_SPILL_BUFFER_SIZE - spill->used;
+        if (size > length)
+            size = length;
 
-    return cell;
+        memcpy(spill->data + spill->used, p_data, size);
+        spill->used += size;
+        p_data += size;
+        length -= size;
+
+        if (spill->used == LXW_SPILL_BUFFER_SIZE)
+            _spill_deflate(spill, Z_NO_FLUSH);
+    }
 }
 
 /*
- * Create a new worksheet inline_string cell object.
+ * Add a length prefixed, and possibly NULL, string to a spill stream.
  */
-STATIC lxw_cell *
-_new_inline_string_cell(lxw_row_t row_num,
-                        lxw_col_t col_num, char *string, lxw_format *format)
+STATIC void
+_spill_write_string(lxw_spill_stream *spill, const char *string)
 {
-    lxw_cell *cell = calloc(1, sizeof(lxw_cell));
-    RETURN_ON_MEM_ERROR(cell, cell);
+    uint32_t length = LXW_SPILL_NO_STRING;
 
-    cell->row_num = row_num;
-    cell->col_num = col_num;
-    cell->type = INLINE_STRING_CELL;
-    cell->format = format;
-    cell->u.string = string;
+    if (string)
+        length = (uint32_t) strlen(string);
 
-    return cell;
+    _spill_write(spill, &length, sizeof(length));
+
+    if (string)
+        _spill_write(spill, string, length);
 }
 
 /*
- * Create a new worksheet inline_string cell object for rich strings.
+ * Read data from a spill stream. Returns false at the end of the data or on
+ * an error.
  */
-STATIC lxw_cell *
-_new_inline_rich_string_cell(lxw_row_t row_num,
-                             lxw_col_t col_num, const char *string,
-                             lxw_format *format)
+STATIC uint8_t
+_spill_read(lxw_spill_stream *spill, void *data, size_t length)
 {
-    lxw_cell *cell = calloc(1, sizeof(lxw_cell));
-    RETURN_ON_MEM_ERROR(cell, cell);
+    z_stream *zstream = &spill->zstream;
+    unsigned char *p_data = data;
+    size_t size;
+    int status;
 
-    cell->row_num = row_num;
-    cell->col_num = col_num;
-    cell->type = INLINE_RICH_STRING_CELL;
-    cell->format = format;
-    cell->u.string = string;
+    while (length) {
+        if (spill->pos == spill->used) {
+            if (spill->at_end)
+                return LXW_FALSE;
 
-    return cell;
+            if (!zstream->avail_in) {
+                zstream->next_in = spill->zdata;
+                zstream->avail_in = (uInt) fread(spill->zdata, 1,
+                                                 LXW_SPILL_BUFFER_SIZE,
+                                                 spill->file);
+            }
+
+            zstream->next_out = spill->data;
+            zstream->avail_out = LXW_SPILL_BUFFER_SIZE;
+
+            status = inflate(zstream, Z_NO_FLUSH);
+            if (status == Z_STREAM_END)
+                spill->at_end = LXW_TRUE;
+            else if (status != Z_OK)
+                return LXW_FALSE;
+
+            spill->pos = 0;
+            spill->used = LXW_SPILL_BUFFER_SIZE - zstream->avail_out;
+            continue;
+        }
+
+        size = spill->used - spill->pos;
+        if (size > length)
+            size = length;
+
+        memcpy(p_data, spill->data + spill->pos, size);
+        spill->pos += size;
+        p_data += size;
+        length -= size;
+    }
+
+    return LXW_TRUE;
 }
 
 /*
- * Create a new worksheet formula cell object.
+ * Read a length prefixed string from a spill stream into a new string.
  */
-STATIC lxw_cell *
-_new_formula_cell(lxw_row_t row_num,
-                  lxw_col_t col_num, char *formula, lxw_format *format)
+STATIC uint8_t
+_spill_read_string(lxw_spill_stream *spill, char **string)
 {
-    lxw_cell *cell = calloc(1, sizeof(lxw_cell));
-    RETURN_ON_MEM_ERROR(cell, cell);
+    uint32_t length;
 
-    cell->row_num = row_num;
-    cell->col_num = col_num;
-    cell->type = FORMULA_CELL;
-    cell->format = format;
-    cell->u.string = formula;
+    *string = NULL;
 
-    return cell;
+    if (!_spill_read(spill, &length, sizeof(length)))
+        return LXW_FALSE;
+
+    if (length == LXW_SPILL_NO_STRING)
+        return LXW_TRUE;
+
+    *string = calloc(1, (size_t) length + 1);
+    RETURN_ON_MEM_ERROR(*string, LXW_FALSE);
+
+    return _spill_read(spill, *string, length);
 }
 
 /*
- * Create a new worksheet array formula cell object.
+ * Write the rows and cells of the worksheet cell table to a spill stream.
  */
-STATIC lxw_cell *
-_new_array_formula_cell(lxw_row_t row_num, lxw_col_t col_num, char *formula,
-                        char *range, lxw_format *format, uint8_t is_dynamic)
+STATIC void
+_worksheet_write_spill_records(lxw_worksheet *self, lxw_spill_stream *spill)
 {
-    lxw_cell *cell = calloc(1, sizeof(lxw_cell));
+    uint8_t record_type;
+    lxw_spill_row spill_row;
+    lxw_spill_cell spill_cell;
+    lxw_row *row;
+    lxw_cell *cell;
+
+    /* Clear any padding bytes in the records. */
+    memset(&spill_row, 0, sizeof(spill_row));
+    memset(&spill_cell, 0, sizeof(spill_cell));
+
+    RB_FOREACH(row, lxw_table_rows, self->table) {
+        record_type = LXW_SPILL_ROW;
+        spill_row.height = row->height;
+        spill_row.format = row->format;
+        spill_row.row_num = row->row_num;
+        spill_row.hidden = row->hidden;
+        spill_row.level = row->level;
+        spill_row.collapsed = row->collapsed;
+        spill_row.row_changed = row->row_changed;
+        spill_row.data_changed = row->data_changed;
+        spill_row.height_changed = row->height_changed;
+
+        _spill_write(spill, &record_type, sizeof(record_type));
+        _spill_write(spill, &spill_row, sizeof(spill_row));
+
+        RB_FOREACH(cell, lxw_table_cells, row->cells) {
+            record_type = LXW_SPILL_CELL;
+            memcpy(&spill_cell.number, &cell->u, sizeof(spill_cell.number));
+            spill_cell.formula_result = cell->formula_result;
+            spill_cell.format = cell->format;
+            spill_cell.sst_string = cell->sst_string;
+            spill_cell.col_num = cell->col_num;
+            spill_cell.type = (uint8_t) cell->type;
+            spill_cell.stats_generation = cell->stats_generation;
+
+            _spill_write(spill, &record_type, sizeof(record_type));
+            _spill_write(spill, &spill_cell, sizeof(spill_cell));
+
+            if (_cell_owns_string(cell))
+                _spill_write_string(spill, cell->u.string);
+
+            _spill_write_string(spill, cell->user_data1);
+            _spill_write_string(spill, cell->user_data2);
+        }
+    }
+
+    record_type = LXW_SPILL_END;
+    _spill_write(spill, &record_type, sizeof(record_type));
+}
+
+/*
+ * Read the rows and cells from a spill stream back into the worksheet cell
+ * table.
+ */
+STATIC uint8_t
+_worksheet_read_spill_records(lxw_worksheet *self, lxw_spill_stream *spill)
+{
+    uint8_t record_type;
+    lxw_spill_row spill_row;
+    lxw_spill_cell spill_cell;
+    lxw_row *row = NULL;
+    lxw_cell *cell;
+    char *string;
+
+    while (_spill_read(spill, &record_type, sizeof(record_type))) {
+
+        if (record_type == LXW_SPILL_END)
+            return LXW_TRUE;
+
+        if (record_type == LXW_SPILL_ROW) {
+            if (!_spill_read(spill, &spill_row, sizeof(spill_row)))
+                return LXW_FALSE;
+
+            row = _new_row(spill_row.row_num);
+            if (!row)
+                return LXW_FALSE;
+
+            row->height = spill_row.height;
+            row->format = spill_row.format;
+            row->hidden = spill_row.hidden;
+            row->level = spill_row.level;
+            row->collapsed = spill_row.collapsed;
+            row->row_changed = spill_row.row_changed;
+            row->data_changed = spill_row.data_changed;
+            row->height_changed = spill_row.height_changed;
+
+            RB_INSERT(lxw_table_rows, self->table, row);
+            continue;
+        }
+
+        if (record_type != LXW_SPILL_CELL || !row)
+            return LXW_FALSE;
+
+        if (!_spill_read(spill, &spill_cell, sizeof(spill_cell)))
+            return LXW_FALSE;
+
+        cell = calloc(1, sizeof(lxw_cell));
+        RETURN_ON_MEM_ERROR(cell, LXW_FALSE);
+
+        cell->row_num = row->row_num;
+        cell->col_num = spill_cell.col_num;
+        cell->type = (enum cell_types) spill_cell.type;
+        cell->stats_generation = spill_cell.stats_generation;
+        cell->format = spill_cell.format;
+        cell->formula_result = spill_cell.formula_result;
+        cell->sst_string = spill_cell.sst_string;
+        memcpy(&cell->u, &spill_cell.number, sizeof(spill_cell.number));
+
+        RB_INSERT(lxw_table_cells, row->cells, cell);
+
+        if (_cell_owns_string(cell)) {
+            cell->u.string = NULL;
+
+            if (!_spill_read_string(spill, &string))
+                return LXW_FALSE;
+
+            cell->u.string = string;
+        }
+
+        if (!_spill_read_string(spill, &cell->user_data1))
+            return LXW_FALSE;
+
+        if (!_spill_read_string(spill, &cell->user_data2))
+            return LXW_FALSE;
+    }
+
+    return LXW_FALSE;
+}
+
+/*
+ * Write the cell data of a worksheet to a compressed temp file and free it.
+ */
+STATIC lxw_error
+_worksheet_spill_cells(lxw_worksheet *self)
+{
+    lxw_worksheet_residency *residency = self->residency;
+    lxw_spill_stream *spill;
+    lxw_error err = LXW_NO_ERROR;
+
+    if (!RB_EMPTY(self->table)) {
+        spill = calloc(1, sizeof(lxw_spill_stream));
+        RETURN_ON_MEM_ERROR(spill, LXW_ERROR_MEMORY_MALLOC_FAILED);
+
+        if (deflateInit(&spill->zstream, Z_BEST_SPEED) != Z_OK) {
+            free(spill);
+            return LXW_ERROR_MEMORY_MALLOC_FAILED;
+        }
+
+        spill->file = lxw_tmpfile(self->tmpdir);
+
+        if (spill->file) {
+            _worksheet_write_spill_records(self, spill);
+
+            if (!spill->error)
+                _spill_deflate(spill, Z_FINISH);
+
+            if (spill->error || fflush(spill->file) != 0) {
+                fclose(spill->file);
+                err = LXW_ERROR_CREATING_TMPFILE;
+            }
+        }
+        else {
+            err = LXW_ERROR_CREATING_TMPFILE;
+        }
+
+        deflateEnd(&spill->zstream);
+
+        if (!err) {
+            _free_row_tree(self->table);
+            self->spill_file = spill->file;
+        }
+
+        free(spill);
+
+        if (err) {
+            LXW_WARN_FORMAT1("Error writing the cell data of worksheet "
+                             "'%s' to a temporary file.", self->name);
+            return err;
+        }
+    }
+
+    TAILQ_REMOVE(&residency->resident, self, residency_pointers);
+    residency->num_resident--;
+    self->is_resident = LXW_FALSE;
+
+    return LXW_NO_ERROR;
+}
+
+/*
+ * Read the cell data of a worksheet back from its spill file.
+ */
+STATIC void
+_worksheet_reload_cells(lxw_worksheet *self)
+{
+    lxw_spill_stream *spill;
+    uint8_t is_loaded = LXW_FALSE;
+
+    spill = calloc(1, sizeof(lxw_spill_stream));
+    if (spill && inflateInit(&spill->zstream) == Z_OK) {
+        spill->file = self->spill_file;
+        rewind(spill->file);
+
+        is_loaded = _worksheet_read_spill_records(self, spill);
+
+        inflateEnd(&spill->zstream);
+    }
+
+    if (!is_loaded)
+        LXW_WARN_FORMAT1("Error reading the cell data of worksheet "
+                         "'%s' from a temporary file.", self->name);
+
+    free(spill);
+
+    fclose(self->spill_file);
+    self->spill_file = NULL;
+    self->reload_count++;
+}
+
+/*
+ * Mark the cell data of a worksheet as being used. The data is reloaded if
+ * it was spilled to disk and the least recently used worksheets are spilled
+ * if there are more resident worksheets than allowed.
+ */
+STATIC void
+_worksheet_use_cells(lxw_worksheet *self)
+{
+    lxw_worksheet_residency *residency = self->residency;
+
+    if (!residency)
+        return;
+
+    if (self->spill_file)
+        _worksheet_reload_cells(self);
+
+    if (!residency->max_resident)
+        return;
+
+    /* Move the worksheet to the most recently used end of the list. */
+    if (self->is_resident) {
+        if (TAILQ_LAST(&residency->resident, lxw_resident_worksheets) == self)
+            return;
+
+        TAILQ_REMOVE(&residency->resident, self, residency_pointers);
+    }
+    else {
+        self->is_resident = LXW_TRUE;
+        residency->num_resident++;
+    }
+
+    TAILQ_INSERT_TAIL(&residency->resident, self, residency_pointers);
+
+    while (residency->num_resident > residency->max_resident) {
+        if (_worksheet_spill_cells(TAILQ_FIRST(&residency->resident)))
+            break;
+    }
+}
+
+/*
+ * Create a new worksheet number cell object.
+ */
+STATIC lxw_cell *
+_new_number_cell(lxw_row_t row_num,
+                 lxw_col_t col_num, double value, lxw_format *format)
+{
+    lxw_cell *cell = calloc(1, sizeof(lxw_cell));
+    RETURN_ON_MEM_ERROR(cell, cell);
+
+    cell->row_num = row_num;
+    cell->col_num = col_num;
+    cell->type = NUMBER_CELL;
+    cell->format = format;
+    cell->u.number = value;
+
+    return cell;
+}
+
+/*
+ * Create a new worksheet number cell object with the number stored as text.
+ */
+STATIC lxw_cell *
+_new_number_text_cell(lxw_row_t row_num,
+                      lxw_col_t col_num, char *digits, lxw_format *format)
+{
+    lxw_cell *cell = calloc(1, sizeof(lxw_cell));
+    RETURN_ON_MEM_ERROR(cell, cell);
+
+    cell->row_num = row_num;
+    cell->col_num = col_num;
+    cell->type = NUMBER_TEXT_CELL;
+    cell->format = format;
+    cell->u.string = digits;
+
+    return cell;
+}
+
+/*
+ * Create a new worksheet string cell object.
+ */
+STATIC lxw_cell *
+_new_string_cell(lxw_row_t row_num,
+                 lxw_col_t col_num, int32_t string_id, char *sst_string,
+                 lxw_format *format)
+{
+    lxw_cell *cell = calloc(1, sizeof(lxw_cell));
+    RETURN_ON_MEM_ERROR(cell, cell);
+
+    cell->row_num = row_num;
+    cell->col_num = col_num;
+    cell->type = STRING_CELL;
+    cell->format = format;
+    cell->u.string_id = string_id;
+    cell->sst_string = sst_string;
+
+    return cell;
+}
+
+/*
+ * Create a new worksheet inline_string cell object.
+ */
+STATIC lxw_cell *
+_new_inline_string_cell(lxw_row_t row_num,
+                        lxw_col_t col_num, char *string, lxw_format *format)
+{
+    lxw_cell *cell = calloc(1, sizeof(lxw_cell));
+    RETURN_ON_MEM_ERROR(cell, cell);
+
+    cell->row_num = row_num;
+    cell->col_num = col_num;
+    cell->type = INLINE_STRING_CELL;
+    cell->format = format;
+    cell->u.string = string;
+
+    return cell;
+}
+
+/*
+ * Create a new worksheet inline_string cell object for rich strings.
+ */
+STATIC lxw_cell *
+_new_inline_rich_string_cell(lxw_row_t row_num,
+                             lxw_col_t col_num, const char *string,
+                             lxw_format *format)
+{
+    lxw_cell *cell = calloc(1, sizeof(lxw_cell));
+    RETURN_ON_MEM_ERROR(cell, cell);
+
+    cell->row_num = row_num;
+    cell->col_num = col_num;
+    cell->type = INLINE_RICH_STRING_CELL;
+    cell->format = format;
+    cell->u.string = string;
+
+    return cell;
+}
+
+/*
+ * Create a new worksheet formula cell object.
+ */
+STATIC lxw_cell *
+_new_formula_cell(lxw_row_t row_num,
+                  lxw_col_t col_num, char *formula, lxw_format *format)
+{
+    lxw_cell *cell = calloc(1, sizeof(lxw_cell));
+    RETURN_ON_MEM_ERROR(cell, cell);
+
+    cell->row_num = row_num;
+    cell->col_num = col_num;
+    cell->type = FORMULA_CELL;
+    cell->format = format;
+    cell->u.string = formula;
+
+    return cell;
+}
+
+/*
+ * Create a new worksheet array formula cell object.
+ */
+STATIC lxw_cell *
+_new_array_formula_cell(lxw_row_t row_num, lxw_col_t col_num, char *formula,
+                        char *range, lxw_format *format, uint8_t is_dynamic)
+{
+    lxw_cell *cell = calloc(1, sizeof(lxw_cell));
     RETURN_ON_MEM_ERROR(cell, cell);
 
     cell->row_num = row_num;
@@ -1051,8 +1839,8 @@ _new_comment_cell(lxw_row_t row_num, lxw_col_t col_num,
  */
 STATIC lxw_cell *
 _new_hyperlink_cell(lxw_row_t row_num, lxw_col_t col_num,
-                    enum cell_types link_type, char *url, char *string,
-                    char *tooltip)
+                    enum cell_types link_type, lxw_url_element *url_element,
+                    char *string, char *tooltip)
 {
     lxw_cell *cell = calloc(1, sizeof(lxw_cell));
     RETURN_ON_MEM_ERROR(cell, cell);
@@ -1060,7 +1848,7 @@ _new_hyperlink_cell(lxw_row_t row_num, lxw_col_t col_num,
     cell->row_num = row_num;
     cell->col_num = col_num;
     cell->type = link_type;
-    cell->u.string = url;
+    cell->sst_string = url_element->url;
     cell->user_data1 = string;
     cell->user_data2 = tooltip;
 
@@ -1074,20 +1862,18 @@ STATIC lxw_row *
 _get_row_list(struct lxw_table_rows *table, lxw_row_t row_num)
 {
     lxw_row *row;
-    lxw_row *existing_row;
+    lxw_row tmp_row;
 
     if (table->cached_row_num == row_num)
         return table->cached_row;
 
-    /* Create a new row and try and insert it. */
-    row = _new_row(row_num);
-    existing_row = RB_INSERT(lxw_table_rows, table, row);
+    /* Look for an existing row before creating and inserting a new one. */
+    tmp_row.row_num = row_num;
+    row = RB_FIND(lxw_table_rows, table, &tmp_row);
 
-    /* If existing_row is not NULL, then it already existed. Free new row */
-    /* and return existing_row. */
-    if (existing_row) {
-        _free_row(row);
-        row = existing_row;
+    if (!row) {
+        row = _new_row(row_num);
+        RB_INSERT(lxw_table_rows, table, row);
     }
 
     table->cached_row = row;
@@ -1104,7 +1890,8 @@ _get_row(lxw_worksheet *self, lxw_row_t row_num)
 {
     lxw_row *row;
 
-    if (!self->optimize) {
+    if (!self->optimize || row_num < self->pinned_rows) {
+        _worksheet_use_cells(self);
         row = _get_row_list(self->table, row_num);
         return row;
     }
@@ -1139,18 +1926,54 @@ _insert_cell_list(struct lxw_table_cells *cell_list,
     existing_cell = RB_INSERT(lxw_table_cells, cell_list, cell);
 
     /* If existing_cell is not NULL, then that cell already existed. */
-    /* Remove existing_cell and add new one in again. */
+    /* Move the new data into the existing cell, which stays in the tree, */
+    /* to avoid removing and re-adding the cell and rebalancing the tree. */
     if (existing_cell) {
-        RB_REMOVE(lxw_table_cells, cell_list, existing_cell);
+        _free_cell_data(existing_cell);
+
+        existing_cell->type = cell->type;
+        existing_cell->stats_generation = cell->stats_generation;
+        existing_cell->format = cell->format;
+        existing_cell->comment = cell->comment;
+        existing_cell->u = cell->u;
+        existing_cell->formula_result = cell->formula_result;
+        existing_cell->user_data1 = cell->user_data1;
+        existing_cell->user_data2 = cell->user_data2;
+        existing_cell->sst_string = cell->sst_string;
 
-        /* Add it in again. */
-        RB_INSERT(lxw_table_cells, cell_list, cell);
-        _free_cell(existing_cell);
+        free(cell);
     }
 
     return;
 }
 
+/*
+ * Find an existing cell so that it can be updated in place without
+ * allocating a new cell. In constant_memory mode only cells in the current
+ * row can be updated.
+ */
+STATIC lxw_cell *
+_get_existing_cell(lxw_worksheet *self, lxw_row_t row_num, lxw_col_t col_num)
+{
+    lxw_row *row;
+
+    if (self->optimize && row_num >= self->pinned_rows) {
+        if (row_num == self->optimize_row->row_num)
+            return self->array[col_num];
+        else
+            return NULL;
+    }
+
+    _worksheet_use_cells(self);
+
+    if (self->table->cached_row_num == row_num)
+        row = self->table->cached_row;
+    else
+        row = lxw_worksheet_find_row(self, row_num);
+
+    return lxw_worksheet_find_cell_in_row(row, col_num);
+}
+
 /*
  * Insert a cell object into the cell list or array.
  */
@@ -1160,8 +1983,13 @@ _insert_cell(lxw_worksheet *self, lxw_row_t row_num, lxw_col_t col_num,
 {
     lxw_row *row = _get_row(self, row_num);
 
-    if (!self->optimize) {
+    if (!self->optimize || row_num < self->pinned_rows) {
         row->data_changed = LXW_TRUE;
+
+        if (self->column_stats)
+            _remove_column_stats(self,
+                                 lxw_worksheet_find_cell_in_row(row, col_num));
+
         _insert_cell_list(row->cells, cell, col_num);
     }
     else {
@@ -1169,8 +1997,10 @@ _insert_cell(lxw_worksheet *self, lxw_row_t row_num, lxw_col_t col_num,
             row->data_changed = LXW_TRUE;
 
             /* Overwrite an existing cell if necessary. */
-            if (self->array[col_num])
+            if (self->array[col_num]) {
+                _remove_column_stats(self, self->array[col_num]);
                 _free_cell(self->array[col_num]);
+            }
 
             self->array[col_num] = cell;
         }
@@ -1250,16 +2080,78 @@ _next_power_of_two(uint16_t col)
 }
 
 /*
- * Check that row and col are within the allowed Excel range and store max
- * and min values for use in other methods/elements.
- *
- * The ignore_row/ignore_col flags are used to indicate that we wish to
- * perform the dimension check without storing the value.
+ * Find the segment, if any, that contains a row. The segments are stored in
+ * row order.
  */
-STATIC lxw_error
-_check_dimensions(lxw_worksheet *self,
-                  lxw_row_t row_num,
-                  lxw_col_t col_num, int8_t ignore_row, int8_t ignore_col)
+STATIC lxw_worksheet *
+_find_segment(lxw_worksheet *self, lxw_row_t row_num)
+{
+    lxw_worksheet *segment;
+
+    STAILQ_FOREACH(segment, self->segments, list_pointers) {
+        if (segment->segment_first_row > row_num)
+            break;
+
+        if (segment->segment_last_row >= row_num)
+            return segment;
+    }
+
+    return NULL;
+}
+
+/*
+ * Check that a cell can be written to a row. In optimization mode rows that
+ * are already written can't be changed, apart from the pinned rows which are
+ * kept in memory. A segment can only write to its own rows and the parent
+ * worksheet can't write to the rows of a segment.
+ */
+STATIC lxw_error
+_check_row_owner(lxw_worksheet *self, lxw_row_t row_num)
+{
+    if (self->optimize) {
+        if (row_num < self->optimize_row->row_num
+            && row_num >= self->pinned_rows)
+            return LXW_ERROR_WORKSHEET_INDEX_OUT_OF_RANGE;
+    }
+
+    if (self->is_segment) {
+        if (row_num < self->segment_first_row
+            || row_num > self->segment_last_row)
+            return LXW_ERROR_WORKSHEET_INDEX_OUT_OF_RANGE;
+    }
+    else if (!STAILQ_EMPTY(self->segments)) {
+        if (_find_segment(self, row_num))
+            return LXW_ERROR_WORKSHEET_INDEX_OUT_OF_RANGE;
+    }
+
+    return LXW_NO_ERROR;
+}
+
+/*
+ * Check that a row isn't past the rollover limit of a worksheet. Only the
+ * cell write functions redirect rows past the limit to the rollover
+ * worksheets. See worksheet_set_rollover().
+ */
+STATIC lxw_error
+_check_rollover_limit(lxw_worksheet *self, lxw_row_t row_num)
+{
+    if (self->rollover_rows && row_num >= self->rollover_rows)
+        return LXW_ERROR_WORKSHEET_INDEX_OUT_OF_RANGE;
+
+    return LXW_NO_ERROR;
+}
+
+/*
+ * Check that row and col are within the allowed Excel range and store max
+ * and min values for use in other methods/elements.
+ *
+ * The ignore_row/ignore_col flags are used to indicate that we wish to
+ * perform the dimension check without storing the value.
+ */
+STATIC lxw_error
+_check_dimensions(lxw_worksheet *self,
+                  lxw_row_t row_num,
+                  lxw_col_t col_num, int8_t ignore_row, int8_t ignore_col)
 {
     if (row_num >= LXW_ROW_MAX)
         return LXW_ERROR_WORKSHEET_INDEX_OUT_OF_RANGE;
@@ -1267,10 +2159,11 @@ _check_dimensions(lxw_worksheet *self,
     if (col_num >= LXW_COL_MAX)
         return LXW_ERROR_WORKSHEET_INDEX_OUT_OF_RANGE;
 
-    /* In optimization mode we don't change dimensions for rows that are */
-    /* already written. */
-    if (!ignore_row && !ignore_col && self->optimize) {
-        if (row_num < self->optimize_row->row_num)
+    if (!ignore_row && _check_rollover_limit(self, row_num))
+        return LXW_ERROR_WORKSHEET_INDEX_OUT_OF_RANGE;
+
+    if (!ignore_row && !ignore_col) {
+        if (_check_row_owner(self, row_num))
             return LXW_ERROR_WORKSHEET_INDEX_OUT_OF_RANGE;
     }
 
@@ -1291,6 +2184,75 @@ _check_dimensions(lxw_worksheet *self,
     return LXW_NO_ERROR;
 }
 
+/* The types of data that are validated for trusted input. */
+enum lxw_trusted_data {
+    LXW_TRUSTED_NUMBER = 0,
+    LXW_TRUSTED_STRING,
+    LXW_TRUSTED_FORMULA
+};
+
+/*
+ * Update the dimensions of the worksheet for a cell written with trusted
+ * input, without the range, string and format validation in
+ * _check_dimensions(). The rows that the worksheet owns are still checked
+ * since a cell written outside them would be dropped. If the library is
+ * compiled with USE_TRUSTED_INPUT_CHECKS the full validation is done and any
+ * errors in the trusted input are reported. This can be used to test that
+ * the data passed to a worksheet with trusted input is valid.
+ */
+STATIC lxw_error
+_check_trusted_cell(lxw_worksheet *self, lxw_row_t row_num,
+                    lxw_col_t col_num, const char *string,
+                    enum lxw_trusted_data data_type)
+{
+#ifdef USE_TRUSTED_INPUT_CHECKS
+    lxw_error err;
+
+    err = _check_dimensions(self, row_num, col_num, LXW_FALSE, LXW_FALSE);
+
+    if (!err && data_type != LXW_TRUSTED_NUMBER) {
+        if (!string)
+            err = LXW_ERROR_NULL_PARAMETER_IGNORED;
+        else if (!*string)
+            err = LXW_ERROR_PARAMETER_IS_EMPTY;
+    }
+
+    if (!err && data_type == LXW_TRUSTED_STRING) {
+        if (lxw_utf8_strlen(string) > LXW_STR_MAX)
+            err = LXW_ERROR_MAX_STRING_LENGTH_EXCEEDED;
+        else if (self->optimize && lxw_has_control_characters(string))
+            err = LXW_ERROR_PARAMETER_VALIDATION;
+    }
+
+    if (err)
+        LXW_WARN_FORMAT3("worksheet_set_trusted_input(): invalid input "
+                         "for cell (%u, %u): %s", row_num, col_num,
+                         lxw_strerror(err));
+
+    return err;
+#else
+    lxw_error err;
+
+    (void) string;
+    (void) data_type;
+
+    err = _check_row_owner(self, row_num);
+    if (err)
+        return err;
+
+    if (row_num < self->dim_rowmin)
+        self->dim_rowmin = row_num;
+    if (row_num > self->dim_rowmax)
+        self->dim_rowmax = row_num;
+    if (col_num < self->dim_colmin)
+        self->dim_colmin = col_num;
+    if (col_num > self->dim_colmax)
+        self->dim_colmax = col_num;
+
+    return LXW_NO_ERROR;
+#endif
+}
+
 /*
  * Comparator for the row structure red/black tree.
  */
@@ -1336,6 +2298,18 @@ _cond_format_hash_cmp(lxw_cond_format_hash_element *elem_1,
     return strcmp(elem_1->sqref, elem_2->sqref);
 }
 
+/*
+ * Comparator for the url table red/black tree.
+ */
+STATIC int
+_url_element_cmp(lxw_url_element *element1, lxw_url_element *element2)
+{
+    if (element1->is_normalized != element2->is_normalized)
+        return element1->is_normalized < element2->is_normalized ? -1 : 1;
+
+    return strcmp(element1->key, element2->key);
+}
+
 /*
  * Get the index used to address a drawing rel link.
  */
@@ -1460,6 +2434,156 @@ _find_vml_drawing_rel_index(lxw_worksheet *self, char *target)
         return 0;
 }
 
+/*
+ * Normalize a hyperlink url in a single pass. The url is split from any
+ * "#location" anchor and, for url and external links, special characters are
+ * escaped as %XX. External links also have their directory separators
+ * converted to DOS style and the file:/// scheme added for absolute paths.
+ *
+ * The buffer must have room for 3 * strlen(url) + sizeof("file:///") bytes.
+ * The function returns the start of the normalized url within the buffer and
+ * sets its length in UTF-8 characters and the location anchor, if any.
+ */
+STATIC char *
+_normalize_url(char *buffer, const char *url, enum cell_types link_type,
+               size_t *url_length, const char **location)
+{
+    static const char hex_digits[] = "0123456789abcdef";
+    size_t prefix_len = sizeof("file:///") - 1;
+    char *start = buffer + prefix_len;
+    char *dest = start;
+    size_t char_count = 0;
+    uint8_t escape = link_type != HYPERLINK_INTERNAL;
+    uint8_t is_external = link_type == HYPERLINK_EXTERNAL;
+    uint8_t is_absolute = LXW_FALSE;
+    unsigned char c;
+
+    *location = NULL;
+
+    for (; *url; url++) {
+        c = (unsigned char) *url;
+
+        /* Split the url into the link and optional anchor/location. */
+        if (c == '#') {
+            *location = url + 1;
+            break;
+        }
+
+        if (escape) {
+            switch (c) {
+                case '%':
+                    /* Only escape % if it isn't already an escape. */
+                    if (isxdigit((unsigned char) url[1])
+                        && isxdigit((unsigned char) url[2]))
+                        break;
+                    /* Fall through. */
+                case ' ':
+                case '"':
+                case '<':
+                case '>':
+                case '[':
+                case ']':
+                case '`':
+                case '^':
+                case '{':
+                case '}':
+                    *dest++ = '%';
+                    *dest++ = hex_digits[c >> 4];
+                    *dest++ = hex_digits[c & 0x0F];
+                    char_count += 3;
+                    continue;
+            }
+        }
+
+        if (is_external) {
+            /* For external links change the dir separator to DOS style. */
+            if (c == '/')
+                c = '\\';
+
+            /* Look for Windows style "C:/" link or Windows share "\\". */
+            if (c == ':' || (c == '\\' && dest > start && dest[-1] == '\\'))
+                is_absolute = LXW_TRUE;
+        }
+
+        *dest++ = (char) c;
+
+        if ((c & 0xC0) != 0x80)
+            char_count++;
+    }
+
+    *dest = '\0';
+
+    if (is_external) {
+        if (is_absolute) {
+            /* Add the file:/// URI to the url if non-local. */
+            start -= prefix_len;
+            memcpy(start, "file:///", prefix_len);
+            char_count += prefix_len;
+        }
+        else if (start[0] == '.' && start[1] == '\\') {
+            /* Convert a ./dir/file.xlsx link to dir/file.xlsx. */
+            start += 2;
+            char_count -= 2;
+        }
+    }
+
+    *url_length = char_count;
+
+    return start;
+}
+
+/*
+ * Find a url in the url table. The key is the url as written by the user or,
+ * if is_normalized is set, a normalized url read from a checkpoint.
+ */
+STATIC lxw_url_element *
+_get_url_element(struct lxw_url_table *url_table, const char *key,
+                 uint8_t is_normalized)
+{
+    lxw_url_element tmp_element;
+
+    tmp_element.key = (char *) key;
+    tmp_element.is_normalized = is_normalized;
+
+    return RB_FIND(lxw_url_table, url_table, &tmp_element);
+}
+
+/*
+ * Add a url and its normalized form to the url table. This allows repeated
+ * hyperlink targets to be normalized and stored once per workbook.
+ */
+STATIC lxw_url_element *
+_new_url_element(struct lxw_url_table *url_table, const char *key,
+                 const char *url, size_t url_length, uint8_t is_normalized)
+{
+    lxw_url_element *element = calloc(1, sizeof(lxw_url_element));
+    RETURN_ON_MEM_ERROR(element, NULL);
+
+    element->url = lxw_strdup(url);
+    GOTO_LABEL_ON_MEM_ERROR(element->url, mem_error);
+
+    if (is_normalized) {
+        element->key = element->url;
+    }
+    else {
+        element->key = lxw_strdup(key);
+        GOTO_LABEL_ON_MEM_ERROR(element->key, mem_error);
+    }
+
+    element->url_length = url_length;
+    element->is_normalized = is_normalized;
+
+    url_table->unique_count++;
+    RB_INSERT(lxw_url_table, url_table, element);
+
+    return element;
+
+mem_error:
+    free(element->url);
+    free(element);
+    return NULL;
+}
+
 /*
  * Simple replacement for libgen.h basename() for compatibility with MSVC. It
  * handles forward and back slashes. It doesn't copy exactly the return
@@ -1542,6 +2666,140 @@ _validation_list_to_csv(const char **list)
     return str;
 }
 
+/*
+ * Hash the strings of a data validation list, including the NUL terminators,
+ * and get the number of strings, the storage size and the CSV length.
+ */
+STATIC uint64_t
+_hash_validation_list(const char **list, uint32_t *num_items,
+                      size_t *data_size, size_t *length)
+{
+    /* The 64 bit FNV-1a constants are built from 32 bit parts for C89. */
+    uint64_t hash = (uint64_t) 0xcbf29ce4 << 32 | 0x84222325;
+    uint64_t prime = (uint64_t) 0x100 << 32 | 0x000001b3;
+    const char *str;
+    uint32_t i;
+
+    *data_size = 0;
+    *length = 0;
+
+    for (i = 0; list[i]; i++) {
+        str = list[i];
+
+        do {
+            hash ^= (unsigned char) *str;
+            hash *= prime;
+        } while (*str++);
+
+        *data_size += str - list[i];
+        *length += 1 + lxw_utf8_strlen(list[i]);
+    }
+
+    /* Adjust the length for the extraneous comma at the end. */
+    if (*length)
+        (*length)--;
+
+    *num_items = i;
+
+    return hash;
+}
+
+/*
+ * Check if a shared data validation list has the same strings as a list.
+ */
+STATIC uint8_t
+_validation_list_matches(lxw_validation_list *shared, const char **list,
+                         uint32_t num_items, size_t data_size)
+{
+    const char *data = shared->data;
+    uint32_t i;
+
+    if (shared->num_items != num_items || shared->data_size != data_size)
+        return LXW_FALSE;
+
+    for (i = 0; i < num_items; i++) {
+        if (strcmp(data, list[i]) != 0)
+            return LXW_FALSE;
+
+        data += strlen(data) + 1;
+    }
+
+    return LXW_TRUE;
+}
+
+/*
+ * Find or add a data validation list in the workbook shared lists. Lists are
+ * found by hash and then compared in full so that hash collisions are
+ * stored as separate lists.
+ */
+STATIC lxw_validation_list *
+_get_shared_validation_list(struct lxw_validation_lists *lists,
+                            const char **list)
+{
+    lxw_hash_element *element;
+    lxw_validation_list *shared;
+    lxw_validation_list *last = NULL;
+    uint32_t num_items;
+    size_t data_size;
+    size_t length;
+    uint64_t hash;
+    char *data;
+    uint32_t i;
+
+    hash = _hash_validation_list(list, &num_items, &data_size, &length);
+
+    element = lxw_hash_key_exists(lists->hashes, &hash, sizeof(uint64_t));
+
+    if (element) {
+        for (shared = element->value; shared; shared = shared->next_same_hash) {
+            if (_validation_list_matches(shared, list, num_items, data_size)) {
+                shared->use_count++;
+                return shared;
+            }
+
+            last = shared;
+        }
+    }
+
+    shared = calloc(1, sizeof(lxw_validation_list));
+    RETURN_ON_MEM_ERROR(shared, NULL);
+
+    shared->data = malloc(data_size);
+    GOTO_LABEL_ON_MEM_ERROR(shared->data, mem_error);
+
+    /* Copy the strings with their NUL terminators. */
+    data = shared->data;
+    for (i = 0; i < num_items; i++) {
+        strcpy(data, list[i]);
+        data += strlen(list[i]) + 1;
+    }
+
+    shared->data_size = data_size;
+    shared->num_items = num_items;
+    shared->length = length;
+    shared->hash = hash;
+    shared->use_count = 1;
+
+    if (last) {
+        last->next_same_hash = shared;
+    }
+    else {
+        element = lxw_insert_hash_element(lists->hashes, &shared->hash,
+                                          shared, sizeof(uint64_t));
+        GOTO_LABEL_ON_MEM_ERROR(element, mem_error);
+    }
+
+    STAILQ_INSERT_TAIL(&lists->lists, shared, list_pointers);
+    lists->count++;
+
+    return shared;
+
+mem_error:
+    free(shared->data);
+    free(shared);
+    return NULL;
+}
+
 STATIC double
 _pixels_to_width(double pixels)
 {
@@ -1863,18 +3121,39 @@ _write_column_function(lxw_worksheet *self, lxw_row_t row, lxw_col_t col,
     worksheet_write_formula_num(self, row, col, formula, format, value);
 }
 
-/* Write a worksheet table column formula. */
+/*
+ * Set up the rows of a worksheet table calculated column. The formula is
+ * stored once in the table column and the formula cells are generated from
+ * it when the rows are written in _worksheet_write_rows(). The row objects
+ * are created here so that the rows are written even if they contain no
+ * other data. Any cells already in the column are replaced by the formula,
+ * as before, but cells written to the column afterwards take precedence.
+ */
 void
 _write_column_formula(lxw_worksheet *self, lxw_row_t first_row,
-                      lxw_row_t last_row, lxw_col_t col,
-                      lxw_table_column *column)
+                      lxw_row_t last_row, lxw_col_t col)
 {
-    lxw_row_t row;
-    const char *formula = column->formula;
-    lxw_format *format = column->format;
+    lxw_row_t row_num;
+    lxw_row *row;
+    lxw_cell *cell;
+
+    for (row_num = first_row; row_num <= last_row; row_num++) {
+        if (_check_dimensions(self, row_num, col, LXW_FALSE, LXW_FALSE))
+            continue;
 
-    for (row = first_row; row <= last_row; row++)
-        worksheet_write_formula(self, row, col, formula, format);
+        row = _get_row(self, row_num);
+        if (!row)
+            continue;
+
+        row->data_changed = LXW_TRUE;
+
+        cell = lxw_worksheet_find_cell_in_row(row, col);
+        if (cell) {
+            _remove_column_stats(self, cell);
+            RB_REMOVE(lxw_table_cells, row->cells, cell);
+            _free_cell(cell);
+        }
+    }
 }
 
 /* Set the defaults for table columns in worksheet_add_table(). */
@@ -1898,6 +3177,9 @@ _write_table_column_data(lxw_worksheet *self, lxw_table_obj *table_obj)
     if (table_obj->total_row)
         last_data_row--;
 
+    table_obj->first_data_row = first_data_row;
+    table_obj->last_data_row = last_data_row;
+
     for (i = 0; i < table_obj->num_cols; i++) {
         col = first_col + i;
         column = columns[i];
@@ -1913,9 +3195,28 @@ _write_table_column_data(lxw_worksheet *self, lxw_table_obj *table_obj)
         if (column->total_function)
             _write_column_function(self, last_row, col, column);
 
-        if (column->formula)
-            _write_column_formula(self, first_data_row, last_data_row, col,
-                                  column);
+        if (column->formula && first_data_row <= last_data_row) {
+            _write_column_formula(self, first_data_row, last_data_row, col);
+
+            if (!table_obj->has_formulas)
+                table_obj->first_formula_col = col;
+
+            table_obj->last_formula_col = col;
+            table_obj->has_formulas = LXW_TRUE;
+        }
+    }
+
+    /* Store the rows covered by all the calculated columns of the sheet. */
+    if (table_obj->has_formulas) {
+        if (!self->has_table_formulas
+            || first_data_row < self->table_formula_first_row)
+            self->table_formula_first_row = first_data_row;
+
+        if (!self->has_table_formulas
+            || last_data_row > self->table_formula_last_row)
+            self->table_formula_last_row = last_data_row;
+
+        self->has_table_formulas = LXW_TRUE;
     }
 }
 
@@ -2534,80 +3835,188 @@ _worksheet_write_sheet_format_pr(lxw_worksheet *self)
 }
 
 /*
- * Write the <sheetData> element.
+ * Get the size of the data in a constant_memory temp file or memory buffer.
  */
-STATIC void
-_worksheet_write_sheet_data(lxw_worksheet *self)
+STATIC size_t
+_worksheet_tmpfile_size(lxw_worksheet *self)
 {
-    if (RB_EMPTY(self->table)) {
-        lxw_xml_empty_tag(self->file, "sheetData", NULL);
-    }
-    else {
-        lxw_xml_start_tag(self->file, "sheetData", NULL);
-        _worksheet_write_rows(self);
-        lxw_xml_end_tag(self->file, "sheetData");
-    }
+    long size;
+
+    fflush(self->optimize_tmpfile);
+
+    if (self->optimize_buffer)
+        return self->optimize_buffer_size;
+
+    size = ftell(self->optimize_tmpfile);
+
+    if (size < 0)
+        return 0;
+    else
+        return (size_t) size;
 }
 
 /*
- * Write the <sheetData> element when the memory optimization is on. In which
- * case we read the data stored in the temp file and rewrite it to the XML
- * sheet file.
+ * Copy a range of the data in the constant_memory temp file, or memory
+ * buffer, of a worksheet or segment to the worksheet XML file.
  */
 STATIC void
-_worksheet_write_optimized_sheet_data(lxw_worksheet *self)
+_worksheet_copy_tmpfile(lxw_worksheet *self, lxw_worksheet *source,
+                        size_t start, size_t end)
 {
-    size_t read_size = 1;
+    size_t read_size;
+    size_t remaining = end - start;
     char buffer[LXW_BUFFER_SIZE];
 
-    if (self->dim_rowmin == LXW_ROW_MAX) {
-        /* If the dimensions aren't defined then there is no data to write. */
-        lxw_xml_empty_tag(self->file, "sheetData", NULL);
+    if (start >= end)
+        return;
+
+    /* Binary row records are converted to XML rather than copied. */
+    if (source->binary_tmpfile) {
+        _worksheet_render_row_records(self, source, start, end);
+        return;
     }
-    else {
 
-        lxw_xml_start_tag(self->file, "sheetData", NULL);
+    if (source->optimize_buffer) {
+        /* Ignore return value. There is no easy way to raise error. */
+        (void) fwrite(source->optimize_buffer + start, 1, remaining,
+                      self->file);
+        return;
+    }
 
-        /* Flush the temp file. */
-        fflush(self->optimize_tmpfile);
+    if (fseek(source->optimize_tmpfile, (long) start, SEEK_SET))
+        return;
 
-        if (self->optimize_buffer) {
-            /* Ignore return value. There is no easy way to raise error. */
-            (void) fwrite(self->optimize_buffer, self->optimize_buffer_size,
-                          1, self->file);
-        }
-        else {
-            /* Rewind the temp file. */
-            rewind(self->optimize_tmpfile);
-            while (read_size) {
-                read_size =
-                    fread(buffer, 1, LXW_BUFFER_SIZE, self->optimize_tmpfile);
-                /* Ignore return value. There is no easy way to raise error. */
-                (void) fwrite(buffer, 1, read_size, self->file);
-            }
-        }
+    while (remaining) {
+        read_size = remaining < LXW_BUFFER_SIZE ? remaining : LXW_BUFFER_SIZE;
+        read_size = fread(buffer, 1, read_size, source->optimize_tmpfile);
 
-        fclose(self->optimize_tmpfile);
-        free(self->optimize_buffer);
+        if (!read_size)
+            break;
 
-        lxw_xml_end_tag(self->file, "sheetData");
+        /* Ignore return value. There is no easy way to raise error. */
+        (void) fwrite(buffer, 1, read_size, self->file);
+        remaining -= read_size;
     }
 }
 
 /*
- * Write the <pageMargins> element.
+ * Copy the row data of a segment to the worksheet XML file and release the
+ * segment temp file.
  */
 STATIC void
-_worksheet_write_page_margins(lxw_worksheet *self)
+_worksheet_write_segment(lxw_worksheet *self, lxw_worksheet *segment)
 {
-    struct xml_attribute_list attributes;
-    struct xml_attribute *attribute;
-    double left = self->margin_left;
-    double right = self->margin_right;
-    double top = self->margin_top;
-    double bottom = self->margin_bottom;
-    double header = self->margin_header;
-    double footer = self->margin_footer;
+    if (!segment->optimize_tmpfile)
+        return;
+
+    _worksheet_copy_tmpfile(self, segment, 0,
+                            _worksheet_tmpfile_size(segment));
+
+    fclose(segment->optimize_tmpfile);
+    free(segment->optimize_buffer);
+
+    segment->optimize_tmpfile = NULL;
+    segment->optimize_buffer = NULL;
+    segment->file = NULL;
+}
+
+/*
+ * Check if any of the worksheet segments contain row data.
+ */
+STATIC uint8_t
+_worksheet_has_segment_data(lxw_worksheet *self)
+{
+    lxw_worksheet *segment;
+
+    STAILQ_FOREACH(segment, self->segments, list_pointers) {
+        if (segment->dim_rowmin != LXW_ROW_MAX)
+            return LXW_TRUE;
+    }
+
+    return LXW_FALSE;
+}
+
+/*
+ * Write the <sheetData> element.
+ */
+STATIC void
+_worksheet_write_sheet_data(lxw_worksheet *self)
+{
+    _worksheet_use_cells(self);
+
+    if (RB_EMPTY(self->table) && !_worksheet_has_segment_data(self)) {
+        lxw_xml_empty_tag(self->file, "sheetData", NULL);
+    }
+    else {
+        lxw_xml_start_tag(self->file, "sheetData", NULL);
+        _worksheet_write_rows(self);
+        lxw_xml_end_tag(self->file, "sheetData");
+    }
+}
+
+/*
+ * Write the <sheetData> element when the memory optimization is on. In which
+ * case we read the data stored in the temp file and rewrite it to the XML
+ * sheet file. Any segments are written in row order between the worksheet
+ * rows, using the temp file offsets stored when the rows were written.
+ */
+STATIC void
+_worksheet_write_optimized_sheet_data(lxw_worksheet *self)
+{
+    lxw_worksheet *segment;
+    size_t offset = 0;
+    size_t size;
+
+    if (self->dim_rowmin == LXW_ROW_MAX) {
+        /* If the dimensions aren't defined then there is no data to write. */
+        lxw_xml_empty_tag(self->file, "sheetData", NULL);
+    }
+    else {
+
+        lxw_xml_start_tag(self->file, "sheetData", NULL);
+
+        /* The pinned rows come before the rows in the temp file. */
+        _worksheet_write_pinned_rows(self);
+
+        size = _worksheet_tmpfile_size(self);
+
+        STAILQ_FOREACH(segment, self->segments, list_pointers) {
+            if (segment->segment_offset_set) {
+                _worksheet_copy_tmpfile(self, self, offset,
+                                        segment->segment_offset);
+                offset = segment->segment_offset;
+            }
+            else {
+                _worksheet_copy_tmpfile(self, self, offset, size);
+                offset = size;
+            }
+
+            _worksheet_write_segment(self, segment);
+        }
+
+        _worksheet_copy_tmpfile(self, self, offset, size);
+
+        fclose(self->optimize_tmpfile);
+        free(self->optimize_buffer);
+
+        lxw_xml_end_tag(self->file, "sheetData");
+    }
+}
+
+/*
+ * Write the <pageMargins> element.
+ */
+STATIC void
+_worksheet_write_page_margins(lxw_worksheet *self)
+{
+    struct xml_attribute_list attributes;
+    struct xml_attribute *attribute;
+    double left = self->margin_left;
+    double right = self->margin_right;
+    double top = self->margin_top;
+    double bottom = self->margin_bottom;
+    double header = self->margin_header;
+    double footer = self->margin_footer;
 
     LXW_INIT_ATTRIBUTES();
     LXW_PUSH_ATTRIBUTES_DBL("left", left);
@@ -3919,7832 +5328,12242 @@ mem_error:
 }
 
 /*
- * Extract width and height information from a PNG file.
+ * Set up the external linkage and ids for the worksheet pivot tables.
  */
-STATIC lxw_error
-_process_png(lxw_object_properties *object_props)
+void
+lxw_worksheet_prepare_pivot_tables(lxw_worksheet *self, uint32_t pivot_id)
 {
-    uint32_t length;
-    uint32_t offset;
-    char type[4];
-    uint32_t width = 0;
-    uint32_t height = 0;
-    double x_dpi = 96;
-    double y_dpi = 96;
-    int fseek_err;
-
-    FILE *stream = object_props->stream;
-
-    /* Skip another 4 bytes to the end of the PNG header. */
-    fseek_err = fseek(stream, 4, SEEK_CUR);
-    if (fseek_err)
-        goto file_error;
-
-    while (!feof(stream)) {
-
-        /* Read the PNG length and type fields for the sub-section. */
-        if (fread(&length, sizeof(length), 1, stream) < 1)
-            break;
+    lxw_pivot_table_obj *pivot_obj;
+    lxw_rel_tuple *relationship = NULL;
+    char name[LXW_ATTR_32];
+    char filename[LXW_FILENAME_LENGTH];
 
-        if (fread(&type, 1, 4, stream) < 4)
-            break;
+    STAILQ_FOREACH(pivot_obj, self->pivot_table_objs, list_pointers) {
 
-        /* Convert the length to network order. */
-        length = LXW_UINT32_NETWORK(length);
+        relationship = calloc(1, sizeof(lxw_rel_tuple));
+        GOTO_LABEL_ON_MEM_ERROR(relationship, mem_error);
 
-        /* The offset for next fseek() is the field length + type length. */
-        offset = length + 4;
+        relationship->type = lxw_strdup("/pivotTable");
+        GOTO_LABEL_ON_MEM_ERROR(relationship->type, mem_error);
 
-        if (memcmp(type, "IHDR", 4) == 0) {
-            if (fread(&width, sizeof(width), 1, stream) < 1)
-                break;
+        lxw_snprintf(filename, LXW_FILENAME_LENGTH,
+                     "../pivotTables/pivotTable%d.xml", pivot_id);
 
-            if (fread(&height, sizeof(height), 1, stream) < 1)
-                break;
+        relationship->target = lxw_strdup(filename);
+        GOTO_LABEL_ON_MEM_ERROR(relationship->target, mem_error);
 
-            width = LXW_UINT32_NETWORK(width);
-            height = LXW_UINT32_NETWORK(height);
+        STAILQ_INSERT_TAIL(self->external_pivot_table_links, relationship,
+                           list_pointers);
+        relationship = NULL;
 
-            /* Reduce the offset by the length of previous freads(). */
-            offset -= 8;
+        if (!pivot_obj->name) {
+            lxw_snprintf(name, LXW_ATTR_32, "PivotTable%d", pivot_id);
+            pivot_obj->name = lxw_strdup(name);
+            GOTO_LABEL_ON_MEM_ERROR(pivot_obj->name, mem_error);
         }
+        pivot_obj->id = pivot_id;
+        pivot_id++;
+    }
 
-        if (memcmp(type, "pHYs", 4) == 0) {
-            uint32_t x_ppu = 0;
-            uint32_t y_ppu = 0;
-            uint8_t units = 1;
-
-            if (fread(&x_ppu, sizeof(x_ppu), 1, stream) < 1)
-                break;
+    return;
 
-            if (fread(&y_ppu, sizeof(y_ppu), 1, stream) < 1)
-                break;
+mem_error:
+    if (relationship) {
+        free(relationship->type);
+        free(relationship->target);
+        free(relationship->target_mode);
+        free(relationship);
+    }
 
-            if (fread(&units, sizeof(units), 1, stream) < 1)
-                break;
+    return;
+}
 
-            if (units == 1) {
-                x_ppu = LXW_UINT32_NETWORK(x_ppu);
-                y_ppu = LXW_UINT32_NETWORK(y_ppu);
+/*
+ * Case insensitive match of a cell string with an autofilter string that can
+ * contain the Excel "*" and "?" wildcards. A "~" escapes a wildcard.
+ */
+STATIC uint8_t
+_filter_match_string(const char *str, const char *pattern)
+{
+    const char *star_pattern = NULL;
+    const char *star_str = NULL;
+    const char *ptr;
 
-                x_dpi = (double) x_ppu *0.0254;
-                y_dpi = (double) y_ppu *0.0254;
-            }
+    while (*str) {
+        if (*pattern == '*') {
+            star_pattern = ++pattern;
+            star_str = str;
+            continue;
+        }
 
-            /* Reduce the offset by the length of previous freads(). */
-            offset -= 9;
+        if (*pattern == '?') {
+            pattern++;
+            str++;
+            continue;
         }
 
-        if (memcmp(type, "IEND", 4) == 0)
-            break;
+        ptr = pattern;
+        if (*ptr == '~' && (ptr[1] == '*' || ptr[1] == '?' || ptr[1] == '~'))
+            ptr++;
 
-        if (!feof(stream)) {
-            fseek_err = fseek(stream, offset, SEEK_CUR);
-            if (fseek_err)
-                goto file_error;
+        if (*ptr && tolower((unsigned char) *ptr) == tolower((unsigned char)
+                                                            *str)) {
+            pattern = ptr + 1;
+            str++;
+        }
+        else if (star_pattern) {
+            pattern = star_pattern;
+            str = ++star_str;
+        }
+        else {
+            return LXW_FALSE;
         }
     }
 
-    /* Ensure that we read some valid data from the file. */
-    if (width == 0)
-        goto file_error;
+    while (*pattern == '*')
+        pattern++;
 
-    /* Set the image metadata. */
-    object_props->image_type = LXW_IMAGE_PNG;
-    object_props->width = width;
-    object_props->height = height;
-    object_props->x_dpi = x_dpi ? x_dpi : 96;
-    object_props->y_dpi = y_dpi ? y_dpi : 96;
-    object_props->extension = lxw_strdup("png");
+    return *pattern == '\0';
+}
 
-    return LXW_NO_ERROR;
+/*
+ * Get the value of a cell in the form used to evaluate autofilter rules.
+ * Blank cells and empty strings are returned as LXW_CELL_VALUE_EMPTY and
+ * booleans and formulas with string results as strings.
+ */
+STATIC void
+_get_filter_cell_value(lxw_row *row, lxw_col_t col_num,
+                       lxw_cell_value *value)
+{
+    lxw_cell *cell = lxw_worksheet_find_cell_in_row(row, col_num);
 
-file_error:
-    LXW_WARN_FORMAT1("worksheet image insertion: "
-                     "no size data found in: %s.", object_props->filename);
+    if (!cell || !_get_cell_value(cell, value))
+        value->type = LXW_CELL_VALUE_EMPTY;
 
-    return LXW_ERROR_IMAGE_DIMENSIONS;
+    if (value->type == LXW_CELL_VALUE_FORMULA) {
+        if (cell->user_data2) {
+            value->type = LXW_CELL_VALUE_STRING;
+            value->string = cell->user_data2;
+        }
+        else {
+            value->type = LXW_CELL_VALUE_NUMBER;
+        }
+    }
+    else if (value->type == LXW_CELL_VALUE_BOOLEAN) {
+        value->type = LXW_CELL_VALUE_STRING;
+        value->string = value->number ? "TRUE" : "FALSE";
+    }
+    else if (value->type == LXW_CELL_VALUE_BLANK) {
+        value->type = LXW_CELL_VALUE_EMPTY;
+    }
+
+    if (value->type == LXW_CELL_VALUE_STRING
+        && (!value->string || !*value->string))
+        value->type = LXW_CELL_VALUE_EMPTY;
 }
 
 /*
- * Extract width and height information from a JPEG file.
+ * Check that an autofilter criteria is one that can be evaluated.
  */
-STATIC lxw_error
-_process_jpeg(lxw_object_properties *image_props)
+STATIC uint8_t
+_filter_known_criteria(uint8_t criteria)
 {
-    uint16_t length;
-    uint16_t marker;
-    uint32_t offset;
-    uint16_t width = 0;
-    uint16_t height = 0;
-    double x_dpi = 96;
-    double y_dpi = 96;
-    int fseek_err;
+    return criteria >= LXW_FILTER_CRITERIA_EQUAL_TO
+        && criteria <= LXW_FILTER_CRITERIA_NON_BLANKS;
+}
 
-    FILE *stream = image_props->stream;
+/*
+ * Evaluate a single autofilter criteria against a cell value. Strings are
+ * compared case insensitively and numbers are compared as the text that
+ * Excel displays when the criteria is a string. Formulas are compared using
+ * their cached numeric result and booleans as "TRUE" or "FALSE".
+ */
+STATIC uint8_t
+_filter_match_criteria(lxw_cell_value *value, uint8_t criteria,
+                       const char *criteria_string, double criteria_number)
+{
+    char number[LXW_ATTR_32];
+    const char *str = value->string;
+    char *end;
+    uint8_t type = value->type;
+    uint8_t is_blank = type == LXW_CELL_VALUE_EMPTY;
+    uint8_t match = LXW_FALSE;
+    int cmp;
 
-    /* Read back 2 bytes to the end of the initial 0xFFD8 marker. */
-    fseek_err = fseek(stream, -2, SEEK_CUR);
-    if (fseek_err)
-        goto file_error;
+    if (!_filter_known_criteria(criteria))
+        return LXW_FALSE;
 
-    /* Search through the image data and read the JPEG markers. */
-    while (!feof(stream)) {
+    if (criteria == LXW_FILTER_CRITERIA_BLANKS)
+        return is_blank;
 
-        /* Read the JPEG marker and length fields for the sub-section. */
-        if (fread(&marker, sizeof(marker), 1, stream) < 1)
-            break;
+    if (criteria == LXW_FILTER_CRITERIA_NON_BLANKS)
+        return !is_blank;
 
-        if (fread(&length, sizeof(length), 1, stream) < 1)
-            break;
+    /* Non-blanks rules are stored as "not equal to a space". */
+    if (criteria == LXW_FILTER_CRITERIA_NOT_EQUAL_TO && criteria_string
+        && strcmp(criteria_string, " ") == 0)
+        return !is_blank;
 
-        /* Convert the marker and length to network order. */
-        marker = LXW_UINT16_NETWORK(marker);
-        length = LXW_UINT16_NETWORK(length);
+    if (type == LXW_CELL_VALUE_FORMULA)
+        type = LXW_CELL_VALUE_NUMBER;
 
-        /* The offset for next fseek() is the field length + type length. */
-        offset = length - 2;
+    if (type == LXW_CELL_VALUE_NUMBER) {
+        lxw_sprintf_dbl(number, value->number);
+        str = number;
+    }
+    else if (type == LXW_CELL_VALUE_BOOLEAN) {
+        type = LXW_CELL_VALUE_STRING;
+        str = value->number ? "TRUE" : "FALSE";
+    }
 
-        /* Read the height and width in the 0xFFCn elements (except C4, C8 */
-        /* and CC which aren't SOF markers). */
-        if ((marker & 0xFFF0) == 0xFFC0 && marker != 0xFFC4
-            && marker != 0xFFC8 && marker != 0xFFCC) {
-            /* Skip 1 byte to height and width. */
-            fseek_err = fseek(stream, 1, SEEK_CUR);
-            if (fseek_err)
-                goto file_error;
+    if (type == LXW_CELL_VALUE_STRING && !str)
+        str = "";
 
-            if (fread(&height, sizeof(height), 1, stream) < 1)
-                break;
+    if (criteria == LXW_FILTER_CRITERIA_EQUAL_TO
+        || criteria == LXW_FILTER_CRITERIA_NOT_EQUAL_TO) {
 
-            if (fread(&width, sizeof(width), 1, stream) < 1)
-                break;
+        if (is_blank || !str)
+            match = LXW_FALSE;
+        else if (criteria_string)
+            match = _filter_match_string(str, criteria_string);
+        else
+            match = type == LXW_CELL_VALUE_NUMBER
+                && value->number == criteria_number;
 
-            height = LXW_UINT16_NETWORK(height);
-            width = LXW_UINT16_NETWORK(width);
+        if (criteria == LXW_FILTER_CRITERIA_EQUAL_TO)
+            return match;
+        else
+            return !match;
+    }
 
-            offset -= 9;
-        }
+    /* A string criteria that is a number is compared numerically. */
+    if (criteria_string) {
+        criteria_number = lxw_strtod(criteria_string, &end);
+        if (end != criteria_string && *end == '\0')
+            criteria_string = NULL;
+    }
 
-        /* Read the DPI in the 0xFFE0 element. */
-        if (marker == 0xFFE0) {
-            uint16_t x_density = 0;
-            uint16_t y_density = 0;
-            uint8_t units = 1;
+    if (criteria_string) {
+        if (type != LXW_CELL_VALUE_STRING)
+            return LXW_FALSE;
 
-            fseek_err = fseek(stream, 7, SEEK_CUR);
-            if (fseek_err)
-                goto file_error;
+        cmp = lxw_strcasecmp(str, criteria_string);
+    }
+    else {
+        if (type != LXW_CELL_VALUE_NUMBER)
+            return LXW_FALSE;
 
-            if (fread(&units, sizeof(units), 1, stream) < 1)
-                break;
+        if (value->number < criteria_number)
+            cmp = -1;
+        else if (value->number > criteria_number)
+            cmp = 1;
+        else
+            cmp = 0;
+    }
 
-            if (fread(&x_density, sizeof(x_density), 1, stream) < 1)
-                break;
+    if (criteria == LXW_FILTER_CRITERIA_GREATER_THAN)
+        return cmp > 0;
+    if (criteria == LXW_FILTER_CRITERIA_GREATER_THAN_OR_EQUAL_TO)
+        return cmp >= 0;
+    if (criteria == LXW_FILTER_CRITERIA_LESS_THAN)
+        return cmp < 0;
+    if (criteria == LXW_FILTER_CRITERIA_LESS_THAN_OR_EQUAL_TO)
+        return cmp <= 0;
 
-            if (fread(&y_density, sizeof(y_density), 1, stream) < 1)
-                break;
+    return LXW_FALSE;
+}
 
-            x_density = LXW_UINT16_NETWORK(x_density);
-            y_density = LXW_UINT16_NETWORK(y_density);
+/*
+ * Evaluate an autofilter column rule against a cell value.
+ */
+STATIC uint8_t
+_filter_match_rule(lxw_filter_rule_obj *rule, lxw_cell_value *value)
+{
+    char number[LXW_ATTR_32];
+    const char *str = value->string;
+    uint8_t match1;
+    uint8_t match2;
+    uint16_t i;
 
-            if (units == 1) {
-                x_dpi = x_density;
-                y_dpi = y_density;
-            }
+    if (rule->type == LXW_FILTER_TYPE_STRING_LIST) {
+        if (value->type == LXW_CELL_VALUE_EMPTY)
+            return rule->has_blanks;
 
-            if (units == 2) {
-                x_dpi = x_density * 2.54;
-                y_dpi = y_density * 2.54;
-            }
+        if (value->type == LXW_CELL_VALUE_ERROR)
+            return LXW_FALSE;
 
-            offset -= 12;
+        if (value->type == LXW_CELL_VALUE_NUMBER) {
+            lxw_sprintf_dbl(number, value->number);
+            str = number;
         }
 
-        if (marker == 0xFFDA)
-            break;
-
-        if (!feof(stream)) {
-            fseek_err = fseek(stream, offset, SEEK_CUR);
-            if (fseek_err)
-                break;
+        for (i = 0; i < rule->num_list_filters; i++) {
+            if (lxw_strcasecmp(str, rule->list[i]) == 0)
+                return LXW_TRUE;
         }
+
+        return LXW_FALSE;
     }
 
-    /* Ensure that we read some valid data from the file. */
-    if (width == 0)
-        goto file_error;
+    /* Rows are left visible for criteria that can't be evaluated. */
+    if (!_filter_known_criteria(rule->criteria1))
+        return LXW_TRUE;
 
-    /* Set the image metadata. */
-    image_props->image_type = LXW_IMAGE_JPEG;
-    image_props->width = width;
-    image_props->height = height;
-    image_props->x_dpi = x_dpi ? x_dpi : 96;
-    image_props->y_dpi = y_dpi ? y_dpi : 96;
-    image_props->extension = lxw_strdup("jpeg");
+    if (rule->type != LXW_FILTER_TYPE_SINGLE
+        && !_filter_known_criteria(rule->criteria2))
+        return LXW_TRUE;
 
-    return LXW_NO_ERROR;
+    match1 = _filter_match_criteria(value, rule->criteria1,
+                                    rule->value1_string, rule->value1);
 
-file_error:
-    LXW_WARN_FORMAT1("worksheet image insertion: "
-                     "no size data found in: %s.", image_props->filename);
+    if (rule->type == LXW_FILTER_TYPE_SINGLE)
+        return match1;
 
-    return LXW_ERROR_IMAGE_DIMENSIONS;
+    match2 = _filter_match_criteria(value, rule->criteria2,
+                                    rule->value2_string, rule->value2);
+
+    if (rule->type == LXW_FILTER_TYPE_AND)
+        return match1 && match2;
+    else
+        return match1 || match2;
 }
 
 /*
- * Extract width and height information from a BMP file.
+ * Check if a row matches all the autofilter column rules. A NULL row is a
+ * row without data.
  */
-STATIC lxw_error
-_process_bmp(lxw_object_properties *image_props)
+STATIC uint8_t
+_filter_match_row(lxw_worksheet *self, lxw_row *row)
 {
-    uint32_t width = 0;
-    uint32_t height = 0;
-    double x_dpi = 96;
-    double y_dpi = 96;
-    int fseek_err;
-
-    FILE *stream = image_props->stream;
-
-    /* Skip another 14 bytes to the start of the BMP height/width. */
-    fseek_err = fseek(stream, 14, SEEK_CUR);
-    if (fseek_err)
-        goto file_error;
-
-    if (fread(&width, sizeof(width), 1, stream) < 1)
-        width = 0;
+    lxw_filter_rule_obj *rule;
+    lxw_cell_value value;
+    lxw_col_t i;
 
-    if (fread(&height, sizeof(height), 1, stream) < 1)
-        height = 0;
+    for (i = 0; i < self->num_filter_rules; i++) {
+        rule = self->filter_rules[i];
 
-    /* Ensure that we read some valid data from the file. */
-    if (width == 0)
-        goto file_error;
+        if (!rule)
+            continue;
 
-    height = LXW_UINT32_HOST(height);
-    width = LXW_UINT32_HOST(width);
+        _get_filter_cell_value(row, self->autofilter.first_col + i, &value);
 
-    /* Set the image metadata. */
-    image_props->image_type = LXW_IMAGE_BMP;
-    image_props->width = width;
-    image_props->height = height;
-    image_props->x_dpi = x_dpi;
-    image_props->y_dpi = y_dpi;
-    image_props->extension = lxw_strdup("bmp");
+        if (!_filter_match_rule(rule, &value))
+            return LXW_FALSE;
+    }
 
-    return LXW_NO_ERROR;
+    return LXW_TRUE;
+}
 
-file_error:
-    LXW_WARN_FORMAT1("worksheet image insertion: "
-                     "no size data found in: %s.", image_props->filename);
+/*
+ * Hide a row that doesn't match the autofilter rules.
+ */
+STATIC void
+_hide_filtered_row(lxw_row *row)
+{
+    if (!row)
+        return;
 
-    return LXW_ERROR_IMAGE_DIMENSIONS;
+    row->hidden = LXW_TRUE;
+    row->row_changed = LXW_TRUE;
 }
 
 /*
- * Extract width and height information from a GIF file.
+ * Evaluate the autofilter rules against the data in the autofilter range
+ * and hide the rows that don't match, in one pass over the rows. Rows
+ * without data are only created, and hidden, if blank cells don't match the
+ * rules. Rows that match aren't changed.
  */
-STATIC lxw_error
-_process_gif(lxw_object_properties *image_props)
+void
+lxw_worksheet_prepare_filtered_rows(lxw_worksheet *self)
 {
-    uint16_t width = 0;
-    uint16_t height = 0;
-    double x_dpi = 96;
-    double y_dpi = 96;
-    int fseek_err;
-
-    FILE *stream = image_props->stream;
+    lxw_row *row;
+    lxw_row_t row_num;
+    lxw_row_t next_row_num;
+    lxw_row_t first_row = self->autofilter.first_row + 1;
+    lxw_row_t last_row = self->autofilter.last_row;
+    uint8_t blanks_match;
+
+    if (!self->hide_filtered_rows || !self->autofilter.has_rules
+        || self->optimize || first_row > last_row)
+        return;
 
-    /* Skip another 2 bytes to the start of the GIF height/width. */
-    fseek_err = fseek(stream, 2, SEEK_CUR);
-    if (fseek_err)
-        goto file_error;
+    _worksheet_use_cells(self);
 
-    if (fread(&width, sizeof(width), 1, stream) < 1)
-        width = 0;
+    blanks_match = _filter_match_row(self, NULL);
 
-    if (fread(&height, sizeof(height), 1, stream) < 1)
-        height = 0;
+    /* Find the first row in the autofilter data range. */
+    row = RB_MIN(lxw_table_rows, self->table);
+    while (row && row->row_num < first_row)
+        row = RB_NEXT(lxw_table_rows, root, row);
 
-    /* Ensure that we read some valid data from the file. */
-    if (width == 0)
-        goto file_error;
+    row_num = first_row;
 
-    height = LXW_UINT16_HOST(height);
-    width = LXW_UINT16_HOST(width);
+    while (row_num <= last_row) {
+        if (row && row->row_num <= last_row)
+            next_row_num = row->row_num;
+        else
+            next_row_num = last_row + 1;
 
-    /* Set the image metadata. */
-    image_props->image_type = LXW_IMAGE_GIF;
-    image_props->width = width;
-    image_props->height = height;
-    image_props->x_dpi = x_dpi;
-    image_props->y_dpi = y_dpi;
-    image_props->extension = lxw_strdup("gif");
+        /* Hide the rows without data before the next row, if required. */
+        if (!blanks_match) {
+            for (; row_num < next_row_num; row_num++)
+                _hide_filtered_row(_get_row_list(self->table, row_num));
+        }
 
-    return LXW_NO_ERROR;
+        if (next_row_num > last_row)
+            break;
 
-file_error:
-    LXW_WARN_FORMAT1("worksheet image insertion: "
-                     "no size data found in: %s.", image_props->filename);
+        if (!_filter_match_row(self, row))
+            _hide_filtered_row(row);
 
-    return LXW_ERROR_IMAGE_DIMENSIONS;
+        row = RB_NEXT(lxw_table_rows, root, row);
+        row_num = next_row_num + 1;
+    }
 }
 
 /*
- * Extract information from the image file such as dimension, type, filename,
- * and extension.
+ * The state used to bake the static conditional formats into the cell
+ * formats. The key is the base cell format followed by a bit mask of the
+ * rules that match a cell, and is used to look up the derived formats.
  */
-STATIC lxw_error
-_get_image_properties(lxw_object_properties *image_props)
+typedef struct lxw_cond_format_bake {
+    lxw_cond_format_obj **rules;
+    uint32_t num_rules;
+    lxw_hash_table *formats;
+    unsigned char *key;
+    size_t key_size;
+    uint8_t blanks_match;
+} lxw_cond_format_bake;
+
+/*
+ * Case insensitive check if a string starts with a conditional format text.
+ */
+STATIC uint8_t
+_cond_format_starts_with(const char *str, const char *text)
 {
-    unsigned char signature[4];
-#ifndef USE_NO_MD5
-    uint8_t i;
-    MD5_CTX md5_context;
-    size_t size_read;
-    char buffer[LXW_IMAGE_BUFFER_SIZE];
-    unsigned char md5_checksum[LXW_MD5_SIZE];
-#endif
+    while (*text) {
+        if (tolower((unsigned char) *str) != tolower((unsigned char) *text))
+            return LXW_FALSE;
 
-    /* Read 4 bytes to look for the file header/signature. */
-    if (fread(signature, 1, 4, image_props->stream) < 4) {
-        LXW_WARN_FORMAT1("worksheet image insertion: "
-                         "couldn't read image type for: %s.",
-                         image_props->filename);
-        return LXW_ERROR_IMAGE_DIMENSIONS;
+        str++;
+        text++;
     }
 
-    if (memcmp(&signature[1], "PNG", 3) == 0) {
-        if (_process_png(image_props) != LXW_NO_ERROR)
-            return LXW_ERROR_IMAGE_DIMENSIONS;
-    }
-    else if (signature[0] == 0xFF && signature[1] == 0xD8) {
-        if (_process_jpeg(image_props) != LXW_NO_ERROR)
-            return LXW_ERROR_IMAGE_DIMENSIONS;
-    }
-    else if (memcmp(signature, "BM", 2) == 0) {
-        if (_process_bmp(image_props) != LXW_NO_ERROR)
-            return LXW_ERROR_IMAGE_DIMENSIONS;
-    }
-    else if (memcmp(signature, "GIF8", 4) == 0) {
-        if (_process_gif(image_props) != LXW_NO_ERROR)
-            return LXW_ERROR_IMAGE_DIMENSIONS;
+    return LXW_TRUE;
+}
+
+/*
+ * Evaluate a static conditional format rule against a cell value in the same
+ * way as the formulas that Excel uses for the rule.
+ */
+STATIC uint8_t
+_cond_format_match(lxw_cond_format_obj *cond_format, lxw_cell_value *value)
+{
+    char number[LXW_ATTR_32];
+    const char *str = value->string;
+    const char *text = cond_format->min_value_string;
+    double cell_number = value->number;
+    uint8_t criteria = cond_format->criteria;
+    size_t str_length;
+    size_t text_length;
+
+    if (value->type == LXW_CELL_VALUE_NUMBER) {
+        lxw_sprintf_dbl(number, value->number);
+        str = number;
     }
-    else {
-        LXW_WARN_FORMAT1("worksheet image insertion: "
-                         "unsupported image format for: %s.",
-                         image_props->filename);
-        return LXW_ERROR_IMAGE_DIMENSIONS;
+    else if (value->type == LXW_CELL_VALUE_EMPTY || !str) {
+        str = "";
+        cell_number = 0;
     }
 
-#ifndef USE_NO_MD5
-    /* Calculate an MD5 checksum for the image so that we can remove duplicate
-     * images to reduce the xlsx file size.*/
-    rewind(image_props->stream);
+    if (cond_format->type == LXW_CONDITIONAL_TYPE_BLANKS
+        || cond_format->type == LXW_CONDITIONAL_TYPE_NO_BLANKS) {
 
-    MD5_Init(&md5_context);
+        /* Excel uses LEN(TRIM(cell)) so strings of spaces are blank. */
+        if (value->type == LXW_CELL_VALUE_ERROR)
+            return LXW_FALSE;
 
-    size_read = fread(buffer, 1, LXW_IMAGE_BUFFER_SIZE, image_props->stream);
-    while (size_read) {
-        MD5_Update(&md5_context, buffer, (unsigned long) size_read);
-        size_read =
-            fread(buffer, 1, LXW_IMAGE_BUFFER_SIZE, image_props->stream);
-    }
+        while (*str == ' ')
+            str++;
 
-    MD5_Final(md5_checksum, &md5_context);
+        if (cond_format->type == LXW_CONDITIONAL_TYPE_BLANKS)
+            return *str == '\0';
+        else
+            return *str != '\0';
+    }
 
-    /* Create a 32 char hex string buffer for the MD5 checksum. */
-    image_props->md5 = calloc(1, LXW_MD5_SIZE * 2 + 1);
+    if (cond_format->type == LXW_CONDITIONAL_TYPE_TEXT) {
 
-    /* If this calloc fails we just return and don't remove duplicates. */
-    RETURN_ON_MEM_ERROR(image_props->md5, LXW_NO_ERROR);
+        /* Excel uses SEARCH() or LEFT()/RIGHT() which fail for errors. */
+        if (value->type == LXW_CELL_VALUE_ERROR)
+            return criteria == LXW_CONDITIONAL_CRITERIA_TEXT_NOT_CONTAINING;
 
-    /* Convert the 16 byte MD5 buffer to a 32 char hex string. */
-    for (i = 0; i < LXW_MD5_SIZE; i++) {
-        lxw_snprintf(&image_props->md5[2 * i], 3, "%02x", md5_checksum[i]);
-    }
-#endif
+        if (criteria == LXW_CONDITIONAL_CRITERIA_TEXT_BEGINS_WITH)
+            return _cond_format_starts_with(str, text);
 
-    return LXW_NO_ERROR;
-}
+        if (criteria == LXW_CONDITIONAL_CRITERIA_TEXT_ENDS_WITH) {
+            str_length = strlen(str);
+            text_length = strlen(text);
 
-/* Conditional formats that refer to the same cell sqref range, like A or
- * B1:B9, need to be written as part of one xml structure. Therefore we need
- * to store them in a RB hash/tree keyed by sqref. Within the RB hash element
- * we then store conditional formats that refer to sqref in a STAILQ list. */
-lxw_error
-_store_conditional_format_object(lxw_worksheet *self,
-                                 lxw_cond_format_obj *cond_format)
-{
-    lxw_cond_format_hash_element tmp_hash_element;
-    lxw_cond_format_hash_element *found_hash_element = NULL;
-    lxw_cond_format_hash_element *new_hash_element = NULL;
+            return str_length >= text_length
+                && _cond_format_starts_with(str + str_length - text_length,
+                                            text);
+        }
 
-    /* Create a temp hash element to do the lookup. */
-    LXW_ATTRIBUTE_COPY(tmp_hash_element.sqref, cond_format->sqref);
-    found_hash_element = RB_FIND(lxw_cond_format_hash,
-                                 self->conditional_formats,
-                                 &tmp_hash_element);
+        do {
+            if (_cond_format_starts_with(str, text))
+                return criteria == LXW_CONDITIONAL_CRITERIA_TEXT_CONTAINING;
+        } while (*str++);
 
-    if (found_hash_element) {
-        /* If the RB element exists then add the conditional format to the
-         * list for the sqref range.*/
-        STAILQ_INSERT_TAIL(found_hash_element->cond_formats, cond_format,
-                           list_pointers);
+        return criteria == LXW_CONDITIONAL_CRITERIA_TEXT_NOT_CONTAINING;
     }
-    else {
-        /* Create a new RB hash element. */
-        new_hash_element = calloc(1, sizeof(lxw_cond_format_hash_element));
-        GOTO_LABEL_ON_MEM_ERROR(new_hash_element, mem_error);
 
-        /* Use the sqref as the key. */
-        LXW_ATTRIBUTE_COPY(new_hash_element->sqref, cond_format->sqref);
+    if (value->type == LXW_CELL_VALUE_ERROR)
+        return LXW_FALSE;
 
-        /* Also create the list where we store the cond format objects. */
-        new_hash_element->cond_formats =
-            calloc(1, sizeof(struct lxw_cond_format_list));
-        GOTO_LABEL_ON_MEM_ERROR(new_hash_element->cond_formats, mem_error);
-
-        /* Initialize the list and add the conditional format object. */
-        STAILQ_INIT(new_hash_element->cond_formats);
-        STAILQ_INSERT_TAIL(new_hash_element->cond_formats, cond_format,
-                           list_pointers);
-
-        /* Now insert the RB hash element into the tree. */
-        RB_INSERT(lxw_cond_format_hash, self->conditional_formats,
-                  new_hash_element);
+    /* Excel sorts text and booleans after all numbers. */
+    if (value->type == LXW_CELL_VALUE_STRING) {
+        return criteria == LXW_CONDITIONAL_CRITERIA_NOT_EQUAL_TO
+            || criteria == LXW_CONDITIONAL_CRITERIA_GREATER_THAN
+            || criteria == LXW_CONDITIONAL_CRITERIA_GREATER_THAN_OR_EQUAL_TO
+            || criteria == LXW_CONDITIONAL_CRITERIA_NOT_BETWEEN;
+    }
 
+    switch (criteria) {
+        case LXW_CONDITIONAL_CRITERIA_EQUAL_TO:
+            return cell_number == cond_format->min_value;
+        case LXW_CONDITIONAL_CRITERIA_NOT_EQUAL_TO:
+            return cell_number != cond_format->min_value;
+        case LXW_CONDITIONAL_CRITERIA_GREATER_THAN:
+            return cell_number > cond_format->min_value;
+        case LXW_CONDITIONAL_CRITERIA_LESS_THAN:
+            return cell_number < cond_format->min_value;
+        case LXW_CONDITIONAL_CRITERIA_GREATER_THAN_OR_EQUAL_TO:
+            return cell_number >= cond_format->min_value;
+        case LXW_CONDITIONAL_CRITERIA_LESS_THAN_OR_EQUAL_TO:
+            return cell_number <= cond_format->min_value;
+        case LXW_CONDITIONAL_CRITERIA_BETWEEN:
+            return cell_number >= cond_format->min_value
+                && cell_number <= cond_format->max_value;
+        case LXW_CONDITIONAL_CRITERIA_NOT_BETWEEN:
+            return cell_number < cond_format->min_value
+                || cell_number > cond_format->max_value;
+        default:
+            return LXW_FALSE;
     }
-
-    return LXW_NO_ERROR;
-
-mem_error:
-    free(new_hash_element);
-    return LXW_ERROR_MEMORY_MALLOC_FAILED;
 }
 
-/*****************************************************************************
- *
- * XML file assembly functions.
- *
- ****************************************************************************/
-
 /*
- * Write out a number worksheet cell. Doesn't use the xml functions as an
- * optimization in the inner cell writing loop.
+ * Check if a conditional format rule can be evaluated when the workbook is
+ * closed: a simple rule over data that isn't calculated by Excel.
  */
-STATIC void
-_write_number_cell(lxw_worksheet *self, char *range,
-                   int32_t style_index, lxw_cell *cell)
+STATIC uint8_t
+_cond_format_is_static(lxw_worksheet *self, lxw_cond_format_obj *cond_format)
 {
-#ifdef USE_DTOA_LIBRARY
-    char data[LXW_ATTR_32];
+    lxw_table_obj *table_obj;
+    lxw_row *row;
+    lxw_cell *cell;
+    lxw_cell_value value;
+    lxw_col_t col;
+    uint16_t i;
 
-    lxw_sprintf_dbl(data, cell->u.number);
+    if (cond_format->is_multi_range)
+        return LXW_FALSE;
 
-    if (style_index)
-        fprintf(self->file,
-                "<c r=\"%s\" s=\"%d\"><v>%s</v></c>",
-                range, style_index, data);
-    else
-        fprintf(self->file, "<c r=\"%s\"><v>%s</v></c>", range, data);
-#else
-    if (style_index)
-        fprintf(self->file,
-                "<c r=\"%s\" s=\"%d\"><v>%.16G</v></c>",
-                range, style_index, cell->u.number);
-    else
-        fprintf(self->file,
-                "<c r=\"%s\"><v>%.16G</v></c>", range, cell->u.number);
+    switch (cond_format->type) {
+        case LXW_CONDITIONAL_TYPE_CELL:
+            if (cond_format->min_value_string
+                || cond_format->max_value_string)
+                return LXW_FALSE;
+            break;
+        case LXW_CONDITIONAL_TYPE_TEXT:
+            /* SEARCH() supports wildcards. */
+            if (cond_format->criteria <=
+                LXW_CONDITIONAL_CRITERIA_TEXT_NOT_CONTAINING
+                && strpbrk(cond_format->min_value_string, "*?~"))
+                return LXW_FALSE;
+            break;
+        case LXW_CONDITIONAL_TYPE_BLANKS:
+        case LXW_CONDITIONAL_TYPE_NO_BLANKS:
+            break;
+        default:
+            return LXW_FALSE;
+    }
+
+    /* Rules that match blank cells are baked by writing formatted blank
+     * cells so they are limited to the range of the worksheet data. */
+    value.type = LXW_CELL_VALUE_EMPTY;
+    value.string = NULL;
+    value.number = 0;
+    cond_format->blanks_match = _cond_format_match(cond_format, &value);
+
+    if (cond_format->blanks_match
+        && (self->dim_rowmin == LXW_ROW_MAX
+            || cond_format->first_row < self->dim_rowmin
+            || cond_format->last_row > self->dim_rowmax
+            || cond_format->first_col < self->dim_colmin
+            || cond_format->last_col > self->dim_colmax))
+        return LXW_FALSE;
+
+    /* Formulas, including table calculated columns, are calculated by
+     * Excel. Rich strings are also left to Excel. */
+    STAILQ_FOREACH(table_obj, self->table_objs, list_pointers) {
+        if (!table_obj->has_formulas
+            || cond_format->last_row < table_obj->first_data_row
+            || cond_format->first_row > table_obj->last_data_row)
+            continue;
 
-#endif
-}
+        for (i = 0; i < table_obj->num_cols; i++) {
+            col = table_obj->first_col + i;
 
-/*
- * Write out a string worksheet cell. Doesn't use the xml functions as an
- * optimization in the inner cell writing loop.
- */
-STATIC void
-_write_string_cell(lxw_worksheet *self, char *range,
-                   int32_t style_index, lxw_cell *cell)
-{
+            if (table_obj->columns[i]->formula
+                && col >= cond_format->first_col
+                && col <= cond_format->last_col)
+                return LXW_FALSE;
+        }
+    }
 
-    if (style_index)
-        fprintf(self->file,
-                "<c r=\"%s\" s=\"%d\" t=\"s\"><v>%d</v></c>",
-                range, style_index, cell->u.string_id);
-    else
-        fprintf(self->file,
-                "<c r=\"%s\" t=\"s\"><v>%d</v></c>",
-                range, cell->u.string_id);
-}
+    RB_FOREACH(row, lxw_table_rows, self->table) {
+        if (row->row_num < cond_format->first_row)
+            continue;
 
-/*
- * Write out an inline string. Doesn't use the xml functions as an
- * optimization in the inner cell writing loop.
- */
-STATIC void
-_write_inline_string_cell(lxw_worksheet *self, char *range,
-                          int32_t style_index, lxw_cell *cell)
-{
-    char *string = lxw_escape_data(cell->u.string);
+        if (row->row_num > cond_format->last_row)
+            break;
 
-    /* Add attribute to preserve leading or trailing whitespace. */
-    if (isspace((unsigned char) string[0])
-        || isspace((unsigned char) string[strlen(string) - 1])) {
+        RB_FOREACH(cell, lxw_table_cells, row->cells) {
+            if (cell->col_num < cond_format->first_col)
+                continue;
 
-        if (style_index)
-            fprintf(self->file,
-                    "<c r=\"%s\" s=\"%d\" t=\"inlineStr\"><is>"
-                    "<t xml:space=\"preserve\">%s</t></is></c>",
-                    range, style_index, string);
-        else
-            fprintf(self->file,
-                    "<c r=\"%s\" t=\"inlineStr\"><is>"
-                    "<t xml:space=\"preserve\">%s</t></is></c>",
-                    range, string);
-    }
-    else {
-        if (style_index)
-            fprintf(self->file,
-                    "<c r=\"%s\" s=\"%d\" t=\"inlineStr\">"
-                    "<is><t>%s</t></is></c>", range, style_index, string);
-        else
-            fprintf(self->file,
-                    "<c r=\"%s\" t=\"inlineStr\">"
-                    "<is><t>%s</t></is></c>", range, string);
+            if (cell->col_num > cond_format->last_col)
+                break;
+
+            if (cell->type == FORMULA_CELL
+                || cell->type == ARRAY_FORMULA_CELL
+                || cell->type == DYNAMIC_ARRAY_FORMULA_CELL
+                || cell->type == INLINE_RICH_STRING_CELL)
+                return LXW_FALSE;
+        }
     }
 
-    free(string);
+    return LXW_TRUE;
 }
 
 /*
- * Write out an inline rich string. Doesn't use the xml functions as an
- * optimization in the inner cell writing loop.
+ * Check if the ranges of two conditional formats overlap. The ranges of
+ * multi_range rules aren't stored so they are assumed to overlap.
  */
-STATIC void
-_write_inline_rich_string_cell(lxw_worksheet *self, char *range,
-                               int32_t style_index, lxw_cell *cell)
+STATIC uint8_t
+_cond_format_overlap(lxw_cond_format_obj *cond_format1,
+                     lxw_cond_format_obj *cond_format2)
 {
-    const char *string = cell->u.string;
+    if (cond_format1->is_multi_range || cond_format2->is_multi_range)
+        return LXW_TRUE;
 
-    if (style_index)
-        fprintf(self->file,
-                "<c r=\"%s\" s=\"%d\" t=\"inlineStr\">"
-                "<is>%s</is></c>", range, style_index, string);
-    else
-        fprintf(self->file,
-                "<c r=\"%s\" t=\"inlineStr\">"
-                "<is>%s</is></c>", range, string);
+    return cond_format1->first_row <= cond_format2->last_row
+        && cond_format2->first_row <= cond_format1->last_row
+        && cond_format1->first_col <= cond_format2->last_col
+        && cond_format2->first_col <= cond_format1->last_col;
 }
 
 /*
- * Write out a formula worksheet cell with a numeric result.
+ * Apply the properties of a conditional format to a cell format. These are
+ * the font, number format, fill and border properties that Excel supports
+ * in conditional formats.
  */
 STATIC void
-_write_formula_num_cell(lxw_worksheet *self, lxw_cell *cell)
+_apply_cond_format_properties(lxw_format *format, lxw_format *cf_format)
 {
-    char data[LXW_ATTR_32];
-
-    lxw_sprintf_dbl(data, cell->formula_result);
-    lxw_xml_data_element(self->file, "f", cell->u.string, NULL);
-    lxw_xml_data_element(self->file, "v", data, NULL);
-}
+    if (cf_format->font_color != LXW_COLOR_UNSET)
+        format->font_color = cf_format->font_color;
 
-/*
- * Write out a formula worksheet cell with a numeric result.
- */
-STATIC void
-_write_formula_str_cell(lxw_worksheet *self, lxw_cell *cell)
-{
-    lxw_xml_data_element(self->file, "f", cell->u.string, NULL);
-    lxw_xml_data_element(self->file, "v", cell->user_data2, NULL);
-}
+    if (cf_format->bold)
+        format->bold = cf_format->bold;
 
-/*
- * Write out an array formula worksheet cell with a numeric result.
- */
-STATIC void
-_write_array_formula_num_cell(lxw_worksheet *self, lxw_cell *cell)
-{
-    struct xml_attribute_list attributes;
-    struct xml_attribute *attribute;
-    char data[LXW_ATTR_32];
+    if (cf_format->italic)
+        format->italic = cf_format->italic;
 
-    LXW_INIT_ATTRIBUTES();
-    LXW_PUSH_ATTRIBUTES_STR("t", "array");
-    LXW_PUSH_ATTRIBUTES_STR("ref", cell->user_data1);
+    if (cf_format->underline)
+        format->underline = cf_format->underline;
 
-    lxw_sprintf_dbl(data, cell->formula_result);
+    if (cf_format->font_strikeout)
+        format->font_strikeout = cf_format->font_strikeout;
 
-    lxw_xml_data_element(self->file, "f", cell->u.string, &attributes);
-    lxw_xml_data_element(self->file, "v", data, NULL);
+    if (cf_format->num_format[0] || cf_format->num_format_index) {
+        memcpy(format->num_format, cf_format->num_format,
+               LXW_FORMAT_FIELD_LEN);
+        format->num_format_index = cf_format->num_format_index;
+    }
 
-    LXW_FREE_ATTRIBUTES();
-}
+    if (cf_format->pattern || cf_format->bg_color != LXW_COLOR_UNSET
+        || cf_format->fg_color != LXW_COLOR_UNSET) {
+        format->pattern = cf_format->pattern;
+        format->bg_color = cf_format->bg_color;
+        format->fg_color = cf_format->fg_color;
+    }
 
-/*
- * Write out a boolean worksheet cell.
- */
-STATIC void
-_write_boolean_cell(lxw_worksheet *self, lxw_cell *cell)
-{
-    char data[LXW_ATTR_32];
+    if (cf_format->left) {
+        format->left = cf_format->left;
+        format->left_color = cf_format->left_color;
+    }
 
-    if (cell->u.number == 0.0)
-        data[0] = '0';
-    else
-        data[0] = '1';
+    if (cf_format->right) {
+        format->right = cf_format->right;
+        format->right_color = cf_format->right_color;
+    }
 
-    data[1] = '\0';
+    if (cf_format->top) {
+        format->top = cf_format->top;
+        format->top_color = cf_format->top_color;
+    }
 
-    lxw_xml_data_element(self->file, "v", data, NULL);
+    if (cf_format->bottom) {
+        format->bottom = cf_format->bottom;
+        format->bottom_color = cf_format->bottom_color;
+    }
 }
 
 /*
- * Write out a error worksheet cell.
+ * Get the cell format derived from a base cell format and the rules in the
+ * bit mask of the bake key. The formats are created once and reused.
  */
-STATIC void
-_write_error_cell(lxw_worksheet *self)
+STATIC lxw_format *
+_get_baked_format(lxw_worksheet *self, lxw_cond_format_bake *bake,
+                  lxw_format *base_format)
 {
-    lxw_xml_data_element(self->file, "v", "#VALUE!", NULL);
-}
+    lxw_hash_element *element;
+    lxw_format *format;
+    lxw_format tmp_format;
+    unsigned char *mask = bake->key + sizeof(lxw_format *);
+    unsigned char *key;
+    uint32_t i;
 
-/*
- * Calculate the "spans" attribute of the <row> tag. This is an XLSX
- * optimization and isn't strictly required. However, it makes comparing
- * files easier.
- *
- * The span is the same for each block of 16 rows.
- */
-STATIC void
-_calculate_spans(struct lxw_row *row, char *span, int32_t *block_num)
-{
-    lxw_cell *cell_min = RB_MIN(lxw_table_cells, row->cells);
-    lxw_cell *cell_max = RB_MAX(lxw_table_cells, row->cells);
-    lxw_col_t span_col_min = cell_min->col_num;
-    lxw_col_t span_col_max = cell_max->col_num;
-    lxw_col_t col_min;
-    lxw_col_t col_max;
-    *block_num = row->row_num / 16;
+    memcpy(bake->key, &base_format, sizeof(lxw_format *));
 
-    row = RB_NEXT(lxw_table_rows, root, row);
+    element = lxw_hash_key_exists(bake->formats, bake->key, bake->key_size);
+    if (element)
+        return element->value;
 
-    while (row && (int32_t) (row->row_num / 16) == *block_num) {
+    format = workbook_add_format(self->workbook);
+    RETURN_ON_MEM_ERROR(format, NULL);
 
-        if (!RB_EMPTY(row->cells)) {
-            cell_min = RB_MIN(lxw_table_cells, row->cells);
-            cell_max = RB_MAX(lxw_table_cells, row->cells);
-            col_min = cell_min->col_num;
-            col_max = cell_max->col_num;
+    /* Copy the base format properties but not its workbook links. */
+    if (base_format) {
+        tmp_format = *format;
+        memcpy(format, base_format, sizeof(lxw_format));
 
-            if (col_min < span_col_min)
-                span_col_min = col_min;
+        format->xf_format_indices = tmp_format.xf_format_indices;
+        format->dxf_format_indices = tmp_format.dxf_format_indices;
+        format->num_xf_formats = tmp_format.num_xf_formats;
+        format->num_dxf_formats = tmp_format.num_dxf_formats;
+        format->list_pointers = tmp_format.list_pointers;
+        format->xf_index = LXW_PROPERTY_UNSET;
+        format->dxf_index = LXW_PROPERTY_UNSET;
+    }
 
-            if (col_max > span_col_max)
-                span_col_max = col_max;
-        }
+    /* Apply the lowest priority rules first so the highest priority wins. */
+    for (i = bake->num_rules; i > 0; i--) {
+        if (mask[(i - 1) / 8] & (1 << ((i - 1) % 8)))
+            _apply_cond_format_properties(format,
+                                          bake->rules[i - 1]->format);
+    }
 
-        row = RB_NEXT(lxw_table_rows, root, row);
+    key = malloc(bake->key_size);
+    RETURN_ON_MEM_ERROR(key, NULL);
+    memcpy(key, bake->key, bake->key_size);
+
+    element = lxw_insert_hash_element(bake->formats, key, format,
+                                      bake->key_size);
+    if (!element) {
+        free(key);
+        return NULL;
     }
 
-    lxw_snprintf(span, LXW_MAX_CELL_RANGE_LENGTH,
-                 "%d:%d", span_col_min + 1, span_col_max + 1);
+    return format;
 }
 
 /*
- * Write out a generic worksheet cell.
+ * Evaluate the static rules, in priority order, for a cell and set the
+ * derived format of any matching rules. A NULL cell is a cell without data
+ * and a formatted blank cell is added if a rule matches it.
  */
-STATIC void
-_write_cell(lxw_worksheet *self, lxw_cell *cell, lxw_format *row_format)
+STATIC lxw_error
+_bake_cond_format_cell(lxw_worksheet *self, lxw_cond_format_bake *bake,
+                       lxw_row *row, lxw_row_t row_num, lxw_col_t col_num,
+                       lxw_cell *cell)
 {
-    struct xml_attribute_list attributes;
-    struct xml_attribute *attribute;
-    char range[LXW_MAX_CELL_NAME_LENGTH] = { 0 };
-    lxw_row_t row_num = cell->row_num;
-    lxw_col_t col_num = cell->col_num;
-    int32_t style_index = 0;
-
-    lxw_rowcol_to_cell(range, row_num, col_num);
+    lxw_cond_format_obj *cond_format;
+    lxw_cell_value value;
+    lxw_format *base_format = NULL;
+    lxw_format *format;
+    unsigned char *mask = bake->key + sizeof(lxw_format *);
+    uint8_t has_match = LXW_FALSE;
+    uint32_t i;
 
-    if (cell->format) {
-        style_index = lxw_format_get_xf_index(cell->format);
+    if (!cell || !_get_cell_value(cell, &value)) {
+        value.type = LXW_CELL_VALUE_EMPTY;
+        value.string = NULL;
+        value.number = 0;
     }
-    else if (row_format) {
-        style_index = lxw_format_get_xf_index(row_format);
+    else if (value.type == LXW_CELL_VALUE_BLANK) {
+        value.type = LXW_CELL_VALUE_EMPTY;
     }
-    else if (col_num < self->col_formats_max && self->col_formats[col_num]) {
-        style_index = lxw_format_get_xf_index(self->col_formats[col_num]);
+    else if (value.type == LXW_CELL_VALUE_BOOLEAN) {
+        value.type = LXW_CELL_VALUE_STRING;
+        value.string = value.number ? "TRUE" : "FALSE";
     }
 
-    /* Unrolled optimization for most commonly written cell types. */
-    if (cell->type == NUMBER_CELL) {
-        _write_number_cell(self, range, style_index, cell);
-        return;
-    }
+    memset(mask, 0, bake->key_size - sizeof(lxw_format *));
 
-    if (cell->type == STRING_CELL) {
-        _write_string_cell(self, range, style_index, cell);
-        return;
-    }
+    for (i = 0; i < bake->num_rules; i++) {
+        cond_format = bake->rules[i];
 
-    if (cell->type == INLINE_STRING_CELL) {
-        _write_inline_string_cell(self, range, style_index, cell);
-        return;
-    }
+        if (row_num < cond_format->first_row
+            || row_num > cond_format->last_row
+            || col_num < cond_format->first_col
+            || col_num > cond_format->last_col)
+            continue;
 
-    if (cell->type == INLINE_RICH_STRING_CELL) {
-        _write_inline_rich_string_cell(self, range, style_index, cell);
-        return;
-    }
+        if (!_cond_format_match(cond_format, &value))
+            continue;
 
-    /* For other cell types use the general functions. */
-    LXW_INIT_ATTRIBUTES();
-    LXW_PUSH_ATTRIBUTES_STR("r", range);
+        if (cond_format->format) {
+            mask[i / 8] |= 1 << (i % 8);
+            has_match = LXW_TRUE;
+        }
 
-    if (style_index)
-        LXW_PUSH_ATTRIBUTES_INT("s", style_index);
+        if (cond_format->stop_if_true)
+            break;
+    }
 
-    if (cell->type == FORMULA_CELL) {
-        /* If user_data2 is set then the formula has a string result. */
-        if (cell->user_data2)
-            LXW_PUSH_ATTRIBUTES_STR("t", "str");
+    if (!has_match)
+        return LXW_NO_ERROR;
 
-        lxw_xml_start_tag(self->file, "c", &attributes);
+    /* The base format is the cell, row or column format, as in Excel. */
+    if (cell && cell->format)
+        base_format = cell->format;
+    else if (row && row->format)
+        base_format = row->format;
+    else if (col_num < self->col_formats_max)
+        base_format = self->col_formats[col_num];
 
-        if (cell->user_data2)
-            _write_formula_str_cell(self, cell);
-        else
-            _write_formula_num_cell(self, cell);
+    format = _get_baked_format(self, bake, base_format);
+    RETURN_ON_MEM_ERROR(format, LXW_ERROR_MEMORY_MALLOC_FAILED);
 
-        lxw_xml_end_tag(self->file, "c");
-    }
-    else if (cell->type == BLANK_CELL) {
-        if (cell->format)
-            lxw_xml_empty_tag(self->file, "c", &attributes);
-    }
-    else if (cell->type == BOOLEAN_CELL) {
-        LXW_PUSH_ATTRIBUTES_STR("t", "b");
-        lxw_xml_start_tag(self->file, "c", &attributes);
-        _write_boolean_cell(self, cell);
-        lxw_xml_end_tag(self->file, "c");
-    }
-    else if (cell->type == ARRAY_FORMULA_CELL) {
-        lxw_xml_start_tag(self->file, "c", &attributes);
-        _write_array_formula_num_cell(self, cell);
-        lxw_xml_end_tag(self->file, "c");
+    if (cell) {
+        cell->format = format;
     }
-    else if (cell->type == DYNAMIC_ARRAY_FORMULA_CELL) {
-        LXW_PUSH_ATTRIBUTES_STR("cm", "1");
-        lxw_xml_start_tag(self->file, "c", &attributes);
-        _write_array_formula_num_cell(self, cell);
-        lxw_xml_end_tag(self->file, "c");
-    }
-    else if (cell->type == ERROR_CELL) {
-        LXW_PUSH_ATTRIBUTES_STR("t", "e");
-        LXW_PUSH_ATTRIBUTES_DBL("vm", cell->u.number);
-        lxw_xml_start_tag(self->file, "c", &attributes);
-        _write_error_cell(self);
-        lxw_xml_end_tag(self->file, "c");
+    else {
+        cell = _new_blank_cell(row_num, col_num, format);
+        RETURN_ON_MEM_ERROR(cell, LXW_ERROR_MEMORY_MALLOC_FAILED);
+
+        _insert_cell(self, row_num, col_num, cell);
     }
 
-    LXW_FREE_ATTRIBUTES();
+    return LXW_NO_ERROR;
 }
 
 /*
- * Write out the worksheet data as a series of rows and cells.
+ * Bake the static rules into the cells of a row. A NULL row is a row
+ * without data, which is only evaluated if a rule matches blank cells.
  */
-STATIC void
-_worksheet_write_rows(lxw_worksheet *self)
+STATIC lxw_error
+_bake_cond_format_row(lxw_worksheet *self, lxw_cond_format_bake *bake,
+                      lxw_row *row, lxw_row_t row_num)
 {
-    lxw_row *row;
+    lxw_cond_format_obj *cond_format;
     lxw_cell *cell;
-    int32_t block_num = -1;
-    char spans[LXW_MAX_CELL_RANGE_LENGTH] = { 0 };
+    lxw_col_t col_num;
+    lxw_col_t first_col = LXW_COL_MAX;
+    lxw_col_t last_col = 0;
+    lxw_error err;
+    uint32_t i;
 
-    RB_FOREACH(row, lxw_table_rows, self->table) {
+    for (i = 0; i < bake->num_rules; i++) {
+        cond_format = bake->rules[i];
 
-        if (RB_EMPTY(row->cells)) {
-            /* Row contains no cells but has height, format or other data. */
+        if (row_num < cond_format->first_row
+            || row_num > cond_format->last_row)
+            continue;
 
-            /* Write a default span for default rows. */
-            if (self->default_row_set)
-                _write_row(self, row, "1:1");
-            else
-                _write_row(self, row, NULL);
-        }
-        else {
-            /* Row and cell data. */
-            if ((int32_t) row->row_num / 16 > block_num)
-                _calculate_spans(row, spans, &block_num);
+        if (cond_format->first_col < first_col)
+            first_col = cond_format->first_col;
 
-            _write_row(self, row, spans);
+        if (cond_format->last_col > last_col)
+            last_col = cond_format->last_col;
+    }
 
-            if (row->data_changed) {
-                RB_FOREACH(cell, lxw_table_cells, row->cells) {
-                    _write_cell(self, cell, row->format);
-                }
+    if (first_col > last_col)
+        return LXW_NO_ERROR;
 
-                lxw_xml_end_tag(self->file, "row");
-            }
-        }
-    }
-}
+    /* Only the stored cells need to be evaluated if blanks don't match. */
+    if (!bake->blanks_match) {
+        RB_FOREACH(cell, lxw_table_cells, row->cells) {
+            if (cell->col_num < first_col)
+                continue;
 
-/*
- * Write out the worksheet data as a single row with cells. This method is
- * used when memory optimization is on. A single row is written and the data
- * array is reset. That way only one row of data is kept in memory at any one
- * time. We don't write span data in the optimized case since it is optional.
- */
-void
-lxw_worksheet_write_single_row(lxw_worksheet *self)
-{
-    lxw_row *row = self->optimize_row;
-    lxw_col_t col;
+            if (cell->col_num > last_col)
+                break;
 
-    /* skip row if it doesn't contain row formatting, cell data or a comment. */
-    if (!(row->row_changed || row->data_changed))
-        return;
+            err = _bake_cond_format_cell(self, bake, row, row_num,
+                                         cell->col_num, cell);
+            if (err)
+                return err;
+        }
 
-    /* Write the cells if the row contains data. */
-    if (!row->data_changed) {
-        /* Row data only. No cells. */
-        _write_row(self, row, NULL);
+        return LXW_NO_ERROR;
     }
-    else {
-        /* Row and cell data. */
-        _write_row(self, row, NULL);
 
-        for (col = self->dim_colmin; col <= self->dim_colmax; col++) {
-            if (self->array[col]) {
-                _write_cell(self, self->array[col], row->format);
-                _free_cell(self->array[col]);
-                self->array[col] = NULL;
-            }
-        }
+    for (col_num = first_col; col_num <= last_col; col_num++) {
+        cell = lxw_worksheet_find_cell_in_row(row, col_num);
 
-        lxw_xml_end_tag(self->file, "row");
+        err = _bake_cond_format_cell(self, bake, row, row_num, col_num, cell);
+        if (err)
+            return err;
     }
 
-    /* Reset the row. */
-    row->height = LXW_DEF_ROW_HEIGHT;
-    row->format = NULL;
-    row->hidden = LXW_FALSE;
-    row->level = 0;
-    row->collapsed = LXW_FALSE;
-    row->data_changed = LXW_FALSE;
-    row->row_changed = LXW_FALSE;
+    return LXW_NO_ERROR;
 }
 
-/* Process a header/footer image and store it in the correct slot. */
-lxw_error
-_worksheet_set_header_footer_image(lxw_worksheet *self, const char *filename,
-                                   uint8_t image_position)
+/*
+ * Remove the baked rules from the conditional formats that are written to
+ * the worksheet.
+ */
+STATIC void
+_remove_baked_cond_formats(lxw_worksheet *self)
 {
-    FILE *image_stream;
-    const char *description;
-    lxw_object_properties *object_props;
-    char *image_strings[] = { "LH", "CH", "RH", "LF", "CF", "RF" };
+    lxw_cond_format_hash_element *element;
+    lxw_cond_format_hash_element *next_element;
+    lxw_cond_format_obj *cond_format;
+    struct lxw_cond_format_list kept_formats;
 
-    /* Not all slots will have image files. */
-    if (!filename)
-        return LXW_NO_ERROR;
+    for (element = RB_MIN(lxw_cond_format_hash, self->conditional_formats);
+         element; element = next_element) {
 
-    /* Check that the image file exists and can be opened. */
-    image_stream = lxw_fopen(filename, "rb");
-    if (!image_stream) {
-        LXW_WARN_FORMAT1("worksheet_set_header_opt/footer_opt(): "
-                         "file doesn't exist or can't be opened: %s.",
-                         filename);
-        return LXW_ERROR_PARAMETER_VALIDATION;
-    }
+        next_element =
+            RB_NEXT(lxw_cond_format_hash, self->conditional_formats, element);
 
-    /* Use the filename as the default description, like Excel. */
-    description = lxw_basename(filename);
-    if (!description) {
-        LXW_WARN_FORMAT1("worksheet_set_header_opt/footer_opt(): "
-                         "couldn't get basename for file: %s.", filename);
-        fclose(image_stream);
-        return LXW_ERROR_PARAMETER_VALIDATION;
-    }
+        STAILQ_INIT(&kept_formats);
 
-    /* Create a new object to hold the image properties. */
-    object_props = calloc(1, sizeof(lxw_object_properties));
-    if (!object_props) {
-        fclose(image_stream);
-        return LXW_ERROR_MEMORY_MALLOC_FAILED;
-    }
+        while (!STAILQ_EMPTY(element->cond_formats)) {
+            cond_format = STAILQ_FIRST(element->cond_formats);
+            STAILQ_REMOVE_HEAD(element->cond_formats, list_pointers);
 
-    /* Copy other options or set defaults. */
-    object_props->filename = lxw_strdup(filename);
-    object_props->description = lxw_strdup(description);
-    object_props->stream = image_stream;
+            if (cond_format->is_static)
+                _free_cond_format(cond_format);
+            else
+                STAILQ_INSERT_TAIL(&kept_formats, cond_format,
+                                   list_pointers);
+        }
 
-    /* Set VML image position string based on the header/footer/position. */
-    object_props->image_position = lxw_strdup(image_strings[image_position]);
+        while (!STAILQ_EMPTY(&kept_formats)) {
+            cond_format = STAILQ_FIRST(&kept_formats);
+            STAILQ_REMOVE_HEAD(&kept_formats, list_pointers);
+            STAILQ_INSERT_TAIL(element->cond_formats, cond_format,
+                               list_pointers);
+        }
 
-    if (_get_image_properties(object_props) == LXW_NO_ERROR) {
-        *self->header_footer_objs[image_position] = object_props;
-        self->has_header_vml = LXW_TRUE;
-        fclose(image_stream);
-        return LXW_NO_ERROR;
-    }
-    else {
-        _free_object_properties(object_props);
-        fclose(image_stream);
-        return LXW_ERROR_IMAGE_DIMENSIONS;
+        if (STAILQ_EMPTY(element->cond_formats)) {
+            RB_REMOVE(lxw_cond_format_hash, self->conditional_formats,
+                      element);
+            free(element->cond_formats);
+            free(element);
+        }
     }
 }
 
 /*
- * Write the <col> element.
+ * Evaluate the static conditional format rules against the worksheet data
+ * and apply the matching rules to the cell formats, in one pass over the
+ * rows. Rules that can't be evaluated, and rules that overlap them, are
+ * left as conditional formats so that Excel applies the rule priorities.
  */
-STATIC void
-_worksheet_write_col_info(lxw_worksheet *self, lxw_col_options *options)
+void
+lxw_worksheet_bake_conditional_formats(lxw_worksheet *self)
 {
-    struct xml_attribute_list attributes;
-    struct xml_attribute *attribute;
-
-    double width = options->width;
-    uint8_t has_custom_width = LXW_TRUE;
-    int32_t xf_index = 0;
-    double max_digit_width = 7.0;       /* For Calabri 11. */
-    double padding = 5.0;
+    lxw_cond_format_bake bake;
+    lxw_cond_format_hash_element *element;
+    lxw_cond_format_obj *cond_format;
+    lxw_cond_format_obj **rules;
+    lxw_row *row;
+    lxw_row_t row_num;
+    lxw_row_t next_row_num;
+    lxw_row_t first_row = LXW_ROW_MAX;
+    lxw_row_t last_row = 0;
+    lxw_error err = LXW_NO_ERROR;
+    uint32_t num_rules = self->dxf_priority;
+    uint32_t i;
+    uint32_t j;
+    uint8_t changed;
 
-    /* Get the format index. */
-    if (options->format) {
-        xf_index = lxw_format_get_xf_index(options->format);
-    }
+    if (!self->bake_cond_formats || self->optimize || !self->workbook
+        || RB_EMPTY(self->conditional_formats))
+        return;
 
-    /* Check if width is the Excel default. */
-    if (width == LXW_DEF_COL_WIDTH) {
+    _worksheet_use_cells(self);
 
-        /* The default col width changes to 0 for hidden columns. */
-        if (options->hidden)
-            width = 0;
-        else
-            has_custom_width = LXW_FALSE;
+    memset(&bake, 0, sizeof(bake));
 
-    }
+    /* Store the rules in priority order. */
+    rules = calloc(num_rules, sizeof(lxw_cond_format_obj *));
+    GOTO_LABEL_ON_MEM_ERROR(rules, mem_error);
 
-    /* Convert column width from user units to character width. */
-    if (width > 0) {
-        if (width < 1) {
-            width = (uint16_t) (((uint16_t)
-                                 (width * (max_digit_width + padding) + 0.5))
-                                / max_digit_width * 256.0) / 256.0;
-        }
-        else {
-            width = (uint16_t) (((uint16_t)
-                                 (width * max_digit_width + 0.5) + padding)
-                                / max_digit_width * 256.0) / 256.0;
+    RB_FOREACH(element, lxw_cond_format_hash, self->conditional_formats) {
+        STAILQ_FOREACH(cond_format, element->cond_formats, list_pointers) {
+            cond_format->is_static = _cond_format_is_static(self, cond_format);
+            rules[cond_format->dxf_priority - 1] = cond_format;
         }
     }
 
-    LXW_INIT_ATTRIBUTES();
-    LXW_PUSH_ATTRIBUTES_INT("min", 1 + options->firstcol);
-    LXW_PUSH_ATTRIBUTES_INT("max", 1 + options->lastcol);
-    LXW_PUSH_ATTRIBUTES_DBL("width", width);
+    /* Rules that overlap a rule that isn't baked can't be baked either. */
+    do {
+        changed = LXW_FALSE;
 
-    if (xf_index)
-        LXW_PUSH_ATTRIBUTES_INT("style", xf_index);
+        for (i = 0; i < num_rules; i++) {
+            for (j = i + 1; j < num_rules; j++) {
+                if (!rules[i] || !rules[j]
+                    || rules[i]->is_static == rules[j]->is_static
+                    || !_cond_format_overlap(rules[i], rules[j]))
+                    continue;
 
-    if (options->hidden)
-        LXW_PUSH_ATTRIBUTES_STR("hidden", "1");
+                rules[i]->is_static = LXW_FALSE;
+                rules[j]->is_static = LXW_FALSE;
+                changed = LXW_TRUE;
+            }
+        }
+    } while (changed);
 
-    if (has_custom_width)
-        LXW_PUSH_ATTRIBUTES_STR("customWidth", "1");
+    for (i = 0; i < num_rules; i++) {
+        cond_format = rules[i];
 
-    if (options->level)
-        LXW_PUSH_ATTRIBUTES_INT("outlineLevel", options->level);
+        if (!cond_format || !cond_format->is_static)
+            continue;
 
-    if (options->collapsed)
-        LXW_PUSH_ATTRIBUTES_STR("collapsed", "1");
+        rules[bake.num_rules++] = cond_format;
 
-    lxw_xml_empty_tag(self->file, "col", &attributes);
+        if (cond_format->first_row < first_row)
+            first_row = cond_format->first_row;
 
-    LXW_FREE_ATTRIBUTES();
-}
+        if (cond_format->last_row > last_row)
+            last_row = cond_format->last_row;
 
-/*
- * Write the <cols> element and <col> sub elements.
- */
-STATIC void
-_worksheet_write_cols(lxw_worksheet *self)
-{
-    lxw_col_t col;
-
-    if (!self->col_size_changed)
-        return;
-
-    lxw_xml_start_tag(self->file, "cols", NULL);
-
-    for (col = 0; col < self->col_options_max; col++) {
-        if (self->col_options[col])
-            _worksheet_write_col_info(self, self->col_options[col]);
+        if (cond_format->blanks_match)
+            bake.blanks_match = LXW_TRUE;
     }
 
-    lxw_xml_end_tag(self->file, "cols");
-}
-
-/*
- * Write the <mergeCell> element.
- */
-STATIC void
-_worksheet_write_merge_cell(lxw_worksheet *self,
-                            lxw_merged_range *merged_range)
-{
-
-    struct xml_attribute_list attributes;
-    struct xml_attribute *attribute;
-    char ref[LXW_MAX_CELL_RANGE_LENGTH];
-
-    LXW_INIT_ATTRIBUTES();
+    if (!bake.num_rules)
+        goto mem_error;
 
-    /* Convert the merge dimensions to a cell range. */
-    lxw_rowcol_to_range(ref, merged_range->first_row, merged_range->first_col,
-                        merged_range->last_row, merged_range->last_col);
+    bake.rules = rules;
+    bake.key_size = sizeof(lxw_format *) + (bake.num_rules + 7) / 8;
 
-    LXW_PUSH_ATTRIBUTES_STR("ref", ref);
+    bake.key = calloc(1, bake.key_size);
+    GOTO_LABEL_ON_MEM_ERROR(bake.key, mem_error);
 
-    lxw_xml_empty_tag(self->file, "mergeCell", &attributes);
+    bake.formats = lxw_hash_new(128, 1, 0);
+    GOTO_LABEL_ON_MEM_ERROR(bake.formats, mem_error);
 
-    LXW_FREE_ATTRIBUTES();
-}
+    /* Find the first row in the range of the rules. */
+    row = RB_MIN(lxw_table_rows, self->table);
+    while (row && row->row_num < first_row)
+        row = RB_NEXT(lxw_table_rows, root, row);
 
-/*
- * Write the <mergeCells> element.
- */
-STATIC void
-_worksheet_write_merge_cells(lxw_worksheet *self)
-{
-    struct xml_attribute_list attributes;
-    struct xml_attribute *attribute;
-    lxw_merged_range *merged_range;
+    row_num = first_row;
 
-    if (self->merged_range_count) {
-        LXW_INIT_ATTRIBUTES();
+    while (row_num <= last_row) {
+        if (row && row->row_num <= last_row)
+            next_row_num = row->row_num;
+        else
+            next_row_num = last_row + 1;
 
-        LXW_PUSH_ATTRIBUTES_INT("count", self->merged_range_count);
+        /* Evaluate the rows without data before the next row, if required. */
+        if (bake.blanks_match) {
+            for (; row_num < next_row_num && !err; row_num++)
+                err = _bake_cond_format_row(self, &bake, NULL, row_num);
+        }
 
-        lxw_xml_start_tag(self->file, "mergeCells", &attributes);
+        if (err || next_row_num > last_row)
+            break;
 
-        STAILQ_FOREACH(merged_range, self->merged_ranges, list_pointers) {
-            _worksheet_write_merge_cell(self, merged_range);
-        }
-        lxw_xml_end_tag(self->file, "mergeCells");
+        err = _bake_cond_format_row(self, &bake, row, next_row_num);
+        if (err)
+            break;
 
-        LXW_FREE_ATTRIBUTES();
+        row = RB_NEXT(lxw_table_rows, root, row);
+        row_num = next_row_num + 1;
     }
-}
 
-/*
- * Write the <oddHeader> element.
- */
-STATIC void
-_worksheet_write_odd_header(lxw_worksheet *self)
-{
-    lxw_xml_data_element(self->file, "oddHeader", self->header, NULL);
-}
+    /* If there was an error the rules are still written to the worksheet
+     * and Excel applies them over any baked cells. */
+    if (!err)
+        _remove_baked_cond_formats(self);
 
-/*
- * Write the <oddFooter> element.
- */
-STATIC void
-_worksheet_write_odd_footer(lxw_worksheet *self)
-{
-    lxw_xml_data_element(self->file, "oddFooter", self->footer, NULL);
+mem_error:
+    lxw_hash_free(bake.formats);
+    free(bake.key);
+    free(rules);
 }
 
 /*
- * Write the <headerFooter> element.
+ * Extract width and height information from a PNG file.
  */
-STATIC void
-_worksheet_write_header_footer(lxw_worksheet *self)
+STATIC lxw_error
+_process_png(lxw_object_properties *object_props)
 {
-    if (!self->header_footer_changed)
-        return;
+    uint32_t length;
+    uint32_t offset;
+    char type[4];
+    uint32_t width = 0;
+    uint32_t height = 0;
+    double x_dpi = 96;
+    double y_dpi = 96;
+    int fseek_err;
 
-    lxw_xml_start_tag(self->file, "headerFooter", NULL);
+    FILE *stream = object_props->stream;
 
-    if (self->header)
-        _worksheet_write_odd_header(self);
+    /* Skip another 4 bytes to the end of the PNG header. */
+    fseek_err = fseek(stream, 4, SEEK_CUR);
+    if (fseek_err)
+        goto file_error;
 
-    if (self->footer)
-        _worksheet_write_odd_footer(self);
+    while (!feof(stream)) {
 
-    lxw_xml_end_tag(self->file, "headerFooter");
-}
+        /* Read the PNG length and type fields for the sub-section. */
+        if (fread(&length, sizeof(length), 1, stream) < 1)
+            break;
 
-/*
- * Write the <pageSetUpPr> element.
- */
-STATIC void
-_worksheet_write_page_set_up_pr(lxw_worksheet *self)
-{
-    struct xml_attribute_list attributes;
-    struct xml_attribute *attribute;
+        if (fread(&type, 1, 4, stream) < 4)
+            break;
 
-    if (!self->fit_page)
-        return;
+        /* Convert the length to network order. */
+        length = LXW_UINT32_NETWORK(length);
 
-    LXW_INIT_ATTRIBUTES();
-    LXW_PUSH_ATTRIBUTES_STR("fitToPage", "1");
+        /* The offset for next fseek() is the field length + type length. */
+        offset = length + 4;
 
-    lxw_xml_empty_tag(self->file, "pageSetUpPr", &attributes);
+        if (memcmp(type, "IHDR", 4) == 0) {
+            if (fread(&width, sizeof(width), 1, stream) < 1)
+                break;
 
-    LXW_FREE_ATTRIBUTES();
+            if (fread(&height, sizeof(height), 1, stream) < 1)
+                break;
 
-}
+            width = LXW_UINT32_NETWORK(width);
+            height = LXW_UINT32_NETWORK(height);
 
-/*
- * Write the <tabColor> element.
- */
-STATIC void
-_worksheet_write_tab_color(lxw_worksheet *self)
-{
-    struct xml_attribute_list attributes;
-    struct xml_attribute *attribute;
-    char rgb_str[LXW_ATTR_32];
+            /* Reduce the offset by the length of previous freads(). */
+            offset -= 8;
+        }
 
-    if (self->tab_color == LXW_COLOR_UNSET)
-        return;
+        if (memcmp(type, "pHYs", 4) == 0) {
+            uint32_t x_ppu = 0;
+            uint32_t y_ppu = 0;
+            uint8_t units = 1;
 
-    lxw_snprintf(rgb_str, LXW_ATTR_32, "FF%06X",
-                 self->tab_color & LXW_COLOR_MASK);
+            if (fread(&x_ppu, sizeof(x_ppu), 1, stream) < 1)
+                break;
 
-    LXW_INIT_ATTRIBUTES();
-    LXW_PUSH_ATTRIBUTES_STR("rgb", rgb_str);
+            if (fread(&y_ppu, sizeof(y_ppu), 1, stream) < 1)
+                break;
 
-    lxw_xml_empty_tag(self->file, "tabColor", &attributes);
+            if (fread(&units, sizeof(units), 1, stream) < 1)
+                break;
 
-    LXW_FREE_ATTRIBUTES();
-}
+            if (units == 1) {
+                x_ppu = LXW_UINT32_NETWORK(x_ppu);
+                y_ppu = LXW_UINT32_NETWORK(y_ppu);
 
-/*
- * Write the <outlinePr> element.
- */
-STATIC void
-_worksheet_write_outline_pr(lxw_worksheet *self)
-{
-    struct xml_attribute_list attributes;
-    struct xml_attribute *attribute;
+                x_dpi = (double) x_ppu *0.0254;
+                y_dpi = (double) y_ppu *0.0254;
+            }
 
-    if (!self->outline_changed)
-        return;
+            /* Reduce the offset by the length of previous freads(). */
+            offset -= 9;
+        }
 
-    LXW_INIT_ATTRIBUTES();
+        if (memcmp(type, "IEND", 4) == 0)
+            break;
 
-    if (self->outline_style)
-        LXW_PUSH_ATTRIBUTES_STR("applyStyles", "1");
+        if (!feof(stream)) {
+            fseek_err = fseek(stream, offset, SEEK_CUR);
+            if (fseek_err)
+                goto file_error;
+        }
+    }
 
-    if (!self->outline_below)
-        LXW_PUSH_ATTRIBUTES_STR("summaryBelow", "0");
+    /* Ensure that we read some valid data from the file. */
+    if (width == 0)
+        goto file_error;
 
-    if (!self->outline_right)
-        LXW_PUSH_ATTRIBUTES_STR("summaryRight", "0");
+    /* Set the image metadata. */
+    object_props->image_type = LXW_IMAGE_PNG;
+    object_props->width = width;
+    object_props->height = height;
+    object_props->x_dpi = x_dpi ? x_dpi : 96;
+    object_props->y_dpi = y_dpi ? y_dpi : 96;
+    object_props->extension = lxw_strdup("png");
 
-    if (!self->outline_on)
-        LXW_PUSH_ATTRIBUTES_STR("showOutlineSymbols", "0");
+    return LXW_NO_ERROR;
 
-    lxw_xml_empty_tag(self->file, "outlinePr", &attributes);
+file_error:
+    LXW_WARN_FORMAT1("worksheet image insertion: "
+                     "no size data found in: %s.", object_props->filename);
 
-    LXW_FREE_ATTRIBUTES();
+    return LXW_ERROR_IMAGE_DIMENSIONS;
 }
 
 /*
- * Write the <sheetPr> element for Sheet level properties.
+ * Extract width and height information from a JPEG file.
  */
-STATIC void
-_worksheet_write_sheet_pr(lxw_worksheet *self)
+STATIC lxw_error
+_process_jpeg(lxw_object_properties *image_props)
 {
-    struct xml_attribute_list attributes;
-    struct xml_attribute *attribute;
+    uint16_t length;
+    uint16_t marker;
+    uint32_t offset;
+    uint16_t width = 0;
+    uint16_t height = 0;
+    double x_dpi = 96;
+    double y_dpi = 96;
+    int fseek_err;
 
-    if (!self->fit_page
-        && !self->filter_on
-        && self->tab_color == LXW_COLOR_UNSET
-        && !self->outline_changed
-        && !self->vba_codename && !self->is_chartsheet) {
-        return;
-    }
+    FILE *stream = image_props->stream;
 
-    LXW_INIT_ATTRIBUTES();
+    /* Read back 2 bytes to the end of the initial 0xFFD8 marker. */
+    fseek_err = fseek(stream, -2, SEEK_CUR);
+    if (fseek_err)
+        goto file_error;
 
-    if (self->vba_codename)
-        LXW_PUSH_ATTRIBUTES_STR("codeName", self->vba_codename);
+    /* Search through the image data and read the JPEG markers. */
+    while (!feof(stream)) {
 
-    if (self->filter_on)
-        LXW_PUSH_ATTRIBUTES_STR("filterMode", "1");
+        /* Read the JPEG marker and length fields for the sub-section. */
+        if (fread(&marker, sizeof(marker), 1, stream) < 1)
+            break;
 
-    if (self->fit_page || self->tab_color != LXW_COLOR_UNSET
-        || self->outline_changed) {
-        lxw_xml_start_tag(self->file, "sheetPr", &attributes);
-        _worksheet_write_tab_color(self);
-        _worksheet_write_outline_pr(self);
-        _worksheet_write_page_set_up_pr(self);
-        lxw_xml_end_tag(self->file, "sheetPr");
-    }
-    else {
-        lxw_xml_empty_tag(self->file, "sheetPr", &attributes);
+        if (fread(&length, sizeof(length), 1, stream) < 1)
+            break;
+
+        /* Convert the marker and length to network order. */
+        marker = LXW_UINT16_NETWORK(marker);
+        length = LXW_UINT16_NETWORK(length);
+
+        /* The offset for next fseek() is the field length + type length. */
+        offset = length - 2;
+
+        /* Read the height and width in the 0xFFCn elements (except C4, C8 */
+        /* and CC which aren't SOF markers). */
+        if ((marker & 0xFFF0) == 0xFFC0 && marker != 0xFFC4
+            && marker != 0xFFC8 && marker != 0xFFCC) {
+            /* Skip 1 byte to height and width. */
+            fseek_err = fseek(stream, 1, SEEK_CUR);
+            if (fseek_err)
+                goto file_error;
+
+            if (fread(&height, sizeof(height), 1, stream) < 1)
+                break;
+
+            if (fread(&width, sizeof(width), 1, stream) < 1)
+                break;
+
+            height = LXW_UINT16_NETWORK(height);
+            width = LXW_UINT16_NETWORK(width);
+
+            offset -= 9;
+        }
+
+        /* Read the DPI in the 0xFFE0 element. */
+        if (marker == 0xFFE0) {
+            uint16_t x_density = 0;
+            uint16_t y_density = 0;
+            uint8_t units = 1;
+
+            fseek_err = fseek(stream, 7, SEEK_CUR);
+            if (fseek_err)
+                goto file_error;
+
+            if (fread(&units, sizeof(units), 1, stream) < 1)
+                break;
+
+            if (fread(&x_density, sizeof(x_density), 1, stream) < 1)
+                break;
+
+            if (fread(&y_density, sizeof(y_density), 1, stream) < 1)
+                break;
+
+            x_density = LXW_UINT16_NETWORK(x_density);
+            y_density = LXW_UINT16_NETWORK(y_density);
+
+            if (units == 1) {
+                x_dpi = x_density;
+                y_dpi = y_density;
+            }
+
+            if (units == 2) {
+                x_dpi = x_density * 2.54;
+                y_dpi = y_density * 2.54;
+            }
+
+            offset -= 12;
+        }
+
+        if (marker == 0xFFDA)
+            break;
+
+        if (!feof(stream)) {
+            fseek_err = fseek(stream, offset, SEEK_CUR);
+            if (fseek_err)
+                break;
+        }
     }
 
-    LXW_FREE_ATTRIBUTES();
+    /* Ensure that we read some valid data from the file. */
+    if (width == 0)
+        goto file_error;
+
+    /* Set the image metadata. */
+    image_props->image_type = LXW_IMAGE_JPEG;
+    image_props->width = width;
+    image_props->height = height;
+    image_props->x_dpi = x_dpi ? x_dpi : 96;
+    image_props->y_dpi = y_dpi ? y_dpi : 96;
+    image_props->extension = lxw_strdup("jpeg");
+
+    return LXW_NO_ERROR;
+
+file_error:
+    LXW_WARN_FORMAT1("worksheet image insertion: "
+                     "no size data found in: %s.", image_props->filename);
 
+    return LXW_ERROR_IMAGE_DIMENSIONS;
 }
 
 /*
- * Write the <brk> element.
+ * Extract width and height information from a BMP file.
  */
-STATIC void
-_worksheet_write_brk(lxw_worksheet *self, uint32_t id, uint32_t max)
+STATIC lxw_error
+_process_bmp(lxw_object_properties *image_props)
 {
-    struct xml_attribute_list attributes;
-    struct xml_attribute *attribute;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    double x_dpi = 96;
+    double y_dpi = 96;
+    int fseek_err;
 
-    LXW_INIT_ATTRIBUTES();
-    LXW_PUSH_ATTRIBUTES_INT("id", id);
-    LXW_PUSH_ATTRIBUTES_INT("max", max);
-    LXW_PUSH_ATTRIBUTES_STR("man", "1");
+    FILE *stream = image_props->stream;
 
-    lxw_xml_empty_tag(self->file, "brk", &attributes);
+    /* Skip another 14 bytes to the start of the BMP height/width. */
+    fseek_err = fseek(stream, 14, SEEK_CUR);
+    if (fseek_err)
+        goto file_error;
 
-    LXW_FREE_ATTRIBUTES();
-}
+    if (fread(&width, sizeof(width), 1, stream) < 1)
+        width = 0;
 
-/*
- * Write the <rowBreaks> element.
- */
-STATIC void
-_worksheet_write_row_breaks(lxw_worksheet *self)
-{
-    struct xml_attribute_list attributes;
-    struct xml_attribute *attribute;
-    uint16_t count = self->hbreaks_count;
-    uint16_t i;
+    if (fread(&height, sizeof(height), 1, stream) < 1)
+        height = 0;
 
-    if (!count)
-        return;
+    /* Ensure that we read some valid data from the file. */
+    if (width == 0)
+        goto file_error;
 
-    LXW_INIT_ATTRIBUTES();
-    LXW_PUSH_ATTRIBUTES_INT("count", count);
-    LXW_PUSH_ATTRIBUTES_INT("manualBreakCount", count);
+    height = LXW_UINT32_HOST(height);
+    width = LXW_UINT32_HOST(width);
 
-    lxw_xml_start_tag(self->file, "rowBreaks", &attributes);
+    /* Set the image metadata. */
+    image_props->image_type = LXW_IMAGE_BMP;
+    image_props->width = width;
+    image_props->height = height;
+    image_props->x_dpi = x_dpi;
+    image_props->y_dpi = y_dpi;
+    image_props->extension = lxw_strdup("bmp");
 
-    for (i = 0; i < count; i++)
-        _worksheet_write_brk(self, self->hbreaks[i], LXW_COL_MAX - 1);
+    return LXW_NO_ERROR;
 
-    lxw_xml_end_tag(self->file, "rowBreaks");
+file_error:
+    LXW_WARN_FORMAT1("worksheet image insertion: "
+                     "no size data found in: %s.", image_props->filename);
 
-    LXW_FREE_ATTRIBUTES();
+    return LXW_ERROR_IMAGE_DIMENSIONS;
 }
 
 /*
- * Write the <colBreaks> element.
+ * Extract width and height information from a GIF file.
  */
-STATIC void
-_worksheet_write_col_breaks(lxw_worksheet *self)
+STATIC lxw_error
+_process_gif(lxw_object_properties *image_props)
 {
-    struct xml_attribute_list attributes;
-    struct xml_attribute *attribute;
-    uint16_t count = self->vbreaks_count;
-    uint16_t i;
+    uint16_t width = 0;
+    uint16_t height = 0;
+    double x_dpi = 96;
+    double y_dpi = 96;
+    int fseek_err;
 
-    if (!count)
-        return;
+    FILE *stream = image_props->stream;
 
-    LXW_INIT_ATTRIBUTES();
-    LXW_PUSH_ATTRIBUTES_INT("count", count);
-    LXW_PUSH_ATTRIBUTES_INT("manualBreakCount", count);
+    /* Skip another 2 bytes to the start of the GIF height/width. */
+    fseek_err = fseek(stream, 2, SEEK_CUR);
+    if (fseek_err)
+        goto file_error;
 
-    lxw_xml_start_tag(self->file, "colBreaks", &attributes);
+    if (fread(&width, sizeof(width), 1, stream) < 1)
+        width = 0;
 
-    for (i = 0; i < count; i++)
-        _worksheet_write_brk(self, self->vbreaks[i], LXW_ROW_MAX - 1);
+    if (fread(&height, sizeof(height), 1, stream) < 1)
+        height = 0;
 
-    lxw_xml_end_tag(self->file, "colBreaks");
+    /* Ensure that we read some valid data from the file. */
+    if (width == 0)
+        goto file_error;
 
-    LXW_FREE_ATTRIBUTES();
+    height = LXW_UINT16_HOST(height);
+    width = LXW_UINT16_HOST(width);
+
+    /* Set the image metadata. */
+    image_props->image_type = LXW_IMAGE_GIF;
+    image_props->width = width;
+    image_props->height = height;
+    image_props->x_dpi = x_dpi;
+    image_props->y_dpi = y_dpi;
+    image_props->extension = lxw_strdup("gif");
+
+    return LXW_NO_ERROR;
+
+file_error:
+    LXW_WARN_FORMAT1("worksheet image insertion: "
+                     "no size data found in: %s.", image_props->filename);
+
+    return LXW_ERROR_IMAGE_DIMENSIONS;
 }
 
 /*
- * Write the <filter> element.
+ * Copy the image properties stored in the image cache.
  */
-STATIC void
-_worksheet_write_filter(lxw_worksheet *self, const char *str, double num,
-                        uint8_t criteria)
+STATIC lxw_error
+_get_cached_image_properties(lxw_object_properties *image_props,
+                             lxw_image_cache_entry *cache_entry)
 {
-    struct xml_attribute_list attributes;
-    struct xml_attribute *attribute;
-
-    if (criteria == LXW_FILTER_CRITERIA_BLANKS)
-        return;
-
-    LXW_INIT_ATTRIBUTES();
+    image_props->image_type = cache_entry->image_type;
+    image_props->width = cache_entry->width;
+    image_props->height = cache_entry->height;
+    image_props->x_dpi = cache_entry->x_dpi;
+    image_props->y_dpi = cache_entry->y_dpi;
 
-    if (str)
-        LXW_PUSH_ATTRIBUTES_STR("val", str);
-    else
-        LXW_PUSH_ATTRIBUTES_DBL("val", num);
+    image_props->extension = lxw_strdup(cache_entry->extension);
+    RETURN_ON_MEM_ERROR(image_props->extension,
+                        LXW_ERROR_MEMORY_MALLOC_FAILED);
 
-    lxw_xml_empty_tag(self->file, "filter", &attributes);
+    /* A missing checksum only means that duplicates aren't removed. */
+    image_props->md5 = lxw_strdup(cache_entry->md5);
 
-    LXW_FREE_ATTRIBUTES();
+    return LXW_NO_ERROR;
 }
 
 /*
- * Write the <filterColumn> element as simple equality.
+ * Store the properties of an image file in the image cache.
  */
 STATIC void
-_worksheet_write_filter_standard(lxw_worksheet *self,
-                                 lxw_filter_rule_obj *filter)
+_cache_image_properties(lxw_object_properties *image_props)
 {
-    struct xml_attribute_list attributes;
-    struct xml_attribute *attribute;
+    lxw_image_cache_entry *cache_entry;
 
-    LXW_INIT_ATTRIBUTES();
-
-    if (filter->has_blanks) {
-        LXW_PUSH_ATTRIBUTES_STR("blank", "1");
-    }
-
-    if (filter->type == LXW_FILTER_TYPE_SINGLE && filter->has_blanks) {
-        lxw_xml_empty_tag(self->file, "filters", &attributes);
-
-    }
-    else {
-        lxw_xml_start_tag(self->file, "filters", &attributes);
-
-        /* Write the filter element. */
-        if (filter->type == LXW_FILTER_TYPE_SINGLE) {
-            _worksheet_write_filter(self, filter->value1_string,
-                                    filter->value1, filter->criteria1);
-        }
-        else if (filter->type == LXW_FILTER_TYPE_AND
-                 || filter->type == LXW_FILTER_TYPE_OR) {
-            _worksheet_write_filter(self, filter->value1_string,
-                                    filter->value1, filter->criteria1);
-            _worksheet_write_filter(self, filter->value2_string,
-                                    filter->value2, filter->criteria2);
-        }
-
-        lxw_xml_end_tag(self->file, "filters");
-    }
+    cache_entry = lxw_image_cache_add_file(image_props->filename);
+    if (!cache_entry)
+        return;
 
-    LXW_FREE_ATTRIBUTES();
+    cache_entry->image_type = image_props->image_type;
+    cache_entry->width = image_props->width;
+    cache_entry->height = image_props->height;
+    cache_entry->x_dpi = image_props->x_dpi;
+    cache_entry->y_dpi = image_props->y_dpi;
+    cache_entry->extension = lxw_strdup(image_props->extension);
+    cache_entry->md5 = lxw_strdup(image_props->md5);
 }
 
 /*
- * Write the <customFilter> element.
+ * Extract information from the image file such as dimension, type, filename,
+ * and extension.
  */
-STATIC void
-_worksheet_write_custom_filter(lxw_worksheet *self, const char *str,
-                               double num, uint8_t criteria)
+STATIC lxw_error
+_get_image_properties(lxw_object_properties *image_props)
 {
-    struct xml_attribute_list attributes;
-    struct xml_attribute *attribute;
-
-    LXW_INIT_ATTRIBUTES();
+    unsigned char signature[4];
+    lxw_image_cache_entry *cache_entry;
+#ifndef USE_NO_MD5
+    uint8_t i;
+    MD5_CTX md5_context;
+    size_t size_read;
+    char buffer[LXW_IMAGE_BUFFER_SIZE];
+    unsigned char md5_checksum[LXW_MD5_SIZE];
+#endif
 
-    if (criteria == LXW_FILTER_CRITERIA_NOT_EQUAL_TO)
-        LXW_PUSH_ATTRIBUTES_STR("operator", "notEqual");
-    if (criteria == LXW_FILTER_CRITERIA_GREATER_THAN)
-        LXW_PUSH_ATTRIBUTES_STR("operator", "greaterThan");
-    else if (criteria == LXW_FILTER_CRITERIA_GREATER_THAN_OR_EQUAL_TO)
-        LXW_PUSH_ATTRIBUTES_STR("operator", "greaterThanOrEqual");
-    else if (criteria == LXW_FILTER_CRITERIA_LESS_THAN)
-        LXW_PUSH_ATTRIBUTES_STR("operator", "lessThan");
-    else if (criteria == LXW_FILTER_CRITERIA_LESS_THAN_OR_EQUAL_TO)
-        LXW_PUSH_ATTRIBUTES_STR("operator", "lessThanOrEqual");
+    /* Use the cached properties of an unchanged image file. */
+    if (!image_props->is_image_buffer && lxw_image_cache_is_enabled()) {
+        cache_entry = lxw_image_cache_get_file(image_props->filename);
 
-    if (str)
-        LXW_PUSH_ATTRIBUTES_STR("val", str);
-    else
-        LXW_PUSH_ATTRIBUTES_DBL("val", num);
+        if (cache_entry)
+            return _get_cached_image_properties(image_props, cache_entry);
+    }
 
-    lxw_xml_empty_tag(self->file, "customFilter", &attributes);
+    /* Read 4 bytes to look for the file header/signature. */
+    if (fread(signature, 1, 4, image_props->stream) < 4) {
+        LXW_WARN_FORMAT1("worksheet image insertion: "
+                         "couldn't read image type for: %s.",
+                         image_props->filename);
+        return LXW_ERROR_IMAGE_DIMENSIONS;
+    }
 
-    LXW_FREE_ATTRIBUTES();
-}
+    if (memcmp(&signature[1], "PNG", 3) == 0) {
+        if (_process_png(image_props) != LXW_NO_ERROR)
+            return LXW_ERROR_IMAGE_DIMENSIONS;
+    }
+    else if (signature[0] == 0xFF && signature[1] == 0xD8) {
+        if (_process_jpeg(image_props) != LXW_NO_ERROR)
+            return LXW_ERROR_IMAGE_DIMENSIONS;
+    }
+    else if (memcmp(signature, "BM", 2) == 0) {
+        if (_process_bmp(image_props) != LXW_NO_ERROR)
+            return LXW_ERROR_IMAGE_DIMENSIONS;
+    }
+    else if (memcmp(signature, "GIF8", 4) == 0) {
+        if (_process_gif(image_props) != LXW_NO_ERROR)
+            return LXW_ERROR_IMAGE_DIMENSIONS;
+    }
+    else {
+        LXW_WARN_FORMAT1("worksheet image insertion: "
+                         "unsupported image format for: %s.",
+                         image_props->filename);
+        return LXW_ERROR_IMAGE_DIMENSIONS;
+    }
 
-/*
- * Write the <filterColumn> element as a list.
- */
-STATIC void
-_worksheet_write_filter_list(lxw_worksheet *self, lxw_filter_rule_obj *filter)
-{
-    struct xml_attribute_list attributes;
-    struct xml_attribute *attribute;
-    uint16_t i;
+#ifndef USE_NO_MD5
+    /* Calculate an MD5 checksum for the image so that we can remove duplicate
+     * images to reduce the xlsx file size.*/
+    rewind(image_props->stream);
 
-    LXW_INIT_ATTRIBUTES();
+    MD5_Init(&md5_context);
 
-    if (filter->has_blanks) {
-        LXW_PUSH_ATTRIBUTES_STR("blank", "1");
+    size_read = fread(buffer, 1, LXW_IMAGE_BUFFER_SIZE, image_props->stream);
+    while (size_read) {
+        MD5_Update(&md5_context, buffer, (unsigned long) size_read);
+        size_read =
+            fread(buffer, 1, LXW_IMAGE_BUFFER_SIZE, image_props->stream);
     }
 
-    lxw_xml_start_tag(self->file, "filters", &attributes);
+    MD5_Final(md5_checksum, &md5_context);
 
-    for (i = 0; i < filter->num_list_filters; i++) {
-        _worksheet_write_filter(self, filter->list[i], 0, 0);
+    /* Create a 32 char hex string buffer for the MD5 checksum. */
+    image_props->md5 = calloc(1, LXW_MD5_SIZE * 2 + 1);
+
+    /* If this calloc fails we just return and don't remove duplicates. */
+    RETURN_ON_MEM_ERROR(image_props->md5, LXW_NO_ERROR);
+
+    /* Convert the 16 byte MD5 buffer to a 32 char hex string. */
+    for (i = 0; i < LXW_MD5_SIZE; i++) {
+        lxw_snprintf(&image_props->md5[2 * i], 3, "%02x", md5_checksum[i]);
     }
+#endif
 
-    lxw_xml_end_tag(self->file, "filters");
+    if (!image_props->is_image_buffer && lxw_image_cache_is_enabled())
+        _cache_image_properties(image_props);
 
-    LXW_FREE_ATTRIBUTES();
+    return LXW_NO_ERROR;
 }
 
-/*
- * Write the <filterColumn> element.
- */
-STATIC void
-_worksheet_write_filter_custom(lxw_worksheet *self,
-                               lxw_filter_rule_obj *filter)
+/* Conditional formats that refer to the same cell sqref range, like A or
+ * B1:B9, need to be written as part of one xml structure. Therefore we need
+ * to store them in a RB hash/tree keyed by sqref. Within the RB hash element
+ * we then store conditional formats that refer to sqref in a STAILQ list. */
+lxw_error
+_store_conditional_format_object(lxw_worksheet *self,
+                                 lxw_cond_format_obj *cond_format)
 {
-    struct xml_attribute_list attributes;
-    struct xml_attribute *attribute;
+    lxw_cond_format_hash_element tmp_hash_element;
+    lxw_cond_format_hash_element *found_hash_element = NULL;
+    lxw_cond_format_hash_element *new_hash_element = NULL;
 
-    LXW_INIT_ATTRIBUTES();
+    /* Create a temp hash element to do the lookup. */
+    LXW_ATTRIBUTE_COPY(tmp_hash_element.sqref, cond_format->sqref);
+    found_hash_element = RB_FIND(lxw_cond_format_hash,
+                                 self->conditional_formats,
+                                 &tmp_hash_element);
 
-    if (filter->type == LXW_FILTER_TYPE_AND)
-        LXW_PUSH_ATTRIBUTES_STR("and", "1");
+    if (found_hash_element) {
+        /* If the RB element exists then add the conditional format to the
+         * list for the sqref range.*/
+        STAILQ_INSERT_TAIL(found_hash_element->cond_formats, cond_format,
+                           list_pointers);
+    }
+    else {
+        /* Create a new RB hash element. */
+        new_hash_element = calloc(1, sizeof(lxw_cond_format_hash_element));
+        GOTO_LABEL_ON_MEM_ERROR(new_hash_element, mem_error);
 
-    lxw_xml_start_tag(self->file, "customFilters", &attributes);
+        /* Use the sqref as the key. */
+        LXW_ATTRIBUTE_COPY(new_hash_element->sqref, cond_format->sqref);
+
+        /* Also create the list where we store the cond format objects. */
+        new_hash_element->cond_formats =
+            calloc(1, sizeof(struct lxw_cond_format_list));
+        GOTO_LABEL_ON_MEM_ERROR(new_hash_element->cond_formats, mem_error);
+
+        /* Initialize the list and add the conditional format object. */
+        STAILQ_INIT(new_hash_element->cond_formats);
+        STAILQ_INSERT_TAIL(new_hash_element->cond_formats, cond_format,
+                           list_pointers);
+
+        /* Now insert the RB hash element into the tree. */
+        RB_INSERT(lxw_cond_format_hash, self->conditional_formats,
+                  new_hash_element);
 
-    /* Write the filter element. */
-    if (filter->type == LXW_FILTER_TYPE_SINGLE) {
-        _worksheet_write_custom_filter(self, filter->value1_string,
-                                       filter->value1, filter->criteria1);
-    }
-    else if (filter->type == LXW_FILTER_TYPE_AND
-             || filter->type == LXW_FILTER_TYPE_OR) {
-        _worksheet_write_custom_filter(self, filter->value1_string,
-                                       filter->value1, filter->criteria1);
-        _worksheet_write_custom_filter(self, filter->value2_string,
-                                       filter->value2, filter->criteria2);
     }
 
-    lxw_xml_end_tag(self->file, "customFilters");
+    return LXW_NO_ERROR;
 
-    LXW_FREE_ATTRIBUTES();
+mem_error:
+    free(new_hash_element);
+    return LXW_ERROR_MEMORY_MALLOC_FAILED;
 }
 
+/*****************************************************************************
+ *
+ * XML file assembly functions.
+ *
+ ****************************************************************************/
+
 /*
- * Write the <filterColumn> element.
+ * Write out a number worksheet cell. Doesn't use the xml functions as an
+ * optimization in the inner cell writing loop.
  */
 STATIC void
-_worksheet_write_filter_column(lxw_worksheet *self,
-                               lxw_filter_rule_obj *filter)
+_write_number_cell(lxw_worksheet *self, char *range,
+                   int32_t style_index, lxw_cell *cell)
 {
-    struct xml_attribute_list attributes;
-    struct xml_attribute *attribute;
+    double number = cell->u.number;
+    lxw_number_precision *precision = self->number_precision;
+#ifdef USE_DTOA_LIBRARY
+    char data[LXW_ATTR_32];
+#endif
 
-    if (!filter)
-        return;
+    /* Round the number if a column or workbook precision has been set. */
+    if (self->col_precision && self->col_precision[cell->col_num].type)
+        precision = &self->col_precision[cell->col_num];
 
-    LXW_INIT_ATTRIBUTES();
-    LXW_PUSH_ATTRIBUTES_INT("colId", filter->col_num);
+    if (precision && precision->type > LXW_PRECISION_FULL)
+        number = lxw_round_dbl(number, precision);
 
-    lxw_xml_start_tag(self->file, "filterColumn", &attributes);
+#ifdef USE_DTOA_LIBRARY
+    lxw_sprintf_dbl(data, number);
 
-    if (filter->list)
-        _worksheet_write_filter_list(self, filter);
-    else if (filter->is_custom)
-        _worksheet_write_filter_custom(self, filter);
+    if (style_index)
+        fprintf(self->file,
+                "<c r=\"%s\" s=\"%d\"><v>%s</v></c>",
+                range, style_index, data);
     else
-        _worksheet_write_filter_standard(self, filter);
-
-    lxw_xml_end_tag(self->file, "filterColumn");
+        fprintf(self->file, "<c r=\"%s\"><v>%s</v></c>", range, data);
+#else
+    if (style_index)
+        fprintf(self->file,
+                "<c r=\"%s\" s=\"%d\"><v>%.16G</v></c>",
+                range, style_index, number);
+    else
+        fprintf(self->file,
+                "<c r=\"%s\"><v>%.16G</v></c>", range, number);
 
-    LXW_FREE_ATTRIBUTES();
+#endif
 }
 
 /*
- * Write the <autoFilter> element.
+ * Write out a number worksheet cell where the number is stored as text. The
+ * text is written as it is, without rounding.
  */
 STATIC void
-_worksheet_write_auto_filter(lxw_worksheet *self)
+_write_number_text_cell(lxw_worksheet *self, char *range,
+                        int32_t style_index, lxw_cell *cell)
 {
-    struct xml_attribute_list attributes;
-    struct xml_attribute *attribute;
-    char range[LXW_MAX_CELL_RANGE_LENGTH];
-    uint16_t i;
-
-    if (!self->autofilter.in_use)
-        return;
-
-    lxw_rowcol_to_range(range,
-                        self->autofilter.first_row,
-                        self->autofilter.first_col,
-                        self->autofilter.last_row, self->autofilter.last_col);
+    if (style_index)
+        fprintf(self->file,
+                "<c r=\"%s\" s=\"%d\"><v>%s</v></c>",
+                range, style_index, cell->u.string);
+    else
+        fprintf(self->file,
+                "<c r=\"%s\"><v>%s</v></c>", range, cell->u.string);
+}
 
-    LXW_INIT_ATTRIBUTES();
-    LXW_PUSH_ATTRIBUTES_STR("ref", range);
+/*
+ * Write out a string worksheet cell. Doesn't use the xml functions as an
+ * optimization in the inner cell writing loop.
+ */
+STATIC void
+_write_string_cell(lxw_worksheet *self, char *range,
+                   int32_t style_index, lxw_cell *cell)
+{
 
-    if (self->autofilter.has_rules) {
-        lxw_xml_start_tag(self->file, "autoFilter", &attributes);
+    if (style_index)
+        fprintf(self->file,
+                "<c r=\"%s\" s=\"%d\" t=\"s\"><v>%d</v></c>",
+                range, style_index, cell->u.string_id);
+    else
+        fprintf(self->file,
+                "<c r=\"%s\" t=\"s\"><v>%d</v></c>",
+                range, cell->u.string_id);
+}
 
-        for (i = 0; i < self->num_filter_rules; i++)
-            _worksheet_write_filter_column(self, self->filter_rules[i]);
+/*
+ * Write out an inline string. Doesn't use the xml functions as an
+ * optimization in the inner cell writing loop.
+ */
+STATIC void
+_write_inline_string_cell(lxw_worksheet *self, char *range,
+                          int32_t style_index, lxw_cell *cell)
+{
+    char *string = lxw_escape_data(cell->u.string);
 
-        lxw_xml_end_tag(self->file, "autoFilter");
+    /* Add attribute to preserve leading or trailing whitespace. */
+    if (isspace((unsigned char) string[0])
+        || isspace((unsigned char) string[strlen(string) - 1])) {
 
+        if (style_index)
+            fprintf(self->file,
+                    "<c r=\"%s\" s=\"%d\" t=\"inlineStr\"><is>"
+                    "<t xml:space=\"preserve\">%s</t></is></c>",
+                    range, style_index, string);
+        else
+            fprintf(self->file,
+                    "<c r=\"%s\" t=\"inlineStr\"><is>"
+                    "<t xml:space=\"preserve\">%s</t></is></c>",
+                    range, string);
     }
     else {
-        lxw_xml_empty_tag(self->file, "autoFilter", &attributes);
+        if (style_index)
+            fprintf(self->file,
+                    "<c r=\"%s\" s=\"%d\" t=\"inlineStr\">"
+                    "<is><t>%s</t></is></c>", range, style_index, string);
+        else
+            fprintf(self->file,
+                    "<c r=\"%s\" t=\"inlineStr\">"
+                    "<is><t>%s</t></is></c>", range, string);
     }
 
-    LXW_FREE_ATTRIBUTES();
+    free(string);
 }
 
 /*
- * Write the <hyperlink> element for external links.
+ * Write out an inline rich string. Doesn't use the xml functions as an
+ * optimization in the inner cell writing loop.
  */
 STATIC void
-_worksheet_write_hyperlink_external(lxw_worksheet *self, lxw_row_t row_num,
-                                    lxw_col_t col_num, const char *location,
-                                    const char *tooltip, uint16_t id)
+_write_inline_rich_string_cell(lxw_worksheet *self, char *range,
+                               int32_t style_index, lxw_cell *cell)
 {
-    struct xml_attribute_list attributes;
-    struct xml_attribute *attribute;
-    char ref[LXW_MAX_CELL_NAME_LENGTH];
-    char r_id[LXW_MAX_ATTRIBUTE_LENGTH];
-
-    lxw_rowcol_to_cell(ref, row_num, col_num);
-
-    lxw_snprintf(r_id, LXW_ATTR_32, "rId%d", id);
-
-    LXW_INIT_ATTRIBUTES();
-    LXW_PUSH_ATTRIBUTES_STR("ref", ref);
-    LXW_PUSH_ATTRIBUTES_STR("r:id", r_id);
+    const char *string = cell->u.string;
 
-    if (location)
-        LXW_PUSH_ATTRIBUTES_STR("location", location);
+    if (style_index)
+        fprintf(self->file,
+                "<c r=\"%s\" s=\"%d\" t=\"inlineStr\">"
+                "<is>%s</is></c>", range, style_index, string);
+    else
+        fprintf(self->file,
+                "<c r=\"%s\" t=\"inlineStr\">"
+                "<is>%s</is></c>", range, string);
+}
 
-    if (tooltip)
-        LXW_PUSH_ATTRIBUTES_STR("tooltip", tooltip);
+/*
+ * Write out a formula worksheet cell with a numeric result.
+ */
+STATIC void
+_write_formula_num_cell(lxw_worksheet *self, lxw_cell *cell)
+{
+    char data[LXW_ATTR_32];
 
-    lxw_xml_empty_tag(self->file, "hyperlink", &attributes);
+    lxw_sprintf_dbl(data, cell->formula_result);
+    lxw_xml_data_element(self->file, "f", cell->u.string, NULL);
+    lxw_xml_data_element(self->file, "v", data, NULL);
+}
 
-    LXW_FREE_ATTRIBUTES();
+/*
+ * Write out a formula worksheet cell with a numeric result.
+ */
+STATIC void
+_write_formula_str_cell(lxw_worksheet *self, lxw_cell *cell)
+{
+    lxw_xml_data_element(self->file, "f", cell->u.string, NULL);
+    lxw_xml_data_element(self->file, "v", cell->user_data2, NULL);
 }
 
 /*
- * Write the <hyperlink> element for internal links.
+ * Write out an array formula worksheet cell with a numeric result.
  */
 STATIC void
-_worksheet_write_hyperlink_internal(lxw_worksheet *self, lxw_row_t row_num,
-                                    lxw_col_t col_num, const char *location,
-                                    const char *display, const char *tooltip)
+_write_array_formula_num_cell(lxw_worksheet *self, lxw_cell *cell)
 {
     struct xml_attribute_list attributes;
     struct xml_attribute *attribute;
-    char ref[LXW_MAX_CELL_NAME_LENGTH];
-
-    lxw_rowcol_to_cell(ref, row_num, col_num);
+    char data[LXW_ATTR_32];
 
     LXW_INIT_ATTRIBUTES();
-    LXW_PUSH_ATTRIBUTES_STR("ref", ref);
-
-    if (location)
-        LXW_PUSH_ATTRIBUTES_STR("location", location);
-
-    if (tooltip)
-        LXW_PUSH_ATTRIBUTES_STR("tooltip", tooltip);
+    LXW_PUSH_ATTRIBUTES_STR("t", "array");
+    LXW_PUSH_ATTRIBUTES_STR("ref", cell->user_data1);
 
-    if (display)
-        LXW_PUSH_ATTRIBUTES_STR("display", display);
+    lxw_sprintf_dbl(data, cell->formula_result);
 
-    lxw_xml_empty_tag(self->file, "hyperlink", &attributes);
+    lxw_xml_data_element(self->file, "f", cell->u.string, &attributes);
+    lxw_xml_data_element(self->file, "v", data, NULL);
 
     LXW_FREE_ATTRIBUTES();
 }
 
 /*
- * Process any stored hyperlinks in row/col order and write the <hyperlinks>
- * element. The attributes are different for internal and external links.
+ * Write out a boolean worksheet cell.
  */
 STATIC void
-_worksheet_write_hyperlinks(lxw_worksheet *self)
+_write_boolean_cell(lxw_worksheet *self, lxw_cell *cell)
 {
+    char data[LXW_ATTR_32];
 
-    lxw_row *row;
-    lxw_cell *link;
-    lxw_rel_tuple *relationship;
-
-    if (RB_EMPTY(self->hyperlinks))
-        return;
+    if (cell->u.number == 0.0)
+        data[0] = '0';
+    else
+        data[0] = '1';
 
-    /* Write the hyperlink elements. */
-    lxw_xml_start_tag(self->file, "hyperlinks", NULL);
+    data[1] = '\0';
 
-    RB_FOREACH(row, lxw_table_rows, self->hyperlinks) {
+    lxw_xml_data_element(self->file, "v", data, NULL);
+}
 
-        RB_FOREACH(link, lxw_table_cells, row->cells) {
+/*
+ * Write out a error worksheet cell.
+ */
+STATIC void
+_write_error_cell(lxw_worksheet *self)
+{
+    lxw_xml_data_element(self->file, "v", "#VALUE!", NULL);
+}
 
-            if (link->type == HYPERLINK_URL
-                || link->type == HYPERLINK_EXTERNAL) {
+/*
+ * Get the range of the table calculated columns that cover a row, if any.
+ * The rows and columns covered by the calculated columns are stored when
+ * the tables are added.
+ */
+STATIC uint8_t
+_get_table_formula_span(lxw_worksheet *self, lxw_row_t row_num,
+                        lxw_col_t *col_min, lxw_col_t *col_max)
+{
+    lxw_table_obj *table_obj;
+    uint8_t has_formulas = LXW_FALSE;
 
-                self->rel_count++;
+    if (!self->has_table_formulas
+        || row_num < self->table_formula_first_row
+        || row_num > self->table_formula_last_row)
+        return LXW_FALSE;
 
-                relationship = calloc(1, sizeof(lxw_rel_tuple));
-                GOTO_LABEL_ON_MEM_ERROR(relationship, mem_error);
+    STAILQ_FOREACH(table_obj, self->table_objs, list_pointers) {
+        if (!table_obj->has_formulas
+            || row_num < table_obj->first_data_row
+            || row_num > table_obj->last_data_row)
+            continue;
 
-                relationship->type = lxw_strdup("/hyperlink");
-                GOTO_LABEL_ON_MEM_ERROR(relationship->type, mem_error);
+        if (!has_formulas || table_obj->first_formula_col < *col_min)
+            *col_min = table_obj->first_formula_col;
 
-                relationship->target = lxw_strdup(link->u.string);
-                GOTO_LABEL_ON_MEM_ERROR(relationship->target, mem_error);
+        if (!has_formulas || table_obj->last_formula_col > *col_max)
+            *col_max = table_obj->last_formula_col;
 
-                relationship->target_mode = lxw_strdup("External");
-                GOTO_LABEL_ON_MEM_ERROR(relationship->target_mode, mem_error);
+        has_formulas = LXW_TRUE;
+    }
 
-                STAILQ_INSERT_TAIL(self->external_hyperlinks, relationship,
-                                   list_pointers);
+    return has_formulas;
+}
 
-                _worksheet_write_hyperlink_external(self, link->row_num,
-                                                    link->col_num,
-                                                    link->user_data1,
-                                                    link->user_data2,
-                                                    self->rel_count);
-            }
+/*
+ * Get the table column with a calculated column formula for a cell, if any.
+ */
+lxw_table_column *
+lxw_worksheet_find_table_formula(lxw_worksheet *self, lxw_row_t row_num,
+                                 lxw_col_t col_num)
+{
+    lxw_table_obj *table_obj;
+    lxw_table_column *column;
 
-            if (link->type == HYPERLINK_INTERNAL) {
+    if (!self->has_table_formulas
+        || row_num < self->table_formula_first_row
+        || row_num > self->table_formula_last_row)
+        return NULL;
 
-                _worksheet_write_hyperlink_internal(self, link->row_num,
-                                                    link->col_num,
-                                                    link->u.string,
-                                                    link->user_data1,
-                                                    link->user_data2);
-            }
+    STAILQ_FOREACH(table_obj, self->table_objs, list_pointers) {
+        if (!table_obj->has_formulas
+            || row_num < table_obj->first_data_row
+            || row_num > table_obj->last_data_row
+            || col_num < table_obj->first_formula_col
+            || col_num > table_obj->last_formula_col)
+            continue;
 
-        }
+        column = table_obj->columns[col_num - table_obj->first_col];
 
+        if (column->formula)
+            return column;
     }
 
-    lxw_xml_end_tag(self->file, "hyperlinks");
-    return;
-
-mem_error:
-    if (relationship) {
-        free(relationship->type);
-        free(relationship->target);
-        free(relationship->target_mode);
-        free(relationship);
-    }
-    lxw_xml_end_tag(self->file, "hyperlinks");
+    return NULL;
 }
 
 /*
- * Write the <sheetProtection> element.
+ * Calculate the "spans" attribute of the <row> tag. This is an XLSX
+ * optimization and isn't strictly required. However, it makes comparing
+ * files easier.
+ *
+ * The span is the same for each block of 16 rows.
  */
 STATIC void
-_worksheet_write_sheet_protection(lxw_worksheet *self,
-                                  lxw_protection_obj *protect)
-{
-    struct xml_attribute_list attributes;
-    struct xml_attribute *attribute;
-
-    if (!protect->is_configured)
-        return;
-
-    LXW_INIT_ATTRIBUTES();
+_calculate_spans(lxw_worksheet *self, struct lxw_row *row, char *span,
+                 int32_t *block_num)
+{
+    lxw_cell *cell_min;
+    lxw_cell *cell_max;
+    lxw_col_t span_col_min = LXW_COL_MAX;
+    lxw_col_t span_col_max = 0;
+    lxw_col_t col_min = 0;
+    lxw_col_t col_max = 0;
+    *block_num = row->row_num / 16;
 
-    if (*protect->hash)
-        LXW_PUSH_ATTRIBUTES_STR("password", protect->hash);
+    while (row && (int32_t) (row->row_num / 16) == *block_num) {
 
-    if (!protect->no_sheet)
-        LXW_PUSH_ATTRIBUTES_INT("sheet", 1);
+        if (!RB_EMPTY(row->cells)) {
+            cell_min = RB_MIN(lxw_table_cells, row->cells);
+            cell_max = RB_MAX(lxw_table_cells, row->cells);
+            col_min = cell_min->col_num;
+            col_max = cell_max->col_num;
 
-    if (!protect->no_content)
-        LXW_PUSH_ATTRIBUTES_INT("content", 1);
+            if (col_min < span_col_min)
+                span_col_min = col_min;
 
-    if (!protect->objects)
-        LXW_PUSH_ATTRIBUTES_INT("objects", 1);
+            if (col_max > span_col_max)
+                span_col_max = col_max;
+        }
 
-    if (!protect->scenarios)
-        LXW_PUSH_ATTRIBUTES_INT("scenarios", 1);
+        /* Include any table calculated columns in the row. */
+        if (_get_table_formula_span(self, row->row_num, &col_min, &col_max)) {
+            if (col_min < span_col_min)
+                span_col_min = col_min;
 
-    if (protect->format_cells)
-        LXW_PUSH_ATTRIBUTES_INT("formatCells", 0);
+            if (col_max > span_col_max)
+                span_col_max = col_max;
+        }
 
-    if (protect->format_columns)
-        LXW_PUSH_ATTRIBUTES_INT("formatColumns", 0);
+        row = RB_NEXT(lxw_table_rows, root, row);
+    }
 
-    if (protect->format_rows)
-        LXW_PUSH_ATTRIBUTES_INT("formatRows", 0);
+    lxw_snprintf(span, LXW_MAX_CELL_RANGE_LENGTH,
+                 "%d:%d", span_col_min + 1, span_col_max + 1);
+}
 
-    if (protect->insert_columns)
-        LXW_PUSH_ATTRIBUTES_INT("insertColumns", 0);
+/*
+ * Write out a generic worksheet cell.
+ */
+STATIC void
+_write_cell(lxw_worksheet *self, lxw_cell *cell, lxw_format *row_format)
+{
+    struct xml_attribute_list attributes;
+    struct xml_attribute *attribute;
+    char range[LXW_MAX_CELL_NAME_LENGTH] = { 0 };
+    lxw_row_t row_num = cell->row_num;
+    lxw_col_t col_num = cell->col_num;
+    int32_t style_index = 0;
 
-    if (protect->insert_rows)
-        LXW_PUSH_ATTRIBUTES_INT("insertRows", 0);
+    lxw_rowcol_to_cell(range, row_num, col_num);
 
-    if (protect->insert_hyperlinks)
-        LXW_PUSH_ATTRIBUTES_INT("insertHyperlinks", 0);
+    if (cell->format) {
+        style_index = lxw_format_get_xf_index(cell->format);
+    }
+    else if (row_format) {
+        style_index = lxw_format_get_xf_index(row_format);
+    }
+    else if (col_num < self->col_formats_max && self->col_formats[col_num]) {
+        style_index = lxw_format_get_xf_index(self->col_formats[col_num]);
+    }
 
-    if (protect->delete_columns)
-        LXW_PUSH_ATTRIBUTES_INT("deleteColumns", 0);
+    /* Unrolled optimization for most commonly written cell types. */
+    if (cell->type == NUMBER_CELL) {
+        _write_number_cell(self, range, style_index, cell);
+        return;
+    }
 
-    if (protect->delete_rows)
-        LXW_PUSH_ATTRIBUTES_INT("deleteRows", 0);
+    if (cell->type == STRING_CELL) {
+        _write_string_cell(self, range, style_index, cell);
+        return;
+    }
 
-    if (protect->no_select_locked_cells)
-        LXW_PUSH_ATTRIBUTES_INT("selectLockedCells", 1);
+    if (cell->type == INLINE_STRING_CELL) {
+        _write_inline_string_cell(self, range, style_index, cell);
+        return;
+    }
 
-    if (protect->sort)
-        LXW_PUSH_ATTRIBUTES_INT("sort", 0);
+    if (cell->type == INLINE_RICH_STRING_CELL) {
+        _write_inline_rich_string_cell(self, range, style_index, cell);
+        return;
+    }
 
-    if (protect->autofilter)
-        LXW_PUSH_ATTRIBUTES_INT("autoFilter", 0);
+    if (cell->type == NUMBER_TEXT_CELL) {
+        _write_number_text_cell(self, range, style_index, cell);
+        return;
+    }
 
-    if (protect->pivot_tables)
-        LXW_PUSH_ATTRIBUTES_INT("pivotTables", 0);
+    /* For other cell types use the general functions. */
+    LXW_INIT_ATTRIBUTES();
+    LXW_PUSH_ATTRIBUTES_STR("r", range);
 
-    if (protect->no_select_unlocked_cells)
-        LXW_PUSH_ATTRIBUTES_INT("selectUnlockedCells", 1);
+    if (style_index)
+        LXW_PUSH_ATTRIBUTES_INT("s", style_index);
 
-    lxw_xml_empty_tag(self->file, "sheetProtection", &attributes);
+    if (cell->type == FORMULA_CELL) {
+        /* If user_data2 is set then the formula has a string result. */
+        if (cell->user_data2)
+            LXW_PUSH_ATTRIBUTES_STR("t", "str");
+
+        lxw_xml_start_tag(self->file, "c", &attributes);
+
+        if (cell->user_data2)
+            _write_formula_str_cell(self, cell);
+        else
+            _write_formula_num_cell(self, cell);
+
+        lxw_xml_end_tag(self->file, "c");
+    }
+    else if (cell->type == BLANK_CELL) {
+        if (cell->format)
+            lxw_xml_empty_tag(self->file, "c", &attributes);
+    }
+    else if (cell->type == BOOLEAN_CELL) {
+        LXW_PUSH_ATTRIBUTES_STR("t", "b");
+        lxw_xml_start_tag(self->file, "c", &attributes);
+        _write_boolean_cell(self, cell);
+        lxw_xml_end_tag(self->file, "c");
+    }
+    else if (cell->type == ARRAY_FORMULA_CELL) {
+        lxw_xml_start_tag(self->file, "c", &attributes);
+        _write_array_formula_num_cell(self, cell);
+        lxw_xml_end_tag(self->file, "c");
+    }
+    else if (cell->type == DYNAMIC_ARRAY_FORMULA_CELL) {
+        LXW_PUSH_ATTRIBUTES_STR("cm", "1");
+        lxw_xml_start_tag(self->file, "c", &attributes);
+        _write_array_formula_num_cell(self, cell);
+        lxw_xml_end_tag(self->file, "c");
+    }
+    else if (cell->type == ERROR_CELL) {
+        LXW_PUSH_ATTRIBUTES_STR("t", "e");
+        LXW_PUSH_ATTRIBUTES_DBL("vm", cell->u.number);
+        lxw_xml_start_tag(self->file, "c", &attributes);
+        _write_error_cell(self);
+        lxw_xml_end_tag(self->file, "c");
+    }
 
     LXW_FREE_ATTRIBUTES();
 }
 
 /*
- * Write the <legacyDrawing> element.
+ * Write out a table calculated column formula cell. The cell isn't stored in
+ * the worksheet, it is generated from the formula in the table column.
  */
 STATIC void
-_worksheet_write_legacy_drawing(lxw_worksheet *self)
+_write_table_formula_cell(lxw_worksheet *self, lxw_row *row,
+                          lxw_col_t col_num)
 {
-    struct xml_attribute_list attributes;
-    struct xml_attribute *attribute;
-    char r_id[LXW_MAX_ATTRIBUTE_LENGTH];
+    lxw_cell cell;
+    lxw_table_column *column;
 
-    if (!self->has_vml)
+    column = lxw_worksheet_find_table_formula(self, row->row_num, col_num);
+    if (!column)
         return;
-    else
-        self->rel_count++;
-
-    lxw_snprintf(r_id, LXW_ATTR_32, "rId%d", self->rel_count);
-    LXW_INIT_ATTRIBUTES();
-    LXW_PUSH_ATTRIBUTES_STR("r:id", r_id);
-
-    lxw_xml_empty_tag(self->file, "legacyDrawing", &attributes);
 
-    LXW_FREE_ATTRIBUTES();
+    memset(&cell, 0, sizeof(lxw_cell));
+    cell.row_num = row->row_num;
+    cell.col_num = col_num;
+    cell.type = FORMULA_CELL;
+    cell.format = column->format;
+    cell.u.string = (char *) column->formula;
 
+    _write_cell(self, &cell, row->format);
 }
 
 /*
- * Write the <legacyDrawingHF> element.
+ * Write out the cells of a row, merged in column order with the formula
+ * cells of any table calculated columns. Cells written explicitly to a table
+ * calculated column take precedence over the column formula.
  */
 STATIC void
-_worksheet_write_legacy_drawing_hf(lxw_worksheet *self)
+_write_row_cells(lxw_worksheet *self, lxw_row *row)
 {
-    struct xml_attribute_list attributes;
-    struct xml_attribute *attribute;
-    char r_id[LXW_MAX_ATTRIBUTE_LENGTH];
+    lxw_cell *cell;
+    lxw_col_t col_num;
+    lxw_col_t col_min = 0;
+    lxw_col_t col_max = 0;
 
-    if (!self->has_header_vml)
+    if (!_get_table_formula_span(self, row->row_num, &col_min, &col_max)) {
+        RB_FOREACH(cell, lxw_table_cells, row->cells) {
+            _write_cell(self, cell, row->format);
+        }
         return;
-    else
-        self->rel_count++;
+    }
 
-    lxw_snprintf(r_id, LXW_ATTR_32, "rId%d", self->rel_count);
-    LXW_INIT_ATTRIBUTES();
-    LXW_PUSH_ATTRIBUTES_STR("r:id", r_id);
+    col_num = col_min;
 
-    lxw_xml_empty_tag(self->file, "legacyDrawingHF", &attributes);
+    RB_FOREACH(cell, lxw_table_cells, row->cells) {
+        for (; col_num <= col_max && col_num < cell->col_num; col_num++)
+            _write_table_formula_cell(self, row, col_num);
 
-    LXW_FREE_ATTRIBUTES();
+        /* Unformatted blank cells, such as comment placeholders, aren't
+         * written so they don't replace the column formula. */
+        if (col_num == cell->col_num
+            && (cell->type != BLANK_CELL || cell->format))
+            col_num++;
+
+        _write_cell(self, cell, row->format);
+    }
 
+    for (; col_num <= col_max; col_num++)
+        _write_table_formula_cell(self, row, col_num);
 }
 
 /*
- * Write the <picture> element.
+ * Write out the worksheet data as a series of rows and cells.
  */
 STATIC void
-_worksheet_write_picture(lxw_worksheet *self)
+_worksheet_write_rows(lxw_worksheet *self)
 {
-    struct xml_attribute_list attributes;
-    struct xml_attribute *attribute;
-    char r_id[LXW_MAX_ATTRIBUTE_LENGTH];
+    lxw_row *row;
+    lxw_col_t col_min;
+    lxw_col_t col_max;
+    lxw_worksheet *segment = STAILQ_FIRST(self->segments);
+    int32_t block_num = -1;
+    char spans[LXW_MAX_CELL_RANGE_LENGTH] = { 0 };
 
-    if (!self->has_background_image)
-        return;
-    else
-        self->rel_count++;
+    RB_FOREACH(row, lxw_table_rows, self->table) {
 
-    lxw_snprintf(r_id, LXW_ATTR_32, "rId%d", self->rel_count);
-    LXW_INIT_ATTRIBUTES();
-    LXW_PUSH_ATTRIBUTES_STR("r:id", r_id);
+        /* Write any segments that come before the row. */
+        while (segment && segment->segment_first_row < row->row_num) {
+            _worksheet_write_segment(self, segment);
+            segment = STAILQ_NEXT(segment, list_pointers);
+        }
 
-    lxw_xml_empty_tag(self->file, "picture", &attributes);
+        if (RB_EMPTY(row->cells)
+            && !_get_table_formula_span(self, row->row_num, &col_min,
+                                        &col_max)) {
+            /* Row contains no cells but has height, format or other data. */
 
-    LXW_FREE_ATTRIBUTES();
+            /* Write a default span for default rows. */
+            if (self->default_row_set)
+                _write_row(self, row, "1:1");
+            else
+                _write_row(self, row, NULL);
+        }
+        else {
+            /* Row and cell data. */
+            if ((int32_t) row->row_num / 16 > block_num)
+                _calculate_spans(self, row, spans, &block_num);
+
+            _write_row(self, row, spans);
+
+            if (row->data_changed) {
+                _write_row_cells(self, row);
+                lxw_xml_end_tag(self->file, "row");
+            }
+        }
+    }
+
+    /* Write any remaining segments. */
+    while (segment) {
+        _worksheet_write_segment(self, segment);
+        segment = STAILQ_NEXT(segment, list_pointers);
+    }
 }
 
 /*
- * Write the <drawing> element.
+ * Write the rows that are kept in memory in constant_memory mode. They are
+ * written without spans like the other rows in that mode.
  */
 STATIC void
-_worksheet_write_drawing(lxw_worksheet *self, uint16_t id)
+_worksheet_write_pinned_rows(lxw_worksheet *self)
 {
-    struct xml_attribute_list attributes;
-    struct xml_attribute *attribute;
-    char r_id[LXW_MAX_ATTRIBUTE_LENGTH];
-
-    lxw_snprintf(r_id, LXW_ATTR_32, "rId%d", id);
-    LXW_INIT_ATTRIBUTES();
-    LXW_PUSH_ATTRIBUTES_STR("r:id", r_id);
+    lxw_row *row;
+    lxw_cell *cell;
 
-    lxw_xml_empty_tag(self->file, "drawing", &attributes);
+    RB_FOREACH(row, lxw_table_rows, self->table) {
+        _write_row(self, row, NULL);
 
-    LXW_FREE_ATTRIBUTES();
+        if (row->data_changed) {
+            RB_FOREACH(cell, lxw_table_cells, row->cells) {
+                _write_cell(self, cell, row->format);
+            }
 
+            lxw_xml_end_tag(self->file, "row");
+        }
+    }
 }
 
 /*
- * Write the <drawing> elements.
+ * Store the position in the constant_memory temp file where the data of any
+ * segments that come before a row should be inserted.
  */
 STATIC void
-_worksheet_write_drawings(lxw_worksheet *self)
+_worksheet_mark_segment_offsets(lxw_worksheet *self, lxw_row_t row_num)
 {
-    if (!self->drawing)
-        return;
+    lxw_worksheet *segment;
+    long offset = -1;
 
-    self->rel_count++;
+    STAILQ_FOREACH(segment, self->segments, list_pointers) {
+        if (segment->segment_first_row > row_num)
+            break;
 
-    _worksheet_write_drawing(self, self->rel_count);
+        if (segment->segment_offset_set)
+            continue;
+
+        if (offset < 0) {
+            fflush(self->file);
+            offset = ftell(self->file);
+        }
+
+        if (offset >= 0) {
+            segment->segment_offset = (size_t) offset;
+            segment->segment_offset_set = LXW_TRUE;
+        }
+    }
 }
 
 /*
- * Write the <formula1> element for numbers.
+ * The rows of a constant_memory worksheet can be stored in the temp file as
+ * binary records instead of XML, when the binary_tmpfile option is on. Each
+ * row is stored as:
+ *
+ *     row number      varint
+ *     flags           byte, see lxw_row_record_flags
+ *     outline level   byte
+ *     format id       varint, if LXW_ROW_RECORD_FORMAT
+ *     height          double, if LXW_ROW_RECORD_HEIGHT
+ *     cells           if LXW_ROW_RECORD_DATA, terminated by a 0 byte
+ *
+ * Each cell is stored as a varint column increment, which is never 0, a
+ * byte with the cell type and the LXW_CELL_RECORD_FORMAT flag, an optional
+ * varint format id and then the cell data. Numbers are stored as raw
+ * doubles, shared strings as a varint index and other strings as a varint
+ * length + 1, or 0 for NULL, followed by the string data. The format id is
+ * the xf index of the format, which is mapped back to a format via the
+ * record_formats array of the worksheet when the XML is written.
+ */
+enum lxw_row_record_flags {
+    LXW_ROW_RECORD_HIDDEN = 0x01,
+    LXW_ROW_RECORD_COLLAPSED = 0x02,
+    LXW_ROW_RECORD_HEIGHT = 0x04,
+    LXW_ROW_RECORD_DATA = 0x08,
+    LXW_ROW_RECORD_FORMAT = 0x10
+};
+
+#define LXW_CELL_RECORD_FORMAT 0x80
+
+/* Reader for a range of the binary row records in a temp file or buffer. */
+typedef struct lxw_record_reader {
+    FILE *file;
+    const unsigned char *data;
+    size_t pos;
+    size_t used;
+    size_t remaining;
+    unsigned char buffer[LXW_BUFFER_SIZE];
+} lxw_record_reader;
+
+/*
+ * Write a variable length unsigned integer to a row record, 7 bits at a time.
  */
 STATIC void
-_worksheet_write_formula1_num(lxw_worksheet *self, double number)
+_record_write_varint(lxw_worksheet *self, uint32_t value)
 {
-    char data[LXW_ATTR_32];
+    unsigned char data[5];
+    size_t length = 0;
 
-    lxw_sprintf_dbl(data, number);
+    while (value >= 0x80) {
+        data[length++] = (unsigned char) (value | 0x80);
+        value >>= 7;
+    }
 
-    lxw_xml_data_element(self->file, "formula1", data, NULL);
+    data[length++] = (unsigned char) value;
+
+    /* Ignore return value. There is no easy way to raise error. */
+    (void) fwrite(data, 1, length, self->file);
 }
 
 /*
- * Write the <formula1> element for strings/formulas.
+ * Write a raw double to a row record.
  */
 STATIC void
-_worksheet_write_formula1_str(lxw_worksheet *self, char *str)
+_record_write_double(lxw_worksheet *self, double number)
 {
-    lxw_xml_data_element(self->file, "formula1", str, NULL);
+    (void) fwrite(&number, sizeof(number), 1, self->file);
 }
 
 /*
- * Write the <formula2> element for numbers.
+ * Write a length prefixed, and possibly NULL, string to a row record.
  */
 STATIC void
-_worksheet_write_formula2_num(lxw_worksheet *self, double number)
+_record_write_string(lxw_worksheet *self, const char *string)
 {
-    char data[LXW_ATTR_32];
+    size_t length;
 
-    lxw_sprintf_dbl(data, number);
+    if (!string) {
+        _record_write_varint(self, 0);
+        return;
+    }
 
-    lxw_xml_data_element(self->file, "formula2", data, NULL);
+    length = strlen(string);
+    _record_write_varint(self, (uint32_t) length + 1);
+    (void) fwrite(string, 1, length, self->file);
 }
 
 /*
- * Write the <formula2> element for strings/formulas.
+ * Get the id of a format for a row record and store the format so that it
+ * can be found from the id when the XML is written.
  */
-STATIC void
-_worksheet_write_formula2_str(lxw_worksheet *self, char *str)
+STATIC uint32_t
+_record_format_id(lxw_worksheet *self, lxw_format *format)
 {
-    lxw_xml_data_element(self->file, "formula2", str, NULL);
+    uint32_t id = (uint32_t) lxw_format_get_xf_index(format);
+    uint32_t new_max;
+    lxw_format **new_formats;
+
+    if (id >= self->record_formats_max) {
+        new_max = self->record_formats_max ? self->record_formats_max : 16;
+
+        while (new_max <= id)
+            new_max *= 2;
+
+        new_formats = realloc(self->record_formats,
+                              new_max * sizeof(lxw_format *));
+        RETURN_ON_MEM_ERROR(new_formats, id);
+
+        memset(new_formats + self->record_formats_max, 0,
+               (new_max - self->record_formats_max) * sizeof(lxw_format *));
+
+        self->record_formats = new_formats;
+        self->record_formats_max = new_max;
+    }
+
+    self->record_formats[id] = format;
+
+    return id;
 }
 
 /*
- * Write the <dataValidation> element.
+ * Write the data of a cell to a row record. Cells without a format inherit
+ * the row or column format when the XML is written. The xf index of the
+ * inherited format is set here so that the formats are indexed in the same
+ * order as rows that are written directly as XML.
  */
 STATIC void
-_worksheet_write_data_validation(lxw_worksheet *self,
-                                 lxw_data_val_obj *validation)
+_record_write_cell(lxw_worksheet *self, lxw_cell *cell,
+                   lxw_format *row_format)
 {
-    struct xml_attribute_list attributes;
-    struct xml_attribute *attribute;
-    uint8_t is_between = 0;
+    uint8_t type = (uint8_t) cell->type;
+    uint8_t boolean;
+    lxw_col_t col_num = cell->col_num;
 
-    LXW_INIT_ATTRIBUTES();
+    if (cell->format)
+        type |= LXW_CELL_RECORD_FORMAT;
+    else if (row_format)
+        lxw_format_get_xf_index(row_format);
+    else if (col_num < self->col_formats_max && self->col_formats[col_num])
+        lxw_format_get_xf_index(self->col_formats[col_num]);
 
-    switch (validation->validate) {
-        case LXW_VALIDATION_TYPE_INTEGER:
-        case LXW_VALIDATION_TYPE_INTEGER_FORMULA:
-            LXW_PUSH_ATTRIBUTES_STR("type", "whole");
-            break;
-        case LXW_VALIDATION_TYPE_DECIMAL:
-        case LXW_VALIDATION_TYPE_DECIMAL_FORMULA:
-            LXW_PUSH_ATTRIBUTES_STR("type", "decimal");
-            break;
-        case LXW_VALIDATION_TYPE_LIST:
-        case LXW_VALIDATION_TYPE_LIST_FORMULA:
-            LXW_PUSH_ATTRIBUTES_STR("type", "list");
-            break;
-        case LXW_VALIDATION_TYPE_DATE:
-        case LXW_VALIDATION_TYPE_DATE_FORMULA:
-        case LXW_VALIDATION_TYPE_DATE_NUMBER:
-            LXW_PUSH_ATTRIBUTES_STR("type", "date");
-            break;
-        case LXW_VALIDATION_TYPE_TIME:
-        case LXW_VALIDATION_TYPE_TIME_FORMULA:
-        case LXW_VALIDATION_TYPE_TIME_NUMBER:
-            LXW_PUSH_ATTRIBUTES_STR("type", "time");
-            break;
-        case LXW_VALIDATION_TYPE_LENGTH:
-        case LXW_VALIDATION_TYPE_LENGTH_FORMULA:
-            LXW_PUSH_ATTRIBUTES_STR("type", "textLength");
-            break;
-        case LXW_VALIDATION_TYPE_CUSTOM_FORMULA:
-            LXW_PUSH_ATTRIBUTES_STR("type", "custom");
-            break;
-    }
+    (void) fwrite(&type, 1, 1, self->file);
 
-    switch (validation->criteria) {
-        case LXW_VALIDATION_CRITERIA_EQUAL_TO:
-            LXW_PUSH_ATTRIBUTES_STR("operator", "equal");
-            break;
-        case LXW_VALIDATION_CRITERIA_NOT_EQUAL_TO:
-            LXW_PUSH_ATTRIBUTES_STR("operator", "notEqual");
+    if (cell->format)
+        _record_write_varint(self, _record_format_id(self, cell->format));
+
+    switch (cell->type) {
+        case NUMBER_CELL:
+        case ERROR_CELL:
+            _record_write_double(self, cell->u.number);
             break;
-        case LXW_VALIDATION_CRITERIA_LESS_THAN:
-            LXW_PUSH_ATTRIBUTES_STR("operator", "lessThan");
+
+        case STRING_CELL:
+            _record_write_varint(self, (uint32_t) cell->u.string_id);
             break;
-        case LXW_VALIDATION_CRITERIA_LESS_THAN_OR_EQUAL_TO:
-            LXW_PUSH_ATTRIBUTES_STR("operator", "lessThanOrEqual");
+
+        case INLINE_STRING_CELL:
+        case INLINE_RICH_STRING_CELL:
+        case NUMBER_TEXT_CELL:
+            _record_write_string(self, cell->u.string);
             break;
-        case LXW_VALIDATION_CRITERIA_GREATER_THAN:
-            LXW_PUSH_ATTRIBUTES_STR("operator", "greaterThan");
+
+        case FORMULA_CELL:
+            _record_write_string(self, cell->u.string);
+            _record_write_double(self, cell->formula_result);
+            _record_write_string(self, cell->user_data2);
             break;
-        case LXW_VALIDATION_CRITERIA_GREATER_THAN_OR_EQUAL_TO:
-            LXW_PUSH_ATTRIBUTES_STR("operator", "greaterThanOrEqual");
+
+        case ARRAY_FORMULA_CELL:
+        case DYNAMIC_ARRAY_FORMULA_CELL:
+            _record_write_string(self, cell->u.string);
+            _record_write_double(self, cell->formula_result);
+            _record_write_string(self, cell->user_data1);
             break;
-        case LXW_VALIDATION_CRITERIA_BETWEEN:
-            /* Between is the default for 2 formulas and isn't added. */
-            is_between = 1;
+
+        case BOOLEAN_CELL:
+            boolean = cell->u.number != 0.0;
+            (void) fwrite(&boolean, 1, 1, self->file);
             break;
-        case LXW_VALIDATION_CRITERIA_NOT_BETWEEN:
-            is_between = 1;
-            LXW_PUSH_ATTRIBUTES_STR("operator", "notBetween");
+
+        default:
             break;
     }
+}
 
-    if (validation->error_type == LXW_VALIDATION_ERROR_TYPE_WARNING)
-        LXW_PUSH_ATTRIBUTES_STR("errorStyle", "warning");
-
-    if (validation->error_type == LXW_VALIDATION_ERROR_TYPE_INFORMATION)
-        LXW_PUSH_ATTRIBUTES_STR("errorStyle", "information");
+/*
+ * Write the optimize row and its cells to the temp file as a binary row
+ * record and free the cells.
+ */
+STATIC void
+_worksheet_write_row_record(lxw_worksheet *self, lxw_row *row)
+{
+    uint8_t flags = 0;
+    uint8_t end = 0;
+    lxw_col_t col;
+    lxw_col_t last_col = 0;
+    uint32_t format_id = 0;
 
-    if (validation->ignore_blank)
-        LXW_PUSH_ATTRIBUTES_INT("allowBlank", 1);
+    if (row->hidden)
+        flags |= LXW_ROW_RECORD_HIDDEN;
 
-    if (validation->dropdown == LXW_VALIDATION_OFF)
-        LXW_PUSH_ATTRIBUTES_INT("showDropDown", 1);
+    if (row->collapsed)
+        flags |= LXW_ROW_RECORD_COLLAPSED;
 
-    if (validation->show_input)
-        LXW_PUSH_ATTRIBUTES_INT("showInputMessage", 1);
+    if (row->height_changed)
+        flags |= LXW_ROW_RECORD_HEIGHT;
 
-    if (validation->show_error)
-        LXW_PUSH_ATTRIBUTES_INT("showErrorMessage", 1);
+    if (row->data_changed)
+        flags |= LXW_ROW_RECORD_DATA;
 
-    if (validation->error_title)
-        LXW_PUSH_ATTRIBUTES_STR("errorTitle", validation->error_title);
+    if (row->format) {
+        flags |= LXW_ROW_RECORD_FORMAT;
+        format_id = _record_format_id(self, row->format);
+    }
 
-    if (validation->error_message)
-        LXW_PUSH_ATTRIBUTES_STR("error", validation->error_message);
+    _record_write_varint(self, row->row_num);
+    (void) fwrite(&flags, 1, 1, self->file);
+    (void) fwrite(&row->level, 1, 1, self->file);
 
-    if (validation->input_title)
-        LXW_PUSH_ATTRIBUTES_STR("promptTitle", validation->input_title);
+    if (row->format)
+        _record_write_varint(self, format_id);
 
-    if (validation->input_message)
-        LXW_PUSH_ATTRIBUTES_STR("prompt", validation->input_message);
+    if (row->height_changed)
+        _record_write_double(self, row->height);
 
-    LXW_PUSH_ATTRIBUTES_STR("sqref", validation->sqref);
+    if (!row->data_changed)
+        return;
 
-    if (validation->validate == LXW_VALIDATION_TYPE_ANY)
-        lxw_xml_empty_tag(self->file, "dataValidation", &attributes);
-    else
-        lxw_xml_start_tag(self->file, "dataValidation", &attributes);
+    for (col = self->dim_colmin; col <= self->dim_colmax; col++) {
+        if (self->array[col]) {
+            /* Store the column as an increment of at least 1. */
+            _record_write_varint(self, (uint32_t) col + 1 - last_col);
+            last_col = col + 1;
 
-    /* Write the formula1 and formula2 elements. */
-    switch (validation->validate) {
-        case LXW_VALIDATION_TYPE_INTEGER:
-        case LXW_VALIDATION_TYPE_DECIMAL:
-        case LXW_VALIDATION_TYPE_LENGTH:
-        case LXW_VALIDATION_TYPE_DATE:
-        case LXW_VALIDATION_TYPE_TIME:
-        case LXW_VALIDATION_TYPE_DATE_NUMBER:
-        case LXW_VALIDATION_TYPE_TIME_NUMBER:
-            _worksheet_write_formula1_num(self, validation->value_number);
-            if (is_between)
-                _worksheet_write_formula2_num(self,
-                                              validation->maximum_number);
-            break;
-        case LXW_VALIDATION_TYPE_INTEGER_FORMULA:
-        case LXW_VALIDATION_TYPE_DECIMAL_FORMULA:
-        case LXW_VALIDATION_TYPE_LENGTH_FORMULA:
-        case LXW_VALIDATION_TYPE_DATE_FORMULA:
-        case LXW_VALIDATION_TYPE_TIME_FORMULA:
-        case LXW_VALIDATION_TYPE_LIST:
-        case LXW_VALIDATION_TYPE_LIST_FORMULA:
-        case LXW_VALIDATION_TYPE_CUSTOM_FORMULA:
-            _worksheet_write_formula1_str(self, validation->value_formula);
-            if (is_between)
-                _worksheet_write_formula2_str(self,
-                                              validation->maximum_formula);
-            break;
+            _record_write_cell(self, self->array[col], row->format);
+            _free_cell(self->array[col]);
+            self->array[col] = NULL;
+        }
     }
 
-    if (validation->validate != LXW_VALIDATION_TYPE_ANY)
-        lxw_xml_end_tag(self->file, "dataValidation");
-
-    LXW_FREE_ATTRIBUTES();
+    (void) fwrite(&end, 1, 1, self->file);
 }
 
 /*
- * Write the <dataValidations> element.
+ * Read data from a range of binary row records. Returns false at the end of
+ * the range.
  */
-STATIC void
-_worksheet_write_data_validations(lxw_worksheet *self)
+STATIC uint8_t
+_record_read(lxw_record_reader *reader, void *data, size_t length)
 {
-    struct xml_attribute_list attributes;
-    struct xml_attribute *attribute;
-    lxw_data_val_obj *data_validation;
+    unsigned char *p_data = data;
+    size_t size;
 
-    if (self->num_validations == 0)
-        return;
+    while (length) {
+        if (reader->pos == reader->used) {
+            if (!reader->remaining || !reader->file)
+                return LXW_FALSE;
 
-    LXW_INIT_ATTRIBUTES();
-    LXW_PUSH_ATTRIBUTES_INT("count", self->num_validations);
+            size = reader->remaining < LXW_BUFFER_SIZE ?
+                reader->remaining : LXW_BUFFER_SIZE;
+            size = fread(reader->buffer, 1, size, reader->file);
 
-    lxw_xml_start_tag(self->file, "dataValidations", &attributes);
+            if (!size)
+                return LXW_FALSE;
 
-    STAILQ_FOREACH(data_validation, self->data_validations, list_pointers) {
-        /* Write the dataValidation element. */
-        _worksheet_write_data_validation(self, data_validation);
-    }
+            reader->pos = 0;
+            reader->used = size;
+            reader->remaining -= size;
+        }
 
-    lxw_xml_end_tag(self->file, "dataValidations");
+        size = reader->used - reader->pos;
+        if (size > length)
+            size = length;
 
-    LXW_FREE_ATTRIBUTES();
-}
+        memcpy(p_data, reader->data + reader->pos, size);
+        reader->pos += size;
+        p_data += size;
+        length -= size;
+    }
 
-/*
- * Write the <formula> element for strings.
- */
-STATIC void
-_worksheet_write_formula_str(lxw_worksheet *self, char *data)
-{
-    lxw_xml_data_element(self->file, "formula", data, NULL);
+    return LXW_TRUE;
 }
 
 /*
- * Write the <formula> element for numbers.
+ * Read a variable length unsigned integer from a row record.
  */
-STATIC void
-_worksheet_write_formula_num(lxw_worksheet *self, double num)
+STATIC uint8_t
+_record_read_varint(lxw_record_reader *reader, uint32_t *value)
 {
-    char data[LXW_ATTR_32];
+    unsigned char byte;
+    uint8_t shift = 0;
 
-    lxw_sprintf_dbl(data, num);
-    lxw_xml_data_element(self->file, "formula", data, NULL);
+    *value = 0;
+
+    do {
+        if (shift > 28 || !_record_read(reader, &byte, 1))
+            return LXW_FALSE;
+
+        *value |= (uint32_t) (byte & 0x7F) << shift;
+        shift += 7;
+    } while (byte & 0x80);
+
+    return LXW_TRUE;
 }
 
 /*
- * Write the <ext> element.
+ * Read a length prefixed string from a row record into a new string.
  */
-STATIC void
-_worksheet_write_ext(lxw_worksheet *self, char *uri)
+STATIC uint8_t
+_record_read_string(lxw_record_reader *reader, char **string)
 {
-    struct xml_attribute_list attributes;
-    struct xml_attribute *attribute;
-    char xmlns_x_14[] =
-        "http://schemas.microsoft.com/office/spreadsheetml/2009/9/main";
+    uint32_t length;
 
-    LXW_INIT_ATTRIBUTES();
-    LXW_PUSH_ATTRIBUTES_STR("xmlns:x14", xmlns_x_14);
-    LXW_PUSH_ATTRIBUTES_STR("uri", uri);
+    *string = NULL;
 
-    lxw_xml_start_tag(self->file, "ext", &attributes);
+    if (!_record_read_varint(reader, &length))
+        return LXW_FALSE;
 
-    LXW_FREE_ATTRIBUTES();
+    if (!length)
+        return LXW_TRUE;
+
+    *string = calloc(1, length);
+    RETURN_ON_MEM_ERROR(*string, LXW_FALSE);
+
+    return _record_read(reader, *string, length - 1);
 }
 
 /*
- * Write the <extLst> dataBar extension element.
+ * Get the format stored for a row record format id.
  */
-STATIC void
-_worksheet_write_data_bar_ext(lxw_worksheet *self,
-                              lxw_cond_format_obj *cond_format)
+STATIC lxw_format *
+_record_format(lxw_worksheet *source, uint32_t id)
 {
-    /* Create a pseudo GUID for each unique Excel 2010 data bar. */
-    cond_format->guid = calloc(1, LXW_GUID_LENGTH);
-    lxw_snprintf(cond_format->guid, LXW_GUID_LENGTH,
-                 "{DA7ABA51-AAAA-BBBB-%04X-%012X}",
-                 self->index + 1, ++self->data_bar_2010_index);
-
-    lxw_xml_start_tag(self->file, "extLst", NULL);
-
-    _worksheet_write_ext(self, "{B025F937-C7B1-47D3-B67F-A62EFF666E3E}");
-
-    lxw_xml_data_element(self->file, "x14:id", cond_format->guid, NULL);
-
-    lxw_xml_end_tag(self->file, "ext");
-    lxw_xml_end_tag(self->file, "extLst");
+    if (id < source->record_formats_max)
+        return source->record_formats[id];
+    else
+        return NULL;
 }
 
 /*
- * Write the <color> element.
+ * Read the data of a cell from a row record.
  */
-STATIC void
-_worksheet_write_color(lxw_worksheet *self, lxw_color_t color)
+STATIC uint8_t
+_record_read_cell(lxw_worksheet *source, lxw_record_reader *reader,
+                  lxw_cell *cell)
 {
-    struct xml_attribute_list attributes;
-    struct xml_attribute *attribute;
-    char rgb[LXW_ATTR_32];
+    uint8_t type;
+    uint8_t boolean;
+    uint32_t value;
+    char *string;
 
-    lxw_snprintf(rgb, LXW_ATTR_32, "FF%06X", color & LXW_COLOR_MASK);
+    if (!_record_read(reader, &type, 1))
+        return LXW_FALSE;
 
-    LXW_INIT_ATTRIBUTES();
-    LXW_PUSH_ATTRIBUTES_STR("rgb", rgb);
+    if (type & LXW_CELL_RECORD_FORMAT) {
+        if (!_record_read_varint(reader, &value))
+            return LXW_FALSE;
 
-    lxw_xml_empty_tag(self->file, "color", &attributes);
+        cell->format = _record_format(source, value);
+    }
 
-    LXW_FREE_ATTRIBUTES();
-}
+    cell->type = (enum cell_types) (type & ~LXW_CELL_RECORD_FORMAT);
 
-/*
- * Write the <cfvo> element for strings.
- */
-STATIC void
-_worksheet_write_cfvo_str(lxw_worksheet *self, uint8_t rule_type,
-                          char *value, uint8_t data_bar_2010)
-{
-    struct xml_attribute_list attributes;
-    struct xml_attribute *attribute;
+    switch (cell->type) {
+        case NUMBER_CELL:
+        case ERROR_CELL:
+            return _record_read(reader, &cell->u.number, sizeof(double));
 
-    LXW_INIT_ATTRIBUTES();
+        case STRING_CELL:
+            if (!_record_read_varint(reader, &value))
+                return LXW_FALSE;
 
-    if (rule_type == LXW_CONDITIONAL_RULE_TYPE_MINIMUM)
-        LXW_PUSH_ATTRIBUTES_STR("type", "min");
-    else if (rule_type == LXW_CONDITIONAL_RULE_TYPE_NUMBER)
-        LXW_PUSH_ATTRIBUTES_STR("type", "num");
-    else if (rule_type == LXW_CONDITIONAL_RULE_TYPE_PERCENT)
-        LXW_PUSH_ATTRIBUTES_STR("type", "percent");
-    else if (rule_type == LXW_CONDITIONAL_RULE_TYPE_PERCENTILE)
-        LXW_PUSH_ATTRIBUTES_STR("type", "percentile");
-    else if (rule_type == LXW_CONDITIONAL_RULE_TYPE_FORMULA)
-        LXW_PUSH_ATTRIBUTES_STR("type", "formula");
-    else if (rule_type == LXW_CONDITIONAL_RULE_TYPE_MAXIMUM)
-        LXW_PUSH_ATTRIBUTES_STR("type", "max");
+            cell->u.string_id = (int32_t) value;
+            return LXW_TRUE;
 
-    if (!data_bar_2010 || (rule_type != LXW_CONDITIONAL_RULE_TYPE_MINIMUM
-                           && rule_type != LXW_CONDITIONAL_RULE_TYPE_MAXIMUM))
-        LXW_PUSH_ATTRIBUTES_STR("val", value);
+        case INLINE_STRING_CELL:
+        case INLINE_RICH_STRING_CELL:
+        case NUMBER_TEXT_CELL:
+            if (!_record_read_string(reader, &string))
+                return LXW_FALSE;
 
-    lxw_xml_empty_tag(self->file, "cfvo", &attributes);
+            cell->u.string = string;
+            return string != NULL;
 
-    LXW_FREE_ATTRIBUTES();
-}
+        case FORMULA_CELL:
+            if (!_record_read_string(reader, &string))
+                return LXW_FALSE;
 
-/*
- * Write the <cfvo> element for numbers.
- */
-STATIC void
-_worksheet_write_cfvo_num(lxw_worksheet *self, uint8_t rule_type,
-                          double value, uint8_t data_bar_2010)
-{
-    struct xml_attribute_list attributes;
-    struct xml_attribute *attribute;
+            cell->u.string = string;
 
-    LXW_INIT_ATTRIBUTES();
+            return _record_read(reader, &cell->formula_result,
+                                sizeof(double))
+                && _record_read_string(reader, &cell->user_data2);
 
-    if (rule_type == LXW_CONDITIONAL_RULE_TYPE_MINIMUM)
-        LXW_PUSH_ATTRIBUTES_STR("type", "min");
-    else if (rule_type == LXW_CONDITIONAL_RULE_TYPE_NUMBER)
-        LXW_PUSH_ATTRIBUTES_STR("type", "num");
-    else if (rule_type == LXW_CONDITIONAL_RULE_TYPE_PERCENT)
-        LXW_PUSH_ATTRIBUTES_STR("type", "percent");
-    else if (rule_type == LXW_CONDITIONAL_RULE_TYPE_PERCENTILE)
-        LXW_PUSH_ATTRIBUTES_STR("type", "percentile");
-    else if (rule_type == LXW_CONDITIONAL_RULE_TYPE_FORMULA)
-        LXW_PUSH_ATTRIBUTES_STR("type", "formula");
-    else if (rule_type == LXW_CONDITIONAL_RULE_TYPE_MAXIMUM)
-        LXW_PUSH_ATTRIBUTES_STR("type", "max");
+        case ARRAY_FORMULA_CELL:
+        case DYNAMIC_ARRAY_FORMULA_CELL:
+            if (!_record_read_string(reader, &string))
+                return LXW_FALSE;
 
-    if (!data_bar_2010 || (rule_type != LXW_CONDITIONAL_RULE_TYPE_MINIMUM
-                           && rule_type != LXW_CONDITIONAL_RULE_TYPE_MAXIMUM))
-        LXW_PUSH_ATTRIBUTES_DBL("val", value);
+            cell->u.string = string;
 
-    lxw_xml_empty_tag(self->file, "cfvo", &attributes);
+            return _record_read(reader, &cell->formula_result,
+                                sizeof(double))
+                && _record_read_string(reader, &cell->user_data1);
 
-    LXW_FREE_ATTRIBUTES();
+        case BOOLEAN_CELL:
+            if (!_record_read(reader, &boolean, 1))
+                return LXW_FALSE;
+
+            cell->u.number = boolean;
+            return LXW_TRUE;
+
+        case BLANK_CELL:
+            return LXW_TRUE;
+
+        default:
+            return LXW_FALSE;
+    }
 }
 
 /*
- * Write the <iconSet> element.
+ * Convert a range of the binary row records in the constant_memory temp
+ * file, or memory buffer, of a worksheet or segment to XML in the worksheet
+ * XML file.
  */
 STATIC void
-_worksheet_write_icon_set(lxw_worksheet *self,
-                          lxw_cond_format_obj *cond_format)
-{
-    struct xml_attribute_list attributes;
-    struct xml_attribute *attribute;
-    char *icon_set[] = {
-        "3Arrows",
-        "3ArrowsGray",
-        "3Flags",
-        "3TrafficLights",
-        "3TrafficLights2",
-        "3Signs",
-        "3Symbols",
-        "3Symbols2",
-        "4Arrows",
-        "4ArrowsGray",
-        "4RedToBlack",
-        "4Rating",
-        "4TrafficLights",
-        "5Arrows",
-        "5ArrowsGray",
-        "5Rating",
-        "5Quarters",
-    };
-    uint8_t percent = LXW_CONDITIONAL_RULE_TYPE_PERCENT;
-    uint8_t style = cond_format->icon_style;
+_worksheet_render_row_records(lxw_worksheet *self, lxw_worksheet *source,
+                              size_t start, size_t end)
+{
+    lxw_record_reader *reader;
+    lxw_row row;
+    lxw_cell cell;
+    uint8_t flags;
+    uint32_t value;
+    lxw_col_t last_col;
+    uint8_t is_valid;
+
+    reader = calloc(1, sizeof(lxw_record_reader));
+    if (!reader) {
+        LXW_MEM_ERROR();
+        return;
+    }
 
-    LXW_INIT_ATTRIBUTES();
+    if (source->optimize_buffer) {
+        reader->data = (const unsigned char *) source->optimize_buffer + start;
+        reader->used = end - start;
+    }
+    else {
+        if (fseek(source->optimize_tmpfile, (long) start, SEEK_SET)) {
+            free(reader);
+            return;
+        }
 
-    if (style != LXW_CONDITIONAL_ICONS_3_TRAFFIC_LIGHTS_UNRIMMED)
-        LXW_PUSH_ATTRIBUTES_STR("iconSet", icon_set[style]);
+        reader->file = source->optimize_tmpfile;
+        reader->data = reader->buffer;
+        reader->remaining = end - start;
+    }
 
-    if (cond_format->reverse_icons == LXW_TRUE)
-        LXW_PUSH_ATTRIBUTES_STR("reverse", "1");
+    memset(&row, 0, sizeof(row));
 
-    if (cond_format->icons_only == LXW_TRUE)
-        LXW_PUSH_ATTRIBUTES_STR("showValue", "0");
+    while (_record_read_varint(reader, &value)) {
+        row.row_num = value;
 
-    lxw_xml_start_tag(self->file, "iconSet", &attributes);
+        if (!_record_read(reader, &flags, 1)
+            || !_record_read(reader, &row.level, 1))
+            break;
 
-    if (style < LXW_CONDITIONAL_ICONS_4_ARROWS_COLORED) {
-        _worksheet_write_cfvo_num(self, percent, 0, LXW_FALSE);
-        _worksheet_write_cfvo_num(self, percent, 33, LXW_FALSE);
-        _worksheet_write_cfvo_num(self, percent, 67, LXW_FALSE);
-    }
+        row.hidden = !!(flags & LXW_ROW_RECORD_HIDDEN);
+        row.collapsed = !!(flags & LXW_ROW_RECORD_COLLAPSED);
+        row.height_changed = !!(flags & LXW_ROW_RECORD_HEIGHT);
+        row.data_changed = !!(flags & LXW_ROW_RECORD_DATA);
+        row.format = NULL;
+        row.height = LXW_DEF_ROW_HEIGHT;
 
-    if (style >= LXW_CONDITIONAL_ICONS_4_ARROWS_COLORED
-        && style < LXW_CONDITIONAL_ICONS_5_ARROWS_COLORED) {
-        _worksheet_write_cfvo_num(self, percent, 0, LXW_FALSE);
-        _worksheet_write_cfvo_num(self, percent, 25, LXW_FALSE);
-        _worksheet_write_cfvo_num(self, percent, 50, LXW_FALSE);
-        _worksheet_write_cfvo_num(self, percent, 75, LXW_FALSE);
-    }
+        if (flags & LXW_ROW_RECORD_FORMAT) {
+            if (!_record_read_varint(reader, &value))
+                break;
 
-    if (style >= LXW_CONDITIONAL_ICONS_5_ARROWS_COLORED
-        && style <= LXW_CONDITIONAL_ICONS_5_QUARTERS) {
-        _worksheet_write_cfvo_num(self, percent, 0, LXW_FALSE);
-        _worksheet_write_cfvo_num(self, percent, 20, LXW_FALSE);
-        _worksheet_write_cfvo_num(self, percent, 40, LXW_FALSE);
-        _worksheet_write_cfvo_num(self, percent, 60, LXW_FALSE);
-        _worksheet_write_cfvo_num(self, percent, 80, LXW_FALSE);
-    }
+            row.format = _record_format(source, value);
+        }
 
-    LXW_FREE_ATTRIBUTES();
-}
+        if (row.height_changed
+            && !_record_read(reader, &row.height, sizeof(double)))
+            break;
 
-/*
- * Write the <cfRule> element for data bar rules.
- */
-STATIC void
-_worksheet_write_cf_rule_icons(lxw_worksheet *self,
-                               lxw_cond_format_obj *cond_format)
-{
-    struct xml_attribute_list attributes;
-    struct xml_attribute *attribute;
+        _write_row(self, &row, NULL);
 
-    LXW_INIT_ATTRIBUTES();
+        if (!row.data_changed)
+            continue;
 
-    LXW_PUSH_ATTRIBUTES_STR("type", cond_format->type_string);
-    LXW_PUSH_ATTRIBUTES_INT("priority", cond_format->dxf_priority);
-    lxw_xml_start_tag(self->file, "cfRule", &attributes);
+        last_col = 0;
+        is_valid = LXW_TRUE;
 
-    _worksheet_write_icon_set(self, cond_format);
+        while (is_valid) {
+            is_valid = _record_read_varint(reader, &value);
 
-    lxw_xml_end_tag(self->file, "iconSet");
-    lxw_xml_end_tag(self->file, "cfRule");
+            /* A column increment of 0 marks the end of the row. */
+            if (!is_valid || !value)
+                break;
 
-    LXW_FREE_ATTRIBUTES();
-}
+            memset(&cell, 0, sizeof(cell));
+            cell.row_num = row.row_num;
+            cell.col_num = (lxw_col_t) (last_col + value - 1);
+            last_col = cell.col_num + 1;
 
-/*
- * Write the <dataBar> element.
- */
-STATIC void
-_worksheet_write_data_bar(lxw_worksheet *self,
-                          lxw_cond_format_obj *cond_format)
-{
-    struct xml_attribute_list attributes;
-    struct xml_attribute *attribute;
+            is_valid = _record_read_cell(source, reader, &cell);
 
-    LXW_INIT_ATTRIBUTES();
+            if (is_valid)
+                _write_cell(self, &cell, row.format);
 
-    if (cond_format->bar_only)
-        LXW_PUSH_ATTRIBUTES_STR("showValue", "0");
+            _free_cell_data(&cell);
+        }
 
-    lxw_xml_start_tag(self->file, "dataBar", &attributes);
+        lxw_xml_end_tag(self->file, "row");
 
-    LXW_FREE_ATTRIBUTES();
+        if (!is_valid)
+            break;
+    }
+
+    free(reader);
 }
 
 /*
- * Write the <cfRule> element for data bar rules.
+ * Write out the worksheet data as a single row with cells. This method is
+ * used when memory optimization is on. A single row is written and the data
+ * array is reset. That way only one row of data is kept in memory at any one
+ * time. We don't write span data in the optimized case since it is optional.
  */
-STATIC void
-_worksheet_write_cf_rule_data_bar(lxw_worksheet *self,
-                                  lxw_cond_format_obj *cond_format)
+void
+lxw_worksheet_write_single_row(lxw_worksheet *self)
 {
-    struct xml_attribute_list attributes;
-    struct xml_attribute *attribute;
-
-    LXW_INIT_ATTRIBUTES();
+    lxw_row *row = self->optimize_row;
+    lxw_col_t col;
 
-    LXW_PUSH_ATTRIBUTES_STR("type", cond_format->type_string);
-    LXW_PUSH_ATTRIBUTES_INT("priority", cond_format->dxf_priority);
-    lxw_xml_start_tag(self->file, "cfRule", &attributes);
+    /* skip row if it doesn't contain row formatting, cell data or a comment. */
+    if (!(row->row_changed || row->data_changed))
+        return;
 
-    _worksheet_write_data_bar(self, cond_format);
+    /* Store the temp file offset of the segments that precede the row. */
+    if (!STAILQ_EMPTY(self->segments))
+        _worksheet_mark_segment_offsets(self, row->row_num);
 
-    if (cond_format->min_value_string) {
-        _worksheet_write_cfvo_str(self, cond_format->min_rule_type,
-                                  cond_format->min_value_string,
-                                  cond_format->data_bar_2010);
-    }
-    else {
-        _worksheet_write_cfvo_num(self, cond_format->min_rule_type,
-                                  cond_format->min_value,
-                                  cond_format->data_bar_2010);
+    /* Write the cells if the row contains data. */
+    if (self->binary_tmpfile) {
+        /* Row and any cell data as a binary record. */
+        _worksheet_write_row_record(self, row);
     }
-
-    if (cond_format->max_value_string) {
-        _worksheet_write_cfvo_str(self, cond_format->max_rule_type,
-                                  cond_format->max_value_string,
-                                  cond_format->data_bar_2010);
+    else if (!row->data_changed) {
+        /* Row data only. No cells. */
+        _write_row(self, row, NULL);
     }
     else {
-        _worksheet_write_cfvo_num(self, cond_format->max_rule_type,
-                                  cond_format->max_value,
-                                  cond_format->data_bar_2010);
-    }
-
-    _worksheet_write_color(self, cond_format->bar_color);
-
-    lxw_xml_end_tag(self->file, "dataBar");
+        /* Row and cell data. */
+        _write_row(self, row, NULL);
 
-    if (cond_format->data_bar_2010)
-        _worksheet_write_data_bar_ext(self, cond_format);
+        for (col = self->dim_colmin; col <= self->dim_colmax; col++) {
+            if (self->array[col]) {
+                _write_cell(self, self->array[col], row->format);
+                _free_cell(self->array[col]);
+                self->array[col] = NULL;
+            }
+        }
 
-    lxw_xml_end_tag(self->file, "cfRule");
+        lxw_xml_end_tag(self->file, "row");
+    }
 
-    LXW_FREE_ATTRIBUTES();
+    /* Reset the row. */
+    row->height = LXW_DEF_ROW_HEIGHT;
+    row->format = NULL;
+    row->hidden = LXW_FALSE;
+    row->level = 0;
+    row->collapsed = LXW_FALSE;
+    row->data_changed = LXW_FALSE;
+    row->row_changed = LXW_FALSE;
 }
 
-/*
- * Write the <cfRule> element for 2 and 3 color scale rules.
- */
-STATIC void
-_worksheet_write_cf_rule_color_scale(lxw_worksheet *self,
-                                     lxw_cond_format_obj *cond_format)
+/* Process a header/footer image and store it in the correct slot. */
+lxw_error
+_worksheet_set_header_footer_image(lxw_worksheet *self, const char *filename,
+                                   uint8_t image_position)
 {
-    struct xml_attribute_list attributes;
-    struct xml_attribute *attribute;
+    FILE *image_stream;
+    const char *description;
+    lxw_object_properties *object_props;
+    char *image_strings[] = { "LH", "CH", "RH", "LF", "CF", "RF" };
 
-    LXW_INIT_ATTRIBUTES();
+    /* Not all slots will have image files. */
+    if (!filename)
+        return LXW_NO_ERROR;
 
-    LXW_PUSH_ATTRIBUTES_STR("type", cond_format->type_string);
-    LXW_PUSH_ATTRIBUTES_INT("priority", cond_format->dxf_priority);
-    lxw_xml_start_tag(self->file, "cfRule", &attributes);
-
-    lxw_xml_start_tag(self->file, "colorScale", NULL);
-
-    if (cond_format->min_value_string) {
-        _worksheet_write_cfvo_str(self, cond_format->min_rule_type,
-                                  cond_format->min_value_string, LXW_FALSE);
-    }
-    else {
-        _worksheet_write_cfvo_num(self, cond_format->min_rule_type,
-                                  cond_format->min_value, LXW_FALSE);
+    /* Check that the image file exists and can be opened. */
+    image_stream = lxw_fopen(filename, "rb");
+    if (!image_stream) {
+        LXW_WARN_FORMAT1("worksheet_set_header_opt/footer_opt(): "
+                         "file doesn't exist or can't be opened: %s.",
+                         filename);
+        return LXW_ERROR_PARAMETER_VALIDATION;
     }
 
-    if (cond_format->type == LXW_CONDITIONAL_3_COLOR_SCALE) {
-        if (cond_format->mid_value_string) {
-            _worksheet_write_cfvo_str(self, cond_format->mid_rule_type,
-                                      cond_format->mid_value_string,
-                                      LXW_FALSE);
-        }
-        else {
-            _worksheet_write_cfvo_num(self, cond_format->mid_rule_type,
-                                      cond_format->mid_value, LXW_FALSE);
-        }
+    /* Use the filename as the default description, like Excel. */
+    description = lxw_basename(filename);
+    if (!description) {
+        LXW_WARN_FORMAT1("worksheet_set_header_opt/footer_opt(): "
+                         "couldn't get basename for file: %s.", filename);
+        fclose(image_stream);
+        return LXW_ERROR_PARAMETER_VALIDATION;
     }
 
-    if (cond_format->max_value_string) {
-        _worksheet_write_cfvo_str(self, cond_format->max_rule_type,
-                                  cond_format->max_value_string, LXW_FALSE);
-    }
-    else {
-        _worksheet_write_cfvo_num(self, cond_format->max_rule_type,
-                                  cond_format->max_value, LXW_FALSE);
+    /* Create a new object to hold the image properties. */
+    object_props = calloc(1, sizeof(lxw_object_properties));
+    if (!object_props) {
+        fclose(image_stream);
+        return LXW_ERROR_MEMORY_MALLOC_FAILED;
     }
 
-    _worksheet_write_color(self, cond_format->min_color);
-
-    if (cond_format->type == LXW_CONDITIONAL_3_COLOR_SCALE)
-        _worksheet_write_color(self, cond_format->mid_color);
-
-    _worksheet_write_color(self, cond_format->max_color);
+    /* Copy other options or set defaults. */
+    object_props->filename = lxw_strdup(filename);
+    object_props->description = lxw_strdup(description);
+    object_props->stream = image_stream;
 
-    lxw_xml_end_tag(self->file, "colorScale");
-    lxw_xml_end_tag(self->file, "cfRule");
+    /* Set VML image position string based on the header/footer/position. */
+    object_props->image_position = lxw_strdup(image_strings[image_position]);
 
-    LXW_FREE_ATTRIBUTES();
+    if (_get_image_properties(object_props) == LXW_NO_ERROR) {
+        *self->header_footer_objs[image_position] = object_props;
+        self->has_header_vml = LXW_TRUE;
+        fclose(image_stream);
+        return LXW_NO_ERROR;
+    }
+    else {
+        _free_object_properties(object_props);
+        fclose(image_stream);
+        return LXW_ERROR_IMAGE_DIMENSIONS;
+    }
 }
 
 /*
- * Write the <cfRule> element for formula rules.
+ * Write the <col> element.
  */
 STATIC void
-_worksheet_write_cf_rule_formula(lxw_worksheet *self,
-                                 lxw_cond_format_obj *cond_format)
+_worksheet_write_col_info(lxw_worksheet *self, lxw_col_options *options)
 {
     struct xml_attribute_list attributes;
     struct xml_attribute *attribute;
 
-    LXW_INIT_ATTRIBUTES();
+    double width = options->width;
+    uint8_t has_custom_width = LXW_TRUE;
+    int32_t xf_index = 0;
+    double max_digit_width = 7.0;       /* For Calabri 11. */
+    double padding = 5.0;
 
-    LXW_PUSH_ATTRIBUTES_STR("type", cond_format->type_string);
+    /* Get the format index. */
+    if (options->format) {
+        xf_index = lxw_format_get_xf_index(options->format);
+    }
 
-    if (cond_format->dxf_index != LXW_PROPERTY_UNSET)
-        LXW_PUSH_ATTRIBUTES_INT("dxfId", cond_format->dxf_index);
+    /* Check if width is the Excel default. */
+    if (width == LXW_DEF_COL_WIDTH) {
 
-    LXW_PUSH_ATTRIBUTES_INT("priority", cond_format->dxf_priority);
+        /* The default col width changes to 0 for hidden columns. */
+        if (options->hidden)
+            width = 0;
+        else
+            has_custom_width = LXW_FALSE;
 
-    if (cond_format->stop_if_true)
-        LXW_PUSH_ATTRIBUTES_INT("stopIfTrue", 1);
+    }
 
-    lxw_xml_start_tag(self->file, "cfRule", &attributes);
+    /* Convert column width from user units to character width. */
+    if (width > 0) {
+        if (width < 1) {
+            width = (uint16_t) (((uint16_t)
+                                 (width * (max_digit_width + padding) + 0.5))
+                                / max_digit_width * 256.0) / 256.0;
+        }
+        else {
+            width = (uint16_t) (((uint16_t)
+                                 (width * max_digit_width + 0.5) + padding)
+                                / max_digit_width * 256.0) / 256.0;
+        }
+    }
 
-    _worksheet_write_formula_str(self, cond_format->min_value_string);
+    LXW_INIT_ATTRIBUTES();
+    LXW_PUSH_ATTRIBUTES_INT("min", 1 + options->firstcol);
+    LXW_PUSH_ATTRIBUTES_INT("max", 1 + options->lastcol);
+    LXW_PUSH_ATTRIBUTES_DBL("width", width);
 
-    lxw_xml_end_tag(self->file, "cfRule");
+    if (xf_index)
+        LXW_PUSH_ATTRIBUTES_INT("style", xf_index);
+
+    if (options->hidden)
+        LXW_PUSH_ATTRIBUTES_STR("hidden", "1");
+
+    if (has_custom_width)
+        LXW_PUSH_ATTRIBUTES_STR("customWidth", "1");
+
+    if (options->level)
+        LXW_PUSH_ATTRIBUTES_INT("outlineLevel", options->level);
+
+    if (options->collapsed)
+        LXW_PUSH_ATTRIBUTES_STR("collapsed", "1");
+
+    lxw_xml_empty_tag(self->file, "col", &attributes);
 
     LXW_FREE_ATTRIBUTES();
 }
 
 /*
- * Write the <cfRule> element for top and bottom rules.
+ * Write the <cols> element and <col> sub elements.
  */
 STATIC void
-_worksheet_write_cf_rule_top(lxw_worksheet *self,
-                             lxw_cond_format_obj *cond_format)
+_worksheet_write_cols(lxw_worksheet *self)
 {
-    struct xml_attribute_list attributes;
-    struct xml_attribute *attribute;
-
-    LXW_INIT_ATTRIBUTES();
-
-    LXW_PUSH_ATTRIBUTES_STR("type", cond_format->type_string);
-
-    if (cond_format->dxf_index != LXW_PROPERTY_UNSET)
-        LXW_PUSH_ATTRIBUTES_INT("dxfId", cond_format->dxf_index);
-
-    LXW_PUSH_ATTRIBUTES_INT("priority", cond_format->dxf_priority);
-
-    if (cond_format->stop_if_true)
-        LXW_PUSH_ATTRIBUTES_INT("stopIfTrue", 1);
-
-    if (cond_format->criteria ==
-        LXW_CONDITIONAL_CRITERIA_TOP_OR_BOTTOM_PERCENT)
-        LXW_PUSH_ATTRIBUTES_INT("percent", 1);
+    lxw_col_t col;
 
-    if (cond_format->type == LXW_CONDITIONAL_TYPE_BOTTOM)
-        LXW_PUSH_ATTRIBUTES_INT("bottom", 1);
+    if (!self->col_size_changed)
+        return;
 
-    /* Rank must be an int in the range 1-1000 . */
-    if (cond_format->min_value < 1.0 || cond_format->min_value > 1000.0)
-        LXW_PUSH_ATTRIBUTES_DBL("rank", 10);
-    else
-        LXW_PUSH_ATTRIBUTES_DBL("rank", (uint16_t) cond_format->min_value);
+    lxw_xml_start_tag(self->file, "cols", NULL);
 
-    lxw_xml_empty_tag(self->file, "cfRule", &attributes);
+    for (col = 0; col < self->col_options_max; col++) {
+        if (self->col_options[col])
+            _worksheet_write_col_info(self, self->col_options[col]);
+    }
 
-    LXW_FREE_ATTRIBUTES();
+    lxw_xml_end_tag(self->file, "cols");
 }
 
 /*
- * Write the <cfRule> element for unique/duplicate rules.
+ * Write the <mergeCell> element.
  */
 STATIC void
-_worksheet_write_cf_rule_duplicate(lxw_worksheet *self,
-                                   lxw_cond_format_obj *cond_format)
+_worksheet_write_merge_cell(lxw_worksheet *self,
+                            lxw_merged_range *merged_range)
 {
+
     struct xml_attribute_list attributes;
     struct xml_attribute *attribute;
+    char ref[LXW_MAX_CELL_RANGE_LENGTH];
 
     LXW_INIT_ATTRIBUTES();
 
-    LXW_PUSH_ATTRIBUTES_STR("type", cond_format->type_string);
-
-    /* Set the attributes common to all rule types. */
-    if (cond_format->dxf_index != LXW_PROPERTY_UNSET)
-        LXW_PUSH_ATTRIBUTES_INT("dxfId", cond_format->dxf_index);
+    /* Convert the merge dimensions to a cell range. */
+    lxw_rowcol_to_range(ref, merged_range->first_row, merged_range->first_col,
+                        merged_range->last_row, merged_range->last_col);
 
-    LXW_PUSH_ATTRIBUTES_INT("priority", cond_format->dxf_priority);
+    LXW_PUSH_ATTRIBUTES_STR("ref", ref);
 
-    lxw_xml_empty_tag(self->file, "cfRule", &attributes);
+    lxw_xml_empty_tag(self->file, "mergeCell", &attributes);
 
     LXW_FREE_ATTRIBUTES();
 }
 
 /*
- * Write the <cfRule> element for averages rules.
+ * Write the <mergeCells> element.
  */
 STATIC void
-_worksheet_write_cf_rule_average(lxw_worksheet *self,
-                                 lxw_cond_format_obj *cond_format)
+_worksheet_write_merge_cells(lxw_worksheet *self)
 {
     struct xml_attribute_list attributes;
     struct xml_attribute *attribute;
-    uint8_t criteria = cond_format->criteria;
-
-    LXW_INIT_ATTRIBUTES();
-
-    LXW_PUSH_ATTRIBUTES_STR("type", cond_format->type_string);
-
-    if (cond_format->dxf_index != LXW_PROPERTY_UNSET)
-        LXW_PUSH_ATTRIBUTES_INT("dxfId", cond_format->dxf_index);
-
-    LXW_PUSH_ATTRIBUTES_INT("priority", cond_format->dxf_priority);
-
-    if (cond_format->stop_if_true)
-        LXW_PUSH_ATTRIBUTES_INT("stopIfTrue", 1);
-
-    if (criteria == LXW_CONDITIONAL_CRITERIA_AVERAGE_BELOW
-        || criteria == LXW_CONDITIONAL_CRITERIA_AVERAGE_BELOW_OR_EQUAL
-        || criteria == LXW_CONDITIONAL_CRITERIA_AVERAGE_1_STD_DEV_BELOW
-        || criteria == LXW_CONDITIONAL_CRITERIA_AVERAGE_2_STD_DEV_BELOW
-        || criteria == LXW_CONDITIONAL_CRITERIA_AVERAGE_3_STD_DEV_BELOW)
-        LXW_PUSH_ATTRIBUTES_INT("aboveAverage", 0);
-
-    if (criteria == LXW_CONDITIONAL_CRITERIA_AVERAGE_ABOVE_OR_EQUAL
-        || criteria == LXW_CONDITIONAL_CRITERIA_AVERAGE_BELOW_OR_EQUAL)
-        LXW_PUSH_ATTRIBUTES_INT("equalAverage", 1);
+    lxw_merged_range *merged_range;
 
-    if (criteria == LXW_CONDITIONAL_CRITERIA_AVERAGE_1_STD_DEV_ABOVE
-        || criteria == LXW_CONDITIONAL_CRITERIA_AVERAGE_1_STD_DEV_BELOW)
-        LXW_PUSH_ATTRIBUTES_INT("stdDev", 1);
+    if (self->merged_range_count) {
+        LXW_INIT_ATTRIBUTES();
 
-    if (criteria == LXW_CONDITIONAL_CRITERIA_AVERAGE_2_STD_DEV_ABOVE
-        || criteria == LXW_CONDITIONAL_CRITERIA_AVERAGE_2_STD_DEV_BELOW)
-        LXW_PUSH_ATTRIBUTES_INT("stdDev", 2);
+        LXW_PUSH_ATTRIBUTES_INT("count", self->merged_range_count);
 
-    if (criteria == LXW_CONDITIONAL_CRITERIA_AVERAGE_3_STD_DEV_ABOVE
-        || criteria == LXW_CONDITIONAL_CRITERIA_AVERAGE_3_STD_DEV_BELOW)
-        LXW_PUSH_ATTRIBUTES_INT("stdDev", 3);
+        lxw_xml_start_tag(self->file, "mergeCells", &attributes);
 
-    lxw_xml_empty_tag(self->file, "cfRule", &attributes);
+        STAILQ_FOREACH(merged_range, self->merged_ranges, list_pointers) {
+            _worksheet_write_merge_cell(self, merged_range);
+        }
+        lxw_xml_end_tag(self->file, "mergeCells");
 
-    LXW_FREE_ATTRIBUTES();
+        LXW_FREE_ATTRIBUTES();
+    }
 }
 
 /*
- * Write the <cfRule> element for time_period rules.
+ * Write the <oddHeader> element.
  */
 STATIC void
-_worksheet_write_cf_rule_time_period(lxw_worksheet *self,
-                                     lxw_cond_format_obj *cond_format)
+_worksheet_write_odd_header(lxw_worksheet *self)
+{
+    lxw_xml_data_element(self->file, "oddHeader", self->header, NULL);
+}
+
+/*
+ * Write the <oddFooter> element.
+ */
+STATIC void
+_worksheet_write_odd_footer(lxw_worksheet *self)
+{
+    lxw_xml_data_element(self->file, "oddFooter", self->footer, NULL);
+}
+
+/*
+ * Write the <headerFooter> element.
+ */
+STATIC void
+_worksheet_write_header_footer(lxw_worksheet *self)
+{
+    if (!self->header_footer_changed)
+        return;
+
+    lxw_xml_start_tag(self->file, "headerFooter", NULL);
+
+    if (self->header)
+        _worksheet_write_odd_header(self);
+
+    if (self->footer)
+        _worksheet_write_odd_footer(self);
+
+    lxw_xml_end_tag(self->file, "headerFooter");
+}
+
+/*
+ * Write the <pageSetUpPr> element.
+ */
+STATIC void
+_worksheet_write_page_set_up_pr(lxw_worksheet *self)
 {
     struct xml_attribute_list attributes;
     struct xml_attribute *attribute;
-    char formula[LXW_MAX_ATTRIBUTE_LENGTH];
-    uint8_t pos;
-    uint8_t criteria = cond_format->criteria;
-    char *first_cell = cond_format->first_cell;
-    char *time_periods[] = {
-        "yesterday",
-        "today",
-        "tomorrow",
-        "last7Days",
-        "lastWeek",
-        "thisWeek",
-        "nextWeek",
-        "lastMonth",
-        "thisMonth",
-        "nextMonth",
-    };
+
+    if (!self->fit_page)
+        return;
 
     LXW_INIT_ATTRIBUTES();
+    LXW_PUSH_ATTRIBUTES_STR("fitToPage", "1");
 
-    LXW_PUSH_ATTRIBUTES_STR("type", cond_format->type_string);
+    lxw_xml_empty_tag(self->file, "pageSetUpPr", &attributes);
 
-    if (cond_format->dxf_index != LXW_PROPERTY_UNSET)
-        LXW_PUSH_ATTRIBUTES_INT("dxfId", cond_format->dxf_index);
+    LXW_FREE_ATTRIBUTES();
 
-    LXW_PUSH_ATTRIBUTES_INT("priority", cond_format->dxf_priority);
+}
 
-    pos = criteria - LXW_CONDITIONAL_CRITERIA_TIME_PERIOD_YESTERDAY;
-    LXW_PUSH_ATTRIBUTES_STR("timePeriod", time_periods[pos]);
+/*
+ * Write the <tabColor> element.
+ */
+STATIC void
+_worksheet_write_tab_color(lxw_worksheet *self)
+{
+    struct xml_attribute_list attributes;
+    struct xml_attribute *attribute;
+    char rgb_str[LXW_ATTR_32];
 
-    if (cond_format->stop_if_true)
-        LXW_PUSH_ATTRIBUTES_INT("stopIfTrue", 1);
+    if (self->tab_color == LXW_COLOR_UNSET)
+        return;
 
-    lxw_xml_start_tag(self->file, "cfRule", &attributes);
+    lxw_snprintf(rgb_str, LXW_ATTR_32, "FF%06X",
+                 self->tab_color & LXW_COLOR_MASK);
 
-    if (criteria == LXW_CONDITIONAL_CRITERIA_TIME_PERIOD_YESTERDAY) {
-        lxw_snprintf(formula, LXW_MAX_ATTRIBUTE_LENGTH,
-                     "FLOOR(%s,1)=TODAY()-1", first_cell);
-        _worksheet_write_formula_str(self, formula);
-    }
-    else if (criteria == LXW_CONDITIONAL_CRITERIA_TIME_PERIOD_TODAY) {
-        lxw_snprintf(formula, LXW_MAX_ATTRIBUTE_LENGTH,
-                     "FLOOR(%s,1)=TODAY()", first_cell);
-        _worksheet_write_formula_str(self, formula);
-    }
-    else if (criteria == LXW_CONDITIONAL_CRITERIA_TIME_PERIOD_TOMORROW) {
-        lxw_snprintf(formula, LXW_MAX_ATTRIBUTE_LENGTH,
-                     "FLOOR(%s,1)=TODAY()+1", first_cell);
-        _worksheet_write_formula_str(self, formula);
-    }
-    else if (criteria == LXW_CONDITIONAL_CRITERIA_TIME_PERIOD_LAST_7_DAYS) {
-        lxw_snprintf(formula, LXW_MAX_ATTRIBUTE_LENGTH,
-                     "AND(TODAY()-FLOOR(%s,1)<=6,FLOOR(%s,1)<=TODAY())",
-                     first_cell, first_cell);
-        _worksheet_write_formula_str(self, formula);
-    }
-    else if (criteria == LXW_CONDITIONAL_CRITERIA_TIME_PERIOD_LAST_WEEK) {
-        lxw_snprintf(formula, LXW_MAX_ATTRIBUTE_LENGTH,
-                     "AND(TODAY()-ROUNDDOWN(%s,0)>=(WEEKDAY(TODAY())),"
-                     "TODAY()-ROUNDDOWN(%s,0)<(WEEKDAY(TODAY())+7))",
-                     first_cell, first_cell);
-        _worksheet_write_formula_str(self, formula);
-    }
-    else if (criteria == LXW_CONDITIONAL_CRITERIA_TIME_PERIOD_THIS_WEEK) {
-        lxw_snprintf(formula, LXW_MAX_ATTRIBUTE_LENGTH,
-                     "AND(TODAY()-ROUNDDOWN(%s,0)<=WEEKDAY(TODAY())-1,"
-                     "ROUNDDOWN(%s,0)-TODAY()<=7-WEEKDAY(TODAY()))",
-                     first_cell, first_cell);
-        _worksheet_write_formula_str(self, formula);
-    }
-    else if (criteria == LXW_CONDITIONAL_CRITERIA_TIME_PERIOD_NEXT_WEEK) {
-        lxw_snprintf(formula, LXW_MAX_ATTRIBUTE_LENGTH,
-                     "AND(ROUNDDOWN(%s,0)-TODAY()>(7-WEEKDAY(TODAY())),"
-                     "ROUNDDOWN(%s,0)-TODAY()<(15-WEEKDAY(TODAY())))",
-                     first_cell, first_cell);
-        _worksheet_write_formula_str(self, formula);
-    }
-    else if (criteria == LXW_CONDITIONAL_CRITERIA_TIME_PERIOD_LAST_MONTH) {
-        lxw_snprintf(formula, LXW_MAX_ATTRIBUTE_LENGTH,
-                     "AND(MONTH(%s)=MONTH(TODAY())-1,OR(YEAR(%s)=YEAR("
-                     "TODAY()),AND(MONTH(%s)=1,YEAR(A1)=YEAR(TODAY())-1)))",
-                     first_cell, first_cell, first_cell);
-        _worksheet_write_formula_str(self, formula);
-    }
-    else if (criteria == LXW_CONDITIONAL_CRITERIA_TIME_PERIOD_THIS_MONTH) {
-        lxw_snprintf(formula, LXW_MAX_ATTRIBUTE_LENGTH,
-                     "AND(MONTH(%s)=MONTH(TODAY()),YEAR(%s)=YEAR(TODAY()))",
-                     first_cell, first_cell);
-        _worksheet_write_formula_str(self, formula);
-    }
-    else if (criteria == LXW_CONDITIONAL_CRITERIA_TIME_PERIOD_NEXT_MONTH) {
-        lxw_snprintf(formula, LXW_MAX_ATTRIBUTE_LENGTH,
-                     "AND(MONTH(%s)=MONTH(TODAY())+1,OR(YEAR(%s)=YEAR("
-                     "TODAY()),AND(MONTH(%s)=12,YEAR(%s)=YEAR(TODAY())+1)))",
-                     first_cell, first_cell, first_cell, first_cell);
-        _worksheet_write_formula_str(self, formula);
-    }
+    LXW_INIT_ATTRIBUTES();
+    LXW_PUSH_ATTRIBUTES_STR("rgb", rgb_str);
 
-    lxw_xml_end_tag(self->file, "cfRule");
+    lxw_xml_empty_tag(self->file, "tabColor", &attributes);
 
     LXW_FREE_ATTRIBUTES();
 }
 
 /*
- * Write the <cfRule> element for blanks/no_blanks, errors/no_errors rules.
+ * Write the <outlinePr> element.
  */
 STATIC void
-_worksheet_write_cf_rule_blanks(lxw_worksheet *self,
-                                lxw_cond_format_obj *cond_format)
+_worksheet_write_outline_pr(lxw_worksheet *self)
 {
     struct xml_attribute_list attributes;
     struct xml_attribute *attribute;
-    char formula[LXW_ATTR_32];
-    uint8_t type = cond_format->type;
 
-    LXW_INIT_ATTRIBUTES();
-
-    LXW_PUSH_ATTRIBUTES_STR("type", cond_format->type_string);
+    if (!self->outline_changed)
+        return;
 
-    if (cond_format->dxf_index != LXW_PROPERTY_UNSET)
-        LXW_PUSH_ATTRIBUTES_INT("dxfId", cond_format->dxf_index);
+    LXW_INIT_ATTRIBUTES();
 
-    LXW_PUSH_ATTRIBUTES_INT("priority", cond_format->dxf_priority);
+    if (self->outline_style)
+        LXW_PUSH_ATTRIBUTES_STR("applyStyles", "1");
 
-    if (cond_format->stop_if_true)
-        LXW_PUSH_ATTRIBUTES_INT("stopIfTrue", 1);
+    if (!self->outline_below)
+        LXW_PUSH_ATTRIBUTES_STR("summaryBelow", "0");
 
-    lxw_xml_start_tag(self->file, "cfRule", &attributes);
+    if (!self->outline_right)
+        LXW_PUSH_ATTRIBUTES_STR("summaryRight", "0");
 
-    if (type == LXW_CONDITIONAL_TYPE_BLANKS) {
-        lxw_snprintf(formula, LXW_ATTR_32, "LEN(TRIM(%s))=0",
-                     cond_format->first_cell);
-        _worksheet_write_formula_str(self, formula);
-    }
-    else if (type == LXW_CONDITIONAL_TYPE_NO_BLANKS) {
-        lxw_snprintf(formula, LXW_ATTR_32, "LEN(TRIM(%s))>0",
-                     cond_format->first_cell);
-        _worksheet_write_formula_str(self, formula);
-    }
-    else if (type == LXW_CONDITIONAL_TYPE_ERRORS) {
-        lxw_snprintf(formula, LXW_ATTR_32, "ISERROR(%s)",
-                     cond_format->first_cell);
-        _worksheet_write_formula_str(self, formula);
-    }
-    else if (type == LXW_CONDITIONAL_TYPE_NO_ERRORS) {
-        lxw_snprintf(formula, LXW_ATTR_32, "NOT(ISERROR(%s))",
-                     cond_format->first_cell);
-        _worksheet_write_formula_str(self, formula);
-    }
+    if (!self->outline_on)
+        LXW_PUSH_ATTRIBUTES_STR("showOutlineSymbols", "0");
 
-    lxw_xml_end_tag(self->file, "cfRule");
+    lxw_xml_empty_tag(self->file, "outlinePr", &attributes);
 
     LXW_FREE_ATTRIBUTES();
 }
 
 /*
- * Write the <cfRule> element for text rules.
+ * Write the <sheetPr> element for Sheet level properties.
  */
 STATIC void
-_worksheet_write_cf_rule_text(lxw_worksheet *self,
-                              lxw_cond_format_obj *cond_format)
+_worksheet_write_sheet_pr(lxw_worksheet *self)
 {
     struct xml_attribute_list attributes;
     struct xml_attribute *attribute;
-    uint8_t pos;
-    char formula[LXW_ATTR_32 * 2];
-    char *operators[] = {
-        "containsText",
-        "notContains",
-        "beginsWith",
-        "endsWith",
-    };
-    uint8_t criteria = cond_format->criteria;
 
-    LXW_INIT_ATTRIBUTES();
-
-    if (criteria == LXW_CONDITIONAL_CRITERIA_TEXT_CONTAINING)
-        LXW_PUSH_ATTRIBUTES_STR("type", "containsText");
-    else if (criteria == LXW_CONDITIONAL_CRITERIA_TEXT_NOT_CONTAINING)
-        LXW_PUSH_ATTRIBUTES_STR("type", "notContainsText");
-    else if (criteria == LXW_CONDITIONAL_CRITERIA_TEXT_BEGINS_WITH)
-        LXW_PUSH_ATTRIBUTES_STR("type", "beginsWith");
-    else if (criteria == LXW_CONDITIONAL_CRITERIA_TEXT_ENDS_WITH)
-        LXW_PUSH_ATTRIBUTES_STR("type", "endsWith");
+    if (!self->fit_page
+        && !self->filter_on
+        && self->tab_color == LXW_COLOR_UNSET
+        && !self->outline_changed
+        && !self->vba_codename && !self->is_chartsheet) {
+        return;
+    }
 
-    if (cond_format->dxf_index != LXW_PROPERTY_UNSET)
-        LXW_PUSH_ATTRIBUTES_INT("dxfId", cond_format->dxf_index);
+    LXW_INIT_ATTRIBUTES();
 
-    LXW_PUSH_ATTRIBUTES_INT("priority", cond_format->dxf_priority);
+    if (self->vba_codename)
+        LXW_PUSH_ATTRIBUTES_STR("codeName", self->vba_codename);
 
-    if (cond_format->stop_if_true)
-        LXW_PUSH_ATTRIBUTES_INT("stopIfTrue", 1);
+    if (self->filter_on)
+        LXW_PUSH_ATTRIBUTES_STR("filterMode", "1");
 
-    pos = criteria - LXW_CONDITIONAL_CRITERIA_TEXT_CONTAINING;
-    LXW_PUSH_ATTRIBUTES_STR("operator", operators[pos]);
+    if (self->fit_page || self->tab_color != LXW_COLOR_UNSET
+        || self->outline_changed) {
+        lxw_xml_start_tag(self->file, "sheetPr", &attributes);
+        _worksheet_write_tab_color(self);
+        _worksheet_write_outline_pr(self);
+        _worksheet_write_page_set_up_pr(self);
+        lxw_xml_end_tag(self->file, "sheetPr");
+    }
+    else {
+        lxw_xml_empty_tag(self->file, "sheetPr", &attributes);
+    }
 
-    LXW_PUSH_ATTRIBUTES_STR("text", cond_format->min_value_string);
+    LXW_FREE_ATTRIBUTES();
 
-    lxw_xml_start_tag(self->file, "cfRule", &attributes);
+}
 
-    if (criteria == LXW_CONDITIONAL_CRITERIA_TEXT_CONTAINING) {
-        lxw_snprintf(formula, LXW_ATTR_32 * 2,
-                     "NOT(ISERROR(SEARCH(\"%s\",%s)))",
-                     cond_format->min_value_string, cond_format->first_cell);
-        _worksheet_write_formula_str(self, formula);
-    }
-    else if (criteria == LXW_CONDITIONAL_CRITERIA_TEXT_NOT_CONTAINING) {
-        lxw_snprintf(formula, LXW_ATTR_32 * 2,
-                     "ISERROR(SEARCH(\"%s\",%s))",
-                     cond_format->min_value_string, cond_format->first_cell);
-        _worksheet_write_formula_str(self, formula);
-    }
-    else if (criteria == LXW_CONDITIONAL_CRITERIA_TEXT_BEGINS_WITH) {
-        lxw_snprintf(formula, LXW_ATTR_32 * 2,
-                     "LEFT(%s,%d)=\"%s\"",
-                     cond_format->first_cell,
-                     (uint16_t) strlen(cond_format->min_value_string),
-                     cond_format->min_value_string);
-        _worksheet_write_formula_str(self, formula);
-    }
-    else if (criteria == LXW_CONDITIONAL_CRITERIA_TEXT_ENDS_WITH) {
-        lxw_snprintf(formula, LXW_ATTR_32 * 2,
-                     "RIGHT(%s,%d)=\"%s\"",
-                     cond_format->first_cell,
-                     (uint16_t) strlen(cond_format->min_value_string),
-                     cond_format->min_value_string);
-        _worksheet_write_formula_str(self, formula);
-    }
+/*
+ * Write the <brk> element.
+ */
+STATIC void
+_worksheet_write_brk(lxw_worksheet *self, uint32_t id, uint32_t max)
+{
+    struct xml_attribute_list attributes;
+    struct xml_attribute *attribute;
 
-    lxw_xml_end_tag(self->file, "cfRule");
+    LXW_INIT_ATTRIBUTES();
+    LXW_PUSH_ATTRIBUTES_INT("id", id);
+    LXW_PUSH_ATTRIBUTES_INT("max", max);
+    LXW_PUSH_ATTRIBUTES_STR("man", "1");
+
+    lxw_xml_empty_tag(self->file, "brk", &attributes);
 
     LXW_FREE_ATTRIBUTES();
 }
 
 /*
- * Write the <cfRule> element for cell rules.
+ * Write the <rowBreaks> element.
  */
 STATIC void
-_worksheet_write_cf_rule_cell(lxw_worksheet *self,
-                              lxw_cond_format_obj *cond_format)
+_worksheet_write_row_breaks(lxw_worksheet *self)
 {
     struct xml_attribute_list attributes;
     struct xml_attribute *attribute;
-    char *operators[] = {
-        "none",
-        "equal",
-        "notEqual",
-        "greaterThan",
-        "lessThan",
-        "greaterThanOrEqual",
-        "lessThanOrEqual",
-        "between",
-        "notBetween",
-    };
+    uint16_t count = self->hbreaks_count;
+    uint16_t i;
+
+    if (!count)
+        return;
 
     LXW_INIT_ATTRIBUTES();
+    LXW_PUSH_ATTRIBUTES_INT("count", count);
+    LXW_PUSH_ATTRIBUTES_INT("manualBreakCount", count);
 
-    LXW_PUSH_ATTRIBUTES_STR("type", cond_format->type_string);
+    lxw_xml_start_tag(self->file, "rowBreaks", &attributes);
 
-    if (cond_format->dxf_index != LXW_PROPERTY_UNSET)
-        LXW_PUSH_ATTRIBUTES_INT("dxfId", cond_format->dxf_index);
+    for (i = 0; i < count; i++)
+        _worksheet_write_brk(self, self->hbreaks[i], LXW_COL_MAX - 1);
 
-    LXW_PUSH_ATTRIBUTES_INT("priority", cond_format->dxf_priority);
+    lxw_xml_end_tag(self->file, "rowBreaks");
 
-    if (cond_format->stop_if_true)
-        LXW_PUSH_ATTRIBUTES_INT("stopIfTrue", 1);
+    LXW_FREE_ATTRIBUTES();
+}
 
-    LXW_PUSH_ATTRIBUTES_STR("operator", operators[cond_format->criteria]);
+/*
+ * Write the <colBreaks> element.
+ */
+STATIC void
+_worksheet_write_col_breaks(lxw_worksheet *self)
+{
+    struct xml_attribute_list attributes;
+    struct xml_attribute *attribute;
+    uint16_t count = self->vbreaks_count;
+    uint16_t i;
 
-    lxw_xml_start_tag(self->file, "cfRule", &attributes);
+    if (!count)
+        return;
 
-    if (cond_format->min_value_string)
-        _worksheet_write_formula_str(self, cond_format->min_value_string);
-    else
-        _worksheet_write_formula_num(self, cond_format->min_value);
+    LXW_INIT_ATTRIBUTES();
+    LXW_PUSH_ATTRIBUTES_INT("count", count);
+    LXW_PUSH_ATTRIBUTES_INT("manualBreakCount", count);
 
-    if (cond_format->has_max) {
-        if (cond_format->max_value_string)
-            _worksheet_write_formula_str(self, cond_format->max_value_string);
-        else
-            _worksheet_write_formula_num(self, cond_format->max_value);
-    }
+    lxw_xml_start_tag(self->file, "colBreaks", &attributes);
 
-    lxw_xml_end_tag(self->file, "cfRule");
+    for (i = 0; i < count; i++)
+        _worksheet_write_brk(self, self->vbreaks[i], LXW_ROW_MAX - 1);
+
+    lxw_xml_end_tag(self->file, "colBreaks");
 
     LXW_FREE_ATTRIBUTES();
 }
 
 /*
- * Write the <cfRule> element.
+ * Write the <filter> element.
  */
 STATIC void
-_worksheet_write_cf_rule(lxw_worksheet *self,
-                         lxw_cond_format_obj *cond_format)
+_worksheet_write_filter(lxw_worksheet *self, const char *str, double num,
+                        uint8_t criteria)
 {
-    if (cond_format->type == LXW_CONDITIONAL_TYPE_CELL) {
+    struct xml_attribute_list attributes;
+    struct xml_attribute *attribute;
 
-        _worksheet_write_cf_rule_cell(self, cond_format);
-    }
-    else if (cond_format->type == LXW_CONDITIONAL_TYPE_TEXT) {
+    if (criteria == LXW_FILTER_CRITERIA_BLANKS)
+        return;
 
-        _worksheet_write_cf_rule_text(self, cond_format);
-    }
-    else if (cond_format->type == LXW_CONDITIONAL_TYPE_TIME_PERIOD) {
+    LXW_INIT_ATTRIBUTES();
 
-        _worksheet_write_cf_rule_time_period(self, cond_format);
-    }
-    else if (cond_format->type == LXW_CONDITIONAL_TYPE_DUPLICATE
-             || cond_format->type == LXW_CONDITIONAL_TYPE_UNIQUE) {
+    if (str)
+        LXW_PUSH_ATTRIBUTES_STR("val", str);
+    else
+        LXW_PUSH_ATTRIBUTES_DBL("val", num);
 
-        _worksheet_write_cf_rule_duplicate(self, cond_format);
-    }
-    else if (cond_format->type == LXW_CONDITIONAL_TYPE_AVERAGE) {
+    lxw_xml_empty_tag(self->file, "filter", &attributes);
 
-        _worksheet_write_cf_rule_average(self, cond_format);
-    }
-    else if (cond_format->type == LXW_CONDITIONAL_TYPE_TOP
-             || cond_format->type == LXW_CONDITIONAL_TYPE_BOTTOM) {
+    LXW_FREE_ATTRIBUTES();
+}
 
-        _worksheet_write_cf_rule_top(self, cond_format);
-    }
-    else if (cond_format->type == LXW_CONDITIONAL_TYPE_BLANKS
-             || cond_format->type == LXW_CONDITIONAL_TYPE_NO_BLANKS
-             || cond_format->type == LXW_CONDITIONAL_TYPE_ERRORS
-             || cond_format->type == LXW_CONDITIONAL_TYPE_NO_ERRORS) {
+/*
+ * Write the <filterColumn> element as simple equality.
+ */
+STATIC void
+_worksheet_write_filter_standard(lxw_worksheet *self,
+                                 lxw_filter_rule_obj *filter)
+{
+    struct xml_attribute_list attributes;
+    struct xml_attribute *attribute;
 
-        _worksheet_write_cf_rule_blanks(self, cond_format);
-    }
-    else if (cond_format->type == LXW_CONDITIONAL_TYPE_FORMULA) {
+    LXW_INIT_ATTRIBUTES();
 
-        _worksheet_write_cf_rule_formula(self, cond_format);
+    if (filter->has_blanks) {
+        LXW_PUSH_ATTRIBUTES_STR("blank", "1");
     }
-    else if (cond_format->type == LXW_CONDITIONAL_2_COLOR_SCALE
-             || cond_format->type == LXW_CONDITIONAL_3_COLOR_SCALE) {
 
-        _worksheet_write_cf_rule_color_scale(self, cond_format);
-    }
-    else if (cond_format->type == LXW_CONDITIONAL_DATA_BAR) {
+    if (filter->type == LXW_FILTER_TYPE_SINGLE && filter->has_blanks) {
+        lxw_xml_empty_tag(self->file, "filters", &attributes);
 
-        _worksheet_write_cf_rule_data_bar(self, cond_format);
     }
-    else if (cond_format->type == LXW_CONDITIONAL_TYPE_ICON_SETS) {
+    else {
+        lxw_xml_start_tag(self->file, "filters", &attributes);
 
-        _worksheet_write_cf_rule_icons(self, cond_format);
+        /* Write the filter element. */
+        if (filter->type == LXW_FILTER_TYPE_SINGLE) {
+            _worksheet_write_filter(self, filter->value1_string,
+                                    filter->value1, filter->criteria1);
+        }
+        else if (filter->type == LXW_FILTER_TYPE_AND
+                 || filter->type == LXW_FILTER_TYPE_OR) {
+            _worksheet_write_filter(self, filter->value1_string,
+                                    filter->value1, filter->criteria1);
+            _worksheet_write_filter(self, filter->value2_string,
+                                    filter->value2, filter->criteria2);
+        }
+
+        lxw_xml_end_tag(self->file, "filters");
     }
 
+    LXW_FREE_ATTRIBUTES();
 }
 
 /*
- * Write the <conditionalFormatting> element.
+ * Write the <customFilter> element.
  */
 STATIC void
-_worksheet_write_conditional_formatting(lxw_worksheet *self,
-                                        lxw_cond_format_hash_element *element)
+_worksheet_write_custom_filter(lxw_worksheet *self, const char *str,
+                               double num, uint8_t criteria)
 {
     struct xml_attribute_list attributes;
     struct xml_attribute *attribute;
-    lxw_cond_format_obj *cond_format;
 
     LXW_INIT_ATTRIBUTES();
-    LXW_PUSH_ATTRIBUTES_STR("sqref", element->sqref);
 
-    lxw_xml_start_tag(self->file, "conditionalFormatting", &attributes);
+    if (criteria == LXW_FILTER_CRITERIA_NOT_EQUAL_TO)
+        LXW_PUSH_ATTRIBUTES_STR("operator", "notEqual");
+    if (criteria == LXW_FILTER_CRITERIA_GREATER_THAN)
+        LXW_PUSH_ATTRIBUTES_STR("operator", "greaterThan");
+    else if (criteria == LXW_FILTER_CRITERIA_GREATER_THAN_OR_EQUAL_TO)
+        LXW_PUSH_ATTRIBUTES_STR("operator", "greaterThanOrEqual");
+    else if (criteria == LXW_FILTER_CRITERIA_LESS_THAN)
+        LXW_PUSH_ATTRIBUTES_STR("operator", "lessThan");
+    else if (criteria == LXW_FILTER_CRITERIA_LESS_THAN_OR_EQUAL_TO)
+        LXW_PUSH_ATTRIBUTES_STR("operator", "lessThanOrEqual");
 
-    STAILQ_FOREACH(cond_format, element->cond_formats, list_pointers) {
-        /* Write the cfRule element. */
-        _worksheet_write_cf_rule(self, cond_format);
-    }
+    if (str)
+        LXW_PUSH_ATTRIBUTES_STR("val", str);
+    else
+        LXW_PUSH_ATTRIBUTES_DBL("val", num);
 
-    lxw_xml_end_tag(self->file, "conditionalFormatting");
+    lxw_xml_empty_tag(self->file, "customFilter", &attributes);
 
     LXW_FREE_ATTRIBUTES();
 }
 
 /*
- * Write the conditional formatting> elements.
+ * Write the <filterColumn> element as a list.
  */
 STATIC void
-_worksheet_write_conditional_formats(lxw_worksheet *self)
+_worksheet_write_filter_list(lxw_worksheet *self, lxw_filter_rule_obj *filter)
 {
-    lxw_cond_format_hash_element *element;
-    lxw_cond_format_hash_element *next_element;
+    struct xml_attribute_list attributes;
+    struct xml_attribute *attribute;
+    uint16_t i;
 
-    for (element = RB_MIN(lxw_cond_format_hash, self->conditional_formats);
-         element; element = next_element) {
+    LXW_INIT_ATTRIBUTES();
 
-        _worksheet_write_conditional_formatting(self, element);
+    if (filter->has_blanks) {
+        LXW_PUSH_ATTRIBUTES_STR("blank", "1");
+    }
 
-        next_element =
-            RB_NEXT(lxw_cond_format_hash, self->conditional_formats, element);
+    lxw_xml_start_tag(self->file, "filters", &attributes);
+
+    for (i = 0; i < filter->num_list_filters; i++) {
+        _worksheet_write_filter(self, filter->list[i], 0, 0);
     }
+
+    lxw_xml_end_tag(self->file, "filters");
+
+    LXW_FREE_ATTRIBUTES();
 }
 
 /*
- * Write the <x14:xxxColor> elements for data bar conditional formats.
+ * Write the <filterColumn> element.
  */
 STATIC void
-_worksheet_write_x14_color(lxw_worksheet *self, char *type, lxw_color_t color)
+_worksheet_write_filter_custom(lxw_worksheet *self,
+                               lxw_filter_rule_obj *filter)
 {
     struct xml_attribute_list attributes;
     struct xml_attribute *attribute;
-    char rgb[LXW_ATTR_32];
-
-    lxw_snprintf(rgb, LXW_ATTR_32, "FF%06X", color & LXW_COLOR_MASK);
 
     LXW_INIT_ATTRIBUTES();
-    LXW_PUSH_ATTRIBUTES_STR("rgb", rgb);
-    lxw_xml_empty_tag(self->file, type, &attributes);
+
+    if (filter->type == LXW_FILTER_TYPE_AND)
+        LXW_PUSH_ATTRIBUTES_STR("and", "1");
+
+    lxw_xml_start_tag(self->file, "customFilters", &attributes);
+
+    /* Write the filter element. */
+    if (filter->type == LXW_FILTER_TYPE_SINGLE) {
+        _worksheet_write_custom_filter(self, filter->value1_string,
+                                       filter->value1, filter->criteria1);
+    }
+    else if (filter->type == LXW_FILTER_TYPE_AND
+             || filter->type == LXW_FILTER_TYPE_OR) {
+        _worksheet_write_custom_filter(self, filter->value1_string,
+                                       filter->value1, filter->criteria1);
+        _worksheet_write_custom_filter(self, filter->value2_string,
+                                       filter->value2, filter->criteria2);
+    }
+
+    lxw_xml_end_tag(self->file, "customFilters");
 
     LXW_FREE_ATTRIBUTES();
 }
 
 /*
- * Write the <x14:cfvo> element.
+ * Write the <filterColumn> element.
  */
 STATIC void
-_worksheet_write_x14_cfvo(lxw_worksheet *self, uint8_t rule_type,
-                          double number, char *string)
+_worksheet_write_filter_column(lxw_worksheet *self,
+                               lxw_filter_rule_obj *filter)
 {
     struct xml_attribute_list attributes;
     struct xml_attribute *attribute;
-    char data[LXW_ATTR_32];
-    uint8_t has_value = LXW_FALSE;
 
-    LXW_INIT_ATTRIBUTES();
+    if (!filter)
+        return;
 
-    if (!string)
-        lxw_sprintf_dbl(data, number);
+    LXW_INIT_ATTRIBUTES();
+    LXW_PUSH_ATTRIBUTES_INT("colId", filter->col_num);
 
-    if (rule_type == LXW_CONDITIONAL_RULE_TYPE_AUTO_MIN) {
-        LXW_PUSH_ATTRIBUTES_STR("type", "autoMin");
-        has_value = LXW_FALSE;
-    }
-    else if (rule_type == LXW_CONDITIONAL_RULE_TYPE_MINIMUM) {
-        LXW_PUSH_ATTRIBUTES_STR("type", "min");
-        has_value = LXW_FALSE;
-    }
-    else if (rule_type == LXW_CONDITIONAL_RULE_TYPE_NUMBER) {
-        LXW_PUSH_ATTRIBUTES_STR("type", "num");
-        has_value = LXW_TRUE;
-    }
-    else if (rule_type == LXW_CONDITIONAL_RULE_TYPE_PERCENT) {
-        LXW_PUSH_ATTRIBUTES_STR("type", "percent");
-        has_value = LXW_TRUE;
-    }
-    else if (rule_type == LXW_CONDITIONAL_RULE_TYPE_PERCENTILE) {
-        LXW_PUSH_ATTRIBUTES_STR("type", "percentile");
-        has_value = LXW_TRUE;
-    }
-    else if (rule_type == LXW_CONDITIONAL_RULE_TYPE_FORMULA) {
-        LXW_PUSH_ATTRIBUTES_STR("type", "formula");
-        has_value = LXW_TRUE;
-    }
-    else if (rule_type == LXW_CONDITIONAL_RULE_TYPE_MAXIMUM) {
-        LXW_PUSH_ATTRIBUTES_STR("type", "max");
-        has_value = LXW_FALSE;
-    }
-    else if (rule_type == LXW_CONDITIONAL_RULE_TYPE_AUTO_MAX) {
-        LXW_PUSH_ATTRIBUTES_STR("type", "autoMax");
-        has_value = LXW_FALSE;
-    }
+    lxw_xml_start_tag(self->file, "filterColumn", &attributes);
 
-    if (has_value) {
-        lxw_xml_start_tag(self->file, "x14:cfvo", &attributes);
+    if (filter->list)
+        _worksheet_write_filter_list(self, filter);
+    else if (filter->is_custom)
+        _worksheet_write_filter_custom(self, filter);
+    else
+        _worksheet_write_filter_standard(self, filter);
 
-        if (string)
-            lxw_xml_data_element(self->file, "xm:f", string, NULL);
-        else
-            lxw_xml_data_element(self->file, "xm:f", data, NULL);
+    lxw_xml_end_tag(self->file, "filterColumn");
 
-        lxw_xml_end_tag(self->file, "x14:cfvo");
-    }
-    else {
-        lxw_xml_empty_tag(self->file, "x14:cfvo", &attributes);
-    }
     LXW_FREE_ATTRIBUTES();
 }
 
 /*
- * Write the <x14:dataBar> element.
+ * Write the <autoFilter> element.
  */
 STATIC void
-_worksheet_write_x14_data_bar(lxw_worksheet *self,
-                              lxw_cond_format_obj *cond_format)
+_worksheet_write_auto_filter(lxw_worksheet *self)
 {
     struct xml_attribute_list attributes;
     struct xml_attribute *attribute;
-    char min_length[] = "0";
-    char max_length[] = "100";
-    char border[] = "1";
-
-    LXW_INIT_ATTRIBUTES();
-    LXW_PUSH_ATTRIBUTES_STR("minLength", min_length);
-    LXW_PUSH_ATTRIBUTES_STR("maxLength", max_length);
-
-    if (!cond_format->bar_no_border)
-        LXW_PUSH_ATTRIBUTES_STR("border", border);
-
-    if (cond_format->bar_solid)
-        LXW_PUSH_ATTRIBUTES_STR("gradient", "0");
-
-    if (cond_format->bar_direction ==
-        LXW_CONDITIONAL_BAR_DIRECTION_RIGHT_TO_LEFT)
-        LXW_PUSH_ATTRIBUTES_STR("direction", "rightToLeft");
-
-    if (cond_format->bar_direction ==
-        LXW_CONDITIONAL_BAR_DIRECTION_LEFT_TO_RIGHT)
-        LXW_PUSH_ATTRIBUTES_STR("direction", "leftToRight");
-
-    if (cond_format->bar_negative_color_same)
-        LXW_PUSH_ATTRIBUTES_STR("negativeBarColorSameAsPositive", "1");
-
-    if (!cond_format->bar_no_border
-        && !cond_format->bar_negative_border_color_same)
-        LXW_PUSH_ATTRIBUTES_STR("negativeBarBorderColorSameAsPositive", "0");
-
-    if (cond_format->bar_axis_position == LXW_CONDITIONAL_BAR_AXIS_MIDPOINT)
-        LXW_PUSH_ATTRIBUTES_STR("axisPosition", "middle");
-
-    if (cond_format->bar_axis_position == LXW_CONDITIONAL_BAR_AXIS_NONE)
-        LXW_PUSH_ATTRIBUTES_STR("axisPosition", "none");
-
-    lxw_xml_start_tag(self->file, "x14:dataBar", &attributes);
-
-    if (cond_format->auto_min)
-        cond_format->min_rule_type = LXW_CONDITIONAL_RULE_TYPE_AUTO_MIN;
+    char range[LXW_MAX_CELL_RANGE_LENGTH];
+    uint16_t i;
 
-    _worksheet_write_x14_cfvo(self, cond_format->min_rule_type,
-                              cond_format->min_value,
-                              cond_format->min_value_string);
+    if (!self->autofilter.in_use)
+        return;
 
-    if (cond_format->auto_max)
-        cond_format->max_rule_type = LXW_CONDITIONAL_RULE_TYPE_AUTO_MAX;
+    lxw_rowcol_to_range(range,
+                        self->autofilter.first_row,
+                        self->autofilter.first_col,
+                        self->autofilter.last_row, self->autofilter.last_col);
 
-    _worksheet_write_x14_cfvo(self, cond_format->max_rule_type,
-                              cond_format->max_value,
-                              cond_format->max_value_string);
+    LXW_INIT_ATTRIBUTES();
+    LXW_PUSH_ATTRIBUTES_STR("ref", range);
 
-    if (!cond_format->bar_no_border)
-        _worksheet_write_x14_color(self, "x14:borderColor",
-                                   cond_format->bar_border_color);
+    if (self->autofilter.has_rules) {
+        lxw_xml_start_tag(self->file, "autoFilter", &attributes);
 
-    if (!cond_format->bar_negative_color_same)
-        _worksheet_write_x14_color(self, "x14:negativeFillColor",
-                                   cond_format->bar_negative_color);
+        for (i = 0; i < self->num_filter_rules; i++)
+            _worksheet_write_filter_column(self, self->filter_rules[i]);
 
-    if (!cond_format->bar_no_border
-        && !cond_format->bar_negative_border_color_same)
-        _worksheet_write_x14_color(self, "x14:negativeBorderColor",
-                                   cond_format->bar_negative_border_color);
+        lxw_xml_end_tag(self->file, "autoFilter");
 
-    if (cond_format->bar_axis_position != LXW_CONDITIONAL_BAR_AXIS_NONE)
-        _worksheet_write_x14_color(self, "x14:axisColor",
-                                   cond_format->bar_axis_color);
+    }
+    else {
+        lxw_xml_empty_tag(self->file, "autoFilter", &attributes);
+    }
 
     LXW_FREE_ATTRIBUTES();
 }
 
 /*
- * Write the <x14:cfRule> element.
+ * Write the <hyperlink> element for external links.
  */
 STATIC void
-_worksheet_write_x14_cf_rule(lxw_worksheet *self,
-                             lxw_cond_format_obj *cond_format)
+_worksheet_write_hyperlink_external(lxw_worksheet *self, lxw_row_t row_num,
+                                    lxw_col_t col_num, const char *location,
+                                    const char *tooltip, uint16_t id)
 {
     struct xml_attribute_list attributes;
     struct xml_attribute *attribute;
+    char ref[LXW_MAX_CELL_NAME_LENGTH];
+    char r_id[LXW_MAX_ATTRIBUTE_LENGTH];
+
+    lxw_rowcol_to_cell(ref, row_num, col_num);
+
+    lxw_snprintf(r_id, LXW_ATTR_32, "rId%d", id);
 
     LXW_INIT_ATTRIBUTES();
-    LXW_PUSH_ATTRIBUTES_STR("type", "dataBar");
-    LXW_PUSH_ATTRIBUTES_STR("id", cond_format->guid);
+    LXW_PUSH_ATTRIBUTES_STR("ref", ref);
+    LXW_PUSH_ATTRIBUTES_STR("r:id", r_id);
 
-    lxw_xml_start_tag(self->file, "x14:cfRule", &attributes);
+    if (location)
+        LXW_PUSH_ATTRIBUTES_STR("location", location);
 
-    /* Write the x14:dataBar element. */
-    _worksheet_write_x14_data_bar(self, cond_format);
+    if (tooltip)
+        LXW_PUSH_ATTRIBUTES_STR("tooltip", tooltip);
 
-    LXW_FREE_ATTRIBUTES();
-}
+    lxw_xml_empty_tag(self->file, "hyperlink", &attributes);
 
-/*
- * Write the <xm:sqref> element.
- */
-STATIC void
-_worksheet_write_xm_sqref(lxw_worksheet *self,
-                          lxw_cond_format_obj *cond_format)
-{
-    lxw_xml_data_element(self->file, "xm:sqref", cond_format->sqref, NULL);
+    LXW_FREE_ATTRIBUTES();
 }
 
 /*
- * Write the <conditionalFormatting> element.
+ * Write the <hyperlink> element for internal links.
  */
 STATIC void
-_worksheet_write_conditional_formatting_2010(lxw_worksheet *self, lxw_cond_format_hash_element
-                                             *element)
+_worksheet_write_hyperlink_internal(lxw_worksheet *self, lxw_row_t row_num,
+                                    lxw_col_t col_num, const char *location,
+                                    const char *display, const char *tooltip)
 {
     struct xml_attribute_list attributes;
     struct xml_attribute *attribute;
-    lxw_cond_format_obj *cond_format;
+    char ref[LXW_MAX_CELL_NAME_LENGTH];
+
+    lxw_rowcol_to_cell(ref, row_num, col_num);
 
     LXW_INIT_ATTRIBUTES();
-    LXW_PUSH_ATTRIBUTES_STR("xmlns:xm",
-                            "http://schemas.microsoft.com/office/excel/2006/main");
+    LXW_PUSH_ATTRIBUTES_STR("ref", ref);
 
-    STAILQ_FOREACH(cond_format, element->cond_formats, list_pointers) {
-        if (!cond_format->data_bar_2010)
-            continue;
+    if (location)
+        LXW_PUSH_ATTRIBUTES_STR("location", location);
 
-        lxw_xml_start_tag(self->file, "x14:conditionalFormatting",
-                          &attributes);
+    if (tooltip)
+        LXW_PUSH_ATTRIBUTES_STR("tooltip", tooltip);
 
-        _worksheet_write_x14_cf_rule(self, cond_format);
+    if (display)
+        LXW_PUSH_ATTRIBUTES_STR("display", display);
 
-        lxw_xml_end_tag(self->file, "x14:dataBar");
-        lxw_xml_end_tag(self->file, "x14:cfRule");
-        _worksheet_write_xm_sqref(self, cond_format);
-        lxw_xml_end_tag(self->file, "x14:conditionalFormatting");
-    }
+    lxw_xml_empty_tag(self->file, "hyperlink", &attributes);
 
     LXW_FREE_ATTRIBUTES();
 }
 
 /*
- * Write the <extLst> element for Excel 2010 conditional formatting data bars.
+ * Process any stored hyperlinks in row/col order and write the <hyperlinks>
+ * element. The attributes are different for internal and external links.
  */
 STATIC void
-_worksheet_write_ext_list_data_bars(lxw_worksheet *self)
+_worksheet_write_hyperlinks(lxw_worksheet *self)
 {
-    lxw_cond_format_hash_element *element;
-    lxw_cond_format_hash_element *next_element;
 
-    _worksheet_write_ext(self, "{78C0D931-6437-407d-A8EE-F0AAD7539E65}");
-    lxw_xml_start_tag(self->file, "x14:conditionalFormattings", NULL);
+    lxw_row *row;
+    lxw_cell *link;
+    lxw_rel_tuple *relationship;
 
-    for (element = RB_MIN(lxw_cond_format_hash, self->conditional_formats);
-         element; element = next_element) {
+    if (RB_EMPTY(self->hyperlinks))
+        return;
 
-        _worksheet_write_conditional_formatting_2010(self, element);
+    /* Write the hyperlink elements. */
+    lxw_xml_start_tag(self->file, "hyperlinks", NULL);
+
+    RB_FOREACH(row, lxw_table_rows, self->hyperlinks) {
+
+        RB_FOREACH(link, lxw_table_cells, row->cells) {
+
+            if (link->type == HYPERLINK_URL
+                || link->type == HYPERLINK_EXTERNAL) {
+
+                self->rel_count++;
+
+                relationship = calloc(1, sizeof(lxw_rel_tuple));
+                GOTO_LABEL_ON_MEM_ERROR(relationship, mem_error);
+
+                relationship->type = lxw_strdup("/hyperlink");
+                GOTO_LABEL_ON_MEM_ERROR(relationship->type, mem_error);
+
+                relationship->target = lxw_strdup(link->sst_string);
+                GOTO_LABEL_ON_MEM_ERROR(relationship->target, mem_error);
+
+                relationship->target_mode = lxw_strdup("External");
+                GOTO_LABEL_ON_MEM_ERROR(relationship->target_mode, mem_error);
+
+                STAILQ_INSERT_TAIL(self->external_hyperlinks, relationship,
+                                   list_pointers);
+
+                _worksheet_write_hyperlink_external(self, link->row_num,
+                                                    link->col_num,
+                                                    link->user_data1,
+                                                    link->user_data2,
+                                                    self->rel_count);
+            }
+
+            if (link->type == HYPERLINK_INTERNAL) {
+
+                _worksheet_write_hyperlink_internal(self, link->row_num,
+                                                    link->col_num,
+                                                    link->sst_string,
+                                                    link->user_data1,
+                                                    link->user_data2);
+            }
+
+        }
 
-        next_element =
-            RB_NEXT(lxw_cond_format_hash, self->conditional_formats, element);
     }
 
-    lxw_xml_end_tag(self->file, "x14:conditionalFormattings");
-    lxw_xml_end_tag(self->file, "ext");
+    lxw_xml_end_tag(self->file, "hyperlinks");
+    return;
+
+mem_error:
+    if (relationship) {
+        free(relationship->type);
+        free(relationship->target);
+        free(relationship->target_mode);
+        free(relationship);
+    }
+    lxw_xml_end_tag(self->file, "hyperlinks");
 }
 
 /*
- * Write the <extLst> element.
+ * Write the <sheetProtection> element.
  */
 STATIC void
-_worksheet_write_ext_list(lxw_worksheet *self)
+_worksheet_write_sheet_protection(lxw_worksheet *self,
+                                  lxw_protection_obj *protect)
 {
-    if (self->data_bar_2010_index == 0)
+    struct xml_attribute_list attributes;
+    struct xml_attribute *attribute;
+
+    if (!protect->is_configured)
         return;
 
-    lxw_xml_start_tag(self->file, "extLst", NULL);
+    LXW_INIT_ATTRIBUTES();
 
-    _worksheet_write_ext_list_data_bars(self);
+    if (*protect->hash)
+        LXW_PUSH_ATTRIBUTES_STR("password", protect->hash);
 
-    lxw_xml_end_tag(self->file, "extLst");
+    if (!protect->no_sheet)
+        LXW_PUSH_ATTRIBUTES_INT("sheet", 1);
+
+    if (!protect->no_content)
+        LXW_PUSH_ATTRIBUTES_INT("content", 1);
+
+    if (!protect->objects)
+        LXW_PUSH_ATTRIBUTES_INT("objects", 1);
+
+    if (!protect->scenarios)
+        LXW_PUSH_ATTRIBUTES_INT("scenarios", 1);
+
+    if (protect->format_cells)
+        LXW_PUSH_ATTRIBUTES_INT("formatCells", 0);
+
+    if (protect->format_columns)
+        LXW_PUSH_ATTRIBUTES_INT("formatColumns", 0);
+
+    if (protect->format_rows)
+        LXW_PUSH_ATTRIBUTES_INT("formatRows", 0);
+
+    if (protect->insert_columns)
+        LXW_PUSH_ATTRIBUTES_INT("insertColumns", 0);
+
+    if (protect->insert_rows)
+        LXW_PUSH_ATTRIBUTES_INT("insertRows", 0);
+
+    if (protect->insert_hyperlinks)
+        LXW_PUSH_ATTRIBUTES_INT("insertHyperlinks", 0);
+
+    if (protect->delete_columns)
+        LXW_PUSH_ATTRIBUTES_INT("deleteColumns", 0);
+
+    if (protect->delete_rows)
+        LXW_PUSH_ATTRIBUTES_INT("deleteRows", 0);
+
+    if (protect->no_select_locked_cells)
+        LXW_PUSH_ATTRIBUTES_INT("selectLockedCells", 1);
+
+    if (protect->sort)
+        LXW_PUSH_ATTRIBUTES_INT("sort", 0);
+
+    if (protect->autofilter)
+        LXW_PUSH_ATTRIBUTES_INT("autoFilter", 0);
+
+    if (protect->pivot_tables)
+        LXW_PUSH_ATTRIBUTES_INT("pivotTables", 0);
+
+    if (protect->no_select_unlocked_cells)
+        LXW_PUSH_ATTRIBUTES_INT("selectUnlockedCells", 1);
+
+    lxw_xml_empty_tag(self->file, "sheetProtection", &attributes);
+
+    LXW_FREE_ATTRIBUTES();
 }
 
 /*
- * Write the <ignoredError> element.
+ * Write the <legacyDrawing> element.
  */
 STATIC void
-_worksheet_write_ignored_error(lxw_worksheet *self, char *ignore_error,
-                               char *range)
+_worksheet_write_legacy_drawing(lxw_worksheet *self)
 {
     struct xml_attribute_list attributes;
     struct xml_attribute *attribute;
+    char r_id[LXW_MAX_ATTRIBUTE_LENGTH];
+
+    if (!self->has_vml)
+        return;
+    else
+        self->rel_count++;
 
+    lxw_snprintf(r_id, LXW_ATTR_32, "rId%d", self->rel_count);
     LXW_INIT_ATTRIBUTES();
-    LXW_PUSH_ATTRIBUTES_STR("sqref", range);
-    LXW_PUSH_ATTRIBUTES_STR(ignore_error, "1");
+    LXW_PUSH_ATTRIBUTES_STR("r:id", r_id);
 
-    lxw_xml_empty_tag(self->file, "ignoredError", &attributes);
+    lxw_xml_empty_tag(self->file, "legacyDrawing", &attributes);
 
     LXW_FREE_ATTRIBUTES();
+
 }
 
-lxw_error
-_validate_conditional_icons(lxw_conditional_format *user)
+/*
+ * Write the <legacyDrawingHF> element.
+ */
+STATIC void
+_worksheet_write_legacy_drawing_hf(lxw_worksheet *self)
 {
-    if (user->icon_style > LXW_CONDITIONAL_ICONS_5_QUARTERS) {
+    struct xml_attribute_list attributes;
+    struct xml_attribute *attribute;
+    char r_id[LXW_MAX_ATTRIBUTE_LENGTH];
 
-        LXW_WARN_FORMAT1("worksheet_conditional_format_cell()/_range(): "
-                         "For type = LXW_CONDITIONAL_TYPE_ICON_SETS, "
-                         "invalid icon_style (%d).", user->icon_style);
+    if (!self->has_header_vml)
+        return;
+    else
+        self->rel_count++;
+
+    lxw_snprintf(r_id, LXW_ATTR_32, "rId%d", self->rel_count);
+    LXW_INIT_ATTRIBUTES();
+    LXW_PUSH_ATTRIBUTES_STR("r:id", r_id);
+
+    lxw_xml_empty_tag(self->file, "legacyDrawingHF", &attributes);
+
+    LXW_FREE_ATTRIBUTES();
 
-        return LXW_ERROR_PARAMETER_VALIDATION;
-    }
-    else {
-        return LXW_NO_ERROR;
-    }
 }
 
-lxw_error
-_validate_conditional_data_bar(lxw_worksheet *self,
-                               lxw_cond_format_obj *cond_format,
-                               lxw_conditional_format *user_options)
+/*
+ * Write the <picture> element.
+ */
+STATIC void
+_worksheet_write_picture(lxw_worksheet *self)
 {
-    uint8_t min_rule_type = user_options->min_rule_type;
-    uint8_t max_rule_type = user_options->max_rule_type;
+    struct xml_attribute_list attributes;
+    struct xml_attribute *attribute;
+    char r_id[LXW_MAX_ATTRIBUTE_LENGTH];
 
-    if (user_options->data_bar_2010
-        || user_options->bar_solid
-        || user_options->bar_no_border
-        || user_options->bar_direction
-        || user_options->bar_axis_position
-        || user_options->bar_negative_color_same
-        || user_options->bar_negative_border_color_same
-        || user_options->bar_negative_color
-        || user_options->bar_border_color
-        || user_options->bar_negative_border_color
-        || user_options->bar_axis_color) {
+    if (!self->has_background_image)
+        return;
+    else
+        self->rel_count++;
 
-        cond_format->data_bar_2010 = LXW_TRUE;
-        self->excel_version = 2010;
-    }
+    lxw_snprintf(r_id, LXW_ATTR_32, "rId%d", self->rel_count);
+    LXW_INIT_ATTRIBUTES();
+    LXW_PUSH_ATTRIBUTES_STR("r:id", r_id);
 
-    if (min_rule_type > LXW_CONDITIONAL_RULE_TYPE_MINIMUM
-        && min_rule_type < LXW_CONDITIONAL_RULE_TYPE_MAXIMUM) {
-        cond_format->min_rule_type = min_rule_type;
-        cond_format->min_value = user_options->min_value;
-        cond_format->min_value_string =
-            lxw_strdup_formula(user_options->min_value_string);
-    }
-    else {
-        cond_format->min_rule_type = LXW_CONDITIONAL_RULE_TYPE_MINIMUM;
-        cond_format->min_value = 0;
-    }
+    lxw_xml_empty_tag(self->file, "picture", &attributes);
 
-    if (max_rule_type > LXW_CONDITIONAL_RULE_TYPE_MINIMUM
-        && max_rule_type < LXW_CONDITIONAL_RULE_TYPE_MAXIMUM) {
-        cond_format->max_rule_type = max_rule_type;
-        cond_format->max_value = user_options->max_value;
-        cond_format->max_value_string =
-            lxw_strdup_formula(user_options->max_value_string);
-    }
-    else {
-        cond_format->max_rule_type = LXW_CONDITIONAL_RULE_TYPE_MAXIMUM;
-        cond_format->max_value = 0;
-    }
+    LXW_FREE_ATTRIBUTES();
+}
 
-    if (cond_format->data_bar_2010) {
-        if (min_rule_type == LXW_CONDITIONAL_RULE_TYPE_NONE)
-            cond_format->auto_min = LXW_TRUE;
-        if (max_rule_type == LXW_CONDITIONAL_RULE_TYPE_NONE)
-            cond_format->auto_max = LXW_TRUE;
-    }
+/*
+ * Write the <drawing> element.
+ */
+STATIC void
+_worksheet_write_drawing(lxw_worksheet *self, uint16_t id)
+{
+    struct xml_attribute_list attributes;
+    struct xml_attribute *attribute;
+    char r_id[LXW_MAX_ATTRIBUTE_LENGTH];
 
-    cond_format->bar_only = user_options->bar_only;
-    cond_format->bar_solid = user_options->bar_solid;
-    cond_format->bar_no_border = user_options->bar_no_border;
-    cond_format->bar_direction = user_options->bar_direction;
-    cond_format->bar_axis_position = user_options->bar_axis_position;
-    cond_format->bar_negative_color_same =
-        user_options->bar_negative_color_same;
-    cond_format->bar_negative_border_color_same =
-        user_options->bar_negative_border_color_same;
-
-    if (user_options->bar_color != LXW_COLOR_UNSET)
-        cond_format->bar_color = user_options->bar_color;
-    else
-        cond_format->bar_color = 0x638EC6;
-
-    if (user_options->bar_negative_color != LXW_COLOR_UNSET)
-        cond_format->bar_negative_color = user_options->bar_negative_color;
-    else
-        cond_format->bar_negative_color = 0xFF0000;
-
-    if (user_options->bar_border_color != LXW_COLOR_UNSET)
-        cond_format->bar_border_color = user_options->bar_border_color;
-    else
-        cond_format->bar_border_color = cond_format->bar_color;
+    lxw_snprintf(r_id, LXW_ATTR_32, "rId%d", id);
+    LXW_INIT_ATTRIBUTES();
+    LXW_PUSH_ATTRIBUTES_STR("r:id", r_id);
 
-    if (user_options->bar_negative_border_color != LXW_COLOR_UNSET)
-        cond_format->bar_negative_border_color =
-            user_options->bar_negative_border_color;
-    else
-        cond_format->bar_negative_border_color = 0xFF0000;
+    lxw_xml_empty_tag(self->file, "drawing", &attributes);
 
-    if (user_options->bar_axis_color != LXW_COLOR_UNSET)
-        cond_format->bar_axis_color = user_options->bar_axis_color;
-    else
-        cond_format->bar_axis_color = 0x000000;
+    LXW_FREE_ATTRIBUTES();
 
-    return LXW_NO_ERROR;
 }
 
-lxw_error
-_validate_conditional_scale(lxw_cond_format_obj *cond_format,
-                            lxw_conditional_format *user_options)
+/*
+ * Write the <drawing> elements.
+ */
+STATIC void
+_worksheet_write_drawings(lxw_worksheet *self)
 {
-    uint8_t min_rule_type = user_options->min_rule_type;
-    uint8_t mid_rule_type = user_options->mid_rule_type;
-    uint8_t max_rule_type = user_options->max_rule_type;
-
-    if (min_rule_type > LXW_CONDITIONAL_RULE_TYPE_MINIMUM
-        && min_rule_type < LXW_CONDITIONAL_RULE_TYPE_MAXIMUM) {
-        cond_format->min_rule_type = min_rule_type;
-        cond_format->min_value = user_options->min_value;
-        cond_format->min_value_string =
-            lxw_strdup_formula(user_options->min_value_string);
-    }
-    else {
-        cond_format->min_rule_type = LXW_CONDITIONAL_RULE_TYPE_MINIMUM;
-        cond_format->min_value = 0;
-    }
-
-    if (max_rule_type > LXW_CONDITIONAL_RULE_TYPE_MINIMUM
-        && max_rule_type < LXW_CONDITIONAL_RULE_TYPE_MAXIMUM) {
-        cond_format->max_rule_type = max_rule_type;
-        cond_format->max_value = user_options->max_value;
-        cond_format->max_value_string =
-            lxw_strdup_formula(user_options->max_value_string);
-    }
-    else {
-        cond_format->max_rule_type = LXW_CONDITIONAL_RULE_TYPE_MAXIMUM;
-        cond_format->max_value = 0;
-    }
-
-    if (cond_format->type == LXW_CONDITIONAL_3_COLOR_SCALE) {
-        if (mid_rule_type > LXW_CONDITIONAL_RULE_TYPE_MINIMUM
-            && mid_rule_type < LXW_CONDITIONAL_RULE_TYPE_MAXIMUM) {
-            cond_format->mid_rule_type = mid_rule_type;
-            cond_format->mid_value = user_options->mid_value;
-            cond_format->mid_value_string =
-                lxw_strdup_formula(user_options->mid_value_string);
-        }
-        else {
-            cond_format->mid_rule_type = LXW_CONDITIONAL_RULE_TYPE_PERCENTILE;
-            cond_format->mid_value = 50;
-        }
-    }
-
-    if (user_options->min_color != LXW_COLOR_UNSET)
-        cond_format->min_color = user_options->min_color;
-    else
-        cond_format->min_color = 0xFF7128;
-
-    if (user_options->max_color != LXW_COLOR_UNSET)
-        cond_format->max_color = user_options->max_color;
-    else
-        cond_format->max_color = 0xFFEF9C;
-
-    if (cond_format->type == LXW_CONDITIONAL_3_COLOR_SCALE) {
-        if (user_options->min_color == LXW_COLOR_UNSET)
-            cond_format->min_color = 0xF8696B;
-
-        if (user_options->mid_color != LXW_COLOR_UNSET)
-            cond_format->mid_color = user_options->mid_color;
-        else
-            cond_format->mid_color = 0xFFEB84;
+    if (!self->drawing)
+        return;
 
-        if (user_options->max_color == LXW_COLOR_UNSET)
-            cond_format->max_color = 0x63BE7B;
-    }
+    self->rel_count++;
 
-    return LXW_NO_ERROR;
+    _worksheet_write_drawing(self, self->rel_count);
 }
 
-lxw_error
-_validate_conditional_top(lxw_cond_format_obj *cond_format,
-                          lxw_conditional_format *user_options)
+/*
+ * Write the <formula1> element for numbers.
+ */
+STATIC void
+_worksheet_write_formula1_num(lxw_worksheet *self, double number)
 {
-    /* Restrict the range of rank values to Excel's allowed range. */
-    if (user_options->criteria ==
-        LXW_CONDITIONAL_CRITERIA_TOP_OR_BOTTOM_PERCENT) {
-        if (user_options->value < 0.0 || user_options->value > 100.0) {
-
-            LXW_WARN_FORMAT1("worksheet_conditional_format_cell()/_range(): "
-                             "For type = LXW_CONDITIONAL_TYPE_TOP/BOTTOM, "
-                             "top/bottom percent (%g%%) must by in range 0-100",
-                             user_options->value);
-
-            return LXW_ERROR_PARAMETER_VALIDATION;
-        }
-    }
-    else {
-        if (user_options->value < 1.0 || user_options->value > 1000.0) {
-
-            LXW_WARN_FORMAT1("worksheet_conditional_format_cell()/_range(): "
-                             "For type = LXW_CONDITIONAL_TYPE_TOP/BOTTOM, "
-                             "top/bottom items (%g) must by in range 1-1000",
-                             user_options->value);
-
-            return LXW_ERROR_PARAMETER_VALIDATION;
-        }
-    }
+    char data[LXW_ATTR_32];
 
-    cond_format->min_value = (uint16_t) user_options->value;
+    lxw_sprintf_dbl(data, number);
 
-    return LXW_NO_ERROR;
+    lxw_xml_data_element(self->file, "formula1", data, NULL);
 }
 
-lxw_error
-_validate_conditional_average(lxw_conditional_format *user)
+/*
+ * Write the <formula1> element for strings/formulas.
+ */
+STATIC void
+_worksheet_write_formula1_str(lxw_worksheet *self, char *str)
 {
-    if (user->criteria < LXW_CONDITIONAL_CRITERIA_AVERAGE_ABOVE ||
-        user->criteria > LXW_CONDITIONAL_CRITERIA_AVERAGE_3_STD_DEV_BELOW) {
-
-        LXW_WARN_FORMAT1("worksheet_conditional_format_cell()/_range(): "
-                         "For type = LXW_CONDITIONAL_TYPE_AVERAGE, "
-                         "invalid criteria value (%d).", user->criteria);
-
-        return LXW_ERROR_PARAMETER_VALIDATION;
-    }
-    else {
-        return LXW_NO_ERROR;
-    }
+    lxw_xml_data_element(self->file, "formula1", str, NULL);
 }
 
-lxw_error
-_validate_conditional_time_period(lxw_conditional_format *user)
+/*
+ * Write the <formula2> element for numbers.
+ */
+STATIC void
+_worksheet_write_formula2_num(lxw_worksheet *self, double number)
 {
-    if (user->criteria < LXW_CONDITIONAL_CRITERIA_TIME_PERIOD_YESTERDAY ||
-        user->criteria > LXW_CONDITIONAL_CRITERIA_TIME_PERIOD_NEXT_MONTH) {
+    char data[LXW_ATTR_32];
 
-        LXW_WARN_FORMAT1("worksheet_conditional_format_cell()/_range(): "
-                         "For type = LXW_CONDITIONAL_TYPE_TIME_PERIOD, "
-                         "invalid criteria value (%d).", user->criteria);
+    lxw_sprintf_dbl(data, number);
 
-        return LXW_ERROR_PARAMETER_VALIDATION;
-    }
-    else {
-        return LXW_NO_ERROR;
-    }
+    lxw_xml_data_element(self->file, "formula2", data, NULL);
 }
 
-lxw_error
-_validate_conditional_text(lxw_cond_format_obj *cond_format,
-                           lxw_conditional_format *user_options)
+/*
+ * Write the <formula2> element for strings/formulas.
+ */
+STATIC void
+_worksheet_write_formula2_str(lxw_worksheet *self, char *str)
 {
-    if (!user_options->value_string) {
-
-        LXW_WARN_FORMAT("worksheet_conditional_format_cell()/_range(): "
-                        "For type = LXW_CONDITIONAL_TYPE_TEXT, "
-                        "value_string can not be NULL. "
-                        "Text must be specified.");
-
-        return LXW_ERROR_PARAMETER_VALIDATION;
-    }
-
-    if (strlen(user_options->value_string) >= LXW_MAX_ATTRIBUTE_LENGTH) {
-
-        LXW_WARN_FORMAT2("worksheet_conditional_format_cell()/_range(): "
-                         "For type = LXW_CONDITIONAL_TYPE_TEXT, "
-                         "value_string length (%d) must be less than %d.",
-                         (uint16_t) strlen(user_options->value_string),
-                         LXW_MAX_ATTRIBUTE_LENGTH);
-
-        return LXW_ERROR_PARAMETER_VALIDATION;
-    }
-
-    if (user_options->criteria < LXW_CONDITIONAL_CRITERIA_TEXT_CONTAINING ||
-        user_options->criteria > LXW_CONDITIONAL_CRITERIA_TEXT_ENDS_WITH) {
-
-        LXW_WARN_FORMAT1("worksheet_conditional_format_cell()/_range(): "
-                         "For type = LXW_CONDITIONAL_TYPE_TEXT, "
-                         "invalid criteria value (%d).",
-                         user_options->criteria);
-
-        return LXW_ERROR_PARAMETER_VALIDATION;
-    }
-
-    cond_format->min_value_string =
-        lxw_strdup_formula(user_options->value_string);
-
-    return LXW_NO_ERROR;
+    lxw_xml_data_element(self->file, "formula2", str, NULL);
 }
 
-lxw_error
-_validate_conditional_formula(lxw_cond_format_obj *cond_format,
-                              lxw_conditional_format *user_options)
+/*
+ * Write the <dataValidation> element.
+ */
+STATIC void
+_worksheet_write_data_validation(lxw_worksheet *self,
+                                 lxw_data_val_obj *validation)
 {
-    if (!user_options->value_string) {
+    struct xml_attribute_list attributes;
+    struct xml_attribute *attribute;
+    uint8_t is_between = 0;
 
-        LXW_WARN_FORMAT("worksheet_conditional_format_cell()/_range(): "
-                        "For type = LXW_CONDITIONAL_TYPE_FORMULA, "
-                        "value_string can not be NULL. "
-                        "Formula must be specified.");
+    LXW_INIT_ATTRIBUTES();
 
-        return LXW_ERROR_PARAMETER_VALIDATION;
-    }
+    switch (validation->validate) {
+        case LXW_VALIDATION_TYPE_INTEGER:
+        case LXW_VALIDATION_TYPE_INTEGER_FORMULA:
+            LXW_PUSH_ATTRIBUTES_STR("type", "whole");
+            break;
+        case LXW_VALIDATION_TYPE_DECIMAL:
+        case LXW_VALIDATION_TYPE_DECIMAL_FORMULA:
+            LXW_PUSH_ATTRIBUTES_STR("type", "decimal");
+            break;
+        case LXW_VALIDATION_TYPE_LIST:
+        case LXW_VALIDATION_TYPE_LIST_FORMULA:
+            LXW_PUSH_ATTRIBUTES_STR("type", "list");
+            break;
+        case LXW_VALIDATION_TYPE_DATE:
+        case LXW_VALIDATION_TYPE_DATE_FORMULA:
+        case LXW_VALIDATION_TYPE_DATE_NUMBER:
+            LXW_PUSH_ATTRIBUTES_STR("type", "date");
+            break;
+        case LXW_VALIDATION_TYPE_TIME:
+        case LXW_VALIDATION_TYPE_TIME_FORMULA:
+        case LXW_VALIDATION_TYPE_TIME_NUMBER:
+            LXW_PUSH_ATTRIBUTES_STR("type", "time");
+            break;
+        case LXW_VALIDATION_TYPE_LENGTH:
+        case LXW_VALIDATION_TYPE_LENGTH_FORMULA:
+            LXW_PUSH_ATTRIBUTES_STR("type", "textLength");
+            break;
+        case LXW_VALIDATION_TYPE_CUSTOM_FORMULA:
+            LXW_PUSH_ATTRIBUTES_STR("type", "custom");
+            break;
+    }
+
+    switch (validation->criteria) {
+        case LXW_VALIDATION_CRITERIA_EQUAL_TO:
+            LXW_PUSH_ATTRIBUTES_STR("operator", "equal");
+            break;
+        case LXW_VALIDATION_CRITERIA_NOT_EQUAL_TO:
+            LXW_PUSH_ATTRIBUTES_STR("operator", "notEqual");
+            break;
+        case LXW_VALIDATION_CRITERIA_LESS_THAN:
+            LXW_PUSH_ATTRIBUTES_STR("operator", "lessThan");
+            break;
+        case LXW_VALIDATION_CRITERIA_LESS_THAN_OR_EQUAL_TO:
+            LXW_PUSH_ATTRIBUTES_STR("operator", "lessThanOrEqual");
+            break;
+        case LXW_VALIDATION_CRITERIA_GREATER_THAN:
+            LXW_PUSH_ATTRIBUTES_STR("operator", "greaterThan");
+            break;
+        case LXW_VALIDATION_CRITERIA_GREATER_THAN_OR_EQUAL_TO:
+            LXW_PUSH_ATTRIBUTES_STR("operator", "greaterThanOrEqual");
+            break;
+        case LXW_VALIDATION_CRITERIA_BETWEEN:
+            /* Between is the default for 2 formulas and isn't added. */
+            is_between = 1;
+            break;
+        case LXW_VALIDATION_CRITERIA_NOT_BETWEEN:
+            is_between = 1;
+            LXW_PUSH_ATTRIBUTES_STR("operator", "notBetween");
+            break;
+    }
+
+    if (validation->error_type == LXW_VALIDATION_ERROR_TYPE_WARNING)
+        LXW_PUSH_ATTRIBUTES_STR("errorStyle", "warning");
+
+    if (validation->error_type == LXW_VALIDATION_ERROR_TYPE_INFORMATION)
+        LXW_PUSH_ATTRIBUTES_STR("errorStyle", "information");
+
+    if (validation->ignore_blank)
+        LXW_PUSH_ATTRIBUTES_INT("allowBlank", 1);
+
+    if (validation->dropdown == LXW_VALIDATION_OFF)
+        LXW_PUSH_ATTRIBUTES_INT("showDropDown", 1);
+
+    if (validation->show_input)
+        LXW_PUSH_ATTRIBUTES_INT("showInputMessage", 1);
+
+    if (validation->show_error)
+        LXW_PUSH_ATTRIBUTES_INT("showErrorMessage", 1);
+
+    if (validation->error_title)
+        LXW_PUSH_ATTRIBUTES_STR("errorTitle", validation->error_title);
+
+    if (validation->error_message)
+        LXW_PUSH_ATTRIBUTES_STR("error", validation->error_message);
+
+    if (validation->input_title)
+        LXW_PUSH_ATTRIBUTES_STR("promptTitle", validation->input_title);
+
+    if (validation->input_message)
+        LXW_PUSH_ATTRIBUTES_STR("prompt", validation->input_message);
+
+    LXW_PUSH_ATTRIBUTES_STR("sqref", validation->sqref);
+
+    if (validation->validate == LXW_VALIDATION_TYPE_ANY)
+        lxw_xml_empty_tag(self->file, "dataValidation", &attributes);
+    else
+        lxw_xml_start_tag(self->file, "dataValidation", &attributes);
+
+    /* Write the formula1 and formula2 elements. */
+    switch (validation->validate) {
+        case LXW_VALIDATION_TYPE_INTEGER:
+        case LXW_VALIDATION_TYPE_DECIMAL:
+        case LXW_VALIDATION_TYPE_LENGTH:
+        case LXW_VALIDATION_TYPE_DATE:
+        case LXW_VALIDATION_TYPE_TIME:
+        case LXW_VALIDATION_TYPE_DATE_NUMBER:
+        case LXW_VALIDATION_TYPE_TIME_NUMBER:
+            _worksheet_write_formula1_num(self, validation->value_number);
+            if (is_between)
+                _worksheet_write_formula2_num(self,
+                                              validation->maximum_number);
+            break;
+        case LXW_VALIDATION_TYPE_INTEGER_FORMULA:
+        case LXW_VALIDATION_TYPE_DECIMAL_FORMULA:
+        case LXW_VALIDATION_TYPE_LENGTH_FORMULA:
+        case LXW_VALIDATION_TYPE_DATE_FORMULA:
+        case LXW_VALIDATION_TYPE_TIME_FORMULA:
+        case LXW_VALIDATION_TYPE_LIST:
+        case LXW_VALIDATION_TYPE_LIST_FORMULA:
+        case LXW_VALIDATION_TYPE_CUSTOM_FORMULA:
+            if (validation->shared_list)
+                _worksheet_write_formula1_str(self,
+                                              validation->shared_list->
+                                              formula);
+            else
+                _worksheet_write_formula1_str(self,
+                                              validation->value_formula);
+            if (is_between)
+                _worksheet_write_formula2_str(self,
+                                              validation->maximum_formula);
+            break;
+    }
+
+    if (validation->validate != LXW_VALIDATION_TYPE_ANY)
+        lxw_xml_end_tag(self->file, "dataValidation");
+
+    LXW_FREE_ATTRIBUTES();
+}
+
+/*
+ * Write the <dataValidations> element.
+ */
+STATIC void
+_worksheet_write_data_validations(lxw_worksheet *self)
+{
+    struct xml_attribute_list attributes;
+    struct xml_attribute *attribute;
+    lxw_data_val_obj *data_validation;
+
+    if (self->num_validations == 0)
+        return;
+
+    LXW_INIT_ATTRIBUTES();
+    LXW_PUSH_ATTRIBUTES_INT("count", self->num_validations);
+
+    lxw_xml_start_tag(self->file, "dataValidations", &attributes);
+
+    STAILQ_FOREACH(data_validation, self->data_validations, list_pointers) {
+        /* Write the dataValidation element. */
+        _worksheet_write_data_validation(self, data_validation);
+    }
+
+    lxw_xml_end_tag(self->file, "dataValidations");
+
+    LXW_FREE_ATTRIBUTES();
+}
+
+/*
+ * Write the <formula> element for strings.
+ */
+STATIC void
+_worksheet_write_formula_str(lxw_worksheet *self, char *data)
+{
+    lxw_xml_data_element(self->file, "formula", data, NULL);
+}
+
+/*
+ * Write the <formula> element for numbers.
+ */
+STATIC void
+_worksheet_write_formula_num(lxw_worksheet *self, double num)
+{
+    char data[LXW_ATTR_32];
+
+    lxw_sprintf_dbl(data, num);
+    lxw_xml_data_element(self->file, "formula", data, NULL);
+}
+
+/*
+ * Write the <ext> element.
+ */
+STATIC void
+_worksheet_write_ext(lxw_worksheet *self, char *uri)
+{
+    struct xml_attribute_list attributes;
+    struct xml_attribute *attribute;
+    char xmlns_x_14[] =
+        "http://schemas.microsoft.com/office/spreadsheetml/2009/9/main";
+
+    LXW_INIT_ATTRIBUTES();
+    LXW_PUSH_ATTRIBUTES_STR("xmlns:x14", xmlns_x_14);
+    LXW_PUSH_ATTRIBUTES_STR("uri", uri);
+
+    lxw_xml_start_tag(self->file, "ext", &attributes);
+
+    LXW_FREE_ATTRIBUTES();
+}
+
+/*
+ * Write the <extLst> dataBar extension element.
+ */
+STATIC void
+_worksheet_write_data_bar_ext(lxw_worksheet *self,
+                              lxw_cond_format_obj *cond_format)
+{
+    /* Create a pseudo GUID for each unique Excel 2010 data bar. */
+    cond_format->guid = calloc(1, LXW_GUID_LENGTH);
+    lxw_snprintf(cond_format->guid, LXW_GUID_LENGTH,
+                 "{DA7ABA51-AAAA-BBBB-%04X-%012X}",
+                 self->index + 1, ++self->data_bar_2010_index);
+
+    lxw_xml_start_tag(self->file, "extLst", NULL);
+
+    _worksheet_write_ext(self, "{B025F937-C7B1-47D3-B67F-A62EFF666E3E}");
+
+    lxw_xml_data_element(self->file, "x14:id", cond_format->guid, NULL);
+
+    lxw_xml_end_tag(self->file, "ext");
+    lxw_xml_end_tag(self->file, "extLst");
+}
+
+/*
+ * Write the <color> element.
+ */
+STATIC void
+_worksheet_write_color(lxw_worksheet *self, lxw_color_t color)
+{
+    struct xml_attribute_list attributes;
+    struct xml_attribute *attribute;
+    char rgb[LXW_ATTR_32];
+
+    lxw_snprintf(rgb, LXW_ATTR_32, "FF%06X", color & LXW_COLOR_MASK);
+
+    LXW_INIT_ATTRIBUTES();
+    LXW_PUSH_ATTRIBUTES_STR("rgb", rgb);
+
+    lxw_xml_empty_tag(self->file, "color", &attributes);
+
+    LXW_FREE_ATTRIBUTES();
+}
+
+/*
+ * Write the <cfvo> element for strings.
+ */
+STATIC void
+_worksheet_write_cfvo_str(lxw_worksheet *self, uint8_t rule_type,
+                          char *value, uint8_t data_bar_2010)
+{
+    struct xml_attribute_list attributes;
+    struct xml_attribute *attribute;
+
+    LXW_INIT_ATTRIBUTES();
+
+    if (rule_type == LXW_CONDITIONAL_RULE_TYPE_MINIMUM)
+        LXW_PUSH_ATTRIBUTES_STR("type", "min");
+    else if (rule_type == LXW_CONDITIONAL_RULE_TYPE_NUMBER)
+        LXW_PUSH_ATTRIBUTES_STR("type", "num");
+    else if (rule_type == LXW_CONDITIONAL_RULE_TYPE_PERCENT)
+        LXW_PUSH_ATTRIBUTES_STR("type", "percent");
+    else if (rule_type == LXW_CONDITIONAL_RULE_TYPE_PERCENTILE)
+        LXW_PUSH_ATTRIBUTES_STR("type", "percentile");
+    else if (rule_type == LXW_CONDITIONAL_RULE_TYPE_FORMULA)
+        LXW_PUSH_ATTRIBUTES_STR("type", "formula");
+    else if (rule_type == LXW_CONDITIONAL_RULE_TYPE_MAXIMUM)
+        LXW_PUSH_ATTRIBUTES_STR("type", "max");
+
+    if (!data_bar_2010 || (rule_type != LXW_CONDITIONAL_RULE_TYPE_MINIMUM
+                           && rule_type != LXW_CONDITIONAL_RULE_TYPE_MAXIMUM))
+        LXW_PUSH_ATTRIBUTES_STR("val", value);
+
+    lxw_xml_empty_tag(self->file, "cfvo", &attributes);
+
+    LXW_FREE_ATTRIBUTES();
+}
+
+/*
+ * Write the <cfvo> element for numbers.
+ */
+STATIC void
+_worksheet_write_cfvo_num(lxw_worksheet *self, uint8_t rule_type,
+                          double value, uint8_t data_bar_2010)
+{
+    struct xml_attribute_list attributes;
+    struct xml_attribute *attribute;
+
+    LXW_INIT_ATTRIBUTES();
+
+    if (rule_type == LXW_CONDITIONAL_RULE_TYPE_MINIMUM)
+        LXW_PUSH_ATTRIBUTES_STR("type", "min");
+    else if (rule_type == LXW_CONDITIONAL_RULE_TYPE_NUMBER)
+        LXW_PUSH_ATTRIBUTES_STR("type", "num");
+    else if (rule_type == LXW_CONDITIONAL_RULE_TYPE_PERCENT)
+        LXW_PUSH_ATTRIBUTES_STR("type", "percent");
+    else if (rule_type == LXW_CONDITIONAL_RULE_TYPE_PERCENTILE)
+        LXW_PUSH_ATTRIBUTES_STR("type", "percentile");
+    else if (rule_type == LXW_CONDITIONAL_RULE_TYPE_FORMULA)
+        LXW_PUSH_ATTRIBUTES_STR("type", "formula");
+    else if (rule_type == LXW_CONDITIONAL_RULE_TYPE_MAXIMUM)
+        LXW_PUSH_ATTRIBUTES_STR("type", "max");
+
+    if (!data_bar_2010 || (rule_type != LXW_CONDITIONAL_RULE_TYPE_MINIMUM
+                           && rule_type != LXW_CONDITIONAL_RULE_TYPE_MAXIMUM))
+        LXW_PUSH_ATTRIBUTES_DBL("val", value);
+
+    lxw_xml_empty_tag(self->file, "cfvo", &attributes);
+
+    LXW_FREE_ATTRIBUTES();
+}
+
+/*
+ * Write the <iconSet> element.
+ */
+STATIC void
+_worksheet_write_icon_set(lxw_worksheet *self,
+                          lxw_cond_format_obj *cond_format)
+{
+    struct xml_attribute_list attributes;
+    struct xml_attribute *attribute;
+    char *icon_set[] = {
+        "3Arrows",
+        "3ArrowsGray",
+        "3Flags",
+        "3TrafficLights",
+        "3TrafficLights2",
+        "3Signs",
+        "3Symbols",
+        "3Symbols2",
+        "4Arrows",
+        "4ArrowsGray",
+        "4RedToBlack",
+        "4Rating",
+        "4TrafficLights",
+        "5Arrows",
+        "5ArrowsGray",
+        "5Rating",
+        "5Quarters",
+    };
+    uint8_t percent = LXW_CONDITIONAL_RULE_TYPE_PERCENT;
+    uint8_t style = cond_format->icon_style;
+
+    LXW_INIT_ATTRIBUTES();
+
+    if (style != LXW_CONDITIONAL_ICONS_3_TRAFFIC_LIGHTS_UNRIMMED)
+        LXW_PUSH_ATTRIBUTES_STR("iconSet", icon_set[style]);
+
+    if (cond_format->reverse_icons == LXW_TRUE)
+        LXW_PUSH_ATTRIBUTES_STR("reverse", "1");
+
+    if (cond_format->icons_only == LXW_TRUE)
+        LXW_PUSH_ATTRIBUTES_STR("showValue", "0");
+
+    lxw_xml_start_tag(self->file, "iconSet", &attributes);
+
+    if (style < LXW_CONDITIONAL_ICONS_4_ARROWS_COLORED) {
+        _worksheet_write_cfvo_num(self, percent, 0, LXW_FALSE);
+        _worksheet_write_cfvo_num(self, percent, 33, LXW_FALSE);
+        _worksheet_write_cfvo_num(self, percent, 67, LXW_FALSE);
+    }
+
+    if (style >= LXW_CONDITIONAL_ICONS_4_ARROWS_COLORED
+        && style < LXW_CONDITIONAL_ICONS_5_ARROWS_COLORED) {
+        _worksheet_write_cfvo_num(self, percent, 0, LXW_FALSE);
+        _worksheet_write_cfvo_num(self, percent, 25, LXW_FALSE);
+        _worksheet_write_cfvo_num(self, percent, 50, LXW_FALSE);
+        _worksheet_write_cfvo_num(self, percent, 75, LXW_FALSE);
+    }
+
+    if (style >= LXW_CONDITIONAL_ICONS_5_ARROWS_COLORED
+        && style <= LXW_CONDITIONAL_ICONS_5_QUARTERS) {
+        _worksheet_write_cfvo_num(self, percent, 0, LXW_FALSE);
+        _worksheet_write_cfvo_num(self, percent, 20, LXW_FALSE);
+        _worksheet_write_cfvo_num(self, percent, 40, LXW_FALSE);
+        _worksheet_write_cfvo_num(self, percent, 60, LXW_FALSE);
+        _worksheet_write_cfvo_num(self, percent, 80, LXW_FALSE);
+    }
+
+    LXW_FREE_ATTRIBUTES();
+}
+
+/*
+ * Write the <cfRule> element for data bar rules.
+ */
+STATIC void
+_worksheet_write_cf_rule_icons(lxw_worksheet *self,
+                               lxw_cond_format_obj *cond_format)
+{
+    struct xml_attribute_list attributes;
+    struct xml_attribute *attribute;
+
+    LXW_INIT_ATTRIBUTES();
+
+    LXW_PUSH_ATTRIBUTES_STR("type", cond_format->type_string);
+    LXW_PUSH_ATTRIBUTES_INT("priority", cond_format->dxf_priority);
+    lxw_xml_start_tag(self->file, "cfRule", &attributes);
+
+    _worksheet_write_icon_set(self, cond_format);
+
+    lxw_xml_end_tag(self->file, "iconSet");
+    lxw_xml_end_tag(self->file, "cfRule");
+
+    LXW_FREE_ATTRIBUTES();
+}
+
+/*
+ * Write the <dataBar> element.
+ */
+STATIC void
+_worksheet_write_data_bar(lxw_worksheet *self,
+                          lxw_cond_format_obj *cond_format)
+{
+    struct xml_attribute_list attributes;
+    struct xml_attribute *attribute;
+
+    LXW_INIT_ATTRIBUTES();
+
+    if (cond_format->bar_only)
+        LXW_PUSH_ATTRIBUTES_STR("showValue", "0");
+
+    lxw_xml_start_tag(self->file, "dataBar", &attributes);
+
+    LXW_FREE_ATTRIBUTES();
+}
+
+/*
+ * Write the <cfRule> element for data bar rules.
+ */
+STATIC void
+_worksheet_write_cf_rule_data_bar(lxw_worksheet *self,
+                                  lxw_cond_format_obj *cond_format)
+{
+    struct xml_attribute_list attributes;
+    struct xml_attribute *attribute;
+
+    LXW_INIT_ATTRIBUTES();
+
+    LXW_PUSH_ATTRIBUTES_STR("type", cond_format->type_string);
+    LXW_PUSH_ATTRIBUTES_INT("priority", cond_format->dxf_priority);
+    lxw_xml_start_tag(self->file, "cfRule", &attributes);
+
+    _worksheet_write_data_bar(self, cond_format);
+
+    if (cond_format->min_value_string) {
+        _worksheet_write_cfvo_str(self, cond_format->min_rule_type,
+                                  cond_format->min_value_string,
+                                  cond_format->data_bar_2010);
+    }
+    else {
+        _worksheet_write_cfvo_num(self, cond_format->min_rule_type,
+                                  cond_format->min_value,
+                                  cond_format->data_bar_2010);
+    }
+
+    if (cond_format->max_value_string) {
+        _worksheet_write_cfvo_str(self, cond_format->max_rule_type,
+                                  cond_format->max_value_string,
+                                  cond_format->data_bar_2010);
+    }
+    else {
+        _worksheet_write_cfvo_num(self, cond_format->max_rule_type,
+                                  cond_format->max_value,
+                                  cond_format->data_bar_2010);
+    }
+
+    _worksheet_write_color(self, cond_format->bar_color);
+
+    lxw_xml_end_tag(self->file, "dataBar");
+
+    if (cond_format->data_bar_2010)
+        _worksheet_write_data_bar_ext(self, cond_format);
+
+    lxw_xml_end_tag(self->file, "cfRule");
+
+    LXW_FREE_ATTRIBUTES();
+}
+
+/*
+ * Write the <cfRule> element for 2 and 3 color scale rules.
+ */
+STATIC void
+_worksheet_write_cf_rule_color_scale(lxw_worksheet *self,
+                                     lxw_cond_format_obj *cond_format)
+{
+    struct xml_attribute_list attributes;
+    struct xml_attribute *attribute;
+
+    LXW_INIT_ATTRIBUTES();
+
+    LXW_PUSH_ATTRIBUTES_STR("type", cond_format->type_string);
+    LXW_PUSH_ATTRIBUTES_INT("priority", cond_format->dxf_priority);
+    lxw_xml_start_tag(self->file, "cfRule", &attributes);
+
+    lxw_xml_start_tag(self->file, "colorScale", NULL);
+
+    if (cond_format->min_value_string) {
+        _worksheet_write_cfvo_str(self, cond_format->min_rule_type,
+                                  cond_format->min_value_string, LXW_FALSE);
+    }
+    else {
+        _worksheet_write_cfvo_num(self, cond_format->min_rule_type,
+                                  cond_format->min_value, LXW_FALSE);
+    }
+
+    if (cond_format->type == LXW_CONDITIONAL_3_COLOR_SCALE) {
+        if (cond_format->mid_value_string) {
+            _worksheet_write_cfvo_str(self, cond_format->mid_rule_type,
+                                      cond_format->mid_value_string,
+                                      LXW_FALSE);
+        }
+        else {
+            _worksheet_write_cfvo_num(self, cond_format->mid_rule_type,
+                                      cond_format->mid_value, LXW_FALSE);
+        }
+    }
+
+    if (cond_format->max_value_string) {
+        _worksheet_write_cfvo_str(self, cond_format->max_rule_type,
+                                  cond_format->max_value_string, LXW_FALSE);
+    }
+    else {
+        _worksheet_write_cfvo_num(self, cond_format->max_rule_type,
+                                  cond_format->max_value, LXW_FALSE);
+    }
+
+    _worksheet_write_color(self, cond_format->min_color);
+
+    if (cond_format->type == LXW_CONDITIONAL_3_COLOR_SCALE)
+        _worksheet_write_color(self, cond_format->mid_color);
+
+    _worksheet_write_color(self, cond_format->max_color);
+
+    lxw_xml_end_tag(self->file, "colorScale");
+    lxw_xml_end_tag(self->file, "cfRule");
+
+    LXW_FREE_ATTRIBUTES();
+}
+
+/*
+ * Write the <cfRule> element for formula rules.
+ */
+STATIC void
+_worksheet_write_cf_rule_formula(lxw_worksheet *self,
+                                 lxw_cond_format_obj *cond_format)
+{
+    struct xml_attribute_list attributes;
+    struct xml_attribute *attribute;
+
+    LXW_INIT_ATTRIBUTES();
+
+    LXW_PUSH_ATTRIBUTES_STR("type", cond_format->type_string);
+
+    if (cond_format->dxf_index != LXW_PROPERTY_UNSET)
+        LXW_PUSH_ATTRIBUTES_INT("dxfId", cond_format->dxf_index);
+
+    LXW_PUSH_ATTRIBUTES_INT("priority", cond_format->dxf_priority);
+
+    if (cond_format->stop_if_true)
+        LXW_PUSH_ATTRIBUTES_INT("stopIfTrue", 1);
+
+    lxw_xml_start_tag(self->file, "cfRule", &attributes);
+
+    _worksheet_write_formula_str(self, cond_format->min_value_string);
+
+    lxw_xml_end_tag(self->file, "cfRule");
+
+    LXW_FREE_ATTRIBUTES();
+}
+
+/*
+ * Write the <cfRule> element for top and bottom rules.
+ */
+STATIC void
+_worksheet_write_cf_rule_top(lxw_worksheet *self,
+                             lxw_cond_format_obj *cond_format)
+{
+    struct xml_attribute_list attributes;
+    struct xml_attribute *attribute;
+
+    LXW_INIT_ATTRIBUTES();
+
+    LXW_PUSH_ATTRIBUTES_STR("type", cond_format->type_string);
+
+    if (cond_format->dxf_index != LXW_PROPERTY_UNSET)
+        LXW_PUSH_ATTRIBUTES_INT("dxfId", cond_format->dxf_index);
+
+    LXW_PUSH_ATTRIBUTES_INT("priority", cond_format->dxf_priority);
+
+    if (cond_format->stop_if_true)
+        LXW_PUSH_ATTRIBUTES_INT("stopIfTrue", 1);
+
+    if (cond_format->criteria ==
+        LXW_CONDITIONAL_CRITERIA_TOP_OR_BOTTOM_PERCENT)
+        LXW_PUSH_ATTRIBUTES_INT("percent", 1);
+
+    if (cond_format->type == LXW_CONDITIONAL_TYPE_BOTTOM)
+        LXW_PUSH_ATTRIBUTES_INT("bottom", 1);
+
+    /* Rank must be an int in the range 1-1000 . */
+    if (cond_format->min_value < 1.0 || cond_format->min_value > 1000.0)
+        LXW_PUSH_ATTRIBUTES_DBL("rank", 10);
+    else
+        LXW_PUSH_ATTRIBUTES_DBL("rank", (uint16_t) cond_format->min_value);
+
+    lxw_xml_empty_tag(self->file, "cfRule", &attributes);
+
+    LXW_FREE_ATTRIBUTES();
+}
+
+/*
+ * Write the <cfRule> element for unique/duplicate rules.
+ */
+STATIC void
+_worksheet_write_cf_rule_duplicate(lxw_worksheet *self,
+                                   lxw_cond_format_obj *cond_format)
+{
+    struct xml_attribute_list attributes;
+    struct xml_attribute *attribute;
+
+    LXW_INIT_ATTRIBUTES();
+
+    LXW_PUSH_ATTRIBUTES_STR("type", cond_format->type_string);
+
+    /* Set the attributes common to all rule types. */
+    if (cond_format->dxf_index != LXW_PROPERTY_UNSET)
+        LXW_PUSH_ATTRIBUTES_INT("dxfId", cond_format->dxf_index);
+
+    LXW_PUSH_ATTRIBUTES_INT("priority", cond_format->dxf_priority);
+
+    lxw_xml_empty_tag(self->file, "cfRule", &attributes);
+
+    LXW_FREE_ATTRIBUTES();
+}
+
+/*
+ * Write the <cfRule> element for averages rules.
+ */
+STATIC void
+_worksheet_write_cf_rule_average(lxw_worksheet *self,
+                                 lxw_cond_format_obj *cond_format)
+{
+    struct xml_attribute_list attributes;
+    struct xml_attribute *attribute;
+    uint8_t criteria = cond_format->criteria;
+
+    LXW_INIT_ATTRIBUTES();
+
+    LXW_PUSH_ATTRIBUTES_STR("type", cond_format->type_string);
+
+    if (cond_format->dxf_index != LXW_PROPERTY_UNSET)
+        LXW_PUSH_ATTRIBUTES_INT("dxfId", cond_format->dxf_index);
+
+    LXW_PUSH_ATTRIBUTES_INT("priority", cond_format->dxf_priority);
+
+    if (cond_format->stop_if_true)
+        LXW_PUSH_ATTRIBUTES_INT("stopIfTrue", 1);
+
+    if (criteria == LXW_CONDITIONAL_CRITERIA_AVERAGE_BELOW
+        || criteria == LXW_CONDITIONAL_CRITERIA_AVERAGE_BELOW_OR_EQUAL
+        || criteria == LXW_CONDITIONAL_CRITERIA_AVERAGE_1_STD_DEV_BELOW
+        || criteria == LXW_CONDITIONAL_CRITERIA_AVERAGE_2_STD_DEV_BELOW
+        || criteria == LXW_CONDITIONAL_CRITERIA_AVERAGE_3_STD_DEV_BELOW)
+        LXW_PUSH_ATTRIBUTES_INT("aboveAverage", 0);
+
+    if (criteria == LXW_CONDITIONAL_CRITERIA_AVERAGE_ABOVE_OR_EQUAL
+        || criteria == LXW_CONDITIONAL_CRITERIA_AVERAGE_BELOW_OR_EQUAL)
+        LXW_PUSH_ATTRIBUTES_INT("equalAverage", 1);
+
+    if (criteria == LXW_CONDITIONAL_CRITERIA_AVERAGE_1_STD_DEV_ABOVE
+        || criteria == LXW_CONDITIONAL_CRITERIA_AVERAGE_1_STD_DEV_BELOW)
+        LXW_PUSH_ATTRIBUTES_INT("stdDev", 1);
+
+    if (criteria == LXW_CONDITIONAL_CRITERIA_AVERAGE_2_STD_DEV_ABOVE
+        || criteria == LXW_CONDITIONAL_CRITERIA_AVERAGE_2_STD_DEV_BELOW)
+        LXW_PUSH_ATTRIBUTES_INT("stdDev", 2);
+
+    if (criteria == LXW_CONDITIONAL_CRITERIA_AVERAGE_3_STD_DEV_ABOVE
+        || criteria == LXW_CONDITIONAL_CRITERIA_AVERAGE_3_STD_DEV_BELOW)
+        LXW_PUSH_ATTRIBUTES_INT("stdDev", 3);
+
+    lxw_xml_empty_tag(self->file, "cfRule", &attributes);
+
+    LXW_FREE_ATTRIBUTES();
+}
+
+/*
+ * Write the <cfRule> element for time_period rules.
+ */
+STATIC void
+_worksheet_write_cf_rule_time_period(lxw_worksheet *self,
+                                     lxw_cond_format_obj *cond_format)
+{
+    struct xml_attribute_list attributes;
+    struct xml_attribute *attribute;
+    char formula[LXW_MAX_ATTRIBUTE_LENGTH];
+    uint8_t pos;
+    uint8_t criteria = cond_format->criteria;
+    char *first_cell = cond_format->first_cell;
+    char *time_periods[] = {
+        "yesterday",
+        "today",
+        "tomorrow",
+        "last7Days",
+        "lastWeek",
+        "thisWeek",
+        "nextWeek",
+        "lastMonth",
+        "thisMonth",
+        "nextMonth",
+    };
+
+    LXW_INIT_ATTRIBUTES();
+
+    LXW_PUSH_ATTRIBUTES_STR("type", cond_format->type_string);
+
+    if (cond_format->dxf_index != LXW_PROPERTY_UNSET)
+        LXW_PUSH_ATTRIBUTES_INT("dxfId", cond_format->dxf_index);
+
+    LXW_PUSH_ATTRIBUTES_INT("priority", cond_format->dxf_priority);
+
+    pos = criteria - LXW_CONDITIONAL_CRITERIA_TIME_PERIOD_YESTERDAY;
+    LXW_PUSH_ATTRIBUTES_STR("timePeriod", time_periods[pos]);
+
+    if (cond_format->stop_if_true)
+        LXW_PUSH_ATTRIBUTES_INT("stopIfTrue", 1);
+
+    lxw_xml_start_tag(self->file, "cfRule", &attributes);
+
+    if (criteria == LXW_CONDITIONAL_CRITERIA_TIME_PERIOD_YESTERDAY) {
+        lxw_snprintf(formula, LXW_MAX_ATTRIBUTE_LENGTH,
+                     "FLOOR(%s,1)=TODAY()-1", first_cell);
+        _worksheet_write_formula_str(self, formula);
+    }
+    else if (criteria == LXW_CONDITIONAL_CRITERIA_TIME_PERIOD_TODAY) {
+        lxw_snprintf(formula, LXW_MAX_ATTRIBUTE_LENGTH,
+                     "FLOOR(%s,1)=TODAY()", first_cell);
+        _worksheet_write_formula_str(self, formula);
+    }
+    else if (criteria == LXW_CONDITIONAL_CRITERIA_TIME_PERIOD_TOMORROW) {
+        lxw_snprintf(formula, LXW_MAX_ATTRIBUTE_LENGTH,
+                     "FLOOR(%s,1)=TODAY()+1", first_cell);
+        _worksheet_write_formula_str(self, formula);
+    }
+    else if (criteria == LXW_CONDITIONAL_CRITERIA_TIME_PERIOD_LAST_7_DAYS) {
+        lxw_snprintf(formula, LXW_MAX_ATTRIBUTE_LENGTH,
+                     "AND(TODAY()-FLOOR(%s,1)<=6,FLOOR(%s,1)<=TODAY())",
+                     first_cell, first_cell);
+        _worksheet_write_formula_str(self, formula);
+    }
+    else if (criteria == LXW_CONDITIONAL_CRITERIA_TIME_PERIOD_LAST_WEEK) {
+        lxw_snprintf(formula, LXW_MAX_ATTRIBUTE_LENGTH,
+                     "AND(TODAY()-ROUNDDOWN(%s,0)>=(WEEKDAY(TODAY())),"
+                     "TODAY()-ROUNDDOWN(%s,0)<(WEEKDAY(TODAY())+7))",
+                     first_cell, first_cell);
+        _worksheet_write_formula_str(self, formula);
+    }
+    else if (criteria == LXW_CONDITIONAL_CRITERIA_TIME_PERIOD_THIS_WEEK) {
+        lxw_snprintf(formula, LXW_MAX_ATTRIBUTE_LENGTH,
+                     "AND(TODAY()-ROUNDDOWN(%s,0)<=WEEKDAY(TODAY())-1,"
+                     "ROUNDDOWN(%s,0)-TODAY()<=7-WEEKDAY(TODAY()))",
+                     first_cell, first_cell);
+        _worksheet_write_formula_str(self, formula);
+    }
+    else if (criteria == LXW_CONDITIONAL_CRITERIA_TIME_PERIOD_NEXT_WEEK) {
+        lxw_snprintf(formula, LXW_MAX_ATTRIBUTE_LENGTH,
+                     "AND(ROUNDDOWN(%s,0)-TODAY()>(7-WEEKDAY(TODAY())),"
+                     "ROUNDDOWN(%s,0)-TODAY()<(15-WEEKDAY(TODAY())))",
+                     first_cell, first_cell);
+        _worksheet_write_formula_str(self, formula);
+    }
+    else if (criteria == LXW_CONDITIONAL_CRITERIA_TIME_PERIOD_LAST_MONTH) {
+        lxw_snprintf(formula, LXW_MAX_ATTRIBUTE_LENGTH,
+                     "AND(MONTH(%s)=MONTH(TODAY())-1,OR(YEAR(%s)=YEAR("
+                     "TODAY()),AND(MONTH(%s)=1,YEAR(A1)=YEAR(TODAY())-1)))",
+                     first_cell, first_cell, first_cell);
+        _worksheet_write_formula_str(self, formula);
+    }
+    else if (criteria == LXW_CONDITIONAL_CRITERIA_TIME_PERIOD_THIS_MONTH) {
+        lxw_snprintf(formula, LXW_MAX_ATTRIBUTE_LENGTH,
+                     "AND(MONTH(%s)=MONTH(TODAY()),YEAR(%s)=YEAR(TODAY()))",
+                     first_cell, first_cell);
+        _worksheet_write_formula_str(self, formula);
+    }
+    else if (criteria == LXW_CONDITIONAL_CRITERIA_TIME_PERIOD_NEXT_MONTH) {
+        lxw_snprintf(formula, LXW_MAX_ATTRIBUTE_LENGTH,
+                     "AND(MONTH(%s)=MONTH(TODAY())+1,OR(YEAR(%s)=YEAR("
+                     "TODAY()),AND(MONTH(%s)=12,YEAR(%s)=YEAR(TODAY())+1)))",
+                     first_cell, first_cell, first_cell, first_cell);
+        _worksheet_write_formula_str(self, formula);
+    }
+
+    lxw_xml_end_tag(self->file, "cfRule");
+
+    LXW_FREE_ATTRIBUTES();
+}
+
+/*
+ * Write the <cfRule> element for blanks/no_blanks, errors/no_errors rules.
+ */
+STATIC void
+_worksheet_write_cf_rule_blanks(lxw_worksheet *self,
+                                lxw_cond_format_obj *cond_format)
+{
+    struct xml_attribute_list attributes;
+    struct xml_attribute *attribute;
+    char formula[LXW_ATTR_32];
+    uint8_t type = cond_format->type;
+
+    LXW_INIT_ATTRIBUTES();
+
+    LXW_PUSH_ATTRIBUTES_STR("type", cond_format->type_string);
+
+    if (cond_format->dxf_index != LXW_PROPERTY_UNSET)
+        LXW_PUSH_ATTRIBUTES_INT("dxfId", cond_format->dxf_index);
+
+    LXW_PUSH_ATTRIBUTES_INT("priority", cond_format->dxf_priority);
+
+    if (cond_format->stop_if_true)
+        LXW_PUSH_ATTRIBUTES_INT("stopIfTrue", 1);
+
+    lxw_xml_start_tag(self->file, "cfRule", &attributes);
+
+    if (type == LXW_CONDITIONAL_TYPE_BLANKS) {
+        lxw_snprintf(formula, LXW_ATTR_32, "LEN(TRIM(%s))=0",
+                     cond_format->first_cell);
+        _worksheet_write_formula_str(self, formula);
+    }
+    else if (type == LXW_CONDITIONAL_TYPE_NO_BLANKS) {
+        lxw_snprintf(formula, LXW_ATTR_32, "LEN(TRIM(%s))>0",
+                     cond_format->first_cell);
+        _worksheet_write_formula_str(self, formula);
+    }
+    else if (type == LXW_CONDITIONAL_TYPE_ERRORS) {
+        lxw_snprintf(formula, LXW_ATTR_32, "ISERROR(%s)",
+                     cond_format->first_cell);
+        _worksheet_write_formula_str(self, formula);
+    }
+    else if (type == LXW_CONDITIONAL_TYPE_NO_ERRORS) {
+        lxw_snprintf(formula, LXW_ATTR_32, "NOT(ISERROR(%s))",
+                     cond_format->first_cell);
+        _worksheet_write_formula_str(self, formula);
+    }
+
+    lxw_xml_end_tag(self->file, "cfRule");
+
+    LXW_FREE_ATTRIBUTES();
+}
+
+/*
+ * Write the <cfRule> element for text rules.
+ */
+STATIC void
+_worksheet_write_cf_rule_text(lxw_worksheet *self,
+                              lxw_cond_format_obj *cond_format)
+{
+    struct xml_attribute_list attributes;
+    struct xml_attribute *attribute;
+    uint8_t pos;
+    char formula[LXW_ATTR_32 * 2];
+    char *operators[] = {
+        "containsText",
+        "notContains",
+        "beginsWith",
+        "endsWith",
+    };
+    uint8_t criteria = cond_format->criteria;
+
+    LXW_INIT_ATTRIBUTES();
+
+    if (criteria == LXW_CONDITIONAL_CRITERIA_TEXT_CONTAINING)
+        LXW_PUSH_ATTRIBUTES_STR("type", "containsText");
+    else if (criteria == LXW_CONDITIONAL_CRITERIA_TEXT_NOT_CONTAINING)
+        LXW_PUSH_ATTRIBUTES_STR("type", "notContainsText");
+    else if (criteria == LXW_CONDITIONAL_CRITERIA_TEXT_BEGINS_WITH)
+        LXW_PUSH_ATTRIBUTES_STR("type", "beginsWith");
+    else if (criteria == LXW_CONDITIONAL_CRITERIA_TEXT_ENDS_WITH)
+        LXW_PUSH_ATTRIBUTES_STR("type", "endsWith");
+
+    if (cond_format->dxf_index != LXW_PROPERTY_UNSET)
+        LXW_PUSH_ATTRIBUTES_INT("dxfId", cond_format->dxf_index);
+
+    LXW_PUSH_ATTRIBUTES_INT("priority", cond_format->dxf_priority);
+
+    if (cond_format->stop_if_true)
+        LXW_PUSH_ATTRIBUTES_INT("stopIfTrue", 1);
+
+    pos = criteria - LXW_CONDITIONAL_CRITERIA_TEXT_CONTAINING;
+    LXW_PUSH_ATTRIBUTES_STR("operator", operators[pos]);
+
+    LXW_PUSH_ATTRIBUTES_STR("text", cond_format->min_value_string);
+
+    lxw_xml_start_tag(self->file, "cfRule", &attributes);
+
+    if (criteria == LXW_CONDITIONAL_CRITERIA_TEXT_CONTAINING) {
+        lxw_snprintf(formula, LXW_ATTR_32 * 2,
+                     "NOT(ISERROR(SEARCH(\"%s\",%s)))",
+                     cond_format->min_value_string, cond_format->first_cell);
+        _worksheet_write_formula_str(self, formula);
+    }
+    else if (criteria == LXW_CONDITIONAL_CRITERIA_TEXT_NOT_CONTAINING) {
+        lxw_snprintf(formula, LXW_ATTR_32 * 2,
+                     "ISERROR(SEARCH(\"%s\",%s))",
+                     cond_format->min_value_string, cond_format->first_cell);
+        _worksheet_write_formula_str(self, formula);
+    }
+    else if (criteria == LXW_CONDITIONAL_CRITERIA_TEXT_BEGINS_WITH) {
+        lxw_snprintf(formula, LXW_ATTR_32 * 2,
+                     "LEFT(%s,%d)=\"%s\"",
+                     cond_format->first_cell,
+                     (uint16_t) strlen(cond_format->min_value_string),
+                     cond_format->min_value_string);
+        _worksheet_write_formula_str(self, formula);
+    }
+    else if (criteria == LXW_CONDITIONAL_CRITERIA_TEXT_ENDS_WITH) {
+        lxw_snprintf(formula, LXW_ATTR_32 * 2,
+                     "RIGHT(%s,%d)=\"%s\"",
+                     cond_format->first_cell,
+                     (uint16_t) strlen(cond_format->min_value_string),
+                     cond_format->min_value_string);
+        _worksheet_write_formula_str(self, formula);
+    }
+
+    lxw_xml_end_tag(self->file, "cfRule");
+
+    LXW_FREE_ATTRIBUTES();
+}
+
+/*
+ * Write the <cfRule> element for cell rules.
+ */
+STATIC void
+_worksheet_write_cf_rule_cell(lxw_worksheet *self,
+                              lxw_cond_format_obj *cond_format)
+{
+    struct xml_attribute_list attributes;
+    struct xml_attribute *attribute;
+    char *operators[] = {
+        "none",
+        "equal",
+        "notEqual",
+        "greaterThan",
+        "lessThan",
+        "greaterThanOrEqual",
+        "lessThanOrEqual",
+        "between",
+        "notBetween",
+    };
+
+    LXW_INIT_ATTRIBUTES();
+
+    LXW_PUSH_ATTRIBUTES_STR("type", cond_format->type_string);
+
+    if (cond_format->dxf_index != LXW_PROPERTY_UNSET)
+        LXW_PUSH_ATTRIBUTES_INT("dxfId", cond_format->dxf_index);
+
+    LXW_PUSH_ATTRIBUTES_INT("priority", cond_format->dxf_priority);
+
+    if (cond_format->stop_if_true)
+        LXW_PUSH_ATTRIBUTES_INT("stopIfTrue", 1);
+
+    LXW_PUSH_ATTRIBUTES_STR("operator", operators[cond_format->criteria]);
+
+    lxw_xml_start_tag(self->file, "cfRule", &attributes);
+
+    if (cond_format->min_value_string)
+        _worksheet_write_formula_str(self, cond_format->min_value_string);
+    else
+        _worksheet_write_formula_num(self, cond_format->min_value);
+
+    if (cond_format->has_max) {
+        if (cond_format->max_value_string)
+            _worksheet_write_formula_str(self, cond_format->max_value_string);
+        else
+            _worksheet_write_formula_num(self, cond_format->max_value);
+    }
+
+    lxw_xml_end_tag(self->file, "cfRule");
+
+    LXW_FREE_ATTRIBUTES();
+}
+
+/*
+ * Write the <cfRule> element.
+ */
+STATIC void
+_worksheet_write_cf_rule(lxw_worksheet *self,
+                         lxw_cond_format_obj *cond_format)
+{
+    if (cond_format->type == LXW_CONDITIONAL_TYPE_CELL) {
+
+        _worksheet_write_cf_rule_cell(self, cond_format);
+    }
+    else if (cond_format->type == LXW_CONDITIONAL_TYPE_TEXT) {
+
+        _worksheet_write_cf_rule_text(self, cond_format);
+    }
+    else if (cond_format->type == LXW_CONDITIONAL_TYPE_TIME_PERIOD) {
+
+        _worksheet_write_cf_rule_time_period(self, cond_format);
+    }
+    else if (cond_format->type == LXW_CONDITIONAL_TYPE_DUPLICATE
+             || cond_format->type == LXW_CONDITIONAL_TYPE_UNIQUE) {
+
+        _worksheet_write_cf_rule_duplicate(self, cond_format);
+    }
+    else if (cond_format->type == LXW_CONDITIONAL_TYPE_AVERAGE) {
+
+        _worksheet_write_cf_rule_average(self, cond_format);
+    }
+    else if (cond_format->type == LXW_CONDITIONAL_TYPE_TOP
+             || cond_format->type == LXW_CONDITIONAL_TYPE_BOTTOM) {
+
+        _worksheet_write_cf_rule_top(self, cond_format);
+    }
+    else if (cond_format->type == LXW_CONDITIONAL_TYPE_BLANKS
+             || cond_format->type == LXW_CONDITIONAL_TYPE_NO_BLANKS
+             || cond_format->type == LXW_CONDITIONAL_TYPE_ERRORS
+             || cond_format->type == LXW_CONDITIONAL_TYPE_NO_ERRORS) {
+
+        _worksheet_write_cf_rule_blanks(self, cond_format);
+    }
+    else if (cond_format->type == LXW_CONDITIONAL_TYPE_FORMULA) {
+
+        _worksheet_write_cf_rule_formula(self, cond_format);
+    }
+    else if (cond_format->type == LXW_CONDITIONAL_2_COLOR_SCALE
+             || cond_format->type == LXW_CONDITIONAL_3_COLOR_SCALE) {
+
+        _worksheet_write_cf_rule_color_scale(self, cond_format);
+    }
+    else if (cond_format->type == LXW_CONDITIONAL_DATA_BAR) {
+
+        _worksheet_write_cf_rule_data_bar(self, cond_format);
+    }
+    else if (cond_format->type == LXW_CONDITIONAL_TYPE_ICON_SETS) {
+
+        _worksheet_write_cf_rule_icons(self, cond_format);
+    }
+
+}
+
+/*
+ * Write the <conditionalFormatting> element.
+ */
+STATIC void
+_worksheet_write_conditional_formatting(lxw_worksheet *self,
+                                        lxw_cond_format_hash_element *element)
+{
+    struct xml_attribute_list attributes;
+    struct xml_attribute *attribute;
+    lxw_cond_format_obj *cond_format;
+
+    LXW_INIT_ATTRIBUTES();
+    LXW_PUSH_ATTRIBUTES_STR("sqref", element->sqref);
+
+    lxw_xml_start_tag(self->file, "conditionalFormatting", &attributes);
+
+    STAILQ_FOREACH(cond_format, element->cond_formats, list_pointers) {
+        /* Write the cfRule element. */
+        _worksheet_write_cf_rule(self, cond_format);
+    }
+
+    lxw_xml_end_tag(self->file, "conditionalFormatting");
+
+    LXW_FREE_ATTRIBUTES();
+}
+
+/*
+ * Write the conditional formatting> elements.
+ */
+STATIC void
+_worksheet_write_conditional_formats(lxw_worksheet *self)
+{
+    lxw_cond_format_hash_element *element;
+    lxw_cond_format_hash_element *next_element;
+
+    for (element = RB_MIN(lxw_cond_format_hash, self->conditional_formats);
+         element; element = next_element) {
+
+        _worksheet_write_conditional_formatting(self, element);
+
+        next_element =
+            RB_NEXT(lxw_cond_format_hash, self->conditional_formats, element);
+    }
+}
+
+/*
+ * Write the <x14:xxxColor> elements for data bar conditional formats.
+ */
+STATIC void
+_worksheet_write_x14_color(lxw_worksheet *self, char *type, lxw_color_t color)
+{
+    struct xml_attribute_list attributes;
+    struct xml_attribute *attribute;
+    char rgb[LXW_ATTR_32];
+
+    lxw_snprintf(rgb, LXW_ATTR_32, "FF%06X", color & LXW_COLOR_MASK);
+
+    LXW_INIT_ATTRIBUTES();
+    LXW_PUSH_ATTRIBUTES_STR("rgb", rgb);
+    lxw_xml_empty_tag(self->file, type, &attributes);
+
+    LXW_FREE_ATTRIBUTES();
+}
+
+/*
+ * Write the <x14:cfvo> element.
+ */
+STATIC void
+_worksheet_write_x14_cfvo(lxw_worksheet *self, uint8_t rule_type,
+                          double number, char *string)
+{
+    struct xml_attribute_list attributes;
+    struct xml_attribute *attribute;
+    char data[LXW_ATTR_32];
+    uint8_t has_value = LXW_FALSE;
+
+    LXW_INIT_ATTRIBUTES();
+
+    if (!string)
+        lxw_sprintf_dbl(data, number);
+
+    if (rule_type == LXW_CONDITIONAL_RULE_TYPE_AUTO_MIN) {
+        LXW_PUSH_ATTRIBUTES_STR("type", "autoMin");
+        has_value = LXW_FALSE;
+    }
+    else if (rule_type == LXW_CONDITIONAL_RULE_TYPE_MINIMUM) {
+        LXW_PUSH_ATTRIBUTES_STR("type", "min");
+        has_value = LXW_FALSE;
+    }
+    else if (rule_type == LXW_CONDITIONAL_RULE_TYPE_NUMBER) {
+        LXW_PUSH_ATTRIBUTES_STR("type", "num");
+        has_value = LXW_TRUE;
+    }
+    else if (rule_type == LXW_CONDITIONAL_RULE_TYPE_PERCENT) {
+        LXW_PUSH_ATTRIBUTES_STR("type", "percent");
+        has_value = LXW_TRUE;
+    }
+    else if (rule_type == LXW_CONDITIONAL_RULE_TYPE_PERCENTILE) {
+        LXW_PUSH_ATTRIBUTES_STR("type", "percentile");
+        has_value = LXW_TRUE;
+    }
+    else if (rule_type == LXW_CONDITIONAL_RULE_TYPE_FORMULA) {
+        LXW_PUSH_ATTRIBUTES_STR("type", "formula");
+        has_value = LXW_TRUE;
+    }
+    else if (rule_type == LXW_CONDITIONAL_RULE_TYPE_MAXIMUM) {
+        LXW_PUSH_ATTRIBUTES_STR("type", "max");
+        has_value = LXW_FALSE;
+    }
+    else if (rule_type == LXW_CONDITIONAL_RULE_TYPE_AUTO_MAX) {
+        LXW_PUSH_ATTRIBUTES_STR("type", "autoMax");
+        has_value = LXW_FALSE;
+    }
+
+    if (has_value) {
+        lxw_xml_start_tag(self->file, "x14:cfvo", &attributes);
+
+        if (string)
+            lxw_xml_data_element(self->file, "xm:f", string, NULL);
+        else
+            lxw_xml_data_element(self->file, "xm:f", data, NULL);
+
+        lxw_xml_end_tag(self->file, "x14:cfvo");
+    }
+    else {
+        lxw_xml_empty_tag(self->file, "x14:cfvo", &attributes);
+    }
+    LXW_FREE_ATTRIBUTES();
+}
+
+/*
+ * Write the <x14:dataBar> element.
+ */
+STATIC void
+_worksheet_write_x14_data_bar(lxw_worksheet *self,
+                              lxw_cond_format_obj *cond_format)
+{
+    struct xml_attribute_list attributes;
+    struct xml_attribute *attribute;
+    char min_length[] = "0";
+    char max_length[] = "100";
+    char border[] = "1";
+
+    LXW_INIT_ATTRIBUTES();
+    LXW_PUSH_ATTRIBUTES_STR("minLength", min_length);
+    LXW_PUSH_ATTRIBUTES_STR("maxLength", max_length);
+
+    if (!cond_format->bar_no_border)
+        LXW_PUSH_ATTRIBUTES_STR("border", border);
+
+    if (cond_format->bar_solid)
+        LXW_PUSH_ATTRIBUTES_STR("gradient", "0");
+
+    if (cond_format->bar_direction ==
+        LXW_CONDITIONAL_BAR_DIRECTION_RIGHT_TO_LEFT)
+        LXW_PUSH_ATTRIBUTES_STR("direction", "rightToLeft");
+
+    if (cond_format->bar_direction ==
+        LXW_CONDITIONAL_BAR_DIRECTION_LEFT_TO_RIGHT)
+        LXW_PUSH_ATTRIBUTES_STR("direction", "leftToRight");
+
+    if (cond_format->bar_negative_color_same)
+        LXW_PUSH_ATTRIBUTES_STR("negativeBarColorSameAsPositive", "1");
+
+    if (!cond_format->bar_no_border
+        && !cond_format->bar_negative_border_color_same)
+        LXW_PUSH_ATTRIBUTES_STR("negativeBarBorderColorSameAsPositive", "0");
+
+    if (cond_format->bar_axis_position == LXW_CONDITIONAL_BAR_AXIS_MIDPOINT)
+        LXW_PUSH_ATTRIBUTES_STR("axisPosition", "middle");
+
+    if (cond_format->bar_axis_position == LXW_CONDITIONAL_BAR_AXIS_NONE)
+        LXW_PUSH_ATTRIBUTES_STR("axisPosition", "none");
+
+    lxw_xml_start_tag(self->file, "x14:dataBar", &attributes);
+
+    if (cond_format->auto_min)
+        cond_format->min_rule_type = LXW_CONDITIONAL_RULE_TYPE_AUTO_MIN;
+
+    _worksheet_write_x14_cfvo(self, cond_format->min_rule_type,
+                              cond_format->min_value,
+                              cond_format->min_value_string);
+
+    if (cond_format->auto_max)
+        cond_format->max_rule_type = LXW_CONDITIONAL_RULE_TYPE_AUTO_MAX;
+
+    _worksheet_write_x14_cfvo(self, cond_format->max_rule_type,
+                              cond_format->max_value,
+                              cond_format->max_value_string);
+
+    if (!cond_format->bar_no_border)
+        _worksheet_write_x14_color(self, "x14:borderColor",
+                                   cond_format->bar_border_color);
+
+    if (!cond_format->bar_negative_color_same)
+        _worksheet_write_x14_color(self, "x14:negativeFillColor",
+                                   cond_format->bar_negative_color);
+
+    if (!cond_format->bar_no_border
+        && !cond_format->bar_negative_border_color_same)
+        _worksheet_write_x14_color(self, "x14:negativeBorderColor",
+                                   cond_format->bar_negative_border_color);
+
+    if (cond_format->bar_axis_position != LXW_CONDITIONAL_BAR_AXIS_NONE)
+        _worksheet_write_x14_color(self, "x14:axisColor",
+                                   cond_format->bar_axis_color);
+
+    LXW_FREE_ATTRIBUTES();
+}
+
+/*
+ * Write the <x14:cfRule> element.
+ */
+STATIC void
+_worksheet_write_x14_cf_rule(lxw_worksheet *self,
+                             lxw_cond_format_obj *cond_format)
+{
+    struct xml_attribute_list attributes;
+    struct xml_attribute *attribute;
+
+    LXW_INIT_ATTRIBUTES();
+    LXW_PUSH_ATTRIBUTES_STR("type", "dataBar");
+    LXW_PUSH_ATTRIBUTES_STR("id", cond_format->guid);
+
+    lxw_xml_start_tag(self->file, "x14:cfRule", &attributes);
+
+    /* Write the x14:dataBar element. */
+    _worksheet_write_x14_data_bar(self, cond_format);
+
+    LXW_FREE_ATTRIBUTES();
+}
+
+/*
+ * Write the <xm:sqref> element.
+ */
+STATIC void
+_worksheet_write_xm_sqref(lxw_worksheet *self,
+                          lxw_cond_format_obj *cond_format)
+{
+    lxw_xml_data_element(self->file, "xm:sqref", cond_format->sqref, NULL);
+}
+
+/*
+ * Write the <conditionalFormatting> element.
+ */
+STATIC void
+_worksheet_write_conditional_formatting_2010(lxw_worksheet *self, lxw_cond_format_hash_element
+                                             *element)
+{
+    struct xml_attribute_list attributes;
+    struct xml_attribute *attribute;
+    lxw_cond_format_obj *cond_format;
+
+    LXW_INIT_ATTRIBUTES();
+    LXW_PUSH_ATTRIBUTES_STR("xmlns:xm",
+                            "http://schemas.microsoft.com/office/excel/2006/main");
+
+    STAILQ_FOREACH(cond_format, element->cond_formats, list_pointers) {
+        if (!cond_format->data_bar_2010)
+            continue;
+
+        lxw_xml_start_tag(self->file, "x14:conditionalFormatting",
+                          &attributes);
+
+        _worksheet_write_x14_cf_rule(self, cond_format);
+
+        lxw_xml_end_tag(self->file, "x14:dataBar");
+        lxw_xml_end_tag(self->file, "x14:cfRule");
+        _worksheet_write_xm_sqref(self, cond_format);
+        lxw_xml_end_tag(self->file, "x14:conditionalFormatting");
+    }
+
+    LXW_FREE_ATTRIBUTES();
+}
+
+/*
+ * Write the <extLst> element for Excel 2010 conditional formatting data bars.
+ */
+STATIC void
+_worksheet_write_ext_list_data_bars(lxw_worksheet *self)
+{
+    lxw_cond_format_hash_element *element;
+    lxw_cond_format_hash_element *next_element;
+
+    _worksheet_write_ext(self, "{78C0D931-6437-407d-A8EE-F0AAD7539E65}");
+    lxw_xml_start_tag(self->file, "x14:conditionalFormattings", NULL);
+
+    for (element = RB_MIN(lxw_cond_format_hash, self->conditional_formats);
+         element; element = next_element) {
+
+        _worksheet_write_conditional_formatting_2010(self, element);
+
+        next_element =
+            RB_NEXT(lxw_cond_format_hash, self->conditional_formats, element);
+    }
+
+    lxw_xml_end_tag(self->file, "x14:conditionalFormattings");
+    lxw_xml_end_tag(self->file, "ext");
+}
+
+/*
+ * Write the <extLst> element.
+ */
+STATIC void
+_worksheet_write_ext_list(lxw_worksheet *self)
+{
+    if (self->data_bar_2010_index == 0)
+        return;
+
+    lxw_xml_start_tag(self->file, "extLst", NULL);
+
+    _worksheet_write_ext_list_data_bars(self);
+
+    lxw_xml_end_tag(self->file, "extLst");
+}
+
+/*
+ * Write the <ignoredError> element.
+ */
+STATIC void
+_worksheet_write_ignored_error(lxw_worksheet *self, char *ignore_error,
+                               char *range)
+{
+    struct xml_attribute_list attributes;
+    struct xml_attribute *attribute;
+
+    LXW_INIT_ATTRIBUTES();
+    LXW_PUSH_ATTRIBUTES_STR("sqref", range);
+    LXW_PUSH_ATTRIBUTES_STR(ignore_error, "1");
+
+    lxw_xml_empty_tag(self->file, "ignoredError", &attributes);
+
+    LXW_FREE_ATTRIBUTES();
+}
+
+lxw_error
+_validate_conditional_icons(lxw_conditional_format *user)
+{
+    if (user->icon_style > LXW_CONDITIONAL_ICONS_5_QUARTERS) {
+
+        LXW_WARN_FORMAT1("worksheet_conditional_format_cell()/_range(): "
+                         "For type = LXW_CONDITIONAL_TYPE_ICON_SETS, "
+                         "invalid icon_style (%d).", user->icon_style);
+
+        return LXW_ERROR_PARAMETER_VALIDATION;
+    }
+    else {
+        return LXW_NO_ERROR;
+    }
+}
+
+lxw_error
+_validate_conditional_data_bar(lxw_worksheet *self,
+                               lxw_cond_format_obj *cond_format,
+                               lxw_conditional_format *user_options)
+{
+    uint8_t min_rule_type = user_options->min_rule_type;
+    uint8_t max_rule_type = user_options->max_rule_type;
+
+    if (user_options->data_bar_2010
+        || user_options->bar_solid
+        || user_options->bar_no_border
+        || user_options->bar_direction
+        || user_options->bar_axis_position
+        || user_options->bar_negative_color_same
+        || user_options->bar_negative_border_color_same
+        || user_options->bar_negative_color
+        || user_options->bar_border_color
+        || user_options->bar_negative_border_color
+        || user_options->bar_axis_color) {
+
+        cond_format->data_bar_2010 = LXW_TRUE;
+        self->excel_version = 2010;
+    }
+
+    if (min_rule_type > LXW_CONDITIONAL_RULE_TYPE_MINIMUM
+        && min_rule_type < LXW_CONDITIONAL_RULE_TYPE_MAXIMUM) {
+        cond_format->min_rule_type = min_rule_type;
+        cond_format->min_value = user_options->min_value;
+        cond_format->min_value_string =
+            lxw_strdup_formula(user_options->min_value_string);
+    }
+    else {
+        cond_format->min_rule_type = LXW_CONDITIONAL_RULE_TYPE_MINIMUM;
+        cond_format->min_value = 0;
+    }
+
+    if (max_rule_type > LXW_CONDITIONAL_RULE_TYPE_MINIMUM
+        && max_rule_type < LXW_CONDITIONAL_RULE_TYPE_MAXIMUM) {
+        cond_format->max_rule_type = max_rule_type;
+        cond_format->max_value = user_options->max_value;
+        cond_format->max_value_string =
+            lxw_strdup_formula(user_options->max_value_string);
+    }
+    else {
+        cond_format->max_rule_type = LXW_CONDITIONAL_RULE_TYPE_MAXIMUM;
+        cond_format->max_value = 0;
+    }
+
+    if (cond_format->data_bar_2010) {
+        if (min_rule_type == LXW_CONDITIONAL_RULE_TYPE_NONE)
+            cond_format->auto_min = LXW_TRUE;
+        if (max_rule_type == LXW_CONDITIONAL_RULE_TYPE_NONE)
+            cond_format->auto_max = LXW_TRUE;
+    }
+
+    cond_format->bar_only = user_options->bar_only;
+    cond_format->bar_solid = user_options->bar_solid;
+    cond_format->bar_no_border = user_options->bar_no_border;
+    cond_format->bar_direction = user_options->bar_direction;
+    cond_format->bar_axis_position = user_options->bar_axis_position;
+    cond_format->bar_negative_color_same =
+        user_options->bar_negative_color_same;
+    cond_format->bar_negative_border_color_same =
+        user_options->bar_negative_border_color_same;
+
+    if (user_options->bar_color != LXW_COLOR_UNSET)
+        cond_format->bar_color = user_options->bar_color;
+    else
+        cond_format->bar_color = 0x638EC6;
+
+    if (user_options->bar_negative_color != LXW_COLOR_UNSET)
+        cond_format->bar_negative_color = user_options->bar_negative_color;
+    else
+        cond_format->bar_negative_color = 0xFF0000;
+
+    if (user_options->bar_border_color != LXW_COLOR_UNSET)
+        cond_format->bar_border_color = user_options->bar_border_color;
+    else
+        cond_format->bar_border_color = cond_format->bar_color;
+
+    if (user_options->bar_negative_border_color != LXW_COLOR_UNSET)
+        cond_format->bar_negative_border_color =
+            user_options->bar_negative_border_color;
+    else
+        cond_format->bar_negative_border_color = 0xFF0000;
+
+    if (user_options->bar_axis_color != LXW_COLOR_UNSET)
+        cond_format->bar_axis_color = user_options->bar_axis_color;
+    else
+        cond_format->bar_axis_color = 0x000000;
+
+    return LXW_NO_ERROR;
+}
+
+lxw_error
+_validate_conditional_scale(lxw_cond_format_obj *cond_format,
+                            lxw_conditional_format *user_options)
+{
+    uint8_t min_rule_type = user_options->min_rule_type;
+    uint8_t mid_rule_type = user_options->mid_rule_type;
+    uint8_t max_rule_type = user_options->max_rule_type;
+
+    if (min_rule_type > LXW_CONDITIONAL_RULE_TYPE_MINIMUM
+        && min_rule_type < LXW_CONDITIONAL_RULE_TYPE_MAXIMUM) {
+        cond_format->min_rule_type = min_rule_type;
+        cond_format->min_value = user_options->min_value;
+        cond_format->min_value_string =
+            lxw_strdup_formula(user_options->min_value_string);
+    }
+    else {
+        cond_format->min_rule_type = LXW_CONDITIONAL_RULE_TYPE_MINIMUM;
+        cond_format->min_value = 0;
+    }
+
+    if (max_rule_type > LXW_CONDITIONAL_RULE_TYPE_MINIMUM
+        && max_rule_type < LXW_CONDITIONAL_RULE_TYPE_MAXIMUM) {
+        cond_format->max_rule_type = max_rule_type;
+        cond_format->max_value = user_options->max_value;
+        cond_format->max_value_string =
+            lxw_strdup_formula(user_options->max_value_string);
+    }
+    else {
+        cond_format->max_rule_type = LXW_CONDITIONAL_RULE_TYPE_MAXIMUM;
+        cond_format->max_value = 0;
+    }
+
+    if (cond_format->type == LXW_CONDITIONAL_3_COLOR_SCALE) {
+        if (mid_rule_type > LXW_CONDITIONAL_RULE_TYPE_MINIMUM
+            && mid_rule_type < LXW_CONDITIONAL_RULE_TYPE_MAXIMUM) {
+            cond_format->mid_rule_type = mid_rule_type;
+            cond_format->mid_value = user_options->mid_value;
+            cond_format->mid_value_string =
+                lxw_strdup_formula(user_options->mid_value_string);
+        }
+        else {
+            cond_format->mid_rule_type = LXW_CONDITIONAL_RULE_TYPE_PERCENTILE;
+            cond_format->mid_value = 50;
+        }
+    }
+
+    if (user_options->min_color != LXW_COLOR_UNSET)
+        cond_format->min_color = user_options->min_color;
+    else
+        cond_format->min_color = 0xFF7128;
+
+    if (user_options->max_color != LXW_COLOR_UNSET)
+        cond_format->max_color = user_options->max_color;
+    else
+        cond_format->max_color = 0xFFEF9C;
+
+    if (cond_format->type == LXW_CONDITIONAL_3_COLOR_SCALE) {
+        if (user_options->min_color == LXW_COLOR_UNSET)
+            cond_format->min_color = 0xF8696B;
+
+        if (user_options->mid_color != LXW_COLOR_UNSET)
+            cond_format->mid_color = user_options->mid_color;
+        else
+            cond_format->mid_color = 0xFFEB84;
+
+        if (user_options->max_color == LXW_COLOR_UNSET)
+            cond_format->max_color = 0x63BE7B;
+    }
+
+    return LXW_NO_ERROR;
+}
+
+lxw_error
+_validate_conditional_top(lxw_cond_format_obj *cond_format,
+                          lxw_conditional_format *user_options)
+{
+    /* Restrict the range of rank values to Excel's allowed range. */
+    if (user_options->criteria ==
+        LXW_CONDITIONAL_CRITERIA_TOP_OR_BOTTOM_PERCENT) {
+        if (user_options->value < 0.0 || user_options->value > 100.0) {
+
+            LXW_WARN_FORMAT1("worksheet_conditional_format_cell()/_range(): "
+                             "For type = LXW_CONDITIONAL_TYPE_TOP/BOTTOM, "
+                             "top/bottom percent (%g%%) must by in range 0-100",
+                             user_options->value);
+
+            return LXW_ERROR_PARAMETER_VALIDATION;
+        }
+    }
+    else {
+        if (user_options->value < 1.0 || user_options->value > 1000.0) {
+
+            LXW_WARN_FORMAT1("worksheet_conditional_format_cell()/_range(): "
+                             "For type = LXW_CONDITIONAL_TYPE_TOP/BOTTOM, "
+                             "top/bottom items (%g) must by in range 1-1000",
+                             user_options->value);
+
+            return LXW_ERROR_PARAMETER_VALIDATION;
+        }
+    }
+
+    cond_format->min_value = (uint16_t) user_options->value;
+
+    return LXW_NO_ERROR;
+}
+
+lxw_error
+_validate_conditional_average(lxw_conditional_format *user)
+{
+    if (user->criteria < LXW_CONDITIONAL_CRITERIA_AVERAGE_ABOVE ||
+        user->criteria > LXW_CONDITIONAL_CRITERIA_AVERAGE_3_STD_DEV_BELOW) {
+
+        LXW_WARN_FORMAT1("worksheet_conditional_format_cell()/_range(): "
+                         "For type = LXW_CONDITIONAL_TYPE_AVERAGE, "
+                         "invalid criteria value (%d).", user->criteria);
+
+        return LXW_ERROR_PARAMETER_VALIDATION;
+    }
+    else {
+        return LXW_NO_ERROR;
+    }
+}
+
+lxw_error
+_validate_conditional_time_period(lxw_conditional_format *user)
+{
+    if (user->criteria < LXW_CONDITIONAL_CRITERIA_TIME_PERIOD_YESTERDAY ||
+        user->criteria > LXW_CONDITIONAL_CRITERIA_TIME_PERIOD_NEXT_MONTH) {
+
+        LXW_WARN_FORMAT1("worksheet_conditional_format_cell()/_range(): "
+                         "For type = LXW_CONDITIONAL_TYPE_TIME_PERIOD, "
+                         "invalid criteria value (%d).", user->criteria);
+
+        return LXW_ERROR_PARAMETER_VALIDATION;
+    }
+    else {
+        return LXW_NO_ERROR;
+    }
+}
+
+lxw_error
+_validate_conditional_text(lxw_cond_format_obj *cond_format,
+                           lxw_conditional_format *user_options)
+{
+    if (!user_options->value_string) {
+
+        LXW_WARN_FORMAT("worksheet_conditional_format_cell()/_range(): "
+                        "For type = LXW_CONDITIONAL_TYPE_TEXT, "
+                        "value_string can not be NULL. "
+                        "Text must be specified.");
+
+        return LXW_ERROR_PARAMETER_VALIDATION;
+    }
+
+    if (strlen(user_options->value_string) >= LXW_MAX_ATTRIBUTE_LENGTH) {
+
+        LXW_WARN_FORMAT2("worksheet_conditional_format_cell()/_range(): "
+                         "For type = LXW_CONDITIONAL_TYPE_TEXT, "
+                         "value_string length (%d) must be less than %d.",
+                         (uint16_t) strlen(user_options->value_string),
+                         LXW_MAX_ATTRIBUTE_LENGTH);
+
+        return LXW_ERROR_PARAMETER_VALIDATION;
+    }
+
+    if (user_options->criteria < LXW_CONDITIONAL_CRITERIA_TEXT_CONTAINING ||
+        user_options->criteria > LXW_CONDITIONAL_CRITERIA_TEXT_ENDS_WITH) {
+
+        LXW_WARN_FORMAT1("worksheet_conditional_format_cell()/_range(): "
+                         "For type = LXW_CONDITIONAL_TYPE_TEXT, "
+                         "invalid criteria value (%d).",
+                         user_options->criteria);
+
+        return LXW_ERROR_PARAMETER_VALIDATION;
+    }
+
+    cond_format->min_value_string =
+        lxw_strdup_formula(user_options->value_string);
+
+    return LXW_NO_ERROR;
+}
+
+lxw_error
+_validate_conditional_formula(lxw_cond_format_obj *cond_format,
+                              lxw_conditional_format *user_options)
+{
+    if (!user_options->value_string) {
+
+        LXW_WARN_FORMAT("worksheet_conditional_format_cell()/_range(): "
+                        "For type = LXW_CONDITIONAL_TYPE_FORMULA, "
+                        "value_string can not be NULL. "
+                        "Formula must be specified.");
+
+        return LXW_ERROR_PARAMETER_VALIDATION;
+    }
+
+    cond_format->min_value_string =
+        lxw_strdup_formula(user_options->value_string);
+
+    return LXW_NO_ERROR;
+}
+
+lxw_error
+_validate_conditional_cell(lxw_cond_format_obj *cond_format,
+                           lxw_conditional_format *user_options)
+{
+    cond_format->min_value = user_options->value;
+    cond_format->min_value_string =
+        lxw_strdup_formula(user_options->value_string);
+
+    if (cond_format->criteria == LXW_CONDITIONAL_CRITERIA_BETWEEN
+        || cond_format->criteria == LXW_CONDITIONAL_CRITERIA_NOT_BETWEEN) {
+        cond_format->has_max = LXW_TRUE;
+        cond_format->min_value = user_options->min_value;
+        cond_format->max_value = user_options->max_value;
+        cond_format->min_value_string =
+            lxw_strdup_formula(user_options->min_value_string);
+        cond_format->max_value_string =
+            lxw_strdup_formula(user_options->max_value_string);
+    }
+
+    return LXW_NO_ERROR;
+}
+
+/* Check that the correct criteria and used with the correct conditional format. */
+lxw_error
+_validate_conditional_criteria(lxw_cond_format_obj *cond_format)
+{
+    uint8_t criteria_mismatch = LXW_FALSE;
+
+    if (cond_format->type == LXW_CONDITIONAL_TYPE_CELL) {
+        switch (cond_format->criteria) {
+            case LXW_CONDITIONAL_CRITERIA_EQUAL_TO:
+            case LXW_CONDITIONAL_CRITERIA_NOT_EQUAL_TO:
+            case LXW_CONDITIONAL_CRITERIA_GREATER_THAN:
+            case LXW_CONDITIONAL_CRITERIA_LESS_THAN:
+            case LXW_CONDITIONAL_CRITERIA_GREATER_THAN_OR_EQUAL_TO:
+            case LXW_CONDITIONAL_CRITERIA_LESS_THAN_OR_EQUAL_TO:
+            case LXW_CONDITIONAL_CRITERIA_BETWEEN:
+            case LXW_CONDITIONAL_CRITERIA_NOT_BETWEEN:
+                criteria_mismatch = LXW_FALSE;
+                break;
+            default:
+                criteria_mismatch = LXW_TRUE;
+        }
+    }
+    else if (cond_format->type == LXW_CONDITIONAL_TYPE_TIME_PERIOD) {
+        switch (cond_format->criteria) {
+            case LXW_CONDITIONAL_CRITERIA_TIME_PERIOD_YESTERDAY:
+            case LXW_CONDITIONAL_CRITERIA_TIME_PERIOD_TODAY:
+            case LXW_CONDITIONAL_CRITERIA_TIME_PERIOD_TOMORROW:
+            case LXW_CONDITIONAL_CRITERIA_TIME_PERIOD_LAST_7_DAYS:
+            case LXW_CONDITIONAL_CRITERIA_TIME_PERIOD_LAST_WEEK:
+            case LXW_CONDITIONAL_CRITERIA_TIME_PERIOD_THIS_WEEK:
+            case LXW_CONDITIONAL_CRITERIA_TIME_PERIOD_NEXT_WEEK:
+            case LXW_CONDITIONAL_CRITERIA_TIME_PERIOD_LAST_MONTH:
+            case LXW_CONDITIONAL_CRITERIA_TIME_PERIOD_THIS_MONTH:
+            case LXW_CONDITIONAL_CRITERIA_TIME_PERIOD_NEXT_MONTH:
+                criteria_mismatch = LXW_FALSE;
+                break;
+            default:
+                criteria_mismatch = LXW_TRUE;
+        }
+    }
+    else if (cond_format->type == LXW_CONDITIONAL_TYPE_TEXT) {
+        switch (cond_format->criteria) {
+            case LXW_CONDITIONAL_CRITERIA_TEXT_CONTAINING:
+            case LXW_CONDITIONAL_CRITERIA_TEXT_NOT_CONTAINING:
+            case LXW_CONDITIONAL_CRITERIA_TEXT_BEGINS_WITH:
+            case LXW_CONDITIONAL_CRITERIA_TEXT_ENDS_WITH:
+                criteria_mismatch = LXW_FALSE;
+                break;
+            default:
+                criteria_mismatch = LXW_TRUE;
+        }
+    }
+    else if (cond_format->type == LXW_CONDITIONAL_TYPE_AVERAGE) {
+        switch (cond_format->criteria) {
+            case LXW_CONDITIONAL_CRITERIA_AVERAGE_ABOVE:
+            case LXW_CONDITIONAL_CRITERIA_AVERAGE_BELOW:
+            case LXW_CONDITIONAL_CRITERIA_AVERAGE_ABOVE_OR_EQUAL:
+            case LXW_CONDITIONAL_CRITERIA_AVERAGE_BELOW_OR_EQUAL:
+            case LXW_CONDITIONAL_CRITERIA_AVERAGE_1_STD_DEV_ABOVE:
+            case LXW_CONDITIONAL_CRITERIA_AVERAGE_1_STD_DEV_BELOW:
+            case LXW_CONDITIONAL_CRITERIA_AVERAGE_2_STD_DEV_ABOVE:
+            case LXW_CONDITIONAL_CRITERIA_AVERAGE_2_STD_DEV_BELOW:
+            case LXW_CONDITIONAL_CRITERIA_AVERAGE_3_STD_DEV_ABOVE:
+            case LXW_CONDITIONAL_CRITERIA_AVERAGE_3_STD_DEV_BELOW:
+                criteria_mismatch = LXW_FALSE;
+                break;
+            default:
+                criteria_mismatch = LXW_TRUE;
+        }
+    }
+    else if (cond_format->type == LXW_CONDITIONAL_TYPE_TOP
+             || cond_format->type == LXW_CONDITIONAL_TYPE_BOTTOM) {
+        switch (cond_format->criteria) {
+            case LXW_CONDITIONAL_CRITERIA_NONE:
+            case LXW_CONDITIONAL_CRITERIA_TOP_OR_BOTTOM_PERCENT:
+                criteria_mismatch = LXW_FALSE;
+                break;
+            default:
+                criteria_mismatch = LXW_TRUE;
+        }
+    }
+    else {
+        /* Any other conditional type should have a zero criteria. */
+        cond_format->criteria = LXW_CONDITIONAL_CRITERIA_NONE;
+    }
+
+    if (criteria_mismatch) {
+        LXW_WARN_FORMAT2("worksheet_conditional_format_cell()/_range(): "
+                         "LXW_CONDITIONAL_CRITERIA_* = %d is not valid for "
+                         "LXW_CONDITIONAL_TYPE_* = %d", cond_format->criteria,
+                         cond_format->type);
+
+        return LXW_ERROR_PARAMETER_VALIDATION;
+    }
+    else {
+        return LXW_NO_ERROR;
+    }
+}
+
+/*
+ * Write the <ignoredErrors> element.
+ */
+STATIC void
+_worksheet_write_ignored_errors(lxw_worksheet *self)
+{
+    if (!self->has_ignore_errors)
+        return;
+
+    lxw_xml_start_tag(self->file, "ignoredErrors", NULL);
+
+    if (self->ignore_number_stored_as_text) {
+        _worksheet_write_ignored_error(self, "numberStoredAsText",
+                                       self->ignore_number_stored_as_text);
+    }
+
+    if (self->ignore_eval_error) {
+        _worksheet_write_ignored_error(self, "evalError",
+                                       self->ignore_eval_error);
+    }
+
+    if (self->ignore_formula_differs) {
+        _worksheet_write_ignored_error(self, "formula",
+                                       self->ignore_formula_differs);
+    }
+
+    if (self->ignore_formula_range) {
+        _worksheet_write_ignored_error(self, "formulaRange",
+                                       self->ignore_formula_range);
+    }
+
+    if (self->ignore_formula_unlocked) {
+        _worksheet_write_ignored_error(self, "unlockedFormula",
+                                       self->ignore_formula_unlocked);
+    }
+
+    if (self->ignore_empty_cell_reference) {
+        _worksheet_write_ignored_error(self, "emptyCellReference",
+                                       self->ignore_empty_cell_reference);
+    }
+
+    if (self->ignore_list_data_validation) {
+        _worksheet_write_ignored_error(self, "listDataValidation",
+                                       self->ignore_list_data_validation);
+    }
+
+    if (self->ignore_calculated_column) {
+        _worksheet_write_ignored_error(self, "calculatedColumn",
+                                       self->ignore_calculated_column);
+    }
+
+    if (self->ignore_two_digit_text_year) {
+        _worksheet_write_ignored_error(self, "twoDigitTextYear",
+                                       self->ignore_two_digit_text_year);
+    }
+
+    lxw_xml_end_tag(self->file, "ignoredErrors");
+}
+
+/*
+ * Write the <tablePart> element.
+ */
+STATIC void
+_worksheet_write_table_part(lxw_worksheet *self, uint16_t id)
+{
+    struct xml_attribute_list attributes;
+    struct xml_attribute *attribute;
+    char r_id[LXW_MAX_ATTRIBUTE_LENGTH];
+
+    lxw_snprintf(r_id, LXW_ATTR_32, "rId%d", id);
+
+    LXW_INIT_ATTRIBUTES();
+    LXW_PUSH_ATTRIBUTES_STR("r:id", r_id);
+
+    lxw_xml_empty_tag(self->file, "tablePart", &attributes);
+
+    LXW_FREE_ATTRIBUTES();
+}
+
+/*
+ * Write the <tableParts> element.
+ */
+STATIC void
+_worksheet_write_table_parts(lxw_worksheet *self)
+{
+    struct xml_attribute_list attributes;
+    struct xml_attribute *attribute;
+    lxw_table_obj *table_obj;
+
+    if (!self->table_count)
+        return;
+
+    LXW_INIT_ATTRIBUTES();
+    LXW_PUSH_ATTRIBUTES_INT("count", self->table_count);
+
+    lxw_xml_start_tag(self->file, "tableParts", &attributes);
+
+    STAILQ_FOREACH(table_obj, self->table_objs, list_pointers) {
+        self->rel_count++;
+
+        /* Write the tablePart element. */
+        _worksheet_write_table_part(self, self->rel_count);
+    }
+
+    lxw_xml_end_tag(self->file, "tableParts");
+
+    LXW_FREE_ATTRIBUTES();
+}
+
+/*
+ * External functions to call intern XML methods shared with chartsheet.
+ */
+void
+lxw_worksheet_write_sheet_views(lxw_worksheet *self)
+{
+    _worksheet_write_sheet_views(self);
+}
+
+void
+lxw_worksheet_write_page_margins(lxw_worksheet *self)
+{
+    _worksheet_write_page_margins(self);
+}
+
+void
+lxw_worksheet_write_drawings(lxw_worksheet *self)
+{
+    _worksheet_write_drawings(self);
+}
+
+void
+lxw_worksheet_write_sheet_protection(lxw_worksheet *self,
+                                     lxw_protection_obj *protect)
+{
+    _worksheet_write_sheet_protection(self, protect);
+}
+
+void
+lxw_worksheet_write_sheet_pr(lxw_worksheet *self)
+{
+    _worksheet_write_sheet_pr(self);
+}
+
+void
+lxw_worksheet_write_page_setup(lxw_worksheet *self)
+{
+    _worksheet_write_page_setup(self);
+}
+
+void
+lxw_worksheet_write_header_footer(lxw_worksheet *self)
+{
+    _worksheet_write_header_footer(self);
+}
+
+/*
+ * Assemble and write the XML file.
+ */
+void
+lxw_worksheet_assemble_xml_file(lxw_worksheet *self)
+{
+    /* Flush any segments and merge their dimensions. */
+    lxw_worksheet_close_segments(self);
+
+    /* Write the XML declaration. */
+    _worksheet_xml_declaration(self);
+
+    /* Write the worksheet element. */
+    _worksheet_write_worksheet(self);
+
+    /* Write the worksheet properties. */
+    _worksheet_write_sheet_pr(self);
+
+    /* Write the worksheet dimensions. */
+    _worksheet_write_dimension(self);
+
+    /* Write the sheet view properties. */
+    _worksheet_write_sheet_views(self);
+
+    /* Write the sheet format properties. */
+    _worksheet_write_sheet_format_pr(self);
+
+    /* Write the sheet column info. */
+    _worksheet_write_cols(self);
+
+    /* Write the sheetData element. */
+    if (!self->optimize)
+        _worksheet_write_sheet_data(self);
+    else
+        _worksheet_write_optimized_sheet_data(self);
+
+    /* Write the sheetProtection element. */
+    _worksheet_write_sheet_protection(self, &self->protection);
+
+    /* Write the autoFilter element. */
+    _worksheet_write_auto_filter(self);
+
+    /* Write the mergeCells element. */
+    _worksheet_write_merge_cells(self);
+
+    /* Write the conditionalFormatting elements. */
+    _worksheet_write_conditional_formats(self);
+
+    /* Write the dataValidations element. */
+    _worksheet_write_data_validations(self);
+
+    /* Write the hyperlink element. */
+    _worksheet_write_hyperlinks(self);
+
+    /* Write the printOptions element. */
+    _worksheet_write_print_options(self);
+
+    /* Write the worksheet page_margins. */
+    _worksheet_write_page_margins(self);
+
+    /* Write the worksheet page setup. */
+    _worksheet_write_page_setup(self);
+
+    /* Write the headerFooter element. */
+    _worksheet_write_header_footer(self);
+
+    /* Write the rowBreaks element. */
+    _worksheet_write_row_breaks(self);
+
+    /* Write the colBreaks element. */
+    _worksheet_write_col_breaks(self);
+
+    /* Write the ignoredErrors element. */
+    _worksheet_write_ignored_errors(self);
+
+    /* Write the drawing element. */
+    _worksheet_write_drawings(self);
+
+    /* Write the legacyDrawing element. */
+    _worksheet_write_legacy_drawing(self);
+
+    /* Write the legacyDrawingHF element. */
+    _worksheet_write_legacy_drawing_hf(self);
+
+    /* Write the picture element. */
+    _worksheet_write_picture(self);
+
+    /* Write the tableParts element. */
+    _worksheet_write_table_parts(self);
+
+    /* Write the extLst element. */
+    _worksheet_write_ext_list(self);
+
+    /* Close the worksheet tag. */
+    lxw_xml_end_tag(self->file, "worksheet");
+}
+
+/*
+ * Make a copy of a worksheet cell for the header rows of a rollover
+ * worksheet. Strings in the shared string table are counted again.
+ */
+STATIC lxw_cell *
+_clone_cell(lxw_worksheet *self, lxw_cell *cell)
+{
+    lxw_cell *copy = calloc(1, sizeof(lxw_cell));
+    RETURN_ON_MEM_ERROR(copy, NULL);
+
+    copy->row_num = cell->row_num;
+    copy->col_num = cell->col_num;
+    copy->type = cell->type;
+    copy->format = cell->format;
+    copy->formula_result = cell->formula_result;
+    copy->sst_string = cell->sst_string;
+
+    if (_cell_owns_string(cell)) {
+        if (cell->u.string) {
+            copy->u.string = lxw_strdup(cell->u.string);
+            GOTO_LABEL_ON_MEM_ERROR(copy->u.string, mem_error);
+        }
+    }
+    else {
+        copy->u = cell->u;
+    }
+
+    if (cell->user_data1) {
+        copy->user_data1 = lxw_strdup(cell->user_data1);
+        GOTO_LABEL_ON_MEM_ERROR(copy->user_data1, mem_error);
+    }
+
+    if (cell->user_data2) {
+        copy->user_data2 = lxw_strdup(cell->user_data2);
+        GOTO_LABEL_ON_MEM_ERROR(copy->user_data2, mem_error);
+    }
+
+    if (cell->type == STRING_CELL && self->sst)
+        self->sst->string_count++;
+
+    return copy;
+
+mem_error:
+    _free_cell(copy);
+    return NULL;
+}
+
+/*
+ * Copy the column settings and the header rows of a worksheet to a new
+ * rollover worksheet. The header rows are copied before they are written
+ * since writing to the new worksheet can move the cell data of the
+ * worksheet out of memory when the number of resident worksheets is limited.
+ */
+STATIC lxw_error
+_worksheet_copy_rollover_setup(lxw_worksheet *self, lxw_worksheet *next)
+{
+    lxw_col_options *col_options;
+    lxw_row_col_options options;
+    lxw_row *row;
+    lxw_row *rows = NULL;
+    lxw_cell *cell;
+    lxw_cell **cells = NULL;
+    uint32_t num_rows = 0;
+    uint32_t num_cells = 0;
+    uint32_t i;
+    uint32_t j = 0;
+    lxw_col_t col;
+    lxw_error err = LXW_NO_ERROR;
+
+    for (col = 0; col < self->col_options_max; col++) {
+        col_options = self->col_options[col];
+        if (!col_options)
+            continue;
+
+        options.hidden = col_options->hidden;
+        options.level = col_options->level;
+        options.collapsed = col_options->collapsed;
+
+        err = worksheet_set_column_opt(next, col_options->firstcol,
+                                       col_options->lastcol,
+                                       col_options->width,
+                                       col_options->format, &options);
+        if (err)
+            return err;
+    }
+
+    if (!self->rollover_header_rows)
+        return LXW_NO_ERROR;
+
+    _worksheet_use_cells(self);
+
+    RB_FOREACH(row, lxw_table_rows, self->table) {
+        if (row->row_num >= self->rollover_header_rows)
+            break;
+
+        num_rows++;
+
+        RB_FOREACH(cell, lxw_table_cells, row->cells) {
+            num_cells++;
+        }
+    }
+
+    if (!num_rows)
+        return LXW_NO_ERROR;
+
+    rows = calloc(num_rows, sizeof(lxw_row));
+    GOTO_LABEL_ON_MEM_ERROR(rows, mem_error);
+
+    if (num_cells) {
+        cells = calloc(num_cells, sizeof(lxw_cell *));
+        GOTO_LABEL_ON_MEM_ERROR(cells, mem_error);
+    }
+
+    i = 0;
+    RB_FOREACH(row, lxw_table_rows, self->table) {
+        if (row->row_num >= self->rollover_header_rows)
+            break;
+
+        rows[i++] = *row;
+
+        RB_FOREACH(cell, lxw_table_cells, row->cells) {
+            cells[j] = _clone_cell(self, cell);
+            GOTO_LABEL_ON_MEM_ERROR(cells[j], mem_error);
+            j++;
+        }
+    }
+
+    /* Write the rows and cells in order, for constant_memory mode. */
+    j = 0;
+    for (i = 0; i < num_rows; i++) {
+        if (rows[i].row_changed) {
+            options.hidden = rows[i].hidden;
+            options.level = rows[i].level;
+            options.collapsed = rows[i].collapsed;
+
+            err = worksheet_set_row_opt(next, rows[i].row_num,
+                                        rows[i].height, rows[i].format,
+                                        &options);
+            if (err)
+                goto error;
+        }
+
+        while (j < num_cells && cells[j]->row_num == rows[i].row_num) {
+            cell = cells[j];
+
+            err = _check_dimensions(next, cell->row_num, cell->col_num,
+                                    LXW_FALSE, LXW_FALSE);
+            if (err)
+                goto error;
+
+            if (cell->type == DYNAMIC_ARRAY_FORMULA_CELL)
+                next->has_dynamic_functions = LXW_TRUE;
+
+            _insert_cell(next, cell->row_num, cell->col_num, cell);
+            cells[j++] = NULL;
+        }
+    }
+
+    goto error;
+
+mem_error:
+    err = LXW_ERROR_MEMORY_MALLOC_FAILED;
+
+error:
+    for (i = 0; i < num_cells && cells; i++)
+        _free_cell(cells[i]);
+
+    free(cells);
+    free(rows);
+    return err;
+}
+
+/*
+ * Share the column statistics of a worksheet with one of its rollover
+ * worksheets. The rows of the rollover worksheet are mapped back to the rows
+ * written to the original worksheet so that the statistics cover all of them.
+ */
+STATIC void
+_share_rollover_column_stats(lxw_worksheet *self, uint16_t index)
+{
+    lxw_worksheet *next = self->rollover_sheets[index];
+    lxw_row_t data_rows = self->rollover_rows - self->rollover_header_rows;
+
+    _free_column_stats(next);
+
+    if (!self->column_stats)
+        return;
+
+    next->column_stats = self->column_stats;
+    next->stats_shared = LXW_TRUE;
+    next->stats_generation = self->stats_generation;
+    next->stats_row_offset = self->rollover_rows + index * data_rows
+        - self->rollover_header_rows;
+    next->stats_first_row = self->stats_first_row;
+    next->stats_last_row = self->stats_last_row;
+    next->stats_first_col = self->stats_first_col;
+    next->stats_last_col = self->stats_last_col;
+}
+
+/*
+ * Add the next rollover worksheet of a worksheet to the workbook, with a
+ * name like "Sheet1 (2)" that is shortened to fit the Excel limit.
+ */
+STATIC lxw_error
+_worksheet_add_rollover_sheet(lxw_worksheet *self)
+{
+    char name[LXW_MAX_SHEETNAME_LENGTH];
+    char suffix[LXW_ATTR_32];
+    size_t name_length = 0;
+    size_t num_chars = 0;
+    size_t max_chars;
+    lxw_worksheet **sheets;
+    lxw_worksheet *next;
+    lxw_error err;
+
+    if (!self->workbook) {
+        LXW_WARN_FORMAT1("worksheet_set_rollover(): worksheet '%s' can't be "
+                         "continued since it isn't part of a workbook.",
+                         self->name);
+        return LXW_ERROR_WORKSHEET_INDEX_OUT_OF_RANGE;
+    }
+
+    if (self->rollover_count == UINT16_MAX)
+        return LXW_ERROR_WORKSHEET_INDEX_OUT_OF_RANGE;
+
+    sheets = realloc(self->rollover_sheets,
+                     (self->rollover_count + 1) * sizeof(lxw_worksheet *));
+    RETURN_ON_MEM_ERROR(sheets, LXW_ERROR_MEMORY_MALLOC_FAILED);
+    self->rollover_sheets = sheets;
+
+    lxw_snprintf(suffix, LXW_ATTR_32, " (%d)", self->rollover_count + 2);
+    max_chars = LXW_SHEETNAME_MAX - strlen(suffix);
+
+    /* Shorten the name to fit the suffix, without splitting a UTF-8 char. */
+    while (self->name[name_length]) {
+        if (((unsigned char) self->name[name_length] & 0xC0) != 0x80) {
+            if (num_chars == max_chars)
+                break;
+
+            num_chars++;
+        }
+
+        name_length++;
+    }
+
+    lxw_snprintf(name, LXW_MAX_SHEETNAME_LENGTH, "%.*s%s",
+                 (int) name_length, self->name, suffix);
+
+    /* Report the reason that the name can't be used, such as a clash with
+     * an existing worksheet name. */
+    err = workbook_validate_sheet_name(self->workbook, name);
+    if (err) {
+        LXW_WARN_FORMAT2("worksheet_set_rollover(): rollover worksheet "
+                         "name '%s' has error: %s", name, lxw_strerror(err));
+        return err;
+    }
+
+    next = workbook_add_worksheet(self->workbook, name);
+    if (!next)
+        return LXW_ERROR_WORKSHEET_INDEX_OUT_OF_RANGE;
+
+    self->rollover_sheets[self->rollover_count++] = next;
+
+    _share_rollover_column_stats(self, self->rollover_count - 1);
+
+    return _worksheet_copy_rollover_setup(self, next);
+}
+
+/*
+ * Map a row past the rollover limit of a worksheet to the row of a rollover
+ * worksheet, adding the rollover worksheets as required.
+ */
+STATIC lxw_error
+_worksheet_rollover(lxw_worksheet **worksheet, lxw_row_t *row_num)
+{
+    lxw_worksheet *self = *worksheet;
+    lxw_row_t data_rows = self->rollover_rows - self->rollover_header_rows;
+    lxw_row_t offset = *row_num - self->rollover_rows;
+    uint32_t index = offset / data_rows;
+    lxw_error err;
+
+    while (self->rollover_count <= index) {
+        err = _worksheet_add_rollover_sheet(self);
+        if (err)
+            return err;
+    }
+
+    *worksheet = self->rollover_sheets[index];
+    *row_num = self->rollover_header_rows + offset % data_rows;
+
+    return LXW_NO_ERROR;
+}
+
+/*
+ * Get the column accumulator for a cell, if the cell is in the range set by
+ * worksheet_track_column_stats().
+ */
+STATIC lxw_column_accumulator *
+_get_column_accumulator(lxw_worksheet *self, lxw_row_t row_num,
+                        lxw_col_t col_num)
+{
+    /* Map the rows of a rollover worksheet to the original worksheet. */
+    row_num += self->stats_row_offset;
+
+    if (row_num < self->stats_first_row || row_num > self->stats_last_row)
+        return NULL;
+
+    if (col_num < self->stats_first_col || col_num > self->stats_last_col)
+        return NULL;
+
+    return &self->column_stats[col_num - self->stats_first_col];
+}
+
+/*
+ * Add a number to the running statistics of a column. Returns the statistics
+ * generation to store in the cell, or 0 if the cell isn't in the range.
+ */
+STATIC uint8_t
+_accumulate_number(lxw_worksheet *self, lxw_row_t row_num,
+                   lxw_col_t col_num, double number)
+{
+    lxw_column_accumulator *accumulator;
+
+    accumulator = _get_column_accumulator(self, row_num, col_num);
+    if (!accumulator)
+        return 0;
+
+    if (!accumulator->number_count || number < accumulator->min)
+        accumulator->min = number;
+
+    if (!accumulator->number_count || number > accumulator->max)
+        accumulator->max = number;
+
+    accumulator->sum += number;
+    accumulator->number_count++;
+
+    return self->stats_generation;
+}
+
+/*
+ * Hash a string for the distinct string estimate. This is FNV-1a with a
+ * final mix so that the high bits, used to order the hashes, are uniform.
+ */
+STATIC uint64_t
+_hash_column_string(const char *string)
+{
+    /* The 64 bit constants are built from 32 bit parts for C89. */
+    uint64_t hash = (uint64_t) 0xcbf29ce4 << 32 | 0x84222325;
+    uint64_t prime = (uint64_t) 0x100 << 32 | 0x000001b3;
+
+    while (*string) {
+        hash ^= (unsigned char) *string++;
+        hash *= prime;
+    }
+
+    hash ^= hash >> 33;
+    hash *= (uint64_t) 0xff51afd7 << 32 | 0xed558ccd;
+    hash ^= hash >> 33;
+    hash *= (uint64_t) 0xc4ceb9fe << 32 | 0x1a85ec53;
+    hash ^= hash >> 33;
+
+    return hash;
+}
+
+/*
+ * Add a string to the running statistics of a column. The distinct strings
+ * are estimated from the smallest string hashes seen, a "k minimum values"
+ * sketch, which is exact while there are fewer distinct strings than hashes.
+ */
+STATIC uint8_t
+_accumulate_string(lxw_worksheet *self, lxw_row_t row_num,
+                   lxw_col_t col_num, const char *string)
+{
+    lxw_column_accumulator *accumulator;
+    uint64_t hash;
+    uint16_t low = 0;
+    uint16_t high;
+    uint16_t mid;
+
+    accumulator = _get_column_accumulator(self, row_num, col_num);
+    if (!accumulator)
+        return 0;
+
+    accumulator->string_count++;
+
+    if (!accumulator->hashes) {
+        accumulator->hashes = calloc(LXW_COLUMN_STATS_HASHES,
+                                     sizeof(uint64_t));
+        RETURN_ON_MEM_ERROR(accumulator->hashes, self->stats_generation);
+    }
+
+    hash = _hash_column_string(string);
+    high = accumulator->num_hashes;
+
+    if (high == LXW_COLUMN_STATS_HASHES && hash >= accumulator->hashes[high - 1])
+        return self->stats_generation;
+
+    /* Find the position of the hash in the sorted list. */
+    while (low < high) {
+        mid = (low + high) / 2;
+        if (accumulator->hashes[mid] < hash)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+
+    if (low < accumulator->num_hashes && accumulator->hashes[low] == hash)
+        return self->stats_generation;
+
+    if (accumulator->num_hashes < LXW_COLUMN_STATS_HASHES)
+        accumulator->num_hashes++;
+
+    memmove(&accumulator->hashes[low + 1], &accumulator->hashes[low],
+            (accumulator->num_hashes - low - 1) * sizeof(uint64_t));
+    accumulator->hashes[low] = hash;
+
+    return self->stats_generation;
+}
+
+/*
+ * Remove the value of a cell that is being overwritten from the running
+ * statistics of its column, if it was counted by the current call to
+ * worksheet_track_column_stats(). The minimum, maximum and distinct strings
+ * can't be unwound so they still include the old value.
+ */
+STATIC void
+_remove_column_stats(lxw_worksheet *self, lxw_cell *cell)
+{
+    lxw_column_accumulator *accumulator;
+
+    if (!cell || !self->column_stats || !cell->stats_generation
+        || cell->stats_generation != self->stats_generation)
+        return;
+
+    cell->stats_generation = 0;
+
+    accumulator = _get_column_accumulator(self, cell->row_num, cell->col_num);
+    if (!accumulator)
+        return;
+
+    if (cell->type == NUMBER_CELL) {
+        accumulator->sum -= cell->u.number;
+        accumulator->number_count--;
+    }
+    else if (cell->type == NUMBER_TEXT_CELL) {
+        accumulator->sum -= lxw_strtod(cell->u.string, NULL);
+        accumulator->number_count--;
+    }
+    else if (cell->type == STRING_CELL || cell->type == INLINE_STRING_CELL) {
+        accumulator->string_count--;
+    }
+}
+
+/*
+ * Free the column accumulators of a worksheet.
+ */
+STATIC void
+_free_column_stats(lxw_worksheet *self)
+{
+    lxw_col_t i;
+
+    if (!self->column_stats)
+        return;
+
+    /* The statistics of a rollover worksheet belong to the original. */
+    if (self->stats_shared) {
+        self->column_stats = NULL;
+        self->stats_shared = LXW_FALSE;
+        self->stats_row_offset = 0;
+        return;
+    }
+
+    for (i = 0; i <= self->stats_last_col - self->stats_first_col; i++)
+        free(self->column_stats[i].hashes);
+
+    free(self->column_stats);
+    self->column_stats = NULL;
+}
+
+/*****************************************************************************
+ *
+ * Public functions.
+ *
+ ****************************************************************************/
+
+/*
+ * Write a number to a cell in Excel.
+ */
+lxw_error
+worksheet_write_number(lxw_worksheet *self,
+                       lxw_row_t row_num,
+                       lxw_col_t col_num, double value, lxw_format *format)
+{
+    lxw_cell *cell;
+    lxw_error err;
+    uint8_t stats_generation = 0;
+
+    LXW_ROLLOVER_ROW(self, row_num);
+
+    if (self->trusted_input)
+        err = _check_trusted_cell(self, row_num, col_num, NULL,
+                                  LXW_TRUSTED_NUMBER);
+    else
+        err = _check_dimensions(self, row_num, col_num, LXW_FALSE, LXW_FALSE);
+
+    if (err)
+        return err;
+
+    if (self->column_stats)
+        stats_generation = _accumulate_number(self, row_num, col_num, value);
+
+    /* Overwrite an existing cell in place if possible. */
+    cell = _get_existing_cell(self, row_num, col_num);
+    if (cell) {
+        _remove_column_stats(self, cell);
+        _free_cell_data(cell);
+        cell->type = NUMBER_CELL;
+        cell->format = format;
+        cell->u.number = value;
+        cell->stats_generation = stats_generation;
+
+        return LXW_NO_ERROR;
+    }
+
+    cell = _new_number_cell(row_num, col_num, value, format);
+    if (cell)
+        cell->stats_generation = stats_generation;
+
+    _insert_cell(self, row_num, col_num, cell);
+
+    return LXW_NO_ERROR;
+}
+
+/*
+ * Check that a number in text form is a decimal number and copy it to a new
+ * string in a minimal form, without a leading "+", leading zeros or trailing
+ * zeros in the fraction. Returns NULL if the number isn't valid.
+ */
+STATIC char *
+_normalize_number_text(const char *digits, size_t length)
+{
+    size_t i = 0;
+    size_t int_start, int_end, frac_start, frac_end;
+    size_t exp_start = 0, exp_end = 0;
+    char sign = '\0';
+    char exp_sign = '\0';
+    char *number;
+    char *p;
+
+#define LXW_IS_DIGIT(c) ((c) >= '0' && (c) <= '9')
+
+    if (i < length && (digits[i] == '-' || digits[i] == '+'))
+        sign = digits[i++];
+
+    int_start = i;
+    while (i < length && LXW_IS_DIGIT(digits[i]))
+        i++;
+    int_end = i;
+
+    frac_start = frac_end = i;
+    if (i < length && digits[i] == '.') {
+        frac_start = ++i;
+        while (i < length && LXW_IS_DIGIT(digits[i]))
+            i++;
+        frac_end = i;
+    }
+
+    /* There must be at least one digit in the integer or fraction. */
+    if (int_start == int_end && frac_start == frac_end)
+        return NULL;
+
+    if (i < length && (digits[i] == 'e' || digits[i] == 'E')) {
+        i++;
+        if (i < length && (digits[i] == '-' || digits[i] == '+'))
+            exp_sign = digits[i++];
+
+        exp_start = i;
+        while (i < length && LXW_IS_DIGIT(digits[i]))
+            i++;
+        exp_end = i;
+
+        if (exp_start == exp_end)
+            return NULL;
+    }
+
+    if (i != length)
+        return NULL;
+
+#undef LXW_IS_DIGIT
+
+    /* Strip leading zeros from the integer, trailing zeros from the
+     * fraction and leading zeros from the exponent. */
+    while (int_start < int_end && digits[int_start] == '0')
+        int_start++;
+
+    while (frac_end > frac_start && digits[frac_end - 1] == '0')
+        frac_end--;
+
+    while (exp_start < exp_end && digits[exp_start] == '0')
+        exp_start++;
+
+    /* Add room for a leading "0" and the NULL terminator. */
+    number = calloc(1, length + 2);
+    RETURN_ON_MEM_ERROR(number, NULL);
+
+    p = number;
+
+    /* Zero is written without a sign or exponent. */
+    if (int_start == int_end && frac_start == frac_end) {
+        *p = '0';
+        return number;
+    }
+
+    if (sign == '-')
+        *p++ = '-';
+
+    if (int_start == int_end) {
+        *p++ = '0';
+    }
+    else {
+        memcpy(p, digits + int_start, int_end - int_start);
+        p += int_end - int_start;
+    }
+
+    if (frac_start != frac_end) {
+        *p++ = '.';
+        memcpy(p, digits + frac_start, frac_end - frac_start);
+        p += frac_end - frac_start;
+    }
+
+    if (exp_start != exp_end) {
+        *p++ = 'E';
+        if (exp_sign == '-')
+            *p++ = '-';
+
+        memcpy(p, digits + exp_start, exp_end - exp_start);
+    }
+
+    return number;
+}
+
+/*
+ * Write a number stored as text to a cell in Excel.
+ */
+lxw_error
+worksheet_write_number_text(lxw_worksheet *self,
+                            lxw_row_t row_num,
+                            lxw_col_t col_num,
+                            const char *digits, size_t length,
+                            lxw_format *format)
+{
+    lxw_cell *cell;
+    char *number;
+    double value;
+    lxw_error err;
+    uint8_t stats_generation = 0;
+
+    LXW_ROLLOVER_ROW(self, row_num);
+
+    if (!digits)
+        return LXW_ERROR_NULL_PARAMETER_IGNORED;
+
+    if (!length)
+        return LXW_ERROR_PARAMETER_IS_EMPTY;
+
+    if (self->trusted_input)
+        err = _check_trusted_cell(self, row_num, col_num, NULL,
+                                  LXW_TRUSTED_NUMBER);
+    else
+        err = _check_dimensions(self, row_num, col_num, LXW_FALSE, LXW_FALSE);
+
+    if (err)
+        return err;
+
+    number = _normalize_number_text(digits, length);
+    if (!number) {
+        LXW_WARN_FORMAT2("worksheet_write_number_text(): cell (%u, %u) "
+                         "text isn't a valid number.", row_num, col_num);
+        return LXW_ERROR_PARAMETER_VALIDATION;
+    }
+
+    /* The exponent must be in the range of a double. Zero is always
+     * normalized to "0" so any other number that converts to zero is too
+     * small. */
+    value = lxw_strtod(number, NULL);
+    if (value > DBL_MAX || value < -DBL_MAX
+        || (value == 0.0 && strcmp(number, "0") != 0)) {
+        LXW_WARN_FORMAT2("worksheet_write_number_text(): cell (%u, %u) "
+                         "number is outside the range of a double.",
+                         row_num, col_num);
+        free(number);
+        return LXW_ERROR_PARAMETER_VALIDATION;
+    }
+
+    if (self->column_stats)
+        stats_generation = _accumulate_number(self, row_num, col_num, value);
+
+    cell = _new_number_text_cell(row_num, col_num, number, format);
+    if (cell)
+        cell->stats_generation = stats_generation;
+
+    _insert_cell(self, row_num, col_num, cell);
+
+    return LXW_NO_ERROR;
+}
+
+/*
+ * Add a number to the value in a worksheet cell, in place.
+ */
+lxw_error
+worksheet_accumulate_number(lxw_worksheet *self,
+                            lxw_row_t row_num,
+                            lxw_col_t col_num, double delta,
+                            lxw_format *format)
+{
+    lxw_cell *cell;
+    double number;
+    lxw_error err;
+
+    LXW_ROLLOVER_ROW(self, row_num);
+
+    err = _check_dimensions(self, row_num, col_num, LXW_FALSE, LXW_FALSE);
+    if (err)
+        return err;
+
+    cell = _get_existing_cell(self, row_num, col_num);
+
+    /* Blank cells without a format are comment placeholders. */
+    if (!cell || (cell->type == BLANK_CELL && !cell->format && !format))
+        return worksheet_write_number(self, row_num, col_num, delta, format);
+
+    if (cell->type == NUMBER_CELL) {
+        number = cell->u.number + delta;
+    }
+    else if (cell->type == NUMBER_TEXT_CELL) {
+        number = lxw_strtod(cell->u.string, NULL) + delta;
+    }
+    else if (cell->type == BLANK_CELL) {
+        number = delta;
+    }
+    else {
+        LXW_WARN_FORMAT2("worksheet_accumulate_number(): cell (%d, %d) "
+                         "doesn't contain a number.", row_num, col_num);
+        return LXW_ERROR_PARAMETER_VALIDATION;
+    }
+
+    /* Replace the old value of the cell in the column statistics. */
+    if (self->column_stats) {
+        _remove_column_stats(self, cell);
+        cell->stats_generation =
+            _accumulate_number(self, row_num, col_num, number);
+    }
+
+    if (cell->type == NUMBER_TEXT_CELL)
+        free((void *) cell->u.string);
+
+    cell->type = NUMBER_CELL;
+    cell->u.number = number;
+
+    if (format)
+        cell->format = format;
+
+    return LXW_NO_ERROR;
+}
+
+/*
+ * Write a string to an Excel file.
+ */
+lxw_error
+worksheet_write_string(lxw_worksheet *self,
+                       lxw_row_t row_num,
+                       lxw_col_t col_num, const char *string,
+                       lxw_format *format)
+{
+    lxw_cell *cell;
+    int32_t string_id;
+    char *string_copy;
+    struct sst_element *sst_element;
+    lxw_error err;
+    uint8_t stats_generation = 0;
+
+    LXW_ROLLOVER_ROW(self, row_num);
+
+    if (self->trusted_input) {
+        err = _check_trusted_cell(self, row_num, col_num, string,
+                                  LXW_TRUSTED_STRING);
+        if (err)
+            return err;
+    }
+    else {
+        if (!string || !*string) {
+            /* Treat a NULL or empty string with formatting as a blank cell. */
+            /* Null strings without formats should be ignored.      */
+            if (format)
+                return worksheet_write_blank(self, row_num, col_num, format);
+            else
+                return LXW_NO_ERROR;
+        }
+
+        err = _check_dimensions(self, row_num, col_num, LXW_FALSE, LXW_FALSE);
+        if (err)
+            return err;
+
+        if (lxw_utf8_strlen(string) > LXW_STR_MAX)
+            return LXW_ERROR_MAX_STRING_LENGTH_EXCEEDED;
+    }
+
+    if (self->column_stats)
+        stats_generation = _accumulate_string(self, row_num, col_num, string);
+
+    if (!self->optimize) {
+        /* Get the SST element and string id. */
+        sst_element = lxw_get_sst_index(self->sst, string, LXW_FALSE);
+
+        if (!sst_element)
+            return LXW_ERROR_SHARED_STRING_INDEX_NOT_FOUND;
+
+        string_id = sst_element->index;
+        cell = _new_string_cell(row_num, col_num, string_id,
+                                sst_element->string, format);
+    }
+    else {
+        /* Look for and escape control chars in the string. Trusted input
+         * doesn't contain control chars. */
+        if (!self->trusted_input && lxw_has_control_characters(string)) {
+            string_copy = lxw_escape_control_characters(string);
+        }
+        else {
+            string_copy = lxw_strdup(string);
+        }
+        cell = _new_inline_string_cell(row_num, col_num, string_copy, format);
+    }
+
+    if (cell)
+        cell->stats_generation = stats_generation;
+
+    _insert_cell(self, row_num, col_num, cell);
+
+    return LXW_NO_ERROR;
+}
+
+/*
+ * Write a formula with a numerical result to a cell in Excel.
+ */
+lxw_error
+worksheet_write_formula_num(lxw_worksheet *self,
+                            lxw_row_t row_num,
+                            lxw_col_t col_num,
+                            const char *formula,
+                            lxw_format *format, double result)
+{
+    lxw_cell *cell;
+    char *formula_copy;
+    lxw_error err;
+
+    LXW_ROLLOVER_ROW(self, row_num);
+
+    if (self->trusted_input) {
+        err = _check_trusted_cell(self, row_num, col_num, formula,
+                                  LXW_TRUSTED_FORMULA);
+        if (err)
+            return err;
+    }
+    else {
+        if (!formula)
+            return LXW_ERROR_NULL_PARAMETER_IGNORED;
+
+        if (lxw_str_is_empty(formula))
+            return LXW_ERROR_PARAMETER_IS_EMPTY;
+
+        err = _check_dimensions(self, row_num, col_num, LXW_FALSE, LXW_FALSE);
+        if (err)
+            return err;
+    }
+
+    /* Strip leading "=" from formula. */
+    if (formula[0] == '=')
+        formula_copy = lxw_strdup(formula + 1);
+    else
+        formula_copy = lxw_strdup(formula);
+
+    cell = _new_formula_cell(row_num, col_num, formula_copy, format);
+    cell->formula_result = result;
+
+    _insert_cell(self, row_num, col_num, cell);
+
+    return LXW_NO_ERROR;
+}
+
+/*
+ * Write a formula with a string result to a cell in Excel.
+ */
+lxw_error
+worksheet_write_formula_str(lxw_worksheet *self,
+                            lxw_row_t row_num,
+                            lxw_col_t col_num,
+                            const char *formula,
+                            lxw_format *format, const char *result)
+{
+    lxw_cell *cell;
+    char *formula_copy;
+    lxw_error err;
+
+    LXW_ROLLOVER_ROW(self, row_num);
+
+    if (self->trusted_input) {
+        err = _check_trusted_cell(self, row_num, col_num, formula,
+                                  LXW_TRUSTED_FORMULA);
+        if (err)
+            return err;
+    }
+    else {
+        if (!formula)
+            return LXW_ERROR_NULL_PARAMETER_IGNORED;
+
+        if (lxw_str_is_empty(formula))
+            return LXW_ERROR_PARAMETER_IS_EMPTY;
+
+        err = _check_dimensions(self, row_num, col_num, LXW_FALSE, LXW_FALSE);
+        if (err)
+            return err;
+    }
+
+    /* Strip leading "=" from formula. */
+    if (formula[0] == '=')
+        formula_copy = lxw_strdup(formula + 1);
+    else
+        formula_copy = lxw_strdup(formula);
+
+    cell = _new_formula_cell(row_num, col_num, formula_copy, format);
+    cell->user_data2 = lxw_strdup(result);
+
+    _insert_cell(self, row_num, col_num, cell);
+
+    return LXW_NO_ERROR;
+}
+
+/*
+ * Write a formula with a default result to a cell in Excel .
+ */
+lxw_error
+worksheet_write_formula(lxw_worksheet *self,
+                        lxw_row_t row_num,
+                        lxw_col_t col_num, const char *formula,
+                        lxw_format *format)
+{
+    return worksheet_write_formula_num(self, row_num, col_num, formula,
+                                       format, 0);
+}
+
+/*
+ * Internal shared function for various array formula functions.
+ */
+lxw_error
+_store_array_formula(lxw_worksheet *self,
+                     lxw_row_t first_row,
+                     lxw_col_t first_col,
+                     lxw_row_t last_row,
+                     lxw_col_t last_col,
+                     const char *formula, lxw_format *format, double result,
+                     uint8_t is_dynamic)
+{
+    lxw_cell *cell;
+    lxw_row_t tmp_row;
+    lxw_col_t tmp_col;
+    char *formula_copy;
+    char *range;
+    lxw_error err;
+
+    /* Swap last row/col with first row/col as necessary */
+    if (first_row > last_row) {
+        tmp_row = last_row;
+        last_row = first_row;
+        first_row = tmp_row;
+    }
+    if (first_col > last_col) {
+        tmp_col = last_col;
+        last_col = first_col;
+        first_col = tmp_col;
+    }
+
+    if (!formula)
+        return LXW_ERROR_NULL_PARAMETER_IGNORED;
+
+    if (lxw_str_is_empty(formula))
+        return LXW_ERROR_PARAMETER_IS_EMPTY;
+
+    /* Check that row and col are valid and store max and min values. */
+    err = _check_dimensions(self, first_row, first_col, LXW_FALSE, LXW_FALSE);
+    if (err)
+        return err;
+
+    err = _check_dimensions(self, last_row, last_col, LXW_FALSE, LXW_FALSE);
+    if (err)
+        return err;
+
+    /* Define the array range. */
+    range = calloc(1, LXW_MAX_CELL_RANGE_LENGTH);
+    RETURN_ON_MEM_ERROR(range, LXW_ERROR_MEMORY_MALLOC_FAILED);
+
+    if (first_row == last_row && first_col == last_col)
+        lxw_rowcol_to_cell(range, first_row, first_col);
+    else
+        lxw_rowcol_to_range(range, first_row, first_col, last_row, last_col);
+
+    /* Copy and trip leading "{=" from formula. */
+    if (formula[0] == '{')
+        if (strlen(formula) >= 2 && formula[1] == '=')
+            formula_copy = lxw_strdup(formula + 2);
+        else
+            formula_copy = lxw_strdup(formula + 1);
+    else
+        formula_copy = lxw_strdup_formula(formula);
+
+    /* Strip trailing "}" from formula. */
+    if (strlen(formula_copy) > 0
+        && formula_copy[strlen(formula_copy) - 1] == '}') {
+        formula_copy[strlen(formula_copy) - 1] = '\0';
+    }
+
+    /* Check for empty formula that started as {=}. */
+    if (lxw_str_is_empty(formula_copy)) {
+        free(formula_copy);
+        free(range);
+        return LXW_ERROR_PARAMETER_IS_EMPTY;
+    }
+
+    /* Create a new array formula cell object. */
+    cell = _new_array_formula_cell(first_row, first_col,
+                                   formula_copy, range, format, is_dynamic);
+
+    cell->formula_result = result;
+
+    _insert_cell(self, first_row, first_col, cell);
+
+    if (is_dynamic)
+        self->has_dynamic_functions = LXW_TRUE;
+
+    /* Pad out the rest of the area with formatted zeroes. */
+    if (!self->optimize) {
+        for (tmp_row = first_row; tmp_row <= last_row; tmp_row++) {
+            for (tmp_col = first_col; tmp_col <= last_col; tmp_col++) {
+                if (tmp_row == first_row && tmp_col == first_col)
+                    continue;
+
+                worksheet_write_number(self, tmp_row, tmp_col, 0, format);
+            }
+        }
+    }
+
+    return LXW_NO_ERROR;
+}
+
+/*
+ * Write an array formula with a numerical result to a cell in Excel.
+ */
+lxw_error
+worksheet_write_array_formula_num(lxw_worksheet *self,
+                                  lxw_row_t first_row,
+                                  lxw_col_t first_col,
+                                  lxw_row_t last_row,
+                                  lxw_col_t last_col,
+                                  const char *formula,
+                                  lxw_format *format, double result)
+{
+    return _store_array_formula(self, first_row, first_col,
+                                last_row, last_col, formula, format, result,
+                                LXW_FALSE);
+}
+
+/*
+ * Write an array formula with a default result to a cell in Excel.
+ */
+lxw_error
+worksheet_write_array_formula(lxw_worksheet *self,
+                              lxw_row_t first_row,
+                              lxw_col_t first_col,
+                              lxw_row_t last_row,
+                              lxw_col_t last_col,
+                              const char *formula, lxw_format *format)
+{
+    return _store_array_formula(self, first_row, first_col,
+                                last_row, last_col, formula, format, 0,
+                                LXW_FALSE);
+}
+
+/*
+ * Write a single cell dynamic array formula with a default result to a cell.
+ */
+lxw_error
+worksheet_write_dynamic_formula(lxw_worksheet *self,
+                                lxw_row_t row,
+                                lxw_col_t col,
+                                const char *formula, lxw_format *format)
+{
+    return _store_array_formula(self, row, col, row, col, formula, format, 0,
+                                LXW_TRUE);
+}
+
+/*
+ * Write a single cell dynamic array formula with a numerical result to a cell.
+ */
+lxw_error
+worksheet_write_dynamic_formula_num(lxw_worksheet *self,
+                                    lxw_row_t row,
+                                    lxw_col_t col,
+                                    const char *formula,
+                                    lxw_format *format, double result)
+{
+    return _store_array_formula(self, row, col, row, col, formula, format,
+                                result, LXW_TRUE);
+}
+
+/*
+ * Write a dynamic array formula with a numerical result to a cell in Excel.
+ */
+lxw_error
+worksheet_write_dynamic_array_formula_num(lxw_worksheet *self,
+                                          lxw_row_t first_row,
+                                          lxw_col_t first_col,
+                                          lxw_row_t last_row,
+                                          lxw_col_t last_col,
+                                          const char *formula,
+                                          lxw_format *format, double result)
+{
+    return _store_array_formula(self, first_row, first_col,
+                                last_row, last_col, formula, format, result,
+                                LXW_TRUE);
+}
+
+/*
+ * Write a dynamic array formula with a default result to a cell in Excel.
+ */
+lxw_error
+worksheet_write_dynamic_array_formula(lxw_worksheet *self,
+                                      lxw_row_t first_row,
+                                      lxw_col_t first_col,
+                                      lxw_row_t last_row,
+                                      lxw_col_t last_col,
+                                      const char *formula, lxw_format *format)
+{
+    return _store_array_formula(self, first_row, first_col,
+                                last_row, last_col, formula, format, 0,
+                                LXW_TRUE);
+}
+
+/*
+ * Write a blank cell with a format to a cell in Excel.
+ */
+lxw_error
+worksheet_write_blank(lxw_worksheet *self,
+                      lxw_row_t row_num, lxw_col_t col_num,
+                      lxw_format *format)
+{
+    lxw_cell *cell;
+    lxw_error err;
+
+    LXW_ROLLOVER_ROW(self, row_num);
+
+    /* Blank cells without formatting are ignored by Excel. */
+    if (!format)
+        return LXW_NO_ERROR;
+
+    if (self->trusted_input)
+        err = _check_trusted_cell(self, row_num, col_num, NULL,
+                                  LXW_TRUSTED_NUMBER);
+    else
+        err = _check_dimensions(self, row_num, col_num, LXW_FALSE, LXW_FALSE);
+
+    if (err)
+        return err;
+
+    cell = _new_blank_cell(row_num, col_num, format);
+
+    _insert_cell(self, row_num, col_num, cell);
+
+    return LXW_NO_ERROR;
+}
+
+/*
+ * Write a boolean cell with a format to a cell in Excel.
+ */
+lxw_error
+worksheet_write_boolean(lxw_worksheet *self,
+                        lxw_row_t row_num, lxw_col_t col_num,
+                        int value, lxw_format *format)
+{
+    lxw_cell *cell;
+    lxw_error err;
+
+    LXW_ROLLOVER_ROW(self, row_num);
+
+    if (self->trusted_input)
+        err = _check_trusted_cell(self, row_num, col_num, NULL,
+                                  LXW_TRUSTED_NUMBER);
+    else
+        err = _check_dimensions(self, row_num, col_num, LXW_FALSE, LXW_FALSE);
+
+    if (err)
+        return err;
+
+    cell = _new_boolean_cell(row_num, col_num, value, format);
+
+    _insert_cell(self, row_num, col_num, cell);
+
+    return LXW_NO_ERROR;
+}
+
+/*
+ * Write a date and or time to a cell in Excel.
+ */
+lxw_error
+worksheet_write_datetime(lxw_worksheet *self,
+                         lxw_row_t row_num,
+                         lxw_col_t col_num, lxw_datetime *datetime,
+                         lxw_format *format)
+{
+    lxw_cell *cell;
+    double excel_date;
+    lxw_error err;
+    uint8_t stats_generation = 0;
+
+    LXW_ROLLOVER_ROW(self, row_num);
+
+    err = _check_dimensions(self, row_num, col_num, LXW_FALSE, LXW_FALSE);
+    if (err)
+        return err;
+
+    printf("worksheet_write_datetime(): %d-%02d-%02d - 1904: %d\n",
+           datetime->year, datetime->month, datetime->day,
+           self->use_1904_epoch);
+
+    excel_date =
+        lxw_datetime_to_excel_date_with_epoch(datetime, self->use_1904_epoch);
+
+    if (self->column_stats)
+        stats_generation =
+            _accumulate_number(self, row_num, col_num, excel_date);
+
+    cell = _new_number_cell(row_num, col_num, excel_date, format);
+    if (cell)
+        cell->stats_generation = stats_generation;
+
+    _insert_cell(self, row_num, col_num, cell);
+
+    return LXW_NO_ERROR;
+}
+
+/*
+ * Write a date and or time to a cell in Excel.
+ */
+lxw_error
+worksheet_write_unixtime(lxw_worksheet *self,
+                         lxw_row_t row_num,
+                         lxw_col_t col_num,
+                         int64_t unixtime, lxw_format *format)
+{
+    lxw_cell *cell;
+    double excel_date;
+    lxw_error err;
+    uint8_t stats_generation = 0;
+
+    LXW_ROLLOVER_ROW(self, row_num);
+
+    err = _check_dimensions(self, row_num, col_num, LXW_FALSE, LXW_FALSE);
+    if (err)
+        return err;
+
+    excel_date =
+        lxw_unixtime_to_excel_date_with_epoch(unixtime, self->use_1904_epoch);
+
+    if (self->column_stats)
+        stats_generation =
+            _accumulate_number(self, row_num, col_num, excel_date);
+
+    cell = _new_number_cell(row_num, col_num, excel_date, format);
+    if (cell)
+        cell->stats_generation = stats_generation;
+
+    _insert_cell(self, row_num, col_num, cell);
+
+    return LXW_NO_ERROR;
+}
+
+/*
+ * Write a hyperlink/url to an Excel file.
+ */
+lxw_error
+worksheet_write_url_opt(lxw_worksheet *self,
+                        lxw_row_t row_num,
+                        lxw_col_t col_num, const char *url,
+                        lxw_format *user_format, const char *string,
+                        const char *tooltip)
+{
+    lxw_cell *link;
+    lxw_url_element *url_element;
+    char url_buffer[LXW_URL_BUFFER_SIZE];
+    char *buffer = url_buffer;
+    char *url_copy;
+    char *string_copy = NULL;
+    char *url_string = NULL;
+    char *tooltip_copy = NULL;
+    const char *link_url = url;
+    const char *display;
+    const char *location;
+    lxw_format *format = NULL;
+    size_t buffer_size;
+    size_t url_length;
+    size_t i;
+    lxw_error err = LXW_ERROR_MEMORY_MALLOC_FAILED;
+    enum cell_types link_type = HYPERLINK_URL;
+
+    LXW_ROLLOVER_ROW(self, row_num);
+
+    if (!url || !*url)
+        return LXW_ERROR_NULL_PARAMETER_IGNORED;
+
+    /* Check the Excel limit of URLS per worksheet. */
+    if (self->hlink_count > LXW_MAX_NUMBER_URLS) {
+        LXW_WARN("worksheet_write_url()/_opt(): URL ignored since it exceeds "
+                 "the maximum number of allowed worksheet URLs (65530).");
+        return LXW_ERROR_WORKSHEET_MAX_NUMBER_URLS_EXCEEDED;
+    }
+
+    err = _check_dimensions(self, row_num, col_num, LXW_FALSE, LXW_FALSE);
+    if (err)
+        return err;
+
+    /* Reset default error condition. */
+    err = LXW_ERROR_MEMORY_MALLOC_FAILED;
+
+    /* Set the URI scheme from internal and external links and strip it. */
+    if (strstr(url, "external:"))
+        link_type = HYPERLINK_EXTERNAL;
+    else if (strstr(url, "internal:"))
+        link_type = HYPERLINK_INTERNAL;
+
+    if (link_type != HYPERLINK_URL)
+        link_url = url + sizeof("external:") - 1;
+
+    /* Get the displayed string, stripping any mailto header. */
+    if (string)
+        display = string;
+    else if (link_type == HYPERLINK_URL && strstr(url, "mailto:"))
+        display = url + sizeof("mailto:") - 1;
+    else
+        display = link_url;
+
+    /* A url that has already been written is stored with its normalized
+     * form. Otherwise normalize the url in a stack buffer unless it is very
+     * long. */
+    url_element = _get_url_element(self->url_table, url, LXW_FALSE);
+
+    if (url_element) {
+        url_copy = url_element->url;
+        url_length = url_element->url_length;
+
+        location = strchr(link_url, '#');
+        if (location)
+            location++;
+    }
+    else {
+        buffer_size = strlen(link_url) * 3 + sizeof("file:///");
+        if (buffer_size > LXW_URL_BUFFER_SIZE) {
+            buffer = malloc(buffer_size);
+            GOTO_LABEL_ON_MEM_ERROR(buffer, mem_error);
+        }
+
+        url_copy = _normalize_url(buffer, link_url, link_type, &url_length,
+                                  &location);
+    }
+
+    /* Check if URL exceeds Excel's length limit. */
+    if (url_length > self->max_url_length) {
+        LXW_WARN_FORMAT2("worksheet_write_url()/_opt(): URL exceeds "
+                         "Excel's allowable length of %d characters: %s",
+                         self->max_url_length, url_copy);
+        err = LXW_ERROR_WORKSHEET_MAX_URL_LENGTH_EXCEEDED;
+        goto mem_error;
+    }
+
+    /* The location is the url anchor or the display string for internal
+     * links. */
+    if (location) {
+        url_string = lxw_strdup(location);
+        GOTO_LABEL_ON_MEM_ERROR(url_string, mem_error);
+    }
+    else if (link_type == HYPERLINK_INTERNAL) {
+        url_string = lxw_strdup(display);
+        GOTO_LABEL_ON_MEM_ERROR(url_string, mem_error);
+    }
+
+    /* For external links change the dir separator from Unix to DOS. */
+    if (link_type == HYPERLINK_EXTERNAL && strchr(display, '/')) {
+        string_copy = lxw_strdup(display);
+        GOTO_LABEL_ON_MEM_ERROR(string_copy, mem_error);
+
+        for (i = 0; string_copy[i]; i++)
+            if (string_copy[i] == '/')
+                string_copy[i] = '\\';
+
+        display = string_copy;
+    }
+
+    if (tooltip) {
+        tooltip_copy = lxw_strdup(tooltip);
+        GOTO_LABEL_ON_MEM_ERROR(tooltip_copy, mem_error);
+    }
+
+    /* Use the default URL format if none is specified. */
+    if (!user_format)
+        format = self->default_url_format;
+    else
+        format = user_format;
+
+    if (!self->storing_embedded_image) {
+        err = worksheet_write_string(self, row_num, col_num, display, format);
+        if (err)
+            goto mem_error;
+    }
+
+    /* Reset default error condition. */
+    err = LXW_ERROR_MEMORY_MALLOC_FAILED;
+
+    /* Store the url once in the workbook url table. */
+    if (!url_element) {
+        url_element = _new_url_element(self->url_table, url, url_copy,
+                                       url_length, LXW_FALSE);
+        GOTO_LABEL_ON_MEM_ERROR(url_element, mem_error);
+    }
+
+    link = _new_hyperlink_cell(row_num, col_num, link_type, url_element,
+                               url_string, tooltip_copy);
+    GOTO_LABEL_ON_MEM_ERROR(link, mem_error);
+
+    _insert_hyperlink(self, row_num, col_num, link);
+
+    if (buffer != url_buffer)
+        free(buffer);
+
+    free(string_copy);
+    self->hlink_count++;
+    return LXW_NO_ERROR;
+
+mem_error:
+    if (buffer != url_buffer)
+        free(buffer);
+
+    free(string_copy);
+    free(url_string);
+    free(tooltip_copy);
+    return err;
+}
+
+/*
+ * Write a hyperlink/url to an Excel file.
+ */
+lxw_error
+worksheet_write_url(lxw_worksheet *self,
+                    lxw_row_t row_num,
+                    lxw_col_t col_num, const char *url, lxw_format *format)
+{
+    return worksheet_write_url_opt(self, row_num, col_num, url, format, NULL,
+                                   NULL);
+}
+
+/*
+ * Write a rich string to an Excel file.
+ *
+ * Rather than duplicate several of the styles.c font xml methods of styles.c
+ * and write the data to a memory buffer this function creates a temporary
+ * styles object and uses it to write the data to a file. It then reads that
+ * data back into memory and closes the file.
+ */
+lxw_error
+worksheet_write_rich_string(lxw_worksheet *self,
+                            lxw_row_t row_num,
+                            lxw_col_t col_num,
+                            lxw_rich_string_tuple *rich_strings[],
+                            lxw_format *format)
+{
+    lxw_cell *cell;
+    int32_t string_id;
+    struct sst_element *sst_element;
+    lxw_error err;
+    uint8_t i;
+    long file_size;
+    char *rich_string = NULL;
+    const char *string_copy = NULL;
+    lxw_styles *styles = NULL;
+    lxw_format *default_format = NULL;
+    lxw_rich_string_tuple *rich_string_tuple = NULL;
+    FILE *tmpfile;
+
+    LXW_ROLLOVER_ROW(self, row_num);
+
+    err = _check_dimensions(self, row_num, col_num, LXW_FALSE, LXW_FALSE);
+    if (err)
+        return err;
+
+    /* Iterate through rich string fragments to check for input errors. */
+    i = 0;
+    err = LXW_NO_ERROR;
+    while ((rich_string_tuple = rich_strings[i++]) != NULL) {
+
+        /* Check for NULL or empty strings. */
+        if (!rich_string_tuple->string || !*rich_string_tuple->string) {
+            err = LXW_ERROR_PARAMETER_VALIDATION;
+        }
+    }
+
+    /* If there are less than 2 fragments it isn't a rich string. */
+    if (i <= 2)
+        err = LXW_ERROR_PARAMETER_VALIDATION;
+
+    if (err)
+        return err;
+
+    /* Create a tmp file for the styles object. */
+    tmpfile = lxw_get_filehandle(&rich_string, NULL, self->tmpdir);
+    if (!tmpfile)
+        return LXW_ERROR_CREATING_TMPFILE;
+
+    /* Create a temp styles object for writing the font data. */
+    styles = lxw_styles_new();
+    GOTO_LABEL_ON_MEM_ERROR(styles, mem_error);
+    styles->file = tmpfile;
+
+    /* Create a default format for non-formatted text. */
+    default_format = lxw_format_new();
+    GOTO_LABEL_ON_MEM_ERROR(default_format, mem_error);
+
+    /* Iterate through the rich string fragments and write each one out. */
+    i = 0;
+    while ((rich_string_tuple = rich_strings[i++]) != NULL) {
+        lxw_xml_start_tag(tmpfile, "r", NULL);
+
+        if (rich_string_tuple->format) {
+            /* Write the user defined font format. */
+            lxw_styles_write_rich_font(styles, rich_string_tuple->format);
+        }
+        else {
+            /* Write a default font format. Except for the first fragment. */
+            if (i > 1)
+                lxw_styles_write_rich_font(styles, default_format);
+        }
+
+        lxw_styles_write_string_fragment(styles, rich_string_tuple->string);
+        lxw_xml_end_tag(tmpfile, "r");
+    }
+
+    /* Free the temp objects. */
+    lxw_styles_free(styles);
+    lxw_format_free(default_format);
+
+    /* Flush the file. */
+    fflush(tmpfile);
+
+    if (!rich_string) {
+        /* Read the size to calculate the required memory. */
+        file_size = ftell(tmpfile);
+        /* Allocate a buffer for the rich string xml data. */
+        rich_string = calloc(file_size + 1, 1);
+        GOTO_LABEL_ON_MEM_ERROR(rich_string, mem_error);
+
+        /* Rewind the file and read the data into the memory buffer. */
+        rewind(tmpfile);
+        if (fread((void *) rich_string, file_size, 1, tmpfile) < 1) {
+            fclose(tmpfile);
+            free((void *) rich_string);
+            return LXW_ERROR_READING_TMPFILE;
+        }
+    }
+
+    /* Close the temp file. */
+    fclose(tmpfile);
+
+    if (lxw_utf8_strlen(rich_string) > LXW_STR_MAX) {
+        free((void *) rich_string);
+        return LXW_ERROR_MAX_STRING_LENGTH_EXCEEDED;
+    }
+
+    if (!self->optimize) {
+        /* Get the SST element and string id. */
+        sst_element = lxw_get_sst_index(self->sst, rich_string, LXW_TRUE);
+        free((void *) rich_string);
+
+        if (!sst_element)
+            return LXW_ERROR_SHARED_STRING_INDEX_NOT_FOUND;
+
+        string_id = sst_element->index;
+        cell = _new_string_cell(row_num, col_num, string_id,
+                                sst_element->string, format);
+    }
+    else {
+        /* Look for and escape control chars in the string. */
+        if (lxw_has_control_characters(rich_string)) {
+            string_copy = lxw_escape_control_characters(rich_string);
+            free((void *) rich_string);
+        }
+        else {
+            string_copy = rich_string;
+        }
+        cell = _new_inline_rich_string_cell(row_num, col_num, string_copy,
+                                            format);
+    }
 
-    cond_format->min_value_string =
-        lxw_strdup_formula(user_options->value_string);
+    _insert_cell(self, row_num, col_num, cell);
 
     return LXW_NO_ERROR;
+
+mem_error:
+    lxw_styles_free(styles);
+    lxw_format_free(default_format);
+    fclose(tmpfile);
+
+    return LXW_ERROR_MEMORY_MALLOC_FAILED;
 }
 
+/*
+ * Write a comment to a worksheet cell in Excel.
+ */
 lxw_error
-_validate_conditional_cell(lxw_cond_format_obj *cond_format,
-                           lxw_conditional_format *user_options)
+worksheet_write_comment_opt(lxw_worksheet *self,
+                            lxw_row_t row_num, lxw_col_t col_num,
+                            const char *text, lxw_comment_options *options)
 {
-    cond_format->min_value = user_options->value;
-    cond_format->min_value_string =
-        lxw_strdup_formula(user_options->value_string);
+    lxw_cell *cell;
+    lxw_error err;
+    lxw_vml_obj *comment;
 
-    if (cond_format->criteria == LXW_CONDITIONAL_CRITERIA_BETWEEN
-        || cond_format->criteria == LXW_CONDITIONAL_CRITERIA_NOT_BETWEEN) {
-        cond_format->has_max = LXW_TRUE;
-        cond_format->min_value = user_options->min_value;
-        cond_format->max_value = user_options->max_value;
-        cond_format->min_value_string =
-            lxw_strdup_formula(user_options->min_value_string);
-        cond_format->max_value_string =
-            lxw_strdup_formula(user_options->max_value_string);
-    }
+    err = _check_dimensions(self, row_num, col_num, LXW_FALSE, LXW_FALSE);
+    if (err)
+        return err;
+
+    if (!text)
+        return LXW_ERROR_NULL_PARAMETER_IGNORED;
+
+    if (lxw_str_is_empty(text))
+        return LXW_ERROR_PARAMETER_IS_EMPTY;
+
+    if (lxw_utf8_strlen(text) > LXW_STR_MAX)
+        return LXW_ERROR_MAX_STRING_LENGTH_EXCEEDED;
+
+    comment = calloc(1, sizeof(lxw_vml_obj));
+    GOTO_LABEL_ON_MEM_ERROR(comment, mem_error);
+
+    comment->text = lxw_strdup(text);
+    GOTO_LABEL_ON_MEM_ERROR(comment->text, mem_error);
+
+    comment->row = row_num;
+    comment->col = col_num;
+
+    cell = _new_comment_cell(row_num, col_num, comment);
+    GOTO_LABEL_ON_MEM_ERROR(cell, mem_error);
+
+    _insert_comment(self, row_num, col_num, cell);
+
+    /* Set user and default parameters for the comment. */
+    _get_comment_params(comment, options);
+
+    self->has_vml = LXW_TRUE;
+    self->has_comments = LXW_TRUE;
+
+    /* Insert a placeholder in the cell RB table in the same position so
+     * that the worksheet row "spans" calculations are correct. */
+    _insert_cell_placeholder(self, row_num, col_num);
 
     return LXW_NO_ERROR;
+
+mem_error:
+    if (comment)
+        _free_vml_object(comment);
+
+    return LXW_ERROR_MEMORY_MALLOC_FAILED;
 }
 
-/* Check that the correct criteria and used with the correct conditional format. */
+/*
+ * Write a comment to a worksheet cell in Excel.
+ */
 lxw_error
-_validate_conditional_criteria(lxw_cond_format_obj *cond_format)
+worksheet_write_comment(lxw_worksheet *self,
+                        lxw_row_t row_num, lxw_col_t col_num,
+                        const char *string)
 {
-    uint8_t criteria_mismatch = LXW_FALSE;
+    return worksheet_write_comment_opt(self, row_num, col_num, string, NULL);
+}
 
-    if (cond_format->type == LXW_CONDITIONAL_TYPE_CELL) {
-        switch (cond_format->criteria) {
-            case LXW_CONDITIONAL_CRITERIA_EQUAL_TO:
-            case LXW_CONDITIONAL_CRITERIA_NOT_EQUAL_TO:
-            case LXW_CONDITIONAL_CRITERIA_GREATER_THAN:
-            case LXW_CONDITIONAL_CRITERIA_LESS_THAN:
-            case LXW_CONDITIONAL_CRITERIA_GREATER_THAN_OR_EQUAL_TO:
-            case LXW_CONDITIONAL_CRITERIA_LESS_THAN_OR_EQUAL_TO:
-            case LXW_CONDITIONAL_CRITERIA_BETWEEN:
-            case LXW_CONDITIONAL_CRITERIA_NOT_BETWEEN:
-                criteria_mismatch = LXW_FALSE;
-                break;
-            default:
-                criteria_mismatch = LXW_TRUE;
-        }
-    }
-    else if (cond_format->type == LXW_CONDITIONAL_TYPE_TIME_PERIOD) {
-        switch (cond_format->criteria) {
-            case LXW_CONDITIONAL_CRITERIA_TIME_PERIOD_YESTERDAY:
-            case LXW_CONDITIONAL_CRITERIA_TIME_PERIOD_TODAY:
-            case LXW_CONDITIONAL_CRITERIA_TIME_PERIOD_TOMORROW:
-            case LXW_CONDITIONAL_CRITERIA_TIME_PERIOD_LAST_7_DAYS:
-            case LXW_CONDITIONAL_CRITERIA_TIME_PERIOD_LAST_WEEK:
-            case LXW_CONDITIONAL_CRITERIA_TIME_PERIOD_THIS_WEEK:
-            case LXW_CONDITIONAL_CRITERIA_TIME_PERIOD_NEXT_WEEK:
-            case LXW_CONDITIONAL_CRITERIA_TIME_PERIOD_LAST_MONTH:
-            case LXW_CONDITIONAL_CRITERIA_TIME_PERIOD_THIS_MONTH:
-            case LXW_CONDITIONAL_CRITERIA_TIME_PERIOD_NEXT_MONTH:
-                criteria_mismatch = LXW_FALSE;
-                break;
-            default:
-                criteria_mismatch = LXW_TRUE;
-        }
-    }
-    else if (cond_format->type == LXW_CONDITIONAL_TYPE_TEXT) {
-        switch (cond_format->criteria) {
-            case LXW_CONDITIONAL_CRITERIA_TEXT_CONTAINING:
-            case LXW_CONDITIONAL_CRITERIA_TEXT_NOT_CONTAINING:
-            case LXW_CONDITIONAL_CRITERIA_TEXT_BEGINS_WITH:
-            case LXW_CONDITIONAL_CRITERIA_TEXT_ENDS_WITH:
-                criteria_mismatch = LXW_FALSE;
-                break;
-            default:
-                criteria_mismatch = LXW_TRUE;
-        }
-    }
-    else if (cond_format->type == LXW_CONDITIONAL_TYPE_AVERAGE) {
-        switch (cond_format->criteria) {
-            case LXW_CONDITIONAL_CRITERIA_AVERAGE_ABOVE:
-            case LXW_CONDITIONAL_CRITERIA_AVERAGE_BELOW:
-            case LXW_CONDITIONAL_CRITERIA_AVERAGE_ABOVE_OR_EQUAL:
-            case LXW_CONDITIONAL_CRITERIA_AVERAGE_BELOW_OR_EQUAL:
-            case LXW_CONDITIONAL_CRITERIA_AVERAGE_1_STD_DEV_ABOVE:
-            case LXW_CONDITIONAL_CRITERIA_AVERAGE_1_STD_DEV_BELOW:
-            case LXW_CONDITIONAL_CRITERIA_AVERAGE_2_STD_DEV_ABOVE:
-            case LXW_CONDITIONAL_CRITERIA_AVERAGE_2_STD_DEV_BELOW:
-            case LXW_CONDITIONAL_CRITERIA_AVERAGE_3_STD_DEV_ABOVE:
-            case LXW_CONDITIONAL_CRITERIA_AVERAGE_3_STD_DEV_BELOW:
-                criteria_mismatch = LXW_FALSE;
-                break;
-            default:
-                criteria_mismatch = LXW_TRUE;
-        }
-    }
-    else if (cond_format->type == LXW_CONDITIONAL_TYPE_TOP
-             || cond_format->type == LXW_CONDITIONAL_TYPE_BOTTOM) {
-        switch (cond_format->criteria) {
-            case LXW_CONDITIONAL_CRITERIA_NONE:
-            case LXW_CONDITIONAL_CRITERIA_TOP_OR_BOTTOM_PERCENT:
-                criteria_mismatch = LXW_FALSE;
-                break;
-            default:
-                criteria_mismatch = LXW_TRUE;
-        }
+/*
+ * Set the properties of a single column or a range of columns with options.
+ */
+lxw_error
+worksheet_set_column_opt(lxw_worksheet *self,
+                         lxw_col_t firstcol,
+                         lxw_col_t lastcol,
+                         double width,
+                         lxw_format *format,
+                         lxw_row_col_options *user_options)
+{
+    lxw_col_options *copied_options;
+    uint8_t ignore_row = LXW_TRUE;
+    uint8_t ignore_col = LXW_TRUE;
+    uint8_t hidden = LXW_FALSE;
+    uint8_t level = 0;
+    uint8_t collapsed = LXW_FALSE;
+    lxw_col_t col;
+    lxw_error err;
+
+    if (user_options) {
+        hidden = user_options->hidden;
+        level = user_options->level;
+        collapsed = user_options->collapsed;
     }
-    else {
-        /* Any other conditional type should have a zero criteria. */
-        cond_format->criteria = LXW_CONDITIONAL_CRITERIA_NONE;
+
+    /* Ensure second col is larger than first. */
+    if (firstcol > lastcol) {
+        lxw_col_t tmp = firstcol;
+        firstcol = lastcol;
+        lastcol = tmp;
     }
 
-    if (criteria_mismatch) {
-        LXW_WARN_FORMAT2("worksheet_conditional_format_cell()/_range(): "
-                         "LXW_CONDITIONAL_CRITERIA_* = %d is not valid for "
-                         "LXW_CONDITIONAL_TYPE_* = %d", cond_format->criteria,
-                         cond_format->type);
+    /* Ensure that the cols are valid and store max and min values.
+     * NOTE: The check shouldn't modify the row dimensions and should only
+     *       modify the column dimensions in certain cases. */
+    if (format != NULL || (width != LXW_DEF_COL_WIDTH && hidden))
+        ignore_col = LXW_FALSE;
 
-        return LXW_ERROR_PARAMETER_VALIDATION;
-    }
-    else {
-        return LXW_NO_ERROR;
-    }
-}
+    err = _check_dimensions(self, 0, firstcol, ignore_row, ignore_col);
 
-/*
- * Write the <ignoredErrors> element.
- */
-STATIC void
-_worksheet_write_ignored_errors(lxw_worksheet *self)
-{
-    if (!self->has_ignore_errors)
-        return;
+    if (!err)
+        err = _check_dimensions(self, 0, lastcol, ignore_row, ignore_col);
+
+    if (err)
+        return err;
+
+    /* Resize the col_options array if required. */
+    if (firstcol >= self->col_options_max) {
+        lxw_col_t col_tmp;
+        lxw_col_t old_size = self->col_options_max;
+        lxw_col_t new_size = _next_power_of_two(firstcol + 1);
+        lxw_col_options **new_ptr = realloc(self->col_options,
+                                            new_size *
+                                            sizeof(lxw_col_options *));
+
+        if (new_ptr) {
+            for (col_tmp = old_size; col_tmp < new_size; col_tmp++)
+                new_ptr[col_tmp] = NULL;
+
+            self->col_options = new_ptr;
+            self->col_options_max = new_size;
+        }
+        else {
+            return LXW_ERROR_MEMORY_MALLOC_FAILED;
+        }
+    }
 
-    lxw_xml_start_tag(self->file, "ignoredErrors", NULL);
+    /* Resize the col_formats array if required. */
+    if (lastcol >= self->col_formats_max) {
+        lxw_col_t col;
+        lxw_col_t old_size = self->col_formats_max;
+        lxw_col_t new_size = _next_power_of_two(lastcol + 1);
+        lxw_format **new_ptr = realloc(self->col_formats,
+                                       new_size * sizeof(lxw_format *));
 
-    if (self->ignore_number_stored_as_text) {
-        _worksheet_write_ignored_error(self, "numberStoredAsText",
-                                       self->ignore_number_stored_as_text);
-    }
+        if (new_ptr) {
+            for (col = old_size; col < new_size; col++)
+                new_ptr[col] = NULL;
 
-    if (self->ignore_eval_error) {
-        _worksheet_write_ignored_error(self, "evalError",
-                                       self->ignore_eval_error);
+            self->col_formats = new_ptr;
+            self->col_formats_max = new_size;
+        }
+        else {
+            return LXW_ERROR_MEMORY_MALLOC_FAILED;
+        }
     }
 
-    if (self->ignore_formula_differs) {
-        _worksheet_write_ignored_error(self, "formula",
-                                       self->ignore_formula_differs);
-    }
+    /* Store the column options. */
+    copied_options = calloc(1, sizeof(lxw_col_options));
+    RETURN_ON_MEM_ERROR(copied_options, LXW_ERROR_MEMORY_MALLOC_FAILED);
 
-    if (self->ignore_formula_range) {
-        _worksheet_write_ignored_error(self, "formulaRange",
-                                       self->ignore_formula_range);
-    }
+    /* Ensure the level is <= 7). */
+    if (level > 7)
+        level = 7;
 
-    if (self->ignore_formula_unlocked) {
-        _worksheet_write_ignored_error(self, "unlockedFormula",
-                                       self->ignore_formula_unlocked);
-    }
+    if (level > self->outline_col_level)
+        self->outline_col_level = level;
 
-    if (self->ignore_empty_cell_reference) {
-        _worksheet_write_ignored_error(self, "emptyCellReference",
-                                       self->ignore_empty_cell_reference);
-    }
+    /* Set the column properties. */
+    copied_options->firstcol = firstcol;
+    copied_options->lastcol = lastcol;
+    copied_options->width = width;
+    copied_options->format = format;
+    copied_options->hidden = hidden;
+    copied_options->level = level;
+    copied_options->collapsed = collapsed;
 
-    if (self->ignore_list_data_validation) {
-        _worksheet_write_ignored_error(self, "listDataValidation",
-                                       self->ignore_list_data_validation);
-    }
+    free(self->col_options[firstcol]);
+    self->col_options[firstcol] = copied_options;
 
-    if (self->ignore_calculated_column) {
-        _worksheet_write_ignored_error(self, "calculatedColumn",
-                                       self->ignore_calculated_column);
+    /* Store the column formats for use when writing cell data. */
+    for (col = firstcol; col <= lastcol; col++) {
+        self->col_formats[col] = format;
     }
 
-    if (self->ignore_two_digit_text_year) {
-        _worksheet_write_ignored_error(self, "twoDigitTextYear",
-                                       self->ignore_two_digit_text_year);
-    }
+    /* Store the column change to allow optimizations. */
+    self->col_size_changed = LXW_TRUE;
 
-    lxw_xml_end_tag(self->file, "ignoredErrors");
+    return LXW_NO_ERROR;
 }
 
 /*
- * Write the <tablePart> element.
+ * Set the properties of a single column or a range of columns.
  */
-STATIC void
-_worksheet_write_table_part(lxw_worksheet *self, uint16_t id)
+lxw_error
+worksheet_set_column(lxw_worksheet *self,
+                     lxw_col_t firstcol,
+                     lxw_col_t lastcol, double width, lxw_format *format)
 {
-    struct xml_attribute_list attributes;
-    struct xml_attribute *attribute;
-    char r_id[LXW_MAX_ATTRIBUTE_LENGTH];
-
-    lxw_snprintf(r_id, LXW_ATTR_32, "rId%d", id);
-
-    LXW_INIT_ATTRIBUTES();
-    LXW_PUSH_ATTRIBUTES_STR("r:id", r_id);
-
-    lxw_xml_empty_tag(self->file, "tablePart", &attributes);
-
-    LXW_FREE_ATTRIBUTES();
+    return worksheet_set_column_opt(self, firstcol, lastcol, width, format,
+                                    NULL);
 }
 
 /*
- * Write the <tableParts> element.
+ * Set the properties of a single column or a range of columns, with the
+ * width in pixels.
  */
-STATIC void
-_worksheet_write_table_parts(lxw_worksheet *self)
+lxw_error
+worksheet_set_column_pixels(lxw_worksheet *self,
+                            lxw_col_t firstcol,
+                            lxw_col_t lastcol,
+                            uint32_t pixels, lxw_format *format)
 {
-    struct xml_attribute_list attributes;
-    struct xml_attribute *attribute;
-    lxw_table_obj *table_obj;
-
-    if (!self->table_count)
-        return;
-
-    LXW_INIT_ATTRIBUTES();
-    LXW_PUSH_ATTRIBUTES_INT("count", self->table_count);
-
-    lxw_xml_start_tag(self->file, "tableParts", &attributes);
-
-    STAILQ_FOREACH(table_obj, self->table_objs, list_pointers) {
-        self->rel_count++;
-
-        /* Write the tablePart element. */
-        _worksheet_write_table_part(self, self->rel_count);
-    }
-
-    lxw_xml_end_tag(self->file, "tableParts");
+    double width = _pixels_to_width(pixels);
 
-    LXW_FREE_ATTRIBUTES();
+    return worksheet_set_column_opt(self, firstcol, lastcol, width, format,
+                                    NULL);
 }
 
 /*
- * External functions to call intern XML methods shared with chartsheet.
+ * Set the properties of a single column or a range of columns with options,
+ * with the width in pixels.
  */
-void
-lxw_worksheet_write_sheet_views(lxw_worksheet *self)
+lxw_error
+worksheet_set_column_pixels_opt(lxw_worksheet *self,
+                                lxw_col_t firstcol,
+                                lxw_col_t lastcol,
+                                uint32_t pixels,
+                                lxw_format *format,
+                                lxw_row_col_options *user_options)
 {
-    _worksheet_write_sheet_views(self);
-}
+    double width = _pixels_to_width(pixels);
 
-void
-lxw_worksheet_write_page_margins(lxw_worksheet *self)
-{
-    _worksheet_write_page_margins(self);
+    return worksheet_set_column_opt(self, firstcol, lastcol, width, format,
+                                    user_options);
 }
 
-void
-lxw_worksheet_write_drawings(lxw_worksheet *self)
+/*
+ * Set the precision used to write the numbers in a range of columns.
+ */
+lxw_error
+worksheet_set_column_precision(lxw_worksheet *self,
+                               lxw_col_t firstcol,
+                               lxw_col_t lastcol, uint8_t type,
+                               uint8_t digits)
 {
-    _worksheet_write_drawings(self);
-}
+    lxw_col_t col;
+    lxw_error err;
 
-void
-lxw_worksheet_write_sheet_protection(lxw_worksheet *self,
-                                     lxw_protection_obj *protect)
-{
-    _worksheet_write_sheet_protection(self, protect);
-}
+    /* Ensure second col is larger than first. */
+    if (firstcol > lastcol) {
+        col = firstcol;
+        firstcol = lastcol;
+        lastcol = col;
+    }
 
-void
-lxw_worksheet_write_sheet_pr(lxw_worksheet *self)
-{
-    _worksheet_write_sheet_pr(self);
-}
+    err = _check_dimensions(self, 0, lastcol, LXW_TRUE, LXW_TRUE);
+    if (err)
+        return err;
 
-void
-lxw_worksheet_write_page_setup(lxw_worksheet *self)
-{
-    _worksheet_write_page_setup(self);
-}
+    err = lxw_validate_number_precision(type, digits);
+    if (err) {
+        LXW_WARN_FORMAT2("worksheet_set_column_precision(): invalid "
+                         "precision type %d or digits %d.", type, digits);
+        return err;
+    }
 
-void
-lxw_worksheet_write_header_footer(lxw_worksheet *self)
-{
-    _worksheet_write_header_footer(self);
+    if (!self->col_precision) {
+        self->col_precision = calloc(LXW_COL_MAX,
+                                     sizeof(lxw_number_precision));
+        RETURN_ON_MEM_ERROR(self->col_precision,
+                            LXW_ERROR_MEMORY_MALLOC_FAILED);
+    }
+
+    for (col = firstcol; col <= lastcol; col++) {
+        self->col_precision[col].type = type;
+        self->col_precision[col].digits = digits;
+    }
+
+    return LXW_NO_ERROR;
 }
 
 /*
- * Assemble and write the XML file.
+ * Set the properties of a row with options.
  */
-void
-lxw_worksheet_assemble_xml_file(lxw_worksheet *self)
+lxw_error
+worksheet_set_row_opt(lxw_worksheet *self,
+                      lxw_row_t row_num,
+                      double height,
+                      lxw_format *format, lxw_row_col_options *user_options)
 {
-    /* Write the XML declaration. */
-    _worksheet_xml_declaration(self);
 
-    /* Write the worksheet element. */
-    _worksheet_write_worksheet(self);
+    lxw_col_t min_col;
+    uint8_t hidden = LXW_FALSE;
+    uint8_t level = 0;
+    uint8_t collapsed = LXW_FALSE;
+    lxw_row *row;
+    lxw_error err;
 
-    /* Write the worksheet properties. */
-    _worksheet_write_sheet_pr(self);
+    LXW_ROLLOVER_ROW(self, row_num);
 
-    /* Write the worksheet dimensions. */
-    _worksheet_write_dimension(self);
+    if (user_options) {
+        hidden = user_options->hidden;
+        level = user_options->level;
+        collapsed = user_options->collapsed;
+    }
 
-    /* Write the sheet view properties. */
-    _worksheet_write_sheet_views(self);
+    /* Use minimum col in _check_dimensions(). */
+    if (self->dim_colmin != LXW_COL_MAX)
+        min_col = self->dim_colmin;
+    else
+        min_col = 0;
 
-    /* Write the sheet format properties. */
-    _worksheet_write_sheet_format_pr(self);
+    err = _check_dimensions(self, row_num, min_col, LXW_FALSE, LXW_FALSE);
+    if (err)
+        return err;
 
-    /* Write the sheet column info. */
-    _worksheet_write_cols(self);
+    /* If the height is 0 the row is hidden and the height is the default. */
+    if (height == 0) {
+        hidden = LXW_TRUE;
+        height = self->default_row_height;
+    }
 
-    /* Write the sheetData element. */
-    if (!self->optimize)
-        _worksheet_write_sheet_data(self);
-    else
-        _worksheet_write_optimized_sheet_data(self);
+    /* Ensure the level is <= 7). */
+    if (level > 7)
+        level = 7;
+
+    if (level > self->outline_row_level)
+        self->outline_row_level = level;
 
-    /* Write the sheetProtection element. */
-    _worksheet_write_sheet_protection(self, &self->protection);
+    /* Store the row properties. */
+    row = _get_row(self, row_num);
 
-    /* Write the autoFilter element. */
-    _worksheet_write_auto_filter(self);
+    row->height = height;
+    row->format = format;
+    row->hidden = hidden;
+    row->level = level;
+    row->collapsed = collapsed;
+    row->row_changed = LXW_TRUE;
 
-    /* Write the mergeCells element. */
-    _worksheet_write_merge_cells(self);
+    if (height != self->default_row_height)
+        row->height_changed = LXW_TRUE;
 
-    /* Write the conditionalFormatting elements. */
-    _worksheet_write_conditional_formats(self);
+    return LXW_NO_ERROR;
+}
 
-    /* Write the dataValidations element. */
-    _worksheet_write_data_validations(self);
+/*
+ * Set the properties of a row.
+ */
+lxw_error
+worksheet_set_row(lxw_worksheet *self,
+                  lxw_row_t row_num, double height, lxw_format *format)
+{
+    return worksheet_set_row_opt(self, row_num, height, format, NULL);
+}
 
-    /* Write the hyperlink element. */
-    _worksheet_write_hyperlinks(self);
+/*
+ * Set the properties of a row, with the height in pixels.
+ */
+lxw_error
+worksheet_set_row_pixels(lxw_worksheet *self,
+                         lxw_row_t row_num, uint32_t pixels,
+                         lxw_format *format)
+{
+    double height = _pixels_to_height(pixels);
 
-    /* Write the printOptions element. */
-    _worksheet_write_print_options(self);
+    return worksheet_set_row_opt(self, row_num, height, format, NULL);
+}
 
-    /* Write the worksheet page_margins. */
-    _worksheet_write_page_margins(self);
+/*
+ * Set the properties of a row with options, with the height in pixels.
+ */
+lxw_error
+worksheet_set_row_pixels_opt(lxw_worksheet *self,
+                             lxw_row_t row_num,
+                             uint32_t pixels,
+                             lxw_format *format,
+                             lxw_row_col_options *user_options)
+{
+    double height = _pixels_to_height(pixels);
 
-    /* Write the worksheet page setup. */
-    _worksheet_write_page_setup(self);
+    return worksheet_set_row_opt(self, row_num, height, format, user_options);
+}
 
-    /* Write the headerFooter element. */
-    _worksheet_write_header_footer(self);
+/*
+ * Merge a range of cells. The first cell should contain the data and the others
+ * should be blank. All cells should contain the same format.
+ */
+lxw_error
+worksheet_merge_range(lxw_worksheet *self, lxw_row_t first_row,
+                      lxw_col_t first_col, lxw_row_t last_row,
+                      lxw_col_t last_col, const char *string,
+                      lxw_format *format)
+{
+    lxw_merged_range *merged_range;
+    lxw_row_t tmp_row;
+    lxw_col_t tmp_col;
+    lxw_error err;
 
-    /* Write the rowBreaks element. */
-    _worksheet_write_row_breaks(self);
+    /* Excel doesn't allow a single cell to be merged */
+    if (first_row == last_row && first_col == last_col)
+        return LXW_ERROR_PARAMETER_VALIDATION;
 
-    /* Write the colBreaks element. */
-    _worksheet_write_col_breaks(self);
+    /* Swap last row/col with first row/col as necessary */
+    if (first_row > last_row) {
+        tmp_row = last_row;
+        last_row = first_row;
+        first_row = tmp_row;
+    }
+    if (first_col > last_col) {
+        tmp_col = last_col;
+        last_col = first_col;
+        first_col = tmp_col;
+    }
 
-    /* Write the ignoredErrors element. */
-    _worksheet_write_ignored_errors(self);
+    /* Check that column number is valid and store the max value */
+    err = _check_dimensions(self, last_row, last_col, LXW_FALSE, LXW_FALSE);
+    if (err)
+        return err;
 
-    /* Write the drawing element. */
-    _worksheet_write_drawings(self);
+    /* Store the merge range. */
+    merged_range = calloc(1, sizeof(lxw_merged_range));
+    RETURN_ON_MEM_ERROR(merged_range, LXW_ERROR_MEMORY_MALLOC_FAILED);
 
-    /* Write the legacyDrawing element. */
-    _worksheet_write_legacy_drawing(self);
+    merged_range->first_row = first_row;
+    merged_range->first_col = first_col;
+    merged_range->last_row = last_row;
+    merged_range->last_col = last_col;
 
-    /* Write the legacyDrawingHF element. */
-    _worksheet_write_legacy_drawing_hf(self);
+    STAILQ_INSERT_TAIL(self->merged_ranges, merged_range, list_pointers);
+    self->merged_range_count++;
 
-    /* Write the picture element. */
-    _worksheet_write_picture(self);
+    /* Write the first cell */
+    worksheet_write_string(self, first_row, first_col, string, format);
 
-    /* Write the tableParts element. */
-    _worksheet_write_table_parts(self);
+    /* Pad out the rest of the area with formatted blank cells. */
+    for (tmp_row = first_row; tmp_row <= last_row; tmp_row++) {
+        for (tmp_col = first_col; tmp_col <= last_col; tmp_col++) {
+            if (tmp_row == first_row && tmp_col == first_col)
+                continue;
 
-    /* Write the extLst element. */
-    _worksheet_write_ext_list(self);
+            worksheet_write_blank(self, tmp_row, tmp_col, format);
+        }
+    }
 
-    /* Close the worksheet tag. */
-    lxw_xml_end_tag(self->file, "worksheet");
+    return LXW_NO_ERROR;
 }
 
-/*****************************************************************************
- *
- * Public functions.
- *
- ****************************************************************************/
-
 /*
- * Write a number to a cell in Excel.
+ * Set the autofilter area in the worksheet.
  */
 lxw_error
-worksheet_write_number(lxw_worksheet *self,
-                       lxw_row_t row_num,
-                       lxw_col_t col_num, double value, lxw_format *format)
+worksheet_autofilter(lxw_worksheet *self, lxw_row_t first_row,
+                     lxw_col_t first_col, lxw_row_t last_row,
+                     lxw_col_t last_col)
 {
-    lxw_cell *cell;
+    lxw_row_t tmp_row;
+    lxw_col_t tmp_col;
     lxw_error err;
+    lxw_filter_rule_obj **filter_rules;
+    lxw_col_t num_filter_rules;
 
-    err = _check_dimensions(self, row_num, col_num, LXW_FALSE, LXW_FALSE);
+    /* Swap last row/col with first row/col as necessary */
+    if (first_row > last_row) {
+        tmp_row = last_row;
+        last_row = first_row;
+        first_row = tmp_row;
+    }
+    if (first_col > last_col) {
+        tmp_col = last_col;
+        last_col = first_col;
+        first_col = tmp_col;
+    }
+
+    /* Check that column number is valid and store the max value */
+    err = _check_dimensions(self, last_row, last_col, LXW_FALSE, LXW_FALSE);
     if (err)
         return err;
 
-    cell = _new_number_cell(row_num, col_num, value, format);
+    /* Create a array to hold filter rules. */
+    self->autofilter.in_use = LXW_FALSE;
+    self->autofilter.has_rules = LXW_FALSE;
+    _free_filter_rules(self);
+    num_filter_rules = last_col - first_col + 1;
+    filter_rules = calloc(num_filter_rules, sizeof(lxw_filter_rule_obj *));
+    RETURN_ON_MEM_ERROR(filter_rules, LXW_ERROR_MEMORY_MALLOC_FAILED);
 
-    _insert_cell(self, row_num, col_num, cell);
+    self->autofilter.in_use = LXW_TRUE;
+    self->autofilter.first_row = first_row;
+    self->autofilter.first_col = first_col;
+    self->autofilter.last_row = last_row;
+    self->autofilter.last_col = last_col;
+
+    self->filter_rules = filter_rules;
+    self->num_filter_rules = num_filter_rules;
 
     return LXW_NO_ERROR;
 }
 
 /*
- * Write a string to an Excel file.
+ * Set a autofilter rule for a filter column.
  */
 lxw_error
-worksheet_write_string(lxw_worksheet *self,
-                       lxw_row_t row_num,
-                       lxw_col_t col_num, const char *string,
-                       lxw_format *format)
+worksheet_filter_column(lxw_worksheet *self, lxw_col_t col,
+                        lxw_filter_rule *rule)
 {
-    lxw_cell *cell;
-    int32_t string_id;
-    char *string_copy;
-    struct sst_element *sst_element;
-    lxw_error err;
+    lxw_filter_rule_obj *rule_obj;
+    uint16_t rule_index;
 
-    if (!string || !*string) {
-        /* Treat a NULL or empty string with formatting as a blank cell. */
-        /* Null strings without formats should be ignored.      */
-        if (format)
-            return worksheet_write_blank(self, row_num, col_num, format);
-        else
-            return LXW_NO_ERROR;
+    if (!rule) {
+        LXW_WARN("worksheet_filter_column(): rule parameter cannot be NULL");
+        return LXW_ERROR_PARAMETER_VALIDATION;
     }
 
-    err = _check_dimensions(self, row_num, col_num, LXW_FALSE, LXW_FALSE);
-    if (err)
-        return err;
+    if (self->autofilter.in_use == LXW_FALSE) {
+        LXW_WARN("worksheet_filter_column(): "
+                 "Worksheet autofilter range hasn't been defined. "
+                 "Use worksheet_autofilter() first.");
+        return LXW_ERROR_PARAMETER_VALIDATION;
+    }
 
-    if (lxw_utf8_strlen(string) > LXW_STR_MAX)
-        return LXW_ERROR_MAX_STRING_LENGTH_EXCEEDED;
+    if (col < self->autofilter.first_col || col > self->autofilter.last_col) {
+        LXW_WARN_FORMAT3("worksheet_filter_column(): "
+                         "Column '%d' is outside autofilter range "
+                         "'%d <= col <= %d'.", col,
+                         self->autofilter.first_col,
+                         self->autofilter.last_col);
+        return LXW_ERROR_PARAMETER_VALIDATION;
+    }
 
-    if (!self->optimize) {
-        /* Get the SST element and string id. */
-        sst_element = lxw_get_sst_index(self->sst, string, LXW_FALSE);
+    /* Free any previous rule in the column slot. */
+    rule_index = col - self->autofilter.first_col;
+    _free_filter_rule(self->filter_rules[rule_index]);
 
-        if (!sst_element)
-            return LXW_ERROR_SHARED_STRING_INDEX_NOT_FOUND;
+    /* Create a new rule and copy user input. */
+    rule_obj = calloc(1, sizeof(lxw_filter_rule_obj));
+    RETURN_ON_MEM_ERROR(rule_obj, LXW_ERROR_MEMORY_MALLOC_FAILED);
 
-        string_id = sst_element->index;
-        cell = _new_string_cell(row_num, col_num, string_id,
-                                sst_element->string, format);
+    rule_obj->col_num = rule_index;
+    rule_obj->type = LXW_FILTER_TYPE_SINGLE;
+    rule_obj->criteria1 = rule->criteria;
+    rule_obj->value1 = rule->value;
+
+    if (rule_obj->criteria1 != LXW_FILTER_CRITERIA_NON_BLANKS) {
+        rule_obj->value1_string = lxw_strdup(rule->value_string);
     }
-    else {
-        /* Look for and escape control chars in the string. */
-        if (lxw_has_control_characters(string)) {
-            string_copy = lxw_escape_control_characters(string);
-        }
-        else {
-            string_copy = lxw_strdup(string);
-        }
-        cell = _new_inline_string_cell(row_num, col_num, string_copy, format);
+    else {
+        rule_obj->criteria1 = LXW_FILTER_CRITERIA_NOT_EQUAL_TO;
+        rule_obj->value1_string = lxw_strdup(" ");
     }
 
-    _insert_cell(self, row_num, col_num, cell);
+    if (rule_obj->criteria1 == LXW_FILTER_CRITERIA_BLANKS)
+        rule_obj->has_blanks = LXW_TRUE;
+
+    _set_custom_filter(rule_obj);
+
+    self->filter_rules[rule_index] = rule_obj;
+    self->filter_on = LXW_TRUE;
+    self->autofilter.has_rules = LXW_TRUE;
 
     return LXW_NO_ERROR;
 }
 
 /*
- * Write a formula with a numerical result to a cell in Excel.
+ * Set two autofilter rules for a filter column.
  */
 lxw_error
-worksheet_write_formula_num(lxw_worksheet *self,
-                            lxw_row_t row_num,
-                            lxw_col_t col_num,
-                            const char *formula,
-                            lxw_format *format, double result)
+worksheet_filter_column2(lxw_worksheet *self, lxw_col_t col,
+                         lxw_filter_rule *rule1, lxw_filter_rule *rule2,
+                         uint8_t and_or)
 {
-    lxw_cell *cell;
-    char *formula_copy;
-    lxw_error err;
+    lxw_filter_rule_obj *rule_obj;
+    uint16_t rule_index;
 
-    if (!formula)
-        return LXW_ERROR_NULL_PARAMETER_IGNORED;
+    if (!rule1 || !rule2) {
+        LXW_WARN("worksheet_filter_column2(): rule parameter cannot be NULL");
+        return LXW_ERROR_PARAMETER_VALIDATION;
+    }
 
-    if (lxw_str_is_empty(formula))
-        return LXW_ERROR_PARAMETER_IS_EMPTY;
+    if (self->autofilter.in_use == LXW_FALSE) {
+        LXW_WARN("worksheet_filter_column2(): "
+                 "Worksheet autofilter range hasn't been defined. "
+                 "Use worksheet_autofilter() first.");
+        return LXW_ERROR_PARAMETER_VALIDATION;
+    }
 
-    err = _check_dimensions(self, row_num, col_num, LXW_FALSE, LXW_FALSE);
-    if (err)
-        return err;
+    if (col < self->autofilter.first_col || col > self->autofilter.last_col) {
+        LXW_WARN_FORMAT3("worksheet_filter_column2(): "
+                         "Column '%d' is outside autofilter range "
+                         "'%d <= col <= %d'.", col,
+                         self->autofilter.first_col,
+                         self->autofilter.last_col);
+        return LXW_ERROR_PARAMETER_VALIDATION;
+    }
 
-    /* Strip leading "=" from formula. */
-    if (formula[0] == '=')
-        formula_copy = lxw_strdup(formula + 1);
-    else
-        formula_copy = lxw_strdup(formula);
+    /* Free any previous rule in the column slot. */
+    rule_index = col - self->autofilter.first_col;
+    _free_filter_rule(self->filter_rules[rule_index]);
 
-    cell = _new_formula_cell(row_num, col_num, formula_copy, format);
-    cell->formula_result = result;
+    /* Create a new rule and copy user input. */
+    rule_obj = calloc(1, sizeof(lxw_filter_rule_obj));
+    RETURN_ON_MEM_ERROR(rule_obj, LXW_ERROR_MEMORY_MALLOC_FAILED);
 
-    _insert_cell(self, row_num, col_num, cell);
+    if (and_or == LXW_FILTER_AND)
+        rule_obj->type = LXW_FILTER_TYPE_AND;
+    else
+        rule_obj->type = LXW_FILTER_TYPE_OR;
 
-    return LXW_NO_ERROR;
-}
+    rule_obj->col_num = rule_index;
 
-/*
- * Write a formula with a string result to a cell in Excel.
- */
-lxw_error
-worksheet_write_formula_str(lxw_worksheet *self,
-                            lxw_row_t row_num,
-                            lxw_col_t col_num,
-                            const char *formula,
-                            lxw_format *format, const char *result)
-{
-    lxw_cell *cell;
-    char *formula_copy;
-    lxw_error err;
+    rule_obj->criteria1 = rule1->criteria;
+    rule_obj->value1 = rule1->value;
 
-    if (!formula)
-        return LXW_ERROR_NULL_PARAMETER_IGNORED;
+    rule_obj->criteria2 = rule2->criteria;
+    rule_obj->value2 = rule2->value;
 
-    if (lxw_str_is_empty(formula))
-        return LXW_ERROR_PARAMETER_IS_EMPTY;
+    if (rule_obj->criteria1 != LXW_FILTER_CRITERIA_NON_BLANKS) {
+        rule_obj->value1_string = lxw_strdup(rule1->value_string);
+    }
+    else {
+        rule_obj->criteria1 = LXW_FILTER_CRITERIA_NOT_EQUAL_TO;
+        rule_obj->value1_string = lxw_strdup(" ");
+    }
 
-    err = _check_dimensions(self, row_num, col_num, LXW_FALSE, LXW_FALSE);
-    if (err)
-        return err;
+    if (rule_obj->criteria2 != LXW_FILTER_CRITERIA_NON_BLANKS) {
+        rule_obj->value2_string = lxw_strdup(rule2->value_string);
+    }
+    else {
+        rule_obj->criteria2 = LXW_FILTER_CRITERIA_NOT_EQUAL_TO;
+        rule_obj->value2_string = lxw_strdup(" ");
+    }
 
-    /* Strip leading "=" from formula. */
-    if (formula[0] == '=')
-        formula_copy = lxw_strdup(formula + 1);
-    else
-        formula_copy = lxw_strdup(formula);
+    if (rule_obj->criteria1 == LXW_FILTER_CRITERIA_BLANKS)
+        rule_obj->has_blanks = LXW_TRUE;
 
-    cell = _new_formula_cell(row_num, col_num, formula_copy, format);
-    cell->user_data2 = lxw_strdup(result);
+    if (rule_obj->criteria2 == LXW_FILTER_CRITERIA_BLANKS)
+        rule_obj->has_blanks = LXW_TRUE;
 
-    _insert_cell(self, row_num, col_num, cell);
+    _set_custom_filter(rule_obj);
 
-    return LXW_NO_ERROR;
-}
+    self->filter_rules[rule_index] = rule_obj;
+    self->filter_on = LXW_TRUE;
+    self->autofilter.has_rules = LXW_TRUE;
 
-/*
- * Write a formula with a default result to a cell in Excel .
- */
-lxw_error
-worksheet_write_formula(lxw_worksheet *self,
-                        lxw_row_t row_num,
-                        lxw_col_t col_num, const char *formula,
-                        lxw_format *format)
-{
-    return worksheet_write_formula_num(self, row_num, col_num, formula,
-                                       format, 0);
+    return LXW_NO_ERROR;
 }
 
 /*
- * Internal shared function for various array formula functions.
+ * Set two autofilter rules for a filter column.
  */
 lxw_error
-_store_array_formula(lxw_worksheet *self,
-                     lxw_row_t first_row,
-                     lxw_col_t first_col,
-                     lxw_row_t last_row,
-                     lxw_col_t last_col,
-                     const char *formula, lxw_format *format, double result,
-                     uint8_t is_dynamic)
+worksheet_filter_list(lxw_worksheet *self, lxw_col_t col, const char **list)
 {
-    lxw_cell *cell;
-    lxw_row_t tmp_row;
-    lxw_col_t tmp_col;
-    char *formula_copy;
-    char *range;
-    lxw_error err;
+    lxw_filter_rule_obj *rule_obj;
+    uint16_t rule_index;
+    uint8_t has_blanks = LXW_FALSE;
+    uint16_t num_filters = 0;
+    uint16_t input_list_index;
+    uint16_t rule_obj_list_index;
+    const char *str;
+    char **tmp_list;
 
-    /* Swap last row/col with first row/col as necessary */
-    if (first_row > last_row) {
-        tmp_row = last_row;
-        last_row = first_row;
-        first_row = tmp_row;
-    }
-    if (first_col > last_col) {
-        tmp_col = last_col;
-        last_col = first_col;
-        first_col = tmp_col;
+    if (!list) {
+        LXW_WARN("worksheet_filter_list(): list parameter cannot be NULL");
+        return LXW_ERROR_PARAMETER_VALIDATION;
     }
 
-    if (!formula)
-        return LXW_ERROR_NULL_PARAMETER_IGNORED;
-
-    if (lxw_str_is_empty(formula))
-        return LXW_ERROR_PARAMETER_IS_EMPTY;
-
-    /* Check that row and col are valid and store max and min values. */
-    err = _check_dimensions(self, first_row, first_col, LXW_FALSE, LXW_FALSE);
-    if (err)
-        return err;
-
-    err = _check_dimensions(self, last_row, last_col, LXW_FALSE, LXW_FALSE);
-    if (err)
-        return err;
-
-    /* Define the array range. */
-    range = calloc(1, LXW_MAX_CELL_RANGE_LENGTH);
-    RETURN_ON_MEM_ERROR(range, LXW_ERROR_MEMORY_MALLOC_FAILED);
+    if (self->autofilter.in_use == LXW_FALSE) {
+        LXW_WARN("worksheet_filter_list(): "
+                 "Worksheet autofilter range hasn't been defined. "
+                 "Use worksheet_autofilter() first.");
+        return LXW_ERROR_PARAMETER_VALIDATION;
+    }
 
-    if (first_row == last_row && first_col == last_col)
-        lxw_rowcol_to_cell(range, first_row, first_col);
-    else
-        lxw_rowcol_to_range(range, first_row, first_col, last_row, last_col);
+    if (col < self->autofilter.first_col || col > self->autofilter.last_col) {
+        LXW_WARN_FORMAT3("worksheet_filter_list(): "
+                         "Column '%d' is outside autofilter range "
+                         "'%d <= col <= %d'.", col,
+                         self->autofilter.first_col,
+                         self->autofilter.last_col);
+        return LXW_ERROR_PARAMETER_VALIDATION;
+    }
 
-    /* Copy and trip leading "{=" from formula. */
-    if (formula[0] == '{')
-        if (strlen(formula) >= 2 && formula[1] == '=')
-            formula_copy = lxw_strdup(formula + 2);
+    /* Count the number of non "Blanks" strings in the input list. */
+    input_list_index = 0;
+    while ((str = list[input_list_index]) != NULL) {
+        if (strncmp(str, "Blanks", 6) == 0)
+            has_blanks = LXW_TRUE;
         else
-            formula_copy = lxw_strdup(formula + 1);
-    else
-        formula_copy = lxw_strdup_formula(formula);
+            num_filters++;
 
-    /* Strip trailing "}" from formula. */
-    if (strlen(formula_copy) > 0
-        && formula_copy[strlen(formula_copy) - 1] == '}') {
-        formula_copy[strlen(formula_copy) - 1] = '\0';
+        input_list_index++;
     }
 
-    /* Check for empty formula that started as {=}. */
-    if (lxw_str_is_empty(formula_copy)) {
-        free(formula_copy);
-        free(range);
-        return LXW_ERROR_PARAMETER_IS_EMPTY;
+    /* There should be at least one filter string. */
+    if (num_filters == 0) {
+        LXW_WARN("worksheet_filter_list(): "
+                 "list must have at least 1 non-blanks item.");
+        return LXW_ERROR_PARAMETER_VALIDATION;
     }
 
-    /* Create a new array formula cell object. */
-    cell = _new_array_formula_cell(first_row, first_col,
-                                   formula_copy, range, format, is_dynamic);
-
-    cell->formula_result = result;
-
-    _insert_cell(self, first_row, first_col, cell);
+    /* Free any previous rule in the column slot. */
+    rule_index = col - self->autofilter.first_col;
+    _free_filter_rule(self->filter_rules[rule_index]);
 
-    if (is_dynamic)
-        self->has_dynamic_functions = LXW_TRUE;
+    /* Create a new rule and copy user input. */
+    rule_obj = calloc(1, sizeof(lxw_filter_rule_obj));
+    RETURN_ON_MEM_ERROR(rule_obj, LXW_ERROR_MEMORY_MALLOC_FAILED);
 
-    /* Pad out the rest of the area with formatted zeroes. */
-    if (!self->optimize) {
-        for (tmp_row = first_row; tmp_row <= last_row; tmp_row++) {
-            for (tmp_col = first_col; tmp_col <= last_col; tmp_col++) {
-                if (tmp_row == first_row && tmp_col == first_col)
-                    continue;
+    tmp_list = calloc(num_filters + 1, sizeof(char *));
+    GOTO_LABEL_ON_MEM_ERROR(tmp_list, mem_error);
 
-                worksheet_write_number(self, tmp_row, tmp_col, 0, format);
-            }
+    /* Copy input list (without any "Blanks" command) to an internal list. */
+    input_list_index = 0;
+    rule_obj_list_index = 0;
+    while ((str = list[input_list_index]) != NULL) {
+        if (strncmp(str, "Blanks", 6) != 0) {
+            tmp_list[rule_obj_list_index] = lxw_strdup(str);
+            rule_obj_list_index++;
         }
+
+        input_list_index++;
     }
 
-    return LXW_NO_ERROR;
-}
+    rule_obj->list = tmp_list;
+    rule_obj->num_list_filters = num_filters;
+    rule_obj->is_custom = LXW_FALSE;
+    rule_obj->col_num = rule_index;
+    rule_obj->type = LXW_FILTER_TYPE_STRING_LIST;
+    rule_obj->has_blanks = has_blanks;
 
-/*
- * Write an array formula with a numerical result to a cell in Excel.
- */
-lxw_error
-worksheet_write_array_formula_num(lxw_worksheet *self,
-                                  lxw_row_t first_row,
-                                  lxw_col_t first_col,
-                                  lxw_row_t last_row,
-                                  lxw_col_t last_col,
-                                  const char *formula,
-                                  lxw_format *format, double result)
-{
-    return _store_array_formula(self, first_row, first_col,
-                                last_row, last_col, formula, format, result,
-                                LXW_FALSE);
-}
+    self->filter_rules[rule_index] = rule_obj;
+    self->filter_on = LXW_TRUE;
+    self->autofilter.has_rules = LXW_TRUE;
 
-/*
- * Write an array formula with a default result to a cell in Excel.
- */
-lxw_error
-worksheet_write_array_formula(lxw_worksheet *self,
-                              lxw_row_t first_row,
-                              lxw_col_t first_col,
-                              lxw_row_t last_row,
-                              lxw_col_t last_col,
-                              const char *formula, lxw_format *format)
-{
-    return _store_array_formula(self, first_row, first_col,
-                                last_row, last_col, formula, format, 0,
-                                LXW_FALSE);
-}
+    return LXW_NO_ERROR;
 
-/*
- * Write a single cell dynamic array formula with a default result to a cell.
- */
-lxw_error
-worksheet_write_dynamic_formula(lxw_worksheet *self,
-                                lxw_row_t row,
-                                lxw_col_t col,
-                                const char *formula, lxw_format *format)
-{
-    return _store_array_formula(self, row, col, row, col, formula, format, 0,
-                                LXW_TRUE);
-}
+mem_error:
+    free(rule_obj);
+    return LXW_ERROR_MEMORY_MALLOC_FAILED;
 
-/*
- * Write a single cell dynamic array formula with a numerical result to a cell.
- */
-lxw_error
-worksheet_write_dynamic_formula_num(lxw_worksheet *self,
-                                    lxw_row_t row,
-                                    lxw_col_t col,
-                                    const char *formula,
-                                    lxw_format *format, double result)
-{
-    return _store_array_formula(self, row, col, row, col, formula, format,
-                                result, LXW_TRUE);
 }
 
 /*
- * Write a dynamic array formula with a numerical result to a cell in Excel.
+ * Hide the rows that don't match the autofilter rules when the file is
+ * closed.
  */
 lxw_error
-worksheet_write_dynamic_array_formula_num(lxw_worksheet *self,
-                                          lxw_row_t first_row,
-                                          lxw_col_t first_col,
-                                          lxw_row_t last_row,
-                                          lxw_col_t last_col,
-                                          const char *formula,
-                                          lxw_format *format, double result)
+worksheet_hide_filtered_rows(lxw_worksheet *self)
 {
-    return _store_array_formula(self, first_row, first_col,
-                                last_row, last_col, formula, format, result,
-                                LXW_TRUE);
-}
+    if (self->optimize) {
+        LXW_WARN("worksheet_hide_filtered_rows(): "
+                 "function isn't supported in 'constant_memory' mode.");
+        return LXW_ERROR_FEATURE_NOT_SUPPORTED;
+    }
 
-/*
- * Write a dynamic array formula with a default result to a cell in Excel.
- */
-lxw_error
-worksheet_write_dynamic_array_formula(lxw_worksheet *self,
-                                      lxw_row_t first_row,
-                                      lxw_col_t first_col,
-                                      lxw_row_t last_row,
-                                      lxw_col_t last_col,
-                                      const char *formula, lxw_format *format)
-{
-    return _store_array_formula(self, first_row, first_col,
-                                last_row, last_col, formula, format, 0,
-                                LXW_TRUE);
+    self->hide_filtered_rows = LXW_TRUE;
+
+    return LXW_NO_ERROR;
 }
 
 /*
- * Write a blank cell with a format to a cell in Excel.
+ * Add an Excel table to the worksheet.
  */
 lxw_error
-worksheet_write_blank(lxw_worksheet *self,
-                      lxw_row_t row_num, lxw_col_t col_num,
-                      lxw_format *format)
+worksheet_add_table(lxw_worksheet *self, lxw_row_t first_row,
+                    lxw_col_t first_col, lxw_row_t last_row,
+                    lxw_col_t last_col, lxw_table_options *user_options)
 {
-    lxw_cell *cell;
+    lxw_row_t tmp_row;
+    lxw_col_t tmp_col;
+    lxw_col_t num_cols;
     lxw_error err;
+    lxw_table_obj *table_obj;
+    lxw_table_column **columns;
 
-    /* Blank cells without formatting are ignored by Excel. */
-    if (!format)
-        return LXW_NO_ERROR;
+    if (self->optimize) {
+        LXW_WARN_FORMAT("worksheet_add_table(): "
+                        "worksheet tables aren't supported in "
+                        "'constant_memory' mode");
+        return LXW_ERROR_FEATURE_NOT_SUPPORTED;
+    }
 
-    err = _check_dimensions(self, row_num, col_num, LXW_FALSE, LXW_FALSE);
+    /* Swap last row/col with first row/col as necessary */
+    if (first_row > last_row) {
+        tmp_row = last_row;
+        last_row = first_row;
+        first_row = tmp_row;
+    }
+    if (first_col > last_col) {
+        tmp_col = last_col;
+        last_col = first_col;
+        first_col = tmp_col;
+    }
+
+    /* Check that column number is valid and store the max value */
+    err = _check_dimensions(self, last_row, last_col, LXW_TRUE, LXW_TRUE);
     if (err)
         return err;
 
-    cell = _new_blank_cell(row_num, col_num, format);
-
-    _insert_cell(self, row_num, col_num, cell);
-
-    return LXW_NO_ERROR;
-}
+    if (_check_rollover_limit(self, last_row))
+        return LXW_ERROR_WORKSHEET_INDEX_OUT_OF_RANGE;
 
-/*
- * Write a boolean cell with a format to a cell in Excel.
- */
-lxw_error
-worksheet_write_boolean(lxw_worksheet *self,
-                        lxw_row_t row_num, lxw_col_t col_num,
-                        int value, lxw_format *format)
-{
-    lxw_cell *cell;
-    lxw_error err;
+    num_cols = last_col - first_col + 1;
 
-    err = _check_dimensions(self, row_num, col_num, LXW_FALSE, LXW_FALSE);
+    /* Check that there are sufficient data rows. */
+    err = _check_table_rows(first_row, last_row, user_options);
     if (err)
         return err;
 
-    cell = _new_boolean_cell(row_num, col_num, value, format);
+    /* Check that the the table name is valid. */
+    err = _check_table_name(user_options);
+    if (err)
+        return err;
 
-    _insert_cell(self, row_num, col_num, cell);
+    /* Create a table object to copy from the user options. */
+    table_obj = calloc(1, sizeof(lxw_table_obj));
+    RETURN_ON_MEM_ERROR(table_obj, LXW_ERROR_MEMORY_MALLOC_FAILED);
 
-    return LXW_NO_ERROR;
-}
+    columns = calloc(num_cols, sizeof(lxw_table_column *));
+    GOTO_LABEL_ON_MEM_ERROR(columns, error);
 
-/*
- * Write a date and or time to a cell in Excel.
- */
-lxw_error
-worksheet_write_datetime(lxw_worksheet *self,
-                         lxw_row_t row_num,
-                         lxw_col_t col_num, lxw_datetime *datetime,
-                         lxw_format *format)
-{
-    lxw_cell *cell;
-    double excel_date;
-    lxw_error err;
+    table_obj->columns = columns;
+    table_obj->num_cols = num_cols;
+    table_obj->first_row = first_row;
+    table_obj->first_col = first_col;
+    table_obj->last_row = last_row;
+    table_obj->last_col = last_col;
 
-    err = _check_dimensions(self, row_num, col_num, LXW_FALSE, LXW_FALSE);
+    err = _set_default_table_columns(table_obj);
     if (err)
-        return err;
+        goto error;
 
-    printf("worksheet_write_datetime(): %d-%02d-%02d - 1904: %d\n",
-           datetime->year, datetime->month, datetime->day,
-           self->use_1904_epoch);
+    /* Create the table range. */
+    lxw_rowcol_to_range(table_obj->sqref,
+                        first_row, first_col, last_row, last_col);
+    lxw_rowcol_to_range(table_obj->filter_sqref,
+                        first_row, first_col, last_row, last_col);
 
-    excel_date =
-        lxw_datetime_to_excel_date_with_epoch(datetime, self->use_1904_epoch);
+    /* Validate and copy user options to an internal object. */
+    if (user_options) {
+
+        _check_and_copy_table_style(table_obj, user_options);
+
+        table_obj->total_row = user_options->total_row;
+        table_obj->last_column = user_options->last_column;
+        table_obj->first_column = user_options->first_column;
+        table_obj->no_autofilter = user_options->no_autofilter;
+        table_obj->no_header_row = user_options->no_header_row;
+        table_obj->no_banded_rows = user_options->no_banded_rows;
+        table_obj->banded_columns = user_options->banded_columns;
+
+        if (user_options->no_header_row)
+            table_obj->no_autofilter = LXW_TRUE;
+
+        if (user_options->columns) {
+            err = _set_custom_table_columns(table_obj, user_options);
+            if (err)
+                goto error;
+        }
+
+        if (user_options->total_row) {
+            lxw_rowcol_to_range(table_obj->filter_sqref,
+                                first_row, first_col, last_row - 1, last_col);
+        }
+
+        if (user_options->name) {
+            table_obj->name = lxw_strdup(user_options->name);
+            if (!table_obj->name) {
+                err = LXW_ERROR_MEMORY_MALLOC_FAILED;
+                goto error;
+            }
+        }
+    }
 
-    cell = _new_number_cell(row_num, col_num, excel_date, format);
+    _write_table_column_data(self, table_obj);
 
-    _insert_cell(self, row_num, col_num, cell);
+    STAILQ_INSERT_TAIL(self->table_objs, table_obj, list_pointers);
+    self->table_count++;
 
     return LXW_NO_ERROR;
+
+error:
+    _free_worksheet_table(table_obj);
+    return err;
+
 }
 
 /*
- * Write a date and or time to a cell in Excel.
+ * Copy a NULL terminated list of pivot table field names.
  */
-lxw_error
-worksheet_write_unixtime(lxw_worksheet *self,
-                         lxw_row_t row_num,
-                         lxw_col_t col_num,
-                         int64_t unixtime, lxw_format *format)
+STATIC lxw_error
+_copy_pivot_field_names(const char **names, char ***field_names,
+                        uint16_t *num_fields)
 {
-    lxw_cell *cell;
-    double excel_date;
-    lxw_error err;
+    uint16_t i;
+    uint16_t count = 0;
 
-    err = _check_dimensions(self, row_num, col_num, LXW_FALSE, LXW_FALSE);
-    if (err)
-        return err;
+    if (!names)
+        return LXW_NO_ERROR;
 
-    excel_date =
-        lxw_unixtime_to_excel_date_with_epoch(unixtime, self->use_1904_epoch);
+    while (names[count])
+        count++;
 
-    cell = _new_number_cell(row_num, col_num, excel_date, format);
+    if (!count)
+        return LXW_NO_ERROR;
 
-    _insert_cell(self, row_num, col_num, cell);
+    *field_names = calloc(count, sizeof(char *));
+    RETURN_ON_MEM_ERROR(*field_names, LXW_ERROR_MEMORY_MALLOC_FAILED);
+
+    for (i = 0; i < count; i++) {
+        (*field_names)[i] = lxw_strdup(names[i]);
+        RETURN_ON_MEM_ERROR((*field_names)[i],
+                            LXW_ERROR_MEMORY_MALLOC_FAILED);
+        (*num_fields)++;
+    }
 
     return LXW_NO_ERROR;
 }
 
 /*
- * Write a hyperlink/url to an Excel file.
+ * Add a pivot table to a worksheet.
  */
 lxw_error
-worksheet_write_url_opt(lxw_worksheet *self,
-                        lxw_row_t row_num,
-                        lxw_col_t col_num, const char *url,
-                        lxw_format *user_format, const char *string,
-                        const char *tooltip)
+worksheet_add_pivot_table(lxw_worksheet *self, lxw_row_t row, lxw_col_t col,
+                          lxw_pivot_table_options *user_options)
 {
-    lxw_cell *link;
-    char *string_copy = NULL;
-    char *url_copy = NULL;
-    char *url_external = NULL;
-    char *url_string = NULL;
-    char *tooltip_copy = NULL;
-    char *found_string;
-    char *tmp_string = NULL;
-    lxw_format *format = NULL;
-    size_t string_size;
-    size_t i;
-    lxw_error err = LXW_ERROR_MEMORY_MALLOC_FAILED;
-    enum cell_types link_type = HYPERLINK_URL;
+    lxw_error err;
+    lxw_pivot_table_obj *pivot_obj;
+    lxw_pivot_data_field *data_field;
+    uint16_t num_data_fields = 0;
+    uint16_t i;
 
-    if (!url || !*url)
+    if (!user_options || !user_options->source) {
+        LXW_WARN("worksheet_add_pivot_table(): "
+                 "the source worksheet must be specified");
         return LXW_ERROR_NULL_PARAMETER_IGNORED;
+    }
 
-    /* Check the Excel limit of URLS per worksheet. */
-    if (self->hlink_count > LXW_MAX_NUMBER_URLS) {
-        LXW_WARN("worksheet_write_url()/_opt(): URL ignored since it exceeds "
-                 "the maximum number of allowed worksheet URLs (65530).");
-        return LXW_ERROR_WORKSHEET_MAX_NUMBER_URLS_EXCEEDED;
+    if (user_options->source->optimize) {
+        LXW_WARN("worksheet_add_pivot_table(): "
+                 "pivot table source data isn't supported from a "
+                 "'constant_memory' worksheet");
+        return LXW_ERROR_FEATURE_NOT_SUPPORTED;
     }
 
-    err = _check_dimensions(self, row_num, col_num, LXW_FALSE, LXW_FALSE);
+    if (user_options->first_row > user_options->last_row
+        || user_options->first_col > user_options->last_col
+        || user_options->last_row >= LXW_ROW_MAX
+        || user_options->last_col >= LXW_COL_MAX) {
+        LXW_WARN("worksheet_add_pivot_table(): "
+                 "invalid pivot table source range");
+        return LXW_ERROR_PARAMETER_VALIDATION;
+    }
+
+    if (row >= LXW_ROW_MAX || col >= LXW_COL_MAX
+        || _check_rollover_limit(self, row))
+        return LXW_ERROR_WORKSHEET_INDEX_OUT_OF_RANGE;
+
+    if (user_options->data_fields) {
+        while ((data_field = user_options->data_fields[num_data_fields])) {
+            if (!data_field->field
+                || data_field->function > LXW_PIVOT_FUNCTION_MIN) {
+                LXW_WARN("worksheet_add_pivot_table(): "
+                         "invalid pivot table data field");
+                return LXW_ERROR_PARAMETER_VALIDATION;
+            }
+            num_data_fields++;
+        }
+    }
+
+    pivot_obj = calloc(1, sizeof(lxw_pivot_table_obj));
+    RETURN_ON_MEM_ERROR(pivot_obj, LXW_ERROR_MEMORY_MALLOC_FAILED);
+
+    pivot_obj->source = user_options->source;
+    pivot_obj->row = row;
+    pivot_obj->col = col;
+    pivot_obj->first_row = user_options->first_row;
+    pivot_obj->first_col = user_options->first_col;
+    pivot_obj->last_row = user_options->last_row;
+    pivot_obj->last_col = user_options->last_col;
+
+    err = _copy_pivot_field_names(user_options->row_fields,
+                                  &pivot_obj->row_fields,
+                                  &pivot_obj->num_row_fields);
     if (err)
-        return err;
+        goto error;
+
+    err = _copy_pivot_field_names(user_options->column_fields,
+                                  &pivot_obj->col_fields,
+                                  &pivot_obj->num_col_fields);
+    if (err)
+        goto error;
 
-    /* Reset default error condition. */
     err = LXW_ERROR_MEMORY_MALLOC_FAILED;
 
-    /* Set the URI scheme from internal links. */
-    found_string = strstr(url, "internal:");
-    if (found_string)
-        link_type = HYPERLINK_INTERNAL;
+    if (num_data_fields) {
+        pivot_obj->data_fields =
+            calloc(num_data_fields, sizeof(lxw_pivot_data_obj));
+        GOTO_LABEL_ON_MEM_ERROR(pivot_obj->data_fields, error);
 
-    /* Set the URI scheme from external links. */
-    found_string = strstr(url, "external:");
-    if (found_string)
-        link_type = HYPERLINK_EXTERNAL;
+        for (i = 0; i < num_data_fields; i++) {
+            data_field = user_options->data_fields[i];
+            pivot_obj->num_data_fields++;
 
-    if (string) {
-        string_copy = lxw_strdup(string);
-        GOTO_LABEL_ON_MEM_ERROR(string_copy, mem_error);
-    }
-    else {
-        if (link_type == HYPERLINK_URL) {
-            /* Strip the mailto header. */
-            found_string = strstr(url, "mailto:");
-            if (found_string)
-                string_copy = lxw_strdup(url + sizeof("mailto"));
-            else
-                string_copy = lxw_strdup(url);
-        }
-        else {
-            string_copy = lxw_strdup(url + sizeof("__ternal"));
+            pivot_obj->data_fields[i].function = data_field->function;
+            pivot_obj->data_fields[i].field = lxw_strdup(data_field->field);
+            GOTO_LABEL_ON_MEM_ERROR(pivot_obj->data_fields[i].field, error);
+
+            if (data_field->name) {
+                pivot_obj->data_fields[i].name =
+                    lxw_strdup(data_field->name);
+                GOTO_LABEL_ON_MEM_ERROR(pivot_obj->data_fields[i].name,
+                                        error);
+            }
         }
-        GOTO_LABEL_ON_MEM_ERROR(string_copy, mem_error);
     }
 
-    if (url) {
-        if (link_type == HYPERLINK_URL)
-            url_copy = lxw_strdup(url);
-        else
-            url_copy = lxw_strdup(url + sizeof("__ternal"));
-
-        GOTO_LABEL_ON_MEM_ERROR(url_copy, mem_error);
+    if (user_options->name) {
+        pivot_obj->name = lxw_strdup(user_options->name);
+        GOTO_LABEL_ON_MEM_ERROR(pivot_obj->name, error);
     }
 
-    if (tooltip) {
-        tooltip_copy = lxw_strdup(tooltip);
-        GOTO_LABEL_ON_MEM_ERROR(tooltip_copy, mem_error);
-    }
+    /* The fields are checked against the header row of the source range. */
+    err = lxw_pivot_table_check_fields(pivot_obj);
+    if (err)
+        goto error;
 
-    if (link_type == HYPERLINK_INTERNAL) {
-        url_string = lxw_strdup(string_copy);
-        GOTO_LABEL_ON_MEM_ERROR(url_string, mem_error);
-    }
+    STAILQ_INSERT_TAIL(self->pivot_table_objs, pivot_obj, list_pointers);
+    self->pivot_table_count++;
 
-    /* Split url into the link and optional anchor/location. */
-    found_string = strchr(url_copy, '#');
+    return LXW_NO_ERROR;
 
-    if (found_string) {
-        free(url_string);
-        url_string = lxw_strdup(found_string + 1);
-        GOTO_LABEL_ON_MEM_ERROR(url_string, mem_error);
+error:
+    _free_worksheet_pivot_table(pivot_obj);
+    return err;
+}
 
-        *found_string = '\0';
-    }
+/*
+ * Set this worksheet as a selected worksheet, i.e. the worksheet has its tab
+ * highlighted.
+ */
+void
+worksheet_select(lxw_worksheet *self)
+{
+    self->selected = LXW_TRUE;
 
-    /* Escape the URL. */
-    if (link_type == HYPERLINK_URL || link_type == HYPERLINK_EXTERNAL) {
-        tmp_string = lxw_escape_url_characters(url_copy, LXW_FALSE);
-        GOTO_LABEL_ON_MEM_ERROR(tmp_string, mem_error);
+    /* Selected worksheet can't be hidden. */
+    self->hidden = LXW_FALSE;
+}
 
-        free(url_copy);
-        url_copy = tmp_string;
-    }
+/*
+ * Set this worksheet as the active worksheet, i.e. the worksheet that is
+ * displayed when the workbook is opened. Also set it as selected.
+ */
+void
+worksheet_activate(lxw_worksheet *self)
+{
+    self->selected = LXW_TRUE;
+    self->active = LXW_TRUE;
 
-    if (link_type == HYPERLINK_EXTERNAL) {
-        /* External Workbook links need to be modified into the right format.
-         * The URL will look something like "c:\temp\file.xlsx#Sheet!A1". */
+    /* Active worksheet can't be hidden. */
+    self->hidden = LXW_FALSE;
 
-        /* For external links change the dir separator from Unix to DOS. */
-        for (i = 0; i <= strlen(url_copy); i++)
-            if (url_copy[i] == '/')
-                url_copy[i] = '\\';
+    *self->active_sheet = self->index;
+}
 
-        for (i = 0; i <= strlen(string_copy); i++)
-            if (string_copy[i] == '/')
-                string_copy[i] = '\\';
+/*
+ * Set this worksheet as the first visible sheet. This is necessary
+ * when there are a large number of worksheets and the activated
+ * worksheet is not visible on the screen.
+ */
+void
+worksheet_set_first_sheet(lxw_worksheet *self)
+{
+    /* Active worksheet can't be hidden. */
+    self->hidden = LXW_FALSE;
 
-        /* Look for Windows style "C:/" link or Windows share "\\" link. */
-        found_string = strchr(url_copy, ':');
-        if (!found_string)
-            found_string = strstr(url_copy, "\\\\");
+    *self->first_sheet = self->index;
+}
 
-        if (found_string) {
-            /* Add the file:/// URI to the url if non-local. */
-            string_size = sizeof("file:///") + strlen(url_copy);
-            url_external = calloc(1, string_size);
-            GOTO_LABEL_ON_MEM_ERROR(url_external, mem_error);
+/*
+ * Hide this worksheet.
+ */
+void
+worksheet_hide(lxw_worksheet *self)
+{
+    self->hidden = LXW_TRUE;
 
-            lxw_snprintf(url_external, string_size, "file:///%s", url_copy);
+    /* A hidden worksheet shouldn't be active or selected. */
+    self->selected = LXW_FALSE;
 
-        }
+    /* If this is active_sheet or first_sheet reset the workbook value. */
+    if (*self->first_sheet == self->index)
+        *self->first_sheet = 0;
+
+    if (*self->active_sheet == self->index)
+        *self->active_sheet = 0;
+}
+
+/*
+ * Set which cell or cells are selected in a worksheet.
+ */
+lxw_error
+worksheet_set_selection(lxw_worksheet *self,
+                        lxw_row_t first_row, lxw_col_t first_col,
+                        lxw_row_t last_row, lxw_col_t last_col)
+{
+    lxw_selection *selection;
+    lxw_row_t tmp_row;
+    lxw_col_t tmp_col;
+    lxw_error err;
+    char active_cell[LXW_MAX_CELL_RANGE_LENGTH];
+    char sqref[LXW_MAX_CELL_RANGE_LENGTH];
 
-        /* Convert a ./dir/file.xlsx link to dir/file.xlsx. */
-        found_string = strstr(url_copy, ".\\");
-        if (found_string == url_copy)
-            memmove(url_copy, url_copy + 2, strlen(url_copy) - 1);
+    /* Only allow selection to be set once to avoid freeing/re-creating it. */
+    if (!STAILQ_EMPTY(self->selections))
+        return LXW_ERROR_PARAMETER_VALIDATION;
 
-        if (url_external) {
-            free(url_copy);
-            url_copy = lxw_strdup(url_external);
-            GOTO_LABEL_ON_MEM_ERROR(url_copy, mem_error);
+    /* Excel doesn't set a selection for cell A1 since it is the default. */
+    if (first_row == 0 && first_col == 0 && last_row == 0 && last_col == 0)
+        return LXW_NO_ERROR;
 
-            free(url_external);
-            url_external = NULL;
-        }
+    selection = calloc(1, sizeof(lxw_selection));
+    RETURN_ON_MEM_ERROR(selection, LXW_ERROR_MEMORY_MALLOC_FAILED);
 
+    /* Check that row and col are valid without storing. */
+    err = _check_dimensions(self, first_row, first_col, LXW_TRUE, LXW_TRUE);
+    if (err) {
+        free(selection);
+        return err;
     }
 
-    /* Check if URL exceeds Excel's length limit. */
-    if (lxw_utf8_strlen(url_copy) > self->max_url_length) {
-        LXW_WARN_FORMAT2("worksheet_write_url()/_opt(): URL exceeds "
-                         "Excel's allowable length of %d characters: %s",
-                         self->max_url_length, url_copy);
-        err = LXW_ERROR_WORKSHEET_MAX_URL_LENGTH_EXCEEDED;
-        goto mem_error;
+    err = _check_dimensions(self, last_row, last_col, LXW_TRUE, LXW_TRUE);
+    if (err) {
+        free(selection);
+        return err;
     }
 
-    /* Use the default URL format if none is specified. */
-    if (!user_format)
-        format = self->default_url_format;
-    else
-        format = user_format;
+    /* Set the cell range selection. Do this before swapping max/min to  */
+    /* allow the selection direction to be reversed. */
+    lxw_rowcol_to_cell(active_cell, first_row, first_col);
 
-    if (!self->storing_embedded_image) {
-        err =
-            worksheet_write_string(self, row_num, col_num, string_copy,
-                                   format);
-        if (err)
-            goto mem_error;
+    /* Swap last row/col for first row/col if necessary. */
+    if (first_row > last_row) {
+        tmp_row = first_row;
+        first_row = last_row;
+        last_row = tmp_row;
     }
 
-    /* Reset default error condition. */
-    err = LXW_ERROR_MEMORY_MALLOC_FAILED;
+    if (first_col > last_col) {
+        tmp_col = first_col;
+        first_col = last_col;
+        last_col = tmp_col;
+    }
 
-    link = _new_hyperlink_cell(row_num, col_num, link_type, url_copy,
-                               url_string, tooltip_copy);
-    GOTO_LABEL_ON_MEM_ERROR(link, mem_error);
+    /* If the first and last cell are the same write a single cell. */
+    if ((first_row == last_row) && (first_col == last_col))
+        lxw_rowcol_to_cell(sqref, first_row, first_col);
+    else
+        lxw_rowcol_to_range(sqref, first_row, first_col, last_row, last_col);
 
-    _insert_hyperlink(self, row_num, col_num, link);
+    lxw_strcpy(selection->pane, "");
+    lxw_strcpy(selection->active_cell, active_cell);
+    lxw_strcpy(selection->sqref, sqref);
+
+    STAILQ_INSERT_TAIL(self->selections, selection, list_pointers);
 
-    free(string_copy);
-    self->hlink_count++;
     return LXW_NO_ERROR;
+}
 
-mem_error:
-    free(string_copy);
-    free(url_copy);
-    free(url_external);
-    free(url_string);
-    free(tooltip_copy);
-    return err;
+/*
+ * Set the first visible cell at the top left of the worksheet.
+ */
+void
+worksheet_set_top_left_cell(lxw_worksheet *self, lxw_row_t row, lxw_col_t col)
+{
+    if (row == 0 && col == 0)
+        return;
+
+    lxw_rowcol_to_cell(self->top_left_cell, row, col);
 }
 
 /*
- * Write a hyperlink/url to an Excel file.
+ * Set panes and mark them as frozen. With extra options.
  */
-lxw_error
-worksheet_write_url(lxw_worksheet *self,
-                    lxw_row_t row_num,
-                    lxw_col_t col_num, const char *url, lxw_format *format)
+void
+worksheet_freeze_panes_opt(lxw_worksheet *self,
+                           lxw_row_t first_row, lxw_col_t first_col,
+                           lxw_row_t top_row, lxw_col_t left_col,
+                           uint8_t type)
 {
-    return worksheet_write_url_opt(self, row_num, col_num, url, format, NULL,
-                                   NULL);
+    self->panes.first_row = first_row;
+    self->panes.first_col = first_col;
+    self->panes.top_row = top_row;
+    self->panes.left_col = left_col;
+    self->panes.x_split = 0.0;
+    self->panes.y_split = 0.0;
+
+    if (type)
+        self->panes.type = FREEZE_SPLIT_PANES;
+    else
+        self->panes.type = FREEZE_PANES;
 }
 
 /*
- * Write a rich string to an Excel file.
- *
- * Rather than duplicate several of the styles.c font xml methods of styles.c
- * and write the data to a memory buffer this function creates a temporary
- * styles object and uses it to write the data to a file. It then reads that
- * data back into memory and closes the file.
+ * Set panes and mark them as frozen.
  */
-lxw_error
-worksheet_write_rich_string(lxw_worksheet *self,
-                            lxw_row_t row_num,
-                            lxw_col_t col_num,
-                            lxw_rich_string_tuple *rich_strings[],
-                            lxw_format *format)
+void
+worksheet_freeze_panes(lxw_worksheet *self,
+                       lxw_row_t first_row, lxw_col_t first_col)
 {
-    lxw_cell *cell;
-    int32_t string_id;
-    struct sst_element *sst_element;
-    lxw_error err;
-    uint8_t i;
-    long file_size;
-    char *rich_string = NULL;
-    const char *string_copy = NULL;
-    lxw_styles *styles = NULL;
-    lxw_format *default_format = NULL;
-    lxw_rich_string_tuple *rich_string_tuple = NULL;
-    FILE *tmpfile;
-
-    err = _check_dimensions(self, row_num, col_num, LXW_FALSE, LXW_FALSE);
-    if (err)
-        return err;
-
-    /* Iterate through rich string fragments to check for input errors. */
-    i = 0;
-    err = LXW_NO_ERROR;
-    while ((rich_string_tuple = rich_strings[i++]) != NULL) {
-
-        /* Check for NULL or empty strings. */
-        if (!rich_string_tuple->string || !*rich_string_tuple->string) {
-            err = LXW_ERROR_PARAMETER_VALIDATION;
-        }
-    }
+    worksheet_freeze_panes_opt(self, first_row, first_col,
+                               first_row, first_col, 0);
+}
 
-    /* If there are less than 2 fragments it isn't a rich string. */
-    if (i <= 2)
-        err = LXW_ERROR_PARAMETER_VALIDATION;
+/*
+ * Set panes and mark them as split.With extra options.
+ */
+void
+worksheet_split_panes_opt(lxw_worksheet *self,
+                          double y_split, double x_split,
+                          lxw_row_t top_row, lxw_col_t left_col)
+{
+    self->panes.first_row = 0;
+    self->panes.first_col = 0;
+    self->panes.top_row = top_row;
+    self->panes.left_col = left_col;
+    self->panes.x_split = x_split;
+    self->panes.y_split = y_split;
+    self->panes.type = SPLIT_PANES;
+}
 
-    if (err)
-        return err;
+/*
+ * Set panes and mark them as split.
+ */
+void
+worksheet_split_panes(lxw_worksheet *self, double y_split, double x_split)
+{
+    worksheet_split_panes_opt(self, y_split, x_split, 0, 0);
+}
 
-    /* Create a tmp file for the styles object. */
-    tmpfile = lxw_get_filehandle(&rich_string, NULL, self->tmpdir);
-    if (!tmpfile)
-        return LXW_ERROR_CREATING_TMPFILE;
+/*
+ * Set the page orientation as portrait.
+ */
+void
+worksheet_set_portrait(lxw_worksheet *self)
+{
+    self->orientation = LXW_PORTRAIT;
+    self->page_setup_changed = LXW_TRUE;
+}
 
-    /* Create a temp styles object for writing the font data. */
-    styles = lxw_styles_new();
-    GOTO_LABEL_ON_MEM_ERROR(styles, mem_error);
-    styles->file = tmpfile;
+/*
+ * Set the page orientation as landscape.
+ */
+void
+worksheet_set_landscape(lxw_worksheet *self)
+{
+    self->orientation = LXW_LANDSCAPE;
+    self->page_setup_changed = LXW_TRUE;
+}
 
-    /* Create a default format for non-formatted text. */
-    default_format = lxw_format_new();
-    GOTO_LABEL_ON_MEM_ERROR(default_format, mem_error);
+/*
+ * Set the page view mode for Mac Excel.
+ */
+void
+worksheet_set_page_view(lxw_worksheet *self)
+{
+    self->page_view = LXW_TRUE;
+}
 
-    /* Iterate through the rich string fragments and write each one out. */
-    i = 0;
-    while ((rich_string_tuple = rich_strings[i++]) != NULL) {
-        lxw_xml_start_tag(tmpfile, "r", NULL);
+/*
+ * Set the paper type. Example. 1 = US Letter, 9 = A4
+ */
+void
+worksheet_set_paper(lxw_worksheet *self, uint8_t paper_size)
+{
+    self->paper_size = paper_size;
+    self->page_setup_changed = LXW_TRUE;
+}
 
-        if (rich_string_tuple->format) {
-            /* Write the user defined font format. */
-            lxw_styles_write_rich_font(styles, rich_string_tuple->format);
-        }
-        else {
-            /* Write a default font format. Except for the first fragment. */
-            if (i > 1)
-                lxw_styles_write_rich_font(styles, default_format);
-        }
+/*
+ * Set the order in which pages are printed.
+ */
+void
+worksheet_print_across(lxw_worksheet *self)
+{
+    self->page_order = LXW_PRINT_ACROSS;
+    self->page_setup_changed = LXW_TRUE;
+}
 
-        lxw_styles_write_string_fragment(styles, rich_string_tuple->string);
-        lxw_xml_end_tag(tmpfile, "r");
-    }
+/*
+ * Set all the page margins in inches.
+ */
+void
+worksheet_set_margins(lxw_worksheet *self, double left, double right,
+                      double top, double bottom)
+{
 
-    /* Free the temp objects. */
-    lxw_styles_free(styles);
-    lxw_format_free(default_format);
+    if (left >= 0)
+        self->margin_left = left;
 
-    /* Flush the file. */
-    fflush(tmpfile);
+    if (right >= 0)
+        self->margin_right = right;
 
-    if (!rich_string) {
-        /* Read the size to calculate the required memory. */
-        file_size = ftell(tmpfile);
-        /* Allocate a buffer for the rich string xml data. */
-        rich_string = calloc(file_size + 1, 1);
-        GOTO_LABEL_ON_MEM_ERROR(rich_string, mem_error);
+    if (top >= 0)
+        self->margin_top = top;
 
-        /* Rewind the file and read the data into the memory buffer. */
-        rewind(tmpfile);
-        if (fread((void *) rich_string, file_size, 1, tmpfile) < 1) {
-            fclose(tmpfile);
-            free((void *) rich_string);
-            return LXW_ERROR_READING_TMPFILE;
-        }
-    }
+    if (bottom >= 0)
+        self->margin_bottom = bottom;
+}
 
-    /* Close the temp file. */
-    fclose(tmpfile);
+/*
+ * Set the page header caption and options.
+ */
+lxw_error
+worksheet_set_header_opt(lxw_worksheet *self, const char *string,
+                         lxw_header_footer_options *options)
+{
+    lxw_error err;
+    char *tmp_header;
+    char *found_string;
+    char *offset_string;
+    uint8_t placeholder_count = 0;
+    uint8_t image_count = 0;
 
-    if (lxw_utf8_strlen(rich_string) > LXW_STR_MAX) {
-        free((void *) rich_string);
-        return LXW_ERROR_MAX_STRING_LENGTH_EXCEEDED;
+    if (!string) {
+        LXW_WARN_FORMAT("worksheet_set_header_opt/footer_opt(): "
+                        "header/footer string cannot be NULL.");
+        return LXW_ERROR_NULL_PARAMETER_IGNORED;
     }
 
-    if (!self->optimize) {
-        /* Get the SST element and string id. */
-        sst_element = lxw_get_sst_index(self->sst, rich_string, LXW_TRUE);
-        free((void *) rich_string);
-
-        if (!sst_element)
-            return LXW_ERROR_SHARED_STRING_INDEX_NOT_FOUND;
-
-        string_id = sst_element->index;
-        cell = _new_string_cell(row_num, col_num, string_id,
-                                sst_element->string, format);
-    }
-    else {
-        /* Look for and escape control chars in the string. */
-        if (lxw_has_control_characters(rich_string)) {
-            string_copy = lxw_escape_control_characters(rich_string);
-            free((void *) rich_string);
-        }
-        else {
-            string_copy = rich_string;
-        }
-        cell = _new_inline_rich_string_cell(row_num, col_num, string_copy,
-                                            format);
+    if (lxw_utf8_strlen(string) > LXW_HEADER_FOOTER_MAX) {
+        LXW_WARN_FORMAT("worksheet_set_header_opt/footer_opt(): "
+                        "header/footer string exceeds Excel's limit of "
+                        "255 characters.");
+        return LXW_ERROR_255_STRING_LENGTH_EXCEEDED;
     }
 
-    _insert_cell(self, row_num, col_num, cell);
-
-    return LXW_NO_ERROR;
+    tmp_header = lxw_strdup(string);
+    RETURN_ON_MEM_ERROR(tmp_header, LXW_ERROR_MEMORY_MALLOC_FAILED);
 
-mem_error:
-    lxw_styles_free(styles);
-    lxw_format_free(default_format);
-    fclose(tmpfile);
+    /* Replace &[Picture] with &G which is used internally by Excel. */
+    while ((found_string = strstr(tmp_header, "&[Picture]"))) {
+        found_string++;
+        *found_string = 'G';
 
-    return LXW_ERROR_MEMORY_MALLOC_FAILED;
-}
+        do {
+            found_string++;
+            offset_string = found_string + sizeof("Picture");
+            *found_string = *offset_string;
+        } while (*offset_string);
+    }
 
-/*
- * Write a comment to a worksheet cell in Excel.
- */
-lxw_error
-worksheet_write_comment_opt(lxw_worksheet *self,
-                            lxw_row_t row_num, lxw_col_t col_num,
-                            const char *text, lxw_comment_options *options)
-{
-    lxw_cell *cell;
-    lxw_error err;
-    lxw_vml_obj *comment;
+    /* Count &G placeholders and ensure there are sufficient images. */
+    found_string = tmp_header;
+    while (*found_string) {
+        if (*found_string == '&' && *(found_string + 1) == 'G')
+            placeholder_count++;
+        found_string++;
+    }
 
-    err = _check_dimensions(self, row_num, col_num, LXW_FALSE, LXW_FALSE);
-    if (err)
-        return err;
+    if (placeholder_count > 0 && !options) {
+        LXW_WARN_FORMAT1("worksheet_set_header_opt/footer_opt(): "
+                         "the number of &G/&[Picture] placeholders in option "
+                         "string \"%s\" does not match the number of supplied "
+                         "images.", string);
 
-    if (!text)
-        return LXW_ERROR_NULL_PARAMETER_IGNORED;
+        free(tmp_header);
+        return LXW_ERROR_PARAMETER_VALIDATION;
+    }
 
-    if (lxw_str_is_empty(text))
-        return LXW_ERROR_PARAMETER_IS_EMPTY;
+    /* Free any previous header string so we can overwrite it. */
+    free(self->header);
+    self->header = NULL;
 
-    if (lxw_utf8_strlen(text) > LXW_STR_MAX)
-        return LXW_ERROR_MAX_STRING_LENGTH_EXCEEDED;
+    if (options) {
+        /* Ensure there are enough images to match the placeholders. There is
+         * a potential bug where there are sufficient images but in the wrong
+         * positions but we don't currently try to deal with that.*/
+        if (options->image_left)
+            image_count++;
+        if (options->image_center)
+            image_count++;
+        if (options->image_right)
+            image_count++;
 
-    comment = calloc(1, sizeof(lxw_vml_obj));
-    GOTO_LABEL_ON_MEM_ERROR(comment, mem_error);
+        if (placeholder_count != image_count) {
+            LXW_WARN_FORMAT1("worksheet_set_header_opt/footer_opt(): "
+                             "the number of &G/&[Picture] placeholders in option "
+                             "string \"%s\" does not match the number of supplied "
+                             "images.", string);
 
-    comment->text = lxw_strdup(text);
-    GOTO_LABEL_ON_MEM_ERROR(comment->text, mem_error);
+            free(tmp_header);
+            return LXW_ERROR_PARAMETER_VALIDATION;
+        }
 
-    comment->row = row_num;
-    comment->col = col_num;
+        /* Free any existing header image objects. */
+        _free_object_properties(self->header_left_object_props);
+        _free_object_properties(self->header_center_object_props);
+        _free_object_properties(self->header_right_object_props);
 
-    cell = _new_comment_cell(row_num, col_num, comment);
-    GOTO_LABEL_ON_MEM_ERROR(cell, mem_error);
+        if (options->margin > 0.0)
+            self->margin_header = options->margin;
 
-    _insert_comment(self, row_num, col_num, cell);
+        err = _worksheet_set_header_footer_image(self,
+                                                 options->image_left,
+                                                 HEADER_LEFT);
+        if (err) {
+            free(tmp_header);
+            return err;
+        }
 
-    /* Set user and default parameters for the comment. */
-    _get_comment_params(comment, options);
+        err = _worksheet_set_header_footer_image(self,
+                                                 options->image_center,
+                                                 HEADER_CENTER);
+        if (err) {
+            free(tmp_header);
+            return err;
+        }
 
-    self->has_vml = LXW_TRUE;
-    self->has_comments = LXW_TRUE;
+        err = _worksheet_set_header_footer_image(self,
+                                                 options->image_right,
+                                                 HEADER_RIGHT);
+        if (err) {
+            free(tmp_header);
+            return err;
+        }
+    }
 
-    /* Insert a placeholder in the cell RB table in the same position so
-     * that the worksheet row "spans" calculations are correct. */
-    _insert_cell_placeholder(self, row_num, col_num);
+    self->header = tmp_header;
+    self->header_footer_changed = LXW_TRUE;
 
     return LXW_NO_ERROR;
-
-mem_error:
-    if (comment)
-        _free_vml_object(comment);
-
-    return LXW_ERROR_MEMORY_MALLOC_FAILED;
-}
-
-/*
- * Write a comment to a worksheet cell in Excel.
- */
-lxw_error
-worksheet_write_comment(lxw_worksheet *self,
-                        lxw_row_t row_num, lxw_col_t col_num,
-                        const char *string)
-{
-    return worksheet_write_comment_opt(self, row_num, col_num, string, NULL);
 }
 
 /*
- * Set the properties of a single column or a range of columns with options.
+ * Set the page footer caption and options.
  */
 lxw_error
-worksheet_set_column_opt(lxw_worksheet *self,
-                         lxw_col_t firstcol,
-                         lxw_col_t lastcol,
-                         double width,
-                         lxw_format *format,
-                         lxw_row_col_options *user_options)
+worksheet_set_footer_opt(lxw_worksheet *self, const char *string,
+                         lxw_header_footer_options *options)
 {
-    lxw_col_options *copied_options;
-    uint8_t ignore_row = LXW_TRUE;
-    uint8_t ignore_col = LXW_TRUE;
-    uint8_t hidden = LXW_FALSE;
-    uint8_t level = 0;
-    uint8_t collapsed = LXW_FALSE;
-    lxw_col_t col;
     lxw_error err;
+    char *tmp_footer;
+    char *found_string;
+    char *offset_string;
+    uint8_t placeholder_count = 0;
+    uint8_t image_count = 0;
 
-    if (user_options) {
-        hidden = user_options->hidden;
-        level = user_options->level;
-        collapsed = user_options->collapsed;
+    if (!string) {
+        LXW_WARN_FORMAT("worksheet_set_header_opt/footer_opt(): "
+                        "header/footer string cannot be NULL.");
+        return LXW_ERROR_NULL_PARAMETER_IGNORED;
     }
 
-    /* Ensure second col is larger than first. */
-    if (firstcol > lastcol) {
-        lxw_col_t tmp = firstcol;
-        firstcol = lastcol;
-        lastcol = tmp;
+    if (lxw_utf8_strlen(string) > LXW_HEADER_FOOTER_MAX) {
+        LXW_WARN_FORMAT("worksheet_set_header_opt/footer_opt(): "
+                        "header/footer string exceeds Excel's limit of "
+                        "255 characters.");
+        return LXW_ERROR_255_STRING_LENGTH_EXCEEDED;
     }
 
-    /* Ensure that the cols are valid and store max and min values.
-     * NOTE: The check shouldn't modify the row dimensions and should only
-     *       modify the column dimensions in certain cases. */
-    if (format != NULL || (width != LXW_DEF_COL_WIDTH && hidden))
-        ignore_col = LXW_FALSE;
-
-    err = _check_dimensions(self, 0, firstcol, ignore_row, ignore_col);
+    tmp_footer = lxw_strdup(string);
+    RETURN_ON_MEM_ERROR(tmp_footer, LXW_ERROR_MEMORY_MALLOC_FAILED);
 
-    if (!err)
-        err = _check_dimensions(self, 0, lastcol, ignore_row, ignore_col);
+    /* Replace &[Picture] with &G which is used internally by Excel. */
+    while ((found_string = strstr(tmp_footer, "&[Picture]"))) {
+        found_string++;
+        *found_string = 'G';
 
-    if (err)
-        return err;
+        do {
+            found_string++;
+            offset_string = found_string + sizeof("Picture");
+            *found_string = *offset_string;
+        } while (*offset_string);
+    }
 
-    /* Resize the col_options array if required. */
-    if (firstcol >= self->col_options_max) {
-        lxw_col_t col_tmp;
-        lxw_col_t old_size = self->col_options_max;
-        lxw_col_t new_size = _next_power_of_two(firstcol + 1);
-        lxw_col_options **new_ptr = realloc(self->col_options,
-                                            new_size *
-                                            sizeof(lxw_col_options *));
+    /* Count &G placeholders and ensure there are sufficient images. */
+    found_string = tmp_footer;
+    while (*found_string) {
+        if (*found_string == '&' && *(found_string + 1) == 'G')
+            placeholder_count++;
+        found_string++;
+    }
 
-        if (new_ptr) {
-            for (col_tmp = old_size; col_tmp < new_size; col_tmp++)
-                new_ptr[col_tmp] = NULL;
+    if (placeholder_count > 0 && !options) {
+        LXW_WARN_FORMAT1("worksheet_set_header_opt/footer_opt(): "
+                         "the number of &G/&[Picture] placeholders in option "
+                         "string \"%s\" does not match the number of supplied "
+                         "images.", string);
 
-            self->col_options = new_ptr;
-            self->col_options_max = new_size;
-        }
-        else {
-            return LXW_ERROR_MEMORY_MALLOC_FAILED;
-        }
+        free(tmp_footer);
+        return LXW_ERROR_PARAMETER_VALIDATION;
     }
 
-    /* Resize the col_formats array if required. */
-    if (lastcol >= self->col_formats_max) {
-        lxw_col_t col;
-        lxw_col_t old_size = self->col_formats_max;
-        lxw_col_t new_size = _next_power_of_two(lastcol + 1);
-        lxw_format **new_ptr = realloc(self->col_formats,
-                                       new_size * sizeof(lxw_format *));
+    /* Free any previous footer string so we can overwrite it. */
+    free(self->footer);
+    self->footer = NULL;
+
+    if (options) {
+        /* Ensure there are enough images to match the placeholders. There is
+         * a potential bug where there are sufficient images but in the wrong
+         * positions but we don't currently try to deal with that.*/
+        if (options->image_left)
+            image_count++;
+        if (options->image_center)
+            image_count++;
+        if (options->image_right)
+            image_count++;
 
-        if (new_ptr) {
-            for (col = old_size; col < new_size; col++)
-                new_ptr[col] = NULL;
+        if (placeholder_count != image_count) {
+            LXW_WARN_FORMAT1("worksheet_set_header_opt/footer_opt(): "
+                             "the number of &G/&[Picture] placeholders in option "
+                             "string \"%s\" does not match the number of supplied "
+                             "images.", string);
 
-            self->col_formats = new_ptr;
-            self->col_formats_max = new_size;
-        }
-        else {
-            return LXW_ERROR_MEMORY_MALLOC_FAILED;
+            free(tmp_footer);
+            return LXW_ERROR_PARAMETER_VALIDATION;
         }
-    }
-
-    /* Store the column options. */
-    copied_options = calloc(1, sizeof(lxw_col_options));
-    RETURN_ON_MEM_ERROR(copied_options, LXW_ERROR_MEMORY_MALLOC_FAILED);
 
-    /* Ensure the level is <= 7). */
-    if (level > 7)
-        level = 7;
+        /* Free any existing footer image objects. */
+        _free_object_properties(self->footer_left_object_props);
+        _free_object_properties(self->footer_center_object_props);
+        _free_object_properties(self->footer_right_object_props);
 
-    if (level > self->outline_col_level)
-        self->outline_col_level = level;
+        if (options->margin > 0.0)
+            self->margin_footer = options->margin;
 
-    /* Set the column properties. */
-    copied_options->firstcol = firstcol;
-    copied_options->lastcol = lastcol;
-    copied_options->width = width;
-    copied_options->format = format;
-    copied_options->hidden = hidden;
-    copied_options->level = level;
-    copied_options->collapsed = collapsed;
+        err = _worksheet_set_header_footer_image(self,
+                                                 options->image_left,
+                                                 FOOTER_LEFT);
+        if (err) {
+            free(tmp_footer);
+            return err;
+        }
 
-    free(self->col_options[firstcol]);
-    self->col_options[firstcol] = copied_options;
+        err = _worksheet_set_header_footer_image(self,
+                                                 options->image_center,
+                                                 FOOTER_CENTER);
+        if (err) {
+            free(tmp_footer);
+            return err;
+        }
 
-    /* Store the column formats for use when writing cell data. */
-    for (col = firstcol; col <= lastcol; col++) {
-        self->col_formats[col] = format;
+        err = _worksheet_set_header_footer_image(self,
+                                                 options->image_right,
+                                                 FOOTER_RIGHT);
+        if (err) {
+            free(tmp_footer);
+            return err;
+        }
     }
 
-    /* Store the column change to allow optimizations. */
-    self->col_size_changed = LXW_TRUE;
+    self->footer = tmp_footer;
+    self->header_footer_changed = LXW_TRUE;
 
     return LXW_NO_ERROR;
 }
 
 /*
- * Set the properties of a single column or a range of columns.
- */
-lxw_error
-worksheet_set_column(lxw_worksheet *self,
-                     lxw_col_t firstcol,
-                     lxw_col_t lastcol, double width, lxw_format *format)
-{
-    return worksheet_set_column_opt(self, firstcol, lastcol, width, format,
-                                    NULL);
-}
-
-/*
- * Set the properties of a single column or a range of columns, with the
- * width in pixels.
+ * Set the page header caption.
  */
 lxw_error
-worksheet_set_column_pixels(lxw_worksheet *self,
-                            lxw_col_t firstcol,
-                            lxw_col_t lastcol,
-                            uint32_t pixels, lxw_format *format)
+worksheet_set_header(lxw_worksheet *self, const char *string)
 {
-    double width = _pixels_to_width(pixels);
-
-    return worksheet_set_column_opt(self, firstcol, lastcol, width, format,
-                                    NULL);
+    return worksheet_set_header_opt(self, string, NULL);
 }
 
 /*
- * Set the properties of a single column or a range of columns with options,
- * with the width in pixels.
+ * Set the page footer caption.
  */
 lxw_error
-worksheet_set_column_pixels_opt(lxw_worksheet *self,
-                                lxw_col_t firstcol,
-                                lxw_col_t lastcol,
-                                uint32_t pixels,
-                                lxw_format *format,
-                                lxw_row_col_options *user_options)
+worksheet_set_footer(lxw_worksheet *self, const char *string)
 {
-    double width = _pixels_to_width(pixels);
-
-    return worksheet_set_column_opt(self, firstcol, lastcol, width, format,
-                                    user_options);
+    return worksheet_set_footer_opt(self, string, NULL);
 }
 
 /*
- * Set the properties of a row with options.
+ * Set the option to show/hide gridlines on the screen and the printed page.
  */
-lxw_error
-worksheet_set_row_opt(lxw_worksheet *self,
-                      lxw_row_t row_num,
-                      double height,
-                      lxw_format *format, lxw_row_col_options *user_options)
+void
+worksheet_gridlines(lxw_worksheet *self, uint8_t option)
 {
-
-    lxw_col_t min_col;
-    uint8_t hidden = LXW_FALSE;
-    uint8_t level = 0;
-    uint8_t collapsed = LXW_FALSE;
-    lxw_row *row;
-    lxw_error err;
-
-    if (user_options) {
-        hidden = user_options->hidden;
-        level = user_options->level;
-        collapsed = user_options->collapsed;
+    if (option == LXW_HIDE_ALL_GRIDLINES) {
+        self->print_gridlines = 0;
+        self->screen_gridlines = 0;
     }
 
-    /* Use minimum col in _check_dimensions(). */
-    if (self->dim_colmin != LXW_COL_MAX)
-        min_col = self->dim_colmin;
-    else
-        min_col = 0;
-
-    err = _check_dimensions(self, row_num, min_col, LXW_FALSE, LXW_FALSE);
-    if (err)
-        return err;
-
-    /* If the height is 0 the row is hidden and the height is the default. */
-    if (height == 0) {
-        hidden = LXW_TRUE;
-        height = self->default_row_height;
+    if (option & LXW_SHOW_SCREEN_GRIDLINES) {
+        self->screen_gridlines = 1;
     }
 
-    /* Ensure the level is <= 7). */
-    if (level > 7)
-        level = 7;
-
-    if (level > self->outline_row_level)
-        self->outline_row_level = level;
-
-    /* Store the row properties. */
-    row = _get_row(self, row_num);
-
-    row->height = height;
-    row->format = format;
-    row->hidden = hidden;
-    row->level = level;
-    row->collapsed = collapsed;
-    row->row_changed = LXW_TRUE;
-
-    if (height != self->default_row_height)
-        row->height_changed = LXW_TRUE;
-
-    return LXW_NO_ERROR;
+    if (option & LXW_SHOW_PRINT_GRIDLINES) {
+        self->print_gridlines = 1;
+        self->print_options_changed = 1;
+    }
 }
 
 /*
- * Set the properties of a row.
+ * Center the page horizontally.
  */
-lxw_error
-worksheet_set_row(lxw_worksheet *self,
-                  lxw_row_t row_num, double height, lxw_format *format)
+void
+worksheet_center_horizontally(lxw_worksheet *self)
 {
-    return worksheet_set_row_opt(self, row_num, height, format, NULL);
+    self->print_options_changed = 1;
+    self->hcenter = 1;
 }
 
 /*
- * Set the properties of a row, with the height in pixels.
+ * Center the page horizontally.
  */
-lxw_error
-worksheet_set_row_pixels(lxw_worksheet *self,
-                         lxw_row_t row_num, uint32_t pixels,
-                         lxw_format *format)
+void
+worksheet_center_vertically(lxw_worksheet *self)
 {
-    double height = _pixels_to_height(pixels);
-
-    return worksheet_set_row_opt(self, row_num, height, format, NULL);
+    self->print_options_changed = 1;
+    self->vcenter = 1;
 }
 
 /*
- * Set the properties of a row with options, with the height in pixels.
+ * Set the option to print the row and column headers on the printed page.
  */
-lxw_error
-worksheet_set_row_pixels_opt(lxw_worksheet *self,
-                             lxw_row_t row_num,
-                             uint32_t pixels,
-                             lxw_format *format,
-                             lxw_row_col_options *user_options)
+void
+worksheet_print_row_col_headers(lxw_worksheet *self)
 {
-    double height = _pixels_to_height(pixels);
-
-    return worksheet_set_row_opt(self, row_num, height, format, user_options);
+    self->print_headers = 1;
+    self->print_options_changed = 1;
 }
 
 /*
- * Merge a range of cells. The first cell should contain the data and the others
- * should be blank. All cells should contain the same format.
+ * Set the rows to repeat at the top of each printed page.
  */
 lxw_error
-worksheet_merge_range(lxw_worksheet *self, lxw_row_t first_row,
-                      lxw_col_t first_col, lxw_row_t last_row,
-                      lxw_col_t last_col, const char *string,
-                      lxw_format *format)
+worksheet_repeat_rows(lxw_worksheet *self, lxw_row_t first_row,
+                      lxw_row_t last_row)
 {
-    lxw_merged_range *merged_range;
     lxw_row_t tmp_row;
-    lxw_col_t tmp_col;
     lxw_error err;
 
-    /* Excel doesn't allow a single cell to be merged */
-    if (first_row == last_row && first_col == last_col)
-        return LXW_ERROR_PARAMETER_VALIDATION;
-
-    /* Swap last row/col with first row/col as necessary */
     if (first_row > last_row) {
         tmp_row = last_row;
         last_row = first_row;
         first_row = tmp_row;
     }
-    if (first_col > last_col) {
-        tmp_col = last_col;
-        last_col = first_col;
-        first_col = tmp_col;
-    }
 
-    /* Check that column number is valid and store the max value */
-    err = _check_dimensions(self, last_row, last_col, LXW_FALSE, LXW_FALSE);
+    err = _check_dimensions(self, last_row, 0, LXW_IGNORE, LXW_IGNORE);
     if (err)
         return err;
 
-    /* Store the merge range. */
-    merged_range = calloc(1, sizeof(lxw_merged_range));
-    RETURN_ON_MEM_ERROR(merged_range, LXW_ERROR_MEMORY_MALLOC_FAILED);
+    self->repeat_rows.in_use = LXW_TRUE;
+    self->repeat_rows.first_row = first_row;
+    self->repeat_rows.last_row = last_row;
 
-    merged_range->first_row = first_row;
-    merged_range->first_col = first_col;
-    merged_range->last_row = last_row;
-    merged_range->last_col = last_col;
+    return LXW_NO_ERROR;
+}
 
-    STAILQ_INSERT_TAIL(self->merged_ranges, merged_range, list_pointers);
-    self->merged_range_count++;
+/*
+ * Set the columns to repeat at the left hand side of each printed page.
+ */
+lxw_error
+worksheet_repeat_columns(lxw_worksheet *self, lxw_col_t first_col,
+                         lxw_col_t last_col)
+{
+    lxw_col_t tmp_col;
+    lxw_error err;
 
-    /* Write the first cell */
-    worksheet_write_string(self, first_row, first_col, string, format);
+    if (first_col > last_col) {
+        tmp_col = last_col;
+        last_col = first_col;
+        first_col = tmp_col;
+    }
 
-    /* Pad out the rest of the area with formatted blank cells. */
-    for (tmp_row = first_row; tmp_row <= last_row; tmp_row++) {
-        for (tmp_col = first_col; tmp_col <= last_col; tmp_col++) {
-            if (tmp_row == first_row && tmp_col == first_col)
-                continue;
+    err = _check_dimensions(self, last_col, 0, LXW_IGNORE, LXW_IGNORE);
+    if (err)
+        return err;
 
-            worksheet_write_blank(self, tmp_row, tmp_col, format);
-        }
-    }
+    self->repeat_cols.in_use = LXW_TRUE;
+    self->repeat_cols.first_col = first_col;
+    self->repeat_cols.last_col = last_col;
 
     return LXW_NO_ERROR;
 }
 
 /*
- * Set the autofilter area in the worksheet.
+ * Set the print area in the current worksheet.
  */
 lxw_error
-worksheet_autofilter(lxw_worksheet *self, lxw_row_t first_row,
+worksheet_print_area(lxw_worksheet *self, lxw_row_t first_row,
                      lxw_col_t first_col, lxw_row_t last_row,
                      lxw_col_t last_col)
 {
     lxw_row_t tmp_row;
     lxw_col_t tmp_col;
     lxw_error err;
-    lxw_filter_rule_obj **filter_rules;
-    lxw_col_t num_filter_rules;
 
-    /* Swap last row/col with first row/col as necessary */
     if (first_row > last_row) {
         tmp_row = last_row;
         last_row = first_row;
         first_row = tmp_row;
     }
+
     if (first_col > last_col) {
         tmp_col = last_col;
         last_col = first_col;
         first_col = tmp_col;
     }
 
-    /* Check that column number is valid and store the max value */
-    err = _check_dimensions(self, last_row, last_col, LXW_FALSE, LXW_FALSE);
+    err = _check_dimensions(self, last_row, last_col, LXW_IGNORE, LXW_IGNORE);
     if (err)
         return err;
 
-    /* Create a array to hold filter rules. */
-    self->autofilter.in_use = LXW_FALSE;
-    self->autofilter.has_rules = LXW_FALSE;
-    _free_filter_rules(self);
-    num_filter_rules = last_col - first_col + 1;
-    filter_rules = calloc(num_filter_rules, sizeof(lxw_filter_rule_obj *));
-    RETURN_ON_MEM_ERROR(filter_rules, LXW_ERROR_MEMORY_MALLOC_FAILED);
+    /* Ignore max area since it is the same as no print area in Excel. */
+    if (first_row == 0 && first_col == 0 && last_row == LXW_ROW_MAX - 1
+        && last_col == LXW_COL_MAX - 1) {
+        return LXW_NO_ERROR;
+    }
 
-    self->autofilter.in_use = LXW_TRUE;
-    self->autofilter.first_row = first_row;
-    self->autofilter.first_col = first_col;
-    self->autofilter.last_row = last_row;
-    self->autofilter.last_col = last_col;
+    self->print_area.in_use = LXW_TRUE;
+    self->print_area.first_row = first_row;
+    self->print_area.last_row = last_row;
+    self->print_area.first_col = first_col;
+    self->print_area.last_col = last_col;
 
-    self->filter_rules = filter_rules;
-    self->num_filter_rules = num_filter_rules;
+    return LXW_NO_ERROR;
+}
+
+/* Store the vertical and horizontal number of pages that will define the
+ * maximum area printed.
+ */
+void
+worksheet_fit_to_pages(lxw_worksheet *self, uint16_t width, uint16_t height)
+{
+    self->fit_page = 1;
+    self->fit_width = width;
+    self->fit_height = height;
+    self->page_setup_changed = 1;
+}
+
+/*
+ * Set the start page number.
+ */
+void
+worksheet_set_start_page(lxw_worksheet *self, uint16_t start_page)
+{
+    self->page_start = start_page;
+}
+
+/*
+ * Set the scale factor for the printed page.
+ */
+void
+worksheet_set_print_scale(lxw_worksheet *self, uint16_t scale)
+{
+    /* Confine the scale to Excel"s range */
+    if (scale < 10 || scale > 400)
+        return;
+
+    /* Turn off "fit to page" option. */
+    self->fit_page = LXW_FALSE;
+
+    self->print_scale = scale;
+    self->page_setup_changed = LXW_TRUE;
+}
+
+/*
+ * Set the print in black and white option.
+ */
+void
+worksheet_print_black_and_white(lxw_worksheet *self)
+{
+    self->black_white = LXW_TRUE;
+    self->page_setup_changed = LXW_TRUE;
+}
+
+/*
+ * Store the horizontal page breaks on a worksheet.
+ */
+lxw_error
+worksheet_set_h_pagebreaks(lxw_worksheet *self, lxw_row_t hbreaks[])
+{
+    uint16_t count = 0;
+
+    if (hbreaks == NULL)
+        return LXW_ERROR_NULL_PARAMETER_IGNORED;
+
+    while (hbreaks[count])
+        count++;
+
+    /* The Excel 2007 specification says that the maximum number of page
+     * breaks is 1026. However, in practice it is actually 1023. */
+    if (count > LXW_BREAKS_MAX)
+        count = LXW_BREAKS_MAX;
+
+    self->hbreaks = calloc(count, sizeof(lxw_row_t));
+    RETURN_ON_MEM_ERROR(self->hbreaks, LXW_ERROR_MEMORY_MALLOC_FAILED);
+    memcpy(self->hbreaks, hbreaks, count * sizeof(lxw_row_t));
+    self->hbreaks_count = count;
 
     return LXW_NO_ERROR;
 }
 
 /*
- * Set a autofilter rule for a filter column.
+ * Store the vertical page breaks on a worksheet.
  */
 lxw_error
-worksheet_filter_column(lxw_worksheet *self, lxw_col_t col,
-                        lxw_filter_rule *rule)
+worksheet_set_v_pagebreaks(lxw_worksheet *self, lxw_col_t vbreaks[])
 {
-    lxw_filter_rule_obj *rule_obj;
-    uint16_t rule_index;
+    uint16_t count = 0;
 
-    if (!rule) {
-        LXW_WARN("worksheet_filter_column(): rule parameter cannot be NULL");
-        return LXW_ERROR_PARAMETER_VALIDATION;
-    }
+    if (vbreaks == NULL)
+        return LXW_ERROR_NULL_PARAMETER_IGNORED;
 
-    if (self->autofilter.in_use == LXW_FALSE) {
-        LXW_WARN("worksheet_filter_column(): "
-                 "Worksheet autofilter range hasn't been defined. "
-                 "Use worksheet_autofilter() first.");
-        return LXW_ERROR_PARAMETER_VALIDATION;
-    }
+    while (vbreaks[count])
+        count++;
 
-    if (col < self->autofilter.first_col || col > self->autofilter.last_col) {
-        LXW_WARN_FORMAT3("worksheet_filter_column(): "
-                         "Column '%d' is outside autofilter range "
-                         "'%d <= col <= %d'.", col,
-                         self->autofilter.first_col,
-                         self->autofilter.last_col);
-        return LXW_ERROR_PARAMETER_VALIDATION;
+    /* The Excel 2007 specification says that the maximum number of page
+     * breaks is 1026. However, in practice it is actually 1023. */
+    if (count > LXW_BREAKS_MAX)
+        count = LXW_BREAKS_MAX;
+
+    self->vbreaks = calloc(count, sizeof(lxw_col_t));
+    RETURN_ON_MEM_ERROR(self->vbreaks, LXW_ERROR_MEMORY_MALLOC_FAILED);
+    memcpy(self->vbreaks, vbreaks, count * sizeof(lxw_col_t));
+    self->vbreaks_count = count;
+
+    return LXW_NO_ERROR;
+}
+
+/*
+ * Set the worksheet zoom factor.
+ */
+void
+worksheet_set_zoom(lxw_worksheet *self, uint16_t scale)
+{
+    /* Confine the scale to Excel"s range */
+    if (scale < 10 || scale > 400) {
+        LXW_WARN("worksheet_set_zoom(): "
+                 "Zoom factor scale outside range: 10 <= zoom <= 400.");
+        return;
     }
 
-    /* Free any previous rule in the column slot. */
-    rule_index = col - self->autofilter.first_col;
-    _free_filter_rule(self->filter_rules[rule_index]);
+    self->zoom = scale;
+}
 
-    /* Create a new rule and copy user input. */
-    rule_obj = calloc(1, sizeof(lxw_filter_rule_obj));
-    RETURN_ON_MEM_ERROR(rule_obj, LXW_ERROR_MEMORY_MALLOC_FAILED);
+/*
+ * Hide cell zero values.
+ */
+void
+worksheet_hide_zero(lxw_worksheet *self)
+{
+    self->show_zeros = LXW_FALSE;
+}
 
-    rule_obj->col_num = rule_index;
-    rule_obj->type = LXW_FILTER_TYPE_SINGLE;
-    rule_obj->criteria1 = rule->criteria;
-    rule_obj->value1 = rule->value;
+/*
+ * Display the worksheet right to left for some eastern versions of Excel.
+ */
+void
+worksheet_right_to_left(lxw_worksheet *self)
+{
+    self->right_to_left = LXW_TRUE;
+}
 
-    if (rule_obj->criteria1 != LXW_FILTER_CRITERIA_NON_BLANKS) {
-        rule_obj->value1_string = lxw_strdup(rule->value_string);
-    }
-    else {
-        rule_obj->criteria1 = LXW_FILTER_CRITERIA_NOT_EQUAL_TO;
-        rule_obj->value1_string = lxw_strdup(" ");
+/*
+ * Set the color of the worksheet tab.
+ */
+void
+worksheet_set_tab_color(lxw_worksheet *self, lxw_color_t color)
+{
+    self->tab_color = color;
+}
+
+/*
+ * Set the worksheet protection flags to prevent modification of worksheet
+ * objects.
+ */
+void
+worksheet_protect(lxw_worksheet *self, const char *password,
+                  lxw_protection *options)
+{
+    struct lxw_protection_obj *protect = &self->protection;
+
+    /* Copy any user parameters to the internal structure. */
+    if (options) {
+        protect->no_select_locked_cells = options->no_select_locked_cells;
+        protect->no_select_unlocked_cells = options->no_select_unlocked_cells;
+        protect->format_cells = options->format_cells;
+        protect->format_columns = options->format_columns;
+        protect->format_rows = options->format_rows;
+        protect->insert_columns = options->insert_columns;
+        protect->insert_rows = options->insert_rows;
+        protect->insert_hyperlinks = options->insert_hyperlinks;
+        protect->delete_columns = options->delete_columns;
+        protect->delete_rows = options->delete_rows;
+        protect->sort = options->sort;
+        protect->autofilter = options->autofilter;
+        protect->pivot_tables = options->pivot_tables;
+        protect->scenarios = options->scenarios;
+        protect->objects = options->objects;
     }
 
-    if (rule_obj->criteria1 == LXW_FILTER_CRITERIA_BLANKS)
-        rule_obj->has_blanks = LXW_TRUE;
-
-    _set_custom_filter(rule_obj);
-
-    self->filter_rules[rule_index] = rule_obj;
-    self->filter_on = LXW_TRUE;
-    self->autofilter.has_rules = LXW_TRUE;
+    if (password) {
+        uint16_t hash = lxw_hash_password(password);
+        lxw_snprintf(protect->hash, 5, "%X", hash);
+    }
 
-    return LXW_NO_ERROR;
+    protect->no_sheet = LXW_FALSE;
+    protect->no_content = LXW_TRUE;
+    protect->is_configured = LXW_TRUE;
 }
 
 /*
- * Set two autofilter rules for a filter column.
+ * Set the worksheet properties for outlines and grouping.
  */
-lxw_error
-worksheet_filter_column2(lxw_worksheet *self, lxw_col_t col,
-                         lxw_filter_rule *rule1, lxw_filter_rule *rule2,
-                         uint8_t and_or)
+void
+worksheet_outline_settings(lxw_worksheet *self,
+                           uint8_t visible,
+                           uint8_t symbols_below,
+                           uint8_t symbols_right, uint8_t auto_style)
 {
-    lxw_filter_rule_obj *rule_obj;
-    uint16_t rule_index;
-
-    if (!rule1 || !rule2) {
-        LXW_WARN("worksheet_filter_column2(): rule parameter cannot be NULL");
-        return LXW_ERROR_PARAMETER_VALIDATION;
-    }
-
-    if (self->autofilter.in_use == LXW_FALSE) {
-        LXW_WARN("worksheet_filter_column2(): "
-                 "Worksheet autofilter range hasn't been defined. "
-                 "Use worksheet_autofilter() first.");
-        return LXW_ERROR_PARAMETER_VALIDATION;
-    }
-
-    if (col < self->autofilter.first_col || col > self->autofilter.last_col) {
-        LXW_WARN_FORMAT3("worksheet_filter_column2(): "
-                         "Column '%d' is outside autofilter range "
-                         "'%d <= col <= %d'.", col,
-                         self->autofilter.first_col,
-                         self->autofilter.last_col);
-        return LXW_ERROR_PARAMETER_VALIDATION;
-    }
-
-    /* Free any previous rule in the column slot. */
-    rule_index = col - self->autofilter.first_col;
-    _free_filter_rule(self->filter_rules[rule_index]);
-
-    /* Create a new rule and copy user input. */
-    rule_obj = calloc(1, sizeof(lxw_filter_rule_obj));
-    RETURN_ON_MEM_ERROR(rule_obj, LXW_ERROR_MEMORY_MALLOC_FAILED);
-
-    if (and_or == LXW_FILTER_AND)
-        rule_obj->type = LXW_FILTER_TYPE_AND;
-    else
-        rule_obj->type = LXW_FILTER_TYPE_OR;
-
-    rule_obj->col_num = rule_index;
-
-    rule_obj->criteria1 = rule1->criteria;
-    rule_obj->value1 = rule1->value;
+    self->outline_on = visible;
+    self->outline_below = symbols_below;
+    self->outline_right = symbols_right;
+    self->outline_style = auto_style;
 
-    rule_obj->criteria2 = rule2->criteria;
-    rule_obj->value2 = rule2->value;
+    self->outline_changed = LXW_TRUE;
+}
 
-    if (rule_obj->criteria1 != LXW_FILTER_CRITERIA_NON_BLANKS) {
-        rule_obj->value1_string = lxw_strdup(rule1->value_string);
-    }
-    else {
-        rule_obj->criteria1 = LXW_FILTER_CRITERIA_NOT_EQUAL_TO;
-        rule_obj->value1_string = lxw_strdup(" ");
-    }
+/*
+ * Set the default row properties
+ */
+void
+worksheet_set_default_row(lxw_worksheet *self, double height,
+                          uint8_t hide_unused_rows)
+{
+    if (height < 0)
+        height = self->default_row_height;
 
-    if (rule_obj->criteria2 != LXW_FILTER_CRITERIA_NON_BLANKS) {
-        rule_obj->value2_string = lxw_strdup(rule2->value_string);
-    }
-    else {
-        rule_obj->criteria2 = LXW_FILTER_CRITERIA_NOT_EQUAL_TO;
-        rule_obj->value2_string = lxw_strdup(" ");
+    if (height != self->default_row_height) {
+        self->default_row_height = height;
+        self->row_size_changed = LXW_TRUE;
     }
 
-    if (rule_obj->criteria1 == LXW_FILTER_CRITERIA_BLANKS)
-        rule_obj->has_blanks = LXW_TRUE;
-
-    if (rule_obj->criteria2 == LXW_FILTER_CRITERIA_BLANKS)
-        rule_obj->has_blanks = LXW_TRUE;
-
-    _set_custom_filter(rule_obj);
-
-    self->filter_rules[rule_index] = rule_obj;
-    self->filter_on = LXW_TRUE;
-    self->autofilter.has_rules = LXW_TRUE;
+    if (hide_unused_rows)
+        self->default_row_zeroed = LXW_TRUE;
 
-    return LXW_NO_ERROR;
+    self->default_row_set = LXW_TRUE;
 }
 
 /*
- * Set two autofilter rules for a filter column.
+ * Insert an image with options into the worksheet.
  */
 lxw_error
-worksheet_filter_list(lxw_worksheet *self, lxw_col_t col, const char **list)
+worksheet_insert_image_opt(lxw_worksheet *self,
+                           lxw_row_t row_num, lxw_col_t col_num,
+                           const char *filename,
+                           lxw_image_options *user_options)
 {
-    lxw_filter_rule_obj *rule_obj;
-    uint16_t rule_index;
-    uint8_t has_blanks = LXW_FALSE;
-    uint16_t num_filters = 0;
-    uint16_t input_list_index;
-    uint16_t rule_obj_list_index;
-    const char *str;
-    char **tmp_list;
+    FILE *image_stream;
+    const char *description;
+    lxw_object_properties *object_props;
 
-    if (!list) {
-        LXW_WARN("worksheet_filter_list(): list parameter cannot be NULL");
-        return LXW_ERROR_PARAMETER_VALIDATION;
+    if (!filename) {
+        LXW_WARN("worksheet_insert_image()/_opt(): "
+                 "filename must be specified.");
+        return LXW_ERROR_NULL_PARAMETER_IGNORED;
     }
 
-    if (self->autofilter.in_use == LXW_FALSE) {
-        LXW_WARN("worksheet_filter_list(): "
-                 "Worksheet autofilter range hasn't been defined. "
-                 "Use worksheet_autofilter() first.");
-        return LXW_ERROR_PARAMETER_VALIDATION;
-    }
+    if (_check_rollover_limit(self, row_num))
+        return LXW_ERROR_WORKSHEET_INDEX_OUT_OF_RANGE;
 
-    if (col < self->autofilter.first_col || col > self->autofilter.last_col) {
-        LXW_WARN_FORMAT3("worksheet_filter_list(): "
-                         "Column '%d' is outside autofilter range "
-                         "'%d <= col <= %d'.", col,
-                         self->autofilter.first_col,
-                         self->autofilter.last_col);
+    /* Check that the image file exists and can be opened. */
+    image_stream = lxw_fopen(filename, "rb");
+    if (!image_stream) {
+        LXW_WARN_FORMAT1("worksheet_insert_image()/_opt(): "
+                         "file doesn't exist or can't be opened: %s.",
+                         filename);
         return LXW_ERROR_PARAMETER_VALIDATION;
     }
 
-    /* Count the number of non "Blanks" strings in the input list. */
-    input_list_index = 0;
-    while ((str = list[input_list_index]) != NULL) {
-        if (strncmp(str, "Blanks", 6) == 0)
-            has_blanks = LXW_TRUE;
-        else
-            num_filters++;
-
-        input_list_index++;
-    }
-
-    /* There should be at least one filter string. */
-    if (num_filters == 0) {
-        LXW_WARN("worksheet_filter_list(): "
-                 "list must have at least 1 non-blanks item.");
+    /* Use the filename as the default description, like Excel. */
+    description = lxw_basename(filename);
+    if (!description) {
+        LXW_WARN_FORMAT1("worksheet_insert_image()/_opt(): "
+                         "couldn't get basename for file: %s.", filename);
+        fclose(image_stream);
         return LXW_ERROR_PARAMETER_VALIDATION;
     }
 
-    /* Free any previous rule in the column slot. */
-    rule_index = col - self->autofilter.first_col;
-    _free_filter_rule(self->filter_rules[rule_index]);
-
-    /* Create a new rule and copy user input. */
-    rule_obj = calloc(1, sizeof(lxw_filter_rule_obj));
-    RETURN_ON_MEM_ERROR(rule_obj, LXW_ERROR_MEMORY_MALLOC_FAILED);
-
-    tmp_list = calloc(num_filters + 1, sizeof(char *));
-    GOTO_LABEL_ON_MEM_ERROR(tmp_list, mem_error);
+    /* Create a new object to hold the image properties. */
+    object_props = calloc(1, sizeof(lxw_object_properties));
+    if (!object_props) {
+        fclose(image_stream);
+        return LXW_ERROR_MEMORY_MALLOC_FAILED;
+    }
 
-    /* Copy input list (without any "Blanks" command) to an internal list. */
-    input_list_index = 0;
-    rule_obj_list_index = 0;
-    while ((str = list[input_list_index]) != NULL) {
-        if (strncmp(str, "Blanks", 6) != 0) {
-            tmp_list[rule_obj_list_index] = lxw_strdup(str);
-            rule_obj_list_index++;
-        }
+    if (user_options) {
+        object_props->x_offset = user_options->x_offset;
+        object_props->y_offset = user_options->y_offset;
+        object_props->x_scale = user_options->x_scale;
+        object_props->y_scale = user_options->y_scale;
+        object_props->url = lxw_strdup(user_options->url);
+        object_props->tip = lxw_strdup(user_options->tip);
+        object_props->object_position = user_options->object_position;
+        object_props->decorative = user_options->decorative;
 
-        input_list_index++;
+        if (user_options->description)
+            description = user_options->description;
     }
 
-    rule_obj->list = tmp_list;
-    rule_obj->num_list_filters = num_filters;
-    rule_obj->is_custom = LXW_FALSE;
-    rule_obj->col_num = rule_index;
-    rule_obj->type = LXW_FILTER_TYPE_STRING_LIST;
-    rule_obj->has_blanks = has_blanks;
+    /* Copy other options or set defaults. */
+    object_props->filename = lxw_strdup(filename);
+    object_props->description = lxw_strdup(description);
+    object_props->stream = image_stream;
+    object_props->row = row_num;
+    object_props->col = col_num;
 
-    self->filter_rules[rule_index] = rule_obj;
-    self->filter_on = LXW_TRUE;
-    self->autofilter.has_rules = LXW_TRUE;
+    if (object_props->x_scale == 0.0)
+        object_props->x_scale = 1;
 
-    return LXW_NO_ERROR;
+    if (object_props->y_scale == 0.0)
+        object_props->y_scale = 1;
 
-mem_error:
-    free(rule_obj);
-    return LXW_ERROR_MEMORY_MALLOC_FAILED;
+    if (_get_image_properties(object_props) == LXW_NO_ERROR) {
+        STAILQ_INSERT_TAIL(self->image_props, object_props, list_pointers);
+        fclose(image_stream);
+        return LXW_NO_ERROR;
+    }
+    else {
+        _free_object_properties(object_props);
+        fclose(image_stream);
+        return LXW_ERROR_IMAGE_DIMENSIONS;
+    }
+}
 
+/*
+ * Insert an image into the worksheet.
+ */
+lxw_error
+worksheet_insert_image(lxw_worksheet *self,
+                       lxw_row_t row_num, lxw_col_t col_num,
+                       const char *filename)
+{
+    return worksheet_insert_image_opt(self, row_num, col_num, filename, NULL);
 }
 
 /*
- * Add an Excel table to the worksheet.
+ * Insert an image buffer, with options, into the worksheet.
  */
 lxw_error
-worksheet_add_table(lxw_worksheet *self, lxw_row_t first_row,
-                    lxw_col_t first_col, lxw_row_t last_row,
-                    lxw_col_t last_col, lxw_table_options *user_options)
+worksheet_insert_image_buffer_opt(lxw_worksheet *self,
+                                  lxw_row_t row_num,
+                                  lxw_col_t col_num,
+                                  const unsigned char *image_buffer,
+                                  size_t image_size,
+                                  lxw_image_options *user_options)
 {
-    lxw_row_t tmp_row;
-    lxw_col_t tmp_col;
-    lxw_col_t num_cols;
-    lxw_error err;
-    lxw_table_obj *table_obj;
-    lxw_table_column **columns;
+    FILE *image_stream;
+    lxw_object_properties *object_props;
 
-    if (self->optimize) {
-        LXW_WARN_FORMAT("worksheet_add_table(): "
-                        "worksheet tables aren't supported in "
-                        "'constant_memory' mode");
-        return LXW_ERROR_FEATURE_NOT_SUPPORTED;
+    if (!image_size) {
+        LXW_WARN("worksheet_insert_image_buffer()/_opt(): "
+                 "size must be non-zero.");
+        return LXW_ERROR_NULL_PARAMETER_IGNORED;
     }
 
-    /* Swap last row/col with first row/col as necessary */
-    if (first_row > last_row) {
-        tmp_row = last_row;
-        last_row = first_row;
-        first_row = tmp_row;
-    }
-    if (first_col > last_col) {
-        tmp_col = last_col;
-        last_col = first_col;
-        first_col = tmp_col;
-    }
+    if (_check_rollover_limit(self, row_num))
+        return LXW_ERROR_WORKSHEET_INDEX_OUT_OF_RANGE;
 
-    /* Check that column number is valid and store the max value */
-    err = _check_dimensions(self, last_row, last_col, LXW_TRUE, LXW_TRUE);
-    if (err)
-        return err;
+    /* Write the image buffer to a file (preferably in memory) so we can read
+     * the dimensions like an ordinary file. */
+#ifdef USE_FMEMOPEN
+    image_stream = fmemopen((void *) image_buffer, image_size, "rb");
 
-    num_cols = last_col - first_col + 1;
+    if (!image_stream)
+        return LXW_ERROR_CREATING_TMPFILE;
+#else
+    image_stream = lxw_tmpfile(self->tmpdir);
 
-    /* Check that there are sufficient data rows. */
-    err = _check_table_rows(first_row, last_row, user_options);
-    if (err)
-        return err;
+    if (!image_stream)
+        return LXW_ERROR_CREATING_TMPFILE;
 
-    /* Check that the the table name is valid. */
-    err = _check_table_name(user_options);
-    if (err)
-        return err;
+    if (fwrite(image_buffer, 1, image_size, image_stream) != image_size) {
+        fclose(image_stream);
+        return LXW_ERROR_CREATING_TMPFILE;
+    }
 
-    /* Create a table object to copy from the user options. */
-    table_obj = calloc(1, sizeof(lxw_table_obj));
-    RETURN_ON_MEM_ERROR(table_obj, LXW_ERROR_MEMORY_MALLOC_FAILED);
+    rewind(image_stream);
+#endif
 
-    columns = calloc(num_cols, sizeof(lxw_table_column *));
-    GOTO_LABEL_ON_MEM_ERROR(columns, error);
+    /* Create a new object to hold the image properties. */
+    object_props = calloc(1, sizeof(lxw_object_properties));
+    if (!object_props) {
+        fclose(image_stream);
+        return LXW_ERROR_MEMORY_MALLOC_FAILED;
+    }
 
-    table_obj->columns = columns;
-    table_obj->num_cols = num_cols;
-    table_obj->first_row = first_row;
-    table_obj->first_col = first_col;
-    table_obj->last_row = last_row;
-    table_obj->last_col = last_col;
+    /* Store the image data in the properties structure. */
+    object_props->image_buffer = calloc(1, image_size);
+    if (!object_props->image_buffer) {
+        _free_object_properties(object_props);
+        fclose(image_stream);
+        return LXW_ERROR_MEMORY_MALLOC_FAILED;
+    }
+    else {
+        memcpy(object_props->image_buffer, image_buffer, image_size);
+        object_props->image_buffer_size = image_size;
+        object_props->is_image_buffer = LXW_TRUE;
+    }
 
-    err = _set_default_table_columns(table_obj);
-    if (err)
-        goto error;
+    if (user_options) {
+        object_props->x_offset = user_options->x_offset;
+        object_props->y_offset = user_options->y_offset;
+        object_props->x_scale = user_options->x_scale;
+        object_props->y_scale = user_options->y_scale;
+        object_props->url = lxw_strdup(user_options->url);
+        object_props->tip = lxw_strdup(user_options->tip);
+        object_props->object_position = user_options->object_position;
+        object_props->description = lxw_strdup(user_options->description);
+        object_props->decorative = user_options->decorative;
+    }
 
-    /* Create the table range. */
-    lxw_rowcol_to_range(table_obj->sqref,
-                        first_row, first_col, last_row, last_col);
-    lxw_rowcol_to_range(table_obj->filter_sqref,
-                        first_row, first_col, last_row, last_col);
+    /* Copy other options or set defaults. */
+    object_props->filename = lxw_strdup("image_buffer");
+    object_props->stream = image_stream;
+    object_props->row = row_num;
+    object_props->col = col_num;
 
-    /* Validate and copy user options to an internal object. */
-    if (user_options) {
+    if (object_props->x_scale == 0.0)
+        object_props->x_scale = 1;
 
-        _check_and_copy_table_style(table_obj, user_options);
+    if (object_props->y_scale == 0.0)
+        object_props->y_scale = 1;
 
-        table_obj->total_row = user_options->total_row;
-        table_obj->last_column = user_options->last_column;
-        table_obj->first_column = user_options->first_column;
-        table_obj->no_autofilter = user_options->no_autofilter;
-        table_obj->no_header_row = user_options->no_header_row;
-        table_obj->no_banded_rows = user_options->no_banded_rows;
-        table_obj->banded_columns = user_options->banded_columns;
+    if (_get_image_properties(object_props) == LXW_NO_ERROR) {
+        STAILQ_INSERT_TAIL(self->image_props, object_props, list_pointers);
+        fclose(image_stream);
+        return LXW_NO_ERROR;
+    }
+    else {
+        _free_object_properties(object_props);
+        fclose(image_stream);
+        return LXW_ERROR_IMAGE_DIMENSIONS;
+    }
+}
 
-        if (user_options->no_header_row)
-            table_obj->no_autofilter = LXW_TRUE;
+/*
+ * Insert an image buffer into the worksheet.
+ */
+lxw_error
+worksheet_insert_image_buffer(lxw_worksheet *self,
+                              lxw_row_t row_num,
+                              lxw_col_t col_num,
+                              const unsigned char *image_buffer,
+                              size_t image_size)
+{
+    return worksheet_insert_image_buffer_opt(self, row_num, col_num,
+                                             image_buffer, image_size, NULL);
+}
 
-        if (user_options->columns) {
-            err = _set_custom_table_columns(table_obj, user_options);
-            if (err)
-                goto error;
-        }
+/*
+ * Embed an image with options into the worksheet.
+ */
+lxw_error
+worksheet_embed_image_opt(lxw_worksheet *self,
+                          lxw_row_t row_num, lxw_col_t col_num,
+                          const char *filename,
+                          lxw_image_options *user_options)
+{
+    FILE *image_stream;
+    lxw_object_properties *object_props;
+    lxw_error err;
 
-        if (user_options->total_row) {
-            lxw_rowcol_to_range(table_obj->filter_sqref,
-                                first_row, first_col, last_row - 1, last_col);
-        }
+    if (!filename) {
+        LXW_WARN("worksheet_embed_image()/_opt(): "
+                 "filename must be specified.");
+        return LXW_ERROR_NULL_PARAMETER_IGNORED;
+    }
 
-        if (user_options->name) {
-            table_obj->name = lxw_strdup(user_options->name);
-            if (!table_obj->name) {
-                err = LXW_ERROR_MEMORY_MALLOC_FAILED;
-                goto error;
-            }
-        }
+    /* Check that the image file exists and can be opened. */
+    image_stream = lxw_fopen(filename, "rb");
+    if (!image_stream) {
+        LXW_WARN_FORMAT1("worksheet_embed_image()/_opt(): "
+                         "file doesn't exist or can't be opened: %s.",
+                         filename);
+        return LXW_ERROR_PARAMETER_VALIDATION;
     }
 
-    _write_table_column_data(self, table_obj);
+    /* Check and store the cell dimensions. */
+    err = _check_dimensions(self, row_num, col_num, LXW_FALSE, LXW_FALSE);
+    if (err) {
+        fclose(image_stream);
+        return err;
+    }
 
-    STAILQ_INSERT_TAIL(self->table_objs, table_obj, list_pointers);
-    self->table_count++;
+    /* Create a new object to hold the image properties. */
+    object_props = calloc(1, sizeof(lxw_object_properties));
+    if (!object_props) {
+        fclose(image_stream);
+        return LXW_ERROR_MEMORY_MALLOC_FAILED;
+    }
 
-    return LXW_NO_ERROR;
+    /* We only copy/use a limited number of options for embedded images. */
+    if (user_options) {
+        if (user_options->cell_format)
+            object_props->format = user_options->cell_format;
 
-error:
-    _free_worksheet_table(table_obj);
-    return err;
+        /* The url for embedded images is written as a cell url. */
+        if (user_options->url) {
+            if (!user_options->cell_format)
+                object_props->format = self->default_url_format;
 
-}
+            self->storing_embedded_image = LXW_TRUE;
+            err = worksheet_write_url(self,
+                                      row_num,
+                                      col_num,
+                                      user_options->url,
+                                      object_props->format);
+            if (err) {
+                _free_object_properties(object_props);
+                fclose(image_stream);
+                return err;
+            }
 
-/*
- * Set this worksheet as a selected worksheet, i.e. the worksheet has its tab
- * highlighted.
- */
-void
-worksheet_select(lxw_worksheet *self)
-{
-    self->selected = LXW_TRUE;
+            self->storing_embedded_image = LXW_FALSE;
+        }
 
-    /* Selected worksheet can't be hidden. */
-    self->hidden = LXW_FALSE;
-}
+        object_props->decorative = user_options->decorative;
+        if (user_options->description)
+            object_props->description = lxw_strdup(user_options->description);
+    }
 
-/*
- * Set this worksheet as the active worksheet, i.e. the worksheet that is
- * displayed when the workbook is opened. Also set it as selected.
- */
-void
-worksheet_activate(lxw_worksheet *self)
-{
-    self->selected = LXW_TRUE;
-    self->active = LXW_TRUE;
+    /* Copy other options or set defaults. */
+    object_props->filename = lxw_strdup(filename);
+    object_props->stream = image_stream;
+    object_props->row = row_num;
+    object_props->col = col_num;
 
-    /* Active worksheet can't be hidden. */
-    self->hidden = LXW_FALSE;
+    if (object_props->x_scale == 0.0)
+        object_props->x_scale = 1;
 
-    *self->active_sheet = self->index;
-}
+    if (object_props->y_scale == 0.0)
+        object_props->y_scale = 1;
 
-/*
- * Set this worksheet as the first visible sheet. This is necessary
- * when there are a large number of worksheets and the activated
- * worksheet is not visible on the screen.
- */
-void
-worksheet_set_first_sheet(lxw_worksheet *self)
-{
-    /* Active worksheet can't be hidden. */
-    self->hidden = LXW_FALSE;
+    if (_get_image_properties(object_props) == LXW_NO_ERROR) {
+        STAILQ_INSERT_TAIL(self->embedded_image_props, object_props,
+                           list_pointers);
+        fclose(image_stream);
 
-    *self->first_sheet = self->index;
+        return LXW_NO_ERROR;
+    }
+    else {
+        _free_object_properties(object_props);
+        fclose(image_stream);
+        return LXW_ERROR_IMAGE_DIMENSIONS;
+    }
 }
 
 /*
- * Hide this worksheet.
+ * Embed an image into the worksheet.
  */
-void
-worksheet_hide(lxw_worksheet *self)
+lxw_error
+worksheet_embed_image(lxw_worksheet *self,
+                      lxw_row_t row_num, lxw_col_t col_num,
+                      const char *filename)
 {
-    self->hidden = LXW_TRUE;
-
-    /* A hidden worksheet shouldn't be active or selected. */
-    self->selected = LXW_FALSE;
-
-    /* If this is active_sheet or first_sheet reset the workbook value. */
-    if (*self->first_sheet == self->index)
-        *self->first_sheet = 0;
-
-    if (*self->active_sheet == self->index)
-        *self->active_sheet = 0;
+    return worksheet_embed_image_opt(self, row_num, col_num, filename, NULL);
 }
 
 /*
- * Set which cell or cells are selected in a worksheet.
+ * Embed an image buffer, with options, into the worksheet.
  */
 lxw_error
-worksheet_set_selection(lxw_worksheet *self,
-                        lxw_row_t first_row, lxw_col_t first_col,
-                        lxw_row_t last_row, lxw_col_t last_col)
+worksheet_embed_image_buffer_opt(lxw_worksheet *self,
+                                 lxw_row_t row_num,
+                                 lxw_col_t col_num,
+                                 const unsigned char *image_buffer,
+                                 size_t image_size,
+                                 lxw_image_options *user_options)
 {
-    lxw_selection *selection;
-    lxw_row_t tmp_row;
-    lxw_col_t tmp_col;
+    FILE *image_stream;
+    lxw_object_properties *object_props;
     lxw_error err;
-    char active_cell[LXW_MAX_CELL_RANGE_LENGTH];
-    char sqref[LXW_MAX_CELL_RANGE_LENGTH];
-
-    /* Only allow selection to be set once to avoid freeing/re-creating it. */
-    if (!STAILQ_EMPTY(self->selections))
-        return LXW_ERROR_PARAMETER_VALIDATION;
-
-    /* Excel doesn't set a selection for cell A1 since it is the default. */
-    if (first_row == 0 && first_col == 0 && last_row == 0 && last_col == 0)
-        return LXW_NO_ERROR;
-
-    selection = calloc(1, sizeof(lxw_selection));
-    RETURN_ON_MEM_ERROR(selection, LXW_ERROR_MEMORY_MALLOC_FAILED);
 
-    /* Check that row and col are valid without storing. */
-    err = _check_dimensions(self, first_row, first_col, LXW_TRUE, LXW_TRUE);
-    if (err) {
-        free(selection);
-        return err;
+    if (!image_size) {
+        LXW_WARN("worksheet_embed_image_buffer()/_opt(): "
+                 "size must be non-zero.");
+        return LXW_ERROR_NULL_PARAMETER_IGNORED;
     }
 
-    err = _check_dimensions(self, last_row, last_col, LXW_TRUE, LXW_TRUE);
-    if (err) {
-        free(selection);
-        return err;
-    }
+    /* Write the image buffer to a file (preferably in memory) so we can read
+     * the dimensions like an ordinary file. For embedded images we really only
+     * need the image type. */
+#ifdef USE_FMEMOPEN
+    image_stream = fmemopen((void *) image_buffer, image_size, "rb");
 
-    /* Set the cell range selection. Do this before swapping max/min to  */
-    /* allow the selection direction to be reversed. */
-    lxw_rowcol_to_cell(active_cell, first_row, first_col);
+    if (!image_stream)
+        return LXW_ERROR_CREATING_TMPFILE;
+#else
+    image_stream = lxw_tmpfile(self->tmpdir);
 
-    /* Swap last row/col for first row/col if necessary. */
-    if (first_row > last_row) {
-        tmp_row = first_row;
-        first_row = last_row;
-        last_row = tmp_row;
-    }
+    if (!image_stream)
+        return LXW_ERROR_CREATING_TMPFILE;
 
-    if (first_col > last_col) {
-        tmp_col = first_col;
-        first_col = last_col;
-        last_col = tmp_col;
+    if (fwrite(image_buffer, 1, image_size, image_stream) != image_size) {
+        fclose(image_stream);
+        return LXW_ERROR_CREATING_TMPFILE;
     }
 
-    /* If the first and last cell are the same write a single cell. */
-    if ((first_row == last_row) && (first_col == last_col))
-        lxw_rowcol_to_cell(sqref, first_row, first_col);
-    else
-        lxw_rowcol_to_range(sqref, first_row, first_col, last_row, last_col);
-
-    lxw_strcpy(selection->pane, "");
-    lxw_strcpy(selection->active_cell, active_cell);
-    lxw_strcpy(selection->sqref, sqref);
-
-    STAILQ_INSERT_TAIL(self->selections, selection, list_pointers);
+    rewind(image_stream);
+#endif
 
-    return LXW_NO_ERROR;
-}
+    /* Check and store the cell dimensions. */
+    err = _check_dimensions(self, row_num, col_num, LXW_FALSE, LXW_FALSE);
+    if (err)
+        return err;
 
-/*
- * Set the first visible cell at the top left of the worksheet.
- */
-void
-worksheet_set_top_left_cell(lxw_worksheet *self, lxw_row_t row, lxw_col_t col)
-{
-    if (row == 0 && col == 0)
-        return;
+    /* Create a new object to hold the image properties. */
+    object_props = calloc(1, sizeof(lxw_object_properties));
+    if (!object_props) {
+        fclose(image_stream);
+        return LXW_ERROR_MEMORY_MALLOC_FAILED;
+    }
 
-    lxw_rowcol_to_cell(self->top_left_cell, row, col);
-}
+    /* Store the image data in the properties structure. */
+    object_props->image_buffer = calloc(1, image_size);
+    if (!object_props->image_buffer) {
+        _free_object_properties(object_props);
+        fclose(image_stream);
+        return LXW_ERROR_MEMORY_MALLOC_FAILED;
+    }
+    else {
+        memcpy(object_props->image_buffer, image_buffer, image_size);
+        object_props->image_buffer_size = image_size;
+        object_props->is_image_buffer = LXW_TRUE;
+    }
 
-/*
- * Set panes and mark them as frozen. With extra options.
- */
-void
-worksheet_freeze_panes_opt(lxw_worksheet *self,
-                           lxw_row_t first_row, lxw_col_t first_col,
-                           lxw_row_t top_row, lxw_col_t left_col,
-                           uint8_t type)
-{
-    self->panes.first_row = first_row;
-    self->panes.first_col = first_col;
-    self->panes.top_row = top_row;
-    self->panes.left_col = left_col;
-    self->panes.x_split = 0.0;
-    self->panes.y_split = 0.0;
+    /* We only copy/use a limited number of options for embedded images. */
+    if (user_options) {
+        if (user_options->cell_format)
+            object_props->format = user_options->cell_format;
 
-    if (type)
-        self->panes.type = FREEZE_SPLIT_PANES;
-    else
-        self->panes.type = FREEZE_PANES;
-}
+        /* The url for embedded images is written as a cell url. */
+        if (user_options->url) {
+            if (!user_options->cell_format)
+                object_props->format = self->default_url_format;
 
-/*
- * Set panes and mark them as frozen.
- */
-void
-worksheet_freeze_panes(lxw_worksheet *self,
-                       lxw_row_t first_row, lxw_col_t first_col)
-{
-    worksheet_freeze_panes_opt(self, first_row, first_col,
-                               first_row, first_col, 0);
-}
+            self->storing_embedded_image = LXW_TRUE;
+            err = worksheet_write_url(self,
+                                      row_num,
+                                      col_num,
+                                      user_options->url,
+                                      object_props->format);
+            if (err) {
+                _free_object_properties(object_props);
+                fclose(image_stream);
+                return err;
+            }
 
-/*
- * Set panes and mark them as split.With extra options.
- */
-void
-worksheet_split_panes_opt(lxw_worksheet *self,
-                          double y_split, double x_split,
-                          lxw_row_t top_row, lxw_col_t left_col)
-{
-    self->panes.first_row = 0;
-    self->panes.first_col = 0;
-    self->panes.top_row = top_row;
-    self->panes.left_col = left_col;
-    self->panes.x_split = x_split;
-    self->panes.y_split = y_split;
-    self->panes.type = SPLIT_PANES;
-}
+            self->storing_embedded_image = LXW_FALSE;
+        }
 
-/*
- * Set panes and mark them as split.
- */
-void
-worksheet_split_panes(lxw_worksheet *self, double y_split, double x_split)
-{
-    worksheet_split_panes_opt(self, y_split, x_split, 0, 0);
-}
+        object_props->decorative = user_options->decorative;
+        if (user_options->description)
+            object_props->description = lxw_strdup(user_options->description);
+    }
 
-/*
- * Set the page orientation as portrait.
- */
-void
-worksheet_set_portrait(lxw_worksheet *self)
-{
-    self->orientation = LXW_PORTRAIT;
-    self->page_setup_changed = LXW_TRUE;
-}
+    /* Copy other options or set defaults. */
+    object_props->filename = lxw_strdup("image_buffer");
+    object_props->stream = image_stream;
+    object_props->row = row_num;
+    object_props->col = col_num;
 
-/*
- * Set the page orientation as landscape.
- */
-void
-worksheet_set_landscape(lxw_worksheet *self)
-{
-    self->orientation = LXW_LANDSCAPE;
-    self->page_setup_changed = LXW_TRUE;
-}
+    if (object_props->x_scale == 0.0)
+        object_props->x_scale = 1;
 
-/*
- * Set the page view mode for Mac Excel.
- */
-void
-worksheet_set_page_view(lxw_worksheet *self)
-{
-    self->page_view = LXW_TRUE;
-}
+    if (object_props->y_scale == 0.0)
+        object_props->y_scale = 1;
 
-/*
- * Set the paper type. Example. 1 = US Letter, 9 = A4
- */
-void
-worksheet_set_paper(lxw_worksheet *self, uint8_t paper_size)
-{
-    self->paper_size = paper_size;
-    self->page_setup_changed = LXW_TRUE;
+    if (_get_image_properties(object_props) == LXW_NO_ERROR) {
+        STAILQ_INSERT_TAIL(self->embedded_image_props, object_props,
+                           list_pointers);
+        fclose(image_stream);
+
+        return LXW_NO_ERROR;
+    }
+    else {
+        _free_object_properties(object_props);
+        fclose(image_stream);
+        return LXW_ERROR_IMAGE_DIMENSIONS;
+    }
 }
 
 /*
- * Set the order in which pages are printed.
+ * Insert an image buffer into the worksheet.
  */
-void
-worksheet_print_across(lxw_worksheet *self)
+lxw_error
+worksheet_embed_image_buffer(lxw_worksheet *self,
+                             lxw_row_t row_num,
+                             lxw_col_t col_num,
+                             const unsigned char *image_buffer,
+                             size_t image_size)
 {
-    self->page_order = LXW_PRINT_ACROSS;
-    self->page_setup_changed = LXW_TRUE;
+    return worksheet_embed_image_buffer_opt(self, row_num, col_num,
+                                            image_buffer, image_size, NULL);
 }
 
 /*
- * Set all the page margins in inches.
+ * Set an image as a worksheet background.
  */
-void
-worksheet_set_margins(lxw_worksheet *self, double left, double right,
-                      double top, double bottom)
+lxw_error
+worksheet_set_background(lxw_worksheet *self, const char *filename)
 {
+    FILE *image_stream;
+    lxw_object_properties *object_props;
 
-    if (left >= 0)
-        self->margin_left = left;
+    if (!filename) {
+        LXW_WARN("worksheet_set_background(): "
+                 "filename must be specified.");
+        return LXW_ERROR_NULL_PARAMETER_IGNORED;
+    }
 
-    if (right >= 0)
-        self->margin_right = right;
+    /* Check that the image file exists and can be opened. */
+    image_stream = lxw_fopen(filename, "rb");
+    if (!image_stream) {
+        LXW_WARN_FORMAT1("worksheet_set_background(): "
+                         "file doesn't exist or can't be opened: %s.",
+                         filename);
+        return LXW_ERROR_PARAMETER_VALIDATION;
+    }
 
-    if (top >= 0)
-        self->margin_top = top;
+    /* Create a new object to hold the image properties. */
+    object_props = calloc(1, sizeof(lxw_object_properties));
+    if (!object_props) {
+        fclose(image_stream);
+        return LXW_ERROR_MEMORY_MALLOC_FAILED;
+    }
 
-    if (bottom >= 0)
-        self->margin_bottom = bottom;
+    /* Copy other options or set defaults. */
+    object_props->filename = lxw_strdup(filename);
+    object_props->stream = image_stream;
+    object_props->is_background = LXW_TRUE;
+
+    if (_get_image_properties(object_props) == LXW_NO_ERROR) {
+        _free_object_properties(self->background_image);
+        self->background_image = object_props;
+        self->has_background_image = LXW_TRUE;
+        fclose(image_stream);
+        return LXW_NO_ERROR;
+    }
+    else {
+        _free_object_properties(object_props);
+        fclose(image_stream);
+        return LXW_ERROR_IMAGE_DIMENSIONS;
+    }
 }
 
 /*
- * Set the page header caption and options.
+ * Set an image buffer as a worksheet background.
  */
 lxw_error
-worksheet_set_header_opt(lxw_worksheet *self, const char *string,
-                         lxw_header_footer_options *options)
+worksheet_set_background_buffer(lxw_worksheet *self,
+                                const unsigned char *image_buffer,
+                                size_t image_size)
 {
-    lxw_error err;
-    char *tmp_header;
-    char *found_string;
-    char *offset_string;
-    uint8_t placeholder_count = 0;
-    uint8_t image_count = 0;
+    FILE *image_stream;
+    lxw_object_properties *object_props;
 
-    if (!string) {
-        LXW_WARN_FORMAT("worksheet_set_header_opt/footer_opt(): "
-                        "header/footer string cannot be NULL.");
+    if (!image_size) {
+        LXW_WARN("worksheet_set_background(): " "size must be non-zero.");
         return LXW_ERROR_NULL_PARAMETER_IGNORED;
     }
 
-    if (lxw_utf8_strlen(string) > LXW_HEADER_FOOTER_MAX) {
-        LXW_WARN_FORMAT("worksheet_set_header_opt/footer_opt(): "
-                        "header/footer string exceeds Excel's limit of "
-                        "255 characters.");
-        return LXW_ERROR_255_STRING_LENGTH_EXCEEDED;
+    /* Write the image buffer to a file (preferably in memory) so we can read
+     * the dimensions like an ordinary file. */
+#ifdef USE_FMEMOPEN
+    image_stream = fmemopen((void *) image_buffer, image_size, "rb");
+
+    if (!image_stream)
+        return LXW_ERROR_CREATING_TMPFILE;
+#else
+    image_stream = lxw_tmpfile(self->tmpdir);
+
+    if (!image_stream)
+        return LXW_ERROR_CREATING_TMPFILE;
+
+    if (fwrite(image_buffer, 1, image_size, image_stream) != image_size) {
+        fclose(image_stream);
+        return LXW_ERROR_CREATING_TMPFILE;
     }
 
-    tmp_header = lxw_strdup(string);
-    RETURN_ON_MEM_ERROR(tmp_header, LXW_ERROR_MEMORY_MALLOC_FAILED);
+    rewind(image_stream);
+#endif
 
-    /* Replace &[Picture] with &G which is used internally by Excel. */
-    while ((found_string = strstr(tmp_header, "&[Picture]"))) {
-        found_string++;
-        *found_string = 'G';
+    /* Create a new object to hold the image properties. */
+    object_props = calloc(1, sizeof(lxw_object_properties));
+    if (!object_props) {
+        fclose(image_stream);
+        return LXW_ERROR_MEMORY_MALLOC_FAILED;
+    }
 
-        do {
-            found_string++;
-            offset_string = found_string + sizeof("Picture");
-            *found_string = *offset_string;
-        } while (*offset_string);
+    /* Store the image data in the properties structure. */
+    object_props->image_buffer = calloc(1, image_size);
+    if (!object_props->image_buffer) {
+        _free_object_properties(object_props);
+        fclose(image_stream);
+        return LXW_ERROR_MEMORY_MALLOC_FAILED;
+    }
+    else {
+        memcpy(object_props->image_buffer, image_buffer, image_size);
+        object_props->image_buffer_size = image_size;
+        object_props->is_image_buffer = LXW_TRUE;
     }
 
-    /* Count &G placeholders and ensure there are sufficient images. */
-    found_string = tmp_header;
-    while (*found_string) {
-        if (*found_string == '&' && *(found_string + 1) == 'G')
-            placeholder_count++;
-        found_string++;
+    /* Copy other options or set defaults. */
+    object_props->filename = lxw_strdup("image_buffer");
+    object_props->stream = image_stream;
+    object_props->is_background = LXW_TRUE;
+
+    if (_get_image_properties(object_props) == LXW_NO_ERROR) {
+        _free_object_properties(self->background_image);
+        self->background_image = object_props;
+        self->has_background_image = LXW_TRUE;
+        fclose(image_stream);
+        return LXW_NO_ERROR;
+    }
+    else {
+        _free_object_properties(object_props);
+        fclose(image_stream);
+        return LXW_ERROR_IMAGE_DIMENSIONS;
     }
+}
 
-    if (placeholder_count > 0 && !options) {
-        LXW_WARN_FORMAT1("worksheet_set_header_opt/footer_opt(): "
-                         "the number of &G/&[Picture] placeholders in option "
-                         "string \"%s\" does not match the number of supplied "
-                         "images.", string);
+/*
+ * Insert an chart into the worksheet.
+ */
+lxw_error
+worksheet_insert_chart_opt(lxw_worksheet *self,
+                           lxw_row_t row_num, lxw_col_t col_num,
+                           lxw_chart *chart, lxw_chart_options *user_options)
+{
+    lxw_object_properties *object_props;
+    lxw_chart_series *series;
+
+    if (!chart) {
+        LXW_WARN("worksheet_insert_chart()/_opt(): chart must be non-NULL.");
+        return LXW_ERROR_NULL_PARAMETER_IGNORED;
+    }
+
+    if (_check_rollover_limit(self, row_num))
+        return LXW_ERROR_WORKSHEET_INDEX_OUT_OF_RANGE;
+
+    /* Check that the chart isn't being used more than once. */
+    if (chart->in_use) {
+        LXW_WARN("worksheet_insert_chart()/_opt(): the same chart object "
+                 "cannot be inserted in a worksheet more than once.");
 
-        free(tmp_header);
         return LXW_ERROR_PARAMETER_VALIDATION;
     }
 
-    /* Free any previous header string so we can overwrite it. */
-    free(self->header);
-    self->header = NULL;
+    /* Check that the chart has a data series. */
+    if (STAILQ_EMPTY(chart->series_list)) {
+        LXW_WARN
+            ("worksheet_insert_chart()/_opt(): chart must have a series.");
 
-    if (options) {
-        /* Ensure there are enough images to match the placeholders. There is
-         * a potential bug where there are sufficient images but in the wrong
-         * positions but we don't currently try to deal with that.*/
-        if (options->image_left)
-            image_count++;
-        if (options->image_center)
-            image_count++;
-        if (options->image_right)
-            image_count++;
+        return LXW_ERROR_PARAMETER_VALIDATION;
+    }
 
-        if (placeholder_count != image_count) {
-            LXW_WARN_FORMAT1("worksheet_set_header_opt/footer_opt(): "
-                             "the number of &G/&[Picture] placeholders in option "
-                             "string \"%s\" does not match the number of supplied "
-                             "images.", string);
+    /* Check that the chart has a 'values' series. */
+    STAILQ_FOREACH(series, chart->series_list, list_pointers) {
+        if (!series->values->formula && !series->values->sheetname) {
+            LXW_WARN("worksheet_insert_chart()/_opt(): chart must have a "
+                     "'values' series.");
 
-            free(tmp_header);
             return LXW_ERROR_PARAMETER_VALIDATION;
         }
+    }
 
-        /* Free any existing header image objects. */
-        _free_object_properties(self->header_left_object_props);
-        _free_object_properties(self->header_center_object_props);
-        _free_object_properties(self->header_right_object_props);
+    /* Create a new object to hold the chart image properties. */
+    object_props = calloc(1, sizeof(lxw_object_properties));
+    RETURN_ON_MEM_ERROR(object_props, LXW_ERROR_MEMORY_MALLOC_FAILED);
 
-        if (options->margin > 0.0)
-            self->margin_header = options->margin;
+    if (user_options) {
+        object_props->x_offset = user_options->x_offset;
+        object_props->y_offset = user_options->y_offset;
+        object_props->x_scale = user_options->x_scale;
+        object_props->y_scale = user_options->y_scale;
+        object_props->object_position = user_options->object_position;
+        object_props->description = lxw_strdup(user_options->description);
+        object_props->decorative = user_options->decorative;
+    }
 
-        err = _worksheet_set_header_footer_image(self,
-                                                 options->image_left,
-                                                 HEADER_LEFT);
-        if (err) {
-            free(tmp_header);
-            return err;
-        }
+    /* Copy other options or set defaults. */
+    object_props->row = row_num;
+    object_props->col = col_num;
 
-        err = _worksheet_set_header_footer_image(self,
-                                                 options->image_center,
-                                                 HEADER_CENTER);
-        if (err) {
-            free(tmp_header);
-            return err;
-        }
+    object_props->width = 480;
+    object_props->height = 288;
 
-        err = _worksheet_set_header_footer_image(self,
-                                                 options->image_right,
-                                                 HEADER_RIGHT);
-        if (err) {
-            free(tmp_header);
-            return err;
-        }
-    }
+    if (object_props->x_scale == 0.0)
+        object_props->x_scale = 1;
 
-    self->header = tmp_header;
-    self->header_footer_changed = LXW_TRUE;
+    if (object_props->y_scale == 0.0)
+        object_props->y_scale = 1;
+
+    /* Store chart references so they can be ordered in the workbook. */
+    object_props->chart = chart;
+
+    STAILQ_INSERT_TAIL(self->chart_data, object_props, list_pointers);
+
+    chart->in_use = LXW_TRUE;
 
     return LXW_NO_ERROR;
 }
 
 /*
- * Set the page footer caption and options.
+ * Insert an image into the worksheet.
  */
 lxw_error
-worksheet_set_footer_opt(lxw_worksheet *self, const char *string,
-                         lxw_header_footer_options *options)
+worksheet_insert_chart(lxw_worksheet *self,
+                       lxw_row_t row_num, lxw_col_t col_num, lxw_chart *chart)
+{
+    return worksheet_insert_chart_opt(self, row_num, col_num, chart, NULL);
+}
+
+/*
+ * Add a data validation to a worksheet, for a range. Ironically this requires
+ * a lot of validation of the user input.
+ */
+lxw_error
+worksheet_data_validation_range(lxw_worksheet *self, lxw_row_t first_row,
+                                lxw_col_t first_col,
+                                lxw_row_t last_row,
+                                lxw_col_t last_col,
+                                lxw_data_validation *validation)
 {
+    lxw_data_val_obj *copy;
+    uint8_t is_between = LXW_FALSE;
+    uint8_t is_formula = LXW_FALSE;
+    uint8_t has_criteria = LXW_TRUE;
     lxw_error err;
-    char *tmp_footer;
-    char *found_string;
-    char *offset_string;
-    uint8_t placeholder_count = 0;
-    uint8_t image_count = 0;
+    lxw_row_t tmp_row;
+    lxw_col_t tmp_col;
+    size_t length;
 
-    if (!string) {
-        LXW_WARN_FORMAT("worksheet_set_header_opt/footer_opt(): "
-                        "header/footer string cannot be NULL.");
-        return LXW_ERROR_NULL_PARAMETER_IGNORED;
-    }
+    /* No action is required for validation type 'any' unless there are
+     * input messages to display.*/
+    if (validation->validate == LXW_VALIDATION_TYPE_ANY
+        && !(validation->input_title || validation->input_message)) {
 
-    if (lxw_utf8_strlen(string) > LXW_HEADER_FOOTER_MAX) {
-        LXW_WARN_FORMAT("worksheet_set_header_opt/footer_opt(): "
-                        "header/footer string exceeds Excel's limit of "
-                        "255 characters.");
-        return LXW_ERROR_255_STRING_LENGTH_EXCEEDED;
+        return LXW_NO_ERROR;
     }
 
-    tmp_footer = lxw_strdup(string);
-    RETURN_ON_MEM_ERROR(tmp_footer, LXW_ERROR_MEMORY_MALLOC_FAILED);
-
-    /* Replace &[Picture] with &G which is used internally by Excel. */
-    while ((found_string = strstr(tmp_footer, "&[Picture]"))) {
-        found_string++;
-        *found_string = 'G';
-
-        do {
-            found_string++;
-            offset_string = found_string + sizeof("Picture");
-            *found_string = *offset_string;
-        } while (*offset_string);
+    /* Check for formula types. */
+    switch (validation->validate) {
+        case LXW_VALIDATION_TYPE_INTEGER_FORMULA:
+        case LXW_VALIDATION_TYPE_DECIMAL_FORMULA:
+        case LXW_VALIDATION_TYPE_LIST_FORMULA:
+        case LXW_VALIDATION_TYPE_LENGTH_FORMULA:
+        case LXW_VALIDATION_TYPE_DATE_FORMULA:
+        case LXW_VALIDATION_TYPE_TIME_FORMULA:
+        case LXW_VALIDATION_TYPE_CUSTOM_FORMULA:
+            is_formula = LXW_TRUE;
+            break;
     }
 
-    /* Count &G placeholders and ensure there are sufficient images. */
-    found_string = tmp_footer;
-    while (*found_string) {
-        if (*found_string == '&' && *(found_string + 1) == 'G')
-            placeholder_count++;
-        found_string++;
+    /* Check for types without a criteria. */
+    switch (validation->validate) {
+        case LXW_VALIDATION_TYPE_LIST:
+        case LXW_VALIDATION_TYPE_LIST_FORMULA:
+        case LXW_VALIDATION_TYPE_ANY:
+        case LXW_VALIDATION_TYPE_CUSTOM_FORMULA:
+            has_criteria = LXW_FALSE;
+            break;
     }
 
-    if (placeholder_count > 0 && !options) {
-        LXW_WARN_FORMAT1("worksheet_set_header_opt/footer_opt(): "
-                         "the number of &G/&[Picture] placeholders in option "
-                         "string \"%s\" does not match the number of supplied "
-                         "images.", string);
+    /* Check that a validation parameter has been specified
+     * except for 'list', 'any' and 'custom'. */
+    if (has_criteria && validation->criteria == LXW_VALIDATION_CRITERIA_NONE) {
 
-        free(tmp_footer);
+        LXW_WARN_FORMAT("worksheet_data_validation_cell()/_range(): "
+                        "criteria parameter must be specified.");
         return LXW_ERROR_PARAMETER_VALIDATION;
     }
 
-    /* Free any previous footer string so we can overwrite it. */
-    free(self->footer);
-    self->footer = NULL;
+    /* Check for "between" criteria so we can do additional checks. */
+    if (has_criteria
+        && (validation->criteria == LXW_VALIDATION_CRITERIA_BETWEEN
+            || validation->criteria == LXW_VALIDATION_CRITERIA_NOT_BETWEEN)) {
 
-    if (options) {
-        /* Ensure there are enough images to match the placeholders. There is
-         * a potential bug where there are sufficient images but in the wrong
-         * positions but we don't currently try to deal with that.*/
-        if (options->image_left)
-            image_count++;
-        if (options->image_center)
-            image_count++;
-        if (options->image_right)
-            image_count++;
+        is_between = LXW_TRUE;
+    }
 
-        if (placeholder_count != image_count) {
-            LXW_WARN_FORMAT1("worksheet_set_header_opt/footer_opt(): "
-                             "the number of &G/&[Picture] placeholders in option "
-                             "string \"%s\" does not match the number of supplied "
-                             "images.", string);
+    /* Check that formula values are non NULL. */
+    if (is_formula) {
+        if (is_between) {
+            if (!validation->minimum_formula) {
+                LXW_WARN_FORMAT("worksheet_data_validation_cell()/_range(): "
+                                "minimum_formula parameter cannot be NULL.");
+                return LXW_ERROR_PARAMETER_VALIDATION;
+            }
+            if (!validation->maximum_formula) {
+                LXW_WARN_FORMAT("worksheet_data_validation_cell()/_range(): "
+                                "maximum_formula parameter cannot be NULL.");
+                return LXW_ERROR_PARAMETER_VALIDATION;
+            }
+        }
+        else {
+            if (!validation->value_formula) {
+                LXW_WARN_FORMAT("worksheet_data_validation_cell()/_range(): "
+                                "formula parameter cannot be NULL.");
+                return LXW_ERROR_PARAMETER_VALIDATION;
+            }
+        }
+    }
 
-            free(tmp_footer);
-            return LXW_ERROR_PARAMETER_VALIDATION;
+    /* Check Excel limitations on input strings. */
+    if (validation->input_title) {
+        length = lxw_utf8_strlen(validation->input_title);
+        if (length > LXW_VALIDATION_MAX_TITLE_LENGTH) {
+            LXW_WARN_FORMAT1("worksheet_data_validation_cell()/_range(): "
+                             "input_title length > Excel limit of %d.",
+                             LXW_VALIDATION_MAX_TITLE_LENGTH);
+            return LXW_ERROR_32_STRING_LENGTH_EXCEEDED;
+        }
+    }
+
+    if (validation->error_title) {
+        length = lxw_utf8_strlen(validation->error_title);
+        if (length > LXW_VALIDATION_MAX_TITLE_LENGTH) {
+            LXW_WARN_FORMAT1("worksheet_data_validation_cell()/_range(): "
+                             "error_title length > Excel limit of %d.",
+                             LXW_VALIDATION_MAX_TITLE_LENGTH);
+            return LXW_ERROR_32_STRING_LENGTH_EXCEEDED;
+        }
+    }
+
+    if (validation->input_message) {
+        length = lxw_utf8_strlen(validation->input_message);
+        if (length > LXW_VALIDATION_MAX_STRING_LENGTH) {
+            LXW_WARN_FORMAT1("worksheet_data_validation_cell()/_range(): "
+                             "input_message length > Excel limit of %d.",
+                             LXW_VALIDATION_MAX_STRING_LENGTH);
+            return LXW_ERROR_255_STRING_LENGTH_EXCEEDED;
         }
+    }
 
-        /* Free any existing footer image objects. */
-        _free_object_properties(self->footer_left_object_props);
-        _free_object_properties(self->footer_center_object_props);
-        _free_object_properties(self->footer_right_object_props);
+    if (validation->error_message) {
+        length = lxw_utf8_strlen(validation->error_message);
+        if (length > LXW_VALIDATION_MAX_STRING_LENGTH) {
+            LXW_WARN_FORMAT1("worksheet_data_validation_cell()/_range(): "
+                             "error_message length > Excel limit of %d.",
+                             LXW_VALIDATION_MAX_STRING_LENGTH);
+            return LXW_ERROR_255_STRING_LENGTH_EXCEEDED;
+        }
+    }
 
-        if (options->margin > 0.0)
-            self->margin_footer = options->margin;
+    if (validation->validate == LXW_VALIDATION_TYPE_LIST) {
+        length = _validation_list_length(validation->value_list);
 
-        err = _worksheet_set_header_footer_image(self,
-                                                 options->image_left,
-                                                 FOOTER_LEFT);
-        if (err) {
-            free(tmp_footer);
-            return err;
+        if (length == 0) {
+            LXW_WARN_FORMAT("worksheet_data_validation_cell()/_range(): "
+                            "list parameters cannot be zero.");
+            return LXW_ERROR_PARAMETER_VALIDATION;
         }
 
-        err = _worksheet_set_header_footer_image(self,
-                                                 options->image_center,
-                                                 FOOTER_CENTER);
-        if (err) {
-            free(tmp_footer);
-            return err;
+        /* Long lists can be stored in the workbook shared lists. */
+        if (length > LXW_VALIDATION_MAX_STRING_LENGTH
+            && !self->validation_lists) {
+            LXW_WARN_FORMAT1("worksheet_data_validation_cell()/_range(): "
+                             "list length with commas > Excel limit of %d.",
+                             LXW_VALIDATION_MAX_STRING_LENGTH);
+            return LXW_ERROR_255_STRING_LENGTH_EXCEEDED;
         }
+    }
 
-        err = _worksheet_set_header_footer_image(self,
-                                                 options->image_right,
-                                                 FOOTER_RIGHT);
-        if (err) {
-            free(tmp_footer);
-            return err;
-        }
+    /* Swap last row/col with first row/col as necessary */
+    if (first_row > last_row) {
+        tmp_row = last_row;
+        last_row = first_row;
+        first_row = tmp_row;
+    }
+    if (first_col > last_col) {
+        tmp_col = last_col;
+        last_col = first_col;
+        first_col = tmp_col;
     }
 
-    self->footer = tmp_footer;
-    self->header_footer_changed = LXW_TRUE;
+    /* Check that dimensions are valid but don't store them. */
+    err = _check_dimensions(self, last_row, last_col, LXW_TRUE, LXW_TRUE);
+    if (err)
+        return err;
 
-    return LXW_NO_ERROR;
-}
+    if (_check_rollover_limit(self, last_row))
+        return LXW_ERROR_WORKSHEET_INDEX_OUT_OF_RANGE;
 
-/*
- * Set the page header caption.
- */
-lxw_error
-worksheet_set_header(lxw_worksheet *self, const char *string)
-{
-    return worksheet_set_header_opt(self, string, NULL);
-}
+    /* Create a copy of the parameters from the user data validation. */
+    copy = calloc(1, sizeof(lxw_data_val_obj));
+    GOTO_LABEL_ON_MEM_ERROR(copy, mem_error);
 
-/*
- * Set the page footer caption.
- */
-lxw_error
-worksheet_set_footer(lxw_worksheet *self, const char *string)
-{
-    return worksheet_set_footer_opt(self, string, NULL);
-}
+    /* Create the data validation range. */
+    if (first_row == last_row && first_col == last_col)
+        lxw_rowcol_to_cell(copy->sqref, first_row, first_col);
+    else
+        lxw_rowcol_to_range(copy->sqref, first_row, first_col, last_row,
+                            last_col);
 
-/*
- * Set the option to show/hide gridlines on the screen and the printed page.
- */
-void
-worksheet_gridlines(lxw_worksheet *self, uint8_t option)
-{
-    if (option == LXW_HIDE_ALL_GRIDLINES) {
-        self->print_gridlines = 0;
-        self->screen_gridlines = 0;
+    /* Copy the parameters from the user data validation. */
+    copy->validate = validation->validate;
+    copy->value_number = validation->value_number;
+    copy->error_type = validation->error_type;
+    copy->dropdown = validation->dropdown;
+
+    if (has_criteria)
+        copy->criteria = validation->criteria;
+
+    if (is_between) {
+        copy->value_number = validation->minimum_number;
+        copy->maximum_number = validation->maximum_number;
     }
 
-    if (option & LXW_SHOW_SCREEN_GRIDLINES) {
-        self->screen_gridlines = 1;
+    /* Copy the input/error titles and messages. */
+    if (validation->input_title) {
+        copy->input_title = lxw_strdup_formula(validation->input_title);
+        GOTO_LABEL_ON_MEM_ERROR(copy->input_title, mem_error);
     }
 
-    if (option & LXW_SHOW_PRINT_GRIDLINES) {
-        self->print_gridlines = 1;
-        self->print_options_changed = 1;
+    if (validation->input_message) {
+        copy->input_message = lxw_strdup_formula(validation->input_message);
+        GOTO_LABEL_ON_MEM_ERROR(copy->input_message, mem_error);
     }
-}
 
-/*
- * Center the page horizontally.
- */
-void
-worksheet_center_horizontally(lxw_worksheet *self)
-{
-    self->print_options_changed = 1;
-    self->hcenter = 1;
-}
+    if (validation->error_title) {
+        copy->error_title = lxw_strdup_formula(validation->error_title);
+        GOTO_LABEL_ON_MEM_ERROR(copy->error_title, mem_error);
+    }
 
-/*
- * Center the page horizontally.
- */
-void
-worksheet_center_vertically(lxw_worksheet *self)
-{
-    self->print_options_changed = 1;
-    self->vcenter = 1;
-}
+    if (validation->error_message) {
+        copy->error_message = lxw_strdup_formula(validation->error_message);
+        GOTO_LABEL_ON_MEM_ERROR(copy->error_message, mem_error);
+    }
 
-/*
- * Set the option to print the row and column headers on the printed page.
- */
-void
-worksheet_print_row_col_headers(lxw_worksheet *self)
-{
-    self->print_headers = 1;
-    self->print_options_changed = 1;
-}
+    /* Copy the formula strings. */
+    if (is_formula) {
+        if (is_between) {
+            copy->value_formula =
+                lxw_strdup_formula(validation->minimum_formula);
+            GOTO_LABEL_ON_MEM_ERROR(copy->value_formula, mem_error);
+            copy->maximum_formula =
+                lxw_strdup_formula(validation->maximum_formula);
+            GOTO_LABEL_ON_MEM_ERROR(copy->maximum_formula, mem_error);
+        }
+        else {
+            copy->value_formula =
+                lxw_strdup_formula(validation->value_formula);
+            GOTO_LABEL_ON_MEM_ERROR(copy->value_formula, mem_error);
+        }
+    }
 
-/*
- * Set the rows to repeat at the top of each printed page.
- */
-lxw_error
-worksheet_repeat_rows(lxw_worksheet *self, lxw_row_t first_row,
-                      lxw_row_t last_row)
-{
-    lxw_row_t tmp_row;
-    lxw_error err;
+    /* Copy the validation list as a csv string, or store it once in the
+     * workbook shared lists. */
+    if (validation->validate == LXW_VALIDATION_TYPE_LIST) {
+        if (self->validation_lists) {
+            copy->shared_list =
+                _get_shared_validation_list(self->validation_lists,
+                                            validation->value_list);
+            GOTO_LABEL_ON_MEM_ERROR(copy->shared_list, mem_error);
+        }
+        else {
+            copy->value_formula =
+                _validation_list_to_csv(validation->value_list);
+            GOTO_LABEL_ON_MEM_ERROR(copy->value_formula, mem_error);
+        }
+    }
 
-    if (first_row > last_row) {
-        tmp_row = last_row;
-        last_row = first_row;
-        first_row = tmp_row;
+    if (validation->validate == LXW_VALIDATION_TYPE_DATE
+        || validation->validate == LXW_VALIDATION_TYPE_TIME) {
+        if (is_between) {
+            copy->value_number =
+                lxw_datetime_to_excel_date_with_epoch
+                (&validation->minimum_datetime, self->use_1904_epoch);
+            copy->maximum_number =
+                lxw_datetime_to_excel_date_with_epoch
+                (&validation->maximum_datetime, self->use_1904_epoch);
+        }
+        else {
+            copy->value_number =
+                lxw_datetime_to_excel_date_with_epoch
+                (&validation->value_datetime, self->use_1904_epoch);
+        }
     }
 
-    err = _check_dimensions(self, last_row, 0, LXW_IGNORE, LXW_IGNORE);
-    if (err)
-        return err;
+    /* These options are on by default so we can't take plain booleans. */
+    copy->ignore_blank = validation->ignore_blank ^ 1;
+    copy->show_input = validation->show_input ^ 1;
+    copy->show_error = validation->show_error ^ 1;
 
-    self->repeat_rows.in_use = LXW_TRUE;
-    self->repeat_rows.first_row = first_row;
-    self->repeat_rows.last_row = last_row;
+    STAILQ_INSERT_TAIL(self->data_validations, copy, list_pointers);
+
+    self->num_validations++;
 
     return LXW_NO_ERROR;
+
+mem_error:
+    _free_data_validation(copy);
+    return LXW_ERROR_MEMORY_MALLOC_FAILED;
 }
 
 /*
- * Set the columns to repeat at the left hand side of each printed page.
+ * Add a data validation to a worksheet, for a cell.
  */
-lxw_error
-worksheet_repeat_columns(lxw_worksheet *self, lxw_col_t first_col,
-                         lxw_col_t last_col)
-{
-    lxw_col_t tmp_col;
-    lxw_error err;
-
-    if (first_col > last_col) {
-        tmp_col = last_col;
-        last_col = first_col;
-        first_col = tmp_col;
-    }
-
-    err = _check_dimensions(self, last_col, 0, LXW_IGNORE, LXW_IGNORE);
-    if (err)
-        return err;
-
-    self->repeat_cols.in_use = LXW_TRUE;
-    self->repeat_cols.first_col = first_col;
-    self->repeat_cols.last_col = last_col;
-
-    return LXW_NO_ERROR;
+lxw_error
+worksheet_data_validation_cell(lxw_worksheet *self, lxw_row_t row,
+                               lxw_col_t col, lxw_data_validation *validation)
+{
+    return worksheet_data_validation_range(self, row, col,
+                                           row, col, validation);
 }
 
 /*
- * Set the print area in the current worksheet.
+ * Add a conditional format to a worksheet, for a range.
  */
 lxw_error
-worksheet_print_area(lxw_worksheet *self, lxw_row_t first_row,
-                     lxw_col_t first_col, lxw_row_t last_row,
-                     lxw_col_t last_col)
+worksheet_conditional_format_range(lxw_worksheet *self, lxw_row_t first_row,
+                                   lxw_col_t first_col,
+                                   lxw_row_t last_row,
+                                   lxw_col_t last_col,
+                                   lxw_conditional_format *user_options)
 {
+    lxw_cond_format_obj *cond_format;
     lxw_row_t tmp_row;
     lxw_col_t tmp_col;
-    lxw_error err;
+    lxw_error err = LXW_NO_ERROR;
+    char *type_strings[] = {
+        "none",
+        "cellIs",
+        "containsText",
+        "timePeriod",
+        "aboveAverage",
+        "duplicateValues",
+        "uniqueValues",
+        "top10",
+        "top10",
+        "containsBlanks",
+        "notContainsBlanks",
+        "containsErrors",
+        "notContainsErrors",
+        "expression",
+        "colorScale",
+        "colorScale",
+        "dataBar",
+        "iconSet",
+    };
 
+    /* Swap last row/col with first row/col as necessary */
     if (first_row > last_row) {
         tmp_row = last_row;
         last_row = first_row;
         first_row = tmp_row;
     }
-
     if (first_col > last_col) {
         tmp_col = last_col;
         last_col = first_col;
         first_col = tmp_col;
     }
 
-    err = _check_dimensions(self, last_row, last_col, LXW_IGNORE, LXW_IGNORE);
+    /* Check that dimensions are valid but don't store them. */
+    err = _check_dimensions(self, last_row, last_col, LXW_TRUE, LXW_TRUE);
     if (err)
         return err;
 
-    /* Ignore max area since it is the same as no print area in Excel. */
-    if (first_row == 0 && first_col == 0 && last_row == LXW_ROW_MAX - 1
-        && last_col == LXW_COL_MAX - 1) {
-        return LXW_NO_ERROR;
+    if (_check_rollover_limit(self, last_row))
+        return LXW_ERROR_WORKSHEET_INDEX_OUT_OF_RANGE;
+
+    /* Check the validation type is in correct enum range. */
+    if (user_options->type <= LXW_CONDITIONAL_TYPE_NONE ||
+        user_options->type >= LXW_CONDITIONAL_TYPE_LAST) {
+
+        LXW_WARN_FORMAT1("worksheet_conditional_format_cell()/_range(): "
+                         "invalid type value (%d).", user_options->type);
+
+        return LXW_ERROR_PARAMETER_VALIDATION;
     }
 
-    self->print_area.in_use = LXW_TRUE;
-    self->print_area.first_row = first_row;
-    self->print_area.last_row = last_row;
-    self->print_area.first_col = first_col;
-    self->print_area.last_col = last_col;
+    /* Create a copy of the parameters from the user data validation. */
+    cond_format = calloc(1, sizeof(lxw_cond_format_obj));
+    GOTO_LABEL_ON_MEM_ERROR(cond_format, error);
 
-    return LXW_NO_ERROR;
-}
+    /* Create the data validation range. */
+    if (first_row == last_row && first_col == last_col)
+        lxw_rowcol_to_cell(cond_format->sqref, first_row, first_col);
+    else
+        lxw_rowcol_to_range(cond_format->sqref, first_row, first_col,
+                            last_row, last_col);
 
-/* Store the vertical and horizontal number of pages that will define the
- * maximum area printed.
- */
-void
-worksheet_fit_to_pages(lxw_worksheet *self, uint16_t width, uint16_t height)
-{
-    self->fit_page = 1;
-    self->fit_width = width;
-    self->fit_height = height;
-    self->page_setup_changed = 1;
-}
+    /* Store the first cell string for text and date rules. */
+    lxw_rowcol_to_cell(cond_format->first_cell, first_row, first_col);
 
-/*
- * Set the start page number.
- */
-void
-worksheet_set_start_page(lxw_worksheet *self, uint16_t start_page)
-{
-    self->page_start = start_page;
-}
+    /* Store the range for baking static rules into the cell formats. */
+    cond_format->first_row = first_row;
+    cond_format->first_col = first_col;
+    cond_format->last_row = last_row;
+    cond_format->last_col = last_col;
+    cond_format->is_multi_range = user_options->multi_range != NULL;
 
-/*
- * Set the scale factor for the printed page.
- */
-void
-worksheet_set_print_scale(lxw_worksheet *self, uint16_t scale)
-{
-    /* Confine the scale to Excel"s range */
-    if (scale < 10 || scale > 400)
-        return;
+    /* Overwrite the sqref range with a user supplied set of ranges. */
+    if (user_options->multi_range) {
 
-    /* Turn off "fit to page" option. */
-    self->fit_page = LXW_FALSE;
+        if (strlen(user_options->multi_range) >= LXW_MAX_ATTRIBUTE_LENGTH) {
+            LXW_WARN_FORMAT1("worksheet_conditional_format_cell()/_range(): "
+                             "multi_range >= limit = %d.",
+                             LXW_MAX_ATTRIBUTE_LENGTH);
+            err = LXW_ERROR_PARAMETER_VALIDATION;
+            goto error;
+        }
 
-    self->print_scale = scale;
-    self->page_setup_changed = LXW_TRUE;
-}
+        LXW_ATTRIBUTE_COPY(cond_format->sqref, user_options->multi_range);
+    }
 
-/*
- * Set the print in black and white option.
- */
-void
-worksheet_print_black_and_white(lxw_worksheet *self)
-{
-    self->black_white = LXW_TRUE;
-    self->page_setup_changed = LXW_TRUE;
-}
+    /* Get the conditional format dxf format index. */
+    if (user_options->format)
+        cond_format->dxf_index =
+            lxw_format_get_dxf_index(user_options->format);
+    else
+        cond_format->dxf_index = LXW_PROPERTY_UNSET;
 
-/*
- * Store the horizontal page breaks on a worksheet.
- */
-lxw_error
-worksheet_set_h_pagebreaks(lxw_worksheet *self, lxw_row_t hbreaks[])
-{
-    uint16_t count = 0;
+    cond_format->format = user_options->format;
 
-    if (hbreaks == NULL)
-        return LXW_ERROR_NULL_PARAMETER_IGNORED;
+    /* Set some common option for all validation types. */
+    cond_format->type = user_options->type;
+    cond_format->criteria = user_options->criteria;
+    cond_format->stop_if_true = user_options->stop_if_true;
+    cond_format->type_string = lxw_strdup(type_strings[cond_format->type]);
 
-    while (hbreaks[count])
-        count++;
+    /* Check that the criteria matches the conditional type. */
+    err = _validate_conditional_criteria(cond_format);
+    if (err)
+        goto error;
 
-    /* The Excel 2007 specification says that the maximum number of page
-     * breaks is 1026. However, in practice it is actually 1023. */
-    if (count > LXW_BREAKS_MAX)
-        count = LXW_BREAKS_MAX;
+    /* Validate the user input for various types of rules. */
+    if (user_options->type == LXW_CONDITIONAL_TYPE_CELL
+        || cond_format->type == LXW_CONDITIONAL_TYPE_DUPLICATE
+        || cond_format->type == LXW_CONDITIONAL_TYPE_UNIQUE) {
 
-    self->hbreaks = calloc(count, sizeof(lxw_row_t));
-    RETURN_ON_MEM_ERROR(self->hbreaks, LXW_ERROR_MEMORY_MALLOC_FAILED);
-    memcpy(self->hbreaks, hbreaks, count * sizeof(lxw_row_t));
-    self->hbreaks_count = count;
+        err = _validate_conditional_cell(cond_format, user_options);
+        if (err)
+            goto error;
+    }
+    else if (user_options->type == LXW_CONDITIONAL_TYPE_TEXT) {
 
-    return LXW_NO_ERROR;
-}
+        err = _validate_conditional_text(cond_format, user_options);
+        if (err)
+            goto error;
+    }
+    else if (user_options->type == LXW_CONDITIONAL_TYPE_TIME_PERIOD) {
 
-/*
- * Store the vertical page breaks on a worksheet.
- */
-lxw_error
-worksheet_set_v_pagebreaks(lxw_worksheet *self, lxw_col_t vbreaks[])
-{
-    uint16_t count = 0;
+        err = _validate_conditional_time_period(user_options);
+        if (err)
+            goto error;
+    }
+    else if (user_options->type == LXW_CONDITIONAL_TYPE_AVERAGE) {
 
-    if (vbreaks == NULL)
-        return LXW_ERROR_NULL_PARAMETER_IGNORED;
+        err = _validate_conditional_average(user_options);
+        if (err)
+            goto error;
+    }
+    else if (cond_format->type == LXW_CONDITIONAL_TYPE_TOP
+             || cond_format->type == LXW_CONDITIONAL_TYPE_BOTTOM) {
 
-    while (vbreaks[count])
-        count++;
+        err = _validate_conditional_top(cond_format, user_options);
+        if (err)
+            goto error;
+    }
+    else if (user_options->type == LXW_CONDITIONAL_TYPE_FORMULA) {
 
-    /* The Excel 2007 specification says that the maximum number of page
-     * breaks is 1026. However, in practice it is actually 1023. */
-    if (count > LXW_BREAKS_MAX)
-        count = LXW_BREAKS_MAX;
+        err = _validate_conditional_formula(cond_format, user_options);
+        if (err)
+            goto error;
+    }
+    else if (cond_format->type == LXW_CONDITIONAL_2_COLOR_SCALE
+             || cond_format->type == LXW_CONDITIONAL_3_COLOR_SCALE) {
 
-    self->vbreaks = calloc(count, sizeof(lxw_col_t));
-    RETURN_ON_MEM_ERROR(self->vbreaks, LXW_ERROR_MEMORY_MALLOC_FAILED);
-    memcpy(self->vbreaks, vbreaks, count * sizeof(lxw_col_t));
-    self->vbreaks_count = count;
+        err = _validate_conditional_scale(cond_format, user_options);
+        if (err)
+            goto error;
+    }
+    else if (cond_format->type == LXW_CONDITIONAL_DATA_BAR) {
 
-    return LXW_NO_ERROR;
-}
+        err = _validate_conditional_data_bar(self, cond_format, user_options);
+        if (err)
+            goto error;
+    }
+    else if (cond_format->type == LXW_CONDITIONAL_TYPE_ICON_SETS) {
 
-/*
- * Set the worksheet zoom factor.
- */
-void
-worksheet_set_zoom(lxw_worksheet *self, uint16_t scale)
-{
-    /* Confine the scale to Excel"s range */
-    if (scale < 10 || scale > 400) {
-        LXW_WARN("worksheet_set_zoom(): "
-                 "Zoom factor scale outside range: 10 <= zoom <= 400.");
-        return;
+        err = _validate_conditional_icons(user_options);
+        if (err)
+            goto error;
+
+        cond_format->icon_style = user_options->icon_style;
+        cond_format->reverse_icons = user_options->reverse_icons;
+        cond_format->icons_only = user_options->icons_only;
     }
 
-    self->zoom = scale;
+    /* Set the priority based on the order of adding. */
+    cond_format->dxf_priority = ++self->dxf_priority;
+
+    /* Store the conditional format object. */
+    err = _store_conditional_format_object(self, cond_format);
+
+    if (err)
+        goto error;
+    else
+        return LXW_NO_ERROR;
+
+error:
+    _free_cond_format(cond_format);
+    return err;
 }
 
 /*
- * Hide cell zero values.
+ * Add a conditional format to a worksheet, for a cell.
  */
-void
-worksheet_hide_zero(lxw_worksheet *self)
+lxw_error
+worksheet_conditional_format_cell(lxw_worksheet *self,
+                                  lxw_row_t row,
+                                  lxw_col_t col,
+                                  lxw_conditional_format *options)
 {
-    self->show_zeros = LXW_FALSE;
+    return worksheet_conditional_format_range(self, row, col,
+                                              row, col, options);
 }
 
 /*
- * Display the worksheet right to left for some eastern versions of Excel.
+ * Bake the static conditional formats into the cell formats when the
+ * workbook is closed.
  */
-void
-worksheet_right_to_left(lxw_worksheet *self)
+lxw_error
+worksheet_bake_conditional_formats(lxw_worksheet *self)
 {
-    self->right_to_left = LXW_TRUE;
+    if (self->optimize) {
+        LXW_WARN("worksheet_bake_conditional_formats(): "
+                 "function isn't supported in 'constant_memory' mode.");
+        return LXW_ERROR_FEATURE_NOT_SUPPORTED;
+    }
+
+    self->bake_cond_formats = LXW_TRUE;
+
+    return LXW_NO_ERROR;
 }
 
 /*
- * Set the color of the worksheet tab.
+ * Insert a button object into the worksheet.
  */
-void
-worksheet_set_tab_color(lxw_worksheet *self, lxw_color_t color)
+lxw_error
+worksheet_insert_button(lxw_worksheet *self, lxw_row_t row_num,
+                        lxw_col_t col_num, lxw_button_options *options)
 {
-    self->tab_color = color;
+    lxw_error err;
+    lxw_vml_obj *button;
+
+    err = _check_dimensions(self, row_num, col_num, LXW_TRUE, LXW_TRUE);
+    if (err)
+        return err;
+
+    if (_check_rollover_limit(self, row_num))
+        return LXW_ERROR_WORKSHEET_INDEX_OUT_OF_RANGE;
+
+    button = calloc(1, sizeof(lxw_vml_obj));
+    GOTO_LABEL_ON_MEM_ERROR(button, mem_error);
+
+    button->row = row_num;
+    button->col = col_num;
+
+    /* Set user and default parameters for the button. */
+    err = _get_button_params(button, 1 + self->num_buttons, options);
+    if (err)
+        goto mem_error;
+
+    /* Calculate the worksheet position of the button. */
+    _worksheet_position_vml_object(self, button);
+
+    self->has_vml = LXW_TRUE;
+    self->has_buttons = LXW_TRUE;
+    self->num_buttons++;
+
+    STAILQ_INSERT_TAIL(self->button_objs, button, list_pointers);
+
+    return LXW_NO_ERROR;
+
+mem_error:
+    if (button)
+        _free_vml_object(button);
+
+    return LXW_ERROR_MEMORY_MALLOC_FAILED;
 }
 
 /*
- * Set the worksheet protection flags to prevent modification of worksheet
- * objects.
+ * Set the VBA name for the worksheet.
  */
-void
-worksheet_protect(lxw_worksheet *self, const char *password,
-                  lxw_protection *options)
+lxw_error
+worksheet_set_vba_name(lxw_worksheet *self, const char *name)
 {
-    struct lxw_protection_obj *protect = &self->protection;
-
-    /* Copy any user parameters to the internal structure. */
-    if (options) {
-        protect->no_select_locked_cells = options->no_select_locked_cells;
-        protect->no_select_unlocked_cells = options->no_select_unlocked_cells;
-        protect->format_cells = options->format_cells;
-        protect->format_columns = options->format_columns;
-        protect->format_rows = options->format_rows;
-        protect->insert_columns = options->insert_columns;
-        protect->insert_rows = options->insert_rows;
-        protect->insert_hyperlinks = options->insert_hyperlinks;
-        protect->delete_columns = options->delete_columns;
-        protect->delete_rows = options->delete_rows;
-        protect->sort = options->sort;
-        protect->autofilter = options->autofilter;
-        protect->pivot_tables = options->pivot_tables;
-        protect->scenarios = options->scenarios;
-        protect->objects = options->objects;
+    if (!name) {
+        LXW_WARN("worksheet_set_vba_name(): " "name must be specified.");
+        return LXW_ERROR_NULL_PARAMETER_IGNORED;
     }
 
-    if (password) {
-        uint16_t hash = lxw_hash_password(password);
-        lxw_snprintf(protect->hash, 5, "%X", hash);
-    }
+    self->vba_codename = lxw_strdup(name);
 
-    protect->no_sheet = LXW_FALSE;
-    protect->no_content = LXW_TRUE;
-    protect->is_configured = LXW_TRUE;
+    return LXW_NO_ERROR;
 }
 
 /*
- * Set the worksheet properties for outlines and grouping.
+ * Set the default author of the cell comments.
  */
 void
-worksheet_outline_settings(lxw_worksheet *self,
-                           uint8_t visible,
-                           uint8_t symbols_below,
-                           uint8_t symbols_right, uint8_t auto_style)
+worksheet_set_comments_author(lxw_worksheet *self, const char *author)
 {
-    self->outline_on = visible;
-    self->outline_below = symbols_below;
-    self->outline_right = symbols_right;
-    self->outline_style = auto_style;
-
-    self->outline_changed = LXW_TRUE;
+    self->comment_author = lxw_strdup(author);
 }
 
 /*
- * Set the default row properties
+ * Make any comments in the worksheet visible, unless explicitly hidden.
  */
 void
-worksheet_set_default_row(lxw_worksheet *self, double height,
-                          uint8_t hide_unused_rows)
+worksheet_show_comments(lxw_worksheet *self)
 {
-    if (height < 0)
-        height = self->default_row_height;
-
-    if (height != self->default_row_height) {
-        self->default_row_height = height;
-        self->row_size_changed = LXW_TRUE;
-    }
-
-    if (hide_unused_rows)
-        self->default_row_zeroed = LXW_TRUE;
-
-    self->default_row_set = LXW_TRUE;
+    self->comment_display_default = LXW_COMMENT_DISPLAY_VISIBLE;
 }
 
 /*
- * Insert an image with options into the worksheet.
+ * Ignore various Excel errors/warnings in a worksheet for user defined ranges.
  */
 lxw_error
-worksheet_insert_image_opt(lxw_worksheet *self,
-                           lxw_row_t row_num, lxw_col_t col_num,
-                           const char *filename,
-                           lxw_image_options *user_options)
+worksheet_ignore_errors(lxw_worksheet *self, uint8_t type, const char *range)
 {
-    FILE *image_stream;
-    const char *description;
-    lxw_object_properties *object_props;
-
-    if (!filename) {
-        LXW_WARN("worksheet_insert_image()/_opt(): "
-                 "filename must be specified.");
+    if (!range) {
+        LXW_WARN("worksheet_ignore_errors(): " "'range' must be specified.");
         return LXW_ERROR_NULL_PARAMETER_IGNORED;
     }
 
-    /* Check that the image file exists and can be opened. */
-    image_stream = lxw_fopen(filename, "rb");
-    if (!image_stream) {
-        LXW_WARN_FORMAT1("worksheet_insert_image()/_opt(): "
-                         "file doesn't exist or can't be opened: %s.",
-                         filename);
-        return LXW_ERROR_PARAMETER_VALIDATION;
+    if (type <= 0 || type >= LXW_IGNORE_LAST_OPTION) {
+        LXW_WARN("worksheet_ignore_errors(): " "unknown option in 'type'.");
+        return LXW_ERROR_NULL_PARAMETER_IGNORED;
     }
 
-    /* Use the filename as the default description, like Excel. */
-    description = lxw_basename(filename);
-    if (!description) {
-        LXW_WARN_FORMAT1("worksheet_insert_image()/_opt(): "
-                         "couldn't get basename for file: %s.", filename);
-        fclose(image_stream);
-        return LXW_ERROR_PARAMETER_VALIDATION;
+    /* Set the ranges to be ignored. */
+    if (type == LXW_IGNORE_NUMBER_STORED_AS_TEXT) {
+        free(self->ignore_number_stored_as_text);
+        self->ignore_number_stored_as_text = lxw_strdup(range);
     }
-
-    /* Create a new object to hold the image properties. */
-    object_props = calloc(1, sizeof(lxw_object_properties));
-    if (!object_props) {
-        fclose(image_stream);
-        return LXW_ERROR_MEMORY_MALLOC_FAILED;
+    else if (type == LXW_IGNORE_EVAL_ERROR) {
+        free(self->ignore_eval_error);
+        self->ignore_eval_error = lxw_strdup(range);
     }
-
-    if (user_options) {
-        object_props->x_offset = user_options->x_offset;
-        object_props->y_offset = user_options->y_offset;
-        object_props->x_scale = user_options->x_scale;
-        object_props->y_scale = user_options->y_scale;
-        object_props->url = lxw_strdup(user_options->url);
-        object_props->tip = lxw_strdup(user_options->tip);
-        object_props->object_position = user_options->object_position;
-        object_props->decorative = user_options->decorative;
-
-        if (user_options->description)
-            description = user_options->description;
+    else if (type == LXW_IGNORE_FORMULA_DIFFERS) {
+        free(self->ignore_formula_differs);
+        self->ignore_formula_differs = lxw_strdup(range);
     }
-
-    /* Copy other options or set defaults. */
-    object_props->filename = lxw_strdup(filename);
-    object_props->description = lxw_strdup(description);
-    object_props->stream = image_stream;
-    object_props->row = row_num;
-    object_props->col = col_num;
-
-    if (object_props->x_scale == 0.0)
-        object_props->x_scale = 1;
-
-    if (object_props->y_scale == 0.0)
-        object_props->y_scale = 1;
-
-    if (_get_image_properties(object_props) == LXW_NO_ERROR) {
-        STAILQ_INSERT_TAIL(self->image_props, object_props, list_pointers);
-        fclose(image_stream);
-        return LXW_NO_ERROR;
+    else if (type == LXW_IGNORE_FORMULA_RANGE) {
+        free(self->ignore_formula_range);
+        self->ignore_formula_range = lxw_strdup(range);
     }
-    else {
-        _free_object_properties(object_props);
-        fclose(image_stream);
-        return LXW_ERROR_IMAGE_DIMENSIONS;
+    else if (type == LXW_IGNORE_FORMULA_UNLOCKED) {
+        free(self->ignore_formula_unlocked);
+        self->ignore_formula_unlocked = lxw_strdup(range);
     }
-}
+    else if (type == LXW_IGNORE_EMPTY_CELL_REFERENCE) {
+        free(self->ignore_empty_cell_reference);
+        self->ignore_empty_cell_reference = lxw_strdup(range);
+    }
+    else if (type == LXW_IGNORE_LIST_DATA_VALIDATION) {
+        free(self->ignore_list_data_validation);
+        self->ignore_list_data_validation = lxw_strdup(range);
+    }
+    else if (type == LXW_IGNORE_CALCULATED_COLUMN) {
+        free(self->ignore_calculated_column);
+        self->ignore_calculated_column = lxw_strdup(range);
+    }
+    else if (type == LXW_IGNORE_TWO_DIGIT_TEXT_YEAR) {
+        free(self->ignore_two_digit_text_year);
+        self->ignore_two_digit_text_year = lxw_strdup(range);
+    }
+
+    self->has_ignore_errors = LXW_TRUE;
 
-/*
- * Insert an image into the worksheet.
- */
-lxw_error
-worksheet_insert_image(lxw_worksheet *self,
-                       lxw_row_t row_num, lxw_col_t col_num,
-                       const char *filename)
-{
-    return worksheet_insert_image_opt(self, row_num, col_num, filename, NULL);
+    return LXW_NO_ERROR;
 }
 
 /*
- * Insert an image buffer, with options, into the worksheet.
+ * Open a row range segment of the worksheet that can be written to
+ * independently, for example from another thread.
  */
-lxw_error
-worksheet_insert_image_buffer_opt(lxw_worksheet *self,
-                                  lxw_row_t row_num,
-                                  lxw_col_t col_num,
-                                  const unsigned char *image_buffer,
-                                  size_t image_size,
-                                  lxw_image_options *user_options)
+lxw_worksheet *
+worksheet_open_segment(lxw_worksheet *self, lxw_row_t first_row,
+                       lxw_row_t last_row)
 {
-    FILE *image_stream;
-    lxw_object_properties *object_props;
+    lxw_worksheet *segment;
+    lxw_worksheet *previous = NULL;
+    lxw_row *row;
+    lxw_format *format;
+    lxw_worksheet_init_data init_data = { 0 };
 
-    if (!image_size) {
-        LXW_WARN("worksheet_insert_image_buffer()/_opt(): "
-                 "size must be non-zero.");
-        return LXW_ERROR_NULL_PARAMETER_IGNORED;
+    if (self->is_segment) {
+        LXW_WARN("worksheet_open_segment(): "
+                 "segments can't be opened from another segment.");
+        return NULL;
     }
 
-    /* Write the image buffer to a file (preferably in memory) so we can read
-     * the dimensions like an ordinary file. */
-#ifdef USE_FMEMOPEN
-    image_stream = fmemopen((void *) image_buffer, image_size, "rb");
+    if (first_row > last_row || last_row >= LXW_ROW_MAX) {
+        LXW_WARN_FORMAT2("worksheet_open_segment(): "
+                         "invalid row range: %u to %u.", first_row, last_row);
+        return NULL;
+    }
 
-    if (!image_stream)
-        return LXW_ERROR_CREATING_TMPFILE;
-#else
-    image_stream = lxw_tmpfile(self->tmpdir);
+    /* Check for overlaps with the existing segments and find the insertion
+     * point to keep them in row order. */
+    STAILQ_FOREACH(segment, self->segments, list_pointers) {
+        if (segment->segment_first_row > last_row)
+            break;
 
-    if (!image_stream)
-        return LXW_ERROR_CREATING_TMPFILE;
+        if (segment->segment_last_row >= first_row) {
+            LXW_WARN_FORMAT2("worksheet_open_segment(): "
+                             "rows %u to %u overlap an existing segment.",
+                             first_row, last_row);
+            return NULL;
+        }
 
-    if (fwrite(image_buffer, 1, image_size, image_stream) != image_size) {
-        fclose(image_stream);
-        return LXW_ERROR_CREATING_TMPFILE;
+        previous = segment;
     }
 
-    rewind(image_stream);
-#endif
-
-    /* Create a new object to hold the image properties. */
-    object_props = calloc(1, sizeof(lxw_object_properties));
-    if (!object_props) {
-        fclose(image_stream);
-        return LXW_ERROR_MEMORY_MALLOC_FAILED;
+    if (first_row < self->pinned_rows) {
+        LXW_WARN_FORMAT1("worksheet_open_segment(): "
+                         "row %u is a pinned row.", first_row);
+        return NULL;
     }
 
-    /* Store the image data in the properties structure. */
-    object_props->image_buffer = calloc(1, image_size);
-    if (!object_props->image_buffer) {
-        _free_object_properties(object_props);
-        fclose(image_stream);
-        return LXW_ERROR_MEMORY_MALLOC_FAILED;
+    /* Check that the worksheet hasn't already written to the rows. */
+    if (self->optimize) {
+        if (self->dim_rowmin != LXW_ROW_MAX
+            && first_row <= self->optimize_row->row_num) {
+            LXW_WARN_FORMAT1("worksheet_open_segment(): "
+                             "row %u has already been written in "
+                             "'constant_memory' mode.", first_row);
+            return NULL;
+        }
     }
     else {
-        memcpy(object_props->image_buffer, image_buffer, image_size);
-        object_props->image_buffer_size = image_size;
-        object_props->is_image_buffer = LXW_TRUE;
+        _worksheet_use_cells(self);
+
+        RB_FOREACH(row, lxw_table_rows, self->table) {
+            if (row->row_num > last_row)
+                break;
+
+            if (row->row_num >= first_row) {
+                LXW_WARN_FORMAT1("worksheet_open_segment(): "
+                                 "row %u already contains data.",
+                                 row->row_num);
+                return NULL;
+            }
+        }
     }
 
-    if (user_options) {
-        object_props->x_offset = user_options->x_offset;
-        object_props->y_offset = user_options->y_offset;
-        object_props->x_scale = user_options->x_scale;
-        object_props->y_scale = user_options->y_scale;
-        object_props->url = lxw_strdup(user_options->url);
-        object_props->tip = lxw_strdup(user_options->tip);
-        object_props->object_position = user_options->object_position;
-        object_props->description = lxw_strdup(user_options->description);
-        object_props->decorative = user_options->decorative;
+    /* Assign the format indexes here, in the calling thread, so that the
+     * segments don't update the shared format table. The hyperlink format
+     * is skipped since it would add an unused cell style. */
+    if (self->formats) {
+        STAILQ_FOREACH(format, self->formats, list_pointers) {
+            if (!format->hyperlink)
+                lxw_format_get_xf_index(format);
+        }
     }
 
-    /* Copy other options or set defaults. */
-    object_props->filename = lxw_strdup("image_buffer");
-    object_props->stream = image_stream;
-    object_props->row = row_num;
-    object_props->col = col_num;
+    /* The segment is a constant_memory worksheet with its own temp file. */
+    init_data.optimize = LXW_TRUE;
+    init_data.binary_tmpfile = self->binary_tmpfile;
+    init_data.tmpdir = self->tmpdir;
+    init_data.default_url_format = self->default_url_format;
+    init_data.max_url_length = self->max_url_length;
+    init_data.use_1904_epoch = self->use_1904_epoch;
+    init_data.number_precision = self->number_precision;
+
+    segment = lxw_worksheet_new(&init_data);
+    RETURN_ON_MEM_ERROR(segment, NULL);
+
+    segment->is_segment = LXW_TRUE;
+    segment->segment_first_row = first_row;
+    segment->segment_last_row = last_row;
+    segment->optimize_row->row_num = first_row;
+
+    /* Copy the properties used when writing the row data. */
+    segment->default_row_height = self->default_row_height;
+    segment->default_row_set = self->default_row_set;
+    segment->excel_version = self->excel_version;
+    segment->trusted_input = self->trusted_input;
+
+    if (self->col_formats_max > segment->col_formats_max) {
+        free(segment->col_formats);
+        segment->col_formats = calloc(self->col_formats_max,
+                                      sizeof(lxw_format *));
+        segment->col_formats_max = self->col_formats_max;
+
+        if (!segment->col_formats) {
+            LXW_MEM_ERROR();
+            lxw_worksheet_free(segment);
+            return NULL;
+        }
+    }
 
-    if (object_props->x_scale == 0.0)
-        object_props->x_scale = 1;
+    memcpy(segment->col_formats, self->col_formats,
+           self->col_formats_max * sizeof(lxw_format *));
 
-    if (object_props->y_scale == 0.0)
-        object_props->y_scale = 1;
+    if (self->col_precision) {
+        segment->col_precision = calloc(LXW_COL_MAX,
+                                        sizeof(lxw_number_precision));
 
-    if (_get_image_properties(object_props) == LXW_NO_ERROR) {
-        STAILQ_INSERT_TAIL(self->image_props, object_props, list_pointers);
-        fclose(image_stream);
-        return LXW_NO_ERROR;
-    }
-    else {
-        _free_object_properties(object_props);
-        fclose(image_stream);
-        return LXW_ERROR_IMAGE_DIMENSIONS;
+        if (!segment->col_precision) {
+            LXW_MEM_ERROR();
+            lxw_worksheet_free(segment);
+            return NULL;
+        }
+
+        memcpy(segment->col_precision, self->col_precision,
+               LXW_COL_MAX * sizeof(lxw_number_precision));
     }
+
+    if (previous)
+        STAILQ_INSERT_AFTER(self->segments, previous, segment, list_pointers);
+    else
+        STAILQ_INSERT_HEAD(self->segments, segment, list_pointers);
+
+    return segment;
 }
 
 /*
- * Insert an image buffer into the worksheet.
+ * Flush the last row of a segment to its temp file.
  */
 lxw_error
-worksheet_insert_image_buffer(lxw_worksheet *self,
-                              lxw_row_t row_num,
-                              lxw_col_t col_num,
-                              const unsigned char *image_buffer,
-                              size_t image_size)
+worksheet_close_segment(lxw_worksheet *segment)
 {
-    return worksheet_insert_image_buffer_opt(self, row_num, col_num,
-                                             image_buffer, image_size, NULL);
+    if (!segment || !segment->is_segment) {
+        LXW_WARN("worksheet_close_segment(): "
+                 "worksheet isn't a segment.");
+        return LXW_ERROR_PARAMETER_VALIDATION;
+    }
+
+    if (!segment->optimize_tmpfile)
+        return LXW_NO_ERROR;
+
+    lxw_worksheet_write_single_row(segment);
+    fflush(segment->optimize_tmpfile);
+
+    return LXW_NO_ERROR;
 }
 
 /*
- * Embed an image with options into the worksheet.
+ * Flush any worksheet segments and add their dimensions and properties to
+ * the parent worksheet. Called before the worksheet is written.
  */
-lxw_error
-worksheet_embed_image_opt(lxw_worksheet *self,
-                          lxw_row_t row_num, lxw_col_t col_num,
-                          const char *filename,
-                          lxw_image_options *user_options)
+void
+lxw_worksheet_close_segments(lxw_worksheet *self)
 {
-    FILE *image_stream;
-    lxw_object_properties *object_props;
-    lxw_error err;
+    lxw_worksheet *segment;
 
-    if (!filename) {
-        LXW_WARN("worksheet_embed_image()/_opt(): "
-                 "filename must be specified.");
-        return LXW_ERROR_NULL_PARAMETER_IGNORED;
+    STAILQ_FOREACH(segment, self->segments, list_pointers) {
+        worksheet_close_segment(segment);
+
+        if (segment->dim_rowmin < self->dim_rowmin)
+            self->dim_rowmin = segment->dim_rowmin;
+        if (segment->dim_rowmin != LXW_ROW_MAX
+            && segment->dim_rowmax > self->dim_rowmax)
+            self->dim_rowmax = segment->dim_rowmax;
+        if (segment->dim_colmin < self->dim_colmin)
+            self->dim_colmin = segment->dim_colmin;
+        if (segment->dim_colmin != LXW_COL_MAX
+            && segment->dim_colmax > self->dim_colmax)
+            self->dim_colmax = segment->dim_colmax;
+
+        if (segment->outline_row_level > self->outline_row_level)
+            self->outline_row_level = segment->outline_row_level;
+
+        if (segment->has_dynamic_functions)
+            self->has_dynamic_functions = LXW_TRUE;
     }
+}
 
-    /* Check that the image file exists and can be opened. */
-    image_stream = lxw_fopen(filename, "rb");
-    if (!image_stream) {
-        LXW_WARN_FORMAT1("worksheet_embed_image()/_opt(): "
-                         "file doesn't exist or can't be opened: %s.",
-                         filename);
+/*
+ * Keep the first rows of a constant_memory worksheet in memory.
+ */
+lxw_error
+worksheet_pin_rows(lxw_worksheet *self, lxw_row_t num_rows)
+{
+    if (num_rows > LXW_ROW_MAX)
+        return LXW_ERROR_WORKSHEET_INDEX_OUT_OF_RANGE;
+
+    if (self->dim_rowmin != LXW_ROW_MAX) {
+        LXW_WARN("worksheet_pin_rows(): "
+                 "function must be called before any data is written.");
         return LXW_ERROR_PARAMETER_VALIDATION;
     }
 
-    /* Check and store the cell dimensions. */
-    err = _check_dimensions(self, row_num, col_num, LXW_FALSE, LXW_FALSE);
-    if (err) {
-        fclose(image_stream);
-        return err;
-    }
+    /* All rows are stored in memory when the optimization is off. */
+    if (!self->optimize)
+        return LXW_NO_ERROR;
 
-    /* Create a new object to hold the image properties. */
-    object_props = calloc(1, sizeof(lxw_object_properties));
-    if (!object_props) {
-        fclose(image_stream);
-        return LXW_ERROR_MEMORY_MALLOC_FAILED;
-    }
+    self->pinned_rows = num_rows;
 
-    /* We only copy/use a limited number of options for embedded images. */
-    if (user_options) {
-        if (user_options->cell_format)
-            object_props->format = user_options->cell_format;
+    return LXW_NO_ERROR;
+}
 
-        /* The url for embedded images is written as a cell url. */
-        if (user_options->url) {
-            if (!user_options->cell_format)
-                object_props->format = self->default_url_format;
+/*
+ * Skip the validation of the data written to a worksheet.
+ */
+void
+worksheet_set_trusted_input(lxw_worksheet *self, uint8_t trusted)
+{
+    self->trusted_input = !!trusted;
+}
 
-            self->storing_embedded_image = LXW_TRUE;
-            err = worksheet_write_url(self,
-                                      row_num,
-                                      col_num,
-                                      user_options->url,
-                                      object_props->format);
-            if (err) {
-                _free_object_properties(object_props);
-                fclose(image_stream);
-                return err;
-            }
+/*
+ * Continue a worksheet on new worksheets past a row limit.
+ */
+lxw_error
+worksheet_set_rollover(lxw_worksheet *self, lxw_rollover_options *options)
+{
+    lxw_row_t max_rows;
 
-            self->storing_embedded_image = LXW_FALSE;
+    if (!options)
+        return LXW_ERROR_NULL_PARAMETER_IGNORED;
+
+    max_rows = options->max_rows ? options->max_rows : LXW_ROW_MAX;
+
+    if (max_rows > LXW_ROW_MAX || options->header_rows >= max_rows) {
+        LXW_WARN("worksheet_set_rollover(): header_rows must be less than "
+                 "max_rows and max_rows must be less than or equal to "
+                 "LXW_ROW_MAX.");
+        return LXW_ERROR_PARAMETER_VALIDATION;
+    }
+
+    /* The header rows are kept in memory so that they can be copied. */
+    if (self->optimize && options->header_rows) {
+        if (self->dim_rowmin != LXW_ROW_MAX) {
+            LXW_WARN("worksheet_set_rollover(): function must be called "
+                     "before any data is written in 'constant_memory' "
+                     "mode.");
+            return LXW_ERROR_PARAMETER_VALIDATION;
         }
 
-        object_props->decorative = user_options->decorative;
-        if (user_options->description)
-            object_props->description = lxw_strdup(user_options->description);
+        self->pinned_rows = options->header_rows;
     }
 
-    /* Copy other options or set defaults. */
-    object_props->filename = lxw_strdup(filename);
-    object_props->stream = image_stream;
-    object_props->row = row_num;
-    object_props->col = col_num;
+    self->rollover_rows = max_rows;
+    self->rollover_header_rows = options->header_rows;
 
-    if (object_props->x_scale == 0.0)
-        object_props->x_scale = 1;
+    return LXW_NO_ERROR;
+}
 
-    if (object_props->y_scale == 0.0)
-        object_props->y_scale = 1;
+/*
+ * Get the first row that can still be written in constant_memory mode.
+ */
+lxw_row_t
+worksheet_get_resume_row(lxw_worksheet *self)
+{
+    if (!self->optimize)
+        return 0;
 
-    if (_get_image_properties(object_props) == LXW_NO_ERROR) {
-        STAILQ_INSERT_TAIL(self->embedded_image_props, object_props,
-                           list_pointers);
-        fclose(image_stream);
+    return self->optimize_row->row_num;
+}
 
-        return LXW_NO_ERROR;
+/*
+ * Turn on the running column statistics for a range of cells.
+ */
+lxw_error
+worksheet_track_column_stats(lxw_worksheet *self, lxw_row_t first_row,
+                             lxw_col_t first_col, lxw_row_t last_row,
+                             lxw_col_t last_col)
+{
+    lxw_row_t tmp_row;
+    lxw_col_t tmp_col;
+    uint16_t i;
+
+    /* Swap last row/col with first row/col as necessary */
+    if (first_row > last_row) {
+        tmp_row = last_row;
+        last_row = first_row;
+        first_row = tmp_row;
     }
-    else {
-        _free_object_properties(object_props);
-        fclose(image_stream);
-        return LXW_ERROR_IMAGE_DIMENSIONS;
+    if (first_col > last_col) {
+        tmp_col = last_col;
+        last_col = first_col;
+        first_col = tmp_col;
     }
-}
 
-/*
- * Embed an image into the worksheet.
- */
-lxw_error
-worksheet_embed_image(lxw_worksheet *self,
-                      lxw_row_t row_num, lxw_col_t col_num,
-                      const char *filename)
-{
-    return worksheet_embed_image_opt(self, row_num, col_num, filename, NULL);
+    /* Rows past the end of a worksheet are written to rollover sheets. */
+    if ((last_row >= LXW_ROW_MAX && !self->rollover_rows)
+        || last_col >= LXW_COL_MAX)
+        return LXW_ERROR_WORKSHEET_INDEX_OUT_OF_RANGE;
+
+    _free_column_stats(self);
+
+    self->column_stats = calloc(last_col - first_col + 1,
+                                sizeof(lxw_column_accumulator));
+    RETURN_ON_MEM_ERROR(self->column_stats, LXW_ERROR_MEMORY_MALLOC_FAILED);
+
+    self->stats_first_row = first_row;
+    self->stats_last_row = last_row;
+    self->stats_first_col = first_col;
+    self->stats_last_col = last_col;
+
+    /* Cells counted by an earlier call are no longer in the statistics. */
+    if (++self->stats_generation == 0)
+        self->stats_generation = 1;
+
+    for (i = 0; i < self->rollover_count; i++)
+        _share_rollover_column_stats(self, i);
+
+    return LXW_NO_ERROR;
 }
 
 /*
- * Embed an image buffer, with options, into the worksheet.
+ * Get the running statistics for a column.
  */
 lxw_error
-worksheet_embed_image_buffer_opt(lxw_worksheet *self,
-                                 lxw_row_t row_num,
-                                 lxw_col_t col_num,
-                                 const unsigned char *image_buffer,
-                                 size_t image_size,
-                                 lxw_image_options *user_options)
+worksheet_get_column_stats(lxw_worksheet *self, lxw_col_t col_num,
+                           lxw_column_stats *stats)
 {
-    FILE *image_stream;
-    lxw_object_properties *object_props;
-    lxw_error err;
+    lxw_column_accumulator *accumulator;
+    double max_hash;
 
-    if (!image_size) {
-        LXW_WARN("worksheet_embed_image_buffer()/_opt(): "
-                 "size must be non-zero.");
+    if (!stats)
         return LXW_ERROR_NULL_PARAMETER_IGNORED;
-    }
-
-    /* Write the image buffer to a file (preferably in memory) so we can read
-     * the dimensions like an ordinary file. For embedded images we really only
-     * need the image type. */
-#ifdef USE_FMEMOPEN
-    image_stream = fmemopen((void *) image_buffer, image_size, "rb");
-
-    if (!image_stream)
-        return LXW_ERROR_CREATING_TMPFILE;
-#else
-    image_stream = lxw_tmpfile(self->tmpdir);
 
-    if (!image_stream)
-        return LXW_ERROR_CREATING_TMPFILE;
+    memset(stats, 0, sizeof(lxw_column_stats));
 
-    if (fwrite(image_buffer, 1, image_size, image_stream) != image_size) {
-        fclose(image_stream);
-        return LXW_ERROR_CREATING_TMPFILE;
+    if (!self->column_stats) {
+        LXW_WARN("worksheet_get_column_stats(): "
+                 "worksheet_track_column_stats() must be called first.");
+        return LXW_ERROR_PARAMETER_VALIDATION;
     }
 
-    rewind(image_stream);
-#endif
+    if (col_num < self->stats_first_col || col_num > self->stats_last_col)
+        return LXW_ERROR_WORKSHEET_INDEX_OUT_OF_RANGE;
 
-    /* Check and store the cell dimensions. */
-    err = _check_dimensions(self, row_num, col_num, LXW_FALSE, LXW_FALSE);
-    if (err)
-        return err;
+    accumulator = &self->column_stats[col_num - self->stats_first_col];
 
-    /* Create a new object to hold the image properties. */
-    object_props = calloc(1, sizeof(lxw_object_properties));
-    if (!object_props) {
-        fclose(image_stream);
-        return LXW_ERROR_MEMORY_MALLOC_FAILED;
-    }
+    stats->number_count = accumulator->number_count;
+    stats->string_count = accumulator->string_count;
+    stats->count = accumulator->number_count + accumulator->string_count;
+    stats->sum = accumulator->sum;
+    stats->min = accumulator->min;
+    stats->max = accumulator->max;
 
-    /* Store the image data in the properties structure. */
-    object_props->image_buffer = calloc(1, image_size);
-    if (!object_props->image_buffer) {
-        _free_object_properties(object_props);
-        fclose(image_stream);
-        return LXW_ERROR_MEMORY_MALLOC_FAILED;
+    /* Below the sketch size every distinct string has its own hash. Above
+     * it the count is estimated from the largest of the smallest hashes. */
+    if (accumulator->num_hashes < LXW_COLUMN_STATS_HASHES) {
+        stats->distinct_strings = accumulator->num_hashes;
     }
     else {
-        memcpy(object_props->image_buffer, image_buffer, image_size);
-        object_props->image_buffer_size = image_size;
-        object_props->is_image_buffer = LXW_TRUE;
+        max_hash = (double) accumulator->hashes[LXW_COLUMN_STATS_HASHES - 1]
+            / 18446744073709551616.0;
+        stats->distinct_strings =
+            (uint32_t) ((LXW_COLUMN_STATS_HASHES - 1) / max_hash + 0.5);
     }
 
-    /* We only copy/use a limited number of options for embedded images. */
-    if (user_options) {
-        if (user_options->cell_format)
-            object_props->format = user_options->cell_format;
-
-        /* The url for embedded images is written as a cell url. */
-        if (user_options->url) {
-            if (!user_options->cell_format)
-                object_props->format = self->default_url_format;
+    if (stats->distinct_strings > stats->string_count)
+        stats->distinct_strings = stats->string_count;
 
-            self->storing_embedded_image = LXW_TRUE;
-            err = worksheet_write_url(self,
-                                      row_num,
-                                      col_num,
-                                      user_options->url,
-                                      object_props->format);
-            if (err) {
-                _free_object_properties(object_props);
-                fclose(image_stream);
-                return err;
-            }
+    return LXW_NO_ERROR;
+}
 
-            self->storing_embedded_image = LXW_FALSE;
-        }
+/*
+ * Replace the anonymous constant_memory temp file of a worksheet with a
+ * named file in the workbook checkpoint directory. Any existing file is
+ * opened without truncating it so that its rows can be resumed.
+ */
+lxw_error
+lxw_worksheet_set_checkpoint_file(lxw_worksheet *self, const char *filename)
+{
+    FILE *file;
 
-        object_props->decorative = user_options->decorative;
-        if (user_options->description)
-            object_props->description = lxw_strdup(user_options->description);
-    }
+    if (!self->optimize)
+        return LXW_NO_ERROR;
 
-    /* Copy other options or set defaults. */
-    object_props->filename = lxw_strdup("image_buffer");
-    object_props->stream = image_stream;
-    object_props->row = row_num;
-    object_props->col = col_num;
+    file = lxw_fopen(filename, "r+b");
+    if (!file)
+        file = lxw_fopen(filename, "w+b");
 
-    if (object_props->x_scale == 0.0)
-        object_props->x_scale = 1;
+    if (!file) {
+        LXW_WARN_FORMAT1("workbook_add_worksheet(): "
+                         "error creating checkpoint file '%s'.", filename);
+        return LXW_ERROR_CREATING_TMPFILE;
+    }
 
-    if (object_props->y_scale == 0.0)
-        object_props->y_scale = 1;
+    fclose(self->optimize_tmpfile);
+    free(self->optimize_buffer);
 
-    if (_get_image_properties(object_props) == LXW_NO_ERROR) {
-        STAILQ_INSERT_TAIL(self->embedded_image_props, object_props,
-                           list_pointers);
-        fclose(image_stream);
+    self->optimize_buffer = NULL;
+    self->optimize_buffer_size = 0;
+    self->optimize_tmpfile = file;
+    self->file = file;
 
-        return LXW_NO_ERROR;
-    }
-    else {
-        _free_object_properties(object_props);
-        fclose(image_stream);
-        return LXW_ERROR_IMAGE_DIMENSIONS;
-    }
+    return LXW_NO_ERROR;
 }
 
 /*
- * Insert an image buffer into the worksheet.
+ * Write a length prefixed string, or -1 for NULL, to a checkpoint file.
  */
-lxw_error
-worksheet_embed_image_buffer(lxw_worksheet *self,
-                             lxw_row_t row_num,
-                             lxw_col_t col_num,
-                             const unsigned char *image_buffer,
-                             size_t image_size)
+STATIC void
+_checkpoint_write_string(FILE *file, const char *string)
 {
-    return worksheet_embed_image_buffer_opt(self, row_num, col_num,
-                                            image_buffer, image_size, NULL);
+    size_t length;
+
+    if (!string) {
+        fprintf(file, " -1");
+        return;
+    }
+
+    length = strlen(string);
+    fprintf(file, " %lu:", (unsigned long) length);
+    (void) fwrite(string, 1, length, file);
 }
 
 /*
- * Set an image as a worksheet background.
+ * Read a length prefixed string from a checkpoint file. NULL strings are
+ * returned as NULL with no error.
  */
-lxw_error
-worksheet_set_background(lxw_worksheet *self, const char *filename)
+STATIC lxw_error
+_checkpoint_read_string(FILE *file, char **string)
 {
-    FILE *image_stream;
-    lxw_object_properties *object_props;
+    long length;
 
-    if (!filename) {
-        LXW_WARN("worksheet_set_background(): "
-                 "filename must be specified.");
-        return LXW_ERROR_NULL_PARAMETER_IGNORED;
-    }
+    *string = NULL;
 
-    /* Check that the image file exists and can be opened. */
-    image_stream = lxw_fopen(filename, "rb");
-    if (!image_stream) {
-        LXW_WARN_FORMAT1("worksheet_set_background(): "
-                         "file doesn't exist or can't be opened: %s.",
-                         filename);
-        return LXW_ERROR_PARAMETER_VALIDATION;
-    }
+    if (fscanf(file, " %ld", &length) != 1)
+        return LXW_ERROR_READING_TMPFILE;
 
-    /* Create a new object to hold the image properties. */
-    object_props = calloc(1, sizeof(lxw_object_properties));
-    if (!object_props) {
-        fclose(image_stream);
-        return LXW_ERROR_MEMORY_MALLOC_FAILED;
-    }
+    if (length < 0)
+        return LXW_NO_ERROR;
 
-    /* Copy other options or set defaults. */
-    object_props->filename = lxw_strdup(filename);
-    object_props->stream = image_stream;
-    object_props->is_background = LXW_TRUE;
+    if (fgetc(file) != ':')
+        return LXW_ERROR_READING_TMPFILE;
 
-    if (_get_image_properties(object_props) == LXW_NO_ERROR) {
-        _free_object_properties(self->background_image);
-        self->background_image = object_props;
-        self->has_background_image = LXW_TRUE;
-        fclose(image_stream);
-        return LXW_NO_ERROR;
-    }
-    else {
-        _free_object_properties(object_props);
-        fclose(image_stream);
-        return LXW_ERROR_IMAGE_DIMENSIONS;
+    *string = calloc(1, (size_t) length + 1);
+    RETURN_ON_MEM_ERROR(*string, LXW_ERROR_MEMORY_MALLOC_FAILED);
+
+    if (fread(*string, 1, (size_t) length, file) != (size_t) length) {
+        free(*string);
+        *string = NULL;
+        return LXW_ERROR_READING_TMPFILE;
     }
+
+    return LXW_NO_ERROR;
 }
 
 /*
- * Set an image buffer as a worksheet background.
+ * Write a 64 bit value to a checkpoint file as two 32 bit hex numbers.
  */
-lxw_error
-worksheet_set_background_buffer(lxw_worksheet *self,
-                                const unsigned char *image_buffer,
-                                size_t image_size)
+STATIC void
+_checkpoint_write_uint64(FILE *file, uint64_t value)
 {
-    FILE *image_stream;
-    lxw_object_properties *object_props;
-
-    if (!image_size) {
-        LXW_WARN("worksheet_set_background(): " "size must be non-zero.");
-        return LXW_ERROR_NULL_PARAMETER_IGNORED;
-    }
+    fprintf(file, " %lx %lx", (unsigned long) (value >> 32),
+            (unsigned long) (value & 0xFFFFFFFF));
+}
 
-    /* Write the image buffer to a file (preferably in memory) so we can read
-     * the dimensions like an ordinary file. */
-#ifdef USE_FMEMOPEN
-    image_stream = fmemopen((void *) image_buffer, image_size, "rb");
+/*
+ * Read a 64 bit value written by _checkpoint_write_uint64().
+ */
+STATIC lxw_error
+_checkpoint_read_uint64(FILE *file, uint64_t *value)
+{
+    unsigned long high;
+    unsigned long low;
 
-    if (!image_stream)
-        return LXW_ERROR_CREATING_TMPFILE;
-#else
-    image_stream = lxw_tmpfile(self->tmpdir);
+    if (fscanf(file, " %lx %lx", &high, &low) != 2)
+        return LXW_ERROR_READING_TMPFILE;
 
-    if (!image_stream)
-        return LXW_ERROR_CREATING_TMPFILE;
+    *value = (uint64_t) (high & 0xFFFFFFFF) << 32 | (low & 0xFFFFFFFF);
 
-    if (fwrite(image_buffer, 1, image_size, image_stream) != image_size) {
-        fclose(image_stream);
-        return LXW_ERROR_CREATING_TMPFILE;
-    }
+    return LXW_NO_ERROR;
+}
 
-    rewind(image_stream);
-#endif
+/*
+ * Write a double to a checkpoint file. The bits of the double are written so
+ * that it is restored exactly and independently of the locale.
+ */
+STATIC void
+_checkpoint_write_double(FILE *file, double number)
+{
+    uint64_t bits;
 
-    /* Create a new object to hold the image properties. */
-    object_props = calloc(1, sizeof(lxw_object_properties));
-    if (!object_props) {
-        fclose(image_stream);
-        return LXW_ERROR_MEMORY_MALLOC_FAILED;
-    }
+    memcpy(&bits, &number, sizeof(bits));
+    _checkpoint_write_uint64(file, bits);
+}
 
-    /* Store the image data in the properties structure. */
-    object_props->image_buffer = calloc(1, image_size);
-    if (!object_props->image_buffer) {
-        _free_object_properties(object_props);
-        fclose(image_stream);
-        return LXW_ERROR_MEMORY_MALLOC_FAILED;
-    }
-    else {
-        memcpy(object_props->image_buffer, image_buffer, image_size);
-        object_props->image_buffer_size = image_size;
-        object_props->is_image_buffer = LXW_TRUE;
-    }
+/*
+ * Read a double written by _checkpoint_write_double().
+ */
+STATIC lxw_error
+_checkpoint_read_double(FILE *file, double *number)
+{
+    uint64_t bits;
+    lxw_error err;
 
-    /* Copy other options or set defaults. */
-    object_props->filename = lxw_strdup("image_buffer");
-    object_props->stream = image_stream;
-    object_props->is_background = LXW_TRUE;
+    err = _checkpoint_read_uint64(file, &bits);
+    if (err)
+        return err;
 
-    if (_get_image_properties(object_props) == LXW_NO_ERROR) {
-        _free_object_properties(self->background_image);
-        self->background_image = object_props;
-        self->has_background_image = LXW_TRUE;
-        fclose(image_stream);
-        return LXW_NO_ERROR;
-    }
-    else {
-        _free_object_properties(object_props);
-        fclose(image_stream);
-        return LXW_ERROR_IMAGE_DIMENSIONS;
-    }
+    memcpy(number, &bits, sizeof(bits));
+
+    return LXW_NO_ERROR;
 }
 
 /*
- * Insert an chart into the worksheet.
+ * Write the column statistics of a worksheet to a checkpoint file.
  */
-lxw_error
-worksheet_insert_chart_opt(lxw_worksheet *self,
-                           lxw_row_t row_num, lxw_col_t col_num,
-                           lxw_chart *chart, lxw_chart_options *user_options)
+STATIC void
+_checkpoint_write_column_stats(lxw_worksheet *self, FILE *file)
 {
-    lxw_object_properties *object_props;
-    lxw_chart_series *series;
+    lxw_column_accumulator *accumulator;
+    lxw_col_t col;
+    uint16_t i;
 
-    if (!chart) {
-        LXW_WARN("worksheet_insert_chart()/_opt(): chart must be non-NULL.");
-        return LXW_ERROR_NULL_PARAMETER_IGNORED;
+    if (!self->column_stats || self->stats_shared) {
+        fprintf(file, "stats 0\n");
+        return;
     }
 
-    /* Check that the chart isn't being used more than once. */
-    if (chart->in_use) {
-        LXW_WARN("worksheet_insert_chart()/_opt(): the same chart object "
-                 "cannot be inserted in a worksheet more than once.");
+    fprintf(file, "stats 1 %u %u %u %u\n",
+            self->stats_first_row, self->stats_first_col,
+            self->stats_last_row, self->stats_last_col);
 
-        return LXW_ERROR_PARAMETER_VALIDATION;
-    }
+    for (col = 0; col <= self->stats_last_col - self->stats_first_col; col++) {
+        accumulator = &self->column_stats[col];
 
-    /* Check that the chart has a data series. */
-    if (STAILQ_EMPTY(chart->series_list)) {
-        LXW_WARN
-            ("worksheet_insert_chart()/_opt(): chart must have a series.");
+        fprintf(file, "col %u %u", accumulator->number_count,
+                accumulator->string_count);
+        _checkpoint_write_double(file, accumulator->sum);
+        _checkpoint_write_double(file, accumulator->min);
+        _checkpoint_write_double(file, accumulator->max);
 
-        return LXW_ERROR_PARAMETER_VALIDATION;
+        fprintf(file, " %u", accumulator->num_hashes);
+        for (i = 0; i < accumulator->num_hashes; i++)
+            _checkpoint_write_uint64(file, accumulator->hashes[i]);
+
+        fprintf(file, "\n");
     }
+}
 
-    /* Check that the chart has a 'values' series. */
-    STAILQ_FOREACH(series, chart->series_list, list_pointers) {
-        if (!series->values->formula && !series->values->sheetname) {
-            LXW_WARN("worksheet_insert_chart()/_opt(): chart must have a "
-                     "'values' series.");
+/*
+ * Restore the column statistics of a worksheet from a checkpoint file. This
+ * replaces any statistics set up by the application before the resume.
+ */
+STATIC lxw_error
+_checkpoint_read_column_stats(lxw_worksheet *self, FILE *file)
+{
+    lxw_column_accumulator *accumulator;
+    unsigned int has_stats;
+    unsigned int range[4];
+    unsigned int counts[3];
+    lxw_col_t col;
+    uint16_t i;
+    lxw_error err;
 
-            return LXW_ERROR_PARAMETER_VALIDATION;
-        }
-    }
+    if (fscanf(file, " stats %u", &has_stats) != 1)
+        return LXW_ERROR_READING_TMPFILE;
 
-    /* Create a new object to hold the chart image properties. */
-    object_props = calloc(1, sizeof(lxw_object_properties));
-    RETURN_ON_MEM_ERROR(object_props, LXW_ERROR_MEMORY_MALLOC_FAILED);
+    if (!has_stats)
+        return LXW_NO_ERROR;
 
-    if (user_options) {
-        object_props->x_offset = user_options->x_offset;
-        object_props->y_offset = user_options->y_offset;
-        object_props->x_scale = user_options->x_scale;
-        object_props->y_scale = user_options->y_scale;
-        object_props->object_position = user_options->object_position;
-        object_props->description = lxw_strdup(user_options->description);
-        object_props->decorative = user_options->decorative;
-    }
+    if (fscanf(file, " %u %u %u %u", &range[0], &range[1], &range[2],
+               &range[3]) != 4)
+        return LXW_ERROR_READING_TMPFILE;
 
-    /* Copy other options or set defaults. */
-    object_props->row = row_num;
-    object_props->col = col_num;
+    if (range[0] > range[2] || range[1] > range[3])
+        return LXW_ERROR_READING_TMPFILE;
 
-    object_props->width = 480;
-    object_props->height = 288;
+    err = worksheet_track_column_stats(self, range[0], (lxw_col_t) range[1],
+                                       range[2], (lxw_col_t) range[3]);
+    if (err)
+        return err;
 
-    if (object_props->x_scale == 0.0)
-        object_props->x_scale = 1;
+    for (col = 0; col <= self->stats_last_col - self->stats_first_col; col++) {
+        accumulator = &self->column_stats[col];
 
-    if (object_props->y_scale == 0.0)
-        object_props->y_scale = 1;
+        if (fscanf(file, " col %u %u", &counts[0], &counts[1]) != 2)
+            return LXW_ERROR_READING_TMPFILE;
 
-    /* Store chart references so they can be ordered in the workbook. */
-    object_props->chart = chart;
+        accumulator->number_count = counts[0];
+        accumulator->string_count = counts[1];
 
-    STAILQ_INSERT_TAIL(self->chart_data, object_props, list_pointers);
+        err = _checkpoint_read_double(file, &accumulator->sum);
+        if (!err)
+            err = _checkpoint_read_double(file, &accumulator->min);
+        if (!err)
+            err = _checkpoint_read_double(file, &accumulator->max);
+        if (err)
+            return err;
 
-    chart->in_use = LXW_TRUE;
+        if (fscanf(file, " %u", &counts[2]) != 1
+            || counts[2] > LXW_COLUMN_STATS_HASHES)
+            return LXW_ERROR_READING_TMPFILE;
 
-    return LXW_NO_ERROR;
-}
+        if (!counts[2])
+            continue;
 
-/*
- * Insert an image into the worksheet.
- */
-lxw_error
-worksheet_insert_chart(lxw_worksheet *self,
-                       lxw_row_t row_num, lxw_col_t col_num, lxw_chart *chart)
-{
-    return worksheet_insert_chart_opt(self, row_num, col_num, chart, NULL);
+        accumulator->hashes = calloc(LXW_COLUMN_STATS_HASHES,
+                                     sizeof(uint64_t));
+        RETURN_ON_MEM_ERROR(accumulator->hashes,
+                            LXW_ERROR_MEMORY_MALLOC_FAILED);
+
+        accumulator->num_hashes = (uint16_t) counts[2];
+
+        for (i = 0; i < accumulator->num_hashes; i++) {
+            err = _checkpoint_read_uint64(file, &accumulator->hashes[i]);
+            if (err)
+                return err;
+        }
+    }
+
+    return LXW_NO_ERROR;
 }
 
 /*
- * Add a data validation to a worksheet, for a range. Ironically this requires
- * a lot of validation of the user input.
+ * Flush the rows of a constant_memory worksheet to its checkpoint file. The
+ * current row is completed so that the checkpoint ends on a row boundary.
+ * This is done for all the worksheets before the checkpoint is written since
+ * it assigns the xf indexes of the formats in the flushed cells.
  */
 lxw_error
-worksheet_data_validation_range(lxw_worksheet *self, lxw_row_t first_row,
-                                lxw_col_t first_col,
-                                lxw_row_t last_row,
-                                lxw_col_t last_col,
-                                lxw_data_validation *validation)
+lxw_worksheet_flush_checkpoint(lxw_worksheet *self)
 {
-    lxw_data_val_obj *copy;
-    uint8_t is_between = LXW_FALSE;
-    uint8_t is_formula = LXW_FALSE;
-    uint8_t has_criteria = LXW_TRUE;
-    lxw_error err;
-    lxw_row_t tmp_row;
-    lxw_col_t tmp_col;
-    size_t length;
-
-    /* No action is required for validation type 'any' unless there are
-     * input messages to display.*/
-    if (validation->validate == LXW_VALIDATION_TYPE_ANY
-        && !(validation->input_title || validation->input_message)) {
+    lxw_row *row = self->optimize_row;
 
+    if (!self->optimize)
         return LXW_NO_ERROR;
-    }
 
-    /* Check for formula types. */
-    switch (validation->validate) {
-        case LXW_VALIDATION_TYPE_INTEGER_FORMULA:
-        case LXW_VALIDATION_TYPE_DECIMAL_FORMULA:
-        case LXW_VALIDATION_TYPE_LIST_FORMULA:
-        case LXW_VALIDATION_TYPE_LENGTH_FORMULA:
-        case LXW_VALIDATION_TYPE_DATE_FORMULA:
-        case LXW_VALIDATION_TYPE_TIME_FORMULA:
-        case LXW_VALIDATION_TYPE_CUSTOM_FORMULA:
-            is_formula = LXW_TRUE;
-            break;
+    if (self->pinned_rows || !STAILQ_EMPTY(self->segments)) {
+        LXW_WARN_FORMAT1("workbook_checkpoint(): worksheet '%s' with "
+                         "pinned rows or row segments can't be checkpointed.",
+                         self->name);
+        return LXW_ERROR_PARAMETER_VALIDATION;
     }
 
-    /* Check for types without a criteria. */
-    switch (validation->validate) {
-        case LXW_VALIDATION_TYPE_LIST:
-        case LXW_VALIDATION_TYPE_LIST_FORMULA:
-        case LXW_VALIDATION_TYPE_ANY:
-        case LXW_VALIDATION_TYPE_CUSTOM_FORMULA:
-            has_criteria = LXW_FALSE;
-            break;
+    if (row->row_changed || row->data_changed) {
+        lxw_worksheet_write_single_row(self);
+        row->row_num++;
     }
 
-    /* Check that a validation parameter has been specified
-     * except for 'list', 'any' and 'custom'. */
-    if (has_criteria && validation->criteria == LXW_VALIDATION_CRITERIA_NONE) {
+    if (fflush(self->optimize_tmpfile))
+        return LXW_ERROR_CREATING_TMPFILE;
 
-        LXW_WARN_FORMAT("worksheet_data_validation_cell()/_range(): "
-                        "criteria parameter must be specified.");
-        return LXW_ERROR_PARAMETER_VALIDATION;
-    }
+    return LXW_NO_ERROR;
+}
 
-    /* Check for "between" criteria so we can do additional checks. */
-    if (has_criteria
-        && (validation->criteria == LXW_VALIDATION_CRITERIA_BETWEEN
-            || validation->criteria == LXW_VALIDATION_CRITERIA_NOT_BETWEEN)) {
+/*
+ * Write the state needed to resume writing a flushed constant_memory
+ * worksheet: the size of the row data, the next row, the dimensions, the
+ * hyperlinks, which are only written when the workbook is closed, and the
+ * column statistics.
+ */
+lxw_error
+lxw_worksheet_write_checkpoint(lxw_worksheet *self, FILE *file)
+{
+    lxw_row *row = self->optimize_row;
+    lxw_row *link_row;
+    lxw_cell *link;
+    uint32_t num_links = 0;
+    long size;
 
-        is_between = LXW_TRUE;
-    }
+    if (!self->optimize)
+        return LXW_NO_ERROR;
 
-    /* Check that formula values are non NULL. */
-    if (is_formula) {
-        if (is_between) {
-            if (!validation->minimum_formula) {
-                LXW_WARN_FORMAT("worksheet_data_validation_cell()/_range(): "
-                                "minimum_formula parameter cannot be NULL.");
-                return LXW_ERROR_PARAMETER_VALIDATION;
-            }
-            if (!validation->maximum_formula) {
-                LXW_WARN_FORMAT("worksheet_data_validation_cell()/_range(): "
-                                "maximum_formula parameter cannot be NULL.");
-                return LXW_ERROR_PARAMETER_VALIDATION;
-            }
-        }
-        else {
-            if (!validation->value_formula) {
-                LXW_WARN_FORMAT("worksheet_data_validation_cell()/_range(): "
-                                "formula parameter cannot be NULL.");
-                return LXW_ERROR_PARAMETER_VALIDATION;
-            }
-        }
-    }
+    size = ftell(self->optimize_tmpfile);
+    if (size < 0)
+        return LXW_ERROR_CREATING_TMPFILE;
 
-    /* Check Excel limitations on input strings. */
-    if (validation->input_title) {
-        length = lxw_utf8_strlen(validation->input_title);
-        if (length > LXW_VALIDATION_MAX_TITLE_LENGTH) {
-            LXW_WARN_FORMAT1("worksheet_data_validation_cell()/_range(): "
-                             "input_title length > Excel limit of %d.",
-                             LXW_VALIDATION_MAX_TITLE_LENGTH);
-            return LXW_ERROR_32_STRING_LENGTH_EXCEEDED;
+    RB_FOREACH(link_row, lxw_table_rows, self->hyperlinks) {
+        RB_FOREACH(link, lxw_table_cells, link_row->cells) {
+            num_links++;
         }
     }
 
-    if (validation->error_title) {
-        length = lxw_utf8_strlen(validation->error_title);
-        if (length > LXW_VALIDATION_MAX_TITLE_LENGTH) {
-            LXW_WARN_FORMAT1("worksheet_data_validation_cell()/_range(): "
-                             "error_title length > Excel limit of %d.",
-                             LXW_VALIDATION_MAX_TITLE_LENGTH);
-            return LXW_ERROR_32_STRING_LENGTH_EXCEEDED;
+    fprintf(file, "sheet %u %ld %u %u %u %u %u %u %u %u\n",
+            self->index, size, row->row_num,
+            self->dim_rowmin, self->dim_rowmax,
+            self->dim_colmin, self->dim_colmax,
+            self->outline_row_level, self->has_dynamic_functions, num_links);
+
+    RB_FOREACH(link_row, lxw_table_rows, self->hyperlinks) {
+        RB_FOREACH(link, lxw_table_cells, link_row->cells) {
+            fprintf(file, "link %u %u %d", link->row_num, link->col_num,
+                    (int) link->type);
+            _checkpoint_write_string(file, link->sst_string);
+            _checkpoint_write_string(file, link->user_data1);
+            _checkpoint_write_string(file, link->user_data2);
+            fprintf(file, "\n");
         }
     }
 
-    if (validation->input_message) {
-        length = lxw_utf8_strlen(validation->input_message);
-        if (length > LXW_VALIDATION_MAX_STRING_LENGTH) {
-            LXW_WARN_FORMAT1("worksheet_data_validation_cell()/_range(): "
-                             "input_message length > Excel limit of %d.",
-                             LXW_VALIDATION_MAX_STRING_LENGTH);
-            return LXW_ERROR_255_STRING_LENGTH_EXCEEDED;
-        }
-    }
+    _checkpoint_write_column_stats(self, file);
 
-    if (validation->error_message) {
-        length = lxw_utf8_strlen(validation->error_message);
-        if (length > LXW_VALIDATION_MAX_STRING_LENGTH) {
-            LXW_WARN_FORMAT1("worksheet_data_validation_cell()/_range(): "
-                             "error_message length > Excel limit of %d.",
-                             LXW_VALIDATION_MAX_STRING_LENGTH);
-            return LXW_ERROR_255_STRING_LENGTH_EXCEEDED;
-        }
-    }
+    return LXW_NO_ERROR;
+}
 
-    if (validation->validate == LXW_VALIDATION_TYPE_LIST) {
-        length = _validation_list_length(validation->value_list);
+/*
+ * Restore the state of a constant_memory worksheet from a checkpoint, after
+ * the "sheet <index>" prefix has been read by the workbook. The checkpoint
+ * file of the worksheet is positioned after the saved rows so that any rows
+ * written after the checkpoint are overwritten.
+ */
+lxw_error
+lxw_worksheet_read_checkpoint(lxw_worksheet *self, FILE *file)
+{
+    lxw_row *row = self->optimize_row;
+    lxw_url_element *url_element;
+    lxw_format *format;
+    lxw_cell *link;
+    char *url = NULL;
+    char *string = NULL;
+    char *tooltip = NULL;
+    long size;
+    unsigned int next_row;
+    unsigned int dims[4];
+    unsigned int outline_level;
+    unsigned int dynamic_functions;
+    unsigned int num_links;
+    unsigned int link_row;
+    unsigned int link_col;
+    int link_type;
+    uint32_t i;
+    lxw_error err;
 
-        if (length == 0) {
-            LXW_WARN_FORMAT("worksheet_data_validation_cell()/_range(): "
-                            "list parameters cannot be zero.");
-            return LXW_ERROR_PARAMETER_VALIDATION;
-        }
+    if (!self->optimize || self->pinned_rows
+        || !STAILQ_EMPTY(self->segments))
+        return LXW_ERROR_PARAMETER_VALIDATION;
 
-        if (length > LXW_VALIDATION_MAX_STRING_LENGTH) {
-            LXW_WARN_FORMAT1("worksheet_data_validation_cell()/_range(): "
-                             "list length with commas > Excel limit of %d.",
-                             LXW_VALIDATION_MAX_STRING_LENGTH);
-            return LXW_ERROR_255_STRING_LENGTH_EXCEEDED;
-        }
-    }
+    if (fscanf(file, " %ld %u %u %u %u %u %u %u %u", &size, &next_row,
+               &dims[0], &dims[1], &dims[2], &dims[3], &outline_level,
+               &dynamic_functions, &num_links) != 9)
+        return LXW_ERROR_READING_TMPFILE;
+
+    /* The rows saved in the checkpoint must all be in the row file. */
+    if (size < 0 || fseek(self->optimize_tmpfile, 0, SEEK_END)
+        || ftell(self->optimize_tmpfile) < size
+        || fseek(self->optimize_tmpfile, size, SEEK_SET))
+        return LXW_ERROR_READING_TMPFILE;
+
+    row->row_num = next_row;
+    self->dim_rowmin = dims[0];
+    self->dim_rowmax = dims[1];
+    self->dim_colmin = (lxw_col_t) dims[2];
+    self->dim_colmax = (lxw_col_t) dims[3];
+    self->outline_row_level = (uint8_t) outline_level;
+    self->has_dynamic_functions = (uint8_t) dynamic_functions;
+
+    for (i = 0; i < num_links; i++) {
+        if (fscanf(file, " link %u %u %d", &link_row, &link_col,
+                   &link_type) != 3)
+            return LXW_ERROR_READING_TMPFILE;
 
-    /* Swap last row/col with first row/col as necessary */
-    if (first_row > last_row) {
-        tmp_row = last_row;
-        last_row = first_row;
-        first_row = tmp_row;
-    }
-    if (first_col > last_col) {
-        tmp_col = last_col;
-        last_col = first_col;
-        first_col = tmp_col;
-    }
+        err = _checkpoint_read_string(file, &url);
+        if (!err)
+            err = _checkpoint_read_string(file, &string);
+        if (!err)
+            err = _checkpoint_read_string(file, &tooltip);
 
-    /* Check that dimensions are valid but don't store them. */
-    err = _check_dimensions(self, last_row, last_col, LXW_TRUE, LXW_TRUE);
-    if (err)
-        return err;
+        if (!err && (!url || link_type < HYPERLINK_URL
+                     || link_type > HYPERLINK_EXTERNAL))
+            err = LXW_ERROR_READING_TMPFILE;
 
-    /* Create a copy of the parameters from the user data validation. */
-    copy = calloc(1, sizeof(lxw_data_val_obj));
-    GOTO_LABEL_ON_MEM_ERROR(copy, mem_error);
+        if (err)
+            goto error;
 
-    /* Create the data validation range. */
-    if (first_row == last_row && first_col == last_col)
-        lxw_rowcol_to_cell(copy->sqref, first_row, first_col);
-    else
-        lxw_rowcol_to_range(copy->sqref, first_row, first_col, last_row,
-                            last_col);
+        url_element = _get_url_element(self->url_table, url, LXW_TRUE);
+        if (!url_element) {
+            url_element = _new_url_element(self->url_table, url, url,
+                                           lxw_utf8_strlen(url), LXW_TRUE);
+            GOTO_LABEL_ON_MEM_ERROR(url_element, mem_error);
+        }
 
-    /* Copy the parameters from the user data validation. */
-    copy->validate = validation->validate;
-    copy->value_number = validation->value_number;
-    copy->error_type = validation->error_type;
-    copy->dropdown = validation->dropdown;
+        link = _new_hyperlink_cell(link_row, (lxw_col_t) link_col,
+                                   (enum cell_types) link_type, url_element,
+                                   string, tooltip);
+        GOTO_LABEL_ON_MEM_ERROR(link, mem_error);
 
-    if (has_criteria)
-        copy->criteria = validation->criteria;
+        _insert_hyperlink(self, link_row, (lxw_col_t) link_col, link);
+        self->hlink_count++;
 
-    if (is_between) {
-        copy->value_number = validation->minimum_number;
-        copy->maximum_number = validation->maximum_number;
+        free(url);
+        url = NULL;
+        string = NULL;
+        tooltip = NULL;
     }
 
-    /* Copy the input/error titles and messages. */
-    if (validation->input_title) {
-        copy->input_title = lxw_strdup_formula(validation->input_title);
-        GOTO_LABEL_ON_MEM_ERROR(copy->input_title, mem_error);
-    }
+    err = _checkpoint_read_column_stats(self, file);
+    if (err)
+        return err;
 
-    if (validation->input_message) {
-        copy->input_message = lxw_strdup_formula(validation->input_message);
-        GOTO_LABEL_ON_MEM_ERROR(copy->input_message, mem_error);
+    /* Map the format ids in binary row records back to the formats. */
+    if (self->binary_tmpfile && self->formats) {
+        STAILQ_FOREACH(format, self->formats, list_pointers) {
+            if (format->xf_index != LXW_PROPERTY_UNSET)
+                _record_format_id(self, format);
+        }
     }
 
-    if (validation->error_title) {
-        copy->error_title = lxw_strdup_formula(validation->error_title);
-        GOTO_LABEL_ON_MEM_ERROR(copy->error_title, mem_error);
-    }
+    return LXW_NO_ERROR;
 
-    if (validation->error_message) {
-        copy->error_message = lxw_strdup_formula(validation->error_message);
-        GOTO_LABEL_ON_MEM_ERROR(copy->error_message, mem_error);
-    }
+mem_error:
+    err = LXW_ERROR_MEMORY_MALLOC_FAILED;
 
-    /* Copy the formula strings. */
-    if (is_formula) {
-        if (is_between) {
-            copy->value_formula =
-                lxw_strdup_formula(validation->minimum_formula);
-            GOTO_LABEL_ON_MEM_ERROR(copy->value_formula, mem_error);
-            copy->maximum_formula =
-                lxw_strdup_formula(validation->maximum_formula);
-            GOTO_LABEL_ON_MEM_ERROR(copy->maximum_formula, mem_error);
+error:
+    free(url);
+    free(string);
+    free(tooltip);
+    return err;
+}
+
+/*
+ * Find the first row in a row tree at or after a given row number.
+ */
+STATIC lxw_row *
+_find_row_from(struct lxw_table_rows *table, lxw_row_t row_num)
+{
+    lxw_row *row = RB_ROOT(table);
+    lxw_row *found = NULL;
+
+    while (row) {
+        if (row->row_num == row_num)
+            return row;
+
+        if (row->row_num > row_num) {
+            found = row;
+            row = RB_LEFT(row, tree_pointers);
         }
         else {
-            copy->value_formula =
-                lxw_strdup_formula(validation->value_formula);
-            GOTO_LABEL_ON_MEM_ERROR(copy->value_formula, mem_error);
+            row = RB_RIGHT(row, tree_pointers);
         }
     }
 
-    /* Copy the validation list as a csv string. */
-    if (validation->validate == LXW_VALIDATION_TYPE_LIST) {
-        copy->value_formula = _validation_list_to_csv(validation->value_list);
-        GOTO_LABEL_ON_MEM_ERROR(copy->value_formula, mem_error);
-    }
+    return found;
+}
 
-    if (validation->validate == LXW_VALIDATION_TYPE_DATE
-        || validation->validate == LXW_VALIDATION_TYPE_TIME) {
-        if (is_between) {
-            copy->value_number =
-                lxw_datetime_to_excel_date_with_epoch
-                (&validation->minimum_datetime, self->use_1904_epoch);
-            copy->maximum_number =
-                lxw_datetime_to_excel_date_with_epoch
-                (&validation->maximum_datetime, self->use_1904_epoch);
+/*
+ * Find the first cell in a cell tree at or after a given column number.
+ */
+STATIC lxw_cell *
+_find_cell_from(struct lxw_table_cells *cells, lxw_col_t col_num)
+{
+    lxw_cell *cell = RB_ROOT(cells);
+    lxw_cell *found = NULL;
+
+    while (cell) {
+        if (cell->col_num == col_num)
+            return cell;
+
+        if (cell->col_num > col_num) {
+            found = cell;
+            cell = RB_LEFT(cell, tree_pointers);
         }
         else {
-            copy->value_number =
-                lxw_datetime_to_excel_date_with_epoch
-                (&validation->value_datetime, self->use_1904_epoch);
+            cell = RB_RIGHT(cell, tree_pointers);
         }
     }
 
-    /* These options are on by default so we can't take plain booleans. */
-    copy->ignore_blank = validation->ignore_blank ^ 1;
-    copy->show_input = validation->show_input ^ 1;
-    copy->show_error = validation->show_error ^ 1;
+    return found;
+}
 
-    STAILQ_INSERT_TAIL(self->data_validations, copy, list_pointers);
+/*
+ * Copy the data of a cell to a user cell value struct. Returns false for
+ * cells that don't hold data such as comment placeholders.
+ */
+STATIC uint8_t
+_get_cell_value(lxw_cell *cell, lxw_cell_value *value)
+{
+    /* Blank cells without a format are placeholders and aren't written. */
+    if (cell->type == BLANK_CELL && !cell->format)
+        return LXW_FALSE;
 
-    self->num_validations++;
+    value->row = cell->row_num;
+    value->col = cell->col_num;
+    value->number = 0;
+    value->string = NULL;
+    value->format = cell->format;
 
-    return LXW_NO_ERROR;
+    if (cell->type == NUMBER_CELL) {
+        value->type = LXW_CELL_VALUE_NUMBER;
+        value->number = cell->u.number;
+    }
+    else if (cell->type == NUMBER_TEXT_CELL) {
+        value->type = LXW_CELL_VALUE_NUMBER;
+        value->number = lxw_strtod(cell->u.string, NULL);
+    }
+    else if (cell->type == STRING_CELL) {
+        value->type = LXW_CELL_VALUE_STRING;
+        value->string = cell->sst_string;
+    }
+    else if (cell->type == INLINE_STRING_CELL
+             || cell->type == INLINE_RICH_STRING_CELL) {
+        value->type = LXW_CELL_VALUE_STRING;
+        value->string = cell->u.string;
+    }
+    else if (cell->type == FORMULA_CELL
+             || cell->type == ARRAY_FORMULA_CELL
+             || cell->type == DYNAMIC_ARRAY_FORMULA_CELL) {
+        value->type = LXW_CELL_VALUE_FORMULA;
+        value->string = cell->u.string;
+        value->number = cell->formula_result;
+    }
+    else if (cell->type == BOOLEAN_CELL) {
+        value->type = LXW_CELL_VALUE_BOOLEAN;
+        value->number = cell->u.number;
+    }
+    else if (cell->type == BLANK_CELL) {
+        value->type = LXW_CELL_VALUE_BLANK;
+    }
+    else if (cell->type == ERROR_CELL) {
+        value->type = LXW_CELL_VALUE_ERROR;
+    }
+    else {
+        return LXW_FALSE;
+    }
 
-mem_error:
-    _free_data_validation(copy);
-    return LXW_ERROR_MEMORY_MALLOC_FAILED;
+    return LXW_TRUE;
 }
 
 /*
- * Add a data validation to a worksheet, for a cell.
+ * Copy the formula of a table calculated column to a user cell value struct,
+ * for a cell in the column that isn't stored in the worksheet. Returns false
+ * if the cell isn't in a calculated column.
  */
-lxw_error
-worksheet_data_validation_cell(lxw_worksheet *self, lxw_row_t row,
-                               lxw_col_t col, lxw_data_validation *validation)
+STATIC uint8_t
+_get_table_formula_value(lxw_worksheet *self, lxw_row_t row_num,
+                         lxw_col_t col_num, lxw_cell_value *value)
 {
-    return worksheet_data_validation_range(self, row, col,
-                                           row, col, validation);
+    lxw_table_column *column;
+
+    column = lxw_worksheet_find_table_formula(self, row_num, col_num);
+    if (!column)
+        return LXW_FALSE;
+
+    value->row = row_num;
+    value->col = col_num;
+    value->type = LXW_CELL_VALUE_FORMULA;
+    value->number = 0;
+    value->string = column->formula;
+    value->format = column->format;
+
+    return LXW_TRUE;
 }
 
 /*
- * Add a conditional format to a worksheet, for a range.
+ * Read back the data written to a worksheet cell.
  */
 lxw_error
-worksheet_conditional_format_range(lxw_worksheet *self, lxw_row_t first_row,
-                                   lxw_col_t first_col,
-                                   lxw_row_t last_row,
-                                   lxw_col_t last_col,
-                                   lxw_conditional_format *user_options)
+worksheet_get_cell(lxw_worksheet *self, lxw_row_t row_num, lxw_col_t col_num,
+                   lxw_cell_value *value)
 {
-    lxw_cond_format_obj *cond_format;
-    lxw_row_t tmp_row;
-    lxw_col_t tmp_col;
-    lxw_error err = LXW_NO_ERROR;
-    char *type_strings[] = {
-        "none",
-        "cellIs",
-        "containsText",
-        "timePeriod",
-        "aboveAverage",
-        "duplicateValues",
-        "uniqueValues",
-        "top10",
-        "top10",
-        "containsBlanks",
-        "notContainsBlanks",
-        "containsErrors",
-        "notContainsErrors",
-        "expression",
-        "colorScale",
-        "colorScale",
-        "dataBar",
-        "iconSet",
-    };
+    lxw_cell *cell = NULL;
 
-    /* Swap last row/col with first row/col as necessary */
-    if (first_row > last_row) {
-        tmp_row = last_row;
-        last_row = first_row;
-        first_row = tmp_row;
+    if (!value)
+        return LXW_ERROR_NULL_PARAMETER_IGNORED;
+
+    if (row_num >= LXW_ROW_MAX || col_num >= LXW_COL_MAX)
+        return LXW_ERROR_WORKSHEET_INDEX_OUT_OF_RANGE;
+
+    if (self->optimize && row_num >= self->pinned_rows) {
+        /* Only the current row is stored in constant_memory mode. */
+        if (row_num == self->optimize_row->row_num)
+            cell = self->array[col_num];
     }
-    if (first_col > last_col) {
-        tmp_col = last_col;
-        last_col = first_col;
-        first_col = tmp_col;
+    else {
+        cell = lxw_worksheet_find_cell_in_row(lxw_worksheet_find_row(self,
+                                                                     row_num),
+                                              col_num);
     }
 
-    /* Check that dimensions are valid but don't store them. */
-    err = _check_dimensions(self, last_row, last_col, LXW_TRUE, LXW_TRUE);
-    if (err)
-        return err;
+    if (cell && _get_cell_value(cell, value))
+        return LXW_NO_ERROR;
 
-    /* Check the validation type is in correct enum range. */
-    if (user_options->type <= LXW_CONDITIONAL_TYPE_NONE ||
-        user_options->type >= LXW_CONDITIONAL_TYPE_LAST) {
+    if (!_get_table_formula_value(self, row_num, col_num, value)) {
+        value->row = row_num;
+        value->col = col_num;
+        value->type = LXW_CELL_VALUE_EMPTY;
+        value->number = 0;
+        value->string = NULL;
+        value->format = NULL;
+    }
 
-        LXW_WARN_FORMAT1("worksheet_conditional_format_cell()/_range(): "
-                         "invalid type value (%d).", user_options->type);
+    return LXW_NO_ERROR;
+}
 
-        return LXW_ERROR_PARAMETER_VALIDATION;
-    }
+/*
+ * Initialize an iterator over the cells written to a worksheet range.
+ */
+lxw_error
+worksheet_cell_iter_init(lxw_cell_iter *iter, lxw_worksheet *self,
+                         lxw_row_t first_row, lxw_col_t first_col,
+                         lxw_row_t last_row, lxw_col_t last_col)
+{
+    if (!iter)
+        return LXW_ERROR_NULL_PARAMETER_IGNORED;
 
-    /* Create a copy of the parameters from the user data validation. */
-    cond_format = calloc(1, sizeof(lxw_cond_format_obj));
-    GOTO_LABEL_ON_MEM_ERROR(cond_format, error);
+    memset(iter, 0, sizeof(lxw_cell_iter));
 
-    /* Create the data validation range. */
-    if (first_row == last_row && first_col == last_col)
-        lxw_rowcol_to_cell(cond_format->sqref, first_row, first_col);
-    else
-        lxw_rowcol_to_range(cond_format->sqref, first_row, first_col,
-                            last_row, last_col);
+    if (last_row >= LXW_ROW_MAX || last_col >= LXW_COL_MAX)
+        return LXW_ERROR_WORKSHEET_INDEX_OUT_OF_RANGE;
 
-    /* Store the first cell string for text and date rules. */
-    lxw_rowcol_to_cell(cond_format->first_cell, first_row, first_col);
+    if (first_row > last_row || first_col > last_col)
+        return LXW_ERROR_PARAMETER_VALIDATION;
 
-    /* Overwrite the sqref range with a user supplied set of ranges. */
-    if (user_options->multi_range) {
+    iter->worksheet = self;
+    iter->first_row = first_row;
+    iter->last_row = last_row;
+    iter->first_col = first_col;
+    iter->last_col = last_col;
 
-        if (strlen(user_options->multi_range) >= LXW_MAX_ATTRIBUTE_LENGTH) {
-            LXW_WARN_FORMAT1("worksheet_conditional_format_cell()/_range(): "
-                             "multi_range >= limit = %d.",
-                             LXW_MAX_ATTRIBUTE_LENGTH);
-            err = LXW_ERROR_PARAMETER_VALIDATION;
-            goto error;
-        }
+    return LXW_NO_ERROR;
+}
 
-        LXW_ATTRIBUTE_COPY(cond_format->sqref, user_options->multi_range);
-    }
+/*
+ * Get the next cell in an iterator range. The rows and cells are walked in
+ * tree order so that only the start of each row requires a search.
+ */
+uint8_t
+worksheet_cell_iter_next(lxw_cell_iter *iter, lxw_cell_value *value)
+{
+    lxw_worksheet *self = iter->worksheet;
+    lxw_row_t row_num;
+    lxw_col_t col;
+    lxw_col_t col_min = 0;
+    lxw_col_t col_max = 0;
+    lxw_cell *cell;
 
-    /* Get the conditional format dxf format index. */
-    if (user_options->format)
-        cond_format->dxf_index =
-            lxw_format_get_dxf_index(user_options->format);
-    else
-        cond_format->dxf_index = LXW_PROPERTY_UNSET;
+    if (!self || !value)
+        return LXW_FALSE;
 
-    /* Set some common option for all validation types. */
-    cond_format->type = user_options->type;
-    cond_format->criteria = user_options->criteria;
-    cond_format->stop_if_true = user_options->stop_if_true;
-    cond_format->type_string = lxw_strdup(type_strings[cond_format->type]);
+    /* Only the current row is stored in constant_memory mode. */
+    if (self->optimize) {
+        row_num = self->optimize_row->row_num;
 
-    /* Check that the criteria matches the conditional type. */
-    err = _validate_conditional_criteria(cond_format);
-    if (err)
-        goto error;
+        if (row_num < iter->first_row || row_num > iter->last_row)
+            return LXW_FALSE;
+
+        if (!iter->started) {
+            iter->col = iter->first_col;
+            iter->started = LXW_TRUE;
+        }
 
-    /* Validate the user input for various types of rules. */
-    if (user_options->type == LXW_CONDITIONAL_TYPE_CELL
-        || cond_format->type == LXW_CONDITIONAL_TYPE_DUPLICATE
-        || cond_format->type == LXW_CONDITIONAL_TYPE_UNIQUE) {
+        while (iter->col <= iter->last_col) {
+            cell = self->array[iter->col++];
 
-        err = _validate_conditional_cell(cond_format, user_options);
-        if (err)
-            goto error;
-    }
-    else if (user_options->type == LXW_CONDITIONAL_TYPE_TEXT) {
+            if (cell && _get_cell_value(cell, value))
+                return LXW_TRUE;
+        }
 
-        err = _validate_conditional_text(cond_format, user_options);
-        if (err)
-            goto error;
+        return LXW_FALSE;
     }
-    else if (user_options->type == LXW_CONDITIONAL_TYPE_TIME_PERIOD) {
 
-        err = _validate_conditional_time_period(user_options);
-        if (err)
-            goto error;
-    }
-    else if (user_options->type == LXW_CONDITIONAL_TYPE_AVERAGE) {
+    _worksheet_use_cells(self);
 
-        err = _validate_conditional_average(user_options);
-        if (err)
-            goto error;
-    }
-    else if (cond_format->type == LXW_CONDITIONAL_TYPE_TOP
-             || cond_format->type == LXW_CONDITIONAL_TYPE_BOTTOM) {
+    if (!iter->started) {
+        iter->started = LXW_TRUE;
+        iter->row = _find_row_from(self->table, iter->first_row);
+        iter->col = iter->first_col;
 
-        err = _validate_conditional_top(cond_format, user_options);
-        if (err)
-            goto error;
+        if (iter->row)
+            iter->cell = _find_cell_from(iter->row->cells, iter->col);
     }
-    else if (user_options->type == LXW_CONDITIONAL_TYPE_FORMULA) {
+    else if (iter->row && iter->reload_count != self->reload_count) {
+        /* Find the current position again if the cell data of the
+         * worksheet has been spilled to disk and reloaded since the last
+         * call. */
+        iter->row = lxw_worksheet_find_row(self, iter->row_num);
 
-        err = _validate_conditional_formula(cond_format, user_options);
-        if (err)
-            goto error;
+        if (iter->row)
+            iter->cell = _find_cell_from(iter->row->cells, iter->col);
     }
-    else if (cond_format->type == LXW_CONDITIONAL_2_COLOR_SCALE
-             || cond_format->type == LXW_CONDITIONAL_3_COLOR_SCALE) {
 
-        err = _validate_conditional_scale(cond_format, user_options);
-        if (err)
-            goto error;
-    }
-    else if (cond_format->type == LXW_CONDITIONAL_DATA_BAR) {
+    iter->reload_count = self->reload_count;
 
-        err = _validate_conditional_data_bar(self, cond_format, user_options);
-        if (err)
-            goto error;
-    }
-    else if (cond_format->type == LXW_CONDITIONAL_TYPE_ICON_SETS) {
+    while (iter->row && iter->row->row_num <= iter->last_row) {
+        row_num = iter->row->row_num;
+        iter->row_num = row_num;
 
-        err = _validate_conditional_icons(user_options);
-        if (err)
-            goto error;
+        while (iter->col <= iter->last_col) {
+            cell = iter->cell;
+            if (cell && cell->col_num > iter->last_col)
+                cell = NULL;
 
-        cond_format->icon_style = user_options->icon_style;
-        cond_format->reverse_icons = user_options->reverse_icons;
-        cond_format->icons_only = user_options->icons_only;
+            /* Table calculated column formulas aren't stored as cells. They
+             * are returned in column order and replace placeholder cells,
+             * as when the row is written. */
+            if (_get_table_formula_span(self, row_num, &col_min, &col_max)) {
+                col = iter->col > col_min ? iter->col : col_min;
+
+                if (cell && cell->col_num < col_max)
+                    col_max = cell->col_num;
+
+                if (iter->last_col < col_max)
+                    col_max = iter->last_col;
+
+                for (; col <= col_max; col++) {
+                    if (cell && cell->col_num == col
+                        && (cell->type != BLANK_CELL || cell->format))
+                        break;
+
+                    if (_get_table_formula_value(self, row_num, col, value)) {
+                        if (cell && cell->col_num == col)
+                            iter->cell = RB_NEXT(lxw_table_cells,
+                                                 iter->row->cells, cell);
+
+                        iter->col = col + 1;
+                        return LXW_TRUE;
+                    }
+                }
+            }
+
+            if (!cell)
+                break;
+
+            iter->cell = RB_NEXT(lxw_table_cells, iter->row->cells, cell);
+            iter->col = cell->col_num + 1;
+
+            if (_get_cell_value(cell, value))
+                return LXW_TRUE;
+        }
+
+        iter->row = RB_NEXT(lxw_table_rows, self->table, iter->row);
+        iter->col = iter->first_col;
+        iter->cell = NULL;
+
+        if (iter->row)
+            iter->cell = _find_cell_from(iter->row->cells, iter->first_col);
     }
 
-    /* Set the priority based on the order of adding. */
-    cond_format->dxf_priority = ++self->dxf_priority;
+    iter->row = NULL;
+    iter->cell = NULL;
 
-    /* Store the conditional format object. */
-    err = _store_conditional_format_object(self, cond_format);
+    return LXW_FALSE;
+}
 
-    if (err)
-        goto error;
-    else
-        return LXW_NO_ERROR;
+/*
+ * Read the little-endian integers and doubles used by the batch commands.
+ */
+STATIC uint16_t
+_batch_read_u16(const uint8_t *data)
+{
+    return (uint16_t) (data[0] | (data[1] << 8));
+}
 
-error:
-    _free_cond_format(cond_format);
-    return err;
+STATIC uint32_t
+_batch_read_u32(const uint8_t *data)
+{
+    return (uint32_t) data[0] | ((uint32_t) data[1] << 8)
+        | ((uint32_t) data[2] << 16) | ((uint32_t) data[3] << 24);
+}
+
+STATIC double
+_batch_read_double(const uint8_t *data)
+{
+    uint64_t bits = _batch_read_u32(data)
+        | ((uint64_t) _batch_read_u32(data + 4) << 32);
+    double number;
+
+    memcpy(&number, &bits, sizeof(number));
+
+    return number;
 }
 
 /*
- * Add a conditional format to a worksheet, for a cell.
+ * Get the size of the fixed length part of a batch command, including the
+ * opcode. Returns 0 for an unknown opcode.
  */
-lxw_error
-worksheet_conditional_format_cell(lxw_worksheet *self,
-                                  lxw_row_t row,
-                                  lxw_col_t col,
-                                  lxw_conditional_format *options)
+STATIC size_t
+_batch_command_size(uint8_t opcode)
 {
-    return worksheet_conditional_format_range(self, row, col,
-                                              row, col, options);
+    switch (opcode) {
+        case LXW_BATCH_SET_FORMAT:
+            return 3;
+        case LXW_BATCH_WRITE_NUMBER:
+            return 15;
+        case LXW_BATCH_WRITE_STRING:
+        case LXW_BATCH_WRITE_FORMULA:
+            return 11;
+        case LXW_BATCH_WRITE_BLANK:
+            return 7;
+        case LXW_BATCH_WRITE_BOOLEAN:
+            return 8;
+        case LXW_BATCH_WRITE_DATETIME:
+            return 21;
+        case LXW_BATCH_SET_ROW:
+            return 13;
+        case LXW_BATCH_MERGE_RANGE:
+            return 17;
+        default:
+            return 0;
+    }
 }
 
 /*
- * Insert a button object into the worksheet.
+ * Check that a batch buffer is well formed and get the number of formats it
+ * refers to and the length of its longest string.
  */
-lxw_error
-worksheet_insert_button(lxw_worksheet *self, lxw_row_t row_num,
-                        lxw_col_t col_num, lxw_button_options *options)
+STATIC lxw_error
+_batch_validate(const uint8_t *buffer, size_t length, uint16_t num_formats,
+                size_t *max_string, size_t *error_offset)
 {
-    lxw_error err;
-    lxw_vml_obj *button;
+    size_t offset = 0;
+    size_t size;
+    size_t string_length;
+    uint8_t opcode;
 
-    err = _check_dimensions(self, row_num, col_num, LXW_TRUE, LXW_TRUE);
-    if (err)
-        return err;
+    *max_string = 0;
 
-    button = calloc(1, sizeof(lxw_vml_obj));
-    GOTO_LABEL_ON_MEM_ERROR(button, mem_error);
+    while (offset < length) {
+        opcode = buffer[offset];
+        size = _batch_command_size(opcode);
 
-    button->row = row_num;
-    button->col = col_num;
+        if (!size || length - offset < size)
+            goto error;
 
-    /* Set user and default parameters for the button. */
-    err = _get_button_params(button, 1 + self->num_buttons, options);
-    if (err)
-        goto mem_error;
+        if (opcode == LXW_BATCH_SET_FORMAT
+            && _batch_read_u16(buffer + offset + 1) > num_formats)
+            goto error;
 
-    /* Calculate the worksheet position of the button. */
-    _worksheet_position_vml_object(self, button);
+        if (opcode == LXW_BATCH_WRITE_STRING
+            || opcode == LXW_BATCH_WRITE_FORMULA
+            || opcode == LXW_BATCH_MERGE_RANGE) {
 
-    self->has_vml = LXW_TRUE;
-    self->has_buttons = LXW_TRUE;
-    self->num_buttons++;
+            string_length = _batch_read_u32(buffer + offset + size - 4);
 
-    STAILQ_INSERT_TAIL(self->button_objs, button, list_pointers);
+            if (length - offset - size < string_length)
+                goto error;
 
-    return LXW_NO_ERROR;
+            if (string_length > *max_string)
+                *max_string = string_length;
 
-mem_error:
-    if (button)
-        _free_vml_object(button);
+            size += string_length;
+        }
 
-    return LXW_ERROR_MEMORY_MALLOC_FAILED;
+        offset += size;
+    }
+
+    return LXW_NO_ERROR;
+
+error:
+    *error_offset = offset;
+    return LXW_ERROR_PARAMETER_VALIDATION;
 }
 
 /*
- * Set the VBA name for the worksheet.
+ * Add the formats created since the last batch to the table that maps the
+ * batch format ids to formats. The table is kept between batches so that
+ * only new formats are looked up. The default formats of the workbook
+ * aren't given ids.
  */
-lxw_error
-worksheet_set_vba_name(lxw_worksheet *self, const char *name)
+STATIC lxw_error
+_update_batch_formats(lxw_worksheet *self)
 {
-    if (!name) {
-        LXW_WARN("worksheet_set_vba_name(): " "name must be specified.");
-        return LXW_ERROR_NULL_PARAMETER_IGNORED;
+    lxw_format *format;
+    lxw_format **batch_formats;
+    uint16_t size;
+    uint16_t i;
+
+    if (!self->formats)
+        return LXW_NO_ERROR;
+
+    if (self->num_batch_formats) {
+        format = self->batch_formats[self->num_batch_formats - 1];
+        format = STAILQ_NEXT(format, list_pointers);
+    }
+    else {
+        format = STAILQ_FIRST(self->formats);
+        for (i = 0; format && i < self->num_default_formats; i++)
+            format = STAILQ_NEXT(format, list_pointers);
     }
 
-    self->vba_codename = lxw_strdup(name);
+    /* The format ids are 16 bit. */
+    while (format && self->num_batch_formats < UINT16_MAX) {
 
-    return LXW_NO_ERROR;
-}
+        if (self->num_batch_formats == self->batch_formats_size) {
+            if (self->batch_formats_size > UINT16_MAX / 2)
+                size = UINT16_MAX;
+            else if (self->batch_formats_size)
+                size = self->batch_formats_size * 2;
+            else
+                size = 16;
 
-/*
- * Set the default author of the cell comments.
- */
-void
-worksheet_set_comments_author(lxw_worksheet *self, const char *author)
-{
-    self->comment_author = lxw_strdup(author);
-}
+            batch_formats = realloc(self->batch_formats,
+                                    size * sizeof(lxw_format *));
+            RETURN_ON_MEM_ERROR(batch_formats,
+                                LXW_ERROR_MEMORY_MALLOC_FAILED);
 
-/*
- * Make any comments in the worksheet visible, unless explicitly hidden.
- */
-void
-worksheet_show_comments(lxw_worksheet *self)
-{
-    self->comment_display_default = LXW_COMMENT_DISPLAY_VISIBLE;
+            self->batch_formats = batch_formats;
+            self->batch_formats_size = size;
+        }
+
+        self->batch_formats[self->num_batch_formats++] = format;
+        format = STAILQ_NEXT(format, list_pointers);
+    }
+
+    return LXW_NO_ERROR;
 }
 
 /*
- * Ignore various Excel errors/warnings in a worksheet for user defined ranges.
+ * Write data to a worksheet from a buffer of binary commands.
  */
 lxw_error
-worksheet_ignore_errors(lxw_worksheet *self, uint8_t type, const char *range)
+worksheet_execute_batch(lxw_worksheet *self, const uint8_t *buffer,
+                        size_t length, size_t *error_offset)
 {
-    if (!range) {
-        LXW_WARN("worksheet_ignore_errors(): " "'range' must be specified.");
-        return LXW_ERROR_NULL_PARAMETER_IGNORED;
-    }
+    lxw_format *format = NULL;
+    lxw_datetime datetime;
+    const uint8_t *data;
+    char *string = NULL;
+    size_t offset = 0;
+    size_t max_string;
+    size_t string_length;
+    size_t failed_offset = 0;
+    uint16_t format_id;
+    uint8_t opcode;
+    lxw_error err = LXW_NO_ERROR;
 
-    if (type <= 0 || type >= LXW_IGNORE_LAST_OPTION) {
-        LXW_WARN("worksheet_ignore_errors(): " "unknown option in 'type'.");
+    if (!buffer) {
+        LXW_WARN("worksheet_execute_batch(): buffer must be non-NULL.");
         return LXW_ERROR_NULL_PARAMETER_IGNORED;
     }
 
-    /* Set the ranges to be ignored. */
-    if (type == LXW_IGNORE_NUMBER_STORED_AS_TEXT) {
-        free(self->ignore_number_stored_as_text);
-        self->ignore_number_stored_as_text = lxw_strdup(range);
-    }
-    else if (type == LXW_IGNORE_EVAL_ERROR) {
-        free(self->ignore_eval_error);
-        self->ignore_eval_error = lxw_strdup(range);
-    }
-    else if (type == LXW_IGNORE_FORMULA_DIFFERS) {
-        free(self->ignore_formula_differs);
-        self->ignore_formula_differs = lxw_strdup(range);
-    }
-    else if (type == LXW_IGNORE_FORMULA_RANGE) {
-        free(self->ignore_formula_range);
-        self->ignore_formula_range = lxw_strdup(range);
-    }
-    else if (type == LXW_IGNORE_FORMULA_UNLOCKED) {
-        free(self->ignore_formula_unlocked);
-        self->ignore_formula_unlocked = lxw_strdup(range);
-    }
-    else if (type == LXW_IGNORE_EMPTY_CELL_REFERENCE) {
-        free(self->ignore_empty_cell_reference);
-        self->ignore_empty_cell_reference = lxw_strdup(range);
-    }
-    else if (type == LXW_IGNORE_LIST_DATA_VALIDATION) {
-        free(self->ignore_list_data_validation);
-        self->ignore_list_data_validation = lxw_strdup(range);
-    }
-    else if (type == LXW_IGNORE_CALCULATED_COLUMN) {
-        free(self->ignore_calculated_column);
-        self->ignore_calculated_column = lxw_strdup(range);
-    }
-    else if (type == LXW_IGNORE_TWO_DIGIT_TEXT_YEAR) {
-        free(self->ignore_two_digit_text_year);
-        self->ignore_two_digit_text_year = lxw_strdup(range);
-    }
+    err = _update_batch_formats(self);
+    if (err)
+        return err;
 
-    self->has_ignore_errors = LXW_TRUE;
+    err = _batch_validate(buffer, length, self->num_batch_formats,
+                          &max_string, &failed_offset);
+    if (err)
+        goto error;
+
+    string = malloc(max_string + 1);
+    GOTO_LABEL_ON_MEM_ERROR(string, mem_error);
+
+    /* The buffer has been checked so the commands can be applied directly. */
+    while (offset < length) {
+        opcode = buffer[offset];
+        data = buffer + offset + 1;
+        failed_offset = offset;
+        offset += _batch_command_size(opcode);
+
+        switch (opcode) {
+            case LXW_BATCH_SET_FORMAT:
+                format_id = _batch_read_u16(data);
+                format = format_id ? self->batch_formats[format_id - 1] : NULL;
+                break;
+
+            case LXW_BATCH_WRITE_NUMBER:
+                err = worksheet_write_number(self, _batch_read_u32(data),
+                                             _batch_read_u16(data + 4),
+                                             _batch_read_double(data + 6),
+                                             format);
+                break;
+
+            case LXW_BATCH_WRITE_STRING:
+            case LXW_BATCH_WRITE_FORMULA:
+            case LXW_BATCH_MERGE_RANGE:
+                string_length = _batch_read_u32(buffer + offset - 4);
+                memcpy(string, buffer + offset, string_length);
+                string[string_length] = '\0';
+                offset += string_length;
+
+                if (opcode == LXW_BATCH_WRITE_STRING)
+                    err = worksheet_write_string(self, _batch_read_u32(data),
+                                                 _batch_read_u16(data + 4),
+                                                 string, format);
+                else if (opcode == LXW_BATCH_WRITE_FORMULA)
+                    err = worksheet_write_formula(self, _batch_read_u32(data),
+                                                  _batch_read_u16(data + 4),
+                                                  string, format);
+                else
+                    err = worksheet_merge_range(self, _batch_read_u32(data),
+                                                _batch_read_u16(data + 4),
+                                                _batch_read_u32(data + 6),
+                                                _batch_read_u16(data + 10),
+                                                string, format);
+                break;
+
+            case LXW_BATCH_WRITE_BLANK:
+                err = worksheet_write_blank(self, _batch_read_u32(data),
+                                            _batch_read_u16(data + 4),
+                                            format);
+                break;
+
+            case LXW_BATCH_WRITE_BOOLEAN:
+                err = worksheet_write_boolean(self, _batch_read_u32(data),
+                                              _batch_read_u16(data + 4),
+                                              data[6], format);
+                break;
+
+            case LXW_BATCH_WRITE_DATETIME:
+                datetime.year = _batch_read_u16(data + 6);
+                datetime.month = data[8];
+                datetime.day = data[9];
+                datetime.hour = data[10];
+                datetime.min = data[11];
+                datetime.sec = _batch_read_double(data + 12);
+
+                err = worksheet_write_datetime(self, _batch_read_u32(data),
+                                               _batch_read_u16(data + 4),
+                                               &datetime, format);
+                break;
 
+            case LXW_BATCH_SET_ROW:
+                err = worksheet_set_row(self, _batch_read_u32(data),
+                                        _batch_read_double(data + 4),
+                                        format);
+                break;
+        }
+
+        if (err)
+            goto error;
+    }
+
+    free(string);
     return LXW_NO_ERROR;
+
+mem_error:
+    err = LXW_ERROR_MEMORY_MALLOC_FAILED;
+
+error:
+    if (error_offset)
+        *error_offset = failed_offset;
+
+    free(string);
+    return err;
 }
 
 /*
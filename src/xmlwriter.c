@@ -395,6 +395,48 @@ _fprint_escaped_attributes(FILE *xmlfile,
     }
 }
 
+/*
+ * Write a single escaped attribute, without the intermediate attribute list
+ * and buffer used by the tag writing functions.
+ */
+void
+lxw_xml_escaped_attribute(FILE *xmlfile, const char *key, const char *value)
+{
+    size_t length;
+
+    fprintf(xmlfile, " %s=\"", key);
+
+    while (*value) {
+        length = strcspn(value, "&<>\"\n");
+        fwrite(value, 1, length, xmlfile);
+        value += length;
+
+        if (!*value)
+            break;
+
+        switch (*value) {
+            case '&':
+                fputs(LXW_AMP, xmlfile);
+                break;
+            case '<':
+                fputs(LXW_LT, xmlfile);
+                break;
+            case '>':
+                fputs(LXW_GT, xmlfile);
+                break;
+            case '"':
+                fputs(LXW_QUOT, xmlfile);
+                break;
+            default:
+                fputs(LXW_NL, xmlfile);
+                break;
+        }
+        value++;
+    }
+
+    fputc('"', xmlfile);
+}
+
 /* Write out escaped XML data. */
 STATIC void
 _fprint_escaped_data(FILE *xmlfile, const char *data)
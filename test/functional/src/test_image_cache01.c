@@ -0,0 +1,45 @@
+/*****************************************************************************
+ * Test cases for libxlsxwriter.
+ *
+ * Test to compare output against Excel files.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ * Copyright 2014-2025, John McNamara, jmcnamara@cpan.org.
+ *
+ */
+
+#include <stdio.h>
+#include "xlsxwriter.h"
+
+int main() {
+
+    lxw_workbook  *workbook;
+    lxw_worksheet *worksheet;
+    lxw_error      error;
+
+    lxw_image_cache_enable();
+
+    /* Write a first workbook to fill the image cache. */
+    workbook  = workbook_new("test_image_cache01_tmp.xlsx");
+    worksheet = workbook_add_worksheet(workbook, NULL);
+
+    worksheet_insert_image(worksheet, CELL("A1"), "images/red.png");
+
+    error = workbook_close(workbook);
+    remove("test_image_cache01_tmp.xlsx");
+
+    if (error)
+        return error;
+
+    /* The image properties and data should now come from the cache. */
+    workbook  = workbook_new("test_image_cache01.xlsx");
+    worksheet = workbook_add_worksheet(workbook, NULL);
+
+    worksheet_insert_image(worksheet, CELL("E9"), "images/red.png");
+
+    error = workbook_close(workbook);
+
+    lxw_image_cache_free();
+
+    return error;
+}
@@ -0,0 +1,28 @@
+/*****************************************************************************
+ * Test cases for libxlsxwriter.
+ *
+ * Test case for writing data in optimization mode.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ * Copyright 2014-2025, John McNamara, jmcnamara@cpan.org.
+ *
+ */
+
+#include "xlsxwriter.h"
+
+int main() {
+
+    lxw_workbook_options options = {.constant_memory = LXW_TRUE,
+                                    .binary_tmpfile = LXW_TRUE};
+
+    lxw_workbook  *workbook  = workbook_new_opt("test_optimize_binary02.xlsx", &options);
+    lxw_worksheet *worksheet = workbook_add_worksheet(workbook, NULL);
+    lxw_format    *bold      = workbook_add_format(workbook);
+
+    format_set_bold(bold);
+
+    worksheet_set_row(worksheet, 0, 20, bold);
+    worksheet_write_string(worksheet, 0, 0, "Foo", NULL);
+
+    return workbook_close(workbook);
+}
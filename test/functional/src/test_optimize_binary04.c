@@ -0,0 +1,54 @@
+/*****************************************************************************
+ * Test cases for libxlsxwriter.
+ *
+ * Test case for writing data in optimization mode.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ * Copyright 2014-2025, John McNamara, jmcnamara@cpan.org.
+ *
+ */
+
+#include "xlsxwriter.h"
+
+/* Write the same data with and without binary row records. The formats are
+ * only indexed by the cells that inherit the column and row formats so the
+ * styles must be indexed in the same order in both files. */
+static lxw_error
+write_workbook(const char *filename, uint8_t binary_tmpfile) {
+
+    lxw_workbook_options options = {.constant_memory = LXW_TRUE,
+                                    .binary_tmpfile = binary_tmpfile};
+
+    lxw_workbook  *workbook  = workbook_new_opt(filename, &options);
+    lxw_worksheet *worksheet = workbook_add_worksheet(workbook, NULL);
+
+    lxw_format    *bold      = workbook_add_format(workbook);
+    format_set_bold(bold);
+
+    lxw_format    *italic    = workbook_add_format(workbook);
+    format_set_italic(italic);
+
+    lxw_format    *underline = workbook_add_format(workbook);
+    format_set_underline(underline, LXW_UNDERLINE_SINGLE);
+
+    worksheet_set_column(worksheet, 2, 2, 8.43, italic);
+
+    worksheet_write_string(worksheet, 0, 2, "Foo", NULL);
+    worksheet_set_row(worksheet, 1, 15, bold);
+    worksheet_write_string(worksheet, 1, 0, "Bar", NULL);
+    worksheet_write_string(worksheet, 1, 2, "Baz", NULL);
+    worksheet_write_number(worksheet, 2, 1, 123, underline);
+    worksheet_write_number(worksheet, 2, 2, 456, NULL);
+
+    return workbook_close(workbook);
+}
+
+int main() {
+
+    lxw_error error = write_workbook("test_optimize_binary04.xlsx", LXW_TRUE);
+
+    if (error)
+        return error;
+
+    return write_workbook("test_optimize_binary04_text.xlsx", LXW_FALSE);
+}
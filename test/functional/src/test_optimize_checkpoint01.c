@@ -0,0 +1,64 @@
+/*****************************************************************************
+ * Test cases for libxlsxwriter.
+ *
+ * Test to compare output against Excel files.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ * Copyright 2014-2025, John McNamara, jmcnamara@cpan.org.
+ *
+ */
+
+#include "xlsxwriter.h"
+
+/* Create the workbook in the same way for the interrupted and resumed runs. */
+static lxw_workbook *create_workbook(lxw_format **bold, lxw_format **italic) {
+
+    lxw_workbook_options options = {.constant_memory = LXW_TRUE};
+
+    lxw_workbook  *workbook  = workbook_new_opt("test_optimize_checkpoint01.xlsx", &options);
+    workbook_set_checkpoint_dir(workbook, ".");
+    workbook_add_worksheet(workbook, NULL);
+
+    *bold = workbook_add_format(workbook);
+    *italic = workbook_add_format(workbook);
+
+    format_set_bold(*bold);
+    format_set_italic(*italic);
+
+    return workbook;
+}
+
+int main() {
+
+    lxw_format *bold;
+    lxw_format *italic;
+
+    /* Write a checkpoint and stop before the workbook is closed. */
+    lxw_workbook  *workbook  = create_workbook(&bold, &italic);
+    lxw_worksheet *worksheet = workbook_get_worksheet_by_name(workbook, "Sheet1");
+
+    worksheet_write_string(worksheet, CELL("A1"), "Foo", bold);
+    workbook_checkpoint(workbook);
+
+    worksheet_write_string(worksheet, CELL("A2"), "Lost", NULL);
+    worksheet_write_string(worksheet, CELL("A3"), "Lost", italic);
+    lxw_workbook_free(workbook);
+
+    /* Resume from the checkpoint and write the rest of the data. */
+    workbook  = create_workbook(&bold, &italic);
+    worksheet = workbook_get_worksheet_by_name(workbook, "Sheet1");
+
+    if (workbook_resume(workbook) || worksheet_get_resume_row(worksheet) != 1)
+        return 1;
+
+    worksheet_write_string(worksheet, CELL("A2"), "Bar", italic);
+
+    lxw_rich_string_tuple fragment1 = {.format = NULL, .string = "a"};
+    lxw_rich_string_tuple fragment2 = {.format = bold, .string = "bc"};
+    lxw_rich_string_tuple fragment3 = {.format = NULL, .string = "defg"};
+
+    lxw_rich_string_tuple *rich_strings[] = {&fragment1, &fragment2, &fragment3, NULL};
+    worksheet_write_rich_string(worksheet, CELL("A3"), rich_strings, NULL);
+
+    return workbook_close(workbook);
+}
@@ -0,0 +1,33 @@
+/*****************************************************************************
+ * Test cases for libxlsxwriter.
+ *
+ * Simple test case to test an incremental workbook close with images.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ * Copyright 2014-2025, John McNamara, jmcnamara@cpan.org.
+ *
+ */
+
+#include "xlsxwriter.h"
+
+int main() {
+
+    lxw_workbook  *workbook  = workbook_new("test_simple07.xlsx");
+    lxw_worksheet *worksheet = workbook_add_worksheet(workbook, NULL);
+    lxw_error error;
+
+    worksheet_insert_image(worksheet, CELL("B2"), "images/black_72.jpg");
+    worksheet_insert_image(worksheet, CELL("B8"), "images/black_96.jpg");
+    worksheet_insert_image(worksheet, CELL("B13"), "images/black_150.jpg");
+    worksheet_insert_image(worksheet, CELL("B17"), "images/black_300.jpg");
+
+    error = workbook_close_begin(workbook);
+    if (error)
+        return error;
+
+    do {
+        error = workbook_close_step(workbook, 1);
+    } while (error == LXW_CLOSE_IN_PROGRESS);
+
+    return error;
+}
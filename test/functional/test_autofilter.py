@@ -49,3 +49,12 @@ class TestCompareXLSXFiles(base_test_class.XLSXBaseTest):
 
     def test_autofilter11(self):
         self.run_exe_test('test_autofilter11')
+
+    def test_autofilter12(self):
+        self.run_exe_test('test_autofilter12', 'autofilter04.xlsx')
+
+    def test_autofilter13(self):
+        self.run_exe_test('test_autofilter13', 'autofilter08.xlsx')
+
+    def test_autofilter14(self):
+        self.run_exe_test('test_autofilter14', 'autofilter11.xlsx')
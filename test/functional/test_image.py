@@ -18,6 +18,9 @@ class TestCompareXLSXFiles(base_test_class.XLSXBaseTest):
     def test_image01(self):
         self.run_exe_test('test_image01')
 
+    def test_image_cache01(self):
+        self.run_exe_test('test_image_cache01', 'image01.xlsx')
+
     def test_image02(self):
         self.run_exe_test('test_image02')
 
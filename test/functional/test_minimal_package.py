@@ -0,0 +1,72 @@
+###############################################################################
+#
+# Tests for libxlsxwriter.
+#
+# SPDX-License-Identifier: BSD-2-Clause
+# Copyright 2014-2025, John McNamara, jmcnamara@cpan.org.
+#
+
+import posixpath
+import re
+from zipfile import ZipFile
+import base_test_class
+
+class TestCompareXLSXFiles(base_test_class.XLSXBaseTest):
+    """
+    Test file created with libxlsxwriter against a file created by Excel.
+
+    """
+
+    def run_minimal_test(self, exe_name, exp_filename):
+        # The optional parts aren't written and the package parts that refer
+        # to them differ. They are checked separately below.
+        self.ignore_files = ['docProps/app.xml',
+                             'docProps/core.xml',
+                             'xl/theme/theme1.xml',
+                             '[Content_Types].xml',
+                             '_rels/.rels',
+                             'xl/_rels/workbook.xml.rels']
+
+        self.run_exe_test(exe_name, exp_filename)
+
+        with ZipFile(self.got_filename, 'r') as got_zip:
+            self.check_package(got_zip)
+
+    def check_package(self, got_zip):
+        """Check that every part has a content type and every relationship
+        target exists in the package."""
+        names = set(got_zip.namelist())
+
+        for name in self.ignore_files[:3]:
+            self.assertNotIn(name, names)
+
+        content_types = got_zip.read('[Content_Types].xml').decode('utf-8')
+        defaults = re.findall(r'<Default Extension="([^"]+)"', content_types)
+        overrides = re.findall(r'<Override PartName="/([^"]+)"', content_types)
+
+        for part in overrides:
+            self.assertIn(part, names)
+
+        for name in names:
+            if name not in overrides:
+                self.assertIn(name.rsplit('.', 1)[-1], defaults)
+
+        for rels_name in [n for n in names if n.endswith('.rels')]:
+            base_dir = posixpath.dirname(posixpath.dirname(rels_name))
+            rels = got_zip.read(rels_name).decode('utf-8')
+
+            for target, mode in re.findall(r'Target="([^"]+)"( TargetMode)?',
+                                           rels):
+                if mode:
+                    continue
+                part = posixpath.normpath(posixpath.join(base_dir, target))
+                self.assertIn(part.lstrip('/'), names)
+
+    def test_minimal_package01(self):
+        self.run_minimal_test('test_minimal_package01', 'simple01.xlsx')
+
+    def test_minimal_package02(self):
+        self.run_minimal_test('test_minimal_package02', 'image01.xlsx')
+
+    def test_minimal_package03(self):
+        self.run_minimal_test('test_minimal_package03', 'chart_bar01.xlsx')
@@ -6,6 +6,7 @@
 # Copyright 2014-2025, John McNamara, jmcnamara@cpan.org.
 #
 
+import os
 import base_test_class
 
 class TestCompareXLSXFiles(base_test_class.XLSXBaseTest):
@@ -57,3 +58,24 @@ class TestCompareXLSXFiles(base_test_class.XLSXBaseTest):
 
     def test_optimize26(self):
         self.run_exe_test('test_optimize26')
+
+    def test_optimize_binary01(self):
+        self.run_exe_test('test_optimize_binary01', 'optimize04.xlsx')
+
+    def test_optimize_checkpoint01(self):
+        self.run_exe_test('test_optimize_checkpoint01', 'optimize04.xlsx')
+
+    def test_optimize_binary02(self):
+        self.run_exe_test('test_optimize_binary02', 'optimize24.xlsx')
+
+    def test_optimize_binary03(self):
+        self.run_exe_test('test_optimize_binary03', 'optimize14.xlsx')
+
+    def test_optimize_binary04(self):
+        # There isn't an Excel file with inherited row and column formats
+        # and inline strings so compare against the XML temp file output.
+        try:
+            self.run_exe_test('test_optimize_binary04',
+                              '../src/test_optimize_binary04_text.xlsx')
+        finally:
+            os.remove('test/functional/src/test_optimize_binary04_text.xlsx')
@@ -26,4 +26,11 @@ class TestCompareXLSXFiles(base_test_class.XLSXBaseTest):
     def test_simple04(self):
         self.run_exe_test('test_simple04')
 
+    def test_simple05(self):
+        self.run_exe_test('test_simple05', 'simple01.xlsx')
 
+    def test_simple06(self):
+        self.run_exe_test('test_simple06', 'simple01.xlsx')
+
+    def test_simple07(self):
+        self.run_exe_test('test_simple07', 'image23.xlsx')
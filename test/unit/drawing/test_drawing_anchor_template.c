@@ -0,0 +1,126 @@
+/*
+ * Tests for the lib_xlsx_writer library.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ * Copyright 2014-2025, John McNamara, jmcnamara@cpan.org.
+ *
+ */
+
+#include <string.h>
+#include "../ctest.h"
+#include "../helper.h"
+
+#include "../../../include/xlsxwriter/drawing.h"
+#include "../../../include/xlsxwriter/worksheet.h"
+
+/* Write an anchor with the element writers or the template writer. */
+static char *
+_write_anchor(lxw_drawing_object *drawing_object, uint8_t use_template)
+{
+    lxw_drawing drawing = {0};
+    long file_size;
+    char *data;
+
+    drawing.file = lxw_tmpfile(NULL);
+    drawing.embedded = LXW_TRUE;
+
+    if (use_template)
+        _drawing_write_two_cell_anchor_template(&drawing, 3, drawing_object);
+    else
+        _drawing_write_two_cell_anchor(&drawing, 3, drawing_object);
+
+    fflush(drawing.file);
+    file_size = ftell(drawing.file);
+
+    data = calloc(file_size + 1, 1);
+    rewind(drawing.file);
+    (void) fread(data, file_size, 1, drawing.file);
+    fclose(drawing.file);
+
+    return data;
+}
+
+// Test that the image template matches the element writers.
+CTEST(drawing, anchor_template01) {
+
+    char *exp;
+    char *got;
+    lxw_drawing_object drawing_object;
+
+    memset(&drawing_object, 0, sizeof(drawing_object));
+
+    drawing_object.type = LXW_DRAWING_IMAGE;
+    drawing_object.anchor = LXW_OBJECT_MOVE_DONT_SIZE;
+    drawing_object.from.col = 2;
+    drawing_object.from.row = 1;
+    drawing_object.to.col = 3;
+    drawing_object.to.col_offset = 533257;
+    drawing_object.to.row = 6;
+    drawing_object.to.row_offset = 190357;
+    drawing_object.col_absolute = 1219200;
+    drawing_object.row_absolute = 190500;
+    drawing_object.width = 1142857;
+    drawing_object.height = 1142857;
+    drawing_object.rel_index = 2;
+    drawing_object.description = "A & B <\"logo\">\nline 2";
+
+    ASSERT_TRUE(_drawing_has_anchor_template(&drawing_object));
+
+    exp = _write_anchor(&drawing_object, LXW_FALSE);
+    got = _write_anchor(&drawing_object, LXW_TRUE);
+
+    ASSERT_STR(exp, got);
+
+    free(exp);
+    free(got);
+}
+
+// Test that the chart template matches the element writers.
+CTEST(drawing, anchor_template02) {
+
+    char *exp;
+    char *got;
+    lxw_drawing_object drawing_object;
+
+    memset(&drawing_object, 0, sizeof(drawing_object));
+
+    drawing_object.type = LXW_DRAWING_CHART;
+    drawing_object.anchor = LXW_OBJECT_DONT_MOVE_DONT_SIZE;
+    drawing_object.from.col = 4;
+    drawing_object.from.col_offset = 457200;
+    drawing_object.from.row = 8;
+    drawing_object.from.row_offset = 104775;
+    drawing_object.to.col = 11;
+    drawing_object.to.col_offset = 152400;
+    drawing_object.to.row = 22;
+    drawing_object.to.row_offset = 180975;
+    drawing_object.rel_index = 5;
+
+    ASSERT_TRUE(_drawing_has_anchor_template(&drawing_object));
+
+    exp = _write_anchor(&drawing_object, LXW_FALSE);
+    got = _write_anchor(&drawing_object, LXW_TRUE);
+
+    ASSERT_STR(exp, got);
+
+    free(exp);
+    free(got);
+}
+
+// Test that objects with hyperlinks use the element writers.
+CTEST(drawing, anchor_template03) {
+
+    lxw_drawing_object drawing_object;
+
+    memset(&drawing_object, 0, sizeof(drawing_object));
+
+    drawing_object.type = LXW_DRAWING_IMAGE;
+    ASSERT_TRUE(_drawing_has_anchor_template(&drawing_object));
+
+    drawing_object.url_rel_index = 1;
+    ASSERT_FALSE(_drawing_has_anchor_template(&drawing_object));
+
+    drawing_object.url_rel_index = 0;
+    drawing_object.decorative = LXW_TRUE;
+    ASSERT_FALSE(_drawing_has_anchor_template(&drawing_object));
+}
@@ -0,0 +1,348 @@
+/*
+ * Tests for the libxlsxwriter library.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ * Copyright 2014-2025, John McNamara, jmcnamara@cpan.org.
+ *
+ */
+
+#include "../ctest.h"
+#include "../helper.h"
+
+#include "../../../include/xlsxwriter/worksheet.h"
+#include "../../../include/xlsxwriter/pivot_table.h"
+
+// Write a source range with a blank row and an unused column to a worksheet.
+static lxw_worksheet *
+_new_source_worksheet(void)
+{
+    lxw_worksheet *source = lxw_worksheet_new(NULL);
+    source->sst = lxw_sst_new();
+    source->name = "Data";
+
+    worksheet_write_string(source, 1, 1, "Region", NULL);
+    worksheet_write_string(source, 1, 2, "Sales", NULL);
+    worksheet_write_string(source, 1, 3, "Note", NULL);
+
+    worksheet_write_string(source, 2, 1, "East", NULL);
+    worksheet_write_number(source, 2, 2, 100, NULL);
+    worksheet_write_string(source, 2, 3, "A&B", NULL);
+
+    worksheet_write_string(source, 3, 1, "West", NULL);
+    worksheet_write_number(source, 3, 2, 2.5, NULL);
+
+    worksheet_write_string(source, 5, 1, "East", NULL);
+    worksheet_write_number(source, 5, 2, 50, NULL);
+    worksheet_write_boolean(source, 5, 3, 1, NULL);
+
+    return source;
+}
+
+// Add a pivot table with the Region row field and a sum of Sales.
+static lxw_pivot_table *
+_new_pivot_table(lxw_worksheet *worksheet, lxw_worksheet *source)
+{
+    const char *rows[] = {"Region", NULL};
+    lxw_pivot_data_field sales = {.field = "Sales"};
+    lxw_pivot_data_field *values[] = {&sales, NULL};
+    lxw_pivot_table_options options = {.source = source,
+                                       .first_row = 1, .first_col = 1,
+                                       .last_row = 5, .last_col = 3,
+                                       .row_fields = rows,
+                                       .data_fields = values};
+    lxw_pivot_table_obj *pivot_obj;
+    lxw_pivot_table *pivot_table;
+
+    worksheet_add_pivot_table(worksheet, 2, 0, &options);
+
+    pivot_obj = STAILQ_FIRST(worksheet->pivot_table_objs);
+    lxw_worksheet_prepare_pivot_tables(worksheet, 1);
+
+    pivot_table = lxw_pivot_table_new(pivot_obj);
+    lxw_pivot_table_build_cache(pivot_table);
+
+    return pivot_table;
+}
+
+static void
+_free_source_worksheet(lxw_worksheet *source)
+{
+    lxw_sst_free(source->sst);
+    source->name = NULL;
+    lxw_worksheet_free(source);
+}
+
+// Get the <location> element for a pivot table of the Region, Product,
+// Sales and Cost source data.
+static void
+_check_location(const char *exp, const char **rows, const char **columns,
+                lxw_pivot_data_field **values)
+{
+    char* got;
+    lxw_pivot_table_options options = {.first_row = 0, .first_col = 0,
+                                       .last_row = 4, .last_col = 3,
+                                       .row_fields = rows,
+                                       .column_fields = columns,
+                                       .data_fields = values};
+    lxw_pivot_table *pivot_table;
+    lxw_worksheet *source = lxw_worksheet_new(NULL);
+    lxw_worksheet *worksheet = lxw_worksheet_new(NULL);
+    FILE* testfile = lxw_tmpfile(NULL);
+
+    source->sst = lxw_sst_new();
+    source->name = "Data";
+
+    worksheet_write_string(source, 0, 0, "Region", NULL);
+    worksheet_write_string(source, 0, 1, "Product", NULL);
+    worksheet_write_string(source, 0, 2, "Sales", NULL);
+    worksheet_write_string(source, 0, 3, "Cost", NULL);
+
+    worksheet_write_string(source, 1, 0, "East", NULL);
+    worksheet_write_string(source, 2, 0, "West", NULL);
+    worksheet_write_string(source, 3, 0, "North", NULL);
+    worksheet_write_string(source, 4, 0, "East", NULL);
+
+    worksheet_write_string(source, 1, 1, "Apple", NULL);
+    worksheet_write_string(source, 2, 1, "Pear", NULL);
+    worksheet_write_string(source, 3, 1, "Apple", NULL);
+    worksheet_write_string(source, 4, 1, "Pear", NULL);
+
+    worksheet_write_number(source, 1, 2, 10, NULL);
+    worksheet_write_number(source, 2, 2, 20, NULL);
+    worksheet_write_number(source, 3, 2, 30, NULL);
+    worksheet_write_number(source, 4, 2, 40, NULL);
+
+    worksheet_write_number(source, 1, 3, 1, NULL);
+    worksheet_write_number(source, 2, 3, 2, NULL);
+    worksheet_write_number(source, 3, 3, 3, NULL);
+    worksheet_write_number(source, 4, 3, 4, NULL);
+
+    options.source = source;
+    worksheet_add_pivot_table(worksheet, 2, 0, &options);
+    lxw_worksheet_prepare_pivot_tables(worksheet, 1);
+
+    pivot_table = lxw_pivot_table_new(STAILQ_FIRST(worksheet->pivot_table_objs));
+    lxw_pivot_table_build_cache(pivot_table);
+    pivot_table->file = testfile;
+
+    _pivot_write_location(pivot_table);
+
+    RUN_XLSX_STREQ(exp, got);
+
+    lxw_pivot_table_free(pivot_table);
+    lxw_worksheet_free(worksheet);
+    _free_source_worksheet(source);
+}
+
+// Test assembling a complete pivotCacheDefinition file.
+CTEST(pivot_table, pivot_cache01) {
+
+    char* got;
+    char exp[] =
+            "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>\n"
+            "<pivotCacheDefinition xmlns=\"http://schemas.openxmlformats.org/spreadsheetml/2006/main\" xmlns:r=\"http://schemas.openxmlformats.org/officeDocument/2006/relationships\" r:id=\"rId1\" refreshOnLoad=\"1\" createdVersion=\"6\" refreshedVersion=\"6\" minRefreshableVersion=\"3\" recordCount=\"4\">"
+              "<cacheSource type=\"worksheet\"><worksheetSource ref=\"B2:D6\" sheet=\"Data\"/></cacheSource>"
+              "<cacheFields count=\"3\">"
+                "<cacheField name=\"Region\" numFmtId=\"0\">"
+                  "<sharedItems containsBlank=\"1\" count=\"3\"><s v=\"East\"/><s v=\"West\"/><m/></sharedItems>"
+                "</cacheField>"
+                "<cacheField name=\"Sales\" numFmtId=\"0\">"
+                  "<sharedItems containsString=\"0\" containsBlank=\"1\" containsNumber=\"1\" minValue=\"2.5\" maxValue=\"100\"/>"
+                "</cacheField>"
+                "<cacheField name=\"Note\" numFmtId=\"0\">"
+                  "<sharedItems containsBlank=\"1\" containsMixedTypes=\"1\"/>"
+                "</cacheField>"
+              "</cacheFields>"
+            "</pivotCacheDefinition>";
+
+    FILE* testfile = lxw_tmpfile(NULL);
+
+    lxw_worksheet *source = _new_source_worksheet();
+    lxw_worksheet *worksheet = lxw_worksheet_new(NULL);
+    lxw_pivot_table *pivot_table = _new_pivot_table(worksheet, source);
+    pivot_table->file = testfile;
+
+    lxw_pivot_cache_assemble_xml_file(pivot_table);
+
+    RUN_XLSX_STREQ_SHORT(exp, got);
+
+    lxw_pivot_table_free(pivot_table);
+    lxw_worksheet_free(worksheet);
+    _free_source_worksheet(source);
+}
+
+// Test assembling a complete pivotCacheRecords file.
+CTEST(pivot_table, pivot_records01) {
+
+    char* got;
+    char exp[] =
+            "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>\n"
+            "<pivotCacheRecords xmlns=\"http://schemas.openxmlformats.org/spreadsheetml/2006/main\" xmlns:r=\"http://schemas.openxmlformats.org/officeDocument/2006/relationships\" count=\"4\">"
+              "<r><x v=\"0\"/><n v=\"100\"/><s v=\"A&amp;B\"/></r>"
+              "<r><x v=\"1\"/><n v=\"2.5\"/><m/></r>"
+              "<r><x v=\"2\"/><m/><m/></r>"
+              "<r><x v=\"0\"/><n v=\"50\"/><b v=\"1\"/></r>"
+            "</pivotCacheRecords>";
+
+    FILE* testfile = lxw_tmpfile(NULL);
+
+    lxw_worksheet *source = _new_source_worksheet();
+    lxw_worksheet *worksheet = lxw_worksheet_new(NULL);
+    lxw_pivot_table *pivot_table = _new_pivot_table(worksheet, source);
+    pivot_table->file = testfile;
+
+    lxw_pivot_records_assemble_xml_file(pivot_table);
+
+    RUN_XLSX_STREQ_SHORT(exp, got);
+
+    lxw_pivot_table_free(pivot_table);
+    lxw_worksheet_free(worksheet);
+    _free_source_worksheet(source);
+}
+
+// Test assembling a complete pivotTableDefinition file.
+CTEST(pivot_table, pivot_table01) {
+
+    char* got;
+    char exp[] =
+            "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>\n"
+            "<pivotTableDefinition xmlns=\"http://schemas.openxmlformats.org/spreadsheetml/2006/main\" name=\"PivotTable1\" cacheId=\"1\" applyNumberFormats=\"0\" applyBorderFormats=\"0\" applyFontFormats=\"0\" applyPatternFormats=\"0\" applyAlignmentFormats=\"0\" applyWidthHeightFormats=\"1\" dataCaption=\"Values\" updatedVersion=\"6\" minRefreshableVersion=\"3\" useAutoFormatting=\"1\" itemPrintTitles=\"1\" createdVersion=\"6\" indent=\"0\" outline=\"1\" outlineData=\"1\" multipleFieldFilters=\"0\">"
+              "<location ref=\"A3:B7\" firstHeaderRow=\"1\" firstDataRow=\"1\" firstDataCol=\"1\"/>"
+              "<pivotFields count=\"3\">"
+                "<pivotField axis=\"axisRow\" showAll=\"0\"><items count=\"4\"><item x=\"0\"/><item x=\"1\"/><item x=\"2\"/><item t=\"default\"/></items></pivotField>"
+                "<pivotField dataField=\"1\" showAll=\"0\"/>"
+                "<pivotField showAll=\"0\"/>"
+              "</pivotFields>"
+              "<rowFields count=\"1\"><field x=\"0\"/></rowFields>"
+              "<rowItems count=\"4\"><i><x/></i><i><x v=\"1\"/></i><i><x v=\"2\"/></i><i t=\"grand\"><x/></i></rowItems>"
+              "<colItems count=\"1\"><i/></colItems>"
+              "<dataFields count=\"1\"><dataField name=\"Sum of Sales\" fld=\"1\" baseField=\"0\" baseItem=\"0\"/></dataFields>"
+              "<pivotTableStyleInfo name=\"PivotStyleLight16\" showRowHeaders=\"1\" showColHeaders=\"1\" showRowStripes=\"0\" showColStripes=\"0\" showLastColumn=\"1\"/>"
+            "</pivotTableDefinition>";
+
+    FILE* testfile = lxw_tmpfile(NULL);
+
+    lxw_worksheet *source = _new_source_worksheet();
+    lxw_worksheet *worksheet = lxw_worksheet_new(NULL);
+    lxw_pivot_table *pivot_table = _new_pivot_table(worksheet, source);
+    pivot_table->file = testfile;
+
+    lxw_pivot_table_assemble_xml_file(pivot_table);
+
+    RUN_XLSX_STREQ_SHORT(exp, got);
+
+    lxw_pivot_table_free(pivot_table);
+    lxw_worksheet_free(worksheet);
+    _free_source_worksheet(source);
+}
+
+// Test the <location> element for the combinations of axes.
+CTEST(pivot_table, pivot_location01) {
+
+    const char *regions[] = {"Region", NULL};
+    const char *products[] = {"Product", NULL};
+    lxw_pivot_data_field sales = {.field = "Sales"};
+    lxw_pivot_data_field cost = {.field = "Cost"};
+    lxw_pivot_data_field *one_value[] = {&sales, NULL};
+    lxw_pivot_data_field *two_values[] = {&sales, &cost, NULL};
+
+    /* Row field and one value: header, 3 items and the grand total. */
+    _check_location("<location ref=\"A3:B7\" firstHeaderRow=\"1\" firstDataRow=\"1\" firstDataCol=\"1\"/>",
+                    regions, NULL, one_value);
+
+    /* Row field and two values: the value captions are the column items. */
+    _check_location("<location ref=\"A3:C7\" firstHeaderRow=\"0\" firstDataRow=\"1\" firstDataCol=\"1\"/>",
+                    regions, NULL, two_values);
+
+    /* Row and column fields: "Column Labels" and column item rows. */
+    _check_location("<location ref=\"A3:D8\" firstHeaderRow=\"1\" firstDataRow=\"2\" firstDataCol=\"1\"/>",
+                    regions, products, one_value);
+
+    /* Row and column fields and two values: an extra value caption row. */
+    _check_location("<location ref=\"A3:G9\" firstHeaderRow=\"1\" firstDataRow=\"3\" firstDataCol=\"1\"/>",
+                    regions, products, two_values);
+
+    /* Column field only. */
+    _check_location("<location ref=\"A3:C5\" firstHeaderRow=\"1\" firstDataRow=\"2\" firstDataCol=\"0\"/>",
+                    NULL, products, one_value);
+
+    /* Values only. */
+    _check_location("<location ref=\"A3:A4\" firstHeaderRow=\"1\" firstDataRow=\"1\" firstDataCol=\"0\"/>",
+                    NULL, NULL, one_value);
+
+    _check_location("<location ref=\"A3:B4\" firstHeaderRow=\"0\" firstDataRow=\"1\" firstDataCol=\"0\"/>",
+                    NULL, NULL, two_values);
+}
+
+// Test the pivot table source validation.
+CTEST(pivot_table, add_pivot_table01) {
+
+    lxw_pivot_table_options options = {0};
+    lxw_worksheet_init_data init_data = {0};
+    lxw_worksheet *worksheet = lxw_worksheet_new(NULL);
+    lxw_worksheet *source;
+
+    init_data.optimize = LXW_TRUE;
+    source = lxw_worksheet_new(&init_data);
+
+    ASSERT_EQUAL(LXW_ERROR_NULL_PARAMETER_IGNORED,
+                 worksheet_add_pivot_table(worksheet, 0, 0, &options));
+
+    options.source = source;
+    ASSERT_EQUAL(LXW_ERROR_FEATURE_NOT_SUPPORTED,
+                 worksheet_add_pivot_table(worksheet, 0, 0, &options));
+
+    ASSERT_EQUAL(0, worksheet->pivot_table_count);
+
+    lxw_worksheet_free(source);
+    lxw_worksheet_free(worksheet);
+}
+
+// Test the validation of the field names against the source header row.
+CTEST(pivot_table, add_pivot_table02) {
+
+    const char *rows[] = {"Region", NULL};
+    const char *unknown_rows[] = {"Country", NULL};
+    const char *duplicate_rows[] = {"Region", "Region", NULL};
+    lxw_pivot_data_field sales = {.field = "Sales2"};
+    lxw_pivot_data_field *values[] = {&sales, NULL};
+    lxw_pivot_table_options options = {.first_row = 1, .first_col = 1,
+                                       .last_row = 5, .last_col = 3,
+                                       .row_fields = unknown_rows};
+    lxw_pivot_table *pivot_table;
+
+    lxw_worksheet *source = _new_source_worksheet();
+    lxw_worksheet *worksheet = lxw_worksheet_new(NULL);
+
+    options.source = source;
+
+    ASSERT_EQUAL(LXW_ERROR_PARAMETER_VALIDATION,
+                 worksheet_add_pivot_table(worksheet, 2, 0, &options));
+
+    options.row_fields = duplicate_rows;
+    ASSERT_EQUAL(LXW_ERROR_PARAMETER_VALIDATION,
+                 worksheet_add_pivot_table(worksheet, 2, 0, &options));
+
+    /* Duplicate header names are made unique, as in Excel. */
+    options.row_fields = rows;
+    options.data_fields = values;
+    ASSERT_EQUAL(LXW_ERROR_PARAMETER_VALIDATION,
+                 worksheet_add_pivot_table(worksheet, 2, 0, &options));
+
+    ASSERT_EQUAL(0, worksheet->pivot_table_count);
+
+    worksheet_write_string(source, 1, 3, "Sales", NULL);
+
+    ASSERT_EQUAL(LXW_NO_ERROR,
+                 worksheet_add_pivot_table(worksheet, 2, 0, &options));
+
+    pivot_table = lxw_pivot_table_new(STAILQ_FIRST(worksheet->pivot_table_objs));
+
+    ASSERT_STR("Sales", pivot_table->fields[1].name);
+    ASSERT_STR("Sales2", pivot_table->fields[2].name);
+    ASSERT_EQUAL(2, pivot_table->data_fields[0]);
+
+    lxw_pivot_table_free(pivot_table);
+    lxw_worksheet_free(worksheet);
+    _free_source_worksheet(source);
+}
@@ -0,0 +1,56 @@
+/*
+ * Tests for the libxlsxwriter library.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ * Copyright 2014-2025, John McNamara, jmcnamara@cpan.org.
+ *
+ */
+
+#include "../ctest.h"
+#include "../helper.h"
+
+#include "../../../include/xlsxwriter/utility.h"
+
+
+// Test lxw_round_dbl().
+CTEST(utility, lxw_round_dbl) {
+
+    lxw_number_precision full = {LXW_PRECISION_FULL, 0};
+    lxw_number_precision sig15 = {LXW_PRECISION_SIGNIFICANT_DIGITS, 15};
+    lxw_number_precision sig3 = {LXW_PRECISION_SIGNIFICANT_DIGITS, 3};
+    lxw_number_precision dp0 = {LXW_PRECISION_DECIMAL_PLACES, 0};
+    lxw_number_precision dp2 = {LXW_PRECISION_DECIMAL_PLACES, 2};
+
+    ASSERT_TRUE(0.1 + 0.2 == lxw_round_dbl(0.1 + 0.2, &full));
+    ASSERT_TRUE(0.1 + 0.2 == lxw_round_dbl(0.1 + 0.2, NULL));
+    ASSERT_TRUE(0.3 == lxw_round_dbl(0.1 + 0.2, &sig15));
+
+    ASSERT_TRUE(123.0 == lxw_round_dbl(123.456, &sig3));
+    ASSERT_TRUE(-0.00123 == lxw_round_dbl(-0.0012345, &sig3));
+    ASSERT_TRUE(12300000.0 == lxw_round_dbl(12345678.9, &sig3));
+
+    // Ties are rounded to even.
+    ASSERT_TRUE(2.0 == lxw_round_dbl(2.5, &dp0));
+    ASSERT_TRUE(4.0 == lxw_round_dbl(3.5, &dp0));
+    ASSERT_TRUE(-2.0 == lxw_round_dbl(-2.5, &dp0));
+    ASSERT_TRUE(0.12 == lxw_round_dbl(0.125, &dp2));
+    ASSERT_TRUE(1.24 == lxw_round_dbl(1.2350001, &dp2));
+
+    ASSERT_TRUE(0.0 == lxw_round_dbl(0.0, &sig3));
+    ASSERT_TRUE(1e300 == lxw_round_dbl(1e300, &dp2));
+}
+
+// Test lxw_validate_number_precision().
+CTEST(utility, lxw_validate_number_precision) {
+
+    ASSERT_EQUAL(LXW_NO_ERROR,
+                 lxw_validate_number_precision(LXW_PRECISION_FULL, 0));
+    ASSERT_EQUAL(LXW_NO_ERROR,
+                 lxw_validate_number_precision(LXW_PRECISION_DECIMAL_PLACES, 0));
+    ASSERT_EQUAL(LXW_ERROR_PARAMETER_VALIDATION,
+                 lxw_validate_number_precision(LXW_PRECISION_SIGNIFICANT_DIGITS, 0));
+    ASSERT_EQUAL(LXW_ERROR_PARAMETER_VALIDATION,
+                 lxw_validate_number_precision(LXW_PRECISION_DECIMAL_PLACES, 16));
+    ASSERT_EQUAL(LXW_ERROR_PARAMETER_VALIDATION,
+                 lxw_validate_number_precision(9, 1));
+}
@@ -0,0 +1,30 @@
+/*
+ * Tests for the libxlsxwriter library.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ * Copyright 2014-2025, John McNamara, jmcnamara@cpan.org.
+ *
+ */
+
+#include "../ctest.h"
+#include "../helper.h"
+
+#include "../../../include/xlsxwriter/utility.h"
+
+
+// Test lxw_strtod().
+CTEST(utility, lxw_strtod) {
+
+    const char *number = "-12.5E2xyz";
+    char *end;
+
+    ASSERT_DBL_NEAR(-1250, lxw_strtod(number, &end));
+    ASSERT_STR("xyz", end);
+
+    ASSERT_DBL_NEAR(0.25, lxw_strtod(".25", NULL));
+    ASSERT_DBL_NEAR(3, lxw_strtod("3", NULL));
+
+    number = "1,5";
+    ASSERT_DBL_NEAR(1, lxw_strtod(number, &end));
+    ASSERT_STR(",5", end);
+}
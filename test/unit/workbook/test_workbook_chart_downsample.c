@@ -0,0 +1,149 @@
+/*
+ * Tests for the libxlsxwriter library.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ * Copyright 2014-2025, John McNamara, jmcnamara@cpan.org.
+ *
+ */
+
+#include "../ctest.h"
+#include "../helper.h"
+
+#include "../../../include/xlsxwriter/workbook.h"
+
+/* Test the selection of the points to plot for a downsampled series. */
+CTEST(workbook, chart_downsample01) {
+
+    double x[10] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
+    double y[10] = {0, 0, 9, 0, 0, 0, -9, 0, 0, 0};
+    uint32_t indices[10];
+    uint32_t count;
+
+    /* The first and last points are kept along with the peaks. */
+    count = _chart_downsample_lttb(x, y, 10, indices, 4);
+    ASSERT_EQUAL(4, count);
+    ASSERT_EQUAL(0, indices[0]);
+    ASSERT_EQUAL(2, indices[1]);
+    ASSERT_EQUAL(6, indices[2]);
+    ASSERT_EQUAL(9, indices[3]);
+
+    /* The minimum and maximum of each bucket are kept in order. */
+    count = _chart_downsample_min_max(y, 10, indices, 4);
+    ASSERT_EQUAL(4, count);
+    ASSERT_EQUAL(0, indices[0]);
+    ASSERT_EQUAL(2, indices[1]);
+    ASSERT_EQUAL(5, indices[2]);
+    ASSERT_EQUAL(6, indices[3]);
+}
+
+/* Test storing the downsampled series data in a hidden worksheet. */
+CTEST(workbook, chart_downsample02) {
+
+    lxw_cell_value value;
+    lxw_chart_series *series1;
+    lxw_chart_series *series2;
+    lxw_chart_series *series3;
+    lxw_workbook *workbook = workbook_new(NULL);
+    lxw_worksheet *worksheet = workbook_add_worksheet(workbook, NULL);
+    lxw_worksheet *data;
+    lxw_chart *chart = workbook_add_chart(workbook, LXW_CHART_LINE);
+    int i;
+
+    for (i = 0; i < 100; i++) {
+        worksheet_write_number(worksheet, i, 0, i * 2, NULL);
+        worksheet_write_number(worksheet, i, 1, i == 50 ? 1000 : i % 3,
+                               NULL);
+    }
+
+    series1 = chart_add_series(chart, "=Sheet1!$A$1:$A$100",
+                               "=Sheet1!$B$1:$B$100");
+    series2 = chart_add_series(chart, NULL, "=Sheet1!$B$1:$B$100");
+    series3 = chart_add_series(chart, NULL, "=Sheet1!$B$1:$B$10");
+
+    ASSERT_EQUAL(LXW_ERROR_PARAMETER_VALIDATION,
+                 chart_series_set_downsample(series1,
+                                             LXW_CHART_DOWNSAMPLE_LTTB, 2));
+    ASSERT_EQUAL(LXW_NO_ERROR,
+                 chart_series_set_downsample(series1,
+                                             LXW_CHART_DOWNSAMPLE_LTTB, 10));
+    ASSERT_EQUAL(LXW_NO_ERROR,
+                 chart_series_set_downsample(series2,
+                                             LXW_CHART_DOWNSAMPLE_MIN_MAX,
+                                             20));
+    ASSERT_EQUAL(LXW_NO_ERROR,
+                 chart_series_set_downsample(series3,
+                                             LXW_CHART_DOWNSAMPLE_LTTB, 10));
+
+    ASSERT_EQUAL(LXW_NO_ERROR, _prepare_chart_downsampling(workbook));
+
+    data = workbook_get_worksheet_by_name(workbook, "_ChartData");
+    ASSERT_TRUE(data != NULL);
+    ASSERT_TRUE(data->hidden);
+
+    ASSERT_STR("_ChartData!$A$1:$A$10", series1->categories->formula);
+    ASSERT_STR("_ChartData!$B$1:$B$10", series1->values->formula);
+    ASSERT_STR("_ChartData!$C$1:$C$20", series2->categories->formula);
+    ASSERT_STR("_ChartData!$D$1:$D$20", series2->values->formula);
+
+    /* Series that are short enough are unchanged. */
+    ASSERT_STR("Sheet1!$B$1:$B$10", series3->values->formula);
+    ASSERT_NULL(series3->categories->formula);
+
+    /* The first and last points and the peak are kept. */
+    worksheet_get_cell(data, 0, 0, &value);
+    ASSERT_DBL_NEAR(0, value.number);
+
+    worksheet_get_cell(data, 9, 0, &value);
+    ASSERT_DBL_NEAR(198, value.number);
+
+    for (i = 0; i < 10; i++) {
+        worksheet_get_cell(data, i, 1, &value);
+        if (value.number == 1000)
+            break;
+    }
+    ASSERT_TRUE(i < 10);
+
+    /* Series without categories use the position of the point. */
+    worksheet_get_cell(data, 0, 2, &value);
+    ASSERT_DBL_NEAR(1, value.number);
+
+    /* The original data is unchanged. */
+    worksheet_get_cell(worksheet, 50, 1, &value);
+    ASSERT_DBL_NEAR(1000, value.number);
+
+    lxw_workbook_free(workbook);
+}
+
+/* Test the series that are plotted unchanged. */
+CTEST(workbook, chart_downsample03) {
+
+    lxw_chart_series *series1;
+    lxw_chart_series *series2;
+    lxw_workbook *workbook = workbook_new(NULL);
+    lxw_worksheet *worksheet = workbook_add_worksheet(workbook, NULL);
+    lxw_chart *column = workbook_add_chart(workbook, LXW_CHART_COLUMN);
+    lxw_chart *line = workbook_add_chart(workbook, LXW_CHART_LINE);
+    int i;
+
+    for (i = 0; i < 100; i++) {
+        worksheet_write_number(worksheet, i, 0, i, NULL);
+        worksheet_write_formula_num(worksheet, i, 1, "=A1*2", NULL, i * 2);
+    }
+
+    /* Only line and scatter charts are downsampled. */
+    series1 = chart_add_series(column, NULL, "=Sheet1!$A$1:$A$100");
+    chart_series_set_downsample(series1, LXW_CHART_DOWNSAMPLE_LTTB, 10);
+
+    /* Formula results aren't known until Excel recalculates. */
+    series2 = chart_add_series(line, NULL, "=Sheet1!$B$1:$B$100");
+    chart_series_set_downsample(series2, LXW_CHART_DOWNSAMPLE_LTTB, 10);
+
+    ASSERT_EQUAL(LXW_NO_ERROR, _prepare_chart_downsampling(workbook));
+
+    ASSERT_NULL(workbook_get_worksheet_by_name(workbook, "_ChartData"));
+    ASSERT_STR("Sheet1!$A$1:$A$100", series1->values->formula);
+    ASSERT_STR("Sheet1!$B$1:$B$100", series2->values->formula);
+    ASSERT_EQUAL(LXW_CHART_DOWNSAMPLE_NONE, series1->downsample);
+
+    lxw_workbook_free(workbook);
+}
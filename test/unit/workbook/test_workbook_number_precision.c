@@ -0,0 +1,48 @@
+/*
+ * Tests for the libxlsxwriter library.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ * Copyright 2014-2025, John McNamara, jmcnamara@cpan.org.
+ *
+ */
+
+#include "../ctest.h"
+#include "../helper.h"
+
+#include "../../../include/xlsxwriter/workbook.h"
+
+/* Test that the chart cache uses the column precision of the data. */
+CTEST(workbook, number_precision01) {
+
+    lxw_series_data_point *data_point;
+    lxw_workbook *workbook = workbook_new(NULL);
+    lxw_worksheet *worksheet = workbook_add_worksheet(workbook, NULL);
+    lxw_chart *chart = workbook_add_chart(workbook, LXW_CHART_LINE);
+    lxw_chart_series *series;
+
+    workbook_set_number_precision(workbook,
+                                  LXW_PRECISION_SIGNIFICANT_DIGITS, 3);
+    worksheet_set_column_precision(worksheet, 1, 1,
+                                   LXW_PRECISION_DECIMAL_PLACES, 2);
+
+    worksheet_write_number(worksheet, 0, 0, 1.23456, NULL);
+    worksheet_write_number(worksheet, 0, 1, 3.14159, NULL);
+
+    series = chart_add_series(chart, "=Sheet1!$A$1:$A$1",
+                              "=Sheet1!$B$1:$B$1");
+
+    _populate_range(workbook, series->categories);
+    _populate_range(workbook, series->values);
+
+    /* The category column uses the workbook precision. */
+    data_point = STAILQ_FIRST(series->categories->data_cache);
+    ASSERT_EQUAL(LXW_PRECISION_DEFAULT, data_point->precision.type);
+
+    data_point = STAILQ_FIRST(series->values->data_cache);
+    ASSERT_EQUAL(LXW_PRECISION_DECIMAL_PLACES, data_point->precision.type);
+    ASSERT_EQUAL(2, data_point->precision.digits);
+    ASSERT_DBL_NEAR(3.14, lxw_round_dbl(data_point->number,
+                                        &data_point->precision));
+
+    lxw_workbook_free(workbook);
+}
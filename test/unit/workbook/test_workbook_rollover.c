@@ -0,0 +1,245 @@
+/*
+ * Tests for the libxlsxwriter library.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ * Copyright 2014-2025, John McNamara, jmcnamara@cpan.org.
+ *
+ */
+
+#include "../ctest.h"
+#include "../helper.h"
+
+#include "../../../include/xlsxwriter/workbook.h"
+
+/* Test continuing a worksheet on rollover worksheets. */
+CTEST(workbook, rollover01) {
+
+    lxw_cell_value value;
+    lxw_rollover_options options = {.max_rows = 3, .header_rows = 1};
+    lxw_row_t row;
+
+    lxw_workbook *workbook = workbook_new(NULL);
+    lxw_worksheet *worksheet = workbook_add_worksheet(workbook, "Data");
+    lxw_worksheet *rollover2;
+    lxw_worksheet *rollover3;
+    lxw_format *bold = workbook_add_format(workbook);
+
+    ASSERT_EQUAL(LXW_NO_ERROR, worksheet_set_rollover(worksheet, &options));
+
+    worksheet_set_column(worksheet, 0, 1, 20, NULL);
+    worksheet_write_string(worksheet, 0, 0, "Name", bold);
+
+    for (row = 1; row <= 5; row++)
+        ASSERT_EQUAL(LXW_NO_ERROR,
+                     worksheet_write_number(worksheet, row, 0, row, NULL));
+
+    rollover2 = workbook_get_worksheet_by_name(workbook, "Data (2)");
+    rollover3 = workbook_get_worksheet_by_name(workbook, "Data (3)");
+
+    ASSERT_TRUE(rollover2 != NULL);
+    ASSERT_TRUE(rollover3 != NULL);
+    ASSERT_EQUAL(3, workbook->num_worksheets);
+
+    ASSERT_EQUAL(2, worksheet->dim_rowmax);
+    ASSERT_EQUAL(2, rollover2->dim_rowmax);
+    ASSERT_EQUAL(1, rollover3->dim_rowmax);
+
+    worksheet_get_cell(rollover2, 0, 0, &value);
+    ASSERT_EQUAL(LXW_CELL_VALUE_STRING, value.type);
+    ASSERT_STR("Name", value.string);
+    ASSERT_TRUE(value.format == bold);
+
+    worksheet_get_cell(rollover2, 2, 0, &value);
+    ASSERT_DBL_NEAR(4, value.number);
+
+    worksheet_get_cell(rollover3, 1, 0, &value);
+    ASSERT_DBL_NEAR(5, value.number);
+
+    ASSERT_TRUE(rollover3->col_options[0] != NULL);
+    ASSERT_EQUAL(1, rollover3->col_options[0]->lastcol);
+    ASSERT_DBL_NEAR(20, rollover3->col_options[0]->width);
+
+    lxw_workbook_free(workbook);
+}
+
+/* Test the rollover worksheet names and the default row limit. */
+CTEST(workbook, rollover02) {
+
+    lxw_rollover_options options = {0};
+    const char *name = "1234567890123456789012345678901";
+
+    lxw_workbook *workbook = workbook_new(NULL);
+    lxw_worksheet *worksheet = workbook_add_worksheet(workbook, name);
+
+    ASSERT_EQUAL(LXW_ERROR_WORKSHEET_INDEX_OUT_OF_RANGE,
+                 worksheet_write_number(worksheet, LXW_ROW_MAX, 0, 1, NULL));
+
+    ASSERT_EQUAL(LXW_NO_ERROR, worksheet_set_rollover(worksheet, &options));
+    ASSERT_EQUAL(LXW_NO_ERROR,
+                 worksheet_write_number(worksheet, LXW_ROW_MAX, 0, 1, NULL));
+
+    ASSERT_TRUE(workbook_get_worksheet_by_name(workbook,
+                                               "123456789012345678901234567 (2)")
+                != NULL);
+
+    options.header_rows = 3;
+    options.max_rows = 3;
+    ASSERT_EQUAL(LXW_ERROR_PARAMETER_VALIDATION,
+                 worksheet_set_rollover(worksheet, &options));
+
+    lxw_workbook_free(workbook);
+}
+
+/* Test rollover worksheets in constant_memory mode. */
+CTEST(workbook, rollover03) {
+
+    lxw_cell_value value;
+    lxw_rollover_options options = {.max_rows = 4, .header_rows = 2};
+    lxw_workbook_options workbook_options = {.constant_memory = LXW_TRUE};
+    lxw_row_t row;
+
+    lxw_workbook *workbook = workbook_new_opt(NULL, &workbook_options);
+    lxw_worksheet *worksheet = workbook_add_worksheet(workbook, NULL);
+    lxw_worksheet *rollover;
+
+    ASSERT_EQUAL(LXW_NO_ERROR, worksheet_set_rollover(worksheet, &options));
+
+    worksheet_write_string(worksheet, 0, 0, "Title", NULL);
+    worksheet_write_string(worksheet, 1, 0, "Name", NULL);
+
+    for (row = 2; row <= 5; row++)
+        ASSERT_EQUAL(LXW_NO_ERROR,
+                     worksheet_write_number(worksheet, row, 0, row, NULL));
+
+    rollover = workbook_get_worksheet_by_name(workbook, "Sheet1 (2)");
+    ASSERT_TRUE(rollover != NULL);
+
+    ASSERT_EQUAL(3, worksheet->dim_rowmax);
+    ASSERT_EQUAL(3, rollover->dim_rowmax);
+
+    ASSERT_EQUAL(0, rollover->dim_rowmin);
+
+    worksheet_get_cell(rollover, 3, 0, &value);
+    ASSERT_DBL_NEAR(5, value.number);
+
+    ASSERT_EQUAL(LXW_ERROR_WORKSHEET_INDEX_OUT_OF_RANGE,
+                 worksheet_write_number(worksheet, 4, 0, 4, NULL));
+
+    lxw_workbook_free(workbook);
+}
+
+/* Test accumulating into rollover rows and rollover name clashes. */
+CTEST(workbook, rollover04) {
+
+    lxw_cell_value value;
+    lxw_rollover_options options = {.max_rows = 2};
+
+    lxw_workbook *workbook = workbook_new(NULL);
+    lxw_worksheet *worksheet = workbook_add_worksheet(workbook, "Data");
+    lxw_worksheet *rollover;
+    lxw_worksheet *other = workbook_add_worksheet(workbook, "Other");
+
+    ASSERT_EQUAL(LXW_NO_ERROR, worksheet_set_rollover(worksheet, &options));
+
+    ASSERT_EQUAL(LXW_NO_ERROR,
+                 worksheet_accumulate_number(worksheet, 3, 0, 1, NULL));
+    ASSERT_EQUAL(LXW_NO_ERROR,
+                 worksheet_accumulate_number(worksheet, 3, 0, 2, NULL));
+
+    rollover = workbook_get_worksheet_by_name(workbook, "Data (2)");
+    ASSERT_TRUE(rollover != NULL);
+
+    worksheet_get_cell(rollover, 1, 0, &value);
+    ASSERT_DBL_NEAR(3, value.number);
+
+    /* The name of the next rollover worksheet is already used. */
+    workbook_add_worksheet(workbook, "Other (2)");
+
+    ASSERT_EQUAL(LXW_NO_ERROR, worksheet_set_rollover(other, &options));
+    ASSERT_EQUAL(LXW_ERROR_SHEETNAME_ALREADY_USED,
+                 worksheet_write_number(other, 2, 0, 1, NULL));
+
+    lxw_workbook_free(workbook);
+}
+
+/* Test the column statistics of rows written past the rollover row. */
+CTEST(workbook, rollover05) {
+
+    lxw_column_stats stats;
+    lxw_rollover_options options = {.max_rows = 3, .header_rows = 1};
+    lxw_row_t row;
+
+    lxw_workbook *workbook = workbook_new(NULL);
+    lxw_worksheet *worksheet = workbook_add_worksheet(workbook, NULL);
+
+    ASSERT_EQUAL(LXW_NO_ERROR, worksheet_set_rollover(worksheet, &options));
+
+    worksheet_write_string(worksheet, 0, 0, "Value", NULL);
+    worksheet_write_number(worksheet, 1, 0, 1, NULL);
+
+    /* The statistics are shared with existing rollover worksheets. */
+    worksheet_write_number(worksheet, 3, 0, 3, NULL);
+    ASSERT_EQUAL(LXW_NO_ERROR,
+                 worksheet_track_column_stats(worksheet, 1, 0, 6, 0));
+
+    for (row = 1; row <= 7; row++)
+        worksheet_write_number(worksheet, row, 0, row, NULL);
+
+    worksheet_get_column_stats(worksheet, 0, &stats);
+
+    ASSERT_EQUAL(6, stats.number_count);
+    ASSERT_DBL_NEAR(21, stats.sum);
+    ASSERT_DBL_NEAR(1, stats.min);
+    ASSERT_DBL_NEAR(6, stats.max);
+
+    lxw_workbook_free(workbook);
+}
+
+/* Test that objects and ranges past the rollover limit are rejected. */
+CTEST(workbook, rollover06) {
+
+    lxw_rollover_options options = {.max_rows = 10, .header_rows = 1};
+    lxw_data_validation validation = {.validate = LXW_VALIDATION_TYPE_INTEGER,
+                                      .criteria = LXW_VALIDATION_CRITERIA_GREATER_THAN,
+                                      .value_number = 0};
+    lxw_conditional_format cond_format = {.type = LXW_CONDITIONAL_TYPE_BLANKS};
+
+    lxw_workbook *workbook = workbook_new(NULL);
+    lxw_worksheet *worksheet = workbook_add_worksheet(workbook, "Data");
+    lxw_chart *chart = workbook_add_chart(workbook, LXW_CHART_LINE);
+
+    chart_add_series(chart, NULL, "=Data!$A$1:$A$5");
+
+    ASSERT_EQUAL(LXW_NO_ERROR, worksheet_set_rollover(worksheet, &options));
+
+    ASSERT_EQUAL(LXW_ERROR_WORKSHEET_INDEX_OUT_OF_RANGE,
+                 worksheet_write_comment(worksheet, 16, 0, "Comment"));
+
+    ASSERT_EQUAL(LXW_ERROR_WORKSHEET_INDEX_OUT_OF_RANGE,
+                 worksheet_data_validation_cell(worksheet, 16, 0,
+                                                &validation));
+
+    ASSERT_EQUAL(LXW_ERROR_WORKSHEET_INDEX_OUT_OF_RANGE,
+                 worksheet_conditional_format_cell(worksheet, 16, 0,
+                                                   &cond_format));
+
+    /* Ranges that cross the limit are also rejected. */
+    ASSERT_EQUAL(LXW_ERROR_WORKSHEET_INDEX_OUT_OF_RANGE,
+                 worksheet_merge_range(worksheet, 8, 0, 12, 1, "Merge",
+                                       NULL));
+
+    ASSERT_EQUAL(LXW_ERROR_WORKSHEET_INDEX_OUT_OF_RANGE,
+                 worksheet_insert_chart(worksheet, 16, 0, chart));
+
+    ASSERT_EQUAL(LXW_ERROR_WORKSHEET_INDEX_OUT_OF_RANGE,
+                 worksheet_insert_image(worksheet, 16, 0,
+                                        "images/red.png"));
+
+    /* Rows within the limit aren't affected. */
+    ASSERT_EQUAL(LXW_NO_ERROR,
+                 worksheet_write_comment(worksheet, 9, 0, "Comment"));
+
+    ASSERT_NULL(workbook_get_worksheet_by_name(workbook, "Data (2)"));
+
+    lxw_workbook_free(workbook);
+}
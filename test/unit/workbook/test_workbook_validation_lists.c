@@ -0,0 +1,219 @@
+/*
+ * Tests for the libxlsxwriter library.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ * Copyright 2014-2025, John McNamara, jmcnamara@cpan.org.
+ *
+ */
+
+#include "../ctest.h"
+#include "../helper.h"
+
+#include "../../../include/xlsxwriter/workbook.h"
+#include "../../../include/xlsxwriter/packager.h"
+
+/* Test storing the shared data validation lists in a hidden worksheet. */
+CTEST(workbook, validation_lists01) {
+
+    lxw_cell_value value;
+    lxw_data_val_obj *obj;
+    lxw_defined_name *defined_name;
+    lxw_workbook_options options = {.validation_list_sheet = LXW_TRUE};
+    const char *repeated[] = {"open", "high", "close", NULL};
+    const char *repeated2[] = {"open", "high", "close", NULL};
+    const char *single[] = {"yes", "no", NULL};
+    const char *long_list[101];
+    char items[100][4];
+    int i;
+
+    lxw_data_validation validation1 = {
+        .validate = LXW_VALIDATION_TYPE_LIST, .value_list = repeated};
+    lxw_data_validation validation2 = {
+        .validate = LXW_VALIDATION_TYPE_LIST, .value_list = repeated2};
+    lxw_data_validation validation3 = {
+        .validate = LXW_VALIDATION_TYPE_LIST, .value_list = single};
+    lxw_data_validation validation4 = {
+        .validate = LXW_VALIDATION_TYPE_LIST, .value_list = long_list};
+
+    lxw_workbook *workbook = workbook_new_opt(NULL, &options);
+    lxw_worksheet *worksheet1 = workbook_add_worksheet(workbook, NULL);
+    lxw_worksheet *worksheet2 = workbook_add_worksheet(workbook, NULL);
+    lxw_worksheet *lists;
+
+    /* A list that is longer than the Excel limit of 255 characters. */
+    for (i = 0; i < 100; i++) {
+        lxw_snprintf(items[i], 4, "%03d", i);
+        long_list[i] = items[i];
+    }
+    long_list[100] = NULL;
+
+    ASSERT_EQUAL(LXW_NO_ERROR,
+                 worksheet_data_validation_cell(worksheet1, 0, 0,
+                                                &validation1));
+    ASSERT_EQUAL(LXW_NO_ERROR,
+                 worksheet_data_validation_cell(worksheet2, 0, 0,
+                                                &validation2));
+    ASSERT_EQUAL(LXW_NO_ERROR,
+                 worksheet_data_validation_cell(worksheet2, 1, 0,
+                                                &validation3));
+    ASSERT_EQUAL(LXW_NO_ERROR,
+                 worksheet_data_validation_cell(worksheet2, 2, 0,
+                                                &validation4));
+
+    /* The repeated list is only stored once. */
+    ASSERT_EQUAL(3, workbook->validation_lists->count);
+
+    ASSERT_EQUAL(LXW_NO_ERROR, _prepare_validation_lists(workbook));
+
+    lists = workbook_get_worksheet_by_name(workbook, "_ValidationLists");
+    ASSERT_TRUE(lists != NULL);
+    ASSERT_TRUE(lists->hidden);
+
+    worksheet_get_cell(lists, 2, 0, &value);
+    ASSERT_STR("close", value.string);
+
+    worksheet_get_cell(lists, 99, 1, &value);
+    ASSERT_STR("099", value.string);
+
+    obj = STAILQ_FIRST(worksheet1->data_validations);
+    ASSERT_STR("_ValidationList1", obj->shared_list->formula);
+
+    obj = STAILQ_FIRST(worksheet2->data_validations);
+    ASSERT_STR("_ValidationList1", obj->shared_list->formula);
+
+    obj = STAILQ_NEXT(obj, list_pointers);
+    ASSERT_STR("\"yes,no\"", obj->shared_list->formula);
+
+    obj = STAILQ_NEXT(obj, list_pointers);
+    ASSERT_STR("_ValidationList2", obj->shared_list->formula);
+
+    defined_name = TAILQ_FIRST(workbook->defined_names);
+    ASSERT_STR("_ValidationList1", defined_name->name);
+    ASSERT_STR("_ValidationLists!$A$1:$A$3", defined_name->formula);
+    ASSERT_TRUE(defined_name->hidden);
+
+    defined_name = TAILQ_NEXT(defined_name, list_pointers);
+    ASSERT_STR("_ValidationList2", defined_name->name);
+    ASSERT_STR("_ValidationLists!$B$1:$B$100", defined_name->formula);
+
+    lxw_workbook_free(workbook);
+}
+
+/* Test a long list that can't be stored in the hidden worksheet. */
+CTEST(workbook, validation_lists02) {
+
+    lxw_workbook_options options = {.validation_list_sheet = LXW_TRUE};
+    const char *long_list[101];
+    char items[100][6];
+    int i;
+
+    lxw_data_validation validation = {
+        .validate = LXW_VALIDATION_TYPE_LIST, .value_list = long_list};
+
+    lxw_workbook *workbook = workbook_new_opt(NULL, &options);
+    lxw_worksheet *worksheet = workbook_add_worksheet(workbook, NULL);
+
+    for (i = 0; i < 100; i++) {
+        lxw_snprintf(items[i], 6, "%03d", i);
+        long_list[i] = items[i];
+    }
+    long_list[100] = NULL;
+
+    /* Add one more distinct long list than there are columns. */
+    for (i = 0; i <= LXW_COL_MAX; i++) {
+        lxw_snprintf(items[0], 6, "%05d", i);
+
+        ASSERT_EQUAL(LXW_NO_ERROR,
+                     worksheet_data_validation_cell(worksheet, i, 0,
+                                                    &validation));
+    }
+
+    ASSERT_EQUAL(LXW_COL_MAX + 1, workbook->validation_lists->count);
+
+    ASSERT_EQUAL(LXW_ERROR_PARAMETER_VALIDATION,
+                 _prepare_validation_lists(workbook));
+
+    lxw_workbook_free(workbook);
+}
+
+/* Test that the hidden list names aren't added to the app.xml parts. */
+CTEST(workbook, validation_lists03) {
+
+    char* got;
+    char exp[] =
+        "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>\n"
+        "<Properties xmlns=\"http://schemas.openxmlformats.org/officeDocument/2006/extended-properties\" xmlns:vt=\"http://schemas.openxmlformats.org/officeDocument/2006/docPropsVTypes\">"
+          "<Application>Microsoft Excel</Application>"
+          "<DocSecurity>0</DocSecurity>"
+          "<ScaleCrop>false</ScaleCrop>"
+          "<HeadingPairs>"
+            "<vt:vector size=\"4\" baseType=\"variant\">"
+              "<vt:variant>"
+                "<vt:lpstr>Worksheets</vt:lpstr>"
+              "</vt:variant>"
+              "<vt:variant>"
+                "<vt:i4>2</vt:i4>"
+              "</vt:variant>"
+              "<vt:variant>"
+                "<vt:lpstr>Named Ranges</vt:lpstr>"
+              "</vt:variant>"
+              "<vt:variant>"
+                "<vt:i4>1</vt:i4>"
+              "</vt:variant>"
+            "</vt:vector>"
+          "</HeadingPairs>"
+          "<TitlesOfParts>"
+            "<vt:vector size=\"3\" baseType=\"lpstr\">"
+              "<vt:lpstr>Sheet1</vt:lpstr>"
+              "<vt:lpstr>_ValidationLists</vt:lpstr>"
+              "<vt:lpstr>Sales</vt:lpstr>"
+            "</vt:vector>"
+          "</TitlesOfParts>"
+          "<Company>"
+          "</Company>"
+          "<LinksUpToDate>false</LinksUpToDate>"
+          "<SharedDoc>false</SharedDoc>"
+          "<HyperlinksChanged>false</HyperlinksChanged>"
+          "<AppVersion>12.0000</AppVersion>"
+        "</Properties>";
+
+    lxw_workbook_options options = {.validation_list_sheet = LXW_TRUE};
+    const char *long_list[101];
+    char items[100][4];
+    int i;
+
+    lxw_data_validation validation = {
+        .validate = LXW_VALIDATION_TYPE_LIST, .value_list = long_list};
+
+    lxw_workbook *workbook = workbook_new_opt(NULL, &options);
+    lxw_worksheet *worksheet = workbook_add_worksheet(workbook, NULL);
+
+    for (i = 0; i < 100; i++) {
+        lxw_snprintf(items[i], 4, "%03d", i);
+        long_list[i] = items[i];
+    }
+    long_list[100] = NULL;
+
+    worksheet_data_validation_cell(worksheet, 0, 0, &validation);
+    workbook_define_name(workbook, "Sales", "=Sheet1!$G$1:$H$10");
+
+    ASSERT_EQUAL(LXW_NO_ERROR, _prepare_validation_lists(workbook));
+
+    FILE* testfile = lxw_tmpfile(NULL);
+
+    lxw_app *app = lxw_app_new();
+    app->file = testfile;
+
+    lxw_app_add_part_name(app, "Sheet1");
+    lxw_app_add_part_name(app, "_ValidationLists");
+    lxw_app_add_heading_pair(app, "Worksheets", "2");
+
+    _add_app_named_ranges(app, workbook);
+
+    lxw_app_assemble_xml_file(app);
+
+    RUN_XLSX_STREQ_SHORT(exp, got);
+
+    lxw_app_free(app);
+    lxw_workbook_free(workbook);
+}
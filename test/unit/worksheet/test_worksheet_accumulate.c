@@ -0,0 +1,87 @@
+/*
+ * Tests for the lib_xlsx_writer library.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ * Copyright 2014-2025, John McNamara, jmcnamara@cpan.org.
+ *
+ */
+
+#include "../ctest.h"
+#include "../helper.h"
+
+#include "../../../include/xlsxwriter/worksheet.h"
+#include "../../../include/xlsxwriter/shared_strings.h"
+
+// Test that repeated writes update the existing cell in place.
+CTEST(worksheet, accumulate_number01) {
+
+    lxw_cell_value value;
+    lxw_row *row;
+    lxw_cell *cell;
+    int i;
+
+    lxw_worksheet *worksheet = lxw_worksheet_new(NULL);
+    worksheet->sst = lxw_sst_new();
+
+    worksheet_write_number(worksheet, 1, 1, 10, NULL);
+    worksheet_write_number(worksheet, 2, 1, 20, NULL);
+
+    row = lxw_worksheet_find_row(worksheet, 1);
+    cell = lxw_worksheet_find_cell_in_row(row, 1);
+
+    for (i = 0; i < 5; i++)
+        worksheet_accumulate_number(worksheet, 1, 1, 2.5, NULL);
+
+    ASSERT_TRUE(cell == lxw_worksheet_find_cell_in_row(row, 1));
+
+    worksheet_get_cell(worksheet, 1, 1, &value);
+    ASSERT_DBL_NEAR(22.5, value.number);
+
+    // Overwriting a cell reuses the node in the row tree.
+    worksheet_write_string(worksheet, 1, 1, "Foo", NULL);
+    ASSERT_TRUE(cell == lxw_worksheet_find_cell_in_row(row, 1));
+
+    worksheet_write_number(worksheet, 1, 1, 7, NULL);
+    ASSERT_TRUE(cell == lxw_worksheet_find_cell_in_row(row, 1));
+
+    // Empty cells start at 0.
+    worksheet_accumulate_number(worksheet, 3, 2, 5, NULL);
+    worksheet_get_cell(worksheet, 3, 2, &value);
+    ASSERT_EQUAL(LXW_CELL_VALUE_NUMBER, value.type);
+    ASSERT_DBL_NEAR(5, value.number);
+
+    worksheet_write_string(worksheet, 4, 1, "Foo", NULL);
+    ASSERT_EQUAL(LXW_ERROR_PARAMETER_VALIDATION,
+                 worksheet_accumulate_number(worksheet, 4, 1, 1, NULL));
+
+    lxw_sst_free(worksheet->sst);
+    lxw_worksheet_free(worksheet);
+}
+
+// Test accumulating cells in the current row in constant_memory mode.
+CTEST(worksheet, accumulate_number02) {
+
+    char* got;
+    char exp[] = "<sheetData>"
+                 "<row r=\"1\"><c r=\"A1\"><v>6</v></c><c r=\"B1\"><v>3</v></c></row>"
+                 "</sheetData>";
+    FILE* testfile = lxw_tmpfile(NULL);
+    lxw_worksheet_init_data init_data = {0};
+    init_data.optimize = LXW_TRUE;
+
+    lxw_worksheet *worksheet = lxw_worksheet_new(&init_data);
+
+    worksheet_accumulate_number(worksheet, 0, 0, 1, NULL);
+    worksheet_accumulate_number(worksheet, 0, 0, 2, NULL);
+    worksheet_accumulate_number(worksheet, 0, 0, 3, NULL);
+    worksheet_accumulate_number(worksheet, 0, 1, 3, NULL);
+
+    lxw_worksheet_write_single_row(worksheet);
+
+    worksheet->file = testfile;
+    _worksheet_write_optimized_sheet_data(worksheet);
+
+    RUN_XLSX_STREQ(exp, got);
+
+    lxw_worksheet_free(worksheet);
+}
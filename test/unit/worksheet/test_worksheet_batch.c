@@ -0,0 +1,144 @@
+/*
+ * Tests for the lib_xlsx_writer library.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ * Copyright 2014-2025, John McNamara, jmcnamara@cpan.org.
+ *
+ */
+
+#include "../ctest.h"
+#include "../helper.h"
+
+#include "../../../include/xlsxwriter/worksheet.h"
+#include "../../../include/xlsxwriter/shared_strings.h"
+
+// Test applying a buffer of batch commands.
+CTEST(worksheet, execute_batch01) {
+
+    char* got;
+    char exp[] = "<sheetData>"
+                 "<row r=\"1\" spans=\"1:2\"><c r=\"A1\"><v>1.5</v></c><c r=\"B1\" t=\"s\"><v>0</v></c></row>"
+                 "<row r=\"2\" spans=\"1:2\" ht=\"30\" customHeight=\"1\"><c r=\"A2\"><f>A1*2</f><v>0</v></c><c r=\"B2\" t=\"b\"><v>1</v></c></row>"
+                 "</sheetData>";
+    uint8_t buffer[] = {
+        LXW_BATCH_WRITE_NUMBER, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0xF8, 0x3F,
+        LXW_BATCH_WRITE_STRING, 0, 0, 0, 0, 1, 0, 3, 0, 0, 0, 'F', 'o', 'o',
+        LXW_BATCH_WRITE_FORMULA, 1, 0, 0, 0, 0, 0, 4, 0, 0, 0, 'A', '1', '*', '2',
+        LXW_BATCH_WRITE_BOOLEAN, 1, 0, 0, 0, 1, 0, 1,
+        LXW_BATCH_SET_ROW, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0x3E, 0x40,
+    };
+    FILE* testfile = lxw_tmpfile(NULL);
+
+    lxw_worksheet *worksheet = lxw_worksheet_new(NULL);
+    worksheet->file = testfile;
+    worksheet->sst = lxw_sst_new();
+
+    ASSERT_EQUAL(LXW_NO_ERROR,
+                 worksheet_execute_batch(worksheet, buffer, sizeof(buffer),
+                                         NULL));
+
+    _worksheet_write_sheet_data(worksheet);
+
+    RUN_XLSX_STREQ(exp, got);
+
+    lxw_sst_free(worksheet->sst);
+    lxw_worksheet_free(worksheet);
+}
+
+// Test the offset of invalid and failing batch commands.
+CTEST(worksheet, execute_batch02) {
+
+    lxw_cell_value value;
+    size_t error_offset = 0;
+    uint8_t truncated[] = {
+        LXW_BATCH_WRITE_BLANK, 0, 0, 0, 0, 0, 0,
+        LXW_BATCH_WRITE_STRING, 0, 0, 0, 0, 1, 0, 9, 0, 0, 0, 'F', 'o', 'o',
+    };
+    uint8_t bad_format[] = {
+        LXW_BATCH_SET_FORMAT, 0, 0,
+        LXW_BATCH_SET_FORMAT, 1, 0,
+    };
+    uint8_t out_of_range[] = {
+        LXW_BATCH_WRITE_BOOLEAN, 0, 0, 0, 0, 0, 0, 1,
+        LXW_BATCH_WRITE_BOOLEAN, 0, 0, 0, 0, 0xFF, 0xFF, 1,
+    };
+
+    lxw_worksheet *worksheet = lxw_worksheet_new(NULL);
+
+    ASSERT_EQUAL(LXW_ERROR_PARAMETER_VALIDATION,
+                 worksheet_execute_batch(worksheet, truncated,
+                                         sizeof(truncated), &error_offset));
+    ASSERT_EQUAL(7, error_offset);
+
+    ASSERT_EQUAL(LXW_ERROR_PARAMETER_VALIDATION,
+                 worksheet_execute_batch(worksheet, bad_format,
+                                         sizeof(bad_format), &error_offset));
+    ASSERT_EQUAL(3, error_offset);
+
+    ASSERT_EQUAL(LXW_ERROR_WORKSHEET_INDEX_OUT_OF_RANGE,
+                 worksheet_execute_batch(worksheet, out_of_range,
+                                         sizeof(out_of_range), &error_offset));
+    ASSERT_EQUAL(8, error_offset);
+
+    worksheet_get_cell(worksheet, 0, 0, &value);
+    ASSERT_EQUAL(LXW_CELL_VALUE_BOOLEAN, value.type);
+
+    lxw_worksheet_free(worksheet);
+}
+
+// Test the mapping of the batch format ids to formats.
+CTEST(worksheet, execute_batch03) {
+
+    lxw_cell_value value;
+    struct lxw_formats formats;
+    lxw_format *format1 = lxw_format_new();
+    lxw_format *format2 = lxw_format_new();
+    lxw_format *format3 = lxw_format_new();
+    lxw_worksheet_init_data init_data = {0};
+    uint8_t buffer1[] = {
+        LXW_BATCH_SET_FORMAT, 1, 0,
+        LXW_BATCH_WRITE_BLANK, 0, 0, 0, 0, 0, 0,
+    };
+    uint8_t buffer2[] = {
+        LXW_BATCH_SET_FORMAT, 2, 0,
+        LXW_BATCH_WRITE_BLANK, 1, 0, 0, 0, 0, 0,
+    };
+
+    /* The first format stands in for a default workbook format. */
+    STAILQ_INIT(&formats);
+    STAILQ_INSERT_TAIL(&formats, format1, list_pointers);
+    STAILQ_INSERT_TAIL(&formats, format2, list_pointers);
+
+    init_data.formats = &formats;
+    init_data.num_default_formats = 1;
+
+    lxw_worksheet *worksheet = lxw_worksheet_new(&init_data);
+
+    ASSERT_EQUAL(LXW_NO_ERROR,
+                 worksheet_execute_batch(worksheet, buffer1,
+                                         sizeof(buffer1), NULL));
+    ASSERT_EQUAL(LXW_ERROR_PARAMETER_VALIDATION,
+                 worksheet_execute_batch(worksheet, buffer2,
+                                         sizeof(buffer2), NULL));
+
+    /* A format added after a batch gets the next id. */
+    STAILQ_INSERT_TAIL(&formats, format3, list_pointers);
+
+    ASSERT_EQUAL(LXW_NO_ERROR,
+                 worksheet_execute_batch(worksheet, buffer2,
+                                         sizeof(buffer2), NULL));
+
+    worksheet_get_cell(worksheet, 0, 0, &value);
+    ASSERT_TRUE(value.format == format2);
+
+    worksheet_get_cell(worksheet, 1, 0, &value);
+    ASSERT_TRUE(value.format == format3);
+
+    ASSERT_EQUAL(2, worksheet->num_batch_formats);
+
+    lxw_worksheet_free(worksheet);
+    lxw_format_free(format1);
+    lxw_format_free(format2);
+    lxw_format_free(format3);
+}
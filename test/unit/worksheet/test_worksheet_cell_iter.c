@@ -0,0 +1,85 @@
+/*
+ * Tests for the lib_xlsx_writer library.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ * Copyright 2014-2025, John McNamara, jmcnamara@cpan.org.
+ *
+ */
+
+#include "../ctest.h"
+#include "../helper.h"
+
+#include "../../../include/xlsxwriter/worksheet.h"
+#include "../../../include/xlsxwriter/shared_strings.h"
+
+// Test worksheet_get_cell().
+CTEST(worksheet, get_cell01) {
+
+    lxw_cell_value value;
+
+    lxw_worksheet *worksheet = lxw_worksheet_new(NULL);
+    worksheet->sst = lxw_sst_new();
+
+    worksheet_write_number(worksheet, 2, 1, 123, NULL);
+    worksheet_write_string(worksheet, 3, 1, "Foo", NULL);
+    worksheet_write_formula_num(worksheet, 4, 1, "=B3*2", NULL, 246);
+
+    worksheet_get_cell(worksheet, 2, 1, &value);
+    ASSERT_EQUAL(LXW_CELL_VALUE_NUMBER, value.type);
+    ASSERT_DBL_NEAR(123, value.number);
+
+    worksheet_get_cell(worksheet, 3, 1, &value);
+    ASSERT_EQUAL(LXW_CELL_VALUE_STRING, value.type);
+    ASSERT_STR("Foo", value.string);
+
+    worksheet_get_cell(worksheet, 4, 1, &value);
+    ASSERT_EQUAL(LXW_CELL_VALUE_FORMULA, value.type);
+    ASSERT_STR("B3*2", value.string);
+    ASSERT_DBL_NEAR(246, value.number);
+
+    worksheet_get_cell(worksheet, 2, 2, &value);
+    ASSERT_EQUAL(LXW_CELL_VALUE_EMPTY, value.type);
+
+    ASSERT_EQUAL(LXW_ERROR_WORKSHEET_INDEX_OUT_OF_RANGE,
+                 worksheet_get_cell(worksheet, LXW_ROW_MAX, 0, &value));
+
+    lxw_sst_free(worksheet->sst);
+    lxw_worksheet_free(worksheet);
+}
+
+// Test iterating over a sparse range in row-major order.
+CTEST(worksheet, cell_iter01) {
+
+    lxw_cell_iter iter;
+    lxw_cell_value value;
+    lxw_row_t rows[] = {1, 1, 3, 5};
+    lxw_col_t cols[] = {1, 3, 2, 1};
+    double total = 0;
+    int count = 0;
+
+    lxw_worksheet *worksheet = lxw_worksheet_new(NULL);
+
+    worksheet_write_number(worksheet, 0, 1, 1000, NULL);
+    worksheet_write_number(worksheet, 1, 0, 1000, NULL);
+    worksheet_write_number(worksheet, 1, 3, 2, NULL);
+    worksheet_write_number(worksheet, 1, 1, 1, NULL);
+    worksheet_write_number(worksheet, 3, 2, 3, NULL);
+    worksheet_write_number(worksheet, 3, 4, 1000, NULL);
+    worksheet_write_number(worksheet, 5, 1, 4, NULL);
+    worksheet_write_number(worksheet, 6, 1, 1000, NULL);
+
+    worksheet_cell_iter_init(&iter, worksheet, 1, 1, 5, 3);
+
+    while (worksheet_cell_iter_next(&iter, &value)) {
+        ASSERT_EQUAL(rows[count], value.row);
+        ASSERT_EQUAL(cols[count], value.col);
+        total += value.number;
+        count++;
+    }
+
+    ASSERT_EQUAL(4, count);
+    ASSERT_DBL_NEAR(10, total);
+    ASSERT_FALSE(worksheet_cell_iter_next(&iter, &value));
+
+    lxw_worksheet_free(worksheet);
+}
@@ -0,0 +1,133 @@
+/*
+ * Tests for the lib_xlsx_writer library.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ * Copyright 2014-2025, John McNamara, jmcnamara@cpan.org.
+ *
+ */
+
+#include "../ctest.h"
+#include "../helper.h"
+
+#include "../../../include/xlsxwriter/worksheet.h"
+
+// Test restoring the state of a constant_memory worksheet from a checkpoint.
+CTEST(worksheet, checkpoint01) {
+
+    char* got;
+    char exp[] = "<hyperlinks>"
+                 "<hyperlink ref=\"B1\" r:id=\"rId1\" tooltip=\"Tip\"/>"
+                 "</hyperlinks>";
+    const char *filename = "test_worksheet_checkpoint01.rows";
+    FILE* testfile = lxw_tmpfile(NULL);
+    FILE* checkpoint = lxw_tmpfile(NULL);
+    lxw_worksheet *resumed;
+    unsigned int index;
+    lxw_worksheet_init_data init_data = {0};
+    init_data.optimize = LXW_TRUE;
+    init_data.max_url_length = 2079;
+
+    lxw_worksheet *worksheet = lxw_worksheet_new(&init_data);
+    ASSERT_EQUAL(LXW_NO_ERROR,
+                 lxw_worksheet_set_checkpoint_file(worksheet, filename));
+
+    worksheet_write_number(worksheet, 0, 0, 1, NULL);
+    worksheet_write_url_opt(worksheet, 0, 1, "http://www.perl.com/", NULL,
+                            NULL, "Tip");
+    worksheet_write_number(worksheet, 2, 3, 3, NULL);
+
+    ASSERT_EQUAL(LXW_NO_ERROR, lxw_worksheet_flush_checkpoint(worksheet));
+    ASSERT_EQUAL(LXW_NO_ERROR,
+                 lxw_worksheet_write_checkpoint(worksheet, checkpoint));
+    ASSERT_EQUAL(3, worksheet_get_resume_row(worksheet));
+
+    /* Rows written after the checkpoint are discarded. */
+    worksheet_write_number(worksheet, 3, 0, 4, NULL);
+    worksheet_write_number(worksheet, 4, 0, 5, NULL);
+    lxw_worksheet_free(worksheet);
+
+    resumed = lxw_worksheet_new(&init_data);
+    ASSERT_EQUAL(LXW_NO_ERROR,
+                 lxw_worksheet_set_checkpoint_file(resumed, filename));
+
+    rewind(checkpoint);
+    ASSERT_EQUAL(1, fscanf(checkpoint, "sheet %u", &index));
+    ASSERT_EQUAL(0, index);
+    ASSERT_EQUAL(LXW_NO_ERROR,
+                 lxw_worksheet_read_checkpoint(resumed, checkpoint));
+
+    ASSERT_EQUAL(3, worksheet_get_resume_row(resumed));
+    ASSERT_EQUAL(0, resumed->dim_rowmin);
+    ASSERT_EQUAL(2, resumed->dim_rowmax);
+    ASSERT_EQUAL(0, resumed->dim_colmin);
+    ASSERT_EQUAL(3, resumed->dim_colmax);
+    ASSERT_EQUAL(1, resumed->hlink_count);
+    ASSERT_EQUAL(LXW_ERROR_WORKSHEET_INDEX_OUT_OF_RANGE,
+                 worksheet_write_number(resumed, 2, 0, 3, NULL));
+
+    resumed->file = testfile;
+    _worksheet_write_hyperlinks(resumed);
+
+    RUN_XLSX_STREQ(exp, got);
+
+    fclose(checkpoint);
+    lxw_worksheet_free(resumed);
+    remove(filename);
+}
+
+// Test restoring the column statistics from a checkpoint.
+CTEST(worksheet, checkpoint02) {
+
+    const char *filename = "test_worksheet_checkpoint02.rows";
+    FILE* checkpoint = lxw_tmpfile(NULL);
+    lxw_column_stats stats;
+    lxw_worksheet *resumed;
+    unsigned int index;
+    lxw_worksheet_init_data init_data = {0};
+    init_data.optimize = LXW_TRUE;
+
+    lxw_worksheet *worksheet = lxw_worksheet_new(&init_data);
+    ASSERT_EQUAL(LXW_NO_ERROR,
+                 lxw_worksheet_set_checkpoint_file(worksheet, filename));
+
+    worksheet_track_column_stats(worksheet, 0, 0, 100, 1);
+
+    worksheet_write_number(worksheet, 0, 0, 0.1, NULL);
+    worksheet_write_string(worksheet, 0, 1, "Foo", NULL);
+    worksheet_write_number(worksheet, 1, 0, -2.5, NULL);
+    worksheet_write_string(worksheet, 1, 1, "Bar", NULL);
+
+    ASSERT_EQUAL(LXW_NO_ERROR, lxw_worksheet_flush_checkpoint(worksheet));
+    ASSERT_EQUAL(LXW_NO_ERROR,
+                 lxw_worksheet_write_checkpoint(worksheet, checkpoint));
+    lxw_worksheet_free(worksheet);
+
+    resumed = lxw_worksheet_new(&init_data);
+    ASSERT_EQUAL(LXW_NO_ERROR,
+                 lxw_worksheet_set_checkpoint_file(resumed, filename));
+
+    /* The statistics set up again by the application are replaced. */
+    worksheet_track_column_stats(resumed, 0, 0, 100, 1);
+
+    rewind(checkpoint);
+    ASSERT_EQUAL(1, fscanf(checkpoint, "sheet %u", &index));
+    ASSERT_EQUAL(LXW_NO_ERROR,
+                 lxw_worksheet_read_checkpoint(resumed, checkpoint));
+
+    worksheet_write_number(resumed, 2, 0, 7, NULL);
+    worksheet_write_string(resumed, 2, 1, "Foo", NULL);
+
+    worksheet_get_column_stats(resumed, 0, &stats);
+    ASSERT_EQUAL(3, stats.number_count);
+    ASSERT_DBL_NEAR(4.6, stats.sum);
+    ASSERT_DBL_NEAR(-2.5, stats.min);
+    ASSERT_DBL_NEAR(7, stats.max);
+
+    worksheet_get_column_stats(resumed, 1, &stats);
+    ASSERT_EQUAL(3, stats.string_count);
+    ASSERT_EQUAL(2, stats.distinct_strings);
+
+    fclose(checkpoint);
+    lxw_worksheet_free(resumed);
+    remove(filename);
+}
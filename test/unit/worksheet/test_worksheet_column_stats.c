@@ -0,0 +1,171 @@
+/*
+ * Tests for the lib_xlsx_writer library.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ * Copyright 2014-2025, John McNamara, jmcnamara@cpan.org.
+ *
+ */
+
+#include "../ctest.h"
+#include "../helper.h"
+
+#include "../../../include/xlsxwriter/worksheet.h"
+
+// Test the running column statistics in constant_memory mode.
+CTEST(worksheet, column_stats01) {
+
+    lxw_column_stats stats;
+    lxw_datetime datetime = {2025, 1, 1, 0, 0, 0};
+    lxw_worksheet_init_data init_data = {0};
+    init_data.optimize = LXW_TRUE;
+
+    lxw_worksheet *worksheet = lxw_worksheet_new(&init_data);
+
+    ASSERT_EQUAL(LXW_ERROR_PARAMETER_VALIDATION,
+                 worksheet_get_column_stats(worksheet, 0, &stats));
+
+    ASSERT_EQUAL(LXW_NO_ERROR,
+                 worksheet_track_column_stats(worksheet, 1, 0, 100, 1));
+
+    /* The header row is outside the range. */
+    worksheet_write_number(worksheet, 0, 0, 1000, NULL);
+
+    worksheet_write_number(worksheet, 1, 0, 10, NULL);
+    worksheet_write_string(worksheet, 1, 1, "East", NULL);
+    worksheet_write_number(worksheet, 2, 0, -2.5, NULL);
+    worksheet_write_string(worksheet, 2, 1, "West", NULL);
+    worksheet_write_number_text(worksheet, 3, 0, "7", 1, NULL);
+    worksheet_write_string(worksheet, 3, 1, "East", NULL);
+    worksheet_write_datetime(worksheet, 4, 1, &datetime, NULL);
+    worksheet_write_number(worksheet, 5, 2, 1000, NULL);
+
+    ASSERT_EQUAL(LXW_NO_ERROR,
+                 worksheet_get_column_stats(worksheet, 0, &stats));
+    ASSERT_EQUAL(3, stats.count);
+    ASSERT_EQUAL(3, stats.number_count);
+    ASSERT_EQUAL(0, stats.string_count);
+    ASSERT_DBL_NEAR(14.5, stats.sum);
+    ASSERT_DBL_NEAR(-2.5, stats.min);
+    ASSERT_DBL_NEAR(10, stats.max);
+
+    ASSERT_EQUAL(LXW_NO_ERROR,
+                 worksheet_get_column_stats(worksheet, 1, &stats));
+    ASSERT_EQUAL(4, stats.count);
+    ASSERT_EQUAL(3, stats.string_count);
+    ASSERT_EQUAL(2, stats.distinct_strings);
+    ASSERT_DBL_NEAR(45658, stats.min);
+
+    ASSERT_EQUAL(LXW_ERROR_WORKSHEET_INDEX_OUT_OF_RANGE,
+                 worksheet_get_column_stats(worksheet, 2, &stats));
+
+    lxw_worksheet_free(worksheet);
+}
+
+// Test the distinct string estimate above the exact range.
+CTEST(worksheet, column_stats02) {
+
+    lxw_column_stats stats;
+    char string[LXW_ATTR_32];
+    lxw_row_t row;
+
+    lxw_worksheet *worksheet = lxw_worksheet_new(NULL);
+    worksheet->sst = lxw_sst_new();
+
+    worksheet_track_column_stats(worksheet, 0, 0, 20000, 0);
+
+    for (row = 0; row < 20000; row++) {
+        lxw_snprintf(string, LXW_ATTR_32, "Item %d", row % 5000);
+        worksheet_write_string(worksheet, row, 0, string, NULL);
+    }
+
+    worksheet_get_column_stats(worksheet, 0, &stats);
+
+    ASSERT_EQUAL(20000, stats.string_count);
+    ASSERT_TRUE(stats.distinct_strings > 4000);
+    ASSERT_TRUE(stats.distinct_strings < 6000);
+
+    lxw_sst_free(worksheet->sst);
+    lxw_worksheet_free(worksheet);
+}
+
+// Test that an overwritten cell is only counted once.
+CTEST(worksheet, column_stats03) {
+
+    lxw_column_stats stats;
+
+    lxw_worksheet *worksheet = lxw_worksheet_new(NULL);
+    worksheet->sst = lxw_sst_new();
+
+    /* Cells written before the range is tracked aren't counted. */
+    worksheet_write_number(worksheet, 0, 0, 100, NULL);
+
+    worksheet_track_column_stats(worksheet, 0, 0, 10, 0);
+
+    worksheet_write_number(worksheet, 0, 0, 5, NULL);
+    worksheet_write_number(worksheet, 1, 0, 10, NULL);
+    worksheet_write_number(worksheet, 1, 0, 20, NULL);
+    worksheet_write_number_text(worksheet, 2, 0, "3", 1, NULL);
+    worksheet_write_number(worksheet, 2, 0, 4, NULL);
+    worksheet_write_string(worksheet, 3, 0, "East", NULL);
+    worksheet_write_number(worksheet, 3, 0, 1, NULL);
+    worksheet_write_number(worksheet, 4, 0, 2, NULL);
+    worksheet_write_string(worksheet, 4, 0, "West", NULL);
+    worksheet_write_number(worksheet, 5, 0, 8, NULL);
+    worksheet_write_formula(worksheet, 5, 0, "=1+1", NULL);
+
+    worksheet_get_column_stats(worksheet, 0, &stats);
+
+    ASSERT_EQUAL(5, stats.count);
+    ASSERT_EQUAL(4, stats.number_count);
+    ASSERT_EQUAL(1, stats.string_count);
+    ASSERT_DBL_NEAR(30, stats.sum);
+
+    /* The minimum and maximum still include the overwritten values. */
+    ASSERT_DBL_NEAR(1, stats.min);
+    ASSERT_DBL_NEAR(20, stats.max);
+
+    /* Tracking again resets the statistics. */
+    worksheet_track_column_stats(worksheet, 0, 0, 10, 0);
+    worksheet_write_number(worksheet, 1, 0, 30, NULL);
+
+    worksheet_get_column_stats(worksheet, 0, &stats);
+
+    ASSERT_EQUAL(1, stats.count);
+    ASSERT_DBL_NEAR(30, stats.sum);
+
+    lxw_sst_free(worksheet->sst);
+    lxw_worksheet_free(worksheet);
+}
+
+// Test that accumulating into a cell replaces its value in the statistics.
+CTEST(worksheet, column_stats04) {
+
+    lxw_column_stats stats;
+
+    lxw_worksheet *worksheet = lxw_worksheet_new(NULL);
+
+    worksheet_track_column_stats(worksheet, 0, 0, 10, 1);
+
+    worksheet_accumulate_number(worksheet, 0, 0, 10, NULL);
+    worksheet_accumulate_number(worksheet, 0, 0, 5, NULL);
+    worksheet_write_number_text(worksheet, 0, 1, "2", 1, NULL);
+    worksheet_accumulate_number(worksheet, 0, 1, 3, NULL);
+    worksheet_write_number(worksheet, 0, 1, 1, NULL);
+
+    worksheet_get_column_stats(worksheet, 0, &stats);
+
+    ASSERT_EQUAL(1, stats.count);
+    ASSERT_EQUAL(1, stats.number_count);
+    ASSERT_DBL_NEAR(15, stats.sum);
+    ASSERT_DBL_NEAR(15, stats.min);
+    ASSERT_DBL_NEAR(15, stats.max);
+
+    worksheet_get_column_stats(worksheet, 1, &stats);
+
+    ASSERT_EQUAL(1, stats.count);
+    ASSERT_DBL_NEAR(1, stats.sum);
+    ASSERT_DBL_NEAR(1, stats.min);
+    ASSERT_DBL_NEAR(5, stats.max);
+
+    lxw_worksheet_free(worksheet);
+}
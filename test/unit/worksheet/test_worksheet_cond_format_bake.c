@@ -0,0 +1,157 @@
+/*
+ * Tests for the lib_xlsx_writer library.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ * Copyright 2014-2025, John McNamara, jmcnamara@cpan.org.
+ *
+ */
+
+#include "../ctest.h"
+#include "../helper.h"
+
+#include "../../../include/xlsxwriter/workbook.h"
+
+// Test the evaluation of static conditional format rules.
+CTEST(worksheet, cond_format_match) {
+
+    lxw_cond_format_obj cond_format = {0};
+    lxw_cell_value number = {.type = LXW_CELL_VALUE_NUMBER, .number = 5};
+    lxw_cell_value string = {.type = LXW_CELL_VALUE_STRING,
+                             .string = "North East"};
+    lxw_cell_value spaces = {.type = LXW_CELL_VALUE_STRING, .string = "  "};
+    lxw_cell_value empty = {.type = LXW_CELL_VALUE_EMPTY};
+
+    cond_format.type = LXW_CONDITIONAL_TYPE_CELL;
+    cond_format.criteria = LXW_CONDITIONAL_CRITERIA_BETWEEN;
+    cond_format.min_value = 1;
+    cond_format.max_value = 5;
+    ASSERT_TRUE(_cond_format_match(&cond_format, &number));
+    ASSERT_FALSE(_cond_format_match(&cond_format, &string));
+    ASSERT_FALSE(_cond_format_match(&cond_format, &empty));
+
+    /* Text sorts after numbers and blank cells are zero. */
+    cond_format.criteria = LXW_CONDITIONAL_CRITERIA_GREATER_THAN;
+    cond_format.min_value = 100;
+    ASSERT_TRUE(_cond_format_match(&cond_format, &string));
+    cond_format.criteria = LXW_CONDITIONAL_CRITERIA_LESS_THAN;
+    cond_format.min_value = 1;
+    ASSERT_TRUE(_cond_format_match(&cond_format, &empty));
+
+    cond_format.type = LXW_CONDITIONAL_TYPE_TEXT;
+    cond_format.criteria = LXW_CONDITIONAL_CRITERIA_TEXT_CONTAINING;
+    cond_format.min_value_string = "EAST";
+    ASSERT_TRUE(_cond_format_match(&cond_format, &string));
+    ASSERT_FALSE(_cond_format_match(&cond_format, &empty));
+
+    cond_format.criteria = LXW_CONDITIONAL_CRITERIA_TEXT_NOT_CONTAINING;
+    ASSERT_FALSE(_cond_format_match(&cond_format, &string));
+    ASSERT_TRUE(_cond_format_match(&cond_format, &empty));
+
+    cond_format.criteria = LXW_CONDITIONAL_CRITERIA_TEXT_BEGINS_WITH;
+    cond_format.min_value_string = "north";
+    ASSERT_TRUE(_cond_format_match(&cond_format, &string));
+
+    cond_format.criteria = LXW_CONDITIONAL_CRITERIA_TEXT_ENDS_WITH;
+    ASSERT_FALSE(_cond_format_match(&cond_format, &string));
+
+    /* Numbers are matched as text. */
+    cond_format.criteria = LXW_CONDITIONAL_CRITERIA_TEXT_CONTAINING;
+    cond_format.min_value_string = "5";
+    ASSERT_TRUE(_cond_format_match(&cond_format, &number));
+
+    cond_format.type = LXW_CONDITIONAL_TYPE_BLANKS;
+    ASSERT_TRUE(_cond_format_match(&cond_format, &empty));
+    ASSERT_TRUE(_cond_format_match(&cond_format, &spaces));
+    ASSERT_FALSE(_cond_format_match(&cond_format, &number));
+
+    cond_format.type = LXW_CONDITIONAL_TYPE_NO_BLANKS;
+    ASSERT_FALSE(_cond_format_match(&cond_format, &spaces));
+    ASSERT_TRUE(_cond_format_match(&cond_format, &string));
+}
+
+// Test baking conditional formats into the cell formats.
+CTEST(worksheet, cond_format_bake) {
+
+    lxw_cell_value value;
+    lxw_cond_format_hash_element *element;
+
+    lxw_workbook *workbook = workbook_new(NULL);
+    lxw_worksheet *worksheet = workbook_add_worksheet(workbook, NULL);
+    lxw_format *red = workbook_add_format(workbook);
+    lxw_format *bold = workbook_add_format(workbook);
+    lxw_format *fill = workbook_add_format(workbook);
+    lxw_format *italic = workbook_add_format(workbook);
+
+    lxw_conditional_format rule1 = {
+        .type = LXW_CONDITIONAL_TYPE_CELL,
+        .criteria = LXW_CONDITIONAL_CRITERIA_GREATER_THAN,
+        .value = 3, .format = red, .stop_if_true = LXW_TRUE};
+    lxw_conditional_format rule2 = {
+        .type = LXW_CONDITIONAL_TYPE_CELL,
+        .criteria = LXW_CONDITIONAL_CRITERIA_GREATER_THAN,
+        .value = 0, .format = bold};
+    lxw_conditional_format rule3 = {
+        .type = LXW_CONDITIONAL_TYPE_BLANKS, .format = fill};
+    lxw_conditional_format rule4 = {
+        .type = LXW_CONDITIONAL_TYPE_FORMULA,
+        .value_string = "=$C1>1", .format = italic};
+    lxw_conditional_format rule5 = {
+        .type = LXW_CONDITIONAL_TYPE_CELL,
+        .criteria = LXW_CONDITIONAL_CRITERIA_EQUAL_TO,
+        .value = 1, .format = bold};
+
+    format_set_font_color(red, LXW_COLOR_RED);
+    format_set_bold(bold);
+    format_set_bg_color(fill, LXW_COLOR_YELLOW);
+    format_set_italic(italic);
+
+    worksheet_write_number(worksheet, 0, 0, 1, italic);
+    worksheet_write_number(worksheet, 1, 0, 5, NULL);
+    worksheet_write_string(worksheet, 0, 1, "a", NULL);
+    worksheet_write_string(worksheet, 2, 1, "b", NULL);
+    worksheet_write_number(worksheet, 0, 2, 1, NULL);
+    worksheet_write_number(worksheet, 2, 2, 2, NULL);
+
+    worksheet_conditional_format_range(worksheet, 0, 0, 2, 0, &rule1);
+    worksheet_conditional_format_range(worksheet, 0, 0, 2, 0, &rule2);
+    worksheet_conditional_format_range(worksheet, 0, 1, 2, 1, &rule3);
+    worksheet_conditional_format_range(worksheet, 0, 2, 2, 2, &rule4);
+    worksheet_conditional_format_range(worksheet, 0, 2, 2, 2, &rule5);
+
+    worksheet_bake_conditional_formats(worksheet);
+    lxw_worksheet_bake_conditional_formats(worksheet);
+
+    /* The cell format is combined with the conditional format. */
+    worksheet_get_cell(worksheet, 0, 0, &value);
+    ASSERT_TRUE(value.format->bold);
+    ASSERT_TRUE(value.format->italic);
+    ASSERT_EQUAL(LXW_COLOR_UNSET, value.format->font_color);
+
+    /* The higher priority rule stops the evaluation of the other rule. */
+    worksheet_get_cell(worksheet, 1, 0, &value);
+    ASSERT_EQUAL(LXW_COLOR_RED, value.format->font_color);
+    ASSERT_FALSE(value.format->bold);
+
+    /* Blank cells are evaluated as zero. */
+    worksheet_get_cell(worksheet, 2, 0, &value);
+    ASSERT_EQUAL(LXW_CELL_VALUE_EMPTY, value.type);
+
+    /* A formatted blank cell is added for a rule that matches blanks. */
+    worksheet_get_cell(worksheet, 1, 1, &value);
+    ASSERT_EQUAL(LXW_CELL_VALUE_BLANK, value.type);
+    ASSERT_EQUAL(LXW_COLOR_YELLOW, value.format->bg_color);
+
+    worksheet_get_cell(worksheet, 2, 1, &value);
+    ASSERT_NULL(value.format);
+
+    /* Rules that overlap a formula rule aren't baked. */
+    worksheet_get_cell(worksheet, 0, 2, &value);
+    ASSERT_NULL(value.format);
+
+    element = RB_ROOT(worksheet->conditional_formats);
+    ASSERT_STR("C1:C3", element->sqref);
+    ASSERT_NULL(RB_LEFT(element, tree_pointers));
+    ASSERT_NULL(RB_RIGHT(element, tree_pointers));
+
+    lxw_workbook_free(workbook);
+}
@@ -0,0 +1,132 @@
+/*
+ * Tests for the lib_xlsx_writer library.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ * Copyright 2014-2025, John McNamara, jmcnamara@cpan.org.
+ *
+ */
+
+#include "../ctest.h"
+#include "../helper.h"
+
+#include "../../../include/xlsxwriter/worksheet.h"
+
+// Test the autofilter string matching with wildcards.
+CTEST(worksheet, filter_match_string) {
+
+    ASSERT_TRUE(_filter_match_string("East", "East"));
+    ASSERT_TRUE(_filter_match_string("EAST", "east"));
+    ASSERT_TRUE(_filter_match_string("East", "E*"));
+    ASSERT_TRUE(_filter_match_string("North East", "*ast"));
+    ASSERT_TRUE(_filter_match_string("Southeast", "*th*a*"));
+    ASSERT_TRUE(_filter_match_string("West", "?est"));
+    ASSERT_TRUE(_filter_match_string("Why?", "Why~?"));
+    ASSERT_TRUE(_filter_match_string("", "*"));
+
+    ASSERT_FALSE(_filter_match_string("East", "Eas"));
+    ASSERT_FALSE(_filter_match_string("East", "W*"));
+    ASSERT_FALSE(_filter_match_string("Whys", "Why~?"));
+    ASSERT_FALSE(_filter_match_string("Eas", "?east"));
+}
+
+// Test the autofilter criteria with formula and boolean values.
+CTEST(worksheet, filter_match_criteria) {
+
+    lxw_cell_value value;
+    lxw_filter_rule_obj rule;
+    char criteria[] = "FALSE";
+
+    memset(&value, 0, sizeof(value));
+
+    /* Formulas are compared using their cached result. */
+    value.type = LXW_CELL_VALUE_FORMULA;
+    value.string = "=A1*2";
+    value.number = 4;
+
+    ASSERT_TRUE(_filter_match_criteria(&value,
+                                       LXW_FILTER_CRITERIA_GREATER_THAN,
+                                       NULL, 2));
+    ASSERT_TRUE(_filter_match_criteria(&value, LXW_FILTER_CRITERIA_EQUAL_TO,
+                                       "4", 0));
+    ASSERT_FALSE(_filter_match_criteria(&value, LXW_FILTER_CRITERIA_EQUAL_TO,
+                                        "=A1*2", 0));
+
+    /* Booleans are compared as TRUE or FALSE. */
+    value.type = LXW_CELL_VALUE_BOOLEAN;
+    value.string = NULL;
+    value.number = 1;
+
+    ASSERT_TRUE(_filter_match_criteria(&value, LXW_FILTER_CRITERIA_EQUAL_TO,
+                                       "true", 0));
+    ASSERT_FALSE(_filter_match_criteria(&value, LXW_FILTER_CRITERIA_EQUAL_TO,
+                                        "FALSE", 0));
+    ASSERT_TRUE(_filter_match_criteria(&value,
+                                       LXW_FILTER_CRITERIA_GREATER_THAN,
+                                       "FALSE", 0));
+
+    /* Unknown criteria don't match but the row is kept visible. */
+    ASSERT_FALSE(_filter_match_criteria(&value, LXW_FILTER_CRITERIA_NONE,
+                                        "TRUE", 0));
+    ASSERT_FALSE(_filter_match_criteria(&value, 100, "TRUE", 0));
+
+    memset(&rule, 0, sizeof(rule));
+    rule.type = LXW_FILTER_TYPE_SINGLE;
+    rule.criteria1 = 100;
+
+    ASSERT_TRUE(_filter_match_rule(&rule, &value));
+
+    rule.type = LXW_FILTER_TYPE_AND;
+    rule.criteria1 = LXW_FILTER_CRITERIA_EQUAL_TO;
+    rule.value1_string = criteria;
+    rule.criteria2 = 100;
+
+    ASSERT_TRUE(_filter_match_rule(&rule, &value));
+}
+
+// Test hiding the rows that don't match the autofilter rules.
+CTEST(worksheet, filter_hide_rows) {
+
+    lxw_row *row;
+    lxw_filter_rule rule1 = {.criteria = LXW_FILTER_CRITERIA_GREATER_THAN,
+                             .value = 2};
+    lxw_filter_rule rule2 = {.criteria = LXW_FILTER_CRITERIA_BLANKS};
+
+    lxw_worksheet *worksheet = lxw_worksheet_new(NULL);
+
+    worksheet_write_number(worksheet, 1, 0, 1, NULL);
+    worksheet_write_number(worksheet, 2, 0, 3, NULL);
+    worksheet_write_number(worksheet, 5, 0, 5, NULL);
+
+    worksheet_autofilter(worksheet, 0, 0, 6, 0);
+    worksheet_filter_column2(worksheet, 0, &rule1, &rule2, LXW_FILTER_OR);
+    worksheet_hide_filtered_rows(worksheet);
+
+    lxw_worksheet_prepare_filtered_rows(worksheet);
+
+    row = lxw_worksheet_find_row(worksheet, 1);
+    ASSERT_EQUAL(1, row->hidden);
+
+    row = lxw_worksheet_find_row(worksheet, 2);
+    ASSERT_EQUAL(0, row->hidden);
+
+    row = lxw_worksheet_find_row(worksheet, 5);
+    ASSERT_EQUAL(0, row->hidden);
+
+    /* Blank rows match the rules so no rows are created for them. */
+    ASSERT_NULL(lxw_worksheet_find_row(worksheet, 3));
+
+    /* Blank rows are hidden when they don't match the rules. */
+    worksheet_filter_column(worksheet, 0, &rule1);
+    lxw_worksheet_prepare_filtered_rows(worksheet);
+
+    row = lxw_worksheet_find_row(worksheet, 3);
+    ASSERT_EQUAL(1, row->hidden);
+
+    row = lxw_worksheet_find_row(worksheet, 6);
+    ASSERT_EQUAL(1, row->hidden);
+
+    row = lxw_worksheet_find_row(worksheet, 5);
+    ASSERT_EQUAL(0, row->hidden);
+
+    lxw_worksheet_free(worksheet);
+}
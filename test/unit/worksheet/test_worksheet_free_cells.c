@@ -0,0 +1,34 @@
+/*
+ * Tests for the lib_xlsx_writer library.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ * Copyright 2014-2025, John McNamara, jmcnamara@cpan.org.
+ *
+ */
+
+#include "../ctest.h"
+#include "../helper.h"
+
+#include "../../../include/xlsxwriter/worksheet.h"
+#include "../../../include/xlsxwriter/shared_strings.h"
+
+// Test that the cell data is freed but the comments are kept.
+CTEST(worksheet, free_cells01) {
+
+    lxw_worksheet *worksheet = lxw_worksheet_new(NULL);
+    worksheet->sst = lxw_sst_new();
+
+    worksheet_write_number(worksheet, 0, 0, 1, NULL);
+    worksheet_write_string(worksheet, 1, 0, "Foo", NULL);
+    worksheet_write_formula(worksheet, 2, 0, "=A1", NULL);
+    worksheet_write_comment(worksheet, 2, 0, "Bar");
+
+    lxw_worksheet_free_cells(worksheet);
+
+    ASSERT_TRUE(RB_EMPTY(worksheet->table));
+    ASSERT_TRUE(lxw_worksheet_find_row(worksheet, 0) == NULL);
+    ASSERT_FALSE(RB_EMPTY(worksheet->comments));
+
+    lxw_sst_free(worksheet->sst);
+    lxw_worksheet_free(worksheet);
+}
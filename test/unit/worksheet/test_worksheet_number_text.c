@@ -0,0 +1,83 @@
+/*
+ * Tests for the lib_xlsx_writer library.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ * Copyright 2014-2025, John McNamara, jmcnamara@cpan.org.
+ *
+ */
+
+#include <string.h>
+
+#include "../ctest.h"
+#include "../helper.h"
+
+#include "../../../include/xlsxwriter/worksheet.h"
+
+// Test the minimal form of numbers written as text.
+CTEST(worksheet, number_text01) {
+
+    const char *digits[] = {"12345.6700", "+0123", "-0.50", ".25", "-000",
+                            "0.000E+10", "1.50E-007", "7.", "1e+05"};
+    const char *exp[] = {"12345.67", "123", "-0.5", "0.25", "0",
+                         "0", "1.5E-7", "7", "1E5"};
+    size_t i;
+    char *got;
+
+    for (i = 0; i < sizeof(digits) / sizeof(digits[0]); i++) {
+        got = _normalize_number_text(digits[i], strlen(digits[i]));
+        ASSERT_STR(exp[i], got);
+        free(got);
+    }
+}
+
+// Test that invalid numbers written as text are rejected.
+CTEST(worksheet, number_text02) {
+
+    const char *digits[] = {"", "-", ".", "1.2.3", "1e", "1e+", " 1", "1 ",
+                            "0x10", "1,000", "NaN", "--1", "1E5.0"};
+    size_t i;
+
+    for (i = 0; i < sizeof(digits) / sizeof(digits[0]); i++)
+        ASSERT_NULL(_normalize_number_text(digits[i], strlen(digits[i])));
+}
+
+// Test writing numbers as text to a worksheet.
+CTEST(worksheet, number_text03) {
+
+    char* got;
+    char exp[] = "<sheetData>"
+                 "<row r=\"1\" spans=\"1:2\"><c r=\"A1\"><v>12345.67</v></c><c r=\"B1\"><v>5</v></c></row>"
+                 "</sheetData>";
+    FILE* testfile = lxw_tmpfile(NULL);
+    lxw_cell_value value;
+
+    lxw_worksheet *worksheet = lxw_worksheet_new(NULL);
+    worksheet->file = testfile;
+
+    /* The text doesn't need to be NULL terminated. */
+    worksheet_write_number_text(worksheet, 0, 0, "12345.6700|9", 10, NULL);
+    worksheet_write_number_text(worksheet, 0, 1, "2.5", 3, NULL);
+
+    ASSERT_EQUAL(LXW_ERROR_PARAMETER_VALIDATION,
+                 worksheet_write_number_text(worksheet, 0, 2, "1,5", 3, NULL));
+    ASSERT_EQUAL(LXW_ERROR_PARAMETER_IS_EMPTY,
+                 worksheet_write_number_text(worksheet, 0, 2, "1", 0, NULL));
+    ASSERT_EQUAL(LXW_ERROR_PARAMETER_VALIDATION,
+                 worksheet_write_number_text(worksheet, 0, 2, "1e999", 5, NULL));
+    ASSERT_EQUAL(LXW_ERROR_PARAMETER_VALIDATION,
+                 worksheet_write_number_text(worksheet, 0, 2, "-1e999", 6, NULL));
+    ASSERT_EQUAL(LXW_ERROR_PARAMETER_VALIDATION,
+                 worksheet_write_number_text(worksheet, 0, 2, "1e-999", 6, NULL));
+
+    worksheet_get_cell(worksheet, 0, 0, &value);
+    ASSERT_EQUAL(LXW_CELL_VALUE_NUMBER, value.type);
+    ASSERT_DBL_NEAR(12345.67, value.number);
+
+    worksheet_accumulate_number(worksheet, 0, 1, 2.5, NULL);
+
+    _worksheet_write_sheet_data(worksheet);
+
+    RUN_XLSX_STREQ(exp, got);
+
+    lxw_worksheet_free(worksheet);
+}
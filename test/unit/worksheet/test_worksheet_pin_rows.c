@@ -0,0 +1,52 @@
+/*
+ * Tests for the lib_xlsx_writer library.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ * Copyright 2014-2025, John McNamara, jmcnamara@cpan.org.
+ *
+ */
+
+#include "../ctest.h"
+#include "../helper.h"
+
+#include "../../../include/xlsxwriter/worksheet.h"
+
+// Test writing pinned rows after the streamed rows in constant_memory mode.
+CTEST(worksheet, pin_rows01) {
+
+    char* got;
+    char exp[] = "<sheetData>"
+                 "<row r=\"1\"><c r=\"A1\" t=\"inlineStr\"><is><t>Total</t></is></c><c r=\"B1\"><v>5</v></c></row>"
+                 "<row r=\"3\"><c r=\"B3\"><v>2</v></c></row>"
+                 "<row r=\"4\"><c r=\"B4\"><v>3</v></c></row>"
+                 "</sheetData>";
+    FILE* testfile = lxw_tmpfile(NULL);
+    lxw_worksheet_init_data init_data = {0};
+    init_data.optimize = LXW_TRUE;
+
+    lxw_worksheet *worksheet = lxw_worksheet_new(&init_data);
+
+    ASSERT_EQUAL(LXW_NO_ERROR, worksheet_pin_rows(worksheet, 2));
+
+    worksheet_write_number(worksheet, 0, 1, 0, NULL);
+    worksheet_write_number(worksheet, 2, 1, 2, NULL);
+    worksheet_write_number(worksheet, 3, 1, 3, NULL);
+
+    ASSERT_EQUAL(LXW_ERROR_WORKSHEET_INDEX_OUT_OF_RANGE,
+                 worksheet_write_number(worksheet, 2, 1, 4, NULL));
+
+    worksheet_write_string(worksheet, 0, 0, "Total", NULL);
+    worksheet_write_number(worksheet, 0, 1, 5, NULL);
+
+    ASSERT_EQUAL(LXW_ERROR_PARAMETER_VALIDATION,
+                 worksheet_pin_rows(worksheet, 1));
+
+    lxw_worksheet_write_single_row(worksheet);
+
+    worksheet->file = testfile;
+    _worksheet_write_optimized_sheet_data(worksheet);
+
+    RUN_XLSX_STREQ(exp, got);
+
+    lxw_worksheet_free(worksheet);
+}
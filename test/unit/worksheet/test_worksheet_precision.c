@@ -0,0 +1,46 @@
+/*
+ * Tests for the lib_xlsx_writer library.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ * Copyright 2014-2025, John McNamara, jmcnamara@cpan.org.
+ *
+ */
+
+#include "../ctest.h"
+#include "../helper.h"
+
+#include "../../../include/xlsxwriter/worksheet.h"
+
+// Test the workbook and column number precision.
+CTEST(worksheet, number_precision01) {
+
+    char* got;
+    char exp[] = "<sheetData>"
+                 "<row r=\"1\" spans=\"1:3\">"
+                 "<c r=\"A1\"><v>1.23</v></c>"
+                 "<c r=\"B1\"><v>3.14</v></c>"
+                 "<c r=\"C1\"><v>1.23456</v></c>"
+                 "</row>"
+                 "</sheetData>";
+    FILE* testfile = lxw_tmpfile(NULL);
+    lxw_number_precision precision = {LXW_PRECISION_SIGNIFICANT_DIGITS, 3};
+    lxw_worksheet_init_data init_data = {0};
+    init_data.number_precision = &precision;
+
+    lxw_worksheet *worksheet = lxw_worksheet_new(&init_data);
+    worksheet->file = testfile;
+
+    worksheet_set_column_precision(worksheet, 1, 1,
+                                   LXW_PRECISION_DECIMAL_PLACES, 2);
+    worksheet_set_column_precision(worksheet, 2, 2, LXW_PRECISION_FULL, 0);
+
+    worksheet_write_number(worksheet, 0, 0, 1.23456, NULL);
+    worksheet_write_number(worksheet, 0, 1, 3.14159, NULL);
+    worksheet_write_number(worksheet, 0, 2, 1.23456, NULL);
+
+    _worksheet_write_sheet_data(worksheet);
+
+    RUN_XLSX_STREQ(exp, got);
+
+    lxw_worksheet_free(worksheet);
+}
@@ -0,0 +1,68 @@
+/*
+ * Tests for the lib_xlsx_writer library.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ * Copyright 2014-2025, John McNamara, jmcnamara@cpan.org.
+ *
+ */
+
+#include "../ctest.h"
+#include "../helper.h"
+
+#include "../../../include/xlsxwriter/worksheet.h"
+
+// Test that the least recently used worksheet is spilled and reloaded.
+CTEST(worksheet, residency01) {
+
+    char* got;
+    char exp[] = "<sheetData>"
+                 "<row r=\"1\" spans=\"1:2\"><c r=\"A1\"><v>1</v></c><c r=\"B1\"><f>A1*2</f><v>2</v></c></row>"
+                 "<row r=\"3\" spans=\"1:2\"><c r=\"A3\"><v>3</v></c></row>"
+                 "</sheetData>";
+    FILE* testfile = lxw_tmpfile(NULL);
+    lxw_cell_value value;
+    lxw_worksheet_residency residency;
+    lxw_worksheet_init_data init_data = {0};
+    lxw_worksheet *worksheet1;
+    lxw_worksheet *worksheet2;
+
+    TAILQ_INIT(&residency.resident);
+    residency.max_resident = 1;
+    residency.num_resident = 0;
+    init_data.residency = &residency;
+
+    worksheet1 = lxw_worksheet_new(&init_data);
+    worksheet2 = lxw_worksheet_new(&init_data);
+
+    worksheet_write_number(worksheet1, 0, 0, 1, NULL);
+    worksheet_write_formula_num(worksheet1, 0, 1, "=A1*2", NULL, 2);
+
+    /* Writing to the second worksheet spills the first. */
+    worksheet_write_number(worksheet2, 0, 0, 10, NULL);
+
+    ASSERT_TRUE(worksheet1->spill_file != NULL);
+    ASSERT_TRUE(RB_EMPTY(worksheet1->table));
+    ASSERT_EQUAL(1, residency.num_resident);
+
+    /* Writing to the first worksheet reloads it and spills the second. */
+    worksheet_write_number(worksheet1, 2, 0, 3, NULL);
+
+    ASSERT_TRUE(worksheet1->spill_file == NULL);
+    ASSERT_TRUE(worksheet2->spill_file != NULL);
+    ASSERT_EQUAL(1, worksheet1->reload_count);
+
+    worksheet_get_cell(worksheet2, 0, 0, &value);
+    ASSERT_EQUAL(LXW_CELL_VALUE_NUMBER, value.type);
+    ASSERT_DBL_NEAR(10, value.number);
+
+    worksheet1->file = testfile;
+    _worksheet_write_sheet_data(worksheet1);
+
+    RUN_XLSX_STREQ(exp, got);
+
+    lxw_worksheet_free_cells(worksheet2);
+    ASSERT_EQUAL(1, residency.num_resident);
+
+    lxw_worksheet_free(worksheet1);
+    lxw_worksheet_free(worksheet2);
+}
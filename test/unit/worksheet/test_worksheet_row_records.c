@@ -0,0 +1,96 @@
+/*
+ * Tests for the lib_xlsx_writer library.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ * Copyright 2014-2025, John McNamara, jmcnamara@cpan.org.
+ *
+ */
+
+#include "../ctest.h"
+#include "../helper.h"
+
+#include "../../../include/xlsxwriter/worksheet.h"
+#include "../../../include/xlsxwriter/format.h"
+
+// Test the binary row records in constant_memory mode.
+CTEST(worksheet, row_records01) {
+
+    char* got;
+    char exp[] = "<sheetData>"
+                 "<row r=\"1\"><c r=\"A1\" s=\"1\"><v>1.5</v></c><c r=\"C1\" t=\"inlineStr\"><is><t>Foo &amp; Bar</t></is></c><c r=\"D1\" t=\"b\"><v>1</v></c></row>"
+                 "<row r=\"2\" s=\"1\" customFormat=\"1\" ht=\"30\" hidden=\"1\" customHeight=\"1\"/>"
+                 "<row r=\"3\" s=\"1\" customFormat=\"1\" outlineLevel=\"1\"><c r=\"B3\" s=\"1\"><f>SUM(A1:A2)</f><v>3</v></c><c r=\"XFD3\" s=\"1\"/></row>"
+                 "<row r=\"4\"><c r=\"A4\"><f t=\"array\" ref=\"A4\">SUM(B1:C1*B2:C2)</f><v>0</v></c><c r=\"B4\" t=\"str\"><f>\"Foo\"</f><v>Foo</v></c></row>"
+                 "</sheetData>";
+    FILE* testfile = lxw_tmpfile(NULL);
+    lxw_format *format = lxw_format_new();
+    lxw_worksheet_init_data init_data = {0};
+    init_data.optimize = LXW_TRUE;
+    init_data.binary_tmpfile = LXW_TRUE;
+
+    lxw_worksheet *worksheet = lxw_worksheet_new(&init_data);
+    format->xf_index = 1;
+
+    worksheet_write_number(worksheet, 0, 0, 1.5, format);
+    worksheet_write_string(worksheet, 0, 2, "Foo & Bar", NULL);
+    worksheet_write_boolean(worksheet, 0, 3, 1, NULL);
+
+    worksheet_set_row_opt(worksheet, 1, 30, format, &(lxw_row_col_options){.hidden = 1});
+
+    worksheet_set_row_opt(worksheet, 2, LXW_DEF_ROW_HEIGHT, format, &(lxw_row_col_options){.level = 1});
+    worksheet_write_formula_num(worksheet, 2, 1, "=SUM(A1:A2)", NULL, 3);
+    worksheet_write_blank(worksheet, 2, LXW_COL_MAX - 1, format);
+
+    worksheet_write_array_formula(worksheet, 3, 0, 3, 0, "{=SUM(B1:C1*B2:C2)}", NULL);
+    worksheet_write_formula_str(worksheet, 3, 1, "=\"Foo\"", NULL, "Foo");
+
+    lxw_worksheet_write_single_row(worksheet);
+
+    worksheet->file = testfile;
+    _worksheet_write_optimized_sheet_data(worksheet);
+
+    RUN_XLSX_STREQ(exp, got);
+
+    lxw_worksheet_free(worksheet);
+    lxw_format_free(format);
+}
+
+// Test the binary row records of segments in constant_memory mode.
+CTEST(worksheet, row_records02) {
+
+    char* got;
+    char exp[] = "<sheetData>"
+                 "<row r=\"1\"><c r=\"A1\"><v>1</v></c></row>"
+                 "<row r=\"2\"><c r=\"A2\"><v>2</v></c></row>"
+                 "<row r=\"3\"><c r=\"A3\" t=\"inlineStr\"><is><t>Foo</t></is></c></row>"
+                 "<row r=\"5\"><c r=\"A5\"><v>5</v></c></row>"
+                 "</sheetData>";
+    FILE* testfile = lxw_tmpfile(NULL);
+    lxw_worksheet *segment;
+    lxw_worksheet_init_data init_data = {0};
+    init_data.optimize = LXW_TRUE;
+    init_data.binary_tmpfile = LXW_TRUE;
+
+    lxw_worksheet *worksheet = lxw_worksheet_new(&init_data);
+
+    worksheet_write_number(worksheet, 0, 0, 1, NULL);
+
+    segment = worksheet_open_segment(worksheet, 1, 3);
+    ASSERT_TRUE(segment != NULL);
+    ASSERT_TRUE(segment->binary_tmpfile);
+
+    worksheet_write_number(worksheet, 4, 0, 5, NULL);
+
+    worksheet_write_number(segment, 1, 0, 2, NULL);
+    worksheet_write_string(segment, 2, 0, "Foo", NULL);
+
+    lxw_worksheet_write_single_row(worksheet);
+    lxw_worksheet_close_segments(worksheet);
+
+    worksheet->file = testfile;
+    _worksheet_write_optimized_sheet_data(worksheet);
+
+    RUN_XLSX_STREQ(exp, got);
+
+    lxw_worksheet_free(worksheet);
+}
@@ -0,0 +1,100 @@
+/*
+ * Tests for the lib_xlsx_writer library.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ * Copyright 2014-2025, John McNamara, jmcnamara@cpan.org.
+ *
+ */
+
+#include "../ctest.h"
+#include "../helper.h"
+
+#include "../../../include/xlsxwriter/worksheet.h"
+
+// Test that row segments are joined in row order with the worksheet rows.
+CTEST(worksheet, segments01) {
+
+    char* got;
+    char exp[] = "<sheetData>"
+                 "<row r=\"1\" spans=\"1:1\"><c r=\"A1\"><v>1</v></c></row>"
+                 "<row r=\"2\"><c r=\"A2\"><v>2</v></c></row>"
+                 "<row r=\"4\"><c r=\"A4\"><v>4</v></c></row>"
+                 "<row r=\"6\" spans=\"1:1\"><c r=\"A6\"><v>6</v></c></row>"
+                 "</sheetData>";
+    FILE* testfile = lxw_tmpfile(NULL);
+    lxw_worksheet *segment1;
+    lxw_worksheet *segment2;
+
+    lxw_worksheet *worksheet = lxw_worksheet_new(NULL);
+    worksheet->file = testfile;
+
+    worksheet_write_number(worksheet, 0, 0, 1, NULL);
+
+    segment2 = worksheet_open_segment(worksheet, 3, 4);
+    segment1 = worksheet_open_segment(worksheet, 1, 2);
+
+    ASSERT_TRUE(segment1 != NULL);
+    ASSERT_TRUE(segment2 != NULL);
+    ASSERT_TRUE(worksheet_open_segment(worksheet, 2, 3) == NULL);
+
+    worksheet_write_number(segment1, 1, 0, 2, NULL);
+    worksheet_write_number(segment2, 3, 0, 4, NULL);
+    worksheet_write_number(worksheet, 5, 0, 6, NULL);
+
+    ASSERT_EQUAL(LXW_ERROR_WORKSHEET_INDEX_OUT_OF_RANGE,
+                 worksheet_write_number(worksheet, 2, 0, 3, NULL));
+    ASSERT_EQUAL(LXW_ERROR_WORKSHEET_INDEX_OUT_OF_RANGE,
+                 worksheet_write_number(segment1, 3, 0, 4, NULL));
+
+    worksheet_close_segment(segment1);
+    lxw_worksheet_close_segments(worksheet);
+
+    ASSERT_EQUAL(0, worksheet->dim_rowmin);
+    ASSERT_EQUAL(5, worksheet->dim_rowmax);
+
+    _worksheet_write_sheet_data(worksheet);
+
+    RUN_XLSX_STREQ(exp, got);
+
+    lxw_worksheet_free(worksheet);
+}
+
+// Test row segments in constant_memory mode.
+CTEST(worksheet, segments02) {
+
+    char* got;
+    char exp[] = "<sheetData>"
+                 "<row r=\"1\"><c r=\"A1\"><v>1</v></c></row>"
+                 "<row r=\"2\"><c r=\"A2\"><v>2</v></c></row>"
+                 "<row r=\"3\"><c r=\"A3\" t=\"inlineStr\"><is><t>Foo</t></is></c></row>"
+                 "<row r=\"5\"><c r=\"A5\"><v>5</v></c></row>"
+                 "</sheetData>";
+    FILE* testfile = lxw_tmpfile(NULL);
+    lxw_worksheet *segment;
+    lxw_worksheet_init_data init_data = {0};
+    init_data.optimize = LXW_TRUE;
+
+    lxw_worksheet *worksheet = lxw_worksheet_new(&init_data);
+
+    worksheet_write_number(worksheet, 0, 0, 1, NULL);
+
+    segment = worksheet_open_segment(worksheet, 1, 3);
+    ASSERT_TRUE(segment != NULL);
+
+    worksheet_write_number(worksheet, 4, 0, 5, NULL);
+
+    worksheet_write_number(segment, 1, 0, 2, NULL);
+    worksheet_write_string(segment, 2, 0, "Foo", NULL);
+
+    ASSERT_TRUE(worksheet_open_segment(worksheet, 0, 0) == NULL);
+
+    lxw_worksheet_write_single_row(worksheet);
+    lxw_worksheet_close_segments(worksheet);
+
+    worksheet->file = testfile;
+    _worksheet_write_optimized_sheet_data(worksheet);
+
+    RUN_XLSX_STREQ(exp, got);
+
+    lxw_worksheet_free(worksheet);
+}
@@ -0,0 +1,108 @@
+/*
+ * Tests for the lib_xlsx_writer library.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ * Copyright 2014-2025, John McNamara, jmcnamara@cpan.org.
+ *
+ */
+
+#include "../ctest.h"
+#include "../helper.h"
+
+#include "../../../include/xlsxwriter/worksheet.h"
+
+// Test that table calculated columns are written without stored cells.
+CTEST(worksheet, table_formula01) {
+
+    char* got;
+    char exp[] = "<sheetData>"
+                 "<row r=\"1\" spans=\"2:3\"><c r=\"B1\"><v>1</v></c><c r=\"C1\"><f>Table1[[#This Row],Column1]*2</f><v>0</v></c></row>"
+                 "<row r=\"2\" spans=\"2:3\"><c r=\"C2\"><v>7</v></c></row>"
+                 "<row r=\"3\" spans=\"2:3\"><c r=\"C3\"><f>Table1[[#This Row],Column1]*2</f><v>0</v></c></row>"
+                 "</sheetData>";
+    FILE* testfile = lxw_tmpfile(NULL);
+
+    lxw_table_column col1 = {0};
+    lxw_table_column col2 = {.formula = "=Table1[@Column1]*2"};
+    lxw_table_column *columns[] = {&col1, &col2, NULL};
+    lxw_table_options options = {.no_header_row = LXW_TRUE,
+                                 .columns = columns};
+
+    lxw_worksheet *worksheet = lxw_worksheet_new(NULL);
+    worksheet->file = testfile;
+
+    /* A cell written before the table is replaced by the formula. */
+    worksheet_write_number(worksheet, 0, 1, 1, NULL);
+    worksheet_write_number(worksheet, 0, 2, 9, NULL);
+
+    worksheet_add_table(worksheet, 0, 1, 2, 2, &options);
+
+    /* A cell written after the table takes precedence over the formula. */
+    worksheet_write_number(worksheet, 1, 2, 7, NULL);
+
+    ASSERT_NULL(lxw_worksheet_find_cell_in_row(
+                    lxw_worksheet_find_row(worksheet, 2), 2));
+
+    _worksheet_write_sheet_data(worksheet);
+
+    RUN_XLSX_STREQ(exp, got);
+
+    lxw_worksheet_free(worksheet);
+}
+
+// Test reading back the cells of table calculated columns.
+CTEST(worksheet, table_formula02) {
+
+    lxw_cell_iter iter;
+    lxw_cell_value value;
+    lxw_format *format = lxw_format_new();
+
+    lxw_table_column col1 = {0};
+    lxw_table_column col2 = {.formula = "=Table1[@Column1]*2",
+                             .format = format};
+    lxw_table_column col3 = {0};
+    lxw_table_column *columns[] = {&col1, &col2, &col3, NULL};
+    lxw_table_options options = {.no_header_row = LXW_TRUE,
+                                 .columns = columns};
+
+    lxw_worksheet *worksheet = lxw_worksheet_new(NULL);
+
+    worksheet_add_table(worksheet, 0, 1, 1, 3, &options);
+
+    worksheet_write_number(worksheet, 0, 1, 1, NULL);
+    worksheet_write_number(worksheet, 0, 3, 3, NULL);
+    worksheet_write_number(worksheet, 1, 2, 7, NULL);
+
+    worksheet_get_cell(worksheet, 0, 2, &value);
+    ASSERT_EQUAL(LXW_CELL_VALUE_FORMULA, value.type);
+    ASSERT_STR("Table1[[#This Row],Column1]*2", value.string);
+    ASSERT_TRUE(value.format == format);
+
+    worksheet_get_cell(worksheet, 1, 2, &value);
+    ASSERT_EQUAL(LXW_CELL_VALUE_NUMBER, value.type);
+
+    /* The formula cells are returned in column order. */
+    worksheet_cell_iter_init(&iter, worksheet, 0, 0, 1, 3);
+
+    ASSERT_TRUE(worksheet_cell_iter_next(&iter, &value));
+    ASSERT_EQUAL(1, value.col);
+    ASSERT_EQUAL(LXW_CELL_VALUE_NUMBER, value.type);
+
+    ASSERT_TRUE(worksheet_cell_iter_next(&iter, &value));
+    ASSERT_EQUAL(2, value.col);
+    ASSERT_EQUAL(LXW_CELL_VALUE_FORMULA, value.type);
+
+    ASSERT_TRUE(worksheet_cell_iter_next(&iter, &value));
+    ASSERT_EQUAL(3, value.col);
+    ASSERT_DBL_NEAR(3, value.number);
+
+    ASSERT_TRUE(worksheet_cell_iter_next(&iter, &value));
+    ASSERT_EQUAL(1, value.row);
+    ASSERT_EQUAL(2, value.col);
+    ASSERT_DBL_NEAR(7, value.number);
+
+    ASSERT_FALSE(worksheet_cell_iter_next(&iter, &value));
+
+    lxw_worksheet_free(worksheet);
+    lxw_format_free(format);
+}
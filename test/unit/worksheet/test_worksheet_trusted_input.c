@@ -0,0 +1,141 @@
+/*
+ * Tests for the lib_xlsx_writer library.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ * Copyright 2014-2025, John McNamara, jmcnamara@cpan.org.
+ *
+ */
+
+#include "../ctest.h"
+#include "../helper.h"
+
+#include "../../../include/xlsxwriter/worksheet.h"
+#include "../../../include/xlsxwriter/shared_strings.h"
+
+// Test writing data with trusted input.
+CTEST(worksheet, trusted_input01) {
+
+    char* got;
+    char exp[] = "<sheetData>"
+                 "<row r=\"2\" spans=\"2:4\"><c r=\"B2\"><v>123</v></c><c r=\"C2\" t=\"s\"><v>0</v></c><c r=\"D2\"><f>B2*2</f><v>246</v></c></row>"
+                 "<row r=\"4\" spans=\"2:4\"><c r=\"C4\" t=\"b\"><v>1</v></c></row>"
+                 "</sheetData>";
+    FILE* testfile = lxw_tmpfile(NULL);
+
+    lxw_worksheet *worksheet = lxw_worksheet_new(NULL);
+    worksheet->file = testfile;
+    worksheet->sst = lxw_sst_new();
+
+    worksheet_set_trusted_input(worksheet, LXW_TRUE);
+
+    ASSERT_EQUAL(LXW_NO_ERROR,
+                 worksheet_write_number(worksheet, 1, 1, 123, NULL));
+    ASSERT_EQUAL(LXW_NO_ERROR,
+                 worksheet_write_string(worksheet, 1, 2, "Foo", NULL));
+    ASSERT_EQUAL(LXW_NO_ERROR,
+                 worksheet_write_formula_num(worksheet, 1, 3, "=B2*2", NULL, 246));
+    ASSERT_EQUAL(LXW_NO_ERROR,
+                 worksheet_write_boolean(worksheet, 3, 2, 1, NULL));
+
+    ASSERT_EQUAL(1, worksheet->dim_rowmin);
+    ASSERT_EQUAL(3, worksheet->dim_rowmax);
+    ASSERT_EQUAL(1, worksheet->dim_colmin);
+    ASSERT_EQUAL(3, worksheet->dim_colmax);
+
+    _worksheet_write_sheet_data(worksheet);
+
+    RUN_XLSX_STREQ(exp, got);
+
+    lxw_sst_free(worksheet->sst);
+    lxw_worksheet_free(worksheet);
+}
+
+// Test that the validation is restored when trusted input is turned off.
+CTEST(worksheet, trusted_input02) {
+
+    lxw_worksheet *worksheet = lxw_worksheet_new(NULL);
+
+    worksheet_set_trusted_input(worksheet, LXW_TRUE);
+    ASSERT_TRUE(worksheet->trusted_input);
+
+    worksheet_set_trusted_input(worksheet, LXW_FALSE);
+
+    ASSERT_EQUAL(LXW_ERROR_WORKSHEET_INDEX_OUT_OF_RANGE,
+                 worksheet_write_number(worksheet, LXW_ROW_MAX, 0, 1, NULL));
+    ASSERT_EQUAL(LXW_ERROR_NULL_PARAMETER_IGNORED,
+                 worksheet_write_formula(worksheet, 0, 0, NULL, NULL));
+
+    lxw_worksheet_free(worksheet);
+}
+
+// Test that the rows owned by segments and constant_memory mode are still
+// checked for trusted input.
+CTEST(worksheet, trusted_input03) {
+
+    lxw_worksheet *segment;
+    lxw_worksheet_init_data init_data = {0};
+    lxw_worksheet *worksheet = lxw_worksheet_new(NULL);
+
+    worksheet_set_trusted_input(worksheet, LXW_TRUE);
+
+    segment = worksheet_open_segment(worksheet, 2, 3);
+    ASSERT_TRUE(segment != NULL);
+
+    ASSERT_EQUAL(LXW_ERROR_WORKSHEET_INDEX_OUT_OF_RANGE,
+                 worksheet_write_number(worksheet, 2, 0, 1, NULL));
+    ASSERT_EQUAL(LXW_ERROR_WORKSHEET_INDEX_OUT_OF_RANGE,
+                 worksheet_write_number(segment, 4, 0, 1, NULL));
+    ASSERT_EQUAL(LXW_NO_ERROR,
+                 worksheet_write_number(segment, 3, 0, 1, NULL));
+
+    lxw_worksheet_free(worksheet);
+
+    init_data.optimize = LXW_TRUE;
+    worksheet = lxw_worksheet_new(&init_data);
+
+    worksheet_set_trusted_input(worksheet, LXW_TRUE);
+
+    ASSERT_EQUAL(LXW_NO_ERROR,
+                 worksheet_write_number(worksheet, 5, 0, 1, NULL));
+    ASSERT_EQUAL(LXW_ERROR_WORKSHEET_INDEX_OUT_OF_RANGE,
+                 worksheet_write_number(worksheet, 2, 0, 1, NULL));
+    ASSERT_EQUAL(LXW_ERROR_WORKSHEET_INDEX_OUT_OF_RANGE,
+                 worksheet_write_string(worksheet, 2, 0, "Foo", NULL));
+
+    lxw_worksheet_free(worksheet);
+}
+
+// Test writing numbers stored as text with trusted input.
+CTEST(worksheet, trusted_input04) {
+
+    char* got;
+    char exp[] = "<sheetData>"
+                 "<row r=\"3\" spans=\"2:5\"><c r=\"B3\"><v>1.5</v></c><c r=\"E3\"><v>-12</v></c></row>"
+                 "</sheetData>";
+    FILE* testfile = lxw_tmpfile(NULL);
+
+    lxw_worksheet *worksheet = lxw_worksheet_new(NULL);
+    worksheet->file = testfile;
+
+    worksheet_set_trusted_input(worksheet, LXW_TRUE);
+
+    ASSERT_EQUAL(LXW_NO_ERROR,
+                 worksheet_write_number_text(worksheet, 2, 1, "1.50", 4, NULL));
+    ASSERT_EQUAL(LXW_NO_ERROR,
+                 worksheet_write_number_text(worksheet, 2, 4, "-012", 4, NULL));
+
+    /* The text is still checked since it is normalized. */
+    ASSERT_EQUAL(LXW_ERROR_PARAMETER_VALIDATION,
+                 worksheet_write_number_text(worksheet, 2, 2, "1x", 2, NULL));
+
+    ASSERT_EQUAL(2, worksheet->dim_rowmin);
+    ASSERT_EQUAL(2, worksheet->dim_rowmax);
+    ASSERT_EQUAL(1, worksheet->dim_colmin);
+    ASSERT_EQUAL(4, worksheet->dim_colmax);
+
+    _worksheet_write_sheet_data(worksheet);
+
+    RUN_XLSX_STREQ(exp, got);
+
+    lxw_worksheet_free(worksheet);
+}
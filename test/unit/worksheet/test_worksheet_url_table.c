@@ -0,0 +1,82 @@
+/*
+ * Tests for the lib_xlsx_writer library.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ * Copyright 2014-2025, John McNamara, jmcnamara@cpan.org.
+ *
+ */
+
+#include "../ctest.h"
+#include "../helper.h"
+
+#include "../../../include/xlsxwriter/worksheet.h"
+#include "../../../include/xlsxwriter/shared_strings.h"
+
+// Test that repeated hyperlink urls are normalized and stored once.
+CTEST(worksheet, url_table01) {
+
+    char* got;
+    char exp[] = "<hyperlinks>"
+                 "<hyperlink ref=\"A1\" r:id=\"rId1\" location=\"top\"/>"
+                 "<hyperlink ref=\"A2\" r:id=\"rId2\" location=\"top\"/>"
+                 "<hyperlink ref=\"A3\" r:id=\"rId3\"/>"
+                 "<hyperlink ref=\"A4\" location=\"Sheet2!A1\" display=\"Sheet2!A1\"/>"
+                 "</hyperlinks>";
+    FILE* testfile = lxw_tmpfile(NULL);
+    lxw_rel_tuple *relationship;
+
+    lxw_worksheet *worksheet = lxw_worksheet_new(NULL);
+    worksheet->file = testfile;
+    worksheet->sst = lxw_sst_new();
+
+    worksheet_write_url(worksheet, 0, 0, "http://www.perl.com/a b#top", NULL);
+    worksheet_write_url(worksheet, 1, 0, "http://www.perl.com/a b#top", NULL);
+    worksheet_write_url(worksheet, 2, 0, "external:c:/temp/foo.xlsx", NULL);
+    worksheet_write_url(worksheet, 3, 0, "internal:Sheet2!A1", NULL);
+
+    ASSERT_EQUAL(3, worksheet->url_table->unique_count);
+
+    _worksheet_write_hyperlinks(worksheet);
+
+    relationship = STAILQ_FIRST(worksheet->external_hyperlinks);
+    ASSERT_STR("http://www.perl.com/a%20b", relationship->target);
+
+    relationship = STAILQ_NEXT(relationship, list_pointers);
+    relationship = STAILQ_NEXT(relationship, list_pointers);
+    ASSERT_STR("file:///c:\\temp\\foo.xlsx", relationship->target);
+
+    RUN_XLSX_STREQ(exp, got);
+
+    lxw_sst_free(worksheet->sst);
+    lxw_worksheet_free(worksheet);
+}
+
+// Test that a repeated url uses the normalized url stored in the table.
+CTEST(worksheet, url_table02) {
+
+    lxw_url_element *element;
+
+    lxw_worksheet *worksheet = lxw_worksheet_new(NULL);
+    worksheet->sst = lxw_sst_new();
+
+    ASSERT_EQUAL(LXW_NO_ERROR,
+                 worksheet_write_url(worksheet, 0, 0,
+                                     "http://www.perl.com/a b#top", NULL));
+
+    element = worksheet->url_table->rbh_root;
+    ASSERT_STR("http://www.perl.com/a b#top", element->key);
+    ASSERT_STR("http://www.perl.com/a%20b", element->url);
+    ASSERT_EQUAL(25, element->url_length);
+
+    /* The stored length is still checked against the limit. */
+    worksheet->max_url_length = 20;
+
+    ASSERT_EQUAL(LXW_ERROR_WORKSHEET_MAX_URL_LENGTH_EXCEEDED,
+                 worksheet_write_url(worksheet, 1, 0,
+                                     "http://www.perl.com/a b#top", NULL));
+
+    ASSERT_EQUAL(1, worksheet->url_table->unique_count);
+
+    lxw_sst_free(worksheet->sst);
+    lxw_worksheet_free(worksheet);
+}